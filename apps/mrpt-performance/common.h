@@ -48,6 +48,7 @@ void register_tests_strings();
 void register_tests_octomaps();
 void register_tests_system();
 void register_tests_yaml();
+void register_tests_data_association();
 // -------------------------------------------------
 
 using TestFunctor =
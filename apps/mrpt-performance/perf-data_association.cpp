@@ -0,0 +1,105 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/random.h>
+#include <mrpt/slam/data_association.h>
+
+#include <numeric>
+
+#include "common.h"
+
+using namespace mrpt;
+using namespace mrpt::math;
+using namespace mrpt::random;
+using namespace mrpt::slam;
+using namespace std;
+
+// ------------------------------------------------------
+//  A dense grid of landmarks (0.5 m apart) with correlated predictions
+//  (a common error of 0.25 m, as after a large vehicle uncertainty), so each
+//  observation is individually compatible with several landmarks. 12 of
+//  them are observed, plus "nClutter" spurious observations.
+// ------------------------------------------------------
+void generate_data_association_scene(
+	size_t nClutter, CMatrixDouble& Z, CMatrixDouble& Y, CMatrixDouble& YCov)
+{
+	auto& rng = getRandomGenerator();
+	rng.randomize(1234);
+
+	const size_t side = 7, nLMs = side * side, nSeen = 12;
+	const double spacing = 0.5, sigmaCommon = 0.25, sigmaInd = 0.05;
+
+	Y.setSize(nLMs, 2);
+	YCov.setSize(2 * nLMs, 2 * nLMs);
+	for (size_t i = 0; i < nLMs; i++)
+	{
+		Y(i, 0) = spacing * (i % side);
+		Y(i, 1) = spacing * (i / side);
+		for (size_t j = 0; j < nLMs; j++)
+			for (size_t k = 0; k < 2; k++)
+				YCov(2 * i + k, 2 * j + k) = mrpt::square(sigmaCommon) +
+					(i == j ? mrpt::square(sigmaInd) : 0.0);
+	}
+
+	std::vector<size_t> idxs(nLMs);
+	std::iota(idxs.begin(), idxs.end(), 0);
+	for (size_t i = nLMs - 1; i > 0; i--)
+		std::swap(idxs[i], idxs[rng.drawUniform32bit() % (i + 1)]);
+
+	const double offset[2] = {0.1, -0.08};
+	Z.setSize(nSeen + nClutter, 2);
+	for (size_t j = 0; j < nSeen; j++)
+		for (size_t k = 0; k < 2; k++)
+			Z(j, k) = Y(idxs[j], k) + offset[k] + rng.drawGaussian1D(0, 0.04);
+	for (size_t j = nSeen; j < nSeen + nClutter; j++)
+		for (size_t k = 0; k < 2; k++)
+			Z(j, k) = rng.drawUniform(-spacing, spacing * side);
+}
+
+// a1: number of clutter observations, a2: number of threads
+double slam_test_jcbb(int a1, int a2)
+{
+	CMatrixDouble Z, Y, YCov;
+	generate_data_association_scene(a1, Z, Y, YCov);
+
+	const long N = a1 > 5 ? 2 : 20;
+	TDataAssociationResults results;
+
+	CTicTac tictac;
+	for (long i = 0; i < N; i++)
+		data_association_full_covariance(
+			Z, Y, YCov, results, assocJCBB, metricMaha, 0.99, true, {},
+			metricMaha, 0.0, a2);
+	const double T = tictac.Tac() / N;
+
+	dummy_do_nothing_with_string(
+		mrpt::format("%u", static_cast<unsigned>(results.associations.size())));
+	return T;
+}
+
+// ------------------------------------------------------
+// register_tests_data_association
+// ------------------------------------------------------
+void register_tests_data_association()
+{
+	lstTests.emplace_back(
+		"slam: JCBB 49 landmarks, 12 obs", slam_test_jcbb, 0, 1);
+	lstTests.emplace_back(
+		"slam: JCBB 49 landmarks, 12 obs + 2 clutter", slam_test_jcbb, 2, 1);
+	lstTests.emplace_back(
+		"slam: JCBB 49 landmarks, 12 obs + 5 clutter", slam_test_jcbb, 5, 1);
+	lstTests.emplace_back(
+		"slam: JCBB 49 landmarks, 12 obs + 5 clutter (all threads)",
+		slam_test_jcbb, 5, 0);
+	lstTests.emplace_back(
+		"slam: JCBB 49 landmarks, 12 obs + 10 clutter", slam_test_jcbb, 10, 1);
+	lstTests.emplace_back(
+		"slam: JCBB 49 landmarks, 12 obs + 10 clutter (all threads)",
+		slam_test_jcbb, 10, 0);
+}
@@ -7,6 +7,7 @@
    | Released under BSD License. See: https://www.mrpt.org/License          |
    +------------------------------------------------------------------------+ */
 
+#include <mrpt/maps/CMultiMetricMapPDF.h>
 #include <mrpt/maps/COccupancyGridMap2D.h>
 #include <mrpt/maps/CSimplePointsMap.h>
 #include <mrpt/obs/CObservation2DRangeScan.h>
@@ -86,7 +87,9 @@ double grid_test_4(int a1, int a2)
 
 	float p = 0.57f;
 	COccupancyGridMap2D::cellType logodd_obs = COccupancyGridMap2D::p2l(p);
+	// Only rows of the first band may be addressed from this pointer:
 	COccupancyGridMap2D::cellType* theMapArray = gridMap.getRow(0);
+	ASSERT_LT_(2U, COccupancyGridMap2D::CELL_BAND_ROWS);
 	unsigned theMapSize_x = gridMap.getSizeX();
 	COccupancyGridMap2D::cellType logodd_thres_occupied =
 		COccupancyGridMap2D::OCCGRID_CELLTYPE_MIN + logodd_obs;
@@ -202,6 +205,48 @@ double grid_test_9(int a1, int a2)
 	return tictac.Tac() / a1;
 }
 
+double grid_test_10(int numThreads, int a2)
+{
+	// RBPF map update right after resampling: the grids of all particles are
+	// copies of the same map, so inserting the scan also copies the bands of
+	// cells each particle writes to.
+	auto scan = CObservation2DRangeScan::Create();
+	stock_observations::example2DRangeScan(*scan);
+	CSensoryFrame sf;
+	sf.insert(scan);
+
+	TSetOfMetricMapInitializers inits;
+	{
+		COccupancyGridMap2D::TMapDefinition def;
+		def.resolution = 0.05f;
+		inits.push_back(def);
+	}
+	mrpt::bayes::CParticleFilter::TParticleFilterOptions pfOpts;
+	pfOpts.sampleSize = 100;
+	pfOpts.numThreads = numThreads;
+	CMultiMetricMapPDF pdf(pfOpts, inits, {});
+
+	auto& parts = pdf.m_particles;
+	for (size_t i = 0; i < parts.size(); i++)
+		parts[i].d->robotPath.push_back(
+			mrpt::math::TPose3D(0.01 * i, -0.01 * i, 0, 0.001 * i, 0, 0));
+	const auto g0 = parts[0].d->mapTillNow.mapByClass<COccupancyGridMap2D>();
+	g0->insertObservation(*scan);
+
+	const long N = 20;
+	double t = 0;
+	for (long n = 0; n < N; n++)
+	{
+		for (size_t i = 1; i < parts.size(); i++)
+			*parts[i].d->mapTillNow.mapByClass<COccupancyGridMap2D>() = *g0;
+
+		CTicTac tictac;
+		pdf.insertObservation(sf, pfOpts);
+		t += tictac.Tac();
+	}
+	return t / N;
+}
+
 // ------------------------------------------------------
 // register_tests_grids
 // ------------------------------------------------------
@@ -218,4 +263,10 @@ void register_tests_grids()
 	lstTests.emplace_back("gridmap2D: resize", grid_test_7);
 	lstTests.emplace_back("gridmap2D: computeLikelihood", grid_test_8);
 	lstTests.emplace_back("gridmap2D: determineMatching2D", grid_test_9, 5000);
+	lstTests.emplace_back(
+		"gridmap2D: RBPF insertion after resampling (1 thread)", grid_test_10,
+		1);
+	lstTests.emplace_back(
+		"gridmap2D: RBPF insertion after resampling (all threads)",
+		grid_test_10, 0);
 }
@@ -8,12 +8,15 @@
    +------------------------------------------------------------------------+ */
 
 #include <mrpt/io/CFileGZInputStream.h>
+#include <mrpt/maps/CHashedVoxelPointsMap.h>
 #include <mrpt/maps/CMultiMetricMap.h>
 #include <mrpt/maps/COccupancyGridMap2D.h>
 #include <mrpt/maps/CSimplePointsMap.h>
 #include <mrpt/obs/CRawlog.h>
+#include <mrpt/poses/CPose3D.h>
 #include <mrpt/random.h>
 #include <mrpt/serialization/CArchive.h>
+#include <mrpt/slam/CICP.h>
 #include <mrpt/slam/CMetricMapBuilderICP.h>
 #include <mrpt/system/filesystem.h>
 
@@ -125,6 +128,157 @@ double icp_test_1(int a1, int a2)
 	return tictac.Tac() / step;
 }
 
+// ------------------------------------------------------
+//	Benchmark: KD-tree correspondences of 3D point clouds,
+//	as in each ICP iteration (a1: threads, a2: reuse buffers)
+// ------------------------------------------------------
+double icp_test_matching3D(int a1, int a2)
+{
+	const size_t N = 100000;
+
+	auto& rng = getRandomGenerator();
+	rng.randomize(1234);
+
+	CSimplePointsMap map1, map2;
+	map1.reserve(N);
+	map2.reserve(N);
+	for (size_t i = 0; i < N; i++)
+	{
+		const float x = rng.drawUniform(-50.0f, 50.0f);
+		const float y = rng.drawUniform(-50.0f, 50.0f);
+		const float z = rng.drawUniform(0.0f, 5.0f);
+		map1.insertPoint(x, y, z);
+		map2.insertPoint(
+			x + rng.drawGaussian1D(0, 0.05), y + rng.drawGaussian1D(0, 0.05),
+			z + rng.drawGaussian1D(0, 0.05));
+	}
+	map1.kdTreeEnsureIndexBuilt3D();
+
+	const mrpt::poses::CPose3D pose(0.1, -0.05, 0.02, 0.01, 0, 0);
+
+	TMatchingParams params;
+	params.maxDistForCorrespondence = 0.5f;
+	params.numThreads = a1;
+	if (a2) params.workspace = std::make_shared<TMatchingWorkspace>();
+
+	mrpt::tfest::TMatchingPairList corrs;
+	TMatchingExtraResults extraResults;
+
+	const long N_REPS = 20;
+	CTicTac tictac;
+	for (long i = 0; i < N_REPS; i++)
+		map1.determineMatching3D(&map2, pose, corrs, params, extraResults);
+
+	return tictac.Tac() / N_REPS;
+}
+
+// ------------------------------------------------------
+//	Benchmark: voxel map correspondences of 3D point clouds, as in
+//	icp_test_matching3D() (a1: threads, a2: 0=matching, 1=map insertion)
+// ------------------------------------------------------
+double icp_test_matching3D_voxels(int a1, int a2)
+{
+	const size_t N = 100000;
+
+	auto& rng = getRandomGenerator();
+	rng.randomize(1234);
+
+	CSimplePointsMap map1, map2;
+	map1.reserve(N);
+	map2.reserve(N);
+	for (size_t i = 0; i < N; i++)
+	{
+		const float x = rng.drawUniform(-50.0f, 50.0f);
+		const float y = rng.drawUniform(-50.0f, 50.0f);
+		const float z = rng.drawUniform(0.0f, 5.0f);
+		map1.insertPoint(x, y, z);
+		map2.insertPoint(
+			x + rng.drawGaussian1D(0, 0.05), y + rng.drawGaussian1D(0, 0.05),
+			z + rng.drawGaussian1D(0, 0.05));
+	}
+
+	CHashedVoxelPointsMap voxelMap(0.5, 32);
+	voxelMap.insertionOptions.minDistBetweenPoints = 0;
+
+	if (a2 == 1)
+	{
+		const long N_REPS = 10;
+		CTicTac tictac;
+		for (long i = 0; i < N_REPS; i++)
+		{
+			voxelMap.clear();
+			voxelMap.insertAnotherMap(&map1, mrpt::poses::CPose3D());
+		}
+		return tictac.Tac() / N_REPS;
+	}
+	voxelMap.insertAnotherMap(&map1, mrpt::poses::CPose3D());
+
+	const mrpt::poses::CPose3D pose(0.1, -0.05, 0.02, 0.01, 0, 0);
+
+	TMatchingParams params;
+	params.maxDistForCorrespondence = 0.5f;
+	params.numThreads = a1;
+	params.workspace = std::make_shared<TMatchingWorkspace>();
+
+	mrpt::tfest::TMatchingPairList corrs;
+	TMatchingExtraResults extraResults;
+
+	const long N_REPS = 20;
+	CTicTac tictac;
+	for (long i = 0; i < N_REPS; i++)
+		voxelMap.determineMatching3D(&map2, pose, corrs, params, extraResults);
+
+	return tictac.Tac() / N_REPS;
+}
+
+// ------------------------------------------------------
+//	Benchmark: ICP-3D of a planar scene (a1: TICPAlgorithm, a2: levels
+//	of coarse-to-fine ICP, 0=disabled).
+//	Each alignment uses a new reference map, so it includes the estimation
+//	of normals and covariances, and of downsampled maps.
+// ------------------------------------------------------
+double icp_test_align3D(int a1, int a2)
+{
+	auto& rng = getRandomGenerator();
+	rng.randomize(1234);
+
+	// A room: floor and four walls
+	CSimplePointsMap world;
+	for (int i = 0; i < 10000; i++)
+	{
+		const double a = rng.drawUniform(0.0, 10.0);
+		const double b = rng.drawUniform(0.0, 10.0);
+		const double h = rng.drawUniform(0.0, 3.0);
+		world.insertPoint(a, b, 0);
+		world.insertPoint(0, a, h);
+		world.insertPoint(10, a, h);
+		world.insertPoint(a, 0, h);
+		world.insertPoint(a, 10, h);
+	}
+	const mrpt::poses::CPose3D truePose(0.2, -0.1, 0.05, 0.05, 0.01, -0.02);
+	mrpt::poses::CPose3D invPose = truePose;
+	invPose.inverse();
+	CSimplePointsMap local = world;
+	local.changeCoordinatesReference(invPose);
+
+	CICP icp;
+	icp.options.ICP_algorithm = static_cast<TICPAlgorithm>(a1);
+	icp.options.thresholdDist = 0.5;
+	icp.options.thresholdAng = 0;
+	icp.options.smallestThresholdDist = 0.05;
+	icp.options.maxIterations = 200;
+	if (a2) icp.options.pyramid_levels = a2;
+
+	const long N_REPS = 5;
+	CTicTac tictac;
+	for (long i = 0; i < N_REPS; i++)
+	{
+		CSimplePointsMap ref = world;
+		icp.Align3D(&ref, &local, mrpt::poses::CPose3D());
+	}
+	return tictac.Tac() / N_REPS;
+}
+
 // ------------------------------------------------------
 // register_tests_icpslam
 // ------------------------------------------------------
@@ -134,4 +288,42 @@ void register_tests_icpslam()
 		"icp-slam (match points): Run with sample dataset", icp_test_1, 0);
 	lstTests.emplace_back(
 		"icp-slam (match grid): Run with sample dataset", icp_test_1, 1);
+	lstTests.emplace_back(
+		"icp: matching3D 100k pts, 1 thread", icp_test_matching3D, 1, 0);
+	lstTests.emplace_back(
+		"icp: matching3D 100k pts, 1 thread, reused buffers",
+		icp_test_matching3D, 1, 1);
+	lstTests.emplace_back(
+		"icp: matching3D 100k pts, 2 threads, reused buffers",
+		icp_test_matching3D, 2, 1);
+	lstTests.emplace_back(
+		"icp: matching3D 100k pts, 4 threads, reused buffers",
+		icp_test_matching3D, 4, 1);
+	lstTests.emplace_back(
+		"icp: matching3D 100k pts, all threads, reused buffers",
+		icp_test_matching3D, 0, 1);
+	lstTests.emplace_back(
+		"icp: matching3D 100k pts, voxel map, 1 thread",
+		icp_test_matching3D_voxels, 1, 0);
+	lstTests.emplace_back(
+		"icp: matching3D 100k pts, voxel map, all threads",
+		icp_test_matching3D_voxels, 0, 0);
+	lstTests.emplace_back(
+		"icp: insert 100k pts into voxel map", icp_test_matching3D_voxels, 1,
+		1);
+	lstTests.emplace_back(
+		"icp: align3D 50k pts room, icpClassic", icp_test_align3D,
+		icpClassic);
+	lstTests.emplace_back(
+		"icp: align3D 50k pts room, icpPointToPlane", icp_test_align3D,
+		icpPointToPlane);
+	lstTests.emplace_back(
+		"icp: align3D 50k pts room, icpGeneralized", icp_test_align3D,
+		icpGeneralized);
+	lstTests.emplace_back(
+		"icp: align3D 50k pts room, icpClassic, 3 levels", icp_test_align3D,
+		icpClassic, 3);
+	lstTests.emplace_back(
+		"icp: align3D 50k pts room, icpPointToPlane, 3 levels",
+		icp_test_align3D, icpPointToPlane, 3);
 }
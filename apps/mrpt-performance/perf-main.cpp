@@ -143,6 +143,7 @@ int main(int argc, char** argv)
 		register_tests_octomaps();
 		register_tests_system();
 		register_tests_yaml();
+		register_tests_data_association();
 
 		if (doLog)
 		{
@@ -7,7 +7,9 @@
    | Released under BSD License. See: https://www.mrpt.org/License          |
    +------------------------------------------------------------------------+ */
 
+#include <mrpt/maps/CHashedOctoMap.h>
 #include <mrpt/maps/COctoMap.h>
+#include <mrpt/maps/CSimplePointsMap.h>
 #include <mrpt/obs/CObservation2DRangeScan.h>
 #include <mrpt/obs/stock_observations.h>
 #include <mrpt/random.h>
@@ -17,9 +19,10 @@
 // ------------------------------------------------------
 //				Benchmark OctoMaps
 // ------------------------------------------------------
+template <class MAP>
 double octomap_updateVoxel(int resolution_cm, int dist_points_cm)
 {
-	mrpt::maps::COctoMap map(resolution_cm * 0.01);
+	MAP map(resolution_cm * 0.01);
 
 	auto& rnd = mrpt::random::getRandomGenerator();
 
@@ -36,6 +39,7 @@ double octomap_updateVoxel(int resolution_cm, int dist_points_cm)
 	return tictac.Tac() / N;
 }
 
+template <class MAP>
 double octomap_insert2Dscan(int resolution_cm, int num_reps)
 {
 	auto& rnd = mrpt::random::getRandomGenerator();
@@ -45,7 +49,7 @@ double octomap_insert2Dscan(int resolution_cm, int num_reps)
 
 	const double L = 2.0;  // [meters]
 
-	mrpt::maps::COctoMap map(resolution_cm * 0.01);
+	MAP map(resolution_cm * 0.01);
 
 	mrpt::system::CTicTac tictac;
 	for (int n = 0; n < num_reps; n++)
@@ -60,25 +64,98 @@ double octomap_insert2Dscan(int resolution_cm, int num_reps)
 	return tictac.Tac() / num_reps;
 }
 
+// A dense 3D scan of an outdoor-like scene (ground plane and walls):
+template <class MAP>
+double octomap_insertPointCloud(int resolution_cm, int num_reps)
+{
+	auto& rnd = mrpt::random::getRandomGenerator();
+	rnd.randomize(1234);
+
+	mrpt::maps::CSimplePointsMap pts;
+	const size_t N = 20000;
+	const double R = 15.0;	// [meters]
+	for (size_t i = 0; i < N; i++)
+	{
+		const double ang = rnd.drawUniform(-M_PI, M_PI);
+		if (i % 2)
+		{
+			const double r = rnd.drawUniform(1.0, R);
+			pts.insertPoint(r * cos(ang), r * sin(ang), -1.0);
+		}
+		else
+			pts.insertPoint(
+				R * cos(ang), R * sin(ang), rnd.drawUniform(-1.0, 3.0));
+	}
+
+	MAP map(resolution_cm * 0.01);
+
+	mrpt::system::CTicTac tictac;
+	for (int n = 0; n < num_reps; n++)
+		map.insertPointCloud(
+			pts, rnd.drawUniform(-0.5, 0.5), rnd.drawUniform(-0.5, 0.5), 0);
+	return tictac.Tac() / num_reps;
+}
+
 // ------------------------------------------------------
 // register_tests_octomaps
 // ------------------------------------------------------
 void register_tests_octomaps()
 {
+	using mrpt::maps::CHashedOctoMap;
+	using mrpt::maps::COctoMap;
+
 	lstTests.emplace_back(
 		"octomap: updateVoxel() random, voxel=0.05m pts=5.0m",
-		octomap_updateVoxel, 5, 500);
+		octomap_updateVoxel<COctoMap>, 5, 500);
 	lstTests.emplace_back(
 		"octomap: updateVoxel() random, voxel=0.1m pts=5.0m",
-		octomap_updateVoxel, 10, 500);
+		octomap_updateVoxel<COctoMap>, 10, 500);
 	lstTests.emplace_back(
 		"octomap: updateVoxel() random, voxel=0.25m pts=5.0m",
-		octomap_updateVoxel, 25, 500);
+		octomap_updateVoxel<COctoMap>, 25, 500);
 
 	lstTests.emplace_back(
-		"octomap: insert2Dscan(), voxel=0.05m", octomap_insert2Dscan, 5, 100);
+		"octomap: insert2Dscan(), voxel=0.05m", octomap_insert2Dscan<COctoMap>,
+		5, 100);
+	lstTests.emplace_back(
+		"octomap: insert2Dscan(), voxel=0.10m", octomap_insert2Dscan<COctoMap>,
+		10, 100);
+	lstTests.emplace_back(
+		"octomap: insert2Dscan(), voxel=0.25m", octomap_insert2Dscan<COctoMap>,
+		25, 100);
+
+	lstTests.emplace_back(
+		"octomap: insertPointCloud() 20k pts, voxel=0.05m",
+		octomap_insertPointCloud<COctoMap>, 5, 5);
+	lstTests.emplace_back(
+		"octomap: insertPointCloud() 20k pts, voxel=0.10m",
+		octomap_insertPointCloud<COctoMap>, 10, 5);
+
+	// Same benchmarks, with the native voxel engine:
+	lstTests.emplace_back(
+		"hashedOctoMap: updateVoxel() random, voxel=0.05m pts=5.0m",
+		octomap_updateVoxel<CHashedOctoMap>, 5, 500);
+	lstTests.emplace_back(
+		"hashedOctoMap: updateVoxel() random, voxel=0.1m pts=5.0m",
+		octomap_updateVoxel<CHashedOctoMap>, 10, 500);
+	lstTests.emplace_back(
+		"hashedOctoMap: updateVoxel() random, voxel=0.25m pts=5.0m",
+		octomap_updateVoxel<CHashedOctoMap>, 25, 500);
+
+	lstTests.emplace_back(
+		"hashedOctoMap: insert2Dscan(), voxel=0.05m",
+		octomap_insert2Dscan<CHashedOctoMap>, 5, 100);
+	lstTests.emplace_back(
+		"hashedOctoMap: insert2Dscan(), voxel=0.10m",
+		octomap_insert2Dscan<CHashedOctoMap>, 10, 100);
+	lstTests.emplace_back(
+		"hashedOctoMap: insert2Dscan(), voxel=0.25m",
+		octomap_insert2Dscan<CHashedOctoMap>, 25, 100);
+
 	lstTests.emplace_back(
-		"octomap: insert2Dscan(), voxel=0.10m", octomap_insert2Dscan, 10, 100);
+		"hashedOctoMap: insertPointCloud() 20k pts, voxel=0.05m",
+		octomap_insertPointCloud<CHashedOctoMap>, 5, 5);
 	lstTests.emplace_back(
-		"octomap: insert2Dscan(), voxel=0.25m", octomap_insert2Dscan, 25, 100);
+		"hashedOctoMap: insertPointCloud() 20k pts, voxel=0.10m",
+		octomap_insertPointCloud<CHashedOctoMap>, 10, 5);
 }
@@ -12,6 +12,9 @@
 #include <mrpt/obs/stock_observations.h>
 #include <mrpt/poses/CPose2D.h>
 #include <mrpt/random.h>
+#include <mrpt/system/filesystem.h>
+
+#include <deque>
 
 #include "common.h"
 
@@ -107,6 +110,7 @@ double pointmap_test_1(int a1, int a2)
 double pointmap_test_2(int a1, int a2)
 {
 	// test 2: insert scan + kd_tree in each iteration
+	// a2: 1=2D, 2=3D, 3=2D dynamic index, 4=3D dynamic index
 	// --------------------------------------------------
 
 	// prepare the laser scan:
@@ -121,13 +125,14 @@ double pointmap_test_2(int a1, int a2)
 		CSimplePointsMap pt_map;
 
 		pt_map.insertionOptions.minDistBetweenLaserPoints = 0.03f;
+		pt_map.kdtree_search_params.dynamic_index = (a2 > 2);
 		CPose3D pose;
 		for (long i = 0; i < a1; i++)
 		{
 			pose.setFromValues(
 				pose.x() + 0.04, pose.y() + 0.08, 0, pose.yaw() + 0.02);
 			pt_map.insertObservation(scan1, pose);
-			if (a2 == 1)
+			if (a2 % 2 == 1)
 			{  // 2d kd-tree
 				float x, y, dist2;
 				/*size_t idx =*/pt_map.kdTreeClosestPoint2D(
@@ -256,6 +261,129 @@ double pointmap_test_5(int a1, int a2)
 	return tictac.Tac() / a2;
 }
 
+double pointmap_test_6(int a1, int a2)
+{
+	// test 6: load a scan into the same map, with a height filter
+	// ------------------------------------------------------------
+
+	// prepare the laser scan:
+	CObservation2DRangeScan scan1;
+	stock_observations::example2DRangeScan(scan1);
+
+	CSimplePointsMap pt_map;
+	pt_map.insertionOptions.minDistBetweenLaserPoints = a1 * 0.01f;
+	pt_map.enableFilterByHeight(true);
+	pt_map.setHeightFilterLevels(-1.0, 1.0);
+	const CPose3D pose(1.0, 2.0, 0.5, 0.3, 0.1, 0.0);
+
+	CTicTac tictac;
+	for (long i = 0; i < a2; i++)
+		pt_map.loadFromRangeScan(scan1, pose);
+
+	return tictac.Tac() / a2;
+}
+
+double pointmap_test_7(int a1, int a2)
+{
+	// test 7: a1 scanners: build the cached points map of each new scan,
+	// keeping the last 10 scans of each one alive.
+	// -------------------------------------------------------------------
+
+	// prepare the laser scan:
+	CObservation2DRangeScan scan1;
+	stock_observations::example2DRangeScan(scan1);
+
+	std::deque<CObservation2DRangeScan::Ptr> window;
+
+	CTicTac tictac;
+	for (long i = 0; i < a2; i++)
+	{
+		for (int k = 0; k < a1; k++)
+		{
+			auto obs = std::make_shared<CObservation2DRangeScan>(scan1);
+			obs->buildAuxPointsMap<CPointsMap>();
+			window.push_back(obs);
+		}
+		while (window.size() > static_cast<size_t>(10 * a1))
+			window.pop_front();
+	}
+	return tictac.Tac() / a2;
+}
+
+double pointmap_test_8(int a1, int a2)
+{
+	// test 8: save and load a map of a1 points: text (a2=0), binary (a2=1)
+	// or binary PLY (a2=2) file
+	// -------------------------------------------------------------------
+	auto& rng = mrpt::random::getRandomGenerator();
+	CSimplePointsMap pt_map;
+	for (int i = 0; i < a1; i++)
+		pt_map.insertPoint(
+			rng.drawUniform(-50.0f, 50.0f), rng.drawUniform(-50.0f, 50.0f),
+			rng.drawUniform(-5.0f, 5.0f));
+
+	const auto fil = mrpt::system::getTempFileName() + ".ply";
+	CSimplePointsMap pt_map2;
+
+	CTicTac tictac;
+	switch (a2)
+	{
+		case 0:
+			pt_map.save3D_to_text_file(fil);
+			pt_map2.load3D_from_text_file(fil);
+			break;
+		case 1:
+			pt_map.saveToBinaryFile(fil);
+			pt_map2.loadFromBinaryFile(fil);
+			break;
+		case 2:
+			pt_map.saveToPlyFile(fil, true);
+			pt_map2.loadFromPlyFile(fil);
+			break;
+	};
+	const double t = tictac.Tac();
+
+	ASSERT_EQUAL_(pt_map2.size(), pt_map.size());
+	mrpt::system::deleteFile(fil);
+	return t;
+}
+
+double pointmap_test_9(int a1, int a2)
+{
+	// test 9: a1 keyframes, like CMetricMapBuilderICP: insert a new scan,
+	// then query the nearest map point of each point in the scan, as one
+	// ICP iteration would do. a2: 0=rebuild the kd-tree, 1=dynamic index
+	// -------------------------------------------------------------------
+
+	// prepare the laser scan:
+	CObservation2DRangeScan scan1;
+	stock_observations::example2DRangeScan(scan1);
+
+	CSimplePointsMap scan_pts;
+	scan_pts.insertObservation(scan1, CPose3D());
+	const auto& xs = scan_pts.getPointsBufferRef_x();
+	const auto& ys = scan_pts.getPointsBufferRef_y();
+
+	CSimplePointsMap pt_map;
+	pt_map.insertionOptions.minDistBetweenLaserPoints = 0.03f;
+	pt_map.kdtree_search_params.dynamic_index = (a2 != 0);
+	CPose3D pose;
+
+	CTicTac tictac;
+	for (long i = 0; i < a1; i++)
+	{
+		pose.setFromValues(
+			pose.x() + 0.04, pose.y() + 0.08, 0, pose.yaw() + 0.02);
+		pt_map.insertObservation(scan1, pose);
+
+		float x, y, dist2;
+		for (size_t k = 0; k < xs.size(); k++)
+			pt_map.kdTreeClosestPoint2D(
+				pose.x() + xs[k], pose.y() + ys[k], x, y, dist2);
+	}
+	return tictac.Tac();
+}
+
 // ------------------------------------------------------
 // register_tests_pointmaps
 // ------------------------------------------------------
@@ -303,6 +431,21 @@ void register_tests_pointmaps()
 		2);
 	// lstTests.push_back( TestData("pointmap: (insert scan+3D kd-tree query) x
 	// 100",pointmap_test_2, 100, 2 ) );
+	lstTests.emplace_back(
+		"pointmap: (insert scan+2D dynamic kd-tree query) x 50",
+		pointmap_test_2, 50, 3);
+	lstTests.emplace_back(
+		"pointmap: (insert scan+3D dynamic kd-tree query) x 50",
+		pointmap_test_2, 50, 4);
+	lstTests.emplace_back(
+		"pointmap: (insert scan+3D dynamic kd-tree query) x 500",
+		pointmap_test_2, 500, 4);
+	lstTests.emplace_back(
+		"pointmap: ICP keyframes x 500 (rebuild kd-tree)", pointmap_test_9,
+		500, 0);
+	lstTests.emplace_back(
+		"pointmap: ICP keyframes x 500 (dynamic kd-tree)", pointmap_test_9,
+		500, 1);
 
 	lstTests.emplace_back(
 		"pointmap: computeMatchingWith2D", pointmap_test_4, 5000);
@@ -311,4 +454,22 @@ void register_tests_pointmaps()
 		"pointmap: boundingBox (10 scans)", pointmap_test_5, 10, 50000);
 	lstTests.emplace_back(
 		"pointmap: boundingBox (1000 scans)", pointmap_test_5, 1000, 5000);
+
+	lstTests.emplace_back(
+		"pointmap: loadFromRangeScan (same map)", pointmap_test_6, 0, 20000);
+	lstTests.emplace_back(
+		"pointmap: loadFromRangeScan (same map, min dist)", pointmap_test_6,
+		3, 20000);
+	lstTests.emplace_back(
+		"pointmap: buildAuxPointsMap (4 scanners)", pointmap_test_7, 4, 2000);
+
+	lstTests.emplace_back(
+		"pointmap: save+load 1M points (text file)", pointmap_test_8, 1000000,
+		0);
+	lstTests.emplace_back(
+		"pointmap: save+load 1M points (binary file)", pointmap_test_8,
+		1000000, 1);
+	lstTests.emplace_back(
+		"pointmap: save+load 1M points (binary PLY)", pointmap_test_8, 1000000,
+		2);
 }
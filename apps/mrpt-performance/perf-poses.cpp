@@ -9,10 +9,14 @@
 
 #include <mrpt/poses/CPoint2D.h>
 #include <mrpt/poses/CPose2D.h>
+#include <mrpt/poses/CPose2DParticlesSoA.h>
 #include <mrpt/poses/CPose3D.h>
 #include <mrpt/poses/CPose3DPDFGaussian.h>
 #include <mrpt/poses/CPose3DQuat.h>
 #include <mrpt/poses/CPose3DQuatPDFGaussian.h>
+#include <mrpt/poses/CPosePDFGaussian.h>
+#include <mrpt/poses/CPosePDFParticles.h>
+#include <mrpt/poses/CPoseRandomSampler.h>
 #include <mrpt/random/RandomGenerators.h>
 
 #include <Eigen/Dense>	// for 6x8 fixed-matrices
@@ -235,6 +239,86 @@ double poses_test_compose2Dpoint2(int a1, int a2)
 	return T;
 }
 
+// 2D particles ===============
+static CPoseRandomSampler poses_test_motionSampler()
+{
+	CPosePDFGaussian motion;
+	motion.mean = CPose2D(0.5, 0.01, 2.0_deg);
+	motion.cov.setDiagonal(std::vector<double>{1e-3, 1e-3, 1e-4});
+	CPoseRandomSampler sampler;
+	sampler.setPosePDF(motion);
+	return sampler;
+}
+
+// a1: number of particles
+double poses_test_particles_motion_aos(int a1, int a2)
+{
+	const long N = 20;
+	const auto sampler = poses_test_motionSampler();
+	CPosePDFParticles parts(a1);
+
+	CTicTac tictac;
+	CPose2D incr;
+	for (long i = 0; i < N; i++)
+	{
+		for (auto& p : parts.m_particles)
+		{
+			sampler.drawSample(incr);
+			p.d = p.d + incr.asTPose();
+		}
+		parts.normalizeWeights();
+		parts.ESS();
+	}
+	double T = tictac.Tac() / N;
+	dummy_do_nothing_with_string(
+		mrpt::format("%f", parts.getParticlePose(0).x));
+	return T;
+}
+
+// a1: number of particles
+double poses_test_particles_motion_soa(int a1, int a2)
+{
+	const long N = 20;
+	const auto sampler = poses_test_motionSampler();
+	CPose2DParticlesSoA parts(a1);
+
+	CTicTac tictac;
+	for (long i = 0; i < N; i++)
+	{
+		parts.drawMotionSamples(sampler);
+		parts.normalizeWeights();
+		parts.ESS();
+	}
+	double T = tictac.Tac() / N;
+	dummy_do_nothing_with_string(mrpt::format("%f", parts.x()[0]));
+	return T;
+}
+
+// a1: number of particles, a2: resampling method
+template <class PARTICLES>
+double poses_test_particles_resampling(int a1, int a2)
+{
+	const long N = 20;
+	PARTICLES parts(a1);
+	bayes::CParticleFilter::TParticleFilterOptions opts;
+	opts.resamplingMethod =
+		static_cast<bayes::CParticleFilter::TParticleResamplingAlgorithm>(a2);
+
+	auto& rng = getRandomGenerator();
+	double T = 0;
+	for (long i = 0; i < N; i++)
+	{
+		for (int k = 0; k < a1; k++)
+			parts.setW(k, rng.drawUniform(-10.0, 0.0));
+
+		CTicTac tictac;
+		parts.performResampling(opts);
+		T += tictac.Tac();
+	}
+	dummy_do_nothing_with_string(mrpt::format("%f", parts.getW(0)));
+	return T / N;
+}
+
 // 3D QUAT ======================
 double poses_test_compose3DQuat(int a1, int a2)
 {
@@ -461,6 +545,37 @@ void register_tests_poses()
 	lstTests.emplace_back(
 		"poses: CPose2D.composePoint()", poses_test_compose2Dpoint2);
 
+	lstTests.emplace_back(
+		"poses: 2D particles motion+normalize (AoS, 10k)",
+		poses_test_particles_motion_aos, 10000);
+	lstTests.emplace_back(
+		"poses: 2D particles motion+normalize (SoA, 10k)",
+		poses_test_particles_motion_soa, 10000);
+	lstTests.emplace_back(
+		"poses: 2D particles motion+normalize (AoS, 100k)",
+		poses_test_particles_motion_aos, 100000);
+	lstTests.emplace_back(
+		"poses: 2D particles motion+normalize (SoA, 100k)",
+		poses_test_particles_motion_soa, 100000);
+
+	using bayes::CParticleFilter;
+	lstTests.emplace_back(
+		"poses: 2D particles resampling multinomial (AoS, 10k)",
+		poses_test_particles_resampling<CPosePDFParticles>, 10000,
+		CParticleFilter::prMultinomial);
+	lstTests.emplace_back(
+		"poses: 2D particles resampling systematic (AoS, 10k)",
+		poses_test_particles_resampling<CPosePDFParticles>, 10000,
+		CParticleFilter::prSystematic);
+	lstTests.emplace_back(
+		"poses: 2D particles resampling multinomial (SoA, 100k)",
+		poses_test_particles_resampling<CPose2DParticlesSoA>, 100000,
+		CParticleFilter::prMultinomial);
+	lstTests.emplace_back(
+		"poses: 2D particles resampling systematic (SoA, 100k)",
+		poses_test_particles_resampling<CPose2DParticlesSoA>, 100000,
+		CParticleFilter::prSystematic);
+
 	lstTests.emplace_back(
 		"poses: CPose3DQuat (+) CPose3DQuat", poses_test_compose3DQuat);
 	lstTests.emplace_back(
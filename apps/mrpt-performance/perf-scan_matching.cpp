@@ -209,6 +209,105 @@ double tfest_test_4(int nCorrs, int nRepets)
 	return T;
 }
 
+// ------------------------------------------------------
+//				Benchmark: AoS vs SoA correspondences
+// ------------------------------------------------------
+template <bool IS_3D, bool USE_SOA>
+double tfest_test_5(int nCorrs, int nRepets)
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	const CPose3D gtPose(1.0, 2.0, 0.5, 10.0_deg, 5.0_deg, -3.0_deg);
+
+	TMatchingPairList in_correspondences;
+	in_correspondences.resize(nCorrs);
+	for (int i = 0; i < nCorrs; i++)
+	{
+		TMatchingPair& m = in_correspondences[i];
+		m.globalIdx = m.localIdx = i;
+		m.local.x = rng.drawUniform(-10.0f, 10.0f);
+		m.local.y = rng.drawUniform(-10.0f, 10.0f);
+		m.local.z = rng.drawUniform(-10.0f, 10.0f);
+		m.global = gtPose.composePoint(m.local);
+	}
+	const TMatchingPairListSoA in_correspondencesSoA(in_correspondences);
+
+	mrpt::math::TPose2D out_pose2D;
+	CPose3DQuat out_pose3D;
+	double out_scale;
+
+	const size_t N = nRepets;
+	CTicTac tictac;
+
+	tictac.Tic();
+	for (size_t i = 0; i < N; i++)
+	{
+		if (IS_3D)
+		{
+			if (USE_SOA)
+				se3_l2(in_correspondencesSoA, out_pose3D, out_scale);
+			else
+				se3_l2(in_correspondences, out_pose3D, out_scale);
+		}
+		else
+		{
+			if (USE_SOA) se2_l2(in_correspondencesSoA, out_pose2D);
+			else
+				se2_l2(in_correspondences, out_pose2D);
+		}
+	}
+	return tictac.Tac() / N;
+}
+
+// ------------------------------------------------------
+//				Benchmark: RANSAC with N threads
+// ------------------------------------------------------
+template <bool IS_3D>
+double tfest_test_6(int nThreads, int nRepets)
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	const CPose3D gtPose(1.0, 2.0, 0.0, 10.0_deg, 0.0, 0.0);
+
+	// 1000 correspondences, 30% of them outliers:
+	const int nCorrs = 1000;
+	TMatchingPairList in_correspondences;
+	in_correspondences.resize(nCorrs);
+	for (int i = 0; i < nCorrs; i++)
+	{
+		TMatchingPair& m = in_correspondences[i];
+		m.globalIdx = m.localIdx = i;
+		m.local.x = rng.drawUniform(-10.0f, 10.0f);
+		m.local.y = rng.drawUniform(-10.0f, 10.0f);
+		m.local.z = IS_3D ? rng.drawUniform(-10.0f, 10.0f) : 0.0f;
+		m.global = gtPose.composePoint(m.local);
+		if (i % 10 < 3) m.global.x += rng.drawUniform(1.0f, 5.0f);
+	}
+
+	TSE3RobustParams params3D;
+	params3D.ransac_nmaxSimulations = 20;
+	params3D.ransac_seed = 1;
+	params3D.numThreads = nThreads;
+	TSE3RobustResult res3D;
+
+	TSE2RobustParams params2D;
+	params2D.ransac_nSimulations = 500;
+	params2D.max_rmse_to_end = 1e-9;  // Run all iterations
+	params2D.ransac_seed = 1;
+	params2D.numThreads = nThreads;
+	TSE2RobustResult res2D;
+
+	const size_t N = nRepets;
+	CTicTac tictac;
+
+	tictac.Tic();
+	for (size_t i = 0; i < N; i++)
+	{
+		if (IS_3D) se3_l2_robust(in_correspondences, params3D, res3D);
+		else
+			se2_l2_robust(in_correspondences, 0.01, params2D, res2D);
+	}
+	return tictac.Tac() / N;
+}
+
 // ------------------------------------------------------
 // register_tests_scan_matching
 // ------------------------------------------------------
@@ -227,5 +326,17 @@ void register_tests_scan_matching()
 	lstTests.emplace_back("tfest: se2_l2 [x100 corrs] [SSE2 disabled]", tfest_test_4<true>, 100, 1e6);
 	lstTests.emplace_back("tfest: se2_l2 [x1000 corrs] [SSE2 disabled]", tfest_test_4<true>, 1000, 1e5);
 	lstTests.emplace_back("tfest: se2_l2 [x10000 corrs] [SSE2 disabled]", tfest_test_4<true>, 10000, 1e4);
+
+	lstTests.emplace_back("tfest: se2_l2 [x1000 corrs] [SoA]", tfest_test_5<false, true>, 1000, 1e5);
+	lstTests.emplace_back("tfest: se2_l2 [x10000 corrs] [SoA]", tfest_test_5<false, true>, 10000, 1e4);
+	lstTests.emplace_back("tfest: se3_l2 [x1000 corrs] [AoS]", tfest_test_5<true, false>, 1000, 1e4);
+	lstTests.emplace_back("tfest: se3_l2 [x1000 corrs] [SoA]", tfest_test_5<true, true>, 1000, 1e4);
+	lstTests.emplace_back("tfest: se3_l2 [x10000 corrs] [AoS]", tfest_test_5<true, false>, 10000, 1e3);
+	lstTests.emplace_back("tfest: se3_l2 [x10000 corrs] [SoA]", tfest_test_5<true, true>, 10000, 1e3);
+
+	lstTests.emplace_back("tfest: se2_l2_robust [x1000 corrs] [1 thread]", tfest_test_6<false>, 1, 20);
+	lstTests.emplace_back("tfest: se2_l2_robust [x1000 corrs] [4 threads]", tfest_test_6<false>, 4, 20);
+	lstTests.emplace_back("tfest: se3_l2_robust [x1000 corrs] [1 thread]", tfest_test_6<true>, 1, 5);
+	lstTests.emplace_back("tfest: se3_l2_robust [x1000 corrs] [4 threads]", tfest_test_6<true>, 4, 5);
 	// clang-format on
 }
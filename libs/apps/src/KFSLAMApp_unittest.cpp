@@ -80,6 +80,20 @@ TEST(KFSLAMApp, EKF_SLAM_2D)
 		});
 }
 
+TEST(KFSLAMApp, EKF_SLAM_2D_compressed)
+{
+	generic_kf_slam_test(
+		"EKF-SLAM_test_2d.ini", "kf-slam_demo.rawlog",
+		[](mrpt::config::CConfigFileBase& c) {
+			using namespace std::string_literals;
+			c.write("RangeBearingKFSLAM", "use_compressed_ekf", true);
+			c.write("RangeBearingKFSLAM", "compressed_ekf_region_radius", 2.0);
+
+			c.write("MappingApplication", "SHOW_3D_LIVE", false);
+			c.write("MappingApplication", "SAVE_3D_SCENES", true);
+		});
+}
+
 TEST(KFSLAMApp, EKF_SLAM_3D_data_assoc_JCBB_Maha)
 {
 	generic_kf_slam_test(
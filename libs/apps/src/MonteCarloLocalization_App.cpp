@@ -183,6 +183,7 @@ void MonteCarloLocalization_Base::do_pf_localization()
 	size_t rawlog_offset = cfg.read_int(sect, "rawlog_offset", 0);
 	string GT_FILE = cfg.read_string(sect, "ground_truth_path_file", "");
 	const auto NUM_REPS = cfg.read_uint64_t(sect, "experimentRepetitions", 1);
+	const int RANDOM_SEED = cfg.read_int(sect, "RANDOM_SEED", -1);
 	int SCENE3D_FREQ = cfg.read_int(sect, "3DSceneFrequency", 10);
 	bool SCENE3D_FOLLOW = cfg.read_bool(sect, "3DSceneFollowRobot", true);
 	unsigned int testConvergenceAt =
@@ -267,7 +268,9 @@ void MonteCarloLocalization_Base::do_pf_localization()
 		MRPT_LOG_INFO_STREAM(ss.str());
 	}
 
-	getRandomGenerator().randomize();
+	if (RANDOM_SEED >= 0) getRandomGenerator().randomize(RANDOM_SEED);
+	else
+		getRandomGenerator().randomize();
 
 	// Load the map (if any):
 	// -------------------------
@@ -29,6 +29,8 @@
 #include <mrpt/system/filesystem.h>	 // ASSERT_FILE_EXISTS_()
 #include <mrpt/system/memory.h>	 // getMemoryUsage()
 
+#include <numeric>
+
 using namespace mrpt::apps;
 
 constexpr auto sect = "MappingApplication";
@@ -456,10 +458,14 @@ void RBPF_SLAM_App_Base::run()
 				float minDistBtwPoses = -1;
 				std::deque<TPose3D> dummyPath;
 				mapBuilder->mapPDF.getPath(0, dummyPath);
+				std::vector<size_t> timeSteps(dummyPath.size());
+				std::iota(timeSteps.begin(), timeSteps.end(), 0);
+				std::vector<CPose3DPDFParticles> posePartsAtTimes;
+				mapBuilder->mapPDF.getEstimatedPosePDFsAtTimes(
+					timeSteps, posePartsAtTimes);
 				for (int k = (int)dummyPath.size() - 1; k >= 0; k--)
 				{
-					CPose3DPDFParticles poseParts;
-					mapBuilder->mapPDF.getEstimatedPosePDFAtTime(k, poseParts);
+					const CPose3DPDFParticles& poseParts = posePartsAtTimes[k];
 
 					const auto [COV, meanPose] =
 						poseParts.getCovarianceAndMean();
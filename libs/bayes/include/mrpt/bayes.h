@@ -13,5 +13,6 @@
 #include <mrpt/bayes/CParticleFilter.h>
 #include <mrpt/bayes/CParticleFilterCapable.h>
 #include <mrpt/bayes/CParticleFilterData.h>
+#include <mrpt/bayes/CParticleFilterDataSoA.h>
 #include <mrpt/bayes/CProbabilityParticle.h>
 #include <mrpt/bayes/CRejectionSamplingCapable.h>
@@ -15,6 +15,7 @@
 #include <mrpt/io/vector_loadsave.h>
 #include <mrpt/math/CMatrixDynamic.h>
 #include <mrpt/math/CMatrixFixed.h>
+#include <mrpt/math/CSparseMatrix.h>
 #include <mrpt/math/CVectorFixed.h>
 #include <mrpt/math/num_jacobian.h>
 #include <mrpt/math/utils.h>
@@ -24,6 +25,8 @@
 #include <mrpt/typemeta/TEnumType.h>
 
 #include <cstring>	// memcpy
+#include <map>
+#include <memory>
 #include <vector>
 
 namespace mrpt
@@ -44,6 +47,21 @@ enum TKFMethod
 	kfIKF
 };
 
+/** The representation of the state uncertainty in
+ * bayes::CKalmanFilterCapable
+ * \sa bayes::TKF_options::backend
+ * \ingroup mrpt_bayes_grp
+ */
+enum TKFBackend
+{
+	/** The full, dense covariance matrix (the classic EKF). */
+	kfbCovariance = 0,
+	/** A sparse information matrix (extended information filter), factored
+	 * with mrpt::math::CSparseMatrix::CholeskyDecomp. Optionally sparsified
+	 * as in SEIF, see TKF_options::information_max_active_landmarks. */
+	kfbSparseInformation
+};
+
 // Forward declaration:
 template <
 	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
@@ -65,6 +83,7 @@ struct TKF_options : public mrpt::config::CLoadableOptions
 		const std::string& section) override
 	{
 		method = iniFile.read_enum<TKFMethod>(section, "method", method);
+		backend = iniFile.read_enum<TKFBackend>(section, "backend", backend);
 		verbosity_level = iniFile.read_enum<mrpt::system::VerbosityLevel>(
 			section, "verbosity_level", verbosity_level);
 		MRPT_LOAD_CONFIG_VAR(IKF_iterations, int, iniFile, section);
@@ -78,6 +97,10 @@ struct TKF_options : public mrpt::config::CLoadableOptions
 		MRPT_LOAD_CONFIG_VAR(
 			debug_verify_analytic_jacobians_threshold, double, iniFile,
 			section);
+		MRPT_LOAD_CONFIG_VAR(
+			information_max_active_landmarks, int, iniFile, section);
+		MRPT_LOAD_CONFIG_VAR(
+			information_min_variance, double, iniFile, section);
 	}
 
 	/** This method must display clearly all the contents of the structure in
@@ -93,8 +116,17 @@ struct TKF_options : public mrpt::config::CLoadableOptions
 			mrpt::typemeta::TEnumType<mrpt::system::VerbosityLevel>::value2name(
 				verbosity_level)
 				.c_str());
+		out << mrpt::format(
+			"backend                                 = %s\n",
+			mrpt::typemeta::TEnumType<TKFBackend>::value2name(backend).c_str());
 		out << mrpt::format(
 			"IKF_iterations                          = %i\n", IKF_iterations);
+		out << mrpt::format(
+			"information_max_active_landmarks        = %u\n",
+			information_max_active_landmarks);
+		out << mrpt::format(
+			"information_min_variance                = %e\n",
+			information_min_variance);
 		out << mrpt::format(
 			"enable_profiler                         = %c\n",
 			enable_profiler ? 'Y' : 'N');
@@ -103,6 +135,10 @@ struct TKF_options : public mrpt::config::CLoadableOptions
 
 	/** The method to employ (default: kfEKFNaive) */
 	TKFMethod method{kfEKFNaive};
+	/** How the uncertainty of the state is stored (default: kfbCovariance).
+	 * kfbSparseInformation only supports the kfEKFNaive and kfIKFFull
+	 * methods. */
+	TKFBackend backend{kfbCovariance};
 	mrpt::system::VerbosityLevel& verbosity_level;
 	/** Number of refinement iterations, only for the IKF method. */
 	int IKF_iterations{5};
@@ -124,6 +160,17 @@ struct TKF_options : public mrpt::config::CLoadableOptions
 	/** (default-1e-2) Sets the threshold for the difference between the
 	 * analytic and the numerical jacobians */
 	double debug_verify_analytic_jacobians_threshold{1e-2};
+	/** Only for kfbSparseInformation: maximum number of landmarks linked to
+	 * the vehicle in the information matrix. Each motion step makes all of
+	 * them mutually linked, so the exact filter (0, the default) ends up
+	 * with a dense matrix. Above this number, the weakest links are removed
+	 * after each update with the SEIF sparsification approximation. */
+	unsigned int information_max_active_landmarks{0};
+	/** Only for kfbSparseInformation: added to the diagonal of a covariance
+	 * matrix set by the derived class before inverting it, so that singular
+	 * ones (e.g. a zero initial covariance, for a perfectly known initial
+	 * vehicle state) have an information matrix. */
+	double information_min_variance{1e-9};
 };
 
 /** Auxiliary functions, for internal usage of MRPT classes */
@@ -263,10 +310,11 @@ class CKalmanFilterCapable : public mrpt::system::COutputLogger
 	inline KFVector& internal_getXkk() { return m_xkk; }
 	inline KFMatrix& internal_getPkk() { return m_pkk; }
 	/** Returns the mean of the estimated value of the idx'th landmark (not
-	 * applicable to non-SLAM problems).
+	 * applicable to non-SLAM problems). Virtual, so derived classes which
+	 * keep landmarks out of the filter state can number them differently.
 	 * \exception std::exception On idx>= getNumberOfLandmarksInTheMap()
 	 */
-	inline void getLandmarkMean(size_t idx, KFArray_FEAT& feat) const
+	virtual void getLandmarkMean(size_t idx, KFArray_FEAT& feat) const
 	{
 		ASSERT_(idx < getNumberOfLandmarksInTheMap());
 		std::memcpy(
@@ -274,13 +322,33 @@ class CKalmanFilterCapable : public mrpt::system::COutputLogger
 			FEAT_SIZE * sizeof(m_xkk[0]));
 	}
 	/** Returns the covariance of the idx'th landmark (not applicable to
-	 * non-SLAM problems).
+	 * non-SLAM problems). Virtual, like getLandmarkMean().
 	 * \exception std::exception On idx>= getNumberOfLandmarksInTheMap()
 	 */
-	inline void getLandmarkCov(size_t idx, KFMatrix_FxF& feat_cov) const
+	virtual void getLandmarkCov(size_t idx, KFMatrix_FxF& feat_cov) const
+	{
+		ASSERT_(idx < getNumberOfLandmarksInTheMap());
+		KF_getCovarianceDiagBlock(VEH_SIZE + idx * FEAT_SIZE, feat_cov);
+	}
+	/** Returns the covariance of the vehicle state (or of the whole state,
+	 * for non-SLAM problems).
+	 */
+	inline void getVehicleCov(KFMatrix_VxV& veh_cov) const
+	{
+		KF_getCovarianceDiagBlock(0, veh_cov);
+	}
+	/** Returns the full covariance matrix of the state vector. With the
+	 * kfbSparseInformation backend, it is recovered from the information
+	 * matrix with one sparse solve per state variable.
+	 */
+	void getStateCovariance(KFMatrix& cov) const;
+	/** Returns the number of landmarks linked to the vehicle in the
+	 * information matrix (only for kfbSparseInformation).
+	 * \sa TKF_options::information_max_active_landmarks
+	 */
+	inline size_t getNumberOfActiveLandmarks() const
 	{
-		feat_cov = m_pkk.blockCopy<FEAT_SIZE, FEAT_SIZE>(
-			VEH_SIZE + idx * FEAT_SIZE, VEH_SIZE + idx * FEAT_SIZE);
+		return m_infoVY.size();
 	}
 
    protected:
@@ -289,7 +357,12 @@ class CKalmanFilterCapable : public mrpt::system::COutputLogger
 
 	/** The system state vector. */
 	KFVector m_xkk;
-	/** The system full covariance matrix. */
+	/** The system full covariance matrix. With the kfbSparseInformation
+	 * backend, it is empty, and the uncertainty is kept in the sparse
+	 * information matrix instead: use getVehicleCov(), getLandmarkCov() or
+	 * getStateCovariance() to read it. A non-empty matrix set by a derived
+	 * class (e.g. upon reset) is converted into the information form in the
+	 * next iteration. */
 	KFMatrix m_pkk;
 
 	/** @} */
@@ -445,6 +518,32 @@ class CKalmanFilterCapable : public mrpt::system::COutputLogger
 		m_user_didnt_implement_jacobian = true;
 	}
 
+	/** Batched version of OnObservationJacobians(), called once per
+	 * iteration with the indices of all the landmarks whose Jacobians are
+	 * needed (in the same way OnObservationModel() receives all of them at
+	 * once). The default implementation just calls OnObservationJacobians()
+	 * for each landmark; reimplement it to share per-iteration computations
+	 * (e.g. the sensor pose) among landmarks, to vectorize, or to evaluate the
+	 * Jacobians in parallel threads.
+	 * \param idx_landmarks_to_predict The indices of the landmarks in the map.
+	 * \param out_Hx Must be resized to the number of landmarks, with the
+	 * Jacobians \f$ \frac{\partial h_i}{\partial x} \f$.
+	 * \param out_Hy Likewise, the Jacobians \f$ \frac{\partial h_i}{\partial
+	 * y_i} \f$.
+	 */
+	virtual void OnObservationJacobiansBatch(
+		const std::vector<size_t>& idx_landmarks_to_predict,
+		std::vector<KFMatrix_OxV>& out_Hx,
+		std::vector<KFMatrix_OxF>& out_Hy) const
+	{
+		const size_t N = idx_landmarks_to_predict.size();
+		out_Hx.resize(N);
+		out_Hy.resize(N);
+		for (size_t i = 0; i < N && !m_user_didnt_implement_jacobian; i++)
+			OnObservationJacobians(
+				idx_landmarks_to_predict[i], out_Hx[i], out_Hy[i]);
+	}
+
 	/** Only called if using a numeric approximation of the observation
 	 * Jacobians, this method must return the increments in each dimension of
 	 * the vehicle state vector while estimating the Jacobian.
@@ -616,9 +715,41 @@ class CKalmanFilterCapable : public mrpt::system::COutputLogger
 	KFMatrix m_S;
 	vector_KFArray_OBS m_Z;	 // Each entry is one observation:
 	KFMatrix m_K;  // Kalman gain
-	KFMatrix m_S_1;	 // Inverse of m_S
-	KFMatrix m_dh_dx_full_obs;
-	KFMatrix m_aux_K_dh_dx;
+	/** P * H^t, for the observations used in the update */
+	KFMatrix m_PHt;
+	/** Indices in m_Hxs/m_Hys of the observations used in the update */
+	std::vector<size_t> m_updPredIdxs;
+	/** Landmarks predicted for the first time in this iteration, and their
+	 * analytic/numeric observation Jacobians */
+	std::vector<size_t> m_newPredLMidxs;
+	std::vector<KFMatrix_OxV> m_newHxsAnalytic, m_newHxsNumeric;
+	std::vector<KFMatrix_OxF> m_newHysAnalytic, m_newHysNumeric;
+	/** Saved landmark components, for the numeric Jacobians */
+	std::vector<KFTYPE> m_aux_feat_values;
+	/** The covariance of the vehicle and the predicted landmarks, in the
+	 * order of m_predictLMidxs (only for kfbSparseInformation) */
+	KFMatrix m_Psel;
+
+	/** @name Sparse information matrix (for kfbSparseInformation)
+	 * Only the upper triangle is stored, in blocks. Landmarks are only
+	 * linked to the vehicle while they are "active".
+		@{ */
+	KFMatrix_VxV m_infoVV;
+	/** Vehicle-landmark blocks, for the active landmarks */
+	std::map<size_t, KFMatrix_VxF> m_infoVY;
+	/** Landmark-landmark blocks: m_infoYY[i][j], for j>=i */
+	std::vector<std::map<size_t, KFMatrix_FxF>> m_infoYY;
+
+	/** A Cholesky factorization of the information matrix */
+	struct TInfoFactor
+	{
+		explicit TInfoFactor(size_t n) : A(n, n) {}
+		mrpt::math::CSparseMatrix A;
+		std::unique_ptr<mrpt::math::CSparseMatrix::CholeskyDecomp> chol;
+	};
+	/** Built on demand, and reset whenever the information matrix changes */
+	mutable std::shared_ptr<const TInfoFactor> m_infoFactor;
+	/** @} */
 
    protected:
 	/** The main entry point, executes one complete step: prediction + update.
@@ -636,12 +767,37 @@ class CKalmanFilterCapable : public mrpt::system::COutputLogger
 	static void KF_aux_estimate_trans_jacobian(
 		const KFArray_VEH& x, const std::pair<KFCLASS*, KFArray_ACT>& dat,
 		KFArray_VEH& out_x);
-	static void KF_aux_estimate_obs_Hx_jacobian(
-		const KFArray_VEH& x, const std::pair<KFCLASS*, size_t>& dat,
-		KFArray_OBS& out_x);
-	static void KF_aux_estimate_obs_Hy_jacobian(
-		const KFArray_FEAT& x, const std::pair<KFCLASS*, size_t>& dat,
-		KFArray_OBS& out_x);
+	/** Central-difference observation Jacobians of several landmarks at
+	 * once: each state component is perturbed in all of them and predicted
+	 * with a single OnObservationModel() call. */
+	void KF_aux_estimate_obs_jacobians(
+		const std::vector<size_t>& idx_landmarks_to_predict,
+		std::vector<KFMatrix_OxV>& out_Hx, std::vector<KFMatrix_OxF>& out_Hy);
+
+	/** The NxN covariance block of the state variables [first,first+N) */
+	template <size_t N>
+	void KF_getCovarianceDiagBlock(
+		size_t first, mrpt::math::CMatrixFixed<KFTYPE, N, N>& cov) const;
+
+	/** @name Sparse information backend
+		@{ */
+	/** Replaces m_pkk with the equivalent information matrix */
+	void KF_info_fromCovariance();
+	const TInfoFactor& KF_info_factor() const;
+	/** b = A^-1 * b, with A the information matrix */
+	void KF_info_solve(KFVector& b) const;
+	/** Returns the columns of the covariance matrix for the given state
+	 * variables */
+	void KF_info_covarianceColumns(
+		const std::vector<size_t>& vars, KFMatrix& cols) const;
+	/** Prediction of the information matrix, for a vehicle transition with
+	 * Jacobian F and noise covariance Q. O(k^2), with k the number of active
+	 * landmarks. */
+	void KF_info_predict(const KFMatrix_VxV& F, const KFMatrix_VxV& Q);
+	/** Deactivates the weakest vehicle-landmark links (SEIF sparsification)
+	 * while there are more than information_max_active_landmarks */
+	void KF_info_sparsify(const std::vector<size_t>& observedLMs);
+	/** @} */
 
 	template <
 		size_t VEH_SIZEb, size_t OBS_SIZEb, size_t FEAT_SIZEb, size_t ACT_SIZEb,
@@ -669,6 +825,12 @@ MRPT_FILL_ENUM(kfIKFFull);
 MRPT_FILL_ENUM(kfIKF);
 MRPT_ENUM_TYPE_END()
 
+MRPT_ENUM_TYPE_BEGIN(mrpt::bayes::TKFBackend)
+using namespace mrpt::bayes;
+MRPT_FILL_ENUM(kfbCovariance);
+MRPT_FILL_ENUM(kfbSparseInformation);
+MRPT_ENUM_TYPE_END()
+
 // Template implementation:
 #define CKalmanFilterCapable_H
 #include "CKalmanFilterCapable_impl.h"
@@ -16,6 +16,8 @@
 #include <mrpt/math/ops_matrices.h>	 // extractSubmatrixSymmetrical()
 
 #include <Eigen/Dense>
+#include <algorithm>  // count_if
+#include <tuple>
 
 namespace mrpt
 {
@@ -34,7 +36,26 @@ void CKalmanFilterCapable<
 	m_timLogger.enable(KF_options.enable_profiler);
 	m_timLogger.enter("KF:complete_step");
 
-	ASSERT_(int(m_xkk.size()) == m_pkk.cols());
+	const bool useInfo = KF_options.backend == kfbSparseInformation;
+	if (useInfo)
+	{
+		ASSERTMSG_(
+			KF_options.method == kfEKFNaive || KF_options.method == kfIKFFull,
+			"kfbSparseInformation only supports the kfEKFNaive and kfIKFFull "
+			"methods");
+		// A covariance set by the derived class (e.g. upon reset) replaces
+		// the current information matrix:
+		if (m_pkk.rows() != 0) KF_info_fromCovariance();
+	}
+	else if (m_pkk.rows() == 0 && m_xkk.size() != 0)
+	{
+		// Switching back from the information form:
+		getStateCovariance(m_pkk);
+		m_infoVY.clear();
+		m_infoYY.clear();
+		m_infoFactor.reset();
+	}
+	if (!useInfo) ASSERT_(int(m_xkk.size()) == m_pkk.cols());
 	ASSERT_(size_t(m_xkk.size()) >= VEH_SIZE);
 	// =============================================================
 	//  1. CREATE ACTION MATRIX u FROM ODOMETRY
@@ -132,29 +153,35 @@ void CKalmanFilterCapable<
 		KFMatrix_VxV Q;
 		OnTransitionNoise(Q);
 
-		// ====================================
-		//  3.1:  Pxx submatrix
-		// ====================================
-		// Replace old covariance:
-		m_pkk.asEigen().template block<VEH_SIZE, VEH_SIZE>(0, 0) = Q.asEigen() +
-			dfv_dxv.asEigen() * m_pkk.template block<VEH_SIZE, VEH_SIZE>(0, 0) *
-				dfv_dxv.asEigen().transpose();
-
-		// ====================================
-		//  3.2:  All Pxy_i
-		// ====================================
-		// Now, update the cov. of landmarks, if any:
-		KFMatrix_VxF aux;
-		for (size_t i = 0; i < N_map; i++)
+		if (useInfo) { KF_info_predict(dfv_dxv, Q); }
+		else
 		{
-			aux = dfv_dxv.asEigen() *
-				m_pkk.template block<VEH_SIZE, FEAT_SIZE>(
-					0, VEH_SIZE + i * FEAT_SIZE);
-
-			m_pkk.asEigen().template block<VEH_SIZE, FEAT_SIZE>(
-				0, VEH_SIZE + i * FEAT_SIZE) = aux.asEigen();
-			m_pkk.asEigen().template block<FEAT_SIZE, VEH_SIZE>(
-				VEH_SIZE + i * FEAT_SIZE, 0) = aux.asEigen().transpose();
+			// ====================================
+			//  3.1:  Pxx submatrix
+			// ====================================
+			// Replace old covariance:
+			m_pkk.asEigen().template block<VEH_SIZE, VEH_SIZE>(0, 0) =
+				Q.asEigen() +
+				dfv_dxv.asEigen() *
+					m_pkk.template block<VEH_SIZE, VEH_SIZE>(0, 0) *
+					dfv_dxv.asEigen().transpose();
+
+			// ====================================
+			//  3.2:  All Pxy_i
+			// ====================================
+			// Now, update the cov. of landmarks, if any:
+			KFMatrix_VxF aux;
+			for (size_t i = 0; i < N_map; i++)
+			{
+				aux = dfv_dxv.asEigen() *
+					m_pkk.template block<VEH_SIZE, FEAT_SIZE>(
+						0, VEH_SIZE + i * FEAT_SIZE);
+
+				m_pkk.asEigen().template block<VEH_SIZE, FEAT_SIZE>(
+					0, VEH_SIZE + i * FEAT_SIZE) = aux.asEigen();
+				m_pkk.asEigen().template block<FEAT_SIZE, VEH_SIZE>(
+					VEH_SIZE + i * FEAT_SIZE, 0) = aux.asEigen().transpose();
+			}
 		}
 
 		// =============================================================
@@ -266,92 +293,79 @@ void CKalmanFilterCapable<
 		m_Hxs.resize(N_pred);  // Append new entries, if needed.
 		m_Hys.resize(N_pred);
 
-		for (size_t i = first_new_pred; i < N_pred; ++i)
+		// Jacobians of the new predictions, all of them at once:
+		m_newPredLMidxs.assign(
+			m_predictLMidxs.begin() + first_new_pred, m_predictLMidxs.end());
+
+		// Try the analitic Jacobians first:
+		bool have_analytic_jacobians = false;
+		if (KF_options.use_analytic_observation_jacobian ||
+			KF_options.debug_verify_analytic_jacobians)
+		{
+			// Set to true by the default method if not reimplemented in
+			// base class:
+			m_user_didnt_implement_jacobian = false;
+			OnObservationJacobiansBatch(
+				m_newPredLMidxs, m_newHxsAnalytic, m_newHysAnalytic);
+			have_analytic_jacobians = !m_user_didnt_implement_jacobian;
+		}
+
+		if (have_analytic_jacobians &&
+			KF_options.use_analytic_observation_jacobian &&
+			!KF_options.debug_verify_analytic_jacobians)
 		{
-			const size_t lm_idx = FEAT_SIZE == 0 ? 0 : m_predictLMidxs[i];
-			KFMatrix_OxV& Hx = m_Hxs[i];
-			KFMatrix_OxF& Hy = m_Hys[i];
-
-			// Try the analitic Jacobian first:
-			m_user_didnt_implement_jacobian =
-				false;	// Set to true by the default method if not
-			// reimplemented in base class.
-			if (KF_options.use_analytic_observation_jacobian)
-				OnObservationJacobians(lm_idx, Hx, Hy);
-
-			if (m_user_didnt_implement_jacobian ||
-				!KF_options.use_analytic_observation_jacobian ||
-				KF_options.debug_verify_analytic_jacobians)
-			{  // Numeric approximation:
-				const size_t lm_idx_in_statevector =
-					VEH_SIZE + lm_idx * FEAT_SIZE;
-
-				const KFArray_VEH x_vehicle(&m_xkk[0]);
-				const KFArray_FEAT x_feat(&m_xkk[lm_idx_in_statevector]);
-
-				KFArray_VEH xkk_veh_increments;
-				KFArray_FEAT feat_increments;
-				OnObservationJacobiansNumericGetIncrements(
-					xkk_veh_increments, feat_increments);
-
-				mrpt::math::estimateJacobian(
-					x_vehicle,
-					std::function<void(
-						const KFArray_VEH& x,
-						const std::pair<KFCLASS*, size_t>& dat,
-						KFArray_OBS& out_x)>(&KF_aux_estimate_obs_Hx_jacobian),
-					xkk_veh_increments,
-					std::pair<KFCLASS*, size_t>(this, lm_idx), Hx);
-				// The state vector was temporarily modified by
-				// KF_aux_estimate_*, restore it:
-				std::memcpy(
-					&m_xkk[0], &x_vehicle[0], sizeof(m_xkk[0]) * VEH_SIZE);
-
-				mrpt::math::estimateJacobian(
-					x_feat,
-					std::function<void(
-						const KFArray_FEAT& x,
-						const std::pair<KFCLASS*, size_t>& dat,
-						KFArray_OBS& out_x)>(&KF_aux_estimate_obs_Hy_jacobian),
-					feat_increments, std::pair<KFCLASS*, size_t>(this, lm_idx),
-					Hy);
-				// The state vector was temporarily modified by
-				// KF_aux_estimate_*, restore it:
-				std::memcpy(
-					&m_xkk[lm_idx_in_statevector], &x_feat[0],
-					sizeof(m_xkk[0]) * FEAT_SIZE);
-
-				if (KF_options.debug_verify_analytic_jacobians)
+			std::copy(
+				m_newHxsAnalytic.begin(), m_newHxsAnalytic.end(),
+				m_Hxs.begin() + first_new_pred);
+			std::copy(
+				m_newHysAnalytic.begin(), m_newHysAnalytic.end(),
+				m_Hys.begin() + first_new_pred);
+		}
+		else
+		{  // Numeric approximation:
+			KF_aux_estimate_obs_jacobians(
+				m_newPredLMidxs, m_newHxsNumeric, m_newHysNumeric);
+			std::copy(
+				m_newHxsNumeric.begin(), m_newHxsNumeric.end(),
+				m_Hxs.begin() + first_new_pred);
+			std::copy(
+				m_newHysNumeric.begin(), m_newHysNumeric.end(),
+				m_Hys.begin() + first_new_pred);
+
+			for (size_t i = 0; have_analytic_jacobians &&
+				 KF_options.debug_verify_analytic_jacobians &&
+				 i < m_newPredLMidxs.size();
+				 i++)
+			{
+				const KFMatrix_OxV& Hx = m_newHxsNumeric[i];
+				const KFMatrix_OxF& Hy = m_newHysNumeric[i];
+				const KFMatrix_OxV& Hx_gt = m_newHxsAnalytic[i];
+				const KFMatrix_OxF& Hy_gt = m_newHysAnalytic[i];
+				if (KFMatrix(Hx - Hx_gt).sum_abs() >
+					KF_options.debug_verify_analytic_jacobians_threshold)
 				{
-					KFMatrix_OxV Hx_gt(mrpt::math::UNINITIALIZED_MATRIX);
-					KFMatrix_OxF Hy_gt(mrpt::math::UNINITIALIZED_MATRIX);
-					OnObservationJacobians(lm_idx, Hx_gt, Hy_gt);
-					if (KFMatrix(Hx - Hx_gt).sum_abs() >
-						KF_options.debug_verify_analytic_jacobians_threshold)
-					{
-						std::cerr << "[KalmanFilter] ERROR: User analytical "
-									 "observation Hx Jacobians are wrong: \n"
-								  << " Real Hx: \n"
-								  << Hx.asEigen() << "\n Analytical Hx:\n"
-								  << Hx_gt.asEigen() << "Diff:\n"
-								  << (Hx.asEigen() - Hx_gt.asEigen()) << "\n";
-						THROW_EXCEPTION(
-							"ERROR: User analytical observation Hx Jacobians "
-							"are wrong (More details dumped to cerr)");
-					}
-					if (KFMatrix(Hy - Hy_gt).sum_abs() >
-						KF_options.debug_verify_analytic_jacobians_threshold)
-					{
-						std::cerr << "[KalmanFilter] ERROR: User analytical "
-									 "observation Hy Jacobians are wrong: \n"
-								  << " Real Hy: \n"
-								  << Hy.asEigen() << "\n Analytical Hx:\n"
-								  << Hy_gt.asEigen() << "Diff:\n"
-								  << Hy.asEigen() - Hy_gt.asEigen() << "\n";
-						THROW_EXCEPTION(
-							"ERROR: User analytical observation Hy Jacobians "
-							"are wrong (More details dumped to cerr)");
-					}
+					std::cerr << "[KalmanFilter] ERROR: User analytical "
+								 "observation Hx Jacobians are wrong: \n"
+							  << " Real Hx: \n"
+							  << Hx.asEigen() << "\n Analytical Hx:\n"
+							  << Hx_gt.asEigen() << "Diff:\n"
+							  << (Hx.asEigen() - Hx_gt.asEigen()) << "\n";
+					THROW_EXCEPTION(
+						"ERROR: User analytical observation Hx Jacobians "
+						"are wrong (More details dumped to cerr)");
+				}
+				if (KFMatrix(Hy - Hy_gt).sum_abs() >
+					KF_options.debug_verify_analytic_jacobians_threshold)
+				{
+					std::cerr << "[KalmanFilter] ERROR: User analytical "
+								 "observation Hy Jacobians are wrong: \n"
+							  << " Real Hy: \n"
+							  << Hy.asEigen() << "\n Analytical Hx:\n"
+							  << Hy_gt.asEigen() << "Diff:\n"
+							  << Hy.asEigen() - Hy_gt.asEigen() << "\n";
+					THROW_EXCEPTION(
+						"ERROR: User analytical observation Hy Jacobians "
+						"are wrong (More details dumped to cerr)");
 				}
 			}
 		}
@@ -366,31 +380,56 @@ void CKalmanFilterCapable<
 		// ------------------------------------------
 		m_S.setSize(N_pred * OBS_SIZE, N_pred * OBS_SIZE);
 
+		// The information form only recovers the covariance of the vehicle
+		// and the predicted landmarks, in the order of m_predictLMidxs:
+		if (useInfo)
+		{
+			std::vector<size_t> vars;
+			vars.reserve(VEH_SIZE + N_pred * FEAT_SIZE);
+			for (size_t k = 0; k < VEH_SIZE; k++)
+				vars.push_back(k);
+			for (size_t i = 0; FEAT_SIZE != 0 && i < N_pred; i++)
+				for (size_t k = 0; k < FEAT_SIZE; k++)
+					vars.push_back(
+						VEH_SIZE + m_predictLMidxs[i] * FEAT_SIZE + k);
+
+			KFMatrix cols;
+			KF_info_covarianceColumns(vars, cols);
+			m_Psel.setSize(vars.size(), vars.size());
+			for (size_t r = 0; r < vars.size(); r++)
+				m_Psel.asEigen().row(r) = cols.asEigen().row(vars[r]);
+		}
+		const KFMatrix& Pcov = useInfo ? m_Psel : m_pkk;
+		// The offset in Pcov of the i'th predicted landmark:
+		const auto Pcov_lm_off = [&](size_t i) {
+			return VEH_SIZE + (useInfo ? i : m_predictLMidxs[i]) * FEAT_SIZE;
+		};
+
 		if (FEAT_SIZE > 0)
 		{  // SLAM-like problem:
 			// Covariance of the vehicle pose
-			const auto Px = m_pkk.template block<VEH_SIZE, VEH_SIZE>(0, 0);
+			const auto Px =
+				Pcov.asEigen().template block<VEH_SIZE, VEH_SIZE>(0, 0);
 
 			for (size_t i = 0; i < N_pred; ++i)
 			{
-				const size_t lm_idx_i = m_predictLMidxs[i];
 				// Pxyi^t
-				const auto Pxyi_t = m_pkk.template block<FEAT_SIZE, VEH_SIZE>(
-					VEH_SIZE + lm_idx_i * FEAT_SIZE, 0);
+				const auto Pxyi_t =
+					Pcov.asEigen().template block<FEAT_SIZE, VEH_SIZE>(
+						Pcov_lm_off(i), 0);
 
 				// Only do j>=i (upper triangle), since m_S is symmetric:
 				for (size_t j = i; j < N_pred; ++j)
 				{
-					const size_t lm_idx_j = m_predictLMidxs[j];
 					// Sij block:
 					mrpt::math::CMatrixFixed<KFTYPE, OBS_SIZE, OBS_SIZE> Sij;
 
-					const auto Pxyj = m_pkk.template block<VEH_SIZE, FEAT_SIZE>(
-						0, VEH_SIZE + lm_idx_j * FEAT_SIZE);
+					const auto Pxyj =
+						Pcov.asEigen().template block<VEH_SIZE, FEAT_SIZE>(
+							0, Pcov_lm_off(j));
 					const auto Pyiyj =
-						m_pkk.template block<FEAT_SIZE, FEAT_SIZE>(
-							VEH_SIZE + lm_idx_i * FEAT_SIZE,
-							VEH_SIZE + lm_idx_j * FEAT_SIZE);
+						Pcov.asEigen().template block<FEAT_SIZE, FEAT_SIZE>(
+							Pcov_lm_off(i), Pcov_lm_off(j));
 
 					// clang-format off
 					Sij = m_Hxs[i].asEigen() * Px     * m_Hxs[j].asEigen().transpose() +
@@ -418,7 +457,7 @@ void CKalmanFilterCapable<
 			ASSERTDEB_(N_pred == 1);
 			ASSERTDEB_(m_S.cols() == OBS_SIZE);
 
-			m_S = m_Hxs[0].asEigen() * m_pkk.asEigen() *
+			m_S = m_Hxs[0].asEigen() * Pcov.asEigen() *
 					m_Hxs[0].asEigen().transpose() +
 				R.asEigen();
 		}
@@ -481,23 +520,13 @@ void CKalmanFilterCapable<
 			case kfEKFNaive:
 			case kfIKFFull:
 			{
-				// Build the whole Jacobian dh_dx matrix
-				// ---------------------------------------------
-				// Keep only those whose DA is not -1
-				std::vector<int> mapIndicesForKFUpdate(data_association.size());
-				mapIndicesForKFUpdate.resize(std::distance(
-					mapIndicesForKFUpdate.begin(),
-					std::remove_copy_if(
-						data_association.begin(), data_association.end(),
-						mapIndicesForKFUpdate.begin(),
-						[](int i) { return i == -1; })));
-
-				const size_t N_upd =
-					(FEAT_SIZE == 0) ? 1 :	// Non-SLAM problems: Just one
-											// observation for the entire
-											// system.
-					mapIndicesForKFUpdate
-						.size();  // SLAM: # of observed known landmarks
+				// Keep only those observations whose DA is not -1
+				const size_t N_upd = (FEAT_SIZE == 0)
+					? 1	 // Non-SLAM problems: Just one observation for the
+						 // entire system.
+					: static_cast<size_t>(std::count_if(
+						  data_association.begin(), data_association.end(),
+						  [](int i) { return i >= 0; }));
 
 				// Just one, or several update iterations??
 				const size_t nKF_iterations = (KF_options.method == kfEKFNaive)
@@ -506,187 +535,369 @@ void CKalmanFilterCapable<
 
 				const KFVector xkk_0 = m_xkk;
 
-				// For each IKF iteration (or 1 for EKF)
 				if (N_upd > 0)	// Do not update if we have no observations!
 				{
-					for (size_t IKF_iteration = 0;
-						 IKF_iteration < nKF_iterations; IKF_iteration++)
-					{
-						// Compute ytilde = OBS - PREDICTION
-						KFVector ytilde(OBS_SIZE * N_upd);
-						size_t ytilde_idx = 0;
-
-						// TODO: Use a Matrix view of "dh_dx_full" instead of
-						// creating a copy into "m_dh_dx_full_obs"
-						m_dh_dx_full_obs.setZero(
-							N_upd * OBS_SIZE,
-							VEH_SIZE + FEAT_SIZE * N_map);	// Init to zeros.
-						KFMatrix S_observed;  // The KF "m_S" matrix: A
-						// re-ordered, subset, version of
-						// the prediction m_S:
-
-						if (FEAT_SIZE != 0)
-						{  // SLAM problems:
-							std::vector<size_t> S_idxs;
-							S_idxs.reserve(OBS_SIZE * N_upd);
-
-							// const size_t row_len = VEH_SIZE + FEAT_SIZE *
-							// N_map;
-
-							for (size_t i = 0; i < data_association.size(); ++i)
-							{
-								if (data_association[i] < 0) continue;
-
-								const auto assoc_idx_in_map =
-									static_cast<size_t>(data_association[i]);
-								const size_t assoc_idx_in_pred =
-									mrpt::containers::find_in_vector(
-										assoc_idx_in_map, m_predictLMidxs);
-								ASSERTMSG_(
-									assoc_idx_in_pred != string::npos,
-									"OnPreComputingPredictions() didn't "
-									"recommend the prediction of a landmark "
-									"which has been actually observed!");
-								// TODO: In these cases, extend the prediction
-								// right now instead of launching an
-								// exception... or is this a bad idea??
-
-								// Build the subset m_dh_dx_full_obs:
-								//										m_dh_dx_full_obs.block(S_idxs.size()
-								//,0, OBS_SIZE, row_len)
-								//										=
-								//										dh_dx_full.block
-								//(assoc_idx_in_pred*OBS_SIZE,0, OBS_SIZE,
-								// row_len);
-
-								m_dh_dx_full_obs
-									.template block<OBS_SIZE, VEH_SIZE>(
-										S_idxs.size(), 0) =
-									m_Hxs[assoc_idx_in_pred].asEigen();
-								m_dh_dx_full_obs
-									.template block<OBS_SIZE, FEAT_SIZE>(
-										S_idxs.size(),
-										VEH_SIZE +
-											assoc_idx_in_map * FEAT_SIZE) =
-									m_Hys[assoc_idx_in_pred].asEigen();
-
-								// S_idxs.size() is used as counter for
-								// "m_dh_dx_full_obs".
-								for (size_t k = 0; k < OBS_SIZE; k++)
-									S_idxs.push_back(
-										assoc_idx_in_pred * OBS_SIZE + k);
-
-								// ytilde_i = Z[i] - m_all_predictions[i]
-								KFArray_OBS ytilde_i = m_Z[i];
-								OnSubstractObservationVectors(
-									ytilde_i,
-									m_all_predictions
-										[m_predictLMidxs[assoc_idx_in_pred]]);
-								for (size_t k = 0; k < OBS_SIZE; k++)
-									ytilde[ytilde_idx++] = ytilde_i[k];
-							}
-							// Extract the subset that is involved in this
-							// observation:
-							mrpt::math::extractSubmatrixSymmetrical(
-								m_S, S_idxs, S_observed);
-						}
-						else
-						{  // Non-SLAM problems:
-							ASSERT_(
-								m_Z.size() == 1 &&
-								m_all_predictions.size() == 1);
-							ASSERT_(
-								m_dh_dx_full_obs.rows() == OBS_SIZE &&
-								m_dh_dx_full_obs.cols() == VEH_SIZE);
-							ASSERT_(m_Hxs.size() == 1);
-							m_dh_dx_full_obs = m_Hxs[0];  // Was: dh_dx_full
-							KFArray_OBS ytilde_i = m_Z[0];
+					// The full Jacobian dh_dx is never built: each block row
+					// only has non-zero entries for the vehicle (m_Hxs[]) and
+					// one landmark (m_Hys[]). Store the index of each
+					// observed prediction instead:
+					m_updPredIdxs.clear();
+					m_updPredIdxs.reserve(N_upd);
+					// And the index in m_Z of each of them:
+					std::vector<size_t> updObsIdxs;
+					updObsIdxs.reserve(N_upd);
+
+					// Compute ytilde = OBS - PREDICTION
+					KFVector ytilde(OBS_SIZE * N_upd);
+					KFMatrix S_observed;  // The KF "m_S" matrix: A
+					// re-ordered, subset, version of the prediction m_S:
+
+					if (FEAT_SIZE != 0)
+					{  // SLAM problems:
+						std::vector<size_t> S_idxs;
+						S_idxs.reserve(OBS_SIZE * N_upd);
+
+						for (size_t i = 0; i < data_association.size(); ++i)
+						{
+							if (data_association[i] < 0) continue;
+
+							const auto assoc_idx_in_map =
+								static_cast<size_t>(data_association[i]);
+							const size_t assoc_idx_in_pred =
+								mrpt::containers::find_in_vector(
+									assoc_idx_in_map, m_predictLMidxs);
+							ASSERTMSG_(
+								assoc_idx_in_pred != string::npos,
+								"OnPreComputingPredictions() didn't "
+								"recommend the prediction of a landmark "
+								"which has been actually observed!");
+
+							for (size_t k = 0; k < OBS_SIZE; k++)
+								S_idxs.push_back(
+									assoc_idx_in_pred * OBS_SIZE + k);
+
+							// ytilde_i = Z[i] - m_all_predictions[i]
+							KFArray_OBS ytilde_i = m_Z[i];
 							OnSubstractObservationVectors(
-								ytilde_i, m_all_predictions[0]);
+								ytilde_i,
+								m_all_predictions
+									[m_predictLMidxs[assoc_idx_in_pred]]);
 							for (size_t k = 0; k < OBS_SIZE; k++)
-								ytilde[ytilde_idx++] = ytilde_i[k];
-							// Extract the subset that is involved in this
-							// observation:
-							S_observed = m_S;
+								ytilde[m_updPredIdxs.size() * OBS_SIZE + k] =
+									ytilde_i[k];
+
+							m_updPredIdxs.push_back(assoc_idx_in_pred);
+							updObsIdxs.push_back(i);
 						}
+						// Extract the subset that is involved in this
+						// observation:
+						mrpt::math::extractSubmatrixSymmetrical(
+							m_S, S_idxs, S_observed);
+					}
+					else
+					{  // Non-SLAM problems:
+						ASSERT_(
+							m_Z.size() == 1 && m_all_predictions.size() == 1);
+						ASSERT_(m_Hxs.size() == 1);
+						KFArray_OBS ytilde_i = m_Z[0];
+						OnSubstractObservationVectors(
+							ytilde_i, m_all_predictions[0]);
+						for (size_t k = 0; k < OBS_SIZE; k++)
+							ytilde[k] = ytilde_i[k];
+						m_updPredIdxs.push_back(0);
+						updObsIdxs.push_back(0);
+						S_observed = m_S;
+					}
 
-						// Compute the full K matrix:
-						// ------------------------------
-						m_timLogger.enter("KF:8.update stage:1.FULLKF:build K");
+					// The landmark observed in each block row of dh_dx:
+					std::vector<size_t> upd_lm_idxs(N_upd, 0);
+					if (FEAT_SIZE != 0)
+						for (size_t k = 0; k < N_upd; k++)
+							upd_lm_idxs[k] = m_predictLMidxs[m_updPredIdxs[k]];
 
-						m_K.setSize(m_pkk.rows(), S_observed.cols());
+					KFMatrix_OxO R_inv;
+					if (useInfo)
+					{
+						const Eigen::LLT<typename KFMatrix_OxO::eigen_t>
+							R_llt(R.asEigen());
+						if (R_llt.info() != Eigen::Success)
+							THROW_EXCEPTION(
+								"kfbSparseInformation requires a positive "
+								"definite observation noise R");
+						R_inv.asEigen() = R_llt.solve(
+							KFMatrix_OxO::eigen_t::Identity());
+					}
 
-						// K = m_pkk * (~dh_dx) * m_S.inverse_LLt() );
-						m_K.asEigen() = m_pkk.asEigen() *
-							m_dh_dx_full_obs.asEigen().transpose();
+					// The information blocks modified by the update, to
+					// start over from them in each IKF relinearization:
+					KFMatrix_VxV infoVV_0;
+					std::map<size_t, KFMatrix_VxF> infoVY_0;
+					std::vector<KFMatrix_FxF> infoYY_0;
+					if (useInfo && nKF_iterations > 1)
+					{
+						infoVV_0 = m_infoVV;
+						infoVY_0 = m_infoVY;
+						for (size_t k = 0; FEAT_SIZE != 0 && k < N_upd; k++)
+							infoYY_0.push_back(
+								m_infoYY[upd_lm_idxs[k]][upd_lm_idxs[k]]);
+					}
 
-						// Inverse of S_observed -> m_S_1
-						m_S_1 = S_observed.inverse_LLt();
-						m_K.asEigen() *= m_S_1.asEigen();
+					// Computes the full K matrix (or updates the information
+					// matrix) for the current Jacobians in m_Hxs/m_Hys.
+					// S_observed is only valid for the first linearization.
+					Eigen::LLT<typename KFMatrix::eigen_t> S_llt;
+					const auto buildGain = [&](bool firstLinearization) {
+						if (!useInfo)
+						{
+							// m_PHt = m_pkk * (~dh_dx), using only the
+							// columns of m_pkk for the vehicle and the
+							// observed landmarks:
+							const size_t D = m_pkk.rows();
+							const auto P = m_pkk.asEigen();
+							m_PHt.setSize(D, OBS_SIZE * N_upd);
+							for (size_t k = 0; k < N_upd; k++)
+							{
+								const size_t pred_idx = m_updPredIdxs[k];
+								auto PHt_k = m_PHt.asEigen().block(
+									0, k * OBS_SIZE, D, OBS_SIZE);
+								PHt_k.noalias() = P.leftCols(VEH_SIZE) *
+									m_Hxs[pred_idx].asEigen().transpose();
+								if (FEAT_SIZE != 0)
+									PHt_k.noalias() +=
+										P.middleCols(
+											 VEH_SIZE +
+												 upd_lm_idxs[k] * FEAT_SIZE,
+											 FEAT_SIZE) *
+										m_Hys[pred_idx].asEigen().transpose();
+							}
 
-						m_timLogger.leave("KF:8.update stage:1.FULLKF:build K");
+							// S_observed = dh_dx * m_PHt + R
+							if (!firstLinearization)
+							{
+								const auto PHt = m_PHt.asEigen();
+								S_observed.setSize(
+									OBS_SIZE * N_upd, OBS_SIZE * N_upd);
+								for (size_t k = 0; k < N_upd; k++)
+								{
+									const size_t pred_idx = m_updPredIdxs[k];
+									auto S_k = S_observed.asEigen().block(
+										k * OBS_SIZE, 0, OBS_SIZE,
+										OBS_SIZE * N_upd);
+									S_k.noalias() =
+										m_Hxs[pred_idx].asEigen() *
+										PHt.topRows(VEH_SIZE);
+									if (FEAT_SIZE != 0)
+										S_k.noalias() +=
+											m_Hys[pred_idx].asEigen() *
+											PHt.middleRows(
+												VEH_SIZE +
+													upd_lm_idxs[k] * FEAT_SIZE,
+												FEAT_SIZE);
+									S_k.block(0, k * OBS_SIZE, OBS_SIZE,
+											  OBS_SIZE) += R.asEigen();
+								}
+							}
 
+							// S_observed = L * L^t, then:
+							//  K = m_PHt * S^-1
+							//  W = m_PHt * L^-t, such as K*S*K^t = W*W^t
+							// If S is not numerically positive definite, fall
+							// back to its plain inverse, as done before.
+							S_llt.compute(S_observed.asEigen());
+							m_K.setSize(D, OBS_SIZE * N_upd);
+							if (S_llt.info() == Eigen::Success)
+								m_K.asEigen() =
+									S_llt.solve(m_PHt.asEigen().transpose())
+										.transpose();
+							else
+							{
+								const KFMatrix S_inv = S_observed.inverse();
+								m_K.asEigen() =
+									m_PHt.asEigen() * S_inv.asEigen();
+							}
+							return;
+						}
+
+						// Information form: A += (~dh_dx) * R^-1 * dh_dx,
+						// which only touches the vehicle and observed
+						// landmark blocks. K is never built.
+						if (!firstLinearization)
+						{
+							m_infoVV = infoVV_0;
+							m_infoVY = infoVY_0;
+							for (size_t k = 0; k < infoYY_0.size(); k++)
+								m_infoYY[upd_lm_idxs[k]][upd_lm_idxs[k]] =
+									infoYY_0[k];
+						}
+						for (size_t k = 0; k < N_upd; k++)
+						{
+							const size_t pred_idx = m_updPredIdxs[k];
+							const auto& Hx = m_Hxs[pred_idx].asEigen();
+							const auto& Hy = m_Hys[pred_idx].asEigen();
+							const KFMatrix_VxO HxtRi(
+								Hx.transpose() * R_inv.asEigen());
+							m_infoVV.asEigen() += HxtRi.asEigen() * Hx;
+							if (FEAT_SIZE != 0)
+							{
+								const size_t lm = upd_lm_idxs[k];
+								m_infoVY[lm].asEigen() +=
+									HxtRi.asEigen() * Hy;
+								m_infoYY[lm][lm].asEigen() += Hy.transpose() *
+									R_inv.asEigen() * Hy;
+							}
+						}
+						m_infoFactor.reset();
+					};
+
+					m_timLogger.enter("KF:8.update stage:1.FULLKF:build K");
+					buildGain(true);
+					m_timLogger.leave("KF:8.update stage:1.FULLKF:build K");
+
+					// The mean increment K * r, for a stacked innovation r:
+					const auto gainTimes = [&](const KFVector& r) {
+						KFVector Ax;
+						Ax.resize(m_xkk.size());
+						if (!useInfo)
+						{
+							Ax.asEigen() = m_K.asEigen() * r.asEigen();
+							return Ax;
+						}
+						// K = A^-1 * (~dh_dx) * R^-1, with A the updated
+						// information matrix:
+						Ax.setZero();
+						for (size_t k = 0; k < N_upd; k++)
+						{
+							const size_t pred_idx = m_updPredIdxs[k];
+							const KFArray_OBS Ri_r(
+								R_inv.asEigen() *
+								r.asEigen().segment(k * OBS_SIZE, OBS_SIZE));
+							Ax.asEigen().head(VEH_SIZE) +=
+								m_Hxs[pred_idx].asEigen().transpose() *
+								Ri_r.asEigen();
+							if (FEAT_SIZE != 0)
+								Ax.asEigen().segment(
+									VEH_SIZE + upd_lm_idxs[k] * FEAT_SIZE,
+									FEAT_SIZE) +=
+									m_Hys[pred_idx].asEigen().transpose() *
+									Ri_r.asEigen();
+						}
+						KF_info_solve(Ax);
+						return Ax;
+					};
+
+					// For each IKF iteration (or 1 for EKF)
+					for (size_t IKF_iteration = 0;
+						 IKF_iteration < nKF_iterations; IKF_iteration++)
+					{
 						// Use the full K matrix to update the mean:
 						if (nKF_iterations == 1)
 						{
 							m_timLogger.enter(
 								"KF:8.update stage:2.FULLKF:update xkk");
-							m_xkk.asEigen() += (m_K * ytilde).eval();
+							m_xkk.asEigen() += gainTimes(ytilde).asEigen();
 							m_timLogger.leave(
 								"KF:8.update stage:2.FULLKF:update xkk");
-						}
-						else
-						{
-							m_timLogger.enter(
-								"KF:8.update stage:2.FULLKF:iter.update xkk");
-
-							auto HAx_column =
-								KFVector(m_dh_dx_full_obs * (m_xkk - xkk_0));
-
-							m_xkk = xkk_0;
-							m_xkk.asEigen() += m_K * (ytilde - HAx_column);
-
-							m_timLogger.leave(
-								"KF:8.update stage:2.FULLKF:iter.update xkk");
+							continue;
 						}
 
-						// Update the covariance just at the end
-						//  of iterations if we are in IKF, always in normal
-						//  EKF.
-						if (IKF_iteration == (nKF_iterations - 1))
+						m_timLogger.enter(
+							"KF:8.update stage:2.FULLKF:iter.update xkk");
+
+						// Iterated EKF: the observation model is linearized
+						// again (Jacobians H_i, gain K_i) at the last
+						// estimate x_i, then:
+						//  x_{i+1} = x_0 + K_i*(z - h(x_i) - H_i*(x_0 - x_i))
+						KFVector r = ytilde;
+						if (IKF_iteration > 0)
 						{
-							m_timLogger.enter(
-								"KF:8.update stage:3.FULLKF:update Pkk");
-
-							// Use the full K matrix to update the covariance:
-							// m_pkk = (I - K*dh_dx ) * m_pkk;
-							// TODO: "Optimize this: sparsity!"
+							vector_KFArray_OBS preds;
+							OnObservationModel(upd_lm_idxs, preds);
 
-							// K * m_dh_dx_full_obs
-							m_aux_K_dh_dx.matProductOf_AB(
-								m_K, m_dh_dx_full_obs);
+							bool analytic = false;
+							if (KF_options.use_analytic_observation_jacobian)
+							{
+								m_user_didnt_implement_jacobian = false;
+								OnObservationJacobiansBatch(
+									upd_lm_idxs, m_newHxsAnalytic,
+									m_newHysAnalytic);
+								analytic = !m_user_didnt_implement_jacobian;
+							}
+							if (!analytic)
+								KF_aux_estimate_obs_jacobians(
+									upd_lm_idxs, m_newHxsNumeric,
+									m_newHysNumeric);
+							for (size_t k = 0; k < N_upd; k++)
+							{
+								const size_t pred_idx = m_updPredIdxs[k];
+								m_Hxs[pred_idx] = analytic
+									? m_newHxsAnalytic[k]
+									: m_newHxsNumeric[k];
+								m_Hys[pred_idx] = analytic
+									? m_newHysAnalytic[k]
+									: m_newHysNumeric[k];
+							}
+							buildGain(false);
 
-							// m_aux_K_dh_dx  <-- I-m_aux_K_dh_dx
-							const size_t stat_len = m_aux_K_dh_dx.cols();
-							for (size_t r = 0; r < stat_len; r++)
+							const KFVector Ax = m_xkk - xkk_0;
+							for (size_t k = 0; k < N_upd; k++)
 							{
-								for (size_t c = 0; c < stat_len; c++)
-								{
-									if (r == c)
-										m_aux_K_dh_dx(r, c) =
-											-m_aux_K_dh_dx(r, c) + kftype(1);
-									else
-										m_aux_K_dh_dx(r, c) =
-											-m_aux_K_dh_dx(r, c);
-								}
+								const size_t pred_idx = m_updPredIdxs[k];
+								KFArray_OBS r_k = m_Z[updObsIdxs[k]];
+								OnSubstractObservationVectors(r_k, preds[k]);
+								r_k.asEigen() += m_Hxs[pred_idx].asEigen() *
+									Ax.asEigen().head(VEH_SIZE);
+								if (FEAT_SIZE != 0)
+									r_k.asEigen() += m_Hys[pred_idx].asEigen() *
+										Ax.asEigen().segment(
+											VEH_SIZE +
+												upd_lm_idxs[k] * FEAT_SIZE,
+											FEAT_SIZE);
+								r.asEigen().segment(k * OBS_SIZE, OBS_SIZE) =
+									r_k.asEigen();
 							}
+						}
 
-							m_pkk = m_aux_K_dh_dx * m_pkk;
+						m_xkk = xkk_0;
+						m_xkk.asEigen() += gainTimes(r).asEigen();
 
-							m_timLogger.leave(
-								"KF:8.update stage:3.FULLKF:update Pkk");
-						}
+						m_timLogger.leave(
+							"KF:8.update stage:2.FULLKF:iter.update xkk");
 					}  // end for each IKF iteration
+
+					// Update the covariance just at the end of iterations if
+					// we are in IKF, always in normal EKF. The information
+					// matrix was already updated above.
+					if (!useInfo)
+					{
+						m_timLogger.enter(
+							"KF:8.update stage:3.FULLKF:update Pkk");
+
+						// m_pkk = (I - K*dh_dx) * m_pkk = m_pkk - W * W^t
+						// As a symmetric rank update on the upper triangle
+						// only, O(n^2) per observation instead of the O(n^3)
+						// of the dense (I - K*dh_dx) * m_pkk product.
+						auto Pkk = m_pkk.asEigen();
+						if (S_llt.info() == Eigen::Success)
+						{
+							const typename KFMatrix::eigen_t W =
+								S_llt.matrixL()
+									.solve(m_PHt.asEigen().transpose())
+									.transpose();
+							Pkk.template selfadjointView<Eigen::Upper>()
+								.rankUpdate(W, kftype(-1));
+						}
+						else
+						{
+							// m_pkk - K * m_PHt^t, with the inverse of S:
+							Pkk.template triangularView<Eigen::Upper>() -=
+								m_K.asEigen() * m_PHt.asEigen().transpose();
+						}
+						Pkk.template triangularView<Eigen::StrictlyLower>() =
+							Pkk.transpose();
+
+						m_timLogger.leave(
+							"KF:8.update stage:3.FULLKF:update Pkk");
+					}
 				}
 			}
 			break;
@@ -852,6 +1063,19 @@ void CKalmanFilterCapable<
 							for (size_t k = 0; k < N; k++)
 								m_xkk[k] += Kij[k] * ytilde[j];
 
+							// The next components of this observation must
+							// see the updated state:
+							//  ytilde(ij') -= dhij'_dx * Kij * ytilde(ij)
+							for (size_t jj = j + 1; jj < OBS_SIZE; jj++)
+							{
+								KFTYPE HK = 0;
+								for (size_t q = 0; q < VEH_SIZE; q++)
+									HK += Hx(jj, q) * Kij[q];
+								for (size_t q = 0; q < FEAT_SIZE; q++)
+									HK += Hy(jj, q) * Kij[idx_off + q];
+								ytilde[jj] -= HK * ytilde[j];
+							}
+
 							// Update the covariance Pkk:
 							// P' =  P - Kij * Sij * Kij^t
 							{
@@ -914,6 +1138,19 @@ void CKalmanFilterCapable<
 		m_timLogger.leave("KF:A.add new landmarks");
 	}  // end if data_association!=empty
 
+	// Bound the number of active landmarks in the information form, keeping
+	// those observed in this iteration whenever possible:
+	if (useInfo && FEAT_SIZE != 0 &&
+		KF_options.information_max_active_landmarks != 0)
+	{
+		std::vector<size_t> observedLMs;
+		for (int i : data_association)
+			if (i >= 0) observedLMs.push_back(static_cast<size_t>(i));
+		for (size_t i = N_map; i < getNumberOfLandmarksInTheMap(); i++)
+			observedLMs.push_back(i);
+		KF_info_sparsify(observedLMs);
+	}
+
 	// Post iteration user code:
 	m_timLogger.enter("KF:B.OnPostIteration");
 	OnPostIteration();
@@ -947,37 +1184,361 @@ template <
 	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
 	typename KFTYPE>
 void CKalmanFilterCapable<VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::
-	KF_aux_estimate_obs_Hx_jacobian(
-		const KFArray_VEH& x, const std::pair<KFCLASS*, size_t>& dat,
-		KFArray_OBS& out_x)
+	KF_aux_estimate_obs_jacobians(
+		const std::vector<size_t>& idx_landmarks_to_predict,
+		std::vector<KFMatrix_OxV>& out_Hx, std::vector<KFMatrix_OxF>& out_Hy)
+{
+	const size_t N = idx_landmarks_to_predict.size();
+	out_Hx.resize(N);
+	out_Hy.resize(N);
+
+	KFArray_VEH veh_increments;
+	KFArray_FEAT feat_increments;
+	OnObservationJacobiansNumericGetIncrements(veh_increments, feat_increments);
+
+	// Central differences, as in mrpt::math::estimateJacobian(), but
+	// predicting all the landmarks with each modified state vector:
+	vector_KFArray_OBS f_plus, f_minus;
+
+	// dh_dx: Increment each vehicle state variable:
+	for (size_t j = 0; j < VEH_SIZE; j++)
+	{
+		ASSERT_(veh_increments[j] > 0);
+		const KFTYPE x_j = m_xkk[j];
+		m_xkk[j] = x_j + veh_increments[j];
+		OnObservationModel(idx_landmarks_to_predict, f_plus);
+		m_xkk[j] = x_j - veh_increments[j];
+		OnObservationModel(idx_landmarks_to_predict, f_minus);
+		m_xkk[j] = x_j;	 // Leave as original
+
+		const double Ax_2_inv = 0.5 / veh_increments[j];
+		for (size_t i = 0; i < N; i++)
+			for (size_t r = 0; r < OBS_SIZE; r++)
+				out_Hx[i](r, j) = Ax_2_inv * (f_plus[i][r] - f_minus[i][r]);
+	}
+
+	// dh_dy: Each prediction only depends on its own landmark, so the same
+	// variable of all the landmarks can be incremented at once:
+	const auto stateIdx = [&](size_t i, size_t j) {
+		return VEH_SIZE + idx_landmarks_to_predict[i] * FEAT_SIZE + j;
+	};
+	m_aux_feat_values.resize(N);
+	for (size_t j = 0; j < FEAT_SIZE; j++)
+	{
+		ASSERT_(feat_increments[j] > 0);
+		for (size_t i = 0; i < N; i++)
+		{
+			m_aux_feat_values[i] = m_xkk[stateIdx(i, j)];
+			m_xkk[stateIdx(i, j)] = m_aux_feat_values[i] + feat_increments[j];
+		}
+		OnObservationModel(idx_landmarks_to_predict, f_plus);
+		for (size_t i = 0; i < N; i++)
+			m_xkk[stateIdx(i, j)] = m_aux_feat_values[i] - feat_increments[j];
+		OnObservationModel(idx_landmarks_to_predict, f_minus);
+		for (size_t i = 0; i < N; i++)	// Leave as original
+			m_xkk[stateIdx(i, j)] = m_aux_feat_values[i];
+
+		const double Ax_2_inv = 0.5 / feat_increments[j];
+		for (size_t i = 0; i < N; i++)
+			for (size_t r = 0; r < OBS_SIZE; r++)
+				out_Hy[i](r, j) = Ax_2_inv * (f_plus[i][r] - f_minus[i][r]);
+	}
+}
+
+template <
+	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
+	typename KFTYPE>
+template <size_t N>
+void CKalmanFilterCapable<VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::
+	KF_getCovarianceDiagBlock(
+		size_t first, mrpt::math::CMatrixFixed<KFTYPE, N, N>& cov) const
+{
+	if (m_pkk.rows() != 0 || m_xkk.size() == 0)
+	{
+		cov = m_pkk.template blockCopy<N, N>(first, first);
+		return;
+	}
+	std::vector<size_t> vars(N);
+	for (size_t k = 0; k < N; k++)
+		vars[k] = first + k;
+	KFMatrix cols;
+	KF_info_covarianceColumns(vars, cols);
+	cov.asEigen() = cols.asEigen().template block<N, N>(first, 0);
+}
+
+template <
+	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
+	typename KFTYPE>
+void CKalmanFilterCapable<VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::
+	getStateCovariance(KFMatrix& cov) const
+{
+	if (m_pkk.rows() != 0 || m_xkk.size() == 0)
+	{
+		cov = m_pkk;
+		return;
+	}
+	KF_info_covarianceColumns(
+		mrpt::math::sequenceStdVec<size_t, 1>(0, m_xkk.size()), cov);
+}
+
+template <
+	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
+	typename KFTYPE>
+void CKalmanFilterCapable<
+	VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::KF_info_fromCovariance()
+{
+	const size_t n = m_xkk.size();
+	ASSERT_EQUAL_(size_t(m_pkk.rows()), n);
+	const size_t N = getNumberOfLandmarksInTheMap();
+
+	// The small regularization makes exactly zero covariances (e.g. upon
+	// reset) invertible, and keeps the zero blocks of a block-diagonal P:
+	typename KFMatrix::eigen_t P = m_pkk.asEigen();
+	P.diagonal().array() += KFTYPE(KF_options.information_min_variance);
+	const Eigen::LLT<typename KFMatrix::eigen_t> llt(P);
+	if (llt.info() != Eigen::Success)
+		THROW_EXCEPTION("The covariance matrix is not positive semidefinite");
+	const typename KFMatrix::eigen_t A =
+		llt.solve(KFMatrix::eigen_t::Identity(n, n));
+
+	const auto isZero = [](const auto& B) { return (B.array() == 0).all(); };
+	m_infoVV.asEigen() = A.template block<VEH_SIZE, VEH_SIZE>(0, 0);
+	m_infoVY.clear();
+	m_infoYY.assign(N, {});
+	for (size_t i = 0; i < N; i++)
+	{
+		const size_t oi = VEH_SIZE + i * FEAT_SIZE;
+		const auto Avi = A.template block<VEH_SIZE, FEAT_SIZE>(0, oi);
+		if (!isZero(Avi)) m_infoVY[i].asEigen() = Avi;
+		for (size_t j = i; j < N; j++)
+		{
+			const auto Aij = A.template block<FEAT_SIZE, FEAT_SIZE>(
+				oi, VEH_SIZE + j * FEAT_SIZE);
+			if (!isZero(Aij)) m_infoYY[i][j].asEigen() = Aij;
+		}
+	}
+	m_pkk.setSize(0, 0);
+	m_infoFactor.reset();
+}
+
+template <
+	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
+	typename KFTYPE>
+auto CKalmanFilterCapable<
+	VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::KF_info_factor() const
+	-> const TInfoFactor&
+{
+	if (m_infoFactor) return *m_infoFactor;
+
+	auto f = std::make_shared<TInfoFactor>(m_xkk.size());
+	// Only the upper triangle is used by the Cholesky factorization:
+	const auto insertBlock = [&f](
+								 size_t r0, size_t c0, const auto& B,
+								 bool diagonal) {
+		for (int r = 0; r < B.rows(); r++)
+			for (int c = diagonal ? r : 0; c < B.cols(); c++)
+				if (B(r, c) != 0) f->A.insert_entry(r0 + r, c0 + c, B(r, c));
+	};
+	insertBlock(0, 0, m_infoVV, true);
+	for (const auto& [j, B] : m_infoVY)
+		insertBlock(0, VEH_SIZE + j * FEAT_SIZE, B, false);
+	for (size_t i = 0; i < m_infoYY.size(); i++)
+		for (const auto& [j, B] : m_infoYY[i])
+			insertBlock(
+				VEH_SIZE + i * FEAT_SIZE, VEH_SIZE + j * FEAT_SIZE, B, i == j);
+	f->A.compressFromTriplet();
+	f->chol = std::make_unique<mrpt::math::CSparseMatrix::CholeskyDecomp>(f->A);
+
+	m_infoFactor = f;
+	return *f;
+}
+
+template <
+	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
+	typename KFTYPE>
+void CKalmanFilterCapable<
+	VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::KF_info_solve(KFVector& b)
+	const
+{
+	const TInfoFactor& f = KF_info_factor();
+	const size_t n = b.size();
+	std::vector<double> rhs(n), x(n);
+	for (size_t i = 0; i < n; i++)
+		rhs[i] = b[i];
+	f.chol->backsub(rhs.data(), x.data(), n);
+	for (size_t i = 0; i < n; i++)
+		b[i] = static_cast<KFTYPE>(x[i]);
+}
+
+template <
+	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
+	typename KFTYPE>
+void CKalmanFilterCapable<VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::
+	KF_info_covarianceColumns(
+		const std::vector<size_t>& vars, KFMatrix& cols) const
+{
+	const TInfoFactor& f = KF_info_factor();
+	const size_t n = m_xkk.size();
+	cols.setSize(n, vars.size());
+	std::vector<double> e(n, 0.0), x(n);
+	for (size_t k = 0; k < vars.size(); k++)
+	{
+		e[vars[k]] = 1.0;
+		f.chol->backsub(e.data(), x.data(), n);
+		e[vars[k]] = 0.0;
+		for (size_t i = 0; i < n; i++)
+			cols(i, k) = static_cast<KFTYPE>(x[i]);
+	}
+}
+
+template <
+	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
+	typename KFTYPE>
+void CKalmanFilterCapable<VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::
+	KF_info_predict(const KFMatrix_VxV& F, const KFMatrix_VxV& Q)
 {
-	std::vector<size_t> idxs_to_predict(1, dat.second);
-	vector_KFArray_OBS prediction;
-	// Overwrite (temporarily!) the affected part of the state vector:
-	std::memcpy(&dat.first->m_xkk[0], &x[0], sizeof(x[0]) * VEH_SIZE);
-	dat.first->OnObservationModel(idxs_to_predict, prediction);
-	ASSERTDEB_(prediction.size() == 1);
-	out_x = prediction[0];
+	using MatVV = typename KFMatrix_VxV::eigen_t;
+
+	// x_v' = F * x_v + w, with w ~ N(0, Q = G * G^t):
+	//  1) F changes the vehicle rows of A: A_v: <- F^-t * A_v:
+	//  2) The noise is added with the matrix inversion lemma:
+	//     A' = A - A_:v * M * A_v:,  M = G * (I + G^t * A_vv * G)^-1 * G^t
+	//     which links all the active landmarks among them.
+	const Eigen::FullPivLU<MatVV> lu(F.asEigen());
+	if (!lu.isInvertible())
+		THROW_EXCEPTION(
+			"kfbSparseInformation requires an invertible transition Jacobian");
+	const MatVV Fit = lu.inverse().transpose();
+
+	const Eigen::SelfAdjointEigenSolver<MatVV> es(Q.asEigen());
+	const MatVV G = es.eigenvectors() *
+		es.eigenvalues().cwiseMax(KFTYPE(0)).cwiseSqrt().asDiagonal();
+
+	const MatVV Avv = Fit * m_infoVV.asEigen() * Fit.transpose();
+	for (auto& e : m_infoVY)
+		e.second.asEigen() = Fit * e.second.asEigen();
+
+	const Eigen::LLT<MatVV> llt(MatVV::Identity() + G.transpose() * Avv * G);
+	if (llt.info() != Eigen::Success)
+		THROW_EXCEPTION(
+			"The vehicle information matrix is not positive semidefinite");
+	const MatVV M = G * llt.solve(G.transpose());
+
+	for (auto a = m_infoVY.begin(); a != m_infoVY.end(); ++a)
+	{
+		const Eigen::Matrix<KFTYPE, FEAT_SIZE, VEH_SIZE> AyaM =
+			a->second.asEigen().transpose() * M;
+		for (auto b = a; b != m_infoVY.end(); ++b)
+			m_infoYY[a->first][b->first].asEigen() -=
+				AyaM * b->second.asEigen();
+	}
+	const MatVV AvvM = Avv * M;
+	for (auto& e : m_infoVY)
+		e.second.asEigen() -= AvvM * e.second.asEigen();
+	const MatVV Avv_new = Avv - AvvM * Avv;
+	m_infoVV.asEigen() = KFTYPE(0.5) * (Avv_new + Avv_new.transpose());
+
+	m_infoFactor.reset();
 }
 
 template <
 	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
 	typename KFTYPE>
 void CKalmanFilterCapable<VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::
-	KF_aux_estimate_obs_Hy_jacobian(
-		const KFArray_FEAT& x, const std::pair<KFCLASS*, size_t>& dat,
-		KFArray_OBS& out_x)
+	KF_info_sparsify(const std::vector<size_t>& observedLMs)
 {
-	std::vector<size_t> idxs_to_predict(1, dat.second);
-	vector_KFArray_OBS prediction;
-	const size_t lm_idx_in_statevector = VEH_SIZE + FEAT_SIZE * dat.second;
-	// Overwrite (temporarily!) the affected part of the state vector:
-	std::memcpy(
-		&dat.first->m_xkk[lm_idx_in_statevector], &x[0],
-		sizeof(x[0]) * FEAT_SIZE);
-	dat.first->OnObservationModel(idxs_to_predict, prediction);
-	ASSERTDEB_(prediction.size() == 1);
-	out_x = prediction[0];
+	const size_t maxActive = KF_options.information_max_active_landmarks;
+	if (maxActive == 0 || m_infoVY.size() <= maxActive) return;
+
+	// Deactivate the weakest vehicle-landmark links, those of the observed
+	// landmarks only if there are more than maxActive of them:
+	std::vector<std::tuple<bool, KFTYPE, size_t>> links;
+	for (const auto& [j, B] : m_infoVY)
+		links.emplace_back(
+			std::find(observedLMs.begin(), observedLMs.end(), j) !=
+				observedLMs.end(),
+			B.asEigen().norm(), j);
+	std::sort(links.begin(), links.end());
+	const size_t nDeact = links.size() - maxActive;
+
+	// The dense information of [x_v, m+, m0], with m0 the landmarks to
+	// deactivate and m+ those which remain active:
+	std::vector<size_t> lms;
+	for (size_t k = nDeact; k < links.size(); k++)
+		lms.push_back(std::get<2>(links[k]));
+	for (size_t k = 0; k < nDeact; k++)
+		lms.push_back(std::get<2>(links[k]));
+	const size_t d = VEH_SIZE + lms.size() * FEAT_SIZE;
+	const size_t m0_first = d - nDeact * FEAT_SIZE;
+
+	typename KFMatrix::eigen_t D = KFMatrix::eigen_t::Zero(d, d);
+	D.template block<VEH_SIZE, VEH_SIZE>(0, 0) = m_infoVV.asEigen();
+	for (size_t a = 0; a < lms.size(); a++)
+	{
+		const size_t oa = VEH_SIZE + a * FEAT_SIZE;
+		D.template block<VEH_SIZE, FEAT_SIZE>(0, oa) =
+			m_infoVY[lms[a]].asEigen();
+		D.template block<FEAT_SIZE, VEH_SIZE>(oa, 0) =
+			m_infoVY[lms[a]].asEigen().transpose();
+		for (size_t b = 0; b < lms.size(); b++)
+		{
+			const auto& row = m_infoYY[std::min(lms[a], lms[b])];
+			const auto it = row.find(std::max(lms[a], lms[b]));
+			if (it == row.end()) continue;
+			auto Dab = D.template block<FEAT_SIZE, FEAT_SIZE>(
+				oa, VEH_SIZE + b * FEAT_SIZE);
+			if (lms[a] <= lms[b]) Dab = it->second.asEigen();
+			else
+				Dab = it->second.asEigen().transpose();
+		}
+	}
+
+	// D[:,s] * D[s,s]^-1 * D[s,:], for a subset of variables s:
+	const auto marginalTerm = [&D, d](const std::vector<size_t>& s) {
+		typename KFMatrix::eigen_t Ds(d, s.size()), Dss(s.size(), s.size());
+		for (size_t k = 0; k < s.size(); k++)
+			Ds.col(k) = D.col(s[k]);
+		for (size_t k = 0; k < s.size(); k++)
+			Dss.row(k) = Ds.row(s[k]);
+		const Eigen::LLT<typename KFMatrix::eigen_t> llt(Dss);
+		if (llt.info() != Eigen::Success)
+			THROW_EXCEPTION(
+				"The information matrix is not positive definite");
+		return typename KFMatrix::eigen_t(Ds * llt.solve(Ds.transpose()));
+	};
+	std::vector<size_t> x_idxs, m0_idxs;
+	for (size_t k = 0; k < VEH_SIZE; k++)
+		x_idxs.push_back(k);
+	for (size_t k = m0_first; k < d; k++)
+		m0_idxs.push_back(k);
+	std::vector<size_t> xm0_idxs = x_idxs;
+	xm0_idxs.insert(xm0_idxs.end(), m0_idxs.begin(), m0_idxs.end());
+
+	// SEIF sparsification: the vehicle is conditioned on m0 = its mean,
+	// then m0 is marginalized out of that conditional and re-added:
+	const typename KFMatrix::eigen_t Dn = D - marginalTerm(m0_idxs) +
+		marginalTerm(xm0_idxs) - marginalTerm(x_idxs);
+
+	m_infoVV.asEigen() = Dn.template block<VEH_SIZE, VEH_SIZE>(0, 0);
+	for (size_t a = 0; a < lms.size(); a++)
+	{
+		const size_t oa = VEH_SIZE + a * FEAT_SIZE;
+		if (oa < m0_first)
+			m_infoVY[lms[a]].asEigen() =
+				Dn.template block<VEH_SIZE, FEAT_SIZE>(0, oa);
+		else
+			m_infoVY.erase(lms[a]);
+		for (size_t b = 0; b < lms.size(); b++)
+		{
+			if (lms[a] > lms[b]) continue;
+			const auto Dab = Dn.template block<FEAT_SIZE, FEAT_SIZE>(
+				oa, VEH_SIZE + b * FEAT_SIZE);
+			auto& row = m_infoYY[lms[a]];
+			if (!(Dab.array() == 0).all() || row.count(lms[b]))
+				row[lms[b]].asEigen() = Dab;
+		}
+	}
+	m_infoFactor.reset();
 }
 
 namespace detail
@@ -1042,6 +1603,36 @@ void addNewLandmarks(
 			for (q = 0; q < FEAT_SIZE; q++)
 				obj.internal_getXkk()[idx + q] = yn[q];
 
+			if (obj.KF_options.backend == kfbSparseInformation)
+			{
+				// Information form: the new landmark is only linked to the
+				// vehicle, through its inverse sensor model:
+				//  yn = g(xv, z) ~ N(dyn_dxv * xv, Pn = dyn_dhn * R * ~dyn_dhn)
+				ASSERT_EQUAL_(obj.m_infoYY.size(), newIndexInMap);
+				typename KF::KFMatrix_FxF Pn = dyn_dhn_R_dyn_dhnT;
+				if (use_dyn_dhn_jacobian)
+					Pn = mrpt::math::multiply_HCHt(dyn_dhn, R);
+				using eigen_FxF = typename KF::KFMatrix_FxF::eigen_t;
+				const Eigen::LLT<eigen_FxF> Pn_llt(Pn.asEigen());
+				if (Pn_llt.info() != Eigen::Success)
+					THROW_EXCEPTION(
+						"kfbSparseInformation requires a positive definite "
+						"inverse sensor model noise");
+				const typename KF::KFMatrix_FxF Omega(
+					Pn_llt.solve(eigen_FxF::Identity()));
+
+				obj.m_infoVV.asEigen() += dyn_dxv.asEigen().transpose() *
+					Omega.asEigen() * dyn_dxv.asEigen();
+				obj.m_infoVY[newIndexInMap].asEigen() =
+					-dyn_dxv.asEigen().transpose() * Omega.asEigen();
+				obj.m_infoYY.emplace_back();
+				obj.m_infoYY.back()[newIndexInMap] = Omega;
+				obj.m_infoFactor.reset();
+
+				obj.getProfiler().leave("KF:9.create new LMs");
+				continue;
+			}
+
 			// --------------------
 			// Append to Pkk:
 			// --------------------
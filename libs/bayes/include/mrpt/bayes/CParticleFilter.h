@@ -12,6 +12,9 @@
 #include <mrpt/system/COutputLogger.h>
 #include <mrpt/typemeta/TEnumType.h>
 
+#include <cstddef>
+#include <functional>
+
 namespace mrpt
 {
 namespace obs
@@ -19,6 +22,10 @@ namespace obs
 class CSensoryFrame;
 class CActionCollection;
 }  // namespace obs
+namespace random
+{
+class CRandomGenerator;
+}
 
 /** The namespace for Bayesian filtering algorithm: different particle filters
  * and Kalman filter algorithms. \ingroup mrpt_bayes_grp
@@ -163,6 +170,20 @@ class CParticleFilter : public mrpt::system::COutputLogger
 		 * perform rejection sampling, but just the most-likely (ML) particle
 		 * found in the preliminary weight-determination stage. */
 		bool pfAuxFilterOptimal_MLE{false};
+
+		/** Number of threads used to draw new particle poses and to evaluate
+		 * the observation likelihood of each particle (0=all cores).
+		 * Particles are split in blocks of a fixed size, each one with its
+		 * own random generator seeded from
+		 * mrpt::random::getRandomGenerator(), so results only depend on the
+		 * seed of the global generator, not on the number of threads (with
+		 * the default value, 1, blocks run sequentially). Observation
+		 * likelihood models must be thread-safe, which is the case of all
+		 * MRPT metric maps except the COccupancyGridMap2D
+		 * `lmMeanInformation` and `lmConsensusOWA` models.
+		 * Used in pfStandardProposal and, for RBPF SLAM, pfOptimalProposal.
+		 * (Default=1) */
+		unsigned int numThreads{1};
 	};
 
 	/** Statistics for being returned from the "execute" method. */
@@ -208,6 +229,22 @@ class CParticleFilter : public mrpt::system::COutputLogger
 	 */
 	CParticleFilter::TParticleFilterOptions m_options;
 
+	/** Runs `func(first, last, rng)` for consecutive blocks `[first,last)`
+	 * of the N particles of a filter, in parallel according to
+	 * TParticleFilterOptions::numThreads, with mrpt::parallelFor().
+	 *
+	 * The blocks and the seeds of their random generators
+	 * (mrpt::parallelTaskSeed()) do not depend on the number of threads: the
+	 * base seed is drawn once per call from
+	 * mrpt::random::getRandomGenerator(). Exceptions thrown by `func` are
+	 * rethrown here, once all blocks are done.
+	 */
+	static void forEachParticleBlock(
+		const TParticleFilterOptions& PF_options, size_t N,
+		const std::function<void(
+			size_t first, size_t last, mrpt::random::CRandomGenerator& rng)>&
+			func);
+
 };	// End of class def.
 
 }  // namespace bayes
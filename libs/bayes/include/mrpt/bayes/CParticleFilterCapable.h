@@ -284,6 +284,14 @@ class CParticleFilterCapable
 	 */
 	mutable TFastDrawAuxVars m_fastDrawAuxiliary;
 
+	/** Buffers reused among calls to performResampling() */
+	struct TResamplingAuxVars
+	{
+		std::vector<double> logWeights;
+		std::vector<size_t> indexes;
+	};
+	TResamplingAuxVars m_resamplingAuxiliary;
+
 };	// End of class def.
 
 }  // namespace mrpt::bayes
@@ -109,56 +109,43 @@ struct CParticleFilterDataImpl : public CParticleFilterCapable
 	void performSubstitution(const std::vector<size_t>& indx) override
 	{
 		MRPT_START
-		// Ensure input indices are sorted
-		std::vector<size_t> sorted_indx(indx);
-		std::sort(sorted_indx.begin(), sorted_indx.end());
+		// Ensure input indices are sorted (they already are for most
+		// resampling methods):
+		std::vector<size_t> sorted_copy;
+		if (!std::is_sorted(indx.begin(), indx.end()))
+		{
+			sorted_copy = indx;
+			std::sort(sorted_copy.begin(), sorted_copy.end());
+		}
+		const std::vector<size_t>& sorted_indx =
+			sorted_copy.empty() ? indx : sorted_copy;
+		auto& oldParts = derived().m_particles;
+		ASSERT_(sorted_indx.empty() || sorted_indx.back() < oldParts.size());
 
 		/* Temporary buffer: */
 		particle_list_t parts;
 		parts.resize(sorted_indx.size());
 
-		// Implementation for particles as pointers:
-		if constexpr (
-			Derived::PARTICLE_STORAGE == particle_storage_mode::POINTER)
+		// Since indices are sorted, all the copies of an old particle are
+		// contiguous: the first one takes over (moves) the old particle data,
+		// and the rest are copies of it. Particles that survive only once are
+		// therefore never copied.
+		// (With particles as pointers, the "= operator" makes a deep copy)
+		for (size_t i = 0; i < parts.size(); i++)
 		{
-			const size_t M_old = derived().m_particles.size();
-			// Index, in the *new* set, of reused particle data, indexed
-			// by *old* indices, or "-1" if not reused.
-			std::vector<int> reusedIdx(M_old, -1);
-			typename particle_list_t::iterator itDest;
-			for (size_t i = 0; i < parts.size(); i++)
-			{
-				const size_t sorted_idx = sorted_indx[i];
-				parts[i].log_w = derived().m_particles[sorted_idx].log_w;
+			const size_t sorted_idx = sorted_indx[i];
+			auto& oldPart = oldParts[sorted_idx];
+			parts[i].log_w = oldPart.log_w;
 
-				// The first time that the old particle "indx[i]" appears, we
-				// can reuse the old "data" instead of creating a new copy:
-				const int idx_of_this_in_new_set = reusedIdx[sorted_idx];
-				if (idx_of_this_in_new_set == -1)
-				{
-					// First time: Reuse the data from the particle.
-					parts[i].d = std::move(derived().m_particles[sorted_idx].d);
-					reusedIdx[sorted_idx] = i;
-				}
-				else
-				{
-					// Make a copy of the particle's data
-					// (The "= operator" already makes a deep copy)
-					parts[i].d = parts[idx_of_this_in_new_set].d;
-				}
-			}
-			// Free memory of unused particles: Done automatically.
-		}
-		else
-		{
-			// Implementation for particles as values:
-			auto it_idx = sorted_indx.begin();
-			auto itDest = parts.begin();
-			for (; itDest != parts.end(); ++it_idx, ++itDest)
-				*itDest = derived().m_particles[*it_idx];
+			if (i == 0 || sorted_indx[i - 1] != sorted_idx)
+				parts[i].d = std::move(oldPart.d);
+			else
+				parts[i].d = parts[i - 1].d;
 		}
+		// Free memory of unused particles: Done automatically.
+
 		/* Move particles to the final container: */
-		derived().m_particles = std::move(parts);
+		oldParts = std::move(parts);
 		MRPT_END
 	}
 
@@ -0,0 +1,200 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/bayes/CParticleFilterCapable.h>
+#include <mrpt/core/bits_math.h>
+#include <mrpt/core/exceptions.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+namespace mrpt::bayes
+{
+/** A set of particles whose state is a fixed number of real values, stored as
+ * a structure of arrays (SoA): one contiguous `std::vector<double>` per state
+ * component, plus one for the logarithmic weights.
+ *
+ * Compared to CParticleFilterData<>, where each particle is one
+ * CProbabilityParticle object (and, in `POINTER` mode, one heap allocation),
+ * loops over all particles (motion models, weight normalization, ESS,
+ * resampling) here run over contiguous memory and can be vectorized by the
+ * compiler.
+ *
+ * This class implements all the weight-related virtual methods of
+ * CParticleFilterCapable, so derived classes only need to implement the
+ * `prediction_and_update_*()` methods to be executed by a CParticleFilter.
+ *
+ * \tparam STATE_DIM Number of real values in the state of each particle.
+ *
+ * \sa CParticleFilterData, mrpt::poses::CPose2DParticlesSoA,
+ * mrpt::poses::CPose3DParticlesSoA
+ * \ingroup mrpt_bayes_grp
+ */
+template <std::size_t STATE_DIM>
+class CParticleFilterDataSoA : public CParticleFilterCapable
+{
+   public:
+	static constexpr std::size_t StateDim = STATE_DIM;
+
+	CParticleFilterDataSoA() = default;
+
+	/** Number of particles */
+	inline size_t size() const { return m_log_w.size(); }
+
+	/** Changes the number of particles. New particles get all state values and
+	 * the log-weight set to zero. */
+	void resizeParticles(size_t n)
+	{
+		for (auto& c : m_state)
+			c.resize(n, .0);
+		m_log_w.resize(n, .0);
+	}
+
+	/** Free the memory of all the particles */
+	void clearParticles()
+	{
+		for (auto& c : m_state)
+			c.clear();
+		m_log_w.clear();
+	}
+
+	/** Read-only access to the k-th state component of all particles. */
+	inline const std::vector<double>& stateComponent(std::size_t k) const
+	{
+		return m_state[k];
+	}
+	/** Read-write access to the k-th state component of all particles. */
+	inline std::vector<double>& stateComponent(std::size_t k)
+	{
+		return m_state[k];
+	}
+
+	/** Read-only access to the logarithmic weights of all particles. */
+	inline const std::vector<double>& logWeights() const { return m_log_w; }
+	/** Read-write access to the logarithmic weights of all particles. */
+	inline std::vector<double>& logWeights() { return m_log_w; }
+
+	/** Returns a vector with the logarithmic weights of all particles. */
+	void getWeights(std::vector<double>& out_logWeights) const
+	{
+		out_logWeights = m_log_w;
+	}
+
+	/** Returns the index of the particle with the highest weight. */
+	size_t getMostLikelyParticleIndex() const
+	{
+		ASSERT_(!m_log_w.empty());
+		return static_cast<size_t>(
+			std::max_element(m_log_w.begin(), m_log_w.end()) - m_log_w.begin());
+	}
+
+	double getW(size_t i) const override
+	{
+		if (i >= m_log_w.size())
+			THROW_EXCEPTION_FMT("Index %i is out of range!", (int)i);
+		return m_log_w[i];
+	}
+
+	void setW(size_t i, double w) override
+	{
+		if (i >= m_log_w.size())
+			THROW_EXCEPTION_FMT("Index %i is out of range!", (int)i);
+		m_log_w[i] = w;
+	}
+
+	size_t particlesCount() const override { return m_log_w.size(); }
+
+	double normalizeWeights(double* out_max_log_w = nullptr) override
+	{
+		MRPT_START
+		const size_t N = m_log_w.size();
+		if (!N) return 0;
+		double* w = m_log_w.data();
+
+		double minW = w[0], maxW = w[0];
+		for (size_t i = 1; i < N; i++)
+		{
+			maxW = std::max(maxW, w[i]);
+			minW = std::min(minW, w[i]);
+		}
+		for (size_t i = 0; i < N; i++)
+			w[i] -= maxW;
+		if (out_max_log_w) *out_max_log_w = maxW;
+
+		return std::exp(maxW - minW);
+		MRPT_END
+	}
+
+	double ESS() const override
+	{
+		MRPT_START
+		const size_t N = m_log_w.size();
+		if (!N) return 0;
+		const double* w = m_log_w.data();
+
+		// ESS is invariant to a common scale of the weights: subtract the
+		// maximum log-weight to avoid overflows/underflows in exp().
+		const double maxW = *std::max_element(w, w + N);
+		double sumW = 0, sumW2 = 0;
+		for (size_t i = 0; i < N; i++)
+		{
+			const double lw = std::exp(w[i] - maxW);
+			sumW += lw;
+			sumW2 += lw * lw;
+		}
+		if (sumW2 == 0) return 0;
+		return mrpt::square(sumW) / (N * sumW2);
+		MRPT_END
+	}
+
+	/** Replaces the old particles by copies determined by the indexes in
+	 * "indx", allowing the number of particles to change. Each state component
+	 * is gathered with one pass over sorted indices. */
+	void performSubstitution(const std::vector<size_t>& indx) override
+	{
+		MRPT_START
+		std::vector<size_t> sorted_copy;
+		if (!std::is_sorted(indx.begin(), indx.end()))
+		{
+			sorted_copy = indx;
+			std::sort(sorted_copy.begin(), sorted_copy.end());
+		}
+		const std::vector<size_t>& sorted_indx =
+			sorted_copy.empty() ? indx : sorted_copy;
+		const size_t N_old = m_log_w.size(), N_new = sorted_indx.size();
+		ASSERT_(N_new == 0 || sorted_indx.back() < N_old);
+
+		m_substBuffer.resize(N_new);
+		auto gather = [&](std::vector<double>& v) {
+			for (size_t i = 0; i < N_new; i++)
+				m_substBuffer[i] = v[sorted_indx[i]];
+			v.swap(m_substBuffer);
+			m_substBuffer.resize(N_new);
+		};
+		for (auto& c : m_state)
+			gather(c);
+		gather(m_log_w);
+		MRPT_END
+	}
+
+   protected:
+	/** The state of all particles: one array per state component. */
+	std::array<std::vector<double>, STATE_DIM> m_state;
+	/** The logarithmic weights of all particles. */
+	std::vector<double> m_log_w;
+
+   private:
+	/** Reused between calls to performSubstitution() */
+	std::vector<double> m_substBuffer;
+};
+
+}  // namespace mrpt::bayes
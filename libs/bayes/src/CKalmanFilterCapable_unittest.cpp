@@ -0,0 +1,448 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+#include <mrpt/bayes/CKalmanFilterCapable.h>
+#include <mrpt/random/RandomGenerators.h>
+
+#include <Eigen/Dense>
+#include <cmath>
+
+using namespace mrpt::bayes;
+
+namespace
+{
+// A linear 2D SLAM problem: the vehicle state is its position, landmarks are
+// 2D points and each observation is the landmark position relative to the
+// vehicle. Being linear, all the KF methods must give the exact KF solution.
+class LinearKFSLAM : public CKalmanFilterCapable<2, 2, 2, 2>
+{
+   public:
+	using Eigen_t = Eigen::MatrixXd;
+
+	LinearKFSLAM(const KFVector& x0, const KFMatrix& P0)
+	{
+		m_xkk = x0;
+		m_pkk = P0;
+	}
+
+	void step() { runOneKalmanIteration(); }
+
+	const KFVector& mean() const { return m_xkk; }
+	KFMatrix cov() const
+	{
+		KFMatrix P;
+		getStateCovariance(P);
+		return P;
+	}
+
+	KFArray_ACT u;
+	double q = 0.1, r = 0.05;
+	vector_KFArray_OBS z;
+	std::vector<int> da;
+
+   protected:
+	void OnGetAction(KFArray_ACT& out_u) const override { out_u = u; }
+	void OnTransitionModel(
+		const KFArray_ACT& in_u, KFArray_VEH& inout_x,
+		bool& out_skipPrediction) const override
+	{
+		inout_x += in_u;
+		out_skipPrediction = false;
+	}
+	void OnTransitionJacobian(KFMatrix_VxV& out_F) const override
+	{
+		out_F.setIdentity();
+	}
+	void OnTransitionNoise(KFMatrix_VxV& out_Q) const override
+	{
+		out_Q.setDiagonal(q * q);
+	}
+	void OnGetObservationNoise(KFMatrix_OxO& out_R) const override
+	{
+		out_R.setDiagonal(r * r);
+	}
+	void OnGetObservationsAndDataAssociation(
+		vector_KFArray_OBS& out_z, std::vector<int>& out_data_association,
+		const vector_KFArray_OBS&, const KFMatrix&, const std::vector<size_t>&,
+		const KFMatrix_OxO&) override
+	{
+		out_z = z;
+		out_data_association = da;
+	}
+	void OnObservationModel(
+		const std::vector<size_t>& idx_landmarks_to_predict,
+		vector_KFArray_OBS& out_predictions) const override
+	{
+		out_predictions.clear();
+		for (const size_t i : idx_landmarks_to_predict)
+		{
+			KFArray_OBS h;
+			h[0] = m_xkk[2 + 2 * i] - m_xkk[0];
+			h[1] = m_xkk[3 + 2 * i] - m_xkk[1];
+			out_predictions.push_back(h);
+		}
+	}
+	void OnObservationJacobians(
+		size_t, KFMatrix_OxV& Hx, KFMatrix_OxF& Hy) const override
+	{
+		Hx.setIdentity();
+		Hx *= -1.0;
+		Hy.setIdentity();
+	}
+	void OnInverseObservationModel(
+		const KFArray_OBS& in_z, KFArray_FEAT& out_yn,
+		KFMatrix_FxV& out_dyn_dxv, KFMatrix_FxO& out_dyn_dhn) const override
+	{
+		out_yn[0] = m_xkk[0] + in_z[0];
+		out_yn[1] = m_xkk[1] + in_z[1];
+		out_dyn_dxv.setIdentity();
+		out_dyn_dhn.setIdentity();
+	}
+};
+
+// Bearing and range to a fixed beacon at the origin of a static vehicle: a
+// non-linear, non-SLAM problem.
+class BeaconKF : public CKalmanFilterCapable<2, 2, 0, 1>
+{
+   public:
+	BeaconKF(const KFVector& x0, const KFMatrix& P0)
+	{
+		m_xkk = x0;
+		m_pkk = P0;
+	}
+
+	void step() { runOneKalmanIteration(); }
+
+	const KFVector& mean() const { return m_xkk; }
+
+	// h(x) and its Jacobian:
+	static KFArray_OBS h(const KFVector& x)
+	{
+		KFArray_OBS z;
+		z[0] = std::atan2(x[1], x[0]);
+		z[1] = std::sqrt(x[0] * x[0] + x[1] * x[1]);
+		return z;
+	}
+	static KFMatrix_OxV H(const KFVector& x)
+	{
+		const double r2 = x[0] * x[0] + x[1] * x[1], r = std::sqrt(r2);
+		KFMatrix_OxV J;
+		J(0, 0) = -x[1] / r2;
+		J(0, 1) = x[0] / r2;
+		J(1, 0) = x[0] / r;
+		J(1, 1) = x[1] / r;
+		return J;
+	}
+
+	KFArray_OBS z;
+	KFMatrix_OxO R;
+
+   protected:
+	void OnGetAction(KFArray_ACT& out_u) const override { out_u.setZero(); }
+	void OnTransitionModel(
+		const KFArray_ACT&, KFArray_VEH&,
+		bool& out_skipPrediction) const override
+	{
+		out_skipPrediction = true;
+	}
+	void OnTransitionNoise(KFMatrix_VxV& out_Q) const override
+	{
+		out_Q.setZero();
+	}
+	void OnGetObservationNoise(KFMatrix_OxO& out_R) const override
+	{
+		out_R = R;
+	}
+	void OnGetObservationsAndDataAssociation(
+		vector_KFArray_OBS& out_z, std::vector<int>& out_data_association,
+		const vector_KFArray_OBS&, const KFMatrix&, const std::vector<size_t>&,
+		const KFMatrix_OxO&) override
+	{
+		out_z.assign(1, z);
+		out_data_association.clear();
+	}
+	void OnObservationModel(
+		const std::vector<size_t>&,
+		vector_KFArray_OBS& out_predictions) const override
+	{
+		out_predictions.assign(1, h(m_xkk));
+	}
+	void OnObservationJacobians(
+		size_t, KFMatrix_OxV& Hx, KFMatrix_OxF&) const override
+	{
+		Hx = H(m_xkk);
+	}
+};
+
+// The textbook KF with dense matrices. Observations with da=-1 become new
+// landmarks after the update.
+void denseKF(
+	const LinearKFSLAM& kf, Eigen::VectorXd& x, Eigen::MatrixXd& P)
+{
+	const size_t D = x.size();
+	x.head<2>() += kf.u.asEigen();
+	P.topLeftCorner<2, 2>() += Eigen::Matrix2d::Identity() * kf.q * kf.q;
+
+	std::vector<size_t> obs;
+	for (size_t k = 0; k < kf.z.size(); k++)
+		if (kf.da[k] >= 0) obs.push_back(k);
+	const size_t M = obs.size();
+	if (M > 0)
+	{
+		Eigen::MatrixXd H = Eigen::MatrixXd::Zero(2 * M, D);
+		Eigen::VectorXd y(2 * M);
+		for (size_t k = 0; k < M; k++)
+		{
+			const size_t off = 2 + 2 * kf.da[obs[k]];
+			H.block<2, 2>(2 * k, 0) = -Eigen::Matrix2d::Identity();
+			H.block<2, 2>(2 * k, off) = Eigen::Matrix2d::Identity();
+			y.segment<2>(2 * k) =
+				kf.z[obs[k]].asEigen() - (x.segment<2>(off) - x.head<2>());
+		}
+		const Eigen::MatrixXd S = H * P * H.transpose() +
+			Eigen::MatrixXd::Identity(2 * M, 2 * M) * kf.r * kf.r;
+		const Eigen::MatrixXd K = P * H.transpose() * S.inverse();
+		x += K * y;
+		P = (Eigen::MatrixXd::Identity(D, D) - K * H) * P;
+	}
+
+	for (size_t k = 0; k < kf.z.size(); k++)
+	{
+		if (kf.da[k] >= 0) continue;
+		const size_t n = x.size();
+		x.conservativeResize(n + 2);
+		x.tail<2>() = x.head<2>() + kf.z[k].asEigen();
+		P.conservativeResize(n + 2, n + 2);
+		P.bottomRows<2>() = P.topRows<2>();
+		P.rightCols<2>() = P.leftCols<2>();
+		P.bottomRightCorner<2, 2>() = P.topLeftCorner<2, 2>() +
+			Eigen::Matrix2d::Identity() * kf.r * kf.r;
+	}
+}
+
+// Random problem with N_LMs landmarks and a dense initial covariance:
+void randomProblem(
+	size_t N_LMs, LinearKFSLAM::KFVector& x0, LinearKFSLAM::KFMatrix& P0)
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	const size_t D = 2 + 2 * N_LMs;
+	x0.resize(D);
+	for (size_t i = 0; i < D; i++)
+		x0[i] = rng.drawUniform(-10.0, 10.0);
+	Eigen::MatrixXd A(D, D);
+	for (size_t i = 0; i < D; i++)
+		for (size_t j = 0; j < D; j++)
+			A(i, j) = rng.drawUniform(-0.1, 0.1);
+	P0.setSize(D, D);
+	P0.asEigen() = A * A.transpose() + Eigen::MatrixXd::Identity(D, D) * 0.01;
+}
+
+// Observe a few landmarks, not in the state vector order, and maybe a new
+// one:
+void randomObservations(
+	LinearKFSLAM& kf, size_t N_LMs, int step, bool addNewLandmark)
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	kf.u[0] = 1.0;
+	kf.u[1] = -0.5 * step;
+	kf.z.clear();
+	kf.da.clear();
+	for (const int lm : {7, 2, 13, 19, -1})
+	{
+		if (lm < 0 && !addNewLandmark) continue;
+		LinearKFSLAM::KFArray_OBS zi;
+		zi[0] = rng.drawUniform(-10.0, 10.0);
+		zi[1] = rng.drawUniform(-10.0, 10.0);
+		kf.z.push_back(zi);
+		kf.da.push_back(lm < 0 ? -1 : (lm + 3 * step) % int(N_LMs));
+	}
+}
+}  // namespace
+
+TEST(CKalmanFilterCapable, linearSLAMUpdate)
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(123);
+
+	const size_t N_LMs = 20;
+	LinearKFSLAM::KFVector x0;
+	LinearKFSLAM::KFMatrix P0;
+	randomProblem(N_LMs, x0, P0);
+
+	for (const auto method : {kfEKFNaive, kfIKFFull, kfEKFAlaDavison})
+		for (const bool analyticJacobs : {true, false})
+		{
+			LinearKFSLAM kf(x0, P0);
+			kf.KF_options.method = method;
+			// Also with numeric observation Jacobians, verified against the
+			// analytic ones:
+			kf.KF_options.use_analytic_observation_jacobian = analyticJacobs;
+			kf.KF_options.debug_verify_analytic_jacobians = !analyticJacobs;
+			const double tol = analyticJacobs ? 1e-8 : 1e-6;
+			Eigen::VectorXd x = x0.asEigen();
+			Eigen::MatrixXd P = P0.asEigen();
+
+			for (int step = 0; step < 3; step++)
+			{
+				randomObservations(kf, N_LMs, step, false);
+
+				kf.step();
+				denseKF(kf, x, P);
+
+				EXPECT_LT((kf.mean().asEigen() - x).norm(), tol)
+					<< "method=" << method << " step=" << step;
+				EXPECT_LT((kf.cov().asEigen() - P).norm(), tol)
+					<< "method=" << method << " step=" << step;
+				// Must be exactly symmetric:
+				EXPECT_EQ(
+					kf.cov().asEigen(), kf.cov().asEigen().transpose().eval())
+					<< "method=" << method;
+			}
+		}
+}
+
+TEST(CKalmanFilterCapable, iteratedEKFConvergence)
+{
+	BeaconKF::KFVector x0;
+	x0.resize(2);
+	x0[0] = 3.0;
+	x0[1] = 1.0;
+	BeaconKF::KFMatrix P0;
+	P0.setSize(2, 2);
+	P0.asEigen() << 1.0, 0.2, 0.2, 0.5;
+
+	BeaconKF::KFVector gt;
+	gt.resize(2);
+	gt[0] = 2.0;
+	gt[1] = 2.5;
+
+	// The maximum a posteriori estimate x is a stationary point of
+	// (x-x0)^t P0^-1 (x-x0) + (z-h(x))^t R^-1 (z-h(x)):
+	const auto gradientAt = [&](const BeaconKF& kf) {
+		const auto& x = kf.mean().asEigen();
+		const Eigen::Vector2d e = (kf.z - BeaconKF::h(kf.mean())).asEigen();
+		return (P0.asEigen().inverse() * (x - x0.asEigen()) -
+				BeaconKF::H(kf.mean()).asEigen().transpose() *
+					kf.R.asEigen().inverse() * e)
+			.norm();
+	};
+
+	double gradEKF = 0, gradIKF = 0;
+	for (const auto method : {kfEKFNaive, kfIKFFull})
+	{
+		BeaconKF kf(x0, P0);
+		kf.KF_options.method = method;
+		kf.KF_options.IKF_iterations = 20;
+		kf.z = BeaconKF::h(gt);
+		kf.R.setDiagonal({0.01 * 0.01, 0.05 * 0.05});
+		kf.step();
+		(method == kfEKFNaive ? gradEKF : gradIKF) = gradientAt(kf);
+	}
+	// The relinearized iterations converge to it, unlike a single update:
+	EXPECT_LT(gradIKF, 1e-6);
+	EXPECT_GT(gradEKF, 1e-2);
+}
+
+TEST(CKalmanFilterCapable, sparseInformationBackend)
+{
+	mrpt::random::getRandomGenerator().randomize(456);
+
+	const size_t N_LMs = 20;
+	LinearKFSLAM::KFVector x0;
+	LinearKFSLAM::KFMatrix P0;
+	randomProblem(N_LMs, x0, P0);
+
+	for (const auto method : {kfEKFNaive, kfIKFFull})
+	{
+		LinearKFSLAM kf(x0, P0);
+		kf.KF_options.method = method;
+		kf.KF_options.backend = kfbSparseInformation;
+		kf.KF_options.information_min_variance = 0;
+		Eigen::VectorXd x = x0.asEigen();
+		Eigen::MatrixXd P = P0.asEigen();
+
+		for (int step = 0; step < 4; step++)
+		{
+			randomObservations(kf, N_LMs, step, true);
+
+			kf.step();
+			denseKF(kf, x, P);
+
+			ASSERT_EQUAL_(size_t(x.size()), kf.getStateVectorLength());
+			EXPECT_LT((kf.mean().asEigen() - x).norm(), 1e-8)
+				<< "method=" << method << " step=" << step;
+			EXPECT_LT((kf.cov().asEigen() - P).norm(), 1e-8)
+				<< "method=" << method << " step=" << step;
+
+			LinearKFSLAM::KFMatrix_VxV Pv;
+			kf.getVehicleCov(Pv);
+			EXPECT_LT((Pv.asEigen() - P.topLeftCorner<2, 2>()).norm(), 1e-8);
+			LinearKFSLAM::KFMatrix_FxF Py;
+			kf.getLandmarkCov(N_LMs + step, Py);
+			const size_t off = 2 + 2 * (N_LMs + step);
+			EXPECT_LT((Py.asEigen() - P.block<2, 2>(off, off)).norm(), 1e-8);
+		}
+	}
+}
+
+TEST(CKalmanFilterCapable, sparseInformationBoundedActiveLandmarks)
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(789);
+
+	// A simulated world, with the initial map uncertainty of a reset:
+	const size_t N_LMs = 20, D = 2 + 2 * N_LMs, maxActive = 3;
+	LinearKFSLAM::KFVector x0;
+	LinearKFSLAM::KFMatrix P0;
+	randomProblem(N_LMs, x0, P0);
+	P0.asEigen().setIdentity(D, D);
+	Eigen::VectorXd gt = x0.asEigen();
+	for (size_t i = 0; i < D; i++)
+		gt[i] += rng.drawGaussian1D_normalized();
+
+	LinearKFSLAM kf(x0, P0);
+	kf.KF_options.backend = kfbSparseInformation;
+	kf.KF_options.information_max_active_landmarks = maxActive;
+	Eigen::VectorXd x = x0.asEigen();
+	Eigen::MatrixXd P = P0.asEigen();
+
+	for (int step = 0; step < 20; step++)
+	{
+		kf.u[0] = 1.0;
+		kf.u[1] = -0.5;
+		gt[0] += kf.u[0] + kf.q * rng.drawGaussian1D_normalized();
+		gt[1] += kf.u[1] + kf.q * rng.drawGaussian1D_normalized();
+		kf.z.clear();
+		kf.da.clear();
+		for (int k = 0; k < 4; k++)
+		{
+			const int lm = (3 * step + 7 * k) % N_LMs;
+			LinearKFSLAM::KFArray_OBS zi;
+			for (int c = 0; c < 2; c++)
+				zi[c] = gt[2 + 2 * lm + c] - gt[c] +
+					kf.r * rng.drawGaussian1D_normalized();
+			kf.z.push_back(zi);
+			kf.da.push_back(lm);
+		}
+
+		kf.step();
+		denseKF(kf, x, P);
+
+		EXPECT_LE(kf.getNumberOfActiveLandmarks(), maxActive);
+
+		// The sparsified filter is an approximation, but its estimate must
+		// remain as good as the exact one, with a valid covariance:
+		const Eigen::MatrixXd Pkk = kf.cov().asEigen();
+		EXPECT_EQ(Pkk.llt().info(), Eigen::Success);
+		const double err = (kf.mean().asEigen() - gt).norm();
+		const double err_exact = (x - gt).norm();
+		EXPECT_LT(err, 2 * err_exact) << "step=" << step;
+	}
+}
@@ -13,12 +13,15 @@
 #include <mrpt/bayes/CParticleFilterCapable.h>	// for CParticleFilterCapable
 #include <mrpt/config/CConfigFileBase.h>  // for CConfigFileBase, MRPT...
 #include <mrpt/core/bits_math.h>  // square()
+#include <mrpt/core/parallel_for.h>
+#include <mrpt/random/RandomGenerators.h>
 #include <mrpt/system/COutputLogger.h>	// for COutputLogger, MRPT_L...
 
 #include <cmath>  // for exp
 #include <cstddef>	// for size_t
 #include <exception>  // for exception
 #include <string>  // for string, allocator
+#include <vector>
 
 namespace mrpt
 {
@@ -99,6 +102,35 @@ void CParticleFilter::executeOn(
 	MRPT_END
 }
 
+namespace
+{
+// Fixed, so the blocks do not depend on the number of threads:
+constexpr size_t PARTICLES_PER_BLOCK = 64;
+}  // namespace
+
+void CParticleFilter::forEachParticleBlock(
+	const TParticleFilterOptions& PF_options, size_t N,
+	const std::function<void(
+		size_t first, size_t last, mrpt::random::CRandomGenerator& rng)>& func)
+{
+	MRPT_START
+
+	if (!N) return;
+
+	const uint32_t baseSeed =
+		mrpt::random::getRandomGenerator().drawUniform32bit();
+
+	mrpt::parallelFor(
+		N, PARTICLES_PER_BLOCK, PF_options.numThreads,
+		[&](size_t first, size_t last) {
+			mrpt::random::CRandomGenerator rng(mrpt::parallelTaskSeed(
+				baseSeed, first / PARTICLES_PER_BLOCK));
+			func(first, last, rng);
+		});
+
+	MRPT_END
+}
+
 /*---------------------------------------------------------------
 					TParticleFilterOptions
   ---------------------------------------------------------------*/
@@ -136,6 +168,10 @@ void CParticleFilter::TParticleFilterOptions::saveToConfigFile(
 		pfAuxFilterStandard_FirstStageWeightsMonteCarlo,
 		"Only for PF_algorithm==pfAuxiliaryPFStandard");
 	MRPT_SAVE_CONFIG_VAR_COMMENT(pfAuxFilterOptimal_MLE, "See doxygen docs.");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		numThreads,
+		"Number of threads to draw particles and evaluate their likelihood "
+		"(0=all cores, default=1)");
 }
 
 /*---------------------------------------------------------------
@@ -178,6 +214,7 @@ void CParticleFilter::TParticleFilterOptions::loadFromConfigFile(
 		section.c_str());
 	MRPT_LOAD_CONFIG_VAR(
 		pfAuxFilterOptimal_MLE, bool, iniFile, section.c_str());
+	MRPT_LOAD_CONFIG_VAR(numThreads, int, iniFile, section.c_str());
 
 	MRPT_END
 }
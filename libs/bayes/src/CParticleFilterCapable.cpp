@@ -24,6 +24,89 @@ using namespace std;
 const unsigned CParticleFilterCapable::PARTICLE_FILTER_CAPABLE_FAST_DRAW_BINS =
 	20;
 
+namespace
+{
+// Buffers reused among calls to computeResampling() to avoid memory
+// allocations: linear weights, modified weights of the residual method, and
+// CDF and sorted thresholds of the multinomial method.
+thread_local std::vector<double> resamplingLinW, resamplingResidualW;
+thread_local std::vector<double> resamplingCDF, resamplingThresholds;
+thread_local std::vector<uint32_t> resamplingCopies;
+
+// Computes linW[i] = exp(logW[i] - max(logW)) / sum.
+void logToNormalizedLinearWeights(const double* logW, size_t M, double* linW)
+{
+	// This is to avoid float point range problems:
+	double maxW = logW[0];
+	for (size_t i = 1; i < M; i++)
+		maxW = logW[i] > maxW ? logW[i] : maxW;
+
+	double sumW = 0;
+	for (size_t i = 0; i < M; i++)
+		sumW += (linW[i] = std::exp(logW[i] - maxW));
+	ASSERT_(sumW > 0);
+
+	const double k = 1.0 / sumW;
+	for (size_t i = 0; i < M; i++)
+		linW[i] *= k;
+}
+
+// Multinomial resampling (select with replacement): draws N indices with
+// the probabilities in linW, merging its CDF with N sorted uniform samples.
+void resampleMultinomial(const std::vector<double>& linW, size_t N, size_t* out)
+{
+	const size_t M = linW.size();
+
+	auto& Q = resamplingCDF;
+	mrpt::math::cumsum_tmpl<vector<double>, vector<double>>(linW, Q);
+	Q[M - 1] = 1.1;
+
+	auto& T = resamplingThresholds;
+	T.resize(N);
+	getRandomGenerator().drawUniformVector(T, 0.0, 0.999999);
+	T.push_back(1.0);
+
+	// Sort:
+	// --------------------
+	sort(T.begin(), T.end());
+
+	size_t i = 0, j = 0;
+	while (i < N)
+	{
+		if (T[i] < Q[j]) { out[i++] = j; }
+		else
+		{
+			j++;
+			if (j >= M) j = M - 1;
+		}
+	}
+}
+
+// Stratified and systematic resampling: one merge pass of the CDF of the M
+// weights with N increasing thresholds, in O(M+N) and without buffers.
+void resampleStratifiedOrSystematic(
+	const bool stratified, const double* linW, const size_t M, const size_t N,
+	size_t* out)
+{
+	auto& rng = getRandomGenerator();
+	const double step = 1.0 / N;
+	const double u0 = stratified ? .0 : rng.drawUniform(0.0, step);
+
+	size_t j = 0;
+	double cdf = linW[0];
+	for (size_t k = 0; k < N; k++)
+	{
+		const double t = stratified
+			? (k + rng.drawUniform(0.0, 0.999999)) * step
+			: u0 + k * step;
+		// (j < M-1 guards against round-off errors at the end of the CDF)
+		while (t >= cdf && j + 1 < M)
+			cdf += linW[++j];
+		out[k] = j;
+	}
+}
+}  // namespace
+
 /*---------------------------------------------------------------
 					performResampling
  ---------------------------------------------------------------*/
@@ -37,9 +120,9 @@ void CParticleFilterCapable::performResampling(
 	const size_t in_particle_count = particlesCount();
 	ASSERT_(in_particle_count > 0);
 
-	vector<size_t> indxs;
-	vector<double> log_ws;
-	log_ws.assign(in_particle_count, .0);
+	auto& log_ws = m_resamplingAuxiliary.logWeights;
+	auto& indxs = m_resamplingAuxiliary.indexes;
+	log_ws.resize(in_particle_count);
 	for (size_t i = 0; i < in_particle_count; i++)
 		log_ws[i] = getW(i);
 
@@ -51,7 +134,8 @@ void CParticleFilterCapable::performResampling(
 	performSubstitution(indxs);
 
 	// Finally, equal weights:
-	for (size_t i = 0; i < out_particle_count; i++)
+	const size_t new_particle_count = indxs.size();
+	for (size_t i = 0; i < new_particle_count; i++)
 		setW(i, 0 /* Logarithmic weight */);
 
 	MRPT_END
@@ -75,20 +159,9 @@ void CParticleFilterCapable::computeResampling(
 
 	if (!out_particle_count) out_particle_count = M;
 
-	vector<double> linW(M, 0);
-	vector<double>::const_iterator inIt;
-	vector<double>::iterator outIt;
-	double linW_SUM = 0;
-
-	// This is to avoid float point range problems:
-	double max_log_w = math::maximum(in_logWeights);
-	for (i = 0, inIt = in_logWeights.begin(), outIt = linW.begin(); i < M;
-		 i++, inIt++, outIt++)
-		linW_SUM += ((*outIt) = exp((*inIt) - max_log_w));
-
-	// Normalize weights:
-	ASSERT_(linW_SUM > 0);
-	linW *= 1.0 / linW_SUM;
+	vector<double>& linW = resamplingLinW;
+	linW.resize(M);
+	logToNormalizedLinearWeights(in_logWeights.data(), M, linW.data());
 
 	switch (method)
 	{
@@ -97,30 +170,8 @@ void CParticleFilterCapable::computeResampling(
 			// ==============================================
 			//   Select with replacement
 			// ==============================================
-			vector<double> Q;
-			mrpt::math::cumsum_tmpl<vector<double>, vector<double>>(linW, Q);
-			Q[M - 1] = 1.1;
-
-			vector<double> T(M);
-			getRandomGenerator().drawUniformVector(T, 0.0, 0.999999);
-			T.push_back(1.0);
-
-			// Sort:
-			// --------------------
-			sort(T.begin(), T.end());
-
 			out_indexes.resize(out_particle_count);
-			i = j = 0;
-
-			while (i < out_particle_count)
-			{
-				if (T[i] < Q[j]) { out_indexes[i++] = (unsigned int)j; }
-				else
-				{
-					j++;
-					if (j >= M) j = M - 1;
-				}
-			}
+			resampleMultinomial(linW, out_particle_count, out_indexes.data());
 		}
 		break;	// end of "Select with replacement"
 
@@ -130,11 +181,12 @@ void CParticleFilterCapable::computeResampling(
 			//   prResidual
 			// ==============================================
 			// Repetition counts:
-			std::vector<uint32_t> N(M);
+			auto& N = resamplingCopies;
+			N.resize(M);
 			size_t R = 0;  // Remainder or residual count
 			for (i = 0; i < M; i++)
 			{
-				N[i] = int(M * linW[i]);
+				N[i] = int(out_particle_count * linW[i]);
 				R += N[i];
 			}
 			size_t N_rnd = out_particle_count >= R ? (out_particle_count - R)
@@ -144,8 +196,8 @@ void CParticleFilterCapable::computeResampling(
 
 			// Fillout the deterministic part of the resampling:
 			out_indexes.resize(out_particle_count);
-			for (i = 0, j = 0; i < out_particle_count; i++)
-				for (size_t k = 0; k < N[i]; k++)
+			for (i = 0, j = 0; i < M; i++)
+				for (size_t k = 0; k < N[i] && j < out_particle_count; k++)
 					out_indexes[j++] = i;
 
 			size_t M_fixed = j;
@@ -157,103 +209,29 @@ void CParticleFilterCapable::computeResampling(
 			// always!)
 			{
 				// Compute modified weights:
-				vector<double> linW_mod(M);
+				auto& linW_mod = resamplingResidualW;
+				linW_mod.resize(M);
 				const double M_R_1 = 1.0 / N_rnd;
 				for (i = 0; i < M; i++)
-					linW_mod[i] = M_R_1 * (M * linW[i] - N[i]);
+					linW_mod[i] =
+						M_R_1 * (out_particle_count * linW[i] - N[i]);
 
 				// perform resampling:
-				vector<double> Q;
-				mrpt::math::cumsum_tmpl<vector<double>, vector<double>>(
-					linW_mod, Q);
-				Q[M - 1] = 1.1;
-
-				vector<double> T(M);
-				getRandomGenerator().drawUniformVector(T, 0.0, 0.999999);
-				T.push_back(1.0);
-
-				// Sort:
-				sort(T.begin(), T.end());
-
-				i = 0;
-				j = 0;
-
-				while (i < N_rnd)
-				{
-					if (T[i] < Q[j])
-					{ out_indexes[M_fixed + i++] = (unsigned int)j; }
-					else
-					{
-						j++;
-						if (j >= M) j = M - 1;
-					}
-				}
+				resampleMultinomial(
+					linW_mod, N_rnd, out_indexes.data() + M_fixed);
 			}  // end if N_rnd!=0
 		}
 		break;
 		case CParticleFilter::prStratified:
-		{
-			// ==============================================
-			//   prStratified
-			// ==============================================
-			vector<double> Q;
-			mrpt::math::cumsum_tmpl<vector<double>, vector<double>>(linW, Q);
-			Q[M - 1] = 1.1;
-
-			// Stratified-uniform random vector:
-			vector<double> T(M + 1);
-			const double _1_M = 1.0 / M;
-			const double _1_M_eps = _1_M - 0.000001;
-			double T_offset = 0;
-			for (i = 0; i < M; i++)
-			{
-				T[i] =
-					T_offset + getRandomGenerator().drawUniform(0.0, _1_M_eps);
-				T_offset += _1_M;
-			}
-			T[M] = 1;
-
-			out_indexes.resize(out_particle_count);
-			i = j = 0;
-			while (i < out_particle_count)
-			{
-				if (T[i] < Q[j]) out_indexes[i++] = (unsigned int)j;
-				else
-				{
-					j++;
-					if (j >= M) j = M - 1;
-				}
-			}
-		}
-		break;
 		case CParticleFilter::prSystematic:
 		{
 			// ==============================================
-			//   prSystematic
+			//   prStratified / prSystematic
 			// ==============================================
-			vector<double> Q;
-			mrpt::math::cumsum_tmpl<vector<double>, vector<double>>(linW, Q);
-			Q[M - 1] = 1.1;
-
-			// Uniform random vector:
-			vector<double> T(M + 1);
-			double _1_M = 1.0 / M;
-			T[0] = getRandomGenerator().drawUniform(0.0, _1_M);
-			for (i = 1; i < M; i++)
-				T[i] = T[i - 1] + _1_M;
-			T[M] = 1;
-
 			out_indexes.resize(out_particle_count);
-			i = j = 0;
-			while (i < out_particle_count)
-			{
-				if (T[i] < Q[j]) out_indexes[i++] = (unsigned int)j;
-				else
-				{
-					j++;
-					if (j >= M) j = M - 1;
-				}
-			}
+			resampleStratifiedOrSystematic(
+				method == CParticleFilter::prStratified, linW.data(), M,
+				out_particle_count, out_indexes.data());
 		}
 		break;
 		default:
@@ -0,0 +1,149 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+#include <mrpt/bayes/CParticleFilterCapable.h>
+#include <mrpt/random/RandomGenerators.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using mrpt::bayes::CParticleFilter;
+using mrpt::bayes::CParticleFilterCapable;
+
+namespace
+{
+std::vector<double> randomLogWeights(size_t M)
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	std::vector<double> log_w(M);
+	for (auto& w : log_w)
+		w = rng.drawUniform(-20.0, 0.0) + 1000.0;  // (not normalized)
+	return log_w;
+}
+
+std::vector<size_t> countCopies(const std::vector<size_t>& idxs, size_t M)
+{
+	std::vector<size_t> counts(M, 0);
+	for (const auto i : idxs)
+	{
+		EXPECT_LT(i, M);
+		if (i < M) counts[i]++;
+	}
+	return counts;
+}
+}  // namespace
+
+TEST(CParticleFilterCapable, computeResampling_systematic)
+{
+	mrpt::random::getRandomGenerator().randomize(123);
+
+	for (const size_t M : {1U, 7U, 100U, 1000U})
+	{
+		const auto log_w = randomLogWeights(M);
+		const double maxW = *std::max_element(log_w.begin(), log_w.end());
+		double sumW = 0;
+		for (const auto w : log_w)
+			sumW += std::exp(w - maxW);
+
+		for (const size_t N : {M, 2 * M + 1, M / 2 + 1})
+		{
+			std::vector<size_t> idxs;
+			CParticleFilterCapable::computeResampling(
+				CParticleFilter::prSystematic, log_w, idxs, N);
+			ASSERT_EQ(idxs.size(), N);
+			EXPECT_TRUE(std::is_sorted(idxs.begin(), idxs.end()));
+
+			// Systematic resampling: each particle is copied either
+			// floor(N*w) or ceil(N*w) times:
+			const auto counts = countCopies(idxs, M);
+			for (size_t i = 0; i < M; i++)
+			{
+				const double expected =
+					N * std::exp(log_w[i] - maxW) / sumW;
+				EXPECT_GE(counts[i] + 1e-6, std::floor(expected));
+				EXPECT_LE(counts[i], std::ceil(expected) + 1e-6);
+			}
+		}
+	}
+}
+
+TEST(CParticleFilterCapable, computeResampling_allMethods)
+{
+	mrpt::random::getRandomGenerator().randomize(456);
+
+	const size_t M = 2000;
+	// Particle #0 has half the total weight:
+	std::vector<double> log_w(M, 0.0);
+	log_w[0] = std::log(double(M - 1));
+
+	for (const auto method :
+		 {CParticleFilter::prMultinomial, CParticleFilter::prResidual,
+		  CParticleFilter::prStratified, CParticleFilter::prSystematic})
+	{
+		for (const size_t N : {M, M / 4, 3 * M})
+		{
+			std::vector<size_t> idxs;
+			CParticleFilterCapable::computeResampling(method, log_w, idxs, N);
+			ASSERT_EQ(idxs.size(), N) << "method=" << method;
+
+			const auto counts = countCopies(idxs, M);
+			EXPECT_NEAR(counts[0], N / 2, 0.1 * N) << "method=" << method;
+		}
+	}
+}
+
+TEST(CParticleFilterCapable, computeResampling_otherOutputCount)
+{
+	mrpt::random::getRandomGenerator().randomize(789);
+
+	const size_t M = 50;
+	const auto log_w = randomLogWeights(M);
+	const double maxW = *std::max_element(log_w.begin(), log_w.end());
+	std::vector<double> w(M);
+	double sumW = 0;
+	for (size_t i = 0; i < M; i++)
+		sumW += (w[i] = std::exp(log_w[i] - maxW));
+	for (auto& wi : w)
+		wi /= sumW;
+
+	for (const size_t N : {M / 3, 5 * M + 3})
+	{
+		// Residual: each particle is copied at least floor(N*w) times:
+		std::vector<size_t> idxs;
+		CParticleFilterCapable::computeResampling(
+			CParticleFilter::prResidual, log_w, idxs, N);
+		ASSERT_EQ(idxs.size(), N);
+		const auto counts = countCopies(idxs, M);
+		for (size_t i = 0; i < M; i++)
+			EXPECT_GE(counts[i] + 1e-6, std::floor(N * w[i]));
+
+		// Multinomial: sorted, and unbiased on average:
+		const int nRuns = 400;
+		std::vector<double> meanCounts(M, 0);
+		for (int run = 0; run < nRuns; run++)
+		{
+			CParticleFilterCapable::computeResampling(
+				CParticleFilter::prMultinomial, log_w, idxs, N);
+			ASSERT_EQ(idxs.size(), N);
+			EXPECT_TRUE(std::is_sorted(idxs.begin(), idxs.end()));
+			const auto c = countCopies(idxs, M);
+			for (size_t i = 0; i < M; i++)
+				meanCounts[i] += double(c[i]) / nRuns;
+		}
+		for (size_t i = 0; i < M; i++)
+		{
+			// 5 sigmas of the mean of nRuns binomial counts:
+			const double sigma = std::sqrt(N * w[i] * (1 - w[i]) / nRuns);
+			EXPECT_NEAR(meanCounts[i], N * w[i], 5 * sigma + 1e-3)
+				<< "N=" << N << " i=" << i;
+		}
+	}
+}
@@ -0,0 +1,85 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+#include <mrpt/bayes/CParticleFilter.h>
+#include <mrpt/core/exceptions.h>
+#include <mrpt/random/RandomGenerators.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+using mrpt::bayes::CParticleFilter;
+using mrpt::random::CRandomGenerator;
+
+namespace
+{
+// One random number per particle, drawn with N threads:
+std::vector<double> drawPerParticle(unsigned int numThreads, size_t N)
+{
+	CParticleFilter::TParticleFilterOptions opts;
+	opts.numThreads = numThreads;
+
+	mrpt::random::getRandomGenerator().randomize(1234);
+
+	std::vector<double> out(N, -1.0);
+	CParticleFilter::forEachParticleBlock(
+		opts, N, [&](size_t first, size_t last, CRandomGenerator& rng) {
+			for (size_t i = first; i < last; i++)
+				out[i] = rng.drawUniform(0.0, 1.0);
+		});
+	return out;
+}
+}  // namespace
+
+TEST(CParticleFilter, forEachParticleBlock_visitsAll)
+{
+	for (const size_t N : {0U, 1U, 63U, 64U, 65U, 1000U})
+	{
+		CParticleFilter::TParticleFilterOptions opts;
+		opts.numThreads = 4;
+
+		std::vector<std::atomic<int>> visits(N);
+		CParticleFilter::forEachParticleBlock(
+			opts, N, [&](size_t first, size_t last, CRandomGenerator&) {
+				for (size_t i = first; i < last; i++)
+					visits[i]++;
+			});
+		for (size_t i = 0; i < N; i++)
+			EXPECT_EQ(visits[i].load(), 1) << "N=" << N << " i=" << i;
+	}
+}
+
+TEST(CParticleFilter, forEachParticleBlock_deterministic)
+{
+	const size_t N = 1000;
+	const auto ref = drawPerParticle(1, N);
+	for (const unsigned int nThreads : {2U, 3U, 8U, 0U})
+		EXPECT_EQ(drawPerParticle(nThreads, N), ref)
+			<< "numThreads=" << nThreads;
+
+	// Different blocks must use different random streams:
+	EXPECT_NE(ref[0], ref[64]);
+}
+
+TEST(CParticleFilter, forEachParticleBlock_rethrows)
+{
+	CParticleFilter::TParticleFilterOptions opts;
+	opts.numThreads = 3;
+
+	EXPECT_THROW(
+		CParticleFilter::forEachParticleBlock(
+			opts, 500,
+			[&](size_t first, size_t last, CRandomGenerator&) {
+				if (first <= 300 && 300 < last)
+					throw std::runtime_error("failed block");
+			}),
+		std::exception);
+}
@@ -0,0 +1,59 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace mrpt
+{
+/** \addtogroup mrpt_core_grp
+ * @{ */
+
+/** Returns `numThreads`, or the number of hardware threads if it is 0.
+ * \note (New in MRPT 2.5.5)
+ */
+std::size_t resolveNumThreads(std::size_t numThreads);
+
+/** Calls `func(first, last)` for the consecutive blocks
+ * `[0,blockSize), [blockSize,2*blockSize), ...` that cover `[0,n)`, using up
+ * to `numThreads` threads (0: all hardware threads).
+ *
+ * The calling thread processes blocks too, and the rest of threads come from
+ * a process-wide pool shared by all MRPT algorithms, created on the first
+ * use, so calling this method often is cheap. Each thread takes the next
+ * pending block, so the block limits (not the threads) should decide the
+ * results. Calls made from within `func` run in the calling thread, so
+ * nested parallel loops do not deadlock.
+ *
+ * The method returns once all blocks are done. If any call to `func` throws,
+ * no more blocks are started and the first exception is rethrown.
+ *
+ * \note (New in MRPT 2.5.5)
+ * \sa parallelTaskSeed
+ */
+void parallelFor(
+	std::size_t n, std::size_t blockSize, std::size_t numThreads,
+	const std::function<void(std::size_t first, std::size_t last)>& func);
+
+/** Seed for the random generator of the `taskIdx`-th of a set of parallel
+ * tasks, given the seed `baseSeed` of the whole set. Giving each task (e.g.
+ * each block of parallelFor()) its own generator makes the results
+ * independent of the number of threads.
+ * \note (New in MRPT 2.5.5)
+ */
+constexpr uint32_t parallelTaskSeed(uint32_t baseSeed, std::size_t taskIdx)
+{
+	// The golden ratio spreads consecutive tasks over the 32 bit range:
+	return baseSeed + static_cast<uint32_t>(taskIdx) * 0x9E3779B9u;
+}
+
+/** @} */
+}  // namespace mrpt
@@ -0,0 +1,106 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "core-precomp.h"  // Precompiled headers
+//
+#include <mrpt/config.h>
+#include <mrpt/core/WorkerThreadsPool.h>
+#include <mrpt/core/lock_helper.h>
+#include <mrpt/core/parallel_for.h>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+// Whether this thread is running blocks of a parallelFor() call:
+thread_local bool insideParallelFor = false;
+
+// Returns the shared pool, grown to at least `minThreads` threads:
+mrpt::WorkerThreadsPool& sharedPool(std::size_t minThreads)
+{
+	static std::mutex mtx;
+	static mrpt::WorkerThreadsPool pool;
+
+	auto lck = mrpt::lockHelper(mtx);
+	if (pool.size() < minThreads)
+	{
+		pool.resize(minThreads - pool.size());
+		pool.name("mrpt_parallel");
+	}
+	return pool;
+}
+}  // namespace
+
+std::size_t mrpt::resolveNumThreads(std::size_t numThreads)
+{
+	if (numThreads != 0) return numThreads;
+	return std::max<std::size_t>(1, std::thread::hardware_concurrency());
+}
+
+void mrpt::parallelFor(
+	std::size_t n, std::size_t blockSize, std::size_t numThreads,
+	const std::function<void(std::size_t first, std::size_t last)>& func)
+{
+	if (!n) return;
+	if (!blockSize) blockSize = 1;
+
+	const std::size_t nBlocks = (n + blockSize - 1) / blockSize;
+	const std::size_t nThreads =
+		std::min(nBlocks, mrpt::resolveNumThreads(numThreads));
+
+	if (nThreads == 1 || insideParallelFor || MRPT_IN_EMSCRIPTEN)
+	{
+		for (std::size_t first = 0; first < n; first += blockSize)
+			func(first, std::min(n, first + blockSize));
+		return;
+	}
+
+	std::atomic<std::size_t> nextBlock{0};
+	std::mutex errMtx;
+	std::exception_ptr firstError;
+
+	const auto worker = [&]() {
+		insideParallelFor = true;
+		try
+		{
+			for (std::size_t b = nextBlock++; b < nBlocks; b = nextBlock++)
+			{
+				const std::size_t first = b * blockSize;
+				func(first, std::min(n, first + blockSize));
+			}
+		}
+		catch (...)
+		{
+			nextBlock = nBlocks;  // do not start more blocks
+			auto lck = mrpt::lockHelper(errMtx);
+			if (!firstError) firstError = std::current_exception();
+		}
+		insideParallelFor = false;
+	};
+
+	// This thread works too, so it needs one thread less from the pool:
+	auto& pool = sharedPool(nThreads - 1);
+	std::vector<std::future<void>> jobs;
+	jobs.reserve(nThreads - 1);
+	for (std::size_t t = 1; t < nThreads; t++)
+		jobs.emplace_back(pool.enqueue(worker));
+	worker();
+
+	// Wait for all jobs, since they reference local variables:
+	for (auto& j : jobs)
+		j.wait();
+
+	if (firstError) std::rethrow_exception(firstError);
+}
@@ -0,0 +1,66 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+#include <mrpt/core/parallel_for.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+TEST(parallelFor, visitsAllBlocks)
+{
+	for (const std::size_t numThreads : {1, 4})
+	{
+		const std::size_t N = 1000, blockSize = 64;
+		std::vector<int> hits(N, 0);
+		std::atomic<std::size_t> nBlocks{0};
+		mrpt::parallelFor(
+			N, blockSize, numThreads, [&](std::size_t first, std::size_t last) {
+				EXPECT_EQ(first % blockSize, 0U);
+				EXPECT_EQ(last, std::min(N, first + blockSize));
+				for (std::size_t i = first; i < last; i++)
+					hits[i]++;
+				nBlocks++;
+			});
+		EXPECT_EQ(nBlocks, (N + blockSize - 1) / blockSize);
+		for (const int h : hits)
+			EXPECT_EQ(h, 1);
+	}
+}
+
+TEST(parallelFor, nested)
+{
+	std::atomic<std::size_t> count{0};
+	mrpt::parallelFor(8, 1, 4, [&](std::size_t, std::size_t) {
+		mrpt::parallelFor(
+			10, 1, 4, [&](std::size_t, std::size_t) { count++; });
+	});
+	EXPECT_EQ(count, 80U);
+}
+
+TEST(parallelFor, rethrows)
+{
+	for (const std::size_t numThreads : {1, 4})
+	{
+		EXPECT_THROW(
+			mrpt::parallelFor(
+				100, 1, numThreads,
+				[](std::size_t first, std::size_t) {
+					if (first == 42) throw std::runtime_error("block 42");
+				}),
+			std::runtime_error);
+	}
+}
+
+TEST(parallelFor, taskSeeds)
+{
+	EXPECT_EQ(mrpt::parallelTaskSeed(123, 0), 123U);
+	EXPECT_NE(mrpt::parallelTaskSeed(123, 1), mrpt::parallelTaskSeed(123, 2));
+}
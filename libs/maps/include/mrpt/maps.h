@@ -18,16 +18,23 @@ MRPT_WARNING(
 #include <mrpt/config.h>
 #include <mrpt/maps/CBeacon.h>
 #include <mrpt/maps/CBeaconMap.h>
+#include <mrpt/maps/CChunkedPointsMap.h>
 #include <mrpt/maps/CColouredOctoMap.h>
 #include <mrpt/maps/CColouredPointsMap.h>
+#include <mrpt/maps/CDynamicVoronoi2D.h>
 #include <mrpt/maps/CGasConcentrationGridMap2D.h>
+#include <mrpt/maps/CHashedOcTree.h>
+#include <mrpt/maps/CHashedOctoMap.h>
+#include <mrpt/maps/CHashedVoxelPointsMap.h>
 #include <mrpt/maps/CHeightGridMap2D.h>
 #include <mrpt/maps/CHeightGridMap2D_MRF.h>
 #include <mrpt/maps/CMultiMetricMap.h>
 #include <mrpt/maps/COccupancyGridMap2D.h>
+#include <mrpt/maps/COccupancyGridMap2DSnapshot.h>
 #include <mrpt/maps/COccupancyGridMap3D.h>
 #include <mrpt/maps/COctoMap.h>
 #include <mrpt/maps/CPointsMap.h>
+#include <mrpt/maps/CPointsMapRingBuffer.h>
 #include <mrpt/maps/CPointsMapXYZI.h>
 #include <mrpt/maps/CRandomFieldGridMap3D.h>
 #include <mrpt/maps/CReflectivityGridMap2D.h>
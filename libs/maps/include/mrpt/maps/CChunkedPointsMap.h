@@ -0,0 +1,265 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/io/CFileInputStream.h>
+#include <mrpt/io/CFileOutputStream.h>
+#include <mrpt/maps/CSimplePointsMap.h>
+#include <mrpt/math/TBoundingBox.h>
+#include <mrpt/math/TPoint3D.h>
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace mrpt::maps
+{
+/** Writes a chunked point cloud file, to be read with CChunkedPointsMap.
+ *
+ * Points are bucketed into cubic chunks of a fixed size and kept in memory
+ * until the number of buffered points reaches `maxBufferedPoints`. Then, the
+ * points of each chunk are appended to the file as one more "fragment" of
+ * that chunk, and the buffers are emptied. This way, arbitrarily large point
+ * clouds can be converted with bounded memory. The index of all chunks and
+ * fragments is written at the end of the file by close().
+ *
+ * Usage:
+ * \code
+ * CChunkedPointsMapWriter w("map.chunks", 20.0f);
+ * w.insertPointsFromTextFile("huge_survey.txt");
+ * w.insertPoints(someMap);
+ * w.close();
+ * \endcode
+ *
+ * \sa CChunkedPointsMap
+ * \ingroup mrpt_maps_grp
+ * \note [New in MRPT 2.5.5]
+ */
+class CChunkedPointsMapWriter
+{
+   public:
+	/** Creates the file, with cubic chunks of `chunkSize` meters.
+	 * \exception std::exception If the file cannot be created.
+	 */
+	CChunkedPointsMapWriter(
+		const std::string& fileName, float chunkSize,
+		size_t maxBufferedPoints = 1000000);
+	/** Calls close(), if not called before */
+	~CChunkedPointsMapWriter();
+
+	void insertPoint(float x, float y, float z);
+	/// \overload
+	void insertPoint(const mrpt::math::TPoint3Df& p)
+	{
+		insertPoint(p.x, p.y, p.z);
+	}
+
+	/** Inserts all points of a map */
+	void insertPoints(const CPointsMap& m);
+
+	/** Inserts the points in a text file, with one point per line ("X Y" or
+	 * "X Y Z", other columns are ignored), reading it line by line.
+	 * \return The number of inserted points
+	 * \exception std::exception If the file cannot be open.
+	 * \sa CPointsMap::load2Dor3D_from_text_file()
+	 */
+	size_t insertPointsFromTextFile(const std::string& fileName);
+
+	/** Writes all buffered points and the index of chunks, and closes the
+	 * file. No more points can be inserted afterwards. */
+	void close();
+
+	/** Number of points inserted so far */
+	size_t size() const { return m_numPoints; }
+
+   private:
+	struct TChunkBuffer
+	{
+		std::vector<float> x, y, z;
+	};
+	struct TFragment
+	{
+		uint64_t offset;
+		uint32_t count;
+	};
+
+	void flush();
+
+	mrpt::io::CFileOutputStream m_f;
+	float m_chunkSize;
+	size_t m_maxBufferedPoints;
+	size_t m_numBuffered = 0, m_numPoints = 0;
+	mrpt::math::TBoundingBoxf m_bbox =
+		mrpt::math::TBoundingBoxf::PlusMinusInfinity();
+	std::unordered_map<uint64_t, TChunkBuffer> m_buffers;
+	std::unordered_map<uint64_t, std::vector<TFragment>> m_fragments;
+	bool m_closed = false;
+};
+
+/** A read-only point map stored on disk by spatial chunks, for point clouds
+ * too large to be kept in memory (e.g. survey maps with hundreds of millions
+ * of points).
+ *
+ * The file is created with CChunkedPointsMapWriter, or with the converter
+ * convertFrom(). When open, only the index of chunks is loaded. Region
+ * queries (queryBoundingBox(), queryRadius()) read the chunks they overlap
+ * on demand, and keep them in a cache of recently used chunks, bounded by a
+ * maximum number of points (see setMaxCachedPoints()). The least recently
+ * used chunks are evicted first.
+ *
+ * For localization against a huge map, query the region around the current
+ * pose estimate into a CSimplePointsMap, and use it as the reference map
+ * while the robot remains in that region. Only the working set of chunks is
+ * kept in memory.
+ *
+ * Chunks are returned as shared pointers: evicting a chunk from the cache
+ * does not invalidate it for users still holding it. All methods are
+ * thread-safe.
+ *
+ * File format (all numbers in little endian):
+ *  - Header: magic "MRPTCHPM", uint32 version, float chunk size, uint64
+ *    offset of the index.
+ *  - Fragments: for each one, `count` floats with the X coordinates, then Y,
+ *    then Z.
+ *  - Index: uint64 number of points, float bounding box (min XYZ, max XYZ),
+ *    uint32 number of chunks, and for each chunk: int32 chunk coordinates
+ *    (ix,iy,iz), uint32 number of fragments, and for each fragment its
+ *    uint64 offset and uint32 number of points.
+ *
+ * \sa CChunkedPointsMapWriter, CSimplePointsMap
+ * \ingroup mrpt_maps_grp
+ * \note [New in MRPT 2.5.5]
+ */
+class CChunkedPointsMap
+{
+   public:
+	/** Bits per axis of the integer chunk coordinates within hash keys */
+	static constexpr unsigned int KEY_BITS = 21;
+	/** Integer chunk coordinates must be in the range [-KEY_OFFSET,
+	 * KEY_OFFSET) */
+	static constexpr int32_t KEY_OFFSET = 1 << (KEY_BITS - 1);
+
+	CChunkedPointsMap() = default;
+	/** Constructor which calls open()
+	 * \exception std::exception On any error opening the file.
+	 */
+	explicit CChunkedPointsMap(const std::string& fileName)
+	{
+		open(fileName);
+	}
+
+	/** Opens a chunked point cloud file, loading its index.
+	 * \exception std::exception On any error opening or parsing the file.
+	 */
+	void open(const std::string& fileName);
+	bool isOpen() const;
+	/** Closes the file and empties the cache */
+	void close();
+
+	/** Writes all points of `m` to a new chunked file */
+	static void convertFrom(
+		const CPointsMap& m, const std::string& fileName, float chunkSize,
+		size_t maxBufferedPoints = 1000000);
+
+	/** Size of the cubic chunks (meters) */
+	float getChunkSize() const;
+	/** Total number of points in the file */
+	size_t size() const;
+	/** Number of non-empty chunks */
+	size_t chunkCount() const;
+	/** Bounding box of all the points in the file */
+	mrpt::math::TBoundingBoxf boundingBox() const;
+
+	/** Appends to `out` all points within the bounding box */
+	void queryBoundingBox(
+		const mrpt::math::TBoundingBoxf& bbox, CPointsMap& out) const;
+
+	/** Appends to `out` all points at a distance `radius` or less from
+	 * `center` */
+	void queryRadius(
+		const mrpt::math::TPoint3Df& center, float radius,
+		CPointsMap& out) const;
+
+	/** Returns the points of the chunk with integer coordinates (ix,iy,iz),
+	 * reading it from disk if it is not in the cache, or nullptr if there is
+	 * no such chunk. The chunk holds the points within
+	 * `[ix*chunkSize, (ix+1)*chunkSize)` in X, and so on. */
+	CSimplePointsMap::ConstPtr getChunk(int32_t ix, int32_t iy, int32_t iz)
+		const;
+
+	/** Limits the number of points kept in the cache of chunks (default:
+	 * 10 million points, i.e. 120 MB). The most recently used chunk is never
+	 * evicted, even if it alone exceeds the limit. */
+	void setMaxCachedPoints(size_t n);
+	size_t getMaxCachedPoints() const;
+
+	/** Cache statistics
+	 * \sa getCacheStats() */
+	struct TCacheStats
+	{
+		size_t cachedChunks = 0, cachedPoints = 0;
+		/** Number of chunk lookups served from the cache, or read from disk,
+		 * since open() */
+		size_t hits = 0, misses = 0;
+	};
+	TCacheStats getCacheStats() const;
+
+	/** Packs the integer coordinates of a chunk into a hash key */
+	static uint64_t chunkKey(int32_t ix, int32_t iy, int32_t iz)
+	{
+		constexpr uint64_t mask = (uint64_t(1) << KEY_BITS) - 1;
+		return (uint64_t(ix + KEY_OFFSET) & mask) |
+			((uint64_t(iy + KEY_OFFSET) & mask) << KEY_BITS) |
+			((uint64_t(iz + KEY_OFFSET) & mask) << (2 * KEY_BITS));
+	}
+
+   private:
+	struct TFragment
+	{
+		uint64_t offset;
+		uint32_t count;
+	};
+	struct TChunk
+	{
+		std::vector<TFragment> fragments;
+		size_t numPoints = 0;
+		/** Cached points, or nullptr if not in the cache */
+		CSimplePointsMap::Ptr points;
+		/** Position in the LRU list, if cached */
+		std::list<uint64_t>::iterator lruIt;
+	};
+
+	// These methods must be called with m_mtx locked.
+
+	/** Invokes `f(chunk)` for each existing chunk overlapping the box */
+	template <class FUNCTOR>
+	void forEachChunkIn(
+		const mrpt::math::TBoundingBoxf& bbox, const FUNCTOR& f) const;
+	CSimplePointsMap::ConstPtr loadChunk(uint64_t key, TChunk& c) const;
+	void evict() const;
+
+	mutable mrpt::io::CFileInputStream m_f;
+	float m_chunkSize = 0;
+	size_t m_numPoints = 0;
+	mrpt::math::TBoundingBoxf m_bbox;
+	mutable std::unordered_map<uint64_t, TChunk> m_index;
+
+	size_t m_maxCachedPoints = 10000000;
+	/** Keys of cached chunks, most recently used first */
+	mutable std::list<uint64_t> m_lru;
+	mutable TCacheStats m_stats;
+	/** Protects the file, the index, the cache and all settings. Queries are
+	 * const, but read chunks and update the LRU list and statistics. */
+	mutable std::mutex m_mtx;
+};
+
+}  // namespace mrpt::maps
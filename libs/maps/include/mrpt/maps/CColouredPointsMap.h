@@ -112,6 +112,12 @@ class CColouredPointsMap : public CPointsMap
 	void addFrom_classSpecific(
 		const CPointsMap& anotherMap, const size_t nPreviousPoints,
 		const bool filterOutPointsAtZero) override;
+	void getExtraFieldBuffers(field_buffers_t& fields) override
+	{
+		fields.emplace_back("color_r", &m_color_R);
+		fields.emplace_back("color_g", &m_color_G);
+		fields.emplace_back("color_b", &m_color_B);
+	}
 
 	// Friend methods:
 	template <class Derived>
@@ -0,0 +1,235 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <queue>
+#include <utility>
+#include <vector>
+
+namespace mrpt::maps
+{
+class COccupancyGridMap2D;
+
+/** Euclidean distance map and Voronoi diagram of the obstacles of a
+ * COccupancyGridMap2D, which can be updated incrementally as cells change
+ * their occupancy.
+ *
+ * For each cell, it keeps the squared distance (in cell units) to its closest
+ * obstacle cell, the index of that obstacle, and whether the cell belongs to
+ * the generalized Voronoi diagram (GVD) of the obstacles.
+ *
+ * - initialize() computes all layers from scratch with an exact Euclidean
+ *   distance transform (separable, Felzenszwalb & Huttenlocher), run in
+ *   parallel over columns and rows.
+ * - update() compares the current grid against the occupancy used the last
+ *   time, and only propagates the changes through the affected cells, with
+ *   the dynamic brushfire algorithm in [1]: new obstacles emit "lower" waves,
+ *   removed obstacles emit "raise" waves which invalidate the cells whose
+ *   closest obstacle was removed, until meeting lower waves from the
+ *   surrounding valid obstacles.
+ *
+ * To find the changed cells without comparing the whole grid, this object
+ * keeps the write stamps of the bands of rows of the grid (see
+ * COccupancyGridMap2D::CELL_BAND_ROWS) as of its last update, and update()
+ * only compares the bands written to since then. Hence, update() must be
+ * given the grid passed to initialize(), or a copy of it.
+ *
+ * Distances after incremental updates may differ from those of a full
+ * rebuild by a small fraction of a cell in a few locations, since brushfire
+ * propagation of closest obstacles over an 8-connected grid is not exact.
+ *
+ * This class is not thread-safe: concurrent calls to update() and getters
+ * must be externally synchronized.
+ *
+ * [1] B. Lau, C. Sprunk, W. Burgard, "Improved updating of Euclidean distance
+ * maps and Voronoi diagrams", IROS 2010.
+ *
+ * \sa COccupancyGridMap2D::updateVoronoiDiagram()
+ * \ingroup mrpt_maps_grp
+ */
+class CDynamicVoronoi2D
+{
+   public:
+	/** Squared distance of cells without any reachable obstacle */
+	static constexpr int32_t INVALID_DISTANCE =
+		std::numeric_limits<int32_t>::max();
+
+	CDynamicVoronoi2D() = default;
+
+	/** Rebuilds the distance map and Voronoi diagram from scratch.
+	 * \param grid The source occupancy grid.
+	 * \param freeThreshold Cells whose "freeness" probability (as returned by
+	 * COccupancyGridMap2D::getCell()) is below this value are obstacles.
+	 * \param numThreads Number of threads to use, or 0 to use all available
+	 * hardware threads.
+	 */
+	void initialize(
+		const COccupancyGridMap2D& grid, float freeThreshold = 0.5f,
+		std::size_t numThreads = 0);
+
+	/** Updates the distance map and Voronoi diagram after changes in the
+	 * grid: cells whose occupancy changed are found, only within the bands
+	 * of rows written to since the last update, and the modifications
+	 * propagated only to the affected cells. If the grid size changed, or
+	 * initialize() was never called, this does a full initialize() instead.
+	 * \return The number of cells whose occupancy changed.
+	 * \sa getLastUpdatedCells()
+	 */
+	std::size_t update(const COccupancyGridMap2D& grid);
+
+	/** Like update(), but only looks for occupancy changes within the cell
+	 * range [x1,x2]x[y1,y2], e.g. the area touched by the last observation.
+	 * Distances and Voronoi state of cells outside of that area are updated
+	 * as needed.
+	 */
+	std::size_t update(
+		const COccupancyGridMap2D& grid, int x1, int x2, int y1, int y2);
+
+	/** @name Low-level edition
+		@{ */
+
+	/** Marks a cell as obstacle. Call propagate() after all changes. */
+	void setObstacle(int cx, int cy);
+	/** Marks a cell as free. Call propagate() after all changes. */
+	void removeObstacle(int cx, int cy);
+	/** Propagates all pending changes from setObstacle()/removeObstacle() */
+	void propagate();
+
+	/** @} */
+
+	/** @name Queries
+		@{ */
+
+	unsigned int getSizeX() const { return m_size_x; }
+	unsigned int getSizeY() const { return m_size_y; }
+	/** The threshold passed to initialize() */
+	float getFreeThreshold() const { return m_freeThreshold; }
+	/** True if initialize() was called (and clear() was not). */
+	bool isInitialized() const { return !m_sqdist.empty(); }
+
+	inline bool isOccupied(unsigned int cx, unsigned int cy) const
+	{
+		return m_flags[idx(cx, cy)] & FLAG_OCCUPIED;
+	}
+	/** Whether the cell belongs to the Voronoi diagram */
+	inline bool isVoronoi(unsigned int cx, unsigned int cy) const
+	{
+		return m_flags[idx(cx, cy)] & FLAG_VORONOI;
+	}
+	/** Squared distance to the closest obstacle, in cell units, or
+	 * INVALID_DISTANCE if there are no obstacles */
+	inline int32_t getSquaredDistance(unsigned int cx, unsigned int cy) const
+	{
+		return m_sqdist[idx(cx, cy)];
+	}
+	/** Distance to the closest obstacle, in cell units, or +Inf if there are
+	 * no obstacles */
+	inline float getDistance(unsigned int cx, unsigned int cy) const
+	{
+		const int32_t d = m_sqdist[idx(cx, cy)];
+		return d == INVALID_DISTANCE ? std::numeric_limits<float>::infinity()
+									 : std::sqrt(static_cast<float>(d));
+	}
+	/** Gets the indices of the closest obstacle to a cell.
+	 * \return false if there are no obstacles */
+	bool getClosestObstacle(
+		unsigned int cx, unsigned int cy, int& obs_cx, int& obs_cy) const;
+
+	/** The cells (as `cx + cy * getSizeX()`) whose closest obstacle or
+	 * distance changed in the last update() or propagate(), maybe repeated.
+	 * Only them and their 8 neighbors can have changed their Voronoi state.
+	 * Empty after initialize(). */
+	const std::vector<int32_t>& getLastUpdatedCells() const
+	{
+		return m_touched;
+	}
+
+	/** @} */
+
+	/** Frees all memory */
+	void clear();
+
+   private:
+	enum : uint8_t
+	{
+		FLAG_OCCUPIED = 0x01,
+		FLAG_RAISE = 0x02,
+		FLAG_VORONOI = 0x04
+	};
+	/** Queueing state of each cell, used to skip outdated queue entries */
+	enum : uint8_t
+	{
+		Q_NONE = 0,
+		Q_LOWER_QUEUED,
+		Q_LOWER_DONE,
+		Q_RAISE_QUEUED,
+		Q_RAISE_DONE
+	};
+
+	unsigned int m_size_x = 0, m_size_y = 0;
+	float m_freeThreshold = 0.5f;
+
+	std::vector<int32_t> m_sqdist;	//!< Squared distances (cells^2)
+	std::vector<int32_t> m_obst;  //!< Closest obstacle cell index, or -1
+	std::vector<uint8_t> m_flags;  //!< FLAG_* bitfields
+	std::vector<uint8_t> m_queueing;  //!< Q_* states
+
+	using queue_entry_t = std::pair<int32_t, int32_t>;	// (sqdist, index)
+	std::priority_queue<
+		queue_entry_t, std::vector<queue_entry_t>, std::greater<queue_entry_t>>
+		m_open;
+
+	inline std::size_t idx(unsigned int cx, unsigned int cy) const
+	{
+		return cx + static_cast<std::size_t>(cy) * m_size_x;
+	}
+	inline bool isValidObstacle(int32_t o) const
+	{
+		return o >= 0 && (m_flags[o] & FLAG_OCCUPIED) && m_obst[o] == o;
+	}
+	inline int32_t sqDistTo(int32_t cell, int32_t obst) const
+	{
+		const int32_t dx = int32_t(cell % m_size_x) - int32_t(obst % m_size_x);
+		const int32_t dy = int32_t(cell / m_size_x) - int32_t(obst / m_size_x);
+		return dx * dx + dy * dy;
+	}
+
+	/** Cells processed by the last propagate() */
+	std::vector<int32_t> m_touched;
+
+	/** The write stamps of the cell bands of the grid, as of the last full
+	 * initialize() or update() (see COccupancyGridMap2D::m_cellBandStamps).
+	 */
+	std::vector<uint64_t> m_syncedBandStamps;
+
+	/** Saves the current band stamps of `grid`, renewing its write stamp so
+	 * later writes can be told apart. */
+	void syncBands(const COccupancyGridMap2D& grid);
+
+	void raise(int32_t s);
+	void lower(int32_t s);
+	/** Re-evaluates whether cell `s` belongs to the Voronoi diagram */
+	void updateVoronoiFlag(int32_t s);
+	/** Voronoi test between neighbors (s,n), as in [1]: true if the closest
+	 * obstacles of both are different objects, and `s` is closer than `n`
+	 * to the line equidistant to both obstacles. */
+	bool isVoronoiPair(int32_t s, int32_t n) const;
+
+	/** Compares the cells in [x1,x2]x[y1,y2] against their last occupancy,
+	 * and marks changes with setObstacle()/removeObstacle().
+	 * \return The number of changed cells */
+	std::size_t findChanges(
+		const COccupancyGridMap2D& grid, int x1, int x2, int y1, int y2);
+};
+
+}  // namespace mrpt::maps
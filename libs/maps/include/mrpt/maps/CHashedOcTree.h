@@ -0,0 +1,284 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/math/TPoint3D.h>
+#include <mrpt/serialization/serialization_frwds.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace mrpt::maps
+{
+/** Native (in-tree) probabilistic 3D occupancy voxel store, used as the
+ * storage engine of CHashedOctoMap.
+ *
+ * Unlike octomap's `OcTree`, there are no per-voxel heap nodes: voxels are
+ * grouped into dense leaf blocks of 8x8x8 voxels (as in VDB-like hierarchical
+ * grids), all blocks live in a single contiguous pool, and a hash table maps
+ * block coordinates to pool indices. Within a block, voxels are stored in
+ * Morton (Z-order) so that neighboring voxels share cache lines.
+ *
+ * Voxels are identified by a 63-bit Morton code of their integer coordinates
+ * (21 bits per axis, with the origin at the center of the range), such that
+ * the top bits are the code of the block and the lowest 9 bits the index of
+ * the voxel within its block. Sorting voxel codes therefore groups them by
+ * block, which is exploited by insertPointCloud() to apply all the updates of
+ * one scan with a single hash lookup per block.
+ *
+ * The sensor model and semantics of updates (log-odds, clamping, "occupied
+ * wins over free" within a scan, ray traversal excluding the end point)
+ * follow those of the octomap library, so the maps built by both engines are
+ * equivalent. Tree pruning does not apply to this engine.
+ *
+ * \sa CHashedOctoMap, COctoMapBase
+ * \ingroup mrpt_maps_grp
+ */
+class CHashedOcTree
+{
+   public:
+	/** Each voxel only holds its occupancy, in log-odds */
+	struct Voxel
+	{
+		float logodds = 0;
+
+		/** Occupancy probability [0,1] */
+		double getOccupancy() const;
+		float getLogOdds() const { return logodds; }
+	};
+
+	/** Points and point clouds, as used by
+	 * COctoMapBase::internal_build_PointCloud_for_observation() */
+	using point3d = mrpt::math::TPoint3Df;
+	struct Pointcloud
+	{
+		std::vector<float> xs, ys, zs;
+
+		void clear()
+		{
+			xs.clear();
+			ys.clear();
+			zs.clear();
+		}
+		void reserve(std::size_t n)
+		{
+			xs.reserve(n);
+			ys.reserve(n);
+			zs.reserve(n);
+		}
+		void push_back(float x, float y, float z)
+		{
+			xs.push_back(x);
+			ys.push_back(y);
+			zs.push_back(z);
+		}
+		std::size_t size() const { return xs.size(); }
+	};
+
+	/** Bits per axis of voxel coordinates */
+	static constexpr unsigned int KEY_BITS = 21;
+	/** Voxel coordinates are in the range [0, 2^KEY_BITS), with this value
+	 * being the voxel at the origin of coordinates */
+	static constexpr int32_t KEY_OFFSET = 1 << (KEY_BITS - 1);
+	/** Blocks are cubes of 2^BLOCK_LOG2 voxels per side */
+	static constexpr unsigned int BLOCK_LOG2 = 3;
+	static constexpr unsigned int BLOCK_VOXELS = 1U << (3 * BLOCK_LOG2);
+
+	/** A dense block of voxels, in Morton order */
+	struct Block
+	{
+		/** Morton code of the block coordinates */
+		uint64_t code = 0;
+		/** Bitmask of voxels which have been observed at least once */
+		std::array<uint64_t, BLOCK_VOXELS / 64> known{};
+		std::array<Voxel, BLOCK_VOXELS> voxels{};
+
+		bool isKnown(unsigned int i) const
+		{
+			return (known[i >> 6] >> (i & 63)) & 1;
+		}
+	};
+
+	CHashedOcTree(double resolution = 0.10);
+
+	double getResolution() const { return m_resolution; }
+	/** Changes the resolution, clearing the map. */
+	void setResolution(double resolution);
+
+	/** Removes all voxels */
+	void clear();
+
+	/** @name Voxel coordinates
+		@{ */
+
+	/** Computes the Morton code of the voxel containing (x,y,z).
+	 * \return false if the point is out of the range of the map. */
+	bool coordToCode(double x, double y, double z, uint64_t& code) const;
+	/** The center of a voxel */
+	mrpt::math::TPoint3D codeToCoord(uint64_t code) const;
+
+	static uint64_t mortonEncode(uint32_t kx, uint32_t ky, uint32_t kz);
+	static void mortonDecode(
+		uint64_t code, uint32_t& kx, uint32_t& ky, uint32_t& kz);
+
+	/** @} */
+
+	/** @name Sensor model (same meaning than in octomap)
+		@{ */
+	void setOccupancyThres(double prob);
+	void setProbHit(double prob);
+	void setProbMiss(double prob);
+	void setClampingThresMin(double thresProb);
+	void setClampingThresMax(double thresProb);
+	double getOccupancyThres() const;
+	float getOccupancyThresLog() const { return m_occupancyThresLog; }
+	double getProbHit() const;
+	float getProbHitLog() const { return m_probHitLog; }
+	double getProbMiss() const;
+	float getProbMissLog() const { return m_probMissLog; }
+	double getClampingThresMin() const;
+	float getClampingThresMinLog() const { return m_clampingThresMinLog; }
+	double getClampingThresMax() const;
+	float getClampingThresMaxLog() const { return m_clampingThresMaxLog; }
+
+	bool isOccupied(const Voxel& v) const
+	{
+		return v.logodds >= m_occupancyThresLog;
+	}
+	/** @} */
+
+	/** @name Updates
+		@{ */
+
+	/** Integrates a set of rays from the sensor at \a sensor to each point.
+	 * Voxels along all rays are computed first, sorted and deduplicated, then
+	 * updated once per scan: as "occupied" for end points, and as "free" for
+	 * voxels traversed by any ray which are not the end point of another one.
+	 * \param maxrange Rays longer than this are truncated, and their end
+	 * point not marked as occupied. Use <0 for no limit.
+	 */
+	void insertPointCloud(
+		const float* xs, const float* ys, const float* zs, std::size_t N,
+		const point3d& sensor, double maxrange = -1.0);
+
+	void insertPointCloud(
+		const Pointcloud& scan, const point3d& sensor, double maxrange = -1.0)
+	{
+		insertPointCloud(
+			scan.xs.data(), scan.ys.data(), scan.zs.data(), scan.size(),
+			sensor, maxrange);
+	}
+
+	/** Integrates a single ray: voxels between \a origin and \a end are
+	 * updated as free, and the one containing \a end as occupied. */
+	void insertRay(
+		const point3d& origin, const point3d& end, double maxrange = -1.0);
+
+	/** Updates the voxel containing (x,y,z) as occupied (true) or free
+	 * (false).
+	 * \return false if the point is out of the range of the map. */
+	bool updateNode(double x, double y, double z, bool occupied);
+
+	/** Adds \a logodds_delta to a voxel, clamping the result */
+	void updateNodeLogOdds(uint64_t code, float logodds_delta);
+
+	/** @} */
+
+	/** @name Queries
+		@{ */
+
+	/** \return nullptr if the voxel has never been observed */
+	const Voxel* search(uint64_t code) const;
+	/** \return nullptr if the voxel has never been observed, or the point is
+	 * out of the map range */
+	const Voxel* search(double x, double y, double z) const;
+
+	/** Casts a ray from \a origin along \a direction until it hits an occupied
+	 * voxel, whose center is returned in \a end. Same semantics than
+	 * `octomap::OcTree::castRay()`: unknown voxels abort the search unless
+	 * \a ignoreUnknownCells is true, and \a maxRange<=0 means no limit (in
+	 * practice, until leaving the bounding box of known voxels).
+	 */
+	bool castRay(
+		const mrpt::math::TPoint3D& origin,
+		const mrpt::math::TPoint3D& direction, mrpt::math::TPoint3D& end,
+		bool ignoreUnknownCells = false, double maxRange = -1.0) const;
+
+	/** Number of observed voxels */
+	std::size_t size() const { return m_numVoxels; }
+	/** Number of allocated blocks */
+	std::size_t getNumBlocks() const { return m_blocks.size(); }
+	/** Approximate memory usage, in bytes */
+	std::size_t memoryUsage() const;
+
+	/** Bounding box of all known voxels (zeros if the map is empty) */
+	void getMetricMin(double& x, double& y, double& z) const;
+	void getMetricMax(double& x, double& y, double& z) const;
+
+	/** Direct access to the pool of blocks, in creation order */
+	const std::vector<Block>& getBlocks() const { return m_blocks; }
+
+	/** Calls `f(code, voxel)` for each known voxel */
+	template <class FUNCTOR>
+	void forEachVoxel(FUNCTOR&& f) const
+	{
+		for (const Block& b : m_blocks)
+			for (unsigned int i = 0; i < BLOCK_VOXELS; i++)
+				if (b.isKnown(i))
+					f((b.code << (3 * BLOCK_LOG2)) | i, b.voxels[i]);
+	}
+
+	/** @} */
+
+	/** @name Serialization
+		@{ */
+	void writeToStream(mrpt::serialization::CArchive& out) const;
+	void readFromStream(mrpt::serialization::CArchive& in);
+	/** @} */
+
+   private:
+	double m_resolution = 0.10, m_resolutionInv = 10.0;
+
+	float m_occupancyThresLog, m_probHitLog, m_probMissLog,
+		m_clampingThresMinLog, m_clampingThresMaxLog;
+
+	/** Pool of blocks, contiguous in memory */
+	std::vector<Block> m_blocks;
+	/** Block Morton code -> index in m_blocks */
+	std::unordered_map<uint64_t, uint32_t> m_blockIndex;
+	std::size_t m_numVoxels = 0;
+	/** Bounding box of known voxels, in voxel coordinates */
+	std::array<uint32_t, 3> m_keyMin{}, m_keyMax{};
+
+	/** Reusable buffers for insertPointCloud() */
+	std::vector<uint64_t> m_freeCodes, m_occupiedCodes;
+
+	Block& getOrCreateBlock(uint64_t blockCode);
+	Voxel& getOrCreateVoxel(Block& b, uint64_t code);
+	void applyUpdate(Voxel& v, float logodds_delta) const;
+
+	bool coordToKey(double x, double y, double z, uint32_t key[3]) const;
+	double keyToCoord(uint32_t k) const
+	{
+		return (static_cast<double>(k) - KEY_OFFSET + 0.5) * m_resolution;
+	}
+	/** Appends the codes of the voxels traversed by the ray from \a origin to
+	 * \a end, excluding the voxel of \a end. Same algorithm than
+	 * `octomap::OcTreeBaseImpl::computeRayKeys()`.
+	 * \return false if any end is out of the map range. */
+	bool computeRayCodes(
+		const mrpt::math::TPoint3D& origin, const mrpt::math::TPoint3D& end,
+		std::vector<uint64_t>& codes) const;
+};
+
+}  // namespace mrpt::maps
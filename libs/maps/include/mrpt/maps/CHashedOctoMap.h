@@ -0,0 +1,117 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#pragma once
+
+#include <mrpt/maps/CHashedOcTree.h>
+#include <mrpt/maps/COctoMapBase.h>
+
+namespace mrpt::maps
+{
+/** A three-dimensional probabilistic occupancy map with the same API and
+ * sensor model than COctoMap, but stored with the native engine
+ * mrpt::maps::CHashedOcTree (pooled 8x8x8 voxel blocks in Morton order,
+ * indexed by a hash table) instead of the octomap library.
+ *
+ * It avoids one heap allocation per octree node and the pointer chasing of
+ * tree traversals, at the cost of not pruning homogeneous regions: it is
+ * best suited for fine resolutions and large, sparse environments. Scans
+ * are inserted in batches: all ray voxels are gathered, sorted in Morton
+ * order and updated once per scan, block by block.
+ *
+ * Both classes can be used interchangeably, e.g. as `octoMap` or
+ * `hashedOctoMap` entries in a CMultiMetricMap configuration file. The
+ * voxels can be directly accessed via getHashedOcTree().
+ *
+ * \sa COctoMap, CHashedOcTree, CMetricMap
+ * \ingroup mrpt_maps_grp
+ */
+class CHashedOctoMap : public COctoMapBase<CHashedOcTree, CHashedOcTree::Voxel>
+{
+	// This must be added to any CSerializable derived class:
+	DEFINE_SERIALIZABLE(CHashedOctoMap, mrpt::maps)
+
+   public:
+	CHashedOctoMap(const double resolution = 0.10);	 //!< Default constructor
+	~CHashedOctoMap() override;	 //!< Destructor
+
+	void getAsOctoMapVoxels(
+		mrpt::opengl::COctoMapVoxels& gl_obj) const override;
+
+	MAP_DEFINITION_START(CHashedOctoMap)
+	double resolution{
+		0.10};	//!< The finest resolution of the octomap (default: 0.10
+	//! meters)
+	mrpt::maps::CHashedOctoMap::TInsertionOptions
+		insertionOpts;	//!< Observations insertion options
+	mrpt::maps::CHashedOctoMap::TLikelihoodOptions
+		likelihoodOpts;	 //!< Probabilistic observation likelihood options
+	MAP_DEFINITION_END(CHashedOctoMap)
+
+	/** Returns true if the map is empty/no observation has been inserted */
+	bool isEmpty() const override { return size() == 0; }
+
+	/** Read-only access to the underlying voxel storage */
+	const CHashedOcTree& getHashedOcTree() const;
+
+	/** @name Same methods than COctoMap
+	@{ */
+
+	/** Just like insertPointCloud but with a single ray. */
+	void insertRay(
+		const float end_x, const float end_y, const float end_z,
+		const float sensor_x, const float sensor_y, const float sensor_z);
+	/** Manually updates the occupancy of the voxel at (x,y,z) as being occupied
+	 * (true) or free (false), using the log-odds parameters in \a
+	 * insertionOptions */
+	void updateVoxel(
+		const double x, const double y, const double z, bool occupied);
+	/** Check whether the given point lies within the volume covered by the
+	 * map coordinates range (that is, whether it can be "mapped") */
+	bool isPointWithinOctoMap(
+		const float x, const float y, const float z) const;
+	double getResolution() const;
+	/// \return The number of observed voxels
+	size_t size() const;
+	/// \return Memory usage of the map in bytes (approximate)
+	size_t memoryUsage() const;
+	/// Size of the bounding box of all known space in meters
+	void getMetricSize(double& x, double& y, double& z) const;
+	/// minimum value of the bounding box of all known space in x, y, z
+	void getMetricMin(double& x, double& y, double& z) const;
+	/// maximum value of the bounding box of all known space in x, y, z
+	void getMetricMax(double& x, double& y, double& z) const;
+	/// Number of voxels (all of them are "leaves" in this engine)
+	size_t getNumLeafNodes() const { return size(); }
+
+	void setOccupancyThres(double prob) override;
+	void setProbHit(double prob) override;
+	void setProbMiss(double prob) override;
+	void setClampingThresMin(double thresProb) override;
+	void setClampingThresMax(double thresProb) override;
+	double getOccupancyThres() const override;
+	float getOccupancyThresLog() const override;
+	double getProbHit() const override;
+	float getProbHitLog() const override;
+	double getProbMiss() const override;
+	float getProbMissLog() const override;
+	double getClampingThresMin() const override;
+	float getClampingThresMinLog() const override;
+	double getClampingThresMax() const override;
+	float getClampingThresMaxLog() const override;
+	/** @} */
+
+   protected:
+	void internal_clear() override;
+	bool internal_insertObservation(
+		const mrpt::obs::CObservation& obs,
+		const std::optional<const mrpt::poses::CPose3D>& robotPose =
+			std::nullopt) override;
+};	// End of class def.
+}  // namespace mrpt::maps
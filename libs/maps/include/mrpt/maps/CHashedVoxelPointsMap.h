@@ -0,0 +1,286 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/config/CLoadableOptions.h>
+#include <mrpt/img/TColor.h>
+#include <mrpt/maps/CMetricMap.h>
+#include <mrpt/math/TPoint3D.h>
+#include <mrpt/obs/obs_frwds.h>
+#include <mrpt/serialization/CSerializable.h>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace mrpt::maps
+{
+class CPointsMap;
+
+/** A 3D point map where points are bucketed into a hash table of voxels,
+ * each one holding at most a small, fixed number of points.
+ *
+ * Compared to CSimplePointsMap and the other point maps, which keep unordered
+ * arrays of points with a KD-tree on top:
+ *  - The map is decimated online as points are inserted: a new point is
+ *    discarded if its voxel is full, or if it is closer than
+ *    `insertionOptions.minDistBetweenPoints` to a point already in the voxel.
+ *    There is no need of a separate filtering pass to keep the map density
+ *    bounded.
+ *  - There is no index to rebuild after insertions.
+ *  - Nearest neighbor queries only visit the voxels around the query point,
+ *    i.e. they take O(1) time for a bounded search radius: just 27 voxels if
+ *    the search radius is not larger than the voxel size.
+ *
+ * This makes it suitable as the reference map of scan matching (e.g. LiDAR
+ * odometry) with mrpt::slam::CICP::Align3DPDF(): implement
+ * determineMatching3D() against any CPointsMap, with the same parameters and
+ * parallel search than CPointsMap::determineMatching3D(). For the fastest
+ * queries, use a voxel size not smaller than the ICP correspondence
+ * distance thresholds.
+ *
+ * Points are stored in a single contiguous buffer, with a fixed-size slot
+ * of `maxPointsPerVoxel` points per voxel. The "index" of a point (e.g. in
+ * the mrpt::tfest::TMatchingPair::globalIdx field of correspondences) is the
+ * index of its slot, which remains valid as the map grows.
+ *
+ * It can be used in a CMultiMetricMap under the name `hashedVoxelPointsMap`.
+ *
+ * \sa CSimplePointsMap, CHashedOctoMap, CMetricMap
+ * \ingroup mrpt_maps_grp
+ */
+class CHashedVoxelPointsMap : public CMetricMap
+{
+	DEFINE_SERIALIZABLE(CHashedVoxelPointsMap, mrpt::maps)
+
+   public:
+	/** Bits per axis of the integer voxel coordinates within hash keys */
+	static constexpr unsigned int KEY_BITS = 21;
+	/** Integer voxel coordinates must be in the range [-KEY_OFFSET,
+	 * KEY_OFFSET) */
+	static constexpr int32_t KEY_OFFSET = 1 << (KEY_BITS - 1);
+
+	/** Constructor, with the voxel size (meters) and the maximum number of
+	 * points per voxel */
+	CHashedVoxelPointsMap(
+		double voxelSize = 0.20, uint32_t maxPointsPerVoxel = 16);
+
+	/** Changes the voxel size and the maximum number of points per voxel,
+	 * clearing the map. */
+	void setVoxelProperties(double voxelSize, uint32_t maxPointsPerVoxel);
+	double getVoxelSize() const { return m_voxelSize; }
+	uint32_t getMaxPointsPerVoxel() const { return m_maxPointsPerVoxel; }
+
+	/** Insertion options */
+	struct TInsertionOptions : public mrpt::config::CLoadableOptions
+	{
+		void loadFromConfigFile(
+			const mrpt::config::CConfigFileBase& source,
+			const std::string& section) override;  // See base docs
+		void dumpToTextStream(
+			std::ostream& out) const override;	// See base docs
+
+		void writeToStream(mrpt::serialization::CArchive& out) const;
+		void readFromStream(mrpt::serialization::CArchive& in);
+
+		/** New points closer than this distance (meters) to any point
+		 * already in their voxel are discarded. Use 0 to only limit the
+		 * number of points per voxel (default: 0.05 m) */
+		float minDistBetweenPoints{0.05f};
+
+		/** Points farther than this distance (meters) from the sensor are
+		 * ignored when inserting observations. Use <=0 for no limit
+		 * (default: -1) */
+		float maxRange{-1.0f};
+	};
+	TInsertionOptions insertionOptions;
+
+	/** Options used when evaluating "computeObservationLikelihood". Same
+	 * meaning than in CPointsMap::TLikelihoodOptions. */
+	struct TLikelihoodOptions : public mrpt::config::CLoadableOptions
+	{
+		void loadFromConfigFile(
+			const mrpt::config::CConfigFileBase& source,
+			const std::string& section) override;  // See base docs
+		void dumpToTextStream(
+			std::ostream& out) const override;	// See base docs
+
+		void writeToStream(mrpt::serialization::CArchive& out) const;
+		void readFromStream(mrpt::serialization::CArchive& in);
+
+		/** Sigma squared (variance, in meters) of the exponential used to
+		 * model the likelihood (default= 0.5^2 meters) */
+		double sigma_dist{0.0025};
+		/** Maximum distance in meters to consider for the numerator divided
+		 * by "sigma_dist" (default=1.0 meters) */
+		double max_corr_distance{1.0};
+		/** Only consider one out of N points (default=10) */
+		uint32_t decimation{10};
+	};
+	TLikelihoodOptions likelihoodOptions;
+
+	/** Rendering options, used in getVisualizationInto() */
+	struct TRenderOptions : public mrpt::config::CLoadableOptions
+	{
+		void loadFromConfigFile(
+			const mrpt::config::CConfigFileBase& source,
+			const std::string& section) override;  // See base docs
+		void dumpToTextStream(
+			std::ostream& out) const override;	// See base docs
+
+		float point_size{1.0f};
+		mrpt::img::TColorf color{.0f, .0f, 1.0f};
+	};
+	TRenderOptions renderOptions;
+
+	/** @name Insertion of points
+		@{ */
+
+	/** Inserts a point, unless discarded by the online decimation rules.
+	 * \return true if the point was inserted */
+	bool insertPoint(float x, float y, float z);
+	/// \overload
+	bool insertPoint(const mrpt::math::TPoint3Df& p)
+	{
+		return insertPoint(p.x, p.y, p.z);
+	}
+
+	/** Inserts all the points of \a otherMap, after transforming them with
+	 * \a otherPose.
+	 * \return The number of points actually inserted */
+	size_t insertAnotherMap(
+		const CPointsMap* otherMap, const mrpt::poses::CPose3D& otherPose);
+
+	/** @} */
+
+	/** @name Queries
+		@{ */
+
+	/** Number of points in the map */
+	size_t size() const { return m_numPoints; }
+	/** Number of non-empty voxels */
+	size_t getNumVoxels() const { return m_voxels.size(); }
+	bool isEmpty() const override { return m_numPoints == 0; }
+
+	/** Finds the closest point to \a query within \a maxDistance meters.
+	 * Only the voxels within that distance are visited.
+	 * \param[out] outPoint The closest point.
+	 * \param[out] outDistSqr Its squared distance to the query.
+	 * \param[out] outIdx Its index (see class description).
+	 * \return false if there are no points within \a maxDistance.
+	 */
+	bool nearestPoint(
+		const mrpt::math::TPoint3Df& query, float maxDistance,
+		mrpt::math::TPoint3Df& outPoint, float& outDistSqr,
+		size_t& outIdx) const;
+
+	/** Returns the point with the given index (see class description) */
+	const mrpt::math::TPoint3Df& getPointByIndex(size_t idx) const
+	{
+		return m_points[idx];
+	}
+
+	/** Calls `f(const TPoint3Df& pt)` for each point in the map */
+	template <class FUNCTOR>
+	void forEachPoint(FUNCTOR&& f) const
+	{
+		for (size_t v = 0; v < m_voxels.size(); v++)
+		{
+			const auto* pts = &m_points[v * m_maxPointsPerVoxel];
+			for (uint32_t i = 0; i < m_voxels[v].numPoints; i++)
+				f(pts[i]);
+		}
+	}
+
+	/** Copies all the points into a points map (which is not cleared) */
+	void getAsPointsMap(CPointsMap& outMap) const;
+
+	/** Integer coordinates of the voxel containing a point.
+	 * \return false if the point is out of the range of the map */
+	bool pointToVoxel(float x, float y, float z, int32_t key[3]) const;
+
+	/** @} */
+
+	// See docs in base class:
+	void determineMatching3D(
+		const mrpt::maps::CMetricMap* otherMap,
+		const mrpt::poses::CPose3D& otherMapPose,
+		mrpt::tfest::TMatchingPairList& correspondences,
+		const TMatchingParams& params,
+		TMatchingExtraResults& extraResults) const override;
+
+	// See docs in base class:
+	float compute3DMatchingRatio(
+		const mrpt::maps::CMetricMap* otherMap,
+		const mrpt::poses::CPose3D& otherMapPose,
+		const TMatchingRatioParams& params) const override;
+
+	/** Saves the points to a text file, one "X Y Z" line per point:
+	 * "filNamePrefix"+".txt" */
+	void saveMetricMapRepresentationToFile(
+		const std::string& filNamePrefix) const override;
+
+	void getVisualizationInto(
+		mrpt::opengl::CSetOfObjects& outObj) const override;
+
+	/** Returns a short description of the map. */
+	std::string asString() const override;
+
+	MAP_DEFINITION_START(CHashedVoxelPointsMap)
+	/** Voxel size (meters) (default: 0.20) */
+	double voxelSize{0.20};
+	/** Maximum number of points per voxel (default: 16) */
+	uint32_t maxPointsPerVoxel{16};
+	mrpt::maps::CHashedVoxelPointsMap::TInsertionOptions insertionOpts;
+	mrpt::maps::CHashedVoxelPointsMap::TLikelihoodOptions likelihoodOpts;
+	mrpt::maps::CHashedVoxelPointsMap::TRenderOptions renderOpts;
+	MAP_DEFINITION_END(CHashedVoxelPointsMap)
+
+   protected:
+	void internal_clear() override;
+	bool internal_insertObservation(
+		const mrpt::obs::CObservation& obs,
+		const std::optional<const mrpt::poses::CPose3D>& robotPose =
+			std::nullopt) override;
+	double internal_computeObservationLikelihood(
+		const mrpt::obs::CObservation& obs,
+		const mrpt::poses::CPose3D& takenFrom) const override;
+
+   private:
+	struct TVoxel
+	{
+		/** Hash key of the voxel coordinates */
+		uint64_t key = 0;
+		uint32_t numPoints = 0;
+	};
+
+	double m_voxelSize = 0.20;
+	float m_voxelSizeInv = 5.0f;
+	uint32_t m_maxPointsPerVoxel = 16;
+
+	/** Non-empty voxels, in creation order */
+	std::vector<TVoxel> m_voxels;
+	/** Points, in slots of m_maxPointsPerVoxel points per voxel */
+	std::vector<mrpt::math::TPoint3Df> m_points;
+	/** Voxel key -> index in m_voxels */
+	std::unordered_map<uint64_t, uint32_t> m_voxelIndex;
+	size_t m_numPoints = 0;
+
+	static uint64_t voxelKey(const int32_t key[3])
+	{
+		constexpr uint64_t mask = (uint64_t(1) << KEY_BITS) - 1;
+		return (uint64_t(key[0] + KEY_OFFSET) & mask) |
+			((uint64_t(key[1] + KEY_OFFSET) & mask) << KEY_BITS) |
+			((uint64_t(key[2] + KEY_OFFSET) & mask) << (2 * KEY_BITS));
+	}
+	/** \return nullptr if the voxel is empty */
+	const TVoxel* findVoxel(uint64_t key, size_t& voxelIdx) const;
+};
+
+}  // namespace mrpt::maps
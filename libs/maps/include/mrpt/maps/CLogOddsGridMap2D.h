@@ -38,6 +38,10 @@ struct CLogOddsGridMap2D : public detail::logoddscell_traits<TCELL>
 	 *  \param logodd_obs Observation of the cell, in log-odd form as
 	 * transformed by p2l.
 	 *  \param thres  This must be CELLTYPE_MIN+logodd_obs
+	 *  \param mapArray Contiguous, row-major array of cells. With
+	 * COccupancyGridMap2D::getRow(), only rows in the same band of
+	 * COccupancyGridMap2D::CELL_BAND_ROWS rows are contiguous, so `y` must
+	 * stay within that band; otherwise, use the overload taking a cell.
 	 * \sa updateCell, updateCell_fast_free
 	 */
 	inline static void updateCell_fast_occupied(
@@ -77,6 +81,8 @@ struct CLogOddsGridMap2D : public detail::logoddscell_traits<TCELL>
 	 *  \param logodd_obs Observation of the cell, in log-odd form as
 	 * transformed by p2l.
 	 *  \param thres  This must be CELLTYPE_MAX-logodd_obs
+	 *  \param mapArray Contiguous, row-major array of cells (see the same
+	 * parameter in updateCell_fast_occupied())
 	 * \sa updateCell_fast_occupied
 	 */
 	inline static void updateCell_fast_free(
@@ -207,6 +207,15 @@ class CMultiMetricMap : public mrpt::maps::CMetricMap
 		mrpt::tfest::TMatchingPairList& correspondences,
 		const mrpt::maps::TMatchingParams& params,
 		mrpt::maps::TMatchingExtraResults& extraResults) const override;
+	/** Forwards the matching to the only CHashedVoxelPointsMap in the
+	 * multi-map if there is one, or to its only CSimplePointsMap otherwise
+	 */
+	void determineMatching3D(
+		const mrpt::maps::CMetricMap* otherMap,
+		const mrpt::poses::CPose3D& otherMapPose,
+		mrpt::tfest::TMatchingPairList& correspondences,
+		const mrpt::maps::TMatchingParams& params,
+		mrpt::maps::TMatchingExtraResults& extraResults) const override;
 	float compute3DMatchingRatio(
 		const mrpt::maps::CMetricMap* otherMap,
 		const mrpt::poses::CPose3D& otherMapPose,
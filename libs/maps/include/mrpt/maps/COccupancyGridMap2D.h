@@ -12,6 +12,7 @@
 #include <mrpt/containers/CDynamicGrid.h>
 #include <mrpt/core/safe_pointers.h>
 #include <mrpt/img/CImage.h>
+#include <mrpt/maps/CDynamicVoronoi2D.h>
 #include <mrpt/maps/CLogOddsGridMap2D.h>
 #include <mrpt/maps/CLogOddsGridMapLUT.h>
 #include <mrpt/maps/CMetricMap.h>
@@ -24,8 +25,15 @@
 #include <mrpt/tfest/TMatchingPair.h>
 #include <mrpt/typemeta/TEnumType.h>
 
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <mutex>
+
 namespace mrpt::maps
 {
+class COccupancyGridMap2DSnapshot;
+
 /** A class for storing an occupancy grid map.
  *  COccupancyGridMap2D is a class for storing a metric map
  *   representation in the form of a probabilistic occupancy
@@ -71,17 +79,93 @@ class COccupancyGridMap2D
 	 * sonarSimulator() and laserScanSimulator(), or >1 to speed it up. */
 	static double RAYTRACE_STEP_SIZE_IN_CELL_UNITS;
 
+	/** Number of consecutive grid rows stored in each band: 2^CELL_BAND_LOG2.
+	 * Only the rows of one band are contiguous in memory, see getRow(). */
+	static constexpr unsigned int CELL_BAND_LOG2 = 5;
+	static constexpr unsigned int CELL_BAND_ROWS = 1U << CELL_BAND_LOG2;
+	static constexpr unsigned int CELL_BAND_MASK = CELL_BAND_ROWS - 1;
+
    protected:
+	friend class CDynamicVoronoi2D;
 	friend class CMultiMetricMap;
 	friend class CMultiMetricMapPDF;
+	friend class COccupancyGridMap2DSnapshot;
 
 	/** Frees the dynamic memory buffers of map. */
 	void freeMap();
 	/** Lookup tables for log-odds */
 	static CLogOddsGridMapLUT<cellType>& get_logodd_lut();
 
-	/** Store of cell occupancy values. Order: row by row, from left to right */
-	std::vector<cellType> m_map;
+	/** A band of CELL_BAND_ROWS consecutive full rows of the grid, row by
+	 * row, from left to right (the last band may have less rows) */
+	using cell_band_t = std::vector<cellType>;
+
+	/** Store of cell occupancy values, in bands of CELL_BAND_ROWS rows.
+	 * Bands are reference counted and shared between copies of the same map
+	 * (e.g. particles in RBPF SLAM after resampling) and with published
+	 * snapshots, and are only copied upon writing to them (copy-on-write).
+	 * All accesses must go through cellRow() (read) or cellRowForWrite()
+	 * (write).
+	 */
+	std::vector<std::shared_ptr<cell_band_t>> m_map;
+
+	/** Read-only pointer to the first cell of row `cy`. Cells of a row are
+	 * contiguous in memory, but consecutive rows may not be. No bound checks.
+	 */
+	inline const cellType* cellRow(unsigned int cy) const
+	{
+		return m_map[cy >> CELL_BAND_LOG2]->data() +
+			(cy & CELL_BAND_MASK) * m_size_x;
+	}
+
+	/** Writable pointer to the first cell of row `cy`, making a private copy
+	 * of its band first if it is shared with other maps. No bound checks. */
+	inline cellType* cellRowForWrite(unsigned int cy)
+	{
+		auto& band = m_map[cy >> CELL_BAND_LOG2];
+		// Maps sharing a band may be written to from different threads (e.g.
+		// RBPF particles): at worst, both copy it. A count of 1 can only be
+		// seen once the other owners dropped their references.
+		if (band.use_count() > 1) band = std::make_shared<cell_band_t>(*band);
+		else
+		{
+			// The count may have just dropped to 1 in another thread (e.g. a
+			// snapshot reader): make its reads happen before our writes.
+			std::atomic_thread_fence(std::memory_order_acquire);
+		}
+		m_cellBandStamps[cy >> CELL_BAND_LOG2] = m_cellWriteStamp.value;
+		return band->data() + (cy & CELL_BAND_MASK) * m_size_x;
+	}
+
+	/** Allocates the cell bands for the current m_size_x, m_size_y, with all
+	 * cells set to the given value. */
+	void allocCellBands(cellType value);
+
+	/** A number unique to each map object, renewed whenever the stamps of
+	 * the bands are looked at (see m_cellBandStamps), so it can be told
+	 * apart from all of them. */
+	struct TCellWriteStamp
+	{
+		TCellWriteStamp() : value(next()) {}
+		TCellWriteStamp(const TCellWriteStamp&) : value(next()) {}
+		TCellWriteStamp& operator=(const TCellWriteStamp&)
+		{
+			value = next();
+			return *this;
+		}
+		void renew() { value = next(); }
+		static uint64_t next();
+
+		uint64_t value;
+	};
+	mutable TCellWriteStamp m_cellWriteStamp;
+
+	/** For each band in m_map, the value of m_cellWriteStamp when it was last
+	 * written to, so observers of the cells (e.g. CDynamicVoronoi2D) can find
+	 * the bands modified since they looked at the stamps (and renewed
+	 * m_cellWriteStamp) without keeping references to the bands. */
+	std::vector<uint64_t> m_cellBandStamps;
+
 	/** The size of the grid in cells */
 	uint32_t m_size_x = 0, m_size_y = 0;
 	/** The limits of the grid in "units" (meters) */
@@ -89,12 +173,97 @@ class COccupancyGridMap2D
 	/** Cell size, i.e. resolution of the grid map. */
 	float m_resolution = 0;
 
+	/** A band of CELL_BAND_ROWS rows of the likelihood cache, with atomic
+	 * entries so it can be filled in from several threads at once */
+	struct TLikelihoodCacheBand
+	{
+		TLikelihoodCacheBand(size_t n, double value) : values(n)
+		{
+			for (auto& v : values)
+				v.store(value, std::memory_order_relaxed);
+		}
+		TLikelihoodCacheBand(const TLikelihoodCacheBand& o)
+			: values(o.values.size())
+		{
+			for (size_t i = 0; i < values.size(); i++)
+				values[i].store(
+					o.values[i].load(std::memory_order_relaxed),
+					std::memory_order_relaxed);
+		}
+
+		std::vector<std::atomic<double>> values;
+	};
+
 	/** Auxiliary variables to speed up the computation of observation
 	 * likelihood values for LF method among others, at a high cost in memory
-	 * (see TLikelihoodOptions::enableLikelihoodCache). */
-	mutable std::vector<double> m_precomputedLikelihood;
+	 * (see TLikelihoodOptions::enableLikelihoodCache).
+	 *
+	 * Like the cells, the cache is stored in bands of rows shared between
+	 * copies of the map, and a band is only copied when some of its entries
+	 * must be invalidated (copy-on-write). Bands are reset or invalidated
+	 * under `mtx`, so several threads can evaluate likelihoods at once (e.g.
+	 * the particles of a filter sharing the same grid). Filling in an entry
+	 * does not copy its band: maps sharing a band have the same cells around
+	 * its valid entries until each one invalidates (thus copies) the band
+	 * around the cells it modified. */
+	struct TLikelihoodCache
+	{
+		TLikelihoodCache() = default;
+		TLikelihoodCache(const TLikelihoodCache& o) { *this = o; }
+		TLikelihoodCache& operator=(const TLikelihoodCache& o)
+		{
+			if (&o == this) return *this;
+			std::scoped_lock lck(mtx, o.mtx);
+			bands = o.bands;
+			return *this;
+		}
+
+		mutable std::mutex mtx;
+		std::vector<std::shared_ptr<TLikelihoodCacheBand>> bands;
+	};
+	mutable TLikelihoodCache m_precomputedLikelihood;
+
+	/** The cache entry of cell (cx,cy). No bound checks. */
+	inline std::atomic<double>& likelihoodCacheEntry(
+		unsigned int cx, unsigned int cy) const
+	{
+		return m_precomputedLikelihood.bands[cy >> CELL_BAND_LOG2]
+			->values[(cy & CELL_BAND_MASK) * m_size_x + cx];
+	}
+
+	/** If true, the whole m_precomputedLikelihood must be reset */
 	mutable bool m_likelihoodCacheOutDated{true};
 
+	/** A rectangle of cell indices, used to keep track of the region of the
+	 * grid modified by observation insertions. */
+	struct TModifiedCellsArea
+	{
+		int min_cx = std::numeric_limits<int>::max();
+		int max_cx = std::numeric_limits<int>::min();
+		int min_cy = std::numeric_limits<int>::max();
+		int max_cy = std::numeric_limits<int>::min();
+
+		bool empty() const { return min_cx > max_cx || min_cy > max_cy; }
+		void clear() { *this = TModifiedCellsArea(); }
+		void extend(int cx0, int cx1, int cy0, int cy1)
+		{
+			min_cx = std::min(min_cx, cx0);
+			max_cx = std::max(max_cx, cx1);
+			min_cy = std::min(min_cy, cy0);
+			max_cy = std::max(max_cy, cy1);
+		}
+	};
+
+	/** Cells modified since the last update of m_precomputedLikelihood, so
+	 * only the affected neighborhood of the cache is invalidated, instead of
+	 * resetting it all (m_likelihoodCacheOutDated). */
+	mutable TModifiedCellsArea m_likelihoodCacheModifiedArea;
+
+	/** Marks the cells within the given rectangle (in map coordinates) as
+	 * modified, for the purpose of the likelihood cache. Must be called after
+	 * any resizeGrid() that could have changed cell indices. */
+	void markAreaAsModified(float x_min, float x_max, float y_min, float y_max);
+
 	/** Used for Voronoi calculation.Same struct as "map", but contains a "0" if
 	 * not a basis point. */
 	mrpt::containers::CDynamicGrid<uint8_t> m_basis_map;
@@ -105,9 +274,20 @@ class COccupancyGridMap2D
 	 * Voronoi diagram  */
 	mrpt::containers::CDynamicGrid<uint16_t> m_voronoi_diagram;
 
+	/** Distance map and Voronoi diagram maintained incrementally by
+	 * updateVoronoiDiagram() */
+	CDynamicVoronoi2D m_dynamic_voronoi;
+	/** Robot size (in 1/100 cells) of the last updateVoronoiDiagram(), or -1
+	 * if m_voronoi_diagram was not built by it and must be fully refilled. */
+	int m_voronoi_robot_size_units{-1};
+
 	/** True upon construction; used by isEmpty() */
 	bool m_is_empty{true};
 
+	/** The last published snapshot (nullptr if none). Always accessed via
+	 * std::atomic_load() / std::atomic_store(). \sa publishSnapshot() */
+	std::shared_ptr<const COccupancyGridMap2DSnapshot> m_snapshot;
+
 	/** See base class */
 	void OnPostSuccesfulInsertObs(const mrpt::obs::CObservation&) override;
 
@@ -128,18 +308,19 @@ class COccupancyGridMap2D
 	/** Change the contents [0,1] of a cell, given its index */
 	inline void setCell_nocheck(int x, int y, float value)
 	{
-		m_map[x + y * m_size_x] = p2l(value);
+		cellRowForWrite(y)[x] = p2l(value);
 	}
 
 	/** Read the real valued [0,1] contents of a cell, given its index */
 	inline float getCell_nocheck(int x, int y) const
 	{
-		return l2p(m_map[x + y * m_size_x]);
+		return l2p(cellRow(y)[x]);
 	}
 	/** Changes a cell by its absolute index (Do not use it normally) */
 	inline void setRawCell(unsigned int cellIndex, cellType b)
 	{
-		if (cellIndex < m_size_x * m_size_y) m_map[cellIndex] = b;
+		if (cellIndex < m_size_x * m_size_y)
+			cellRowForWrite(cellIndex / m_size_x)[cellIndex % m_size_x] = b;
 	}
 
 	/** One of the methods that can be selected for implementing
@@ -201,9 +382,17 @@ class COccupancyGridMap2D
 			std::nullopt) override;
 
    public:
-	/** Read-only access to the raw cell contents (cells are in log-odd units)
-	 */
-	const std::vector<cellType>& getRawMap() const { return this->m_map; }
+	/** Copies the raw cell contents (cells are in log-odd units), row by
+	 * row, into `out`. This is O(map size): use getRow() to access the cells
+	 * without copying them. */
+	void getRawMapCopy(std::vector<cellType>& out) const;
+
+	/** Returns the raw contents (in log-odd units) of a cell, without
+	 * checking its indices \sa getRow() */
+	inline cellType getRawCell_nocheck(unsigned int cx, unsigned int cy) const
+	{
+		return cellRow(cy)[cx];
+	}
 	/** Performs the Bayesian fusion of a new observation of a cell  \sa
 	 * updateInfoChangeOnly, updateCell_fast_occupied, updateCell_fast_free */
 	void updateCell(int x, int y, float v);
@@ -352,7 +541,7 @@ class COccupancyGridMap2D
 			static_cast<unsigned int>(y) >= m_size_y)
 			return;
 		else
-			m_map[x + y * m_size_x] = p2l(value);
+			cellRowForWrite(y)[x] = p2l(value);
 	}
 
 	/** Read the real valued [0,1] contents of a cell, given its index */
@@ -363,25 +552,31 @@ class COccupancyGridMap2D
 			static_cast<unsigned int>(y) >= m_size_y)
 			return 0.5f;
 		else
-			return l2p(m_map[x + y * m_size_x]);
+			return l2p(cellRow(y)[x]);
 	}
 
 	/** Access to a "row": mainly used for drawing grid as a bitmap efficiently,
-	 * do not use it normally */
+	 * do not use it normally. The cells of one row are contiguous in memory,
+	 * but different rows are not, in general: only the rows of the same band
+	 * of CELL_BAND_ROWS rows, i.e. with the same `cy >> CELL_BAND_LOG2`, are
+	 * consecutive. Do not use a row pointer to address rows of other bands.
+	 * \note This non-const version makes a private copy of the row (and its
+	 * neighbors) if it was shared with copies of this map. */
 	inline cellType* getRow(int cy)
 	{
 		if (cy < 0 || static_cast<unsigned int>(cy) >= m_size_y) return nullptr;
 		else
-			return &m_map[0 + cy * m_size_x];
+			return cellRowForWrite(cy);
 	}
 
 	/** Access to a "row": mainly used for drawing grid as a bitmap efficiently,
-	 * do not use it normally */
+	 * do not use it normally. The cells of one row are contiguous in memory,
+	 * but different rows are not, in general (see the non-const version). */
 	inline const cellType* getRow(int cy) const
 	{
 		if (cy < 0 || static_cast<unsigned int>(cy) >= m_size_y) return nullptr;
 		else
-			return &m_map[0 + cy * m_size_x];
+			return cellRow(cy);
 	}
 
 	/** Change the contents [0,1] of a cell, given its coordinates */
@@ -523,6 +718,10 @@ class COccupancyGridMap2D
 		/** Enabled: Rays widen with distance to approximate the real behavior
 		 * of lasers, disabled: insert rays as simple lines (Default=false) */
 		bool wideningBeamsWithDistance{false};
+		/** Versioned mode: if enabled, a new immutable snapshot is published
+		 * after each successful observation insertion, so other threads can
+		 * query the map via getSnapshot() without locking (Default=false) */
+		bool publishSnapshots{false};
 	};
 
 	/** With this struct options are provided to the observation insertion
@@ -644,6 +843,32 @@ class COccupancyGridMap2D
 
 	mutable TLikelihoodOutput likelihoodOutputs;
 
+	/** @name Lock-free concurrent read access (versioned snapshots)
+		@{ */
+
+	/** Creates a new immutable COccupancyGridMap2DSnapshot with the current
+	 * contents of the grid and atomically makes it the one returned by
+	 * getSnapshot(). No cell is copied: the snapshot shares the bands of
+	 * rows of the grid, which are only duplicated when the grid modifies
+	 * them afterwards. Hence, the cost is proportional to the number of
+	 * bands, and bands not modified between snapshots are shared by them.
+	 *
+	 * This is called automatically after each successful insertObservation()
+	 * if TInsertionOptions::publishSnapshots is enabled; call it manually
+	 * after modifying cells by other means (setCell(), updateCell(),...).
+	 * Must be called from the thread which modifies the map.
+	 */
+	void publishSnapshot();
+
+	/** Returns the latest snapshot published with publishSnapshot(), or an
+	 * empty pointer if none has been published yet. Safe to be called from
+	 * any thread at any time, even while the grid is being updated.
+	 * \sa COccupancyGridMap2DSnapshot
+	 */
+	std::shared_ptr<const COccupancyGridMap2DSnapshot> getSnapshot() const;
+
+	/** @} */
+
 	/** Performs a downsampling of the gridmap, by a given factor:
 	 * resolution/=ratio */
 	void subSample(int downRatio);
@@ -670,6 +895,34 @@ class COccupancyGridMap2D
 		float threshold, float robot_size, int x1 = 0, int x2 = 0, int y1 = 0,
 		int y2 = 0);
 
+	/** Builds or refreshes the Voronoi diagram of the grid map, returned by
+	 * getVoronoiDiagram() in the same format than buildVoronoiDiagram().
+	 *
+	 * The first call (and any call after the grid has been resized or the
+	 * threshold changed) computes the distance map from scratch, in parallel.
+	 * Subsequent calls only look for occupancy changes in the bands of rows
+	 * written to since the previous call, propagate them with a dynamic
+	 * brushfire algorithm (see CDynamicVoronoi2D), and refresh the diagram
+	 * only around the affected cells, which is much faster than
+	 * buildVoronoiDiagram() for maps being updated while navigating.
+	 *
+	 * Voronoi cells are those equidistant to two non-adjacent obstacles,
+	 * hence the diagram may slightly differ from that of
+	 * buildVoronoiDiagram().
+	 *
+	 * \param threshold The threshold for binarizing the map.
+	 * \param robot_size Size in "units" (meters) of robot, approx.
+	 * \sa getDynamicVoronoi(), findCriticalPoints
+	 */
+	void updateVoronoiDiagram(float threshold, float robot_size);
+
+	/** The distance map and Voronoi diagram maintained by
+	 * updateVoronoiDiagram() */
+	const CDynamicVoronoi2D& getDynamicVoronoi() const
+	{
+		return m_dynamic_voronoi;
+	}
+
 	/** Reads a the clearance of a cell (in centimeters), after building the
 	 * Voronoi diagram with \a buildVoronoiDiagram */
 	inline uint16_t getVoroniClearance(int cx, int cy) const
@@ -0,0 +1,189 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/maps/COccupancyGridMap2D.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace mrpt::maps
+{
+/** An immutable, versioned copy of the cells of a COccupancyGridMap2D, meant
+ * to be read from any number of threads without locking while the original
+ * grid keeps being updated by a mapping thread.
+ *
+ * Snapshots are created by COccupancyGridMap2D::publishSnapshot() (or
+ * automatically after each successful observation insertion if
+ * COccupancyGridMap2D::TInsertionOptions::publishSnapshots is enabled) and
+ * retrieved with COccupancyGridMap2D::getSnapshot(), which atomically returns
+ * a `std::shared_ptr` to the latest published version. A reader keeps using
+ * its snapshot for as long as it holds the smart pointer, no matter how many
+ * newer versions are published meanwhile.
+ *
+ * A snapshot shares the reference-counted bands of rows of the grid (see
+ * COccupancyGridMap2D::CELL_BAND_ROWS), so publishing a new version does not
+ * copy any cell: its cost only depends on the number of bands. The grid
+ * makes a private copy of a band the first time it modifies it after a
+ * snapshot is published (copy-on-write), so consecutive snapshots share all
+ * the bands not modified in between.
+ *
+ * All methods are `const` and do not touch any mutable state, hence they are
+ * safe to be invoked concurrently.
+ *
+ * \sa COccupancyGridMap2D
+ * \ingroup mrpt_maps_grp
+ */
+class COccupancyGridMap2DSnapshot
+{
+   public:
+	using Ptr = std::shared_ptr<const COccupancyGridMap2DSnapshot>;
+	using cellType = COccupancyGridMap2D::cellType;
+
+	/** Rows are stored in bands of BAND_ROWS consecutive rows */
+	static constexpr unsigned int BAND_LOG2 =
+		COccupancyGridMap2D::CELL_BAND_LOG2;
+	static constexpr unsigned int BAND_ROWS =
+		COccupancyGridMap2D::CELL_BAND_ROWS;
+	static constexpr unsigned int BAND_MASK =
+		COccupancyGridMap2D::CELL_BAND_MASK;
+
+	/** A band of BAND_ROWS full rows of the grid, row by row (the last one
+	 * may have less rows) */
+	using Band = std::vector<cellType>;
+	using BandPtr = std::shared_ptr<const Band>;
+
+	/** Builds a snapshot of the current contents of \a grid, sharing its
+	 * bands of cells. \a previous, if not nullptr, is the previous version
+	 * published by the same grid (only used for the epoch number).
+	 */
+	static Ptr Create(
+		const COccupancyGridMap2D& grid, const Ptr& previous = Ptr());
+
+	/** Monotonically increasing version number, starting at 1 for the first
+	 * snapshot published by a given grid map */
+	uint64_t epoch() const { return m_epoch; }
+
+	/** @name Grid geometry (same meaning than in COccupancyGridMap2D)
+		@{ */
+	unsigned int getSizeX() const { return m_size_x; }
+	unsigned int getSizeY() const { return m_size_y; }
+	float getXMin() const { return m_xMin; }
+	float getXMax() const { return m_xMax; }
+	float getYMin() const { return m_yMin; }
+	float getYMax() const { return m_yMax; }
+	float getResolution() const { return m_resolution; }
+
+	/** Transform a coordinate into a cell index. As in COccupancyGridMap2D,
+	 * the float and double versions may round differently. */
+	inline int x2idx(float x) const
+	{
+		return static_cast<int>((x - m_xMin) / m_resolution);
+	}
+	inline int y2idx(float y) const
+	{
+		return static_cast<int>((y - m_yMin) / m_resolution);
+	}
+	inline int x2idx(double x) const
+	{
+		return static_cast<int>((x - m_xMin) / m_resolution);
+	}
+	inline int y2idx(double y) const
+	{
+		return static_cast<int>((y - m_yMin) / m_resolution);
+	}
+	inline float idx2x(const size_t cx) const
+	{
+		return m_xMin + (cx + 0.5f) * m_resolution;
+	}
+	inline float idx2y(const size_t cy) const
+	{
+		return m_yMin + (cy + 0.5f) * m_resolution;
+	}
+	/** @} */
+
+	/** @name Cell access
+		@{ */
+
+	/** Read-only pointer to the first cell of row `cy`, without bound
+	 * checking. Only the rows of one band are contiguous in memory. */
+	inline const cellType* getRow(unsigned int cy) const
+	{
+		return m_bands[cy >> BAND_LOG2]->data() + (cy & BAND_MASK) * m_size_x;
+	}
+
+	/** Read the raw log-odds contents of a cell, without bound checking */
+	inline cellType getRawCell_nocheck(unsigned int cx, unsigned int cy) const
+	{
+		return getRow(cy)[cx];
+	}
+
+	/** Read the real valued [0,1] contents of a cell, given its index, or 0.5
+	 * if out of the grid */
+	inline float getCell(int cx, int cy) const
+	{
+		if (static_cast<unsigned int>(cx) >= m_size_x ||
+			static_cast<unsigned int>(cy) >= m_size_y)
+			return 0.5f;
+		return COccupancyGridMap2D::l2p(getRawCell_nocheck(cx, cy));
+	}
+
+	/** Read the real valued [0,1] contents of a cell, given its coordinates */
+	inline float getPos(float x, float y) const
+	{
+		return getCell(x2idx(x), y2idx(y));
+	}
+
+	/** \sa COccupancyGridMap2D::isStaticPos */
+	inline bool isStaticPos(float x, float y, float threshold = 0.7f) const
+	{
+		return getPos(x, y) <= threshold;
+	}
+
+	/** Direct read-only access to one band of rows (shared with the grid
+	 * and with other snapshots) */
+	const BandPtr& getBand(unsigned int band) const { return m_bands[band]; }
+
+	/** Copies all the cells into a row-major buffer, like
+	 * COccupancyGridMap2D::getRawMapCopy() */
+	void getRawMapCopy(std::vector<cellType>& out) const;
+
+	/** @} */
+
+	/** @name Queries
+		@{ */
+
+	/** Returns the clearance (distance to closest OCCUPIED cell), in meters.
+	 * Same algorithm than COccupancyGridMap2D::computeClearance(x,y,maxDist).
+	 */
+	float computeClearance(float x, float y, float maxSearchDistance) const;
+
+	/** Likelihood field (Thrun's) evaluation of a set of points, using the
+	 * given likelihood options. Same result than
+	 * COccupancyGridMap2D::computeLikelihoodField_Thrun(), but the
+	 * likelihood cache is never used since snapshots are immutable.
+	 */
+	double computeLikelihoodField_Thrun(
+		const CPointsMap& pm, const mrpt::poses::CPose2D* relativePose,
+		const COccupancyGridMap2D::TLikelihoodOptions& opts) const;
+
+	/** @} */
+
+   private:
+	COccupancyGridMap2DSnapshot() = default;
+
+	uint64_t m_epoch = 0;
+	uint32_t m_size_x = 0, m_size_y = 0;
+	float m_xMin = 0, m_xMax = 0, m_yMin = 0, m_yMax = 0;
+	float m_resolution = 0;
+	std::vector<BandPtr> m_bands;
+};
+
+}  // namespace mrpt::maps
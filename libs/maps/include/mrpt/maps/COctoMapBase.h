@@ -30,6 +30,10 @@ namespace mrpt::maps
  * To use octomap's iterators to go through the voxels, use
  * COctoMap::getOctomap()
  *
+ * The storage engine is given by the template arguments: COctoMap and
+ * CColouredOctoMap use the octomap library, while CHashedOctoMap uses the
+ * native, pooled voxel store mrpt::maps::CHashedOcTree.
+ *
  * The octomap library was presented in:
  *  - K. M. Wurm, A. Hornung, M. Bennewitz, C. Stachniss, and W. Burgard,
  *     <i>"OctoMap: A Probabilistic, Flexible, and Compact 3D Map Representation
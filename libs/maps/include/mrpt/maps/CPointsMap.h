@@ -25,7 +25,12 @@
 #include <mrpt/opengl/pointcloud_adapters.h>
 #include <mrpt/serialization/CSerializable.h>
 
+#include <deque>
 #include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <utility>
 
 // Add for declaration of mexplus::from template specialization
 DECLARE_MEXPLUS_FROM(mrpt::maps::CPointsMap)
@@ -410,6 +415,37 @@ class CPointsMap : public CMetricMap,
 	bool save3D_to_text_file(const std::string& file) const;
 	bool save3D_to_text_stream(std::ostream& out) const;
 
+	/** Saves the map to a binary file with the same structure-of-arrays
+	 * layout of the point buffers, written and read back in bulk. Much
+	 * faster than text or PLY files for large maps.
+	 *
+	 * File format (all numbers in little endian):
+	 *  - Header: magic "MRPTPTS1", uint64 number of points N, uint32 number
+	 *    of fields F.
+	 *  - F field descriptors: name (16 chars, zero-padded) and uint64 offset
+	 *    of its data from the beginning of the file.
+	 *  - F arrays of N floats, each one starting at an offset multiple of 64
+	 *    bytes. Each array is read with a single bulk call straight into the
+	 *    (aligned) point buffer; no memory-mapped reader is provided.
+	 *
+	 * Fields are "x", "y", "z", plus "intensity" in CPointsMapXYZI, and
+	 * "color_r", "color_g", "color_b" in CColouredPointsMap.
+	 *
+	 * \return false on any error
+	 * \sa loadFromBinaryFile()
+	 * \note [New in MRPT 2.5.5]
+	 */
+	bool saveToBinaryFile(const std::string& file) const;
+
+	/** Loads a file written by saveToBinaryFile(), replacing the current
+	 * contents of the map. Fields in the file not used by this class are
+	 * ignored. Fields of this class missing in the file get their default
+	 * values.
+	 * \return false on any error, e.g. a wrong file format.
+	 * \note [New in MRPT 2.5.5]
+	 */
+	bool loadFromBinaryFile(const std::string& file);
+
 	/** This virtual method saves the map to a file "filNamePrefix"+<
 	 * some_file_extension >, as an image or in any other applicable way (Notice
 	 * that other methods to save the map may be implemented in classes
@@ -654,7 +690,7 @@ class CPointsMap : public CMetricMap,
 	inline void insertPoint(float x, float y, float z = 0)
 	{
 		insertPointFast(x, y, z);
-		mark_as_modified();
+		mark_as_appended();
 	}
 	/// \overload
 	inline void insertPoint(const mrpt::math::TPoint3D& p)
@@ -971,6 +1007,63 @@ class CPointsMap : public CMetricMap,
 		const mrpt::math::TPoint3D& corner2, CPointsMap* outMap, double R = 1,
 		double G = 1, double B = 1);
 
+	/** @name Local surface geometry (normals and covariances)
+		@{ */
+
+	/** Local geometry of the surface around each point of the map, estimated
+	 * from its nearest neighbors. Used by point-to-plane and generalized ICP
+	 * (see mrpt::slam::CICP).
+	 * \sa getLocalGeometry() */
+	struct TLocalGeometry
+	{
+		/** Unit normal of the plane fitted to the neighborhood of each point
+		 * (with an arbitrary sign), or (0,0,0) if it could not be estimated.
+		 */
+		std::vector<mrpt::math::TPoint3Df> normals;
+		/** Covariance of each point for generalized ICP: the covariance of
+		 * its neighborhood, with eigenvalues replaced by (epsilon,1,1), i.e.
+		 * a thin disk along the local plane. The identity if it could not
+		 * be estimated. */
+		std::vector<mrpt::math::CMatrixFloat33> covariances;
+	};
+
+	/** Returns the local geometry (normals and covariances) of all points,
+	 * using the \a numNeighbors closest points (including itself) of each
+	 * one, and the given \a epsilon for the smallest eigenvalue of
+	 * covariances.
+	 *
+	 * Results are cached: they are computed only for points without them
+	 * (in parallel, with \a numThreads threads, or as many as hardware
+	 * threads if 0), and the cache is reset together with the KD-tree when
+	 * points are modified. Points appended at the end of the map (e.g. with
+	 * insertPoint() or insertAnotherMap()) do not reset the cache: only the
+	 * new points are estimated, while existing points keep their geometry.
+	 * Calling this with different \a numNeighbors or \a epsilon resets it.
+	 *
+	 * \note Thread-safe for concurrent calls, but the returned reference
+	 * is only valid until the map is modified.
+	 */
+	const TLocalGeometry& getLocalGeometry(
+		unsigned int numNeighbors = 10, float epsilon = 1e-3f,
+		unsigned int numThreads = 1) const;
+
+	/** @} */
+
+	/** Returns a voxel-downsampled version of this map, which keeps the first
+	 * point (in insertion order) of each voxel of size \a voxelSize (meters).
+	 * Used, for example, to build the levels of coarse-to-fine ICP (see
+	 * mrpt::slam::CICP::TConfigParams::pyramid_levels).
+	 *
+	 * Results are cached for the last few voxel sizes, and the cache is reset
+	 * together with the KD-tree when points are modified. Points appended at
+	 * the end of this map are added incrementally to the cached maps, so a
+	 * growing reference map is never downsampled from scratch again.
+	 *
+	 * \note Thread-safe for concurrent calls, but the returned reference
+	 * is only valid until this map is modified.
+	 */
+	const CPointsMap& getVoxelDecimated(float voxelSize) const;
+
 	/** @name Filter-by-height stuff
 		@{ */
 
@@ -1138,6 +1231,18 @@ class CPointsMap : public CMetricMap,
 		m_largestDistanceFromOriginIsUpdated = false;
 		m_boundingBoxIsUpdated = false;
 		kdtree_mark_as_outdated();
+		m_localGeometry.reset();
+		m_voxelDecimated.reset();
+	}
+
+	/** Like mark_as_modified(), for changes that only append new points at
+	 * the end of the map. With `kdtree_search_params.dynamic_index` enabled,
+	 * the KD-tree is then incrementally updated instead of rebuilt. */
+	inline void mark_as_appended() const
+	{
+		m_largestDistanceFromOriginIsUpdated = false;
+		m_boundingBoxIsUpdated = false;
+		kdtree_mark_as_appended();
 	}
 
 	/** Returns a short description of the map. */
@@ -1169,6 +1274,62 @@ class CPointsMap : public CMetricMap,
 	mutable bool m_boundingBoxIsUpdated;
 	mutable mrpt::math::TBoundingBoxf m_boundingBox;
 
+	/** Cache of getLocalGeometry(). Never copied along the points, like the
+	 * KD-tree. */
+	struct TLocalGeometryCache
+	{
+		TLocalGeometryCache() = default;
+		TLocalGeometryCache(const TLocalGeometryCache&) {}
+		TLocalGeometryCache& operator=(const TLocalGeometryCache& o)
+		{
+			if (&o != this) reset();
+			return *this;
+		}
+		void reset()
+		{
+			std::lock_guard<std::mutex> lck(mtx);
+			data.normals.clear();
+			data.covariances.clear();
+		}
+
+		std::mutex mtx;
+		TLocalGeometry data;
+		unsigned int numNeighbors = 0;
+		float epsilon = 0;
+	};
+	mutable TLocalGeometryCache m_localGeometry;
+
+	/** Cache of getVoxelDecimated(). Never copied along the points. */
+	struct TVoxelDecimatedCache
+	{
+		TVoxelDecimatedCache() = default;
+		TVoxelDecimatedCache(const TVoxelDecimatedCache&) {}
+		TVoxelDecimatedCache& operator=(const TVoxelDecimatedCache& o)
+		{
+			if (&o != this) reset();
+			return *this;
+		}
+		void reset()
+		{
+			std::lock_guard<std::mutex> lck(mtx);
+			levels.clear();
+		}
+
+		struct TLevel
+		{
+			float voxelSize = 0;
+			std::shared_ptr<CPointsMap> map;
+			/** Keys of the voxels with a point in "map" */
+			std::unordered_set<uint64_t> voxels;
+			/** Points of the source map already processed */
+			size_t numSourcePoints = 0;
+		};
+		std::mutex mtx;
+		/** Most recently used first */
+		std::deque<TLevel> levels;
+	};
+	mutable TVoxelDecimatedCache m_voxelDecimated;
+
 	/** This is a common version of CMetricMap::insertObservation() for point
 	 * maps (actually, CMetricMap::internal_insertObservation),
 	 *   so derived classes don't need to worry implementing that method unless
@@ -1183,6 +1344,17 @@ class CPointsMap : public CMetricMap,
 	/** Helper method for ::copyFrom() */
 	void base_copyFrom(const CPointsMap& obj);
 
+	/** A list of (name, buffer) of per-point float fields */
+	using field_buffers_t =
+		std::vector<std::pair<std::string, mrpt::aligned_std_vector<float>*>>;
+
+	/** Per-point fields other than x,y,z, for saveToBinaryFile() and
+	 * loadFromBinaryFile(). Derived classes append the name and buffer of
+	 * each of their float fields. */
+	virtual void getExtraFieldBuffers([[maybe_unused]] field_buffers_t& fields)
+	{
+	}
+
 	/** @name PLY Import virtual methods to implement in base classes
 		@{ */
 	/** In a base class, reserve memory to prepare subsequent calls to
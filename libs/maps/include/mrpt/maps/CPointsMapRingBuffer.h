@@ -0,0 +1,98 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/maps/CSimplePointsMap.h>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace mrpt::maps
+{
+/** A bounded pool of reusable CSimplePointsMap objects, to convert high-rate
+ * range scans into point clouds without heap allocations in steady state.
+ *
+ * next() hands out a map for the exclusive use of the caller, emptied but
+ * keeping the memory of its point buffers and its cache of sin/cos tables
+ * (see CSinCosLookUpTableFor2DScans). When the last reference to it is
+ * released, the map is returned to the pool, unless the pool already holds
+ * size() free maps, in which case it is destroyed. If there are no free maps,
+ * next() allocates a new one, so the caller never waits. Once the maps have
+ * grown to the size of the scans, loading a scan into them does not allocate
+ * memory.
+ *
+ * Maps may outlive the pool: if it is destroyed first, they are just deleted
+ * when released.
+ *
+ * The global Instance() is used by
+ * mrpt::obs::CObservation2DRangeScan::buildAuxPointsMap(). It keeps
+ * DEFAULT_GLOBAL_SIZE free maps by default; call `Instance().resize(n)` if
+ * more scans keep their cached point clouds alive at once, or
+ * `Instance().resize(0)` to allocate a new map for each scan.
+ *
+ * All methods are thread-safe.
+ *
+ * \sa CPointsMap::loadFromRangeScan()
+ * \ingroup mrpt_maps_grp
+ * \note [New in MRPT 2.5.5]
+ */
+class CPointsMapRingBuffer
+{
+   public:
+	/** Creates `numMaps` free maps, each one with memory reserved for
+	 * `reservePoints` points. */
+	explicit CPointsMapRingBuffer(
+		size_t numMaps = 16, size_t reservePoints = 0);
+
+	/** Returns an empty map, with default insertion options, for exclusive
+	 * use by the caller until it releases all its references to it. */
+	CSimplePointsMap::Ptr next();
+
+	/** Maximum number of free maps kept in the pool */
+	size_t size() const;
+
+	/** Number of maps handed out by next() and not released yet */
+	size_t checkedOutCount() const;
+
+	/** Changes the maximum number of free maps kept in the pool, destroying
+	 * or creating free maps as needed, and reserves memory for
+	 * `reservePoints` points in all free maps. Maps in use are not
+	 * affected. */
+	void resize(size_t numMaps, size_t reservePoints = 0);
+
+	/** Number of times next() had to allocate a new map since the creation
+	 * of this object (for statistics). */
+	size_t allocationCount() const;
+
+	/** Default size() of the global Instance() */
+	static constexpr size_t DEFAULT_GLOBAL_SIZE = 16;
+
+	/** The global pool, used by buildAuxPointsMap(). Its size is
+	 * DEFAULT_GLOBAL_SIZE unless changed by the user: resize it to at least
+	 * the number of scans whose cached point clouds are alive at once, e.g.
+	 * the number of scanners times the number of scans in the SLAM window.
+	 */
+	static CPointsMapRingBuffer& Instance();
+
+   private:
+	struct Impl
+	{
+		std::mutex mtx;
+		std::vector<std::unique_ptr<CSimplePointsMap>> freeMaps;
+		size_t maxFree = 0;
+		size_t checkedOut = 0;
+		size_t allocations = 0;
+	};
+	/** Shared with the deleters of the maps handed out, which return them
+	 * to the pool if it still exists */
+	std::shared_ptr<Impl> m_impl;
+};
+
+}  // namespace mrpt::maps
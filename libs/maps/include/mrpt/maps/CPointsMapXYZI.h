@@ -111,6 +111,11 @@ class CPointsMapXYZI : public CPointsMap
 	void addFrom_classSpecific(
 		const CPointsMap& anotherMap, const size_t nPreviousPoints,
 		const bool filterOutPointsAtZero) override;
+	// See base class
+	void getExtraFieldBuffers(field_buffers_t& fields) override
+	{
+		fields.emplace_back("intensity", &m_intensity);
+	}
 
 	// Friend methods:
 	template <class Derived>
@@ -0,0 +1,457 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "maps-precomp.h"  // Precomp header
+//
+#include <mrpt/core/lock_helper.h>
+#include <mrpt/maps/CChunkedPointsMap.h>
+#include <mrpt/serialization/CArchive.h>
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace mrpt::maps;
+using mrpt::math::TBoundingBoxf;
+using mrpt::math::TPoint3Df;
+
+namespace
+{
+constexpr char FILE_MAGIC[8] = {'M', 'R', 'P', 'T', 'C', 'H', 'P', 'M'};
+constexpr uint32_t FILE_VERSION = 1;
+// Offset of the "index offset" field in the header:
+constexpr uint64_t HEADER_INDEX_OFFSET_POS = 8 + 4 + 4;
+
+int32_t chunkCoord(float v, float chunkSize)
+{
+	const auto k = static_cast<int32_t>(std::floor(v / chunkSize));
+	if (!(k >= -CChunkedPointsMap::KEY_OFFSET &&
+		  k < CChunkedPointsMap::KEY_OFFSET))
+		THROW_EXCEPTION_FMT(
+			"Coordinate %f out of the range of chunks of size %f", v,
+			chunkSize);
+	return k;
+}
+
+void unpackChunkKey(uint64_t key, int32_t k[3])
+{
+	constexpr auto B = CChunkedPointsMap::KEY_BITS;
+	constexpr uint64_t mask = (uint64_t(1) << B) - 1;
+	for (unsigned int i = 0; i < 3; i++)
+		k[i] = static_cast<int32_t>((key >> (i * B)) & mask) -
+			CChunkedPointsMap::KEY_OFFSET;
+}
+}  // namespace
+
+// ----------------------------------------------------------------------------
+//  CChunkedPointsMapWriter
+// ----------------------------------------------------------------------------
+CChunkedPointsMapWriter::CChunkedPointsMapWriter(
+	const std::string& fileName, float chunkSize, size_t maxBufferedPoints)
+	: m_chunkSize(chunkSize), m_maxBufferedPoints(maxBufferedPoints)
+{
+	MRPT_START
+	ASSERT_GT_(chunkSize, 0.0f);
+	ASSERT_GT_(maxBufferedPoints, 0U);
+
+	if (!m_f.open(fileName, mrpt::io::OpenMode::TRUNCATE))
+		THROW_EXCEPTION_FMT("Cannot create file: `%s`", fileName.c_str());
+
+	// Header. The index offset is set in close():
+	m_f.Write(FILE_MAGIC, sizeof(FILE_MAGIC));
+	auto ar = mrpt::serialization::archiveFrom(m_f);
+	ar << FILE_VERSION << m_chunkSize << uint64_t(0);
+	MRPT_END
+}
+
+CChunkedPointsMapWriter::~CChunkedPointsMapWriter()
+{
+	try
+	{
+		close();
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "[~CChunkedPointsMapWriter] Error closing file:\n"
+				  << e.what() << std::endl;
+	}
+}
+
+void CChunkedPointsMapWriter::insertPoint(float x, float y, float z)
+{
+	ASSERTMSG_(!m_closed, "Cannot insert points after close()");
+
+	auto& b = m_buffers[CChunkedPointsMap::chunkKey(
+		chunkCoord(x, m_chunkSize), chunkCoord(y, m_chunkSize),
+		chunkCoord(z, m_chunkSize))];
+	b.x.push_back(x);
+	b.y.push_back(y);
+	b.z.push_back(z);
+	m_bbox.updateWithPoint({x, y, z});
+	m_numPoints++;
+
+	if (++m_numBuffered >= m_maxBufferedPoints) flush();
+}
+
+void CChunkedPointsMapWriter::insertPoints(const CPointsMap& m)
+{
+	const auto& xs = m.getPointsBufferRef_x();
+	const auto& ys = m.getPointsBufferRef_y();
+	const auto& zs = m.getPointsBufferRef_z();
+	for (size_t i = 0; i < xs.size(); i++)
+		insertPoint(xs[i], ys[i], zs[i]);
+}
+
+size_t CChunkedPointsMapWriter::insertPointsFromTextFile(
+	const std::string& fileName)
+{
+	MRPT_START
+	std::ifstream f(fileName);
+	if (!f.is_open())
+		THROW_EXCEPTION_FMT("Cannot open file: `%s`", fileName.c_str());
+
+	size_t n = 0;
+	std::string line;
+	while (std::getline(f, line))
+	{
+		std::istringstream ss(line);
+		float x, y, z = 0;
+		if (!(ss >> x >> y)) continue;	// Empty line, or comment
+		ss >> z;
+		insertPoint(x, y, z);
+		n++;
+	}
+	return n;
+	MRPT_END
+}
+
+void CChunkedPointsMapWriter::flush()
+{
+	auto ar = mrpt::serialization::archiveFrom(m_f);
+	for (auto& kv : m_buffers)
+	{
+		auto& b = kv.second;
+		if (b.x.empty()) continue;
+
+		m_fragments[kv.first].push_back(
+			{m_f.getPosition(), static_cast<uint32_t>(b.x.size())});
+		ar.WriteBufferFixEndianness(b.x.data(), b.x.size());
+		ar.WriteBufferFixEndianness(b.y.data(), b.y.size());
+		ar.WriteBufferFixEndianness(b.z.data(), b.z.size());
+	}
+	// Free the memory, since the next points may belong to other chunks:
+	m_buffers.clear();
+	m_numBuffered = 0;
+}
+
+void CChunkedPointsMapWriter::close()
+{
+	MRPT_START
+	if (m_closed) return;
+	m_closed = true;
+
+	flush();
+
+	// Index:
+	const uint64_t indexOffset = m_f.getPosition();
+	auto ar = mrpt::serialization::archiveFrom(m_f);
+	ar << uint64_t(m_numPoints) << m_bbox.min.x << m_bbox.min.y
+	   << m_bbox.min.z << m_bbox.max.x << m_bbox.max.y << m_bbox.max.z;
+	ar << static_cast<uint32_t>(m_fragments.size());
+	for (const auto& kv : m_fragments)
+	{
+		int32_t k[3];
+		unpackChunkKey(kv.first, k);
+		ar << k[0] << k[1] << k[2]
+		   << static_cast<uint32_t>(kv.second.size());
+		for (const auto& frag : kv.second)
+			ar << frag.offset << frag.count;
+	}
+
+	m_f.Seek(HEADER_INDEX_OFFSET_POS);
+	ar << indexOffset;
+	m_f.close();
+	m_fragments.clear();
+	MRPT_END
+}
+
+// ----------------------------------------------------------------------------
+//  CChunkedPointsMap
+// ----------------------------------------------------------------------------
+void CChunkedPointsMap::open(const std::string& fileName)
+{
+	MRPT_START
+	auto lck = mrpt::lockHelper(m_mtx);
+
+	m_index.clear();
+	m_lru.clear();
+	m_stats = TCacheStats();
+	m_f.close();
+
+	if (!m_f.open(fileName))
+		THROW_EXCEPTION_FMT("Cannot open file: `%s`", fileName.c_str());
+
+	char magic[sizeof(FILE_MAGIC)];
+	if (m_f.Read(magic, sizeof(magic)) != sizeof(magic) ||
+		std::memcmp(magic, FILE_MAGIC, sizeof(magic)) != 0)
+		THROW_EXCEPTION_FMT(
+			"Not a chunked point cloud file: `%s`", fileName.c_str());
+
+	auto ar = mrpt::serialization::archiveFrom(m_f);
+	uint32_t version;
+	uint64_t indexOffset;
+	ar >> version >> m_chunkSize >> indexOffset;
+	if (version != FILE_VERSION)
+		THROW_EXCEPTION_FMT(
+			"Unsupported file version %u in `%s`",
+			static_cast<unsigned>(version), fileName.c_str());
+	ASSERTMSG_(indexOffset != 0, "File was not properly closed");
+
+	m_f.Seek(indexOffset);
+	uint64_t numPoints;
+	ar >> numPoints >> m_bbox.min.x >> m_bbox.min.y >> m_bbox.min.z >>
+		m_bbox.max.x >> m_bbox.max.y >> m_bbox.max.z;
+	m_numPoints = numPoints;
+
+	uint32_t numChunks;
+	ar >> numChunks;
+	m_index.reserve(numChunks);
+	for (uint32_t i = 0; i < numChunks; i++)
+	{
+		int32_t k[3];
+		uint32_t numFrags;
+		ar >> k[0] >> k[1] >> k[2] >> numFrags;
+		auto& c = m_index[chunkKey(k[0], k[1], k[2])];
+		c.fragments.resize(numFrags);
+		for (auto& frag : c.fragments)
+		{
+			ar >> frag.offset >> frag.count;
+			c.numPoints += frag.count;
+		}
+	}
+	MRPT_END
+}
+
+bool CChunkedPointsMap::isOpen() const
+{
+	auto lck = mrpt::lockHelper(m_mtx);
+	return m_f.fileOpenCorrectly();
+}
+
+void CChunkedPointsMap::close()
+{
+	auto lck = mrpt::lockHelper(m_mtx);
+	m_f.close();
+	m_index.clear();
+	m_lru.clear();
+	m_stats = TCacheStats();
+	m_numPoints = 0;
+}
+
+void CChunkedPointsMap::convertFrom(
+	const CPointsMap& m, const std::string& fileName, float chunkSize,
+	size_t maxBufferedPoints)
+{
+	CChunkedPointsMapWriter w(fileName, chunkSize, maxBufferedPoints);
+	w.insertPoints(m);
+	w.close();
+}
+
+float CChunkedPointsMap::getChunkSize() const
+{
+	auto lck = mrpt::lockHelper(m_mtx);
+	return m_chunkSize;
+}
+
+size_t CChunkedPointsMap::size() const
+{
+	auto lck = mrpt::lockHelper(m_mtx);
+	return m_numPoints;
+}
+
+size_t CChunkedPointsMap::chunkCount() const
+{
+	auto lck = mrpt::lockHelper(m_mtx);
+	return m_index.size();
+}
+
+TBoundingBoxf CChunkedPointsMap::boundingBox() const
+{
+	auto lck = mrpt::lockHelper(m_mtx);
+	return m_bbox;
+}
+
+size_t CChunkedPointsMap::getMaxCachedPoints() const
+{
+	auto lck = mrpt::lockHelper(m_mtx);
+	return m_maxCachedPoints;
+}
+
+void CChunkedPointsMap::setMaxCachedPoints(size_t n)
+{
+	auto lck = mrpt::lockHelper(m_mtx);
+	m_maxCachedPoints = n;
+	evict();
+}
+
+CChunkedPointsMap::TCacheStats CChunkedPointsMap::getCacheStats() const
+{
+	auto lck = mrpt::lockHelper(m_mtx);
+	return m_stats;
+}
+
+CSimplePointsMap::ConstPtr CChunkedPointsMap::loadChunk(
+	uint64_t key, TChunk& c) const
+{
+	if (c.points)
+	{
+		// Move to the front of the LRU list:
+		m_lru.splice(m_lru.begin(), m_lru, c.lruIt);
+		m_stats.hits++;
+		return c.points;
+	}
+
+	m_stats.misses++;
+	auto m = CSimplePointsMap::Create();
+	m->reserve(c.numPoints);
+
+	auto ar = mrpt::serialization::archiveFrom(m_f);
+	std::vector<float> buf;
+	for (const auto& frag : c.fragments)
+	{
+		buf.resize(3 * frag.count);
+		m_f.Seek(frag.offset);
+		ar.ReadBufferFixEndianness(buf.data(), buf.size());
+		const float *xs = &buf[0], *ys = xs + frag.count,
+					*zs = ys + frag.count;
+		for (uint32_t i = 0; i < frag.count; i++)
+			m->insertPointFast(xs[i], ys[i], zs[i]);
+	}
+
+	c.points = m;
+	m_lru.push_front(key);
+	c.lruIt = m_lru.begin();
+	m_stats.cachedChunks++;
+	m_stats.cachedPoints += c.numPoints;
+	evict();
+	return m;
+}
+
+void CChunkedPointsMap::evict() const
+{
+	while (m_stats.cachedPoints > m_maxCachedPoints && m_lru.size() > 1)
+	{
+		auto& c = m_index.at(m_lru.back());
+		m_lru.pop_back();
+		c.points.reset();
+		m_stats.cachedChunks--;
+		m_stats.cachedPoints -= c.numPoints;
+	}
+}
+
+CSimplePointsMap::ConstPtr CChunkedPointsMap::getChunk(
+	int32_t ix, int32_t iy, int32_t iz) const
+{
+	auto lck = mrpt::lockHelper(m_mtx);
+	const uint64_t key = chunkKey(ix, iy, iz);
+	auto it = m_index.find(key);
+	if (it == m_index.end()) return {};
+	return loadChunk(key, it->second);
+}
+
+template <class FUNCTOR>
+void CChunkedPointsMap::forEachChunkIn(
+	const TBoundingBoxf& bbox, const FUNCTOR& f) const
+{
+	ASSERTMSG_(m_f.fileOpenCorrectly(), "No file is open");
+
+	// Do not iterate over empty space:
+	const auto box = bbox.intersection(m_bbox, 0.0f);
+	if (!box) return;
+
+	const int32_t k0[3] = {
+		chunkCoord(box->min.x, m_chunkSize),
+		chunkCoord(box->min.y, m_chunkSize),
+		chunkCoord(box->min.z, m_chunkSize)};
+	const int32_t k1[3] = {
+		chunkCoord(box->max.x, m_chunkSize),
+		chunkCoord(box->max.y, m_chunkSize),
+		chunkCoord(box->max.z, m_chunkSize)};
+
+	// Visit the index instead of the box if that is cheaper:
+	const size_t boxChunks = size_t(k1[0] - k0[0] + 1) *
+		size_t(k1[1] - k0[1] + 1) * size_t(k1[2] - k0[2] + 1);
+	if (boxChunks > m_index.size())
+	{
+		for (auto& kv : m_index)
+		{
+			int32_t k[3];
+			unpackChunkKey(kv.first, k);
+			bool inside = true;
+			for (int i = 0; i < 3; i++)
+				inside = inside && k[i] >= k0[i] && k[i] <= k1[i];
+			if (inside) f(*loadChunk(kv.first, kv.second));
+		}
+		return;
+	}
+
+	for (int32_t iz = k0[2]; iz <= k1[2]; iz++)
+		for (int32_t iy = k0[1]; iy <= k1[1]; iy++)
+			for (int32_t ix = k0[0]; ix <= k1[0]; ix++)
+			{
+				const uint64_t key = chunkKey(ix, iy, iz);
+				auto it = m_index.find(key);
+				if (it == m_index.end()) continue;
+				f(*loadChunk(key, it->second));
+			}
+}
+
+void CChunkedPointsMap::queryBoundingBox(
+	const TBoundingBoxf& bbox, CPointsMap& out) const
+{
+	MRPT_START
+	auto lck = mrpt::lockHelper(m_mtx);
+
+	forEachChunkIn(bbox, [&](const CSimplePointsMap& c) {
+		const auto& xs = c.getPointsBufferRef_x();
+		const auto& ys = c.getPointsBufferRef_y();
+		const auto& zs = c.getPointsBufferRef_z();
+		for (size_t i = 0; i < xs.size(); i++)
+			if (bbox.containsPoint({xs[i], ys[i], zs[i]}))
+				out.insertPoint(xs[i], ys[i], zs[i]);
+	});
+	MRPT_END
+}
+
+void CChunkedPointsMap::queryRadius(
+	const TPoint3Df& center, float radius, CPointsMap& out) const
+{
+	MRPT_START
+	ASSERT_GE_(radius, 0.0f);
+	auto lck = mrpt::lockHelper(m_mtx);
+
+	const TPoint3Df r(radius, radius, radius);
+	const float radius2 = radius * radius;
+	forEachChunkIn(
+		TBoundingBoxf(center - r, center + r), [&](const CSimplePointsMap& c) {
+			const auto& xs = c.getPointsBufferRef_x();
+			const auto& ys = c.getPointsBufferRef_y();
+			const auto& zs = c.getPointsBufferRef_z();
+			for (size_t i = 0; i < xs.size(); i++)
+			{
+				const float dx = xs[i] - center.x, dy = ys[i] - center.y,
+							dz = zs[i] - center.z;
+				if (dx * dx + dy * dy + dz * dz <= radius2)
+					out.insertPoint(xs[i], ys[i], zs[i]);
+			}
+		});
+	MRPT_END
+}
@@ -0,0 +1,163 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+#include <mrpt/maps/CChunkedPointsMap.h>
+#include <mrpt/maps/CSimplePointsMap.h>
+#include <mrpt/random/RandomGenerators.h>
+#include <mrpt/system/filesystem.h>
+
+#include <atomic>
+#include <fstream>
+#include <thread>
+
+using namespace mrpt::maps;
+using namespace mrpt::math;
+
+static CSimplePointsMap randomMap(size_t N)
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(1234);
+	CSimplePointsMap m;
+	for (size_t i = 0; i < N; i++)
+		m.insertPoint(
+			rng.drawUniform(-50.0f, 50.0f), rng.drawUniform(-50.0f, 50.0f),
+			rng.drawUniform(-2.0f, 3.0f));
+	return m;
+}
+
+TEST(CChunkedPointsMap, queries)
+{
+	const auto m = randomMap(20000);
+	const auto fil = mrpt::system::getTempFileName();
+	// Small buffers, to have several fragments per chunk:
+	CChunkedPointsMap::convertFrom(m, fil, 10.0f, 3000);
+
+	CChunkedPointsMap c(fil);
+	EXPECT_EQ(c.size(), m.size());
+	EXPECT_EQ(c.chunkCount(), 10U * 10U * 2U);
+	EXPECT_NEAR(c.boundingBox().min.x, m.boundingBox().min.x, 1e-6);
+	EXPECT_NEAR(c.boundingBox().max.z, m.boundingBox().max.z, 1e-6);
+
+	// Keep only a few chunks in memory:
+	c.setMaxCachedPoints(2000);
+
+	const TBoundingBoxf bbox({-12.0f, -3.0f, -1.0f}, {7.0f, 20.0f, 1.0f});
+	CSimplePointsMap inBox;
+	c.queryBoundingBox(bbox, inBox);
+
+	const TPoint3Df center(3.0f, 4.0f, 0.0f);
+	const float radius = 15.0f;
+	CSimplePointsMap inBall;
+	c.queryRadius(center, radius, inBall);
+
+	size_t expectedInBox = 0, expectedInBall = 0;
+	for (size_t i = 0; i < m.size(); i++)
+	{
+		float x, y, z;
+		m.getPoint(i, x, y, z);
+		if (bbox.containsPoint({x, y, z})) expectedInBox++;
+		if ((TPoint3Df(x, y, z) - center).sqrNorm() <= radius * radius)
+			expectedInBall++;
+	}
+	EXPECT_EQ(inBox.size(), expectedInBox);
+	EXPECT_EQ(inBall.size(), expectedInBall);
+	EXPECT_GT(expectedInBox, 0U);
+
+	const auto stats = c.getCacheStats();
+	EXPECT_LE(stats.cachedPoints, 2000U + 500U);
+	EXPECT_GT(stats.misses, 0U);
+
+	// A chunk already in use is not invalidated by evictions:
+	const auto chunk = c.getChunk(0, 0, 0);
+	ASSERT_TRUE(chunk);
+	const size_t chunkSize = chunk->size();
+	CSimplePointsMap all;
+	c.queryBoundingBox(c.boundingBox(), all);
+	EXPECT_EQ(all.size(), m.size());
+	EXPECT_EQ(chunk->size(), chunkSize);
+
+	// Chunk (0,0,0) holds the points in [0,10)x[0,10)x[0,10):
+	for (size_t i = 0; i < chunk->size(); i++)
+	{
+		float x, y, z;
+		chunk->getPoint(i, x, y, z);
+		EXPECT_TRUE(x >= 0 && x < 10 && y >= 0 && y < 10 && z >= 0);
+	}
+	EXPECT_FALSE(c.getChunk(100, 0, 0));
+
+	c.close();
+	mrpt::system::deleteFile(fil);
+}
+
+TEST(CChunkedPointsMap, concurrentQueries)
+{
+	const auto m = randomMap(20000);
+	const auto fil = mrpt::system::getTempFileName();
+	CChunkedPointsMap::convertFrom(m, fil, 10.0f);
+
+	CChunkedPointsMap c(fil);
+	// Force evictions while other threads are querying:
+	c.setMaxCachedPoints(1000);
+
+	CSimplePointsMap ref;
+	c.queryRadius({0.0f, 0.0f, 0.0f}, 20.0f, ref);
+
+	std::atomic<size_t> wrongResults{0};
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; t++)
+		threads.emplace_back([&, t]() {
+			for (int rep = 0; rep < 10; rep++)
+			{
+				CSimplePointsMap out;
+				c.queryRadius({0.0f, 0.0f, 0.0f}, 20.0f, out);
+				if (out.size() != ref.size()) wrongResults++;
+				// Move around, to keep loading and evicting chunks:
+				CSimplePointsMap other;
+				c.queryBoundingBox(
+					{{-50.0f + 10 * t, -50.0f, -2.0f},
+					 {-40.0f + 10 * t, 50.0f, 3.0f}},
+					other);
+			}
+		});
+	for (auto& th : threads)
+		th.join();
+
+	EXPECT_EQ(wrongResults.load(), 0U);
+	EXPECT_GT(ref.size(), 0U);
+	EXPECT_LE(c.getCacheStats().cachedPoints, 1000U + 500U);
+
+	c.close();
+	mrpt::system::deleteFile(fil);
+}
+
+TEST(CChunkedPointsMap, fromTextFile)
+{
+	const auto txtFile = mrpt::system::getTempFileName();
+	{
+		std::ofstream f(txtFile);
+		f << "1.0 2.0 3.0\n\n-4.0 5.0\n0.5 0.5 0.5 123\n";
+	}
+	const auto fil = mrpt::system::getTempFileName();
+	{
+		CChunkedPointsMapWriter w(fil, 1.0f);
+		EXPECT_EQ(w.insertPointsFromTextFile(txtFile), 3U);
+	}  // the dtor closes the file
+
+	CChunkedPointsMap c(fil);
+	EXPECT_EQ(c.size(), 3U);
+	EXPECT_EQ(c.chunkCount(), 3U);
+
+	CSimplePointsMap out;
+	c.queryRadius({-4.0f, 5.0f, 0.0f}, 0.1f, out);
+	EXPECT_EQ(out.size(), 1U);
+
+	mrpt::system::deleteFile(txtFile);
+	mrpt::system::deleteFile(fil);
+}
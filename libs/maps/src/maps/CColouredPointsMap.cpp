@@ -359,7 +359,7 @@ void CColouredPointsMap::insertPointRGB(
 	m_color_G.push_back(G);
 	m_color_B.push_back(B);
 
-	mark_as_modified();
+	mark_as_appended();
 }
 
 void CColouredPointsMap::getVisualizationInto(
@@ -0,0 +1,442 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "maps-precomp.h"  // Precomp header
+//
+#include <mrpt/core/exceptions.h>
+#include <mrpt/core/parallel_for.h>
+#include <mrpt/maps/CDynamicVoronoi2D.h>
+#include <mrpt/maps/COccupancyGridMap2D.h>
+
+#include <algorithm>
+
+using namespace mrpt::maps;
+
+namespace
+{
+// Rows or columns per block of the parallel loops:
+constexpr std::size_t LINES_PER_BLOCK = 16;
+
+constexpr int NEIGHBORS_DX[8] = {-1, 0, 1, -1, 1, -1, 0, 1};
+constexpr int NEIGHBORS_DY[8] = {-1, -1, -1, 0, 0, 1, 1, 1};
+
+}  // namespace
+
+void CDynamicVoronoi2D::clear()
+{
+	m_size_x = m_size_y = 0;
+	m_sqdist.clear();
+	m_obst.clear();
+	m_flags.clear();
+	m_queueing.clear();
+	m_open = decltype(m_open)();
+	m_touched.clear();
+	m_syncedBandStamps.clear();
+}
+
+void CDynamicVoronoi2D::syncBands(const COccupancyGridMap2D& grid)
+{
+	m_syncedBandStamps = grid.m_cellBandStamps;
+	grid.m_cellWriteStamp.renew();
+}
+
+void CDynamicVoronoi2D::initialize(
+	const COccupancyGridMap2D& grid, float freeThreshold,
+	std::size_t numThreads)
+{
+	MRPT_START
+
+	clear();
+	m_freeThreshold = freeThreshold;
+	m_size_x = grid.getSizeX();
+	m_size_y = grid.getSizeY();
+	syncBands(grid);
+
+	const std::size_t N = static_cast<std::size_t>(m_size_x) * m_size_y;
+	if (!N) return;
+	m_sqdist.assign(N, INVALID_DISTANCE);
+	m_obst.assign(N, -1);
+	m_flags.assign(N, 0);
+	m_queueing.assign(N, Q_LOWER_DONE);
+
+	const auto thresholdCellValue = COccupancyGridMap2D::p2l(freeThreshold);
+	const int W = static_cast<int>(m_size_x), H = static_cast<int>(m_size_y);
+
+	// Occupancy:
+	mrpt::parallelFor(
+		m_size_y, LINES_PER_BLOCK, numThreads,
+		[&](std::size_t y0, std::size_t y1) {
+			for (std::size_t cy = y0; cy < y1; cy++)
+			{
+				const auto* row = grid.getRow(static_cast<int>(cy));
+				for (unsigned int cx = 0; cx < m_size_x; cx++)
+					if (row[cx] < thresholdCellValue)
+						m_flags[idx(cx, cy)] = FLAG_OCCUPIED;
+			}
+		});
+
+	// Phase 1: for each column, vertical distance to the closest obstacle
+	// in that column, and its row:
+	std::vector<int32_t> colDist(N, INVALID_DISTANCE), colObstY(N, -1);
+	mrpt::parallelFor(
+		m_size_x, LINES_PER_BLOCK, numThreads,
+		[&](std::size_t x0, std::size_t x1) {
+			for (std::size_t cx = x0; cx < x1; cx++)
+			{
+				int last = -1;
+				for (int cy = 0; cy < H; cy++)
+				{
+					const std::size_t i = idx(cx, cy);
+					if (m_flags[i] & FLAG_OCCUPIED) last = cy;
+					if (last >= 0)
+					{
+						colDist[i] = cy - last;
+						colObstY[i] = last;
+					}
+				}
+				last = -1;
+				for (int cy = H - 1; cy >= 0; cy--)
+				{
+					const std::size_t i = idx(cx, cy);
+					if (m_flags[i] & FLAG_OCCUPIED) last = cy;
+					if (last >= 0 && last - cy < colDist[i])
+					{
+						colDist[i] = last - cy;
+						colObstY[i] = last;
+					}
+				}
+			}
+		});
+
+	// Phase 2: for each row, lower envelope of the parabolas
+	// (x-q)^2 + colDist(q)^2 of all columns q with some obstacle:
+	mrpt::parallelFor(
+		m_size_y, LINES_PER_BLOCK, numThreads,
+		[&](std::size_t y0, std::size_t y1) {
+			std::vector<int> v(W);
+			std::vector<double> z(W + 1);
+			std::vector<int64_t> f(W);
+			for (std::size_t cy = y0; cy < y1; cy++)
+			{
+				int k = -1;
+				for (int q = 0; q < W; q++)
+				{
+					const int32_t g = colDist[idx(q, cy)];
+					if (g == INVALID_DISTANCE) continue;
+					f[q] = int64_t(g) * g;
+					if (k < 0)
+					{
+						k = 0;
+						v[0] = q;
+						z[0] = -std::numeric_limits<double>::infinity();
+						z[1] = std::numeric_limits<double>::infinity();
+						continue;
+					}
+					double s;
+					for (;;)
+					{
+						const int p = v[k];
+						s = (double(f[q] + int64_t(q) * q) -
+							 double(f[p] + int64_t(p) * p)) /
+							(2.0 * (q - p));
+						if (s > z[k]) break;
+						k--;
+					}
+					k++;
+					v[k] = q;
+					z[k] = s;
+					z[k + 1] = std::numeric_limits<double>::infinity();
+				}
+				if (k < 0) continue;  // No obstacles at all
+
+				k = 0;
+				for (int cx = 0; cx < W; cx++)
+				{
+					while (z[k + 1] < cx)
+						k++;
+					const int q = v[k];
+					const std::size_t i = idx(cx, cy);
+					const int64_t d = int64_t(cx - q) * (cx - q) + f[q];
+					m_sqdist[i] = static_cast<int32_t>(
+						std::min<int64_t>(d, INVALID_DISTANCE - 1));
+					m_obst[i] =
+						static_cast<int32_t>(idx(q, colObstY[idx(q, cy)]));
+				}
+			}
+		});
+
+	// Voronoi layer: each cell only modifies itself, so rows are
+	// independent:
+	mrpt::parallelFor(
+		m_size_y, LINES_PER_BLOCK, numThreads,
+		[&](std::size_t y0, std::size_t y1) {
+			for (std::size_t cy = y0; cy < y1; cy++)
+				for (int cx = 0; cx < W; cx++)
+					updateVoronoiFlag(static_cast<int32_t>(idx(cx, cy)));
+		});
+
+	MRPT_END
+}
+
+std::size_t CDynamicVoronoi2D::update(const COccupancyGridMap2D& grid)
+{
+	MRPT_START
+
+	const auto& stamps = grid.m_cellBandStamps;
+	if (!isInitialized() || grid.getSizeX() != m_size_x ||
+		grid.getSizeY() != m_size_y ||
+		stamps.size() != m_syncedBandStamps.size())
+	{
+		initialize(grid, m_freeThreshold);
+		return static_cast<std::size_t>(m_size_x) * m_size_y;
+	}
+
+	// Bands written to since the last sync have a stamp different from the
+	// saved one, since the grid write stamp was renewed then:
+	const int lastX = static_cast<int>(m_size_x) - 1;
+	std::size_t nChanges = 0;
+	for (std::size_t b = 0; b < stamps.size(); b++)
+	{
+		if (stamps[b] == m_syncedBandStamps[b]) continue;
+		const auto y0 =
+			static_cast<int>(b << COccupancyGridMap2D::CELL_BAND_LOG2);
+		nChanges += findChanges(
+			grid, 0, lastX, y0, y0 + COccupancyGridMap2D::CELL_BAND_MASK);
+	}
+	syncBands(grid);
+
+	if (nChanges) propagate();
+	else
+		m_touched.clear();
+	return nChanges;
+
+	MRPT_END
+}
+
+std::size_t CDynamicVoronoi2D::update(
+	const COccupancyGridMap2D& grid, int x1, int x2, int y1, int y2)
+{
+	MRPT_START
+
+	if (!isInitialized() || grid.getSizeX() != m_size_x ||
+		grid.getSizeY() != m_size_y)
+	{
+		initialize(grid, m_freeThreshold);
+		return static_cast<std::size_t>(m_size_x) * m_size_y;
+	}
+
+	const std::size_t nChanges = findChanges(grid, x1, x2, y1, y2);
+	if (nChanges) propagate();
+	else
+		m_touched.clear();
+	return nChanges;
+
+	MRPT_END
+}
+
+std::size_t CDynamicVoronoi2D::findChanges(
+	const COccupancyGridMap2D& grid, int x1, int x2, int y1, int y2)
+{
+	x1 = std::max(0, x1);
+	y1 = std::max(0, y1);
+	x2 = std::min(x2, static_cast<int>(m_size_x) - 1);
+	y2 = std::min(y2, static_cast<int>(m_size_y) - 1);
+
+	const auto thresholdCellValue = COccupancyGridMap2D::p2l(m_freeThreshold);
+
+	std::size_t nChanges = 0;
+	for (int cy = y1; cy <= y2; cy++)
+	{
+		const auto* row = grid.getRow(cy);
+		for (int cx = x1; cx <= x2; cx++)
+		{
+			const bool occ = row[cx] < thresholdCellValue;
+			if (occ == isOccupied(cx, cy)) continue;
+			if (occ) setObstacle(cx, cy);
+			else
+				removeObstacle(cx, cy);
+			nChanges++;
+		}
+	}
+	return nChanges;
+}
+
+void CDynamicVoronoi2D::setObstacle(int cx, int cy)
+{
+	ASSERT_(static_cast<unsigned>(cx) < m_size_x);
+	ASSERT_(static_cast<unsigned>(cy) < m_size_y);
+
+	const auto i = static_cast<int32_t>(idx(cx, cy));
+	if (m_flags[i] & FLAG_OCCUPIED) return;
+
+	m_flags[i] = FLAG_OCCUPIED;
+	m_obst[i] = i;
+	m_sqdist[i] = 0;
+	m_queueing[i] = Q_LOWER_QUEUED;
+	m_open.emplace(0, i);
+}
+
+void CDynamicVoronoi2D::removeObstacle(int cx, int cy)
+{
+	ASSERT_(static_cast<unsigned>(cx) < m_size_x);
+	ASSERT_(static_cast<unsigned>(cy) < m_size_y);
+
+	const auto i = static_cast<int32_t>(idx(cx, cy));
+	if (!(m_flags[i] & FLAG_OCCUPIED)) return;
+
+	m_flags[i] = FLAG_RAISE;
+	m_obst[i] = -1;
+	m_sqdist[i] = INVALID_DISTANCE;
+	m_queueing[i] = Q_RAISE_QUEUED;
+	m_open.emplace(0, i);
+}
+
+void CDynamicVoronoi2D::propagate()
+{
+	m_touched.clear();
+	while (!m_open.empty())
+	{
+		const int32_t s = m_open.top().second;
+		m_open.pop();
+
+		// Outdated entry of a cell already lowered:
+		if (m_queueing[s] == Q_LOWER_DONE) continue;
+
+		if (m_flags[s] & FLAG_RAISE) raise(s);
+		else if (isValidObstacle(m_obst[s]))
+			lower(s);
+		else
+			continue;
+		m_touched.push_back(s);
+	}
+
+	// The Voronoi state depends on the closest obstacles of a cell and its
+	// neighbors: re-evaluate it around all cells whose obstacle changed.
+	for (const int32_t s : m_touched)
+	{
+		const int cx = s % m_size_x, cy = s / m_size_x;
+		updateVoronoiFlag(s);
+		for (int k = 0; k < 8; k++)
+		{
+			const int nx = cx + NEIGHBORS_DX[k], ny = cy + NEIGHBORS_DY[k];
+			if (static_cast<unsigned>(nx) < m_size_x &&
+				static_cast<unsigned>(ny) < m_size_y)
+				updateVoronoiFlag(static_cast<int32_t>(idx(nx, ny)));
+		}
+	}
+}
+
+void CDynamicVoronoi2D::raise(int32_t s)
+{
+	const int cx = s % m_size_x, cy = s / m_size_x;
+	for (int k = 0; k < 8; k++)
+	{
+		const int nx = cx + NEIGHBORS_DX[k], ny = cy + NEIGHBORS_DY[k];
+		if (static_cast<unsigned>(nx) >= m_size_x ||
+			static_cast<unsigned>(ny) >= m_size_y)
+			continue;
+		const auto n = static_cast<int32_t>(idx(nx, ny));
+		if (m_obst[n] < 0 || (m_flags[n] & FLAG_RAISE)) continue;
+
+		if (!isValidObstacle(m_obst[n]))
+		{
+			// Its closest obstacle is gone: keep raising
+			m_open.emplace(m_sqdist[n], n);
+			m_queueing[n] = Q_RAISE_QUEUED;
+			m_flags[n] |= FLAG_RAISE;
+			m_obst[n] = -1;
+			m_sqdist[n] = INVALID_DISTANCE;
+		}
+		else if (m_queueing[n] != Q_LOWER_QUEUED)
+		{
+			// Valid border of the raise wave: will lower the cells behind
+			m_open.emplace(m_sqdist[n], n);
+			m_queueing[n] = Q_LOWER_QUEUED;
+		}
+	}
+	m_flags[s] &= ~FLAG_RAISE;
+	m_queueing[s] = Q_RAISE_DONE;
+}
+
+void CDynamicVoronoi2D::lower(int32_t s)
+{
+	m_queueing[s] = Q_LOWER_DONE;
+
+	const int32_t os = m_obst[s];
+	const int cx = s % m_size_x, cy = s / m_size_x;
+	for (int k = 0; k < 8; k++)
+	{
+		const int nx = cx + NEIGHBORS_DX[k], ny = cy + NEIGHBORS_DY[k];
+		if (static_cast<unsigned>(nx) >= m_size_x ||
+			static_cast<unsigned>(ny) >= m_size_y)
+			continue;
+		const auto n = static_cast<int32_t>(idx(nx, ny));
+		if (m_flags[n] & FLAG_RAISE) continue;
+
+		const int32_t newSqDist = sqDistTo(n, os);
+		const bool overwrite = newSqDist < m_sqdist[n] ||
+			(newSqDist == m_sqdist[n] && !isValidObstacle(m_obst[n]));
+		if (!overwrite) continue;
+
+		m_open.emplace(newSqDist, n);
+		m_queueing[n] = Q_LOWER_QUEUED;
+		m_sqdist[n] = newSqDist;
+		m_obst[n] = os;
+	}
+}
+
+void CDynamicVoronoi2D::updateVoronoiFlag(int32_t s)
+{
+	m_flags[s] &= ~FLAG_VORONOI;
+	if (m_obst[s] < 0 || m_sqdist[s] <= 2) return;
+
+	const int cx = s % m_size_x, cy = s / m_size_x;
+	for (int k = 0; k < 8; k++)
+	{
+		const int nx = cx + NEIGHBORS_DX[k], ny = cy + NEIGHBORS_DY[k];
+		if (static_cast<unsigned>(nx) >= m_size_x ||
+			static_cast<unsigned>(ny) >= m_size_y)
+			continue;
+		if (isVoronoiPair(s, static_cast<int32_t>(idx(nx, ny))))
+		{
+			m_flags[s] |= FLAG_VORONOI;
+			return;
+		}
+	}
+}
+
+bool CDynamicVoronoi2D::isVoronoiPair(int32_t s, int32_t n) const
+{
+	const int32_t os = m_obst[s], on = m_obst[n];
+	if (os < 0 || on < 0) return false;
+
+	// Cells whose closest obstacles are neighbors (i.e. the same obstacle
+	// boundary) do not define a Voronoi edge:
+	if (std::abs(int32_t(os % m_size_x) - int32_t(on % m_size_x)) <= 1 &&
+		std::abs(int32_t(os / m_size_x) - int32_t(on / m_size_x)) <= 1)
+		return false;
+
+	// Mark the cell of the pair which is closest to the equidistance line:
+	const int32_t stability_s = sqDistTo(s, on) - m_sqdist[s];
+	if (stability_s < 0) return false;
+	const int32_t stability_n = sqDistTo(n, os) - m_sqdist[n];
+	if (stability_n < 0) return false;
+
+	return stability_s <= stability_n;
+}
+
+bool CDynamicVoronoi2D::getClosestObstacle(
+	unsigned int cx, unsigned int cy, int& obs_cx, int& obs_cy) const
+{
+	const int32_t o = m_obst[idx(cx, cy)];
+	if (o < 0) return false;
+	obs_cx = o % m_size_x;
+	obs_cy = o / m_size_x;
+	return true;
+}
@@ -0,0 +1,193 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+#include <mrpt/maps/CDynamicVoronoi2D.h>
+#include <mrpt/maps/COccupancyGridMap2D.h>
+#include <mrpt/random/RandomGenerators.h>
+
+#include <cmath>
+#include <vector>
+
+using namespace mrpt::maps;
+
+namespace
+{
+// Brute-force distance (in cells) to the closest occupied cell:
+float bruteForceDistance(const COccupancyGridMap2D& grid, int cx, int cy)
+{
+	int best = CDynamicVoronoi2D::INVALID_DISTANCE;
+	for (int y = 0; y < static_cast<int>(grid.getSizeY()); y++)
+		for (int x = 0; x < static_cast<int>(grid.getSizeX()); x++)
+			if (grid.getCell(x, y) < 0.5f)
+				best =
+					std::min(best, (x - cx) * (x - cx) + (y - cy) * (y - cy));
+	return best == CDynamicVoronoi2D::INVALID_DISTANCE
+		? std::numeric_limits<float>::infinity()
+		: std::sqrt(static_cast<float>(best));
+}
+
+void checkDistances(
+	const COccupancyGridMap2D& grid, const CDynamicVoronoi2D& dv,
+	float tolerance)
+{
+	ASSERT_EQ(dv.getSizeX(), grid.getSizeX());
+	ASSERT_EQ(dv.getSizeY(), grid.getSizeY());
+	for (unsigned int y = 0; y < grid.getSizeY(); y++)
+		for (unsigned int x = 0; x < grid.getSizeX(); x++)
+		{
+			EXPECT_EQ(dv.isOccupied(x, y), grid.getCell(x, y) < 0.5f);
+			EXPECT_NEAR(
+				dv.getDistance(x, y), bruteForceDistance(grid, x, y),
+				tolerance)
+				<< "cell: " << x << "," << y;
+		}
+}
+
+void addRandomObstacles(
+	COccupancyGridMap2D& grid, mrpt::random::CRandomGenerator& rng, int n)
+{
+	const int sx = grid.getSizeX(), sy = grid.getSizeY();
+	for (int i = 0; i < n; i++)
+	{
+		const int x = rng.drawUniform32bit() % sx;
+		const int y = rng.drawUniform32bit() % sy;
+		const int len = 1 + rng.drawUniform32bit() % 8;
+		for (int k = 0; k < len; k++)
+			grid.setCell(x + k, y, 0.0f);
+	}
+}
+
+}  // namespace
+
+TEST(CDynamicVoronoi2D, fullAndIncrementalUpdates)
+{
+	mrpt::random::CRandomGenerator rng(123);
+
+	COccupancyGridMap2D grid(-3.0f, 3.0f, -2.0f, 2.0f, 0.1f);
+	addRandomObstacles(grid, rng, 15);
+
+	CDynamicVoronoi2D dv;
+	dv.initialize(grid, 0.5f, 2 /*threads*/);
+	// Full rebuilds are exact:
+	checkDistances(grid, dv, 1e-4f);
+
+	for (int iter = 0; iter < 5; iter++)
+	{
+		// Add and remove some obstacles:
+		addRandomObstacles(grid, rng, 3);
+		for (int i = 0; i < 10; i++)
+			grid.setCell(
+				rng.drawUniform32bit() % grid.getSizeX(),
+				rng.drawUniform32bit() % grid.getSizeY(), 0.9f);
+
+		EXPECT_GT(dv.update(grid), 0U);
+		checkDistances(grid, dv, 0.5f);
+	}
+
+	// Remove all obstacles:
+	grid.fill(0.5f);
+	dv.update(grid);
+	for (unsigned int y = 0; y < grid.getSizeY(); y++)
+		for (unsigned int x = 0; x < grid.getSizeX(); x++)
+		{
+			EXPECT_FALSE(dv.isVoronoi(x, y));
+			EXPECT_EQ(
+				dv.getSquaredDistance(x, y),
+				CDynamicVoronoi2D::INVALID_DISTANCE);
+		}
+}
+
+TEST(CDynamicVoronoi2D, gridmapVoronoiDiagram)
+{
+	// A corridor between two walls, 2 m apart:
+	COccupancyGridMap2D grid(-5.0f, 5.0f, -2.0f, 2.0f, 0.1f);
+	for (float x = -4.0f; x <= 4.0f; x += 0.05f)
+	{
+		grid.setPos(x, -1.0f, 0.0f);
+		grid.setPos(x, 1.0f, 0.0f);
+	}
+
+	grid.updateVoronoiDiagram(0.5f, 0.3f);
+
+	// The Voronoi diagram runs along the corridor axis, with a clearance of
+	// ~1 m (10 cells, in 1/100 cell units):
+	const int cy = grid.y2idx(0.0f);
+	for (float x = -3.0f; x <= 3.0f; x += 0.5f)
+	{
+		const int cx = grid.x2idx(x);
+		const int clearance = std::max(
+			{grid.getVoroniClearance(cx, cy - 1),
+			 grid.getVoroniClearance(cx, cy),
+			 grid.getVoroniClearance(cx, cy + 1)});
+		EXPECT_NEAR(clearance, 1000, 100) << "x=" << x;
+	}
+
+	// Close the corridor: the diagram is updated incrementally.
+	for (float y = -1.0f; y <= 1.0f; y += 0.05f)
+		grid.setPos(0.0f, y, 0.0f);
+	grid.updateVoronoiDiagram(0.5f, 0.3f);
+
+	const auto& dv = grid.getDynamicVoronoi();
+	EXPECT_TRUE(dv.isOccupied(grid.x2idx(0.0f), cy));
+	EXPECT_NEAR(dv.getDistance(grid.x2idx(0.5f), cy), 5.0f, 0.5f);
+	EXPECT_EQ(grid.getVoroniClearance(grid.x2idx(0.0f), cy), 0);
+}
+
+TEST(CDynamicVoronoi2D, incrementalDiagramRefresh)
+{
+	mrpt::random::CRandomGenerator rng(321);
+
+	COccupancyGridMap2D grid(-4.0f, 4.0f, -4.0f, 4.0f, 0.1f);
+	addRandomObstacles(grid, rng, 20);
+	grid.updateVoronoiDiagram(0.5f, 0.2f);
+
+	// Nothing written to the grid, nothing to update:
+	grid.updateVoronoiDiagram(0.5f, 0.2f);
+	EXPECT_TRUE(grid.getDynamicVoronoi().getLastUpdatedCells().empty());
+
+	// The diagram keeps no references to the cells, so writing to them does
+	// not copy their band:
+	const auto& cgrid = grid;
+	const auto* row = cgrid.getRow(0);
+	grid.setCell(0, 0, grid.getCell(0, 0));
+	EXPECT_EQ(row, cgrid.getRow(0));
+
+	// Changes in a copy of the grid are found by the copy of the diagram:
+	{
+		COccupancyGridMap2D copy = grid;
+		copy.setCell(5, 5, grid.getCell(5, 5) < 0.5f ? 0.95f : 0.05f);
+		copy.updateVoronoiDiagram(0.5f, 0.2f);
+		EXPECT_FALSE(copy.getDynamicVoronoi().getLastUpdatedCells().empty());
+	}
+
+	const auto getDiagram = [&]() {
+		std::vector<uint16_t> d;
+		for (unsigned int y = 0; y < grid.getSizeY(); y++)
+			for (unsigned int x = 0; x < grid.getSizeX(); x++)
+				d.push_back(grid.getVoroniClearance(x, y));
+		return d;
+	};
+
+	for (int iter = 0; iter < 5; iter++)
+	{
+		addRandomObstacles(grid, rng, 2);
+		grid.setCell(
+			rng.drawUniform32bit() % grid.getSizeX(),
+			rng.drawUniform32bit() % grid.getSizeY(), 0.9f);
+		grid.updateVoronoiDiagram(0.5f, 0.2f);
+		const auto incremental = getDiagram();
+
+		// A different robot size forces refilling the whole diagram, from
+		// the same distance map:
+		grid.updateVoronoiDiagram(0.5f, 0.3f);
+		grid.updateVoronoiDiagram(0.5f, 0.2f);
+		EXPECT_EQ(incremental, getDiagram()) << "iter=" << iter;
+	}
+}
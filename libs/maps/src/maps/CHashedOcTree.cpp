@@ -0,0 +1,577 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "maps-precomp.h"  // Precomp header
+//
+#include <mrpt/core/exceptions.h>
+#include <mrpt/maps/CHashedOcTree.h>
+#include <mrpt/serialization/CArchive.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace mrpt::maps;
+using mrpt::math::TPoint3D;
+
+namespace
+{
+constexpr uint32_t KEY_MAX = (1U << CHashedOcTree::KEY_BITS) - 1;
+constexpr unsigned int VOXEL_BITS = 3 * CHashedOcTree::BLOCK_LOG2;
+constexpr uint64_t VOXEL_MASK = (uint64_t(1) << VOXEL_BITS) - 1;
+
+inline float logodds(double p)
+{
+	return static_cast<float>(std::log(p / (1 - p)));
+}
+inline double probability(double l) { return 1.0 - 1.0 / (1.0 + std::exp(l)); }
+
+// Spreads the lowest 21 bits of v so there are two zero bits between them:
+inline uint64_t spreadBits(uint64_t v)
+{
+	v &= 0x1fffff;
+	v = (v | v << 32) & 0x1f00000000ffffULL;
+	v = (v | v << 16) & 0x1f0000ff0000ffULL;
+	v = (v | v << 8) & 0x100f00f00f00f00fULL;
+	v = (v | v << 4) & 0x10c30c30c30c30c3ULL;
+	v = (v | v << 2) & 0x1249249249249249ULL;
+	return v;
+}
+inline uint32_t compactBits(uint64_t v)
+{
+	v &= 0x1249249249249249ULL;
+	v = (v ^ (v >> 2)) & 0x10c30c30c30c30c3ULL;
+	v = (v ^ (v >> 4)) & 0x100f00f00f00f00fULL;
+	v = (v ^ (v >> 8)) & 0x1f0000ff0000ffULL;
+	v = (v ^ (v >> 16)) & 0x1f00000000ffffULL;
+	v = (v ^ (v >> 32)) & 0x1fffffULL;
+	return static_cast<uint32_t>(v);
+}
+}  // namespace
+
+double CHashedOcTree::Voxel::getOccupancy() const
+{
+	return probability(logodds);
+}
+
+CHashedOcTree::CHashedOcTree(double resolution)
+{
+	setResolution(resolution);
+	// Default values from octomap:
+	setOccupancyThres(0.5);
+	setProbHit(0.7);
+	setProbMiss(0.4);
+	setClampingThresMin(0.1192);
+	setClampingThresMax(0.971);
+}
+
+void CHashedOcTree::setResolution(double resolution)
+{
+	ASSERT_GT_(resolution, 0);
+	clear();
+	m_resolution = resolution;
+	m_resolutionInv = 1.0 / resolution;
+}
+
+void CHashedOcTree::clear()
+{
+	m_blocks.clear();
+	m_blockIndex.clear();
+	m_numVoxels = 0;
+	m_keyMin.fill(0);
+	m_keyMax.fill(0);
+}
+
+uint64_t CHashedOcTree::mortonEncode(uint32_t kx, uint32_t ky, uint32_t kz)
+{
+	return spreadBits(kx) | (spreadBits(ky) << 1) | (spreadBits(kz) << 2);
+}
+
+void CHashedOcTree::mortonDecode(
+	uint64_t code, uint32_t& kx, uint32_t& ky, uint32_t& kz)
+{
+	kx = compactBits(code);
+	ky = compactBits(code >> 1);
+	kz = compactBits(code >> 2);
+}
+
+bool CHashedOcTree::coordToKey(
+	double x, double y, double z, uint32_t key[3]) const
+{
+	const double c[3] = {x, y, z};
+	for (int i = 0; i < 3; i++)
+	{
+		const double k = std::floor(c[i] * m_resolutionInv) + KEY_OFFSET;
+		if (!(k >= 0 && k <= KEY_MAX)) return false;  // (also catches NaNs)
+		key[i] = static_cast<uint32_t>(k);
+	}
+	return true;
+}
+
+bool CHashedOcTree::coordToCode(
+	double x, double y, double z, uint64_t& code) const
+{
+	uint32_t k[3];
+	if (!coordToKey(x, y, z, k)) return false;
+	code = mortonEncode(k[0], k[1], k[2]);
+	return true;
+}
+
+TPoint3D CHashedOcTree::codeToCoord(uint64_t code) const
+{
+	uint32_t kx, ky, kz;
+	mortonDecode(code, kx, ky, kz);
+	return {keyToCoord(kx), keyToCoord(ky), keyToCoord(kz)};
+}
+
+// Sensor model:
+void CHashedOcTree::setOccupancyThres(double prob)
+{
+	m_occupancyThresLog = logodds(prob);
+}
+void CHashedOcTree::setProbHit(double prob)
+{
+	ASSERT_GE_(prob, 0.5);
+	m_probHitLog = logodds(prob);
+}
+void CHashedOcTree::setProbMiss(double prob)
+{
+	ASSERT_LE_(prob, 0.5);
+	m_probMissLog = logodds(prob);
+}
+void CHashedOcTree::setClampingThresMin(double thresProb)
+{
+	m_clampingThresMinLog = logodds(thresProb);
+}
+void CHashedOcTree::setClampingThresMax(double thresProb)
+{
+	m_clampingThresMaxLog = logodds(thresProb);
+}
+double CHashedOcTree::getOccupancyThres() const
+{
+	return probability(m_occupancyThresLog);
+}
+double CHashedOcTree::getProbHit() const { return probability(m_probHitLog); }
+double CHashedOcTree::getProbMiss() const
+{
+	return probability(m_probMissLog);
+}
+double CHashedOcTree::getClampingThresMin() const
+{
+	return probability(m_clampingThresMinLog);
+}
+double CHashedOcTree::getClampingThresMax() const
+{
+	return probability(m_clampingThresMaxLog);
+}
+
+CHashedOcTree::Block& CHashedOcTree::getOrCreateBlock(uint64_t blockCode)
+{
+	const auto [it, isNew] = m_blockIndex.emplace(
+		blockCode, static_cast<uint32_t>(m_blocks.size()));
+	if (isNew)
+	{
+		m_blocks.emplace_back();
+		m_blocks.back().code = blockCode;
+	}
+	return m_blocks[it->second];
+}
+
+CHashedOcTree::Voxel& CHashedOcTree::getOrCreateVoxel(Block& b, uint64_t code)
+{
+	const auto i = static_cast<unsigned int>(code & VOXEL_MASK);
+	if (!b.isKnown(i))
+	{
+		b.known[i >> 6] |= uint64_t(1) << (i & 63);
+		b.voxels[i].logodds = 0;
+
+		uint32_t k[3];
+		mortonDecode(code, k[0], k[1], k[2]);
+		for (int j = 0; j < 3; j++)
+		{
+			if (!m_numVoxels || k[j] < m_keyMin[j]) m_keyMin[j] = k[j];
+			if (!m_numVoxels || k[j] > m_keyMax[j]) m_keyMax[j] = k[j];
+		}
+		m_numVoxels++;
+	}
+	return b.voxels[i];
+}
+
+void CHashedOcTree::applyUpdate(Voxel& v, float logodds_delta) const
+{
+	v.logodds = std::clamp(
+		v.logodds + logodds_delta, m_clampingThresMinLog,
+		m_clampingThresMaxLog);
+}
+
+void CHashedOcTree::updateNodeLogOdds(uint64_t code, float logodds_delta)
+{
+	Block& b = getOrCreateBlock(code >> VOXEL_BITS);
+	applyUpdate(getOrCreateVoxel(b, code), logodds_delta);
+}
+
+bool CHashedOcTree::updateNode(double x, double y, double z, bool occupied)
+{
+	uint64_t code;
+	if (!coordToCode(x, y, z, code)) return false;
+	updateNodeLogOdds(code, occupied ? m_probHitLog : m_probMissLog);
+	return true;
+}
+
+bool CHashedOcTree::computeRayCodes(
+	const TPoint3D& origin, const TPoint3D& end,
+	std::vector<uint64_t>& codes) const
+{
+	uint32_t cur[3], keyEnd[3];
+	if (!coordToKey(origin.x, origin.y, origin.z, cur) ||
+		!coordToKey(end.x, end.y, end.z, keyEnd))
+		return false;
+
+	if (cur[0] == keyEnd[0] && cur[1] == keyEnd[1] && cur[2] == keyEnd[2])
+		return true;  // same voxel: nothing to do
+
+	codes.push_back(mortonEncode(cur[0], cur[1], cur[2]));
+
+	const double o[3] = {origin.x, origin.y, origin.z};
+	double dir[3] = {end.x - origin.x, end.y - origin.y, end.z - origin.z};
+	const double length =
+		std::sqrt(dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2]);
+	for (double& d : dir)
+		d /= length;
+
+	int step[3];
+	double tMax[3], tDelta[3];
+	for (int i = 0; i < 3; i++)
+	{
+		step[i] = dir[i] > 0 ? 1 : (dir[i] < 0 ? -1 : 0);
+		if (step[i] != 0)
+		{
+			// Corner of the voxel, in the direction of the ray:
+			const double voxelBorder =
+				keyToCoord(cur[i]) + step[i] * m_resolution * 0.5;
+			tMax[i] = (voxelBorder - o[i]) / dir[i];
+			tDelta[i] = m_resolution / std::abs(dir[i]);
+		}
+		else
+		{
+			tMax[i] = std::numeric_limits<double>::max();
+			tDelta[i] = std::numeric_limits<double>::max();
+		}
+	}
+
+	for (;;)
+	{
+		int dim;
+		if (tMax[0] < tMax[1]) dim = tMax[0] < tMax[2] ? 0 : 2;
+		else
+			dim = tMax[1] < tMax[2] ? 1 : 2;
+
+		cur[dim] += step[dim];
+		tMax[dim] += tDelta[dim];
+
+		if (cur[0] == keyEnd[0] && cur[1] == keyEnd[1] && cur[2] == keyEnd[2])
+			break;
+		// Past the end point, in world coordinates?
+		if (std::min({tMax[0], tMax[1], tMax[2]}) > length) break;
+
+		codes.push_back(mortonEncode(cur[0], cur[1], cur[2]));
+	}
+	return true;
+}
+
+void CHashedOcTree::insertPointCloud(
+	const float* xs, const float* ys, const float* zs, std::size_t N,
+	const point3d& sensor, double maxrange)
+{
+	MRPT_START
+
+	// 1) Gather the voxels of all rays:
+	m_freeCodes.clear();
+	m_occupiedCodes.clear();
+
+	const TPoint3D origin(sensor);
+	for (std::size_t i = 0; i < N; i++)
+	{
+		const TPoint3D p(xs[i], ys[i], zs[i]);
+		const TPoint3D delta = p - origin;
+		const double dist = delta.norm();
+		if (maxrange < 0 || dist <= maxrange)
+		{
+			computeRayCodes(origin, p, m_freeCodes);
+			uint64_t code;
+			if (coordToCode(p.x, p.y, p.z, code))
+				m_occupiedCodes.push_back(code);
+		}
+		else
+		{
+			// Truncated ray: only the free space is updated
+			computeRayCodes(
+				origin, origin + delta * (maxrange / dist), m_freeCodes);
+		}
+	}
+
+	// 2) Sort in Morton order, which groups voxels by block, and remove
+	// duplicates, so each voxel is updated at most once per scan:
+	const auto sortUnique = [](std::vector<uint64_t>& v) {
+		std::sort(v.begin(), v.end());
+		v.erase(std::unique(v.begin(), v.end()), v.end());
+	};
+	sortUnique(m_occupiedCodes);
+	sortUnique(m_freeCodes);
+
+	// 3) Apply updates, with one block lookup per run of voxels in the same
+	// block. Occupied voxels have preference over free ones:
+	uint64_t curBlockCode = std::numeric_limits<uint64_t>::max();
+	Block* b = nullptr;
+	const auto voxelFor = [&](uint64_t code) -> Voxel& {
+		const uint64_t blockCode = code >> VOXEL_BITS;
+		if (blockCode != curBlockCode)
+		{
+			b = &getOrCreateBlock(blockCode);
+			curBlockCode = blockCode;
+		}
+		return getOrCreateVoxel(*b, code);
+	};
+
+	for (const uint64_t code : m_occupiedCodes)
+		applyUpdate(voxelFor(code), m_probHitLog);
+
+	auto itOcc = m_occupiedCodes.cbegin();
+	const auto itOccEnd = m_occupiedCodes.cend();
+	for (const uint64_t code : m_freeCodes)
+	{
+		while (itOcc != itOccEnd && *itOcc < code)
+			++itOcc;
+		if (itOcc != itOccEnd && *itOcc == code) continue;
+		applyUpdate(voxelFor(code), m_probMissLog);
+	}
+
+	MRPT_END
+}
+
+void CHashedOcTree::insertRay(
+	const point3d& origin, const point3d& end, double maxrange)
+{
+	insertPointCloud(&end.x, &end.y, &end.z, 1, origin, maxrange);
+}
+
+const CHashedOcTree::Voxel* CHashedOcTree::search(uint64_t code) const
+{
+	const auto it = m_blockIndex.find(code >> VOXEL_BITS);
+	if (it == m_blockIndex.end()) return nullptr;
+	const Block& b = m_blocks[it->second];
+	const auto i = static_cast<unsigned int>(code & VOXEL_MASK);
+	return b.isKnown(i) ? &b.voxels[i] : nullptr;
+}
+
+const CHashedOcTree::Voxel* CHashedOcTree::search(
+	double x, double y, double z) const
+{
+	uint64_t code;
+	if (!coordToCode(x, y, z, code)) return nullptr;
+	return search(code);
+}
+
+bool CHashedOcTree::castRay(
+	const TPoint3D& origin, const TPoint3D& direction, TPoint3D& end,
+	bool ignoreUnknownCells, double maxRange) const
+{
+	uint32_t cur[3];
+	if (!coordToKey(origin.x, origin.y, origin.z, cur)) return false;
+
+	const auto curCode = [&]() {
+		return mortonEncode(cur[0], cur[1], cur[2]);
+	};
+	const auto curCenter = [&]() {
+		return TPoint3D(
+			keyToCoord(cur[0]), keyToCoord(cur[1]), keyToCoord(cur[2]));
+	};
+
+	if (const Voxel* v = search(curCode()); v)
+	{
+		if (isOccupied(*v))
+		{
+			end = curCenter();
+			return true;
+		}
+	}
+	else if (!ignoreUnknownCells)
+	{
+		end = curCenter();
+		return false;
+	}
+	if (!m_numVoxels) return false;
+
+	const double norm = direction.norm();
+	ASSERT_GT_(norm, 0);
+	const double o[3] = {origin.x, origin.y, origin.z};
+	const double dir[3] = {
+		direction.x / norm, direction.y / norm, direction.z / norm};
+
+	int step[3];
+	double tMax[3], tDelta[3];
+	for (int i = 0; i < 3; i++)
+	{
+		step[i] = dir[i] > 0 ? 1 : (dir[i] < 0 ? -1 : 0);
+		if (step[i] != 0)
+		{
+			const double voxelBorder =
+				keyToCoord(cur[i]) + step[i] * m_resolution * 0.5;
+			tMax[i] = (voxelBorder - o[i]) / dir[i];
+			tDelta[i] = m_resolution / std::abs(dir[i]);
+		}
+		else
+		{
+			tMax[i] = std::numeric_limits<double>::max();
+			tDelta[i] = std::numeric_limits<double>::max();
+		}
+	}
+
+	const bool maxRangeSet = maxRange > 0;
+	const double maxRangeSq = maxRange * maxRange;
+
+	for (;;)
+	{
+		int dim;
+		if (tMax[0] < tMax[1]) dim = tMax[0] < tMax[2] ? 0 : 2;
+		else
+			dim = tMax[1] < tMax[2] ? 1 : 2;
+
+		// Leaving the map range?
+		if ((step[dim] < 0 && cur[dim] == 0) ||
+			(step[dim] > 0 && cur[dim] == KEY_MAX))
+		{
+			end = curCenter();
+			return false;
+		}
+		cur[dim] += step[dim];
+		tMax[dim] += tDelta[dim];
+		end = curCenter();
+
+		if (maxRangeSet && (end - origin).sqrNorm() > maxRangeSq)
+			return false;
+
+		// Moving away from the bounding box of known voxels? Then there is
+		// nothing else to hit:
+		for (int i = 0; i < 3; i++)
+			if ((cur[i] < m_keyMin[i] && step[i] <= 0) ||
+				(cur[i] > m_keyMax[i] && step[i] >= 0))
+				return false;
+
+		if (const Voxel* v = search(curCode()); v)
+		{
+			if (isOccupied(*v)) return true;
+		}
+		else if (!ignoreUnknownCells)
+			return false;
+	}
+}
+
+std::size_t CHashedOcTree::memoryUsage() const
+{
+	// Approximate cost of each hash table entry, incl. the node allocation:
+	const std::size_t hashEntry =
+		sizeof(std::pair<const uint64_t, uint32_t>) + 2 * sizeof(void*);
+	return sizeof(*this) + m_blocks.capacity() * sizeof(Block) +
+		m_blockIndex.size() * hashEntry +
+		m_blockIndex.bucket_count() * sizeof(void*) +
+		(m_freeCodes.capacity() + m_occupiedCodes.capacity()) *
+		sizeof(uint64_t);
+}
+
+void CHashedOcTree::getMetricMin(double& x, double& y, double& z) const
+{
+	if (!m_numVoxels)
+	{
+		x = y = z = 0;
+		return;
+	}
+	const double h = 0.5 * m_resolution;
+	x = keyToCoord(m_keyMin[0]) - h;
+	y = keyToCoord(m_keyMin[1]) - h;
+	z = keyToCoord(m_keyMin[2]) - h;
+}
+
+void CHashedOcTree::getMetricMax(double& x, double& y, double& z) const
+{
+	if (!m_numVoxels)
+	{
+		x = y = z = 0;
+		return;
+	}
+	const double h = 0.5 * m_resolution;
+	x = keyToCoord(m_keyMax[0]) + h;
+	y = keyToCoord(m_keyMax[1]) + h;
+	z = keyToCoord(m_keyMax[2]) + h;
+}
+
+void CHashedOcTree::writeToStream(mrpt::serialization::CArchive& out) const
+{
+	const int8_t version = 0;
+	out << version;
+	out << m_resolution << getOccupancyThres() << getProbHit()
+		<< getProbMiss() << getClampingThresMin() << getClampingThresMax();
+
+	out.WriteAs<uint32_t>(m_blocks.size());
+	std::array<float, BLOCK_VOXELS> logodds;
+	for (const Block& b : m_blocks)
+	{
+		out << b.code;
+		out.WriteBufferFixEndianness(b.known.data(), b.known.size());
+		for (unsigned int i = 0; i < BLOCK_VOXELS; i++)
+			logodds[i] = b.voxels[i].logodds;
+		out.WriteBufferFixEndianness(logodds.data(), logodds.size());
+	}
+}
+
+void CHashedOcTree::readFromStream(mrpt::serialization::CArchive& in)
+{
+	int8_t version;
+	in >> version;
+	switch (version)
+	{
+		case 0:
+		{
+			double resolution, occThres, probHit, probMiss, clampMin,
+				clampMax;
+			in >> resolution >> occThres >> probHit >> probMiss >> clampMin >>
+				clampMax;
+			setResolution(resolution);
+			setOccupancyThres(occThres);
+			setProbHit(probHit);
+			setProbMiss(probMiss);
+			setClampingThresMin(clampMin);
+			setClampingThresMax(clampMax);
+
+			const auto nBlocks = in.ReadAs<uint32_t>();
+			m_blocks.resize(nBlocks);
+			m_blockIndex.reserve(nBlocks);
+			std::array<float, BLOCK_VOXELS> logodds;
+			for (uint32_t bi = 0; bi < nBlocks; bi++)
+			{
+				Block& b = m_blocks[bi];
+				in >> b.code;
+				in.ReadBufferFixEndianness(b.known.data(), b.known.size());
+				in.ReadBufferFixEndianness(logodds.data(), logodds.size());
+				m_blockIndex[b.code] = bi;
+
+				// Restore voxel values, and the count and bounding box:
+				const uint64_t base = b.code << VOXEL_BITS;
+				for (unsigned int i = 0; i < BLOCK_VOXELS; i++)
+				{
+					if (!b.isKnown(i)) continue;
+					b.known[i >> 6] &= ~(uint64_t(1) << (i & 63));
+					getOrCreateVoxel(b, base | i).logodds = logodds[i];
+				}
+			}
+		}
+		break;
+		default: MRPT_THROW_UNKNOWN_SERIALIZATION_VERSION(version);
+	}
+}
@@ -0,0 +1,428 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "maps-precomp.h"  // Precomp header
+//
+#include <mrpt/io/CFileGZOutputStream.h>
+#include <mrpt/maps/CHashedOctoMap.h>
+#include <mrpt/maps/CPointsMap.h>
+#include <mrpt/serialization/CArchive.h>
+#include <octomap/octomap.h>
+
+#include "COctoMapBase_impl.h"
+
+using namespace std;
+using namespace mrpt;
+using namespace mrpt::maps;
+using namespace mrpt::img;
+using namespace mrpt::obs;
+using namespace mrpt::poses;
+using namespace mrpt::math;
+using namespace mrpt::opengl;
+
+// The generic COctoMapBase<> implementation relies on the octomap API. These
+// are the specializations for the native CHashedOcTree engine:
+namespace mrpt::maps
+{
+using hashed_base_t = COctoMapBase<CHashedOcTree, CHashedOcTree::Voxel>;
+
+template <>
+void hashed_base_t::saveMetricMapRepresentationToFile(
+	const std::string& filNamePrefix) const
+{
+	MRPT_START
+
+	// Save as 3D Scene:
+	{
+		mrpt::opengl::COpenGLScene scene;
+		scene.insert(this->getVisualization());
+		scene.saveToFile(filNamePrefix + std::string("_3D.3Dscene"));
+	}
+
+	// Save the voxels, in the CHashedOcTree binary format:
+	{
+		mrpt::io::CFileGZOutputStream f(
+			filNamePrefix + std::string("_voxels.bin.gz"));
+		auto arch = mrpt::serialization::archiveFrom(f);
+		m_impl->m_octomap.writeToStream(arch);
+	}
+	MRPT_END
+}
+
+template <>
+double hashed_base_t::internal_computeObservationLikelihood(
+	const mrpt::obs::CObservation& obs,
+	const mrpt::poses::CPose3D& takenFrom) const
+{
+	CHashedOcTree::point3d sensorPt;
+	CHashedOcTree::Pointcloud scan;
+
+	if (!internal_build_PointCloud_for_observation(
+			obs, takenFrom, sensorPt, scan))
+		return 0;  // Nothing to do.
+
+	const auto& om = m_impl->m_octomap;
+	const size_t N = scan.size();
+
+	double log_lik = 0;
+	for (size_t i = 0; i < N; i += likelihoodOptions.decimation)
+	{
+		const auto* v = om.search(scan.xs[i], scan.ys[i], scan.zs[i]);
+		if (v) log_lik += std::log(v->getOccupancy());
+	}
+	return log_lik;
+}
+
+template <>
+bool hashed_base_t::getPointOccupancy(
+	const float x, const float y, const float z, double& prob_occupancy) const
+{
+	const auto* v = m_impl->m_octomap.search(x, y, z);
+	if (!v) return false;
+	prob_occupancy = v->getOccupancy();
+	return true;
+}
+
+template <>
+void hashed_base_t::insertPointCloud(
+	const CPointsMap& ptMap, const float sensor_x, const float sensor_y,
+	const float sensor_z)
+{
+	MRPT_START
+	size_t N;
+	const float *xs, *ys, *zs;
+	ptMap.getPointsBuffer(N, xs, ys, zs);
+	m_impl->m_octomap.insertPointCloud(
+		xs, ys, zs, N, CHashedOcTree::point3d(sensor_x, sensor_y, sensor_z),
+		insertionOptions.maxrange);
+	MRPT_END
+}
+
+template <>
+bool hashed_base_t::castRay(
+	const mrpt::math::TPoint3D& origin, const mrpt::math::TPoint3D& direction,
+	mrpt::math::TPoint3D& end, bool ignoreUnknownCells, double maxRange) const
+{
+	return m_impl->m_octomap.castRay(
+		origin, direction, end, ignoreUnknownCells, maxRange);
+}
+
+}  // namespace mrpt::maps
+
+// Explicit instantiation:
+template class mrpt::maps::COctoMapBase<
+	mrpt::maps::CHashedOcTree, mrpt::maps::CHashedOcTree::Voxel>;
+
+//  =========== Begin of Map definition ============
+MAP_DEFINITION_REGISTER(
+	"mrpt::maps::CHashedOctoMap,hashedOctoMap", mrpt::maps::CHashedOctoMap)
+
+CHashedOctoMap::TMapDefinition::TMapDefinition() = default;
+void CHashedOctoMap::TMapDefinition::loadFromConfigFile_map_specific(
+	const mrpt::config::CConfigFileBase& source,
+	const std::string& sectionNamePrefix)
+{
+	// [<sectionNamePrefix>+"_creationOpts"]
+	const std::string sSectCreation =
+		sectionNamePrefix + string("_creationOpts");
+	MRPT_LOAD_CONFIG_VAR(resolution, double, source, sSectCreation);
+
+	insertionOpts.loadFromConfigFile(
+		source, sectionNamePrefix + string("_insertOpts"));
+	likelihoodOpts.loadFromConfigFile(
+		source, sectionNamePrefix + string("_likelihoodOpts"));
+}
+
+void CHashedOctoMap::TMapDefinition::dumpToTextStream_map_specific(
+	std::ostream& out) const
+{
+	LOADABLEOPTS_DUMP_VAR(resolution, double);
+
+	this->insertionOpts.dumpToTextStream(out);
+	this->likelihoodOpts.dumpToTextStream(out);
+}
+
+mrpt::maps::CMetricMap* CHashedOctoMap::internal_CreateFromMapDefinition(
+	const mrpt::maps::TMetricMapInitializer& _def)
+{
+	const CHashedOctoMap::TMapDefinition& def =
+		*dynamic_cast<const CHashedOctoMap::TMapDefinition*>(&_def);
+	auto* obj = new CHashedOctoMap(def.resolution);
+	obj->insertionOptions = def.insertionOpts;
+	obj->likelihoodOptions = def.likelihoodOpts;
+	return obj;
+}
+//  =========== End of Map definition Block =========
+
+IMPLEMENTS_SERIALIZABLE(CHashedOctoMap, CMetricMap, mrpt::maps)
+
+CHashedOctoMap::CHashedOctoMap(const double resolution)
+	: COctoMapBase<CHashedOcTree, CHashedOcTree::Voxel>(resolution)
+{
+}
+
+CHashedOctoMap::~CHashedOctoMap() = default;
+uint8_t CHashedOctoMap::serializeGetVersion() const { return 0; }
+void CHashedOctoMap::serializeTo(mrpt::serialization::CArchive& out) const
+{
+	this->likelihoodOptions.writeToStream(out);
+	this->renderingOptions.writeToStream(out);
+	out << genericMapParams;
+	m_impl->m_octomap.writeToStream(out);
+}
+
+void CHashedOctoMap::serializeFrom(
+	mrpt::serialization::CArchive& in, uint8_t version)
+{
+	switch (version)
+	{
+		case 0:
+		{
+			this->likelihoodOptions.readFromStream(in);
+			this->renderingOptions.readFromStream(in);
+			in >> genericMapParams;
+			this->clear();
+			m_impl->m_octomap.readFromStream(in);
+		}
+		break;
+		default: MRPT_THROW_UNKNOWN_SERIALIZATION_VERSION(version);
+	};
+}
+
+bool CHashedOctoMap::internal_insertObservation(
+	const mrpt::obs::CObservation& obs,
+	const std::optional<const mrpt::poses::CPose3D>& robotPose)
+{
+	CHashedOcTree::point3d sensorPt;
+	CHashedOcTree::Pointcloud scan;
+	if (!internal_build_PointCloud_for_observation(
+			obs, robotPose, sensorPt, scan))
+		return false;  // Nothing to do.
+	// Insert all rays as one batch:
+	m_impl->m_octomap.insertPointCloud(
+		scan, sensorPt, insertionOptions.maxrange);
+	return true;
+}
+
+void CHashedOctoMap::getAsOctoMapVoxels(
+	mrpt::opengl::COctoMapVoxels& gl_obj) const
+{
+	const auto& om = m_impl->m_octomap;
+
+	const TColorf general_color = gl_obj.getColor();
+	const TColor general_color_u(
+		general_color.R * 255, general_color.G * 255, general_color.B * 255,
+		general_color.A * 255);
+
+	gl_obj.clear();
+	gl_obj.resizeVoxelSets(2);	// 2 sets of voxels: occupied & free
+
+	gl_obj.showVoxels(
+		VOXEL_SET_OCCUPIED, renderingOptions.visibleOccupiedVoxels);
+	gl_obj.showVoxels(VOXEL_SET_FREESPACE, renderingOptions.visibleFreeVoxels);
+
+	gl_obj.reserveVoxels(VOXEL_SET_OCCUPIED, om.size());
+	gl_obj.reserveVoxels(VOXEL_SET_FREESPACE, om.size());
+
+	double xmin, xmax, ymin, ymax, zmin, zmax;
+	om.getMetricMin(xmin, ymin, zmin);
+	om.getMetricMax(xmax, ymax, zmax);
+	const double inv_dz = 1 / (zmax - zmin + 0.01);
+	const double vx_length = om.getResolution();
+
+	om.forEachVoxel([&](uint64_t code, const CHashedOcTree::Voxel& v) {
+		const double occ = v.getOccupancy();
+		if (!((occ >= 0.5 && renderingOptions.generateOccupiedVoxels) ||
+			  (occ < 0.5 && renderingOptions.generateFreeVoxels)))
+			return;
+
+		const TPoint3D vx_center = om.codeToCoord(code);
+
+		mrpt::img::TColor vx_color;
+		double coefc, coeft;
+		switch (gl_obj.getVisualizationMode())
+		{
+			case COctoMapVoxels::FIXED: vx_color = general_color_u; break;
+			case COctoMapVoxels::COLOR_FROM_HEIGHT:
+				coefc = 255 * inv_dz * (vx_center.z - zmin);
+				vx_color = TColor(
+					coefc * general_color.R, coefc * general_color.G,
+					coefc * general_color.B, 255.0 * general_color.A);
+				break;
+			case COctoMapVoxels::COLOR_FROM_OCCUPANCY:
+				coefc = 240 * (1 - occ) + 15;
+				vx_color = TColor(
+					coefc * general_color.R, coefc * general_color.G,
+					coefc * general_color.B, 255.0 * general_color.A);
+				break;
+			case COctoMapVoxels::TRANSPARENCY_FROM_OCCUPANCY:
+				coeft = std::max(0.0, 255 - 510 * (1 - occ));
+				vx_color = TColor(
+					255 * general_color.R, 255 * general_color.G,
+					255 * general_color.B, coeft);
+				break;
+			case COctoMapVoxels::TRANS_AND_COLOR_FROM_OCCUPANCY:
+				coefc = 240 * (1 - occ) + 15;
+				vx_color = TColor(
+					coefc * general_color.R, coefc * general_color.G,
+					coefc * general_color.B, 50);
+				break;
+			case COctoMapVoxels::MIXED:
+				coefc = 255 * inv_dz * (vx_center.z - zmin);
+				coeft = std::max(0.0, 255 - 510 * (1 - occ));
+				vx_color = TColor(
+					coefc * general_color.R, coefc * general_color.G,
+					coefc * general_color.B, coeft);
+				break;
+			default: THROW_EXCEPTION("Unknown coloring scheme!");
+		}
+
+		gl_obj.push_back_Voxel(
+			om.isOccupied(v) ? VOXEL_SET_OCCUPIED : VOXEL_SET_FREESPACE,
+			COctoMapVoxels::TVoxel(vx_center, vx_length, vx_color));
+	});
+
+	// Grid lines: the boundaries of the voxel blocks
+	if (renderingOptions.generateGridLines)
+	{
+		const double blockLength =
+			vx_length * (1U << CHashedOcTree::BLOCK_LOG2);
+		gl_obj.reserveGridCubes(om.getNumBlocks());
+		for (const auto& b : om.getBlocks())
+		{
+			// Center of the first voxel in the block:
+			const TPoint3D c0 =
+				om.codeToCoord(b.code << (3 * CHashedOcTree::BLOCK_LOG2));
+			const TPoint3D pt_min = c0 - TPoint3D(1, 1, 1) * (0.5 * vx_length);
+			gl_obj.push_back_GridCube(COctoMapVoxels::TGridCube(
+				pt_min, pt_min + TPoint3D(1, 1, 1) * blockLength));
+		}
+	}
+
+	// if we use transparency, sort cubes by "Z" as an approximation to
+	// far-to-near render ordering:
+	if (gl_obj.isCubeTransparencyEnabled()) gl_obj.sort_voxels_by_z();
+
+	gl_obj.setBoundingBox(
+		TPoint3D(xmin, ymin, zmin), TPoint3D(xmax, ymax, zmax));
+}
+
+const CHashedOcTree& CHashedOctoMap::getHashedOcTree() const
+{
+	return m_impl->m_octomap;
+}
+
+void CHashedOctoMap::insertRay(
+	const float end_x, const float end_y, const float end_z,
+	const float sensor_x, const float sensor_y, const float sensor_z)
+{
+	m_impl->m_octomap.insertRay(
+		CHashedOcTree::point3d(sensor_x, sensor_y, sensor_z),
+		CHashedOcTree::point3d(end_x, end_y, end_z),
+		insertionOptions.maxrange);
+}
+void CHashedOctoMap::updateVoxel(
+	const double x, const double y, const double z, bool occupied)
+{
+	m_impl->m_octomap.updateNode(x, y, z, occupied);
+}
+bool CHashedOctoMap::isPointWithinOctoMap(
+	const float x, const float y, const float z) const
+{
+	uint64_t code;
+	return m_impl->m_octomap.coordToCode(x, y, z, code);
+}
+
+double CHashedOctoMap::getResolution() const
+{
+	return m_impl->m_octomap.getResolution();
+}
+size_t CHashedOctoMap::size() const { return m_impl->m_octomap.size(); }
+size_t CHashedOctoMap::memoryUsage() const
+{
+	return m_impl->m_octomap.memoryUsage();
+}
+void CHashedOctoMap::getMetricSize(double& x, double& y, double& z) const
+{
+	double x0, y0, z0;
+	m_impl->m_octomap.getMetricMin(x0, y0, z0);
+	m_impl->m_octomap.getMetricMax(x, y, z);
+	x -= x0;
+	y -= y0;
+	z -= z0;
+}
+void CHashedOctoMap::getMetricMin(double& x, double& y, double& z) const
+{
+	m_impl->m_octomap.getMetricMin(x, y, z);
+}
+void CHashedOctoMap::getMetricMax(double& x, double& y, double& z) const
+{
+	m_impl->m_octomap.getMetricMax(x, y, z);
+}
+void CHashedOctoMap::setOccupancyThres(double prob)
+{
+	m_impl->m_octomap.setOccupancyThres(prob);
+}
+void CHashedOctoMap::setProbHit(double prob)
+{
+	m_impl->m_octomap.setProbHit(prob);
+}
+void CHashedOctoMap::setProbMiss(double prob)
+{
+	m_impl->m_octomap.setProbMiss(prob);
+}
+void CHashedOctoMap::setClampingThresMin(double thresProb)
+{
+	m_impl->m_octomap.setClampingThresMin(thresProb);
+}
+void CHashedOctoMap::setClampingThresMax(double thresProb)
+{
+	m_impl->m_octomap.setClampingThresMax(thresProb);
+}
+double CHashedOctoMap::getOccupancyThres() const
+{
+	return m_impl->m_octomap.getOccupancyThres();
+}
+float CHashedOctoMap::getOccupancyThresLog() const
+{
+	return m_impl->m_octomap.getOccupancyThresLog();
+}
+double CHashedOctoMap::getProbHit() const
+{
+	return m_impl->m_octomap.getProbHit();
+}
+float CHashedOctoMap::getProbHitLog() const
+{
+	return m_impl->m_octomap.getProbHitLog();
+}
+double CHashedOctoMap::getProbMiss() const
+{
+	return m_impl->m_octomap.getProbMiss();
+}
+float CHashedOctoMap::getProbMissLog() const
+{
+	return m_impl->m_octomap.getProbMissLog();
+}
+double CHashedOctoMap::getClampingThresMin() const
+{
+	return m_impl->m_octomap.getClampingThresMin();
+}
+float CHashedOctoMap::getClampingThresMinLog() const
+{
+	return m_impl->m_octomap.getClampingThresMinLog();
+}
+double CHashedOctoMap::getClampingThresMax() const
+{
+	return m_impl->m_octomap.getClampingThresMax();
+}
+float CHashedOctoMap::getClampingThresMaxLog() const
+{
+	return m_impl->m_octomap.getClampingThresMaxLog();
+}
+void CHashedOctoMap::internal_clear() { m_impl->m_octomap.clear(); }
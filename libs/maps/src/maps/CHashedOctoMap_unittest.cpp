@@ -0,0 +1,133 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+#include <mrpt/io/CMemoryStream.h>
+#include <mrpt/maps/CHashedOctoMap.h>
+#include <mrpt/maps/COctoMap.h>
+#include <mrpt/obs/CObservation2DRangeScan.h>
+#include <mrpt/obs/stock_observations.h>
+#include <mrpt/serialization/CArchive.h>
+
+using namespace mrpt;
+using namespace mrpt::maps;
+using namespace mrpt::obs;
+using namespace mrpt::poses;
+using namespace mrpt::math;
+using namespace std;
+
+TEST(CHashedOctoMapTests, mortonCodes)
+{
+	const uint32_t keys[][3] = {
+		{0, 0, 0}, {1, 2, 3}, {0x1fffff, 0, 0x12345}, {0x100000, 7, 0x1fffff}};
+	for (const auto& k : keys)
+	{
+		const uint64_t code = CHashedOcTree::mortonEncode(k[0], k[1], k[2]);
+		uint32_t x, y, z;
+		CHashedOcTree::mortonDecode(code, x, y, z);
+		EXPECT_EQ(x, k[0]);
+		EXPECT_EQ(y, k[1]);
+		EXPECT_EQ(z, k[2]);
+		// The top bits are the code of the 8x8x8 block:
+		EXPECT_EQ(
+			code >> 9,
+			CHashedOcTree::mortonEncode(k[0] >> 3, k[1] >> 3, k[2] >> 3));
+	}
+}
+
+TEST(CHashedOctoMapTests, updateVoxels)
+{
+	CHashedOctoMap map(0.1);
+	EXPECT_TRUE(map.isEmpty());
+
+	map.updateVoxel(1, 1, 1, true);
+	map.updateVoxel(1.5, 1, 1, true);
+	map.updateVoxel(1.5, 1, 1, true);
+	map.updateVoxel(-1, -1, 1, false);
+
+	double occup;
+	EXPECT_TRUE(map.getPointOccupancy(1, 1, 1, occup));
+	EXPECT_GT(occup, 0.5);
+	EXPECT_TRUE(map.getPointOccupancy(-1, -1, 1, occup));
+	EXPECT_LT(occup, 0.5);
+	EXPECT_FALSE(map.getPointOccupancy(0, 0, 0, occup));
+	EXPECT_EQ(map.size(), 3U);
+}
+
+TEST(CHashedOctoMapTests, sameResultsThanOctoMap)
+{
+	CObservation2DRangeScan scan1;
+	stock_observations::example2DRangeScan(scan1);
+
+	COctoMap octomap(0.1);
+	CHashedOctoMap hashed(0.1);
+
+	const CPose3D poses[] = {
+		CPose3D(0, 0, 0, 0, 0, 0), CPose3D(0.3, -0.2, 0.05, 0.4, 0, 0),
+		CPose3D(-0.5, 0.1, 0.02, -0.3, 0, 0)};
+	for (const auto& p : poses)
+	{
+		octomap.insertObservation(scan1, p);
+		hashed.insertObservation(scan1, p);
+	}
+
+	const auto& om = hashed.getHashedOcTree();
+	ASSERT_GT(om.size(), 100U);
+
+	size_t nVoxels = 0, nEqual = 0;
+	om.forEachVoxel([&](uint64_t code, const CHashedOcTree::Voxel& v) {
+		const TPoint3D pt = om.codeToCoord(code);
+		double p;
+		nVoxels++;
+		if (octomap.getPointOccupancy(pt.x, pt.y, pt.z, p) &&
+			std::abs(p - v.getOccupancy()) < 1e-3)
+			nEqual++;
+	});
+	// Ray traversal is the same in both engines, up to round-off errors in
+	// rays grazing voxel corners:
+	EXPECT_GT(nEqual, 0.99 * nVoxels);
+
+	// Ray casting:
+	TPoint3D end1, end2;
+	const TPoint3D origin(0, 0, 0), dir(1, 0.2, 0);
+	const bool hit1 = octomap.castRay(origin, dir, end1, true);
+	const bool hit2 = hashed.castRay(origin, dir, end2, true);
+	EXPECT_EQ(hit1, hit2);
+	if (hit1 && hit2) EXPECT_LT((end1 - end2).norm(), 0.15);
+}
+
+TEST(CHashedOctoMapTests, serialization)
+{
+	CObservation2DRangeScan scan1;
+	stock_observations::example2DRangeScan(scan1);
+
+	CHashedOctoMap map(0.05);
+	map.insertObservation(scan1);
+	map.setProbHit(0.8);
+
+	mrpt::io::CMemoryStream buf;
+	auto arch = mrpt::serialization::archiveFrom(buf);
+	arch << map;
+	buf.Seek(0);
+
+	CHashedOctoMap map2;
+	arch >> map2;
+
+	EXPECT_EQ(map2.size(), map.size());
+	EXPECT_DOUBLE_EQ(map2.getResolution(), 0.05);
+	EXPECT_NEAR(map2.getProbHit(), 0.8, 1e-6);
+
+	const auto& om = map.getHashedOcTree();
+	const auto& om2 = map2.getHashedOcTree();
+	om.forEachVoxel([&](uint64_t code, const CHashedOcTree::Voxel& v) {
+		const auto* v2 = om2.search(code);
+		ASSERT_TRUE(v2 != nullptr);
+		EXPECT_EQ(v2->logodds, v.logodds);
+	});
+}
@@ -0,0 +1,660 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "maps-precomp.h"  // Precomp header
+//
+#include <mrpt/config/CConfigFileBase.h>
+#include <mrpt/core/format.h>
+#include <mrpt/maps/CHashedVoxelPointsMap.h>
+#include <mrpt/maps/CSimplePointsMap.h>
+#include <mrpt/obs/CObservation.h>
+#include <mrpt/opengl/CPointCloud.h>
+#include <mrpt/opengl/CSetOfObjects.h>
+#include <mrpt/poses/CPose3D.h>
+#include <mrpt/serialization/CArchive.h>
+#include <mrpt/system/os.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "TMatchingWorkspace_impl.h"
+
+using namespace std;
+using namespace mrpt;
+using namespace mrpt::maps;
+using namespace mrpt::math;
+using namespace mrpt::obs;
+using namespace mrpt::poses;
+using namespace mrpt::tfest;
+
+//  =========== Begin of Map definition ============
+MAP_DEFINITION_REGISTER(
+	"mrpt::maps::CHashedVoxelPointsMap,hashedVoxelPointsMap",
+	mrpt::maps::CHashedVoxelPointsMap)
+
+CHashedVoxelPointsMap::TMapDefinition::TMapDefinition() = default;
+void CHashedVoxelPointsMap::TMapDefinition::loadFromConfigFile_map_specific(
+	const mrpt::config::CConfigFileBase& source,
+	const std::string& sectionNamePrefix)
+{
+	// [<sectionNamePrefix>+"_creationOpts"]
+	const std::string sSectCreation =
+		sectionNamePrefix + string("_creationOpts");
+	MRPT_LOAD_CONFIG_VAR(voxelSize, double, source, sSectCreation);
+	MRPT_LOAD_CONFIG_VAR(maxPointsPerVoxel, int, source, sSectCreation);
+
+	insertionOpts.loadFromConfigFile(
+		source, sectionNamePrefix + string("_insertOpts"));
+	likelihoodOpts.loadFromConfigFile(
+		source, sectionNamePrefix + string("_likelihoodOpts"));
+	renderOpts.loadFromConfigFile(
+		source, sectionNamePrefix + string("_renderOpts"));
+}
+
+void CHashedVoxelPointsMap::TMapDefinition::dumpToTextStream_map_specific(
+	std::ostream& out) const
+{
+	LOADABLEOPTS_DUMP_VAR(voxelSize, double);
+	LOADABLEOPTS_DUMP_VAR(maxPointsPerVoxel, int);
+
+	this->insertionOpts.dumpToTextStream(out);
+	this->likelihoodOpts.dumpToTextStream(out);
+	this->renderOpts.dumpToTextStream(out);
+}
+
+mrpt::maps::CMetricMap* CHashedVoxelPointsMap::internal_CreateFromMapDefinition(
+	const mrpt::maps::TMetricMapInitializer& _def)
+{
+	const CHashedVoxelPointsMap::TMapDefinition& def =
+		*dynamic_cast<const CHashedVoxelPointsMap::TMapDefinition*>(&_def);
+	auto* obj =
+		new CHashedVoxelPointsMap(def.voxelSize, def.maxPointsPerVoxel);
+	obj->insertionOptions = def.insertionOpts;
+	obj->likelihoodOptions = def.likelihoodOpts;
+	obj->renderOptions = def.renderOpts;
+	return obj;
+}
+//  =========== End of Map definition Block =========
+
+IMPLEMENTS_SERIALIZABLE(CHashedVoxelPointsMap, CMetricMap, mrpt::maps)
+
+CHashedVoxelPointsMap::CHashedVoxelPointsMap(
+	double voxelSize, uint32_t maxPointsPerVoxel)
+{
+	setVoxelProperties(voxelSize, maxPointsPerVoxel);
+}
+
+void CHashedVoxelPointsMap::setVoxelProperties(
+	double voxelSize, uint32_t maxPointsPerVoxel)
+{
+	ASSERT_GT_(voxelSize, 0);
+	ASSERT_GT_(maxPointsPerVoxel, 0U);
+	m_voxelSize = voxelSize;
+	m_voxelSizeInv = static_cast<float>(1.0 / voxelSize);
+	m_maxPointsPerVoxel = maxPointsPerVoxel;
+	internal_clear();
+}
+
+void CHashedVoxelPointsMap::internal_clear()
+{
+	m_voxels.clear();
+	m_points.clear();
+	m_voxelIndex.clear();
+	m_numPoints = 0;
+}
+
+bool CHashedVoxelPointsMap::pointToVoxel(
+	float x, float y, float z, int32_t key[3]) const
+{
+	const float p[3] = {x, y, z};
+	for (int i = 0; i < 3; i++)
+	{
+		const float k = std::floor(p[i] * m_voxelSizeInv);
+		// (This also rejects NaNs)
+		if (!(k >= -KEY_OFFSET && k < KEY_OFFSET)) return false;
+		key[i] = static_cast<int32_t>(k);
+	}
+	return true;
+}
+
+const CHashedVoxelPointsMap::TVoxel* CHashedVoxelPointsMap::findVoxel(
+	uint64_t key, size_t& voxelIdx) const
+{
+	const auto it = m_voxelIndex.find(key);
+	if (it == m_voxelIndex.end()) return nullptr;
+	voxelIdx = it->second;
+	return &m_voxels[voxelIdx];
+}
+
+bool CHashedVoxelPointsMap::insertPoint(float x, float y, float z)
+{
+	int32_t k[3];
+	if (!pointToVoxel(x, y, z, k)) return false;
+
+	const uint64_t key = voxelKey(k);
+	const auto [it, isNewVoxel] =
+		m_voxelIndex.try_emplace(key, static_cast<uint32_t>(m_voxels.size()));
+	if (isNewVoxel)
+	{
+		m_voxels.emplace_back().key = key;
+		m_points.resize(m_points.size() + m_maxPointsPerVoxel);
+	}
+
+	TVoxel& voxel = m_voxels[it->second];
+	if (voxel.numPoints >= m_maxPointsPerVoxel) return false;  // Full
+
+	TPoint3Df* pts = &m_points[size_t(it->second) * m_maxPointsPerVoxel];
+	const TPoint3Df p(x, y, z);
+
+	// Online decimation:
+	const float minDistSqr = square(insertionOptions.minDistBetweenPoints);
+	if (minDistSqr > 0)
+		for (uint32_t i = 0; i < voxel.numPoints; i++)
+			if ((pts[i] - p).sqrNorm() < minDistSqr) return false;
+
+	pts[voxel.numPoints++] = p;
+	m_numPoints++;
+	return true;
+}
+
+size_t CHashedVoxelPointsMap::insertAnotherMap(
+	const CPointsMap* otherMap, const CPose3D& otherPose)
+{
+	ASSERT_(otherMap);
+	const auto& xs = otherMap->getPointsBufferRef_x();
+	const auto& ys = otherMap->getPointsBufferRef_y();
+	const auto& zs = otherMap->getPointsBufferRef_z();
+
+	size_t nInserted = 0;
+	for (size_t i = 0; i < xs.size(); i++)
+	{
+		float gx, gy, gz;
+		otherPose.composePoint(xs[i], ys[i], zs[i], gx, gy, gz);
+		if (insertPoint(gx, gy, gz)) nInserted++;
+	}
+	return nInserted;
+}
+
+bool CHashedVoxelPointsMap::nearestPoint(
+	const TPoint3Df& query, float maxDistance, TPoint3Df& outPoint,
+	float& outDistSqr, size_t& outIdx) const
+{
+	int32_t k[3];
+	if (m_voxels.empty() || !pointToVoxel(query.x, query.y, query.z, k))
+		return false;
+
+	// Visit voxels in shells of increasing Chebyshev distance to the voxel
+	// of the query, up to the search radius:
+	const int32_t maxShell = std::max<int32_t>(
+		1, static_cast<int32_t>(std::ceil(maxDistance * m_voxelSizeInv)));
+	const float s = static_cast<float>(m_voxelSize);
+
+	// Squared distance from a query coordinate to the voxel [i*s, (i+1)*s]:
+	const auto axisDistSqr = [s](float q, int32_t i) {
+		const float lo = i * s, hi = lo + s;
+		const float d = q < lo ? lo - q : (q > hi ? q - hi : 0.0f);
+		return d * d;
+	};
+
+	bool found = false;
+	float bestSqr = square(maxDistance);
+	int32_t n[3];
+	for (int32_t shell = 0; shell <= maxShell; shell++)
+	{
+		for (int32_t dz = -shell; dz <= shell; dz++)
+		{
+			n[2] = k[2] + dz;
+			const float dz2 = axisDistSqr(query.z, n[2]);
+			if (dz2 > bestSqr) continue;
+			for (int32_t dy = -shell; dy <= shell; dy++)
+			{
+				n[1] = k[1] + dy;
+				const float dyz2 = dz2 + axisDistSqr(query.y, n[1]);
+				if (dyz2 > bestSqr) continue;
+				// Only the two ends of x rows inside the shell:
+				const bool inner =
+					std::abs(dz) < shell && std::abs(dy) < shell;
+				const int32_t step = inner ? 2 * shell : 1;
+				for (int32_t dx = -shell; dx <= shell; dx += step)
+				{
+					n[0] = k[0] + dx;
+					if (dyz2 + axisDistSqr(query.x, n[0]) > bestSqr)
+						continue;
+
+					size_t voxelIdx;
+					const TVoxel* voxel = findVoxel(voxelKey(n), voxelIdx);
+					if (!voxel) continue;
+
+					const size_t first = voxelIdx * m_maxPointsPerVoxel;
+					for (uint32_t i = 0; i < voxel->numPoints; i++)
+					{
+						const float d2 =
+							(m_points[first + i] - query).sqrNorm();
+						if (found ? d2 >= bestSqr : d2 > bestSqr) continue;
+						found = true;
+						bestSqr = d2;
+						outIdx = first + i;
+					}
+				}
+			}
+		}
+		// Points in further shells are at least this far:
+		if (found && bestSqr <= square(shell * s)) break;
+	}
+	if (!found) return false;
+
+	outPoint = m_points[outIdx];
+	outDistSqr = bestSqr;
+	return true;
+}
+
+void CHashedVoxelPointsMap::getAsPointsMap(CPointsMap& outMap) const
+{
+	outMap.reserve(outMap.size() + m_numPoints);
+	forEachPoint([&](const TPoint3Df& p) { outMap.insertPoint(p); });
+}
+
+void CHashedVoxelPointsMap::determineMatching3D(
+	const mrpt::maps::CMetricMap* otherMap2, const CPose3D& otherMapPose,
+	TMatchingPairList& correspondences, const TMatchingParams& params,
+	TMatchingExtraResults& extraResults) const
+{
+	MRPT_START
+
+	extraResults = TMatchingExtraResults();
+
+	ASSERT_GT_(params.decimation_other_map_points, 0);
+	ASSERT_LT_(
+		params.offset_other_map_points, params.decimation_other_map_points);
+
+	ASSERT_(otherMap2->GetRuntimeClass()->derivedFrom(CLASS_ID(CPointsMap)));
+	const auto* otherMap = static_cast<const CPointsMap*>(otherMap2);
+
+	const size_t nLocalPoints = otherMap->size();
+
+	// Prepare output: no correspondences initially:
+	correspondences.clear();
+
+	// Empty maps?  Nothing to do
+	if (!m_numPoints || !nLocalPoints) return;
+
+	const auto& lxs = otherMap->getPointsBufferRef_x();
+	const auto& lys = otherMap->getPointsBufferRef_y();
+	const auto& lzs = otherMap->getPointsBufferRef_z();
+
+	// Reuse the user-provided buffers, if any:
+	TMatchingWorkspace tempWorkspace;
+	TMatchingWorkspace& ws =
+		params.workspace ? *params.workspace : tempWorkspace;
+
+	// Transform all local points:
+	ws.xs.resize(nLocalPoints);
+	ws.ys.resize(nLocalPoints);
+	ws.zs.resize(nLocalPoints);
+	for (size_t i = params.offset_other_map_points; i < nLocalPoints;
+		 i += params.decimation_other_map_points)
+		otherMapPose.composePoint(
+			lxs[i], lys[i], lzs[i], ws.xs[i], ws.ys[i], ws.zs[i]);
+
+	// Loop for each point in local map, in blocks of points. Queries are
+	// read-only, and can run in parallel:
+	auto& allCorrs = params.onlyUniqueRobust ? ws.allCorrs : correspondences;
+	const float sumSqrDist = internal::matchPointsInBlocks(
+		params, nLocalPoints, ws, allCorrs,
+		[&](size_t localIdx, TMatchingPairList& corrs) {
+			const TPoint3Df query(
+				ws.xs[localIdx], ws.ys[localIdx], ws.zs[localIdx]);
+
+			// Compute max. allowed distance:
+			const float maxDist = d2f(
+				params.maxAngularDistForCorrespondence *
+					params.angularDistPivotPoint.distanceTo(
+						TPoint3D(query.x, query.y, query.z)) +
+				params.maxDistForCorrespondence);
+
+			TPoint3Df closest;
+			float errSqr;
+			size_t globalIdx;
+			if (!nearestPoint(query, maxDist, closest, errSqr, globalIdx) ||
+				errSqr >= square(maxDist))
+				return;
+
+			TMatchingPair& p = corrs.emplace_back();
+			p.globalIdx = globalIdx;
+			p.global = closest;
+			p.localIdx = localIdx;
+			p.local.x = lxs[localIdx];
+			p.local.y = lys[localIdx];
+			p.local.z = lzs[localIdx];
+			p.errorSquareAfterTransformation = errSqr;
+		});
+	// Number of points with one corrs. at least:
+	const size_t nOtherMapPointsWithCorrespondence = allCorrs.size();
+
+	if (params.onlyUniqueRobust)
+	{
+		ASSERTMSG_(
+			params.onlyKeepTheClosest,
+			"ERROR: onlyKeepTheClosest must be also set to true when "
+			"onlyUniqueRobust=true.");
+		allCorrs.filterUniqueRobustPairs(m_points.size(), correspondences);
+	}
+
+	extraResults.sumSqrDist = nOtherMapPointsWithCorrespondence
+		? sumSqrDist / static_cast<double>(nOtherMapPointsWithCorrespondence)
+		: 0;
+	extraResults.correspondencesRatio = params.decimation_other_map_points *
+		nOtherMapPointsWithCorrespondence / d2f(nLocalPoints);
+
+	MRPT_END
+}
+
+float CHashedVoxelPointsMap::compute3DMatchingRatio(
+	const mrpt::maps::CMetricMap* otherMap,
+	const mrpt::poses::CPose3D& otherMapPose,
+	const TMatchingRatioParams& mrp) const
+{
+	TMatchingPairList correspondences;
+	TMatchingParams params;
+	TMatchingExtraResults extraResults;
+
+	params.maxDistForCorrespondence = mrp.maxDistForCorr;
+
+	this->determineMatching3D(
+		otherMap->getAsSimplePointsMap(), otherMapPose, correspondences,
+		params, extraResults);
+
+	return extraResults.correspondencesRatio;
+}
+
+bool CHashedVoxelPointsMap::internal_insertObservation(
+	const CObservation& obs, const std::optional<const CPose3D>& robotPose)
+{
+	MRPT_START
+
+	const CPose3D robotPose3D = robotPose ? *robotPose : CPose3D();
+
+	// Let a points map convert the observation into global points:
+	CSimplePointsMap pts;
+	pts.insertionOptions.minDistBetweenLaserPoints = 0;
+	if (!pts.insertObservation(obs, robotPose3D)) return false;
+
+	CPose3D sensorPose;
+	obs.getSensorPose(sensorPose);
+	const CPose3D sensorPose3D = robotPose3D + sensorPose;
+	const TPoint3Df sensorPt(
+		d2f(sensorPose3D.x()), d2f(sensorPose3D.y()),
+		d2f(sensorPose3D.z()));
+	const float maxRangeSqr = insertionOptions.maxRange > 0
+		? square(insertionOptions.maxRange)
+		: std::numeric_limits<float>::max();
+
+	const auto& xs = pts.getPointsBufferRef_x();
+	const auto& ys = pts.getPointsBufferRef_y();
+	const auto& zs = pts.getPointsBufferRef_z();
+	for (size_t i = 0; i < xs.size(); i++)
+	{
+		const TPoint3Df p(xs[i], ys[i], zs[i]);
+		if ((p - sensorPt).sqrNorm() > maxRangeSqr) continue;
+		insertPoint(p);
+	}
+	return true;
+
+	MRPT_END
+}
+
+double CHashedVoxelPointsMap::internal_computeObservationLikelihood(
+	const CObservation& obs, const CPose3D& takenFrom) const
+{
+	MRPT_START
+
+	CSimplePointsMap pts;
+	pts.insertionOptions.minDistBetweenLaserPoints = 0;
+	pts.insertObservation(obs, takenFrom);
+
+	const size_t N = pts.size();
+	if (!N || isEmpty()) return -100;
+
+	const auto& xs = pts.getPointsBufferRef_x();
+	const auto& ys = pts.getPointsBufferRef_y();
+	const auto& zs = pts.getPointsBufferRef_z();
+
+	const float maxDist = d2f(likelihoodOptions.max_corr_distance);
+	const float maxSqrErr = square(maxDist);
+	double sumSqrDist = 0;
+	size_t nPtsForAverage = 0;
+	for (size_t i = 0; i < N;
+		 i += likelihoodOptions.decimation, nPtsForAverage++)
+	{
+		TPoint3Df closest;
+		float closestErr;
+		size_t idx;
+		if (!nearestPoint(
+				TPoint3Df(xs[i], ys[i], zs[i]), maxDist, closest, closestErr,
+				idx))
+			closestErr = maxSqrErr;
+		sumSqrDist += static_cast<double>(std::min(closestErr, maxSqrErr));
+	}
+	if (nPtsForAverage) sumSqrDist /= nPtsForAverage;
+
+	// Log-likelihood:
+	return -sumSqrDist / likelihoodOptions.sigma_dist;
+
+	MRPT_END
+}
+
+void CHashedVoxelPointsMap::saveMetricMapRepresentationToFile(
+	const std::string& filNamePrefix) const
+{
+	const std::string fil = filNamePrefix + std::string(".txt");
+	FILE* f = mrpt::system::os::fopen(fil.c_str(), "wt");
+	if (!f)
+		THROW_EXCEPTION_FMT(
+			"Error opening file for writing: `%s`", fil.c_str());
+
+	forEachPoint([f](const TPoint3Df& p) {
+		mrpt::system::os::fprintf(f, "%f %f %f\n", p.x, p.y, p.z);
+	});
+	mrpt::system::os::fclose(f);
+}
+
+void CHashedVoxelPointsMap::getVisualizationInto(
+	mrpt::opengl::CSetOfObjects& o) const
+{
+	MRPT_START
+	if (!genericMapParams.enableSaveAs3DObject) return;
+
+	auto obj = mrpt::opengl::CPointCloud::Create();
+	obj->reserve(m_numPoints);
+	forEachPoint([&](const TPoint3Df& p) { obj->insertPoint(p); });
+	obj->setColor(renderOptions.color);
+	obj->setPointSize(renderOptions.point_size);
+	obj->enableColorFromZ(false);
+	o.insert(obj);
+	MRPT_END
+}
+
+std::string CHashedVoxelPointsMap::asString() const
+{
+	return mrpt::format(
+		"Hashed voxel points map with %u points in %u voxels of %.03f m",
+		static_cast<unsigned int>(m_numPoints),
+		static_cast<unsigned int>(m_voxels.size()), m_voxelSize);
+}
+
+uint8_t CHashedVoxelPointsMap::serializeGetVersion() const { return 0; }
+void CHashedVoxelPointsMap::serializeTo(
+	mrpt::serialization::CArchive& out) const
+{
+	out << m_voxelSize << m_maxPointsPerVoxel;
+	insertionOptions.writeToStream(out);
+	likelihoodOptions.writeToStream(out);
+	out << genericMapParams;
+
+	out.WriteAs<uint32_t>(m_voxels.size());
+	for (size_t v = 0; v < m_voxels.size(); v++)
+	{
+		out << m_voxels[v].key << m_voxels[v].numPoints;
+		const TPoint3Df* pts = &m_points[v * m_maxPointsPerVoxel];
+		for (uint32_t i = 0; i < m_voxels[v].numPoints; i++)
+			out << pts[i].x << pts[i].y << pts[i].z;
+	}
+}
+
+void CHashedVoxelPointsMap::serializeFrom(
+	mrpt::serialization::CArchive& in, uint8_t version)
+{
+	switch (version)
+	{
+		case 0:
+		{
+			double voxelSize;
+			uint32_t maxPointsPerVoxel;
+			in >> voxelSize >> maxPointsPerVoxel;
+			setVoxelProperties(voxelSize, maxPointsPerVoxel);
+
+			insertionOptions.readFromStream(in);
+			likelihoodOptions.readFromStream(in);
+			in >> genericMapParams;
+
+			const auto nVoxels = in.ReadAs<uint32_t>();
+			m_voxels.resize(nVoxels);
+			m_points.resize(size_t(nVoxels) * m_maxPointsPerVoxel);
+			m_voxelIndex.reserve(nVoxels);
+			for (uint32_t v = 0; v < nVoxels; v++)
+			{
+				TVoxel& voxel = m_voxels[v];
+				in >> voxel.key >> voxel.numPoints;
+				ASSERT_LE_(voxel.numPoints, m_maxPointsPerVoxel);
+				m_voxelIndex[voxel.key] = v;
+				m_numPoints += voxel.numPoints;
+
+				TPoint3Df* pts = &m_points[size_t(v) * m_maxPointsPerVoxel];
+				for (uint32_t i = 0; i < voxel.numPoints; i++)
+					in >> pts[i].x >> pts[i].y >> pts[i].z;
+			}
+		}
+		break;
+		default: MRPT_THROW_UNKNOWN_SERIALIZATION_VERSION(version);
+	};
+}
+
+/*---------------------------------------------------------------
+						TInsertionOptions
+ ---------------------------------------------------------------*/
+void CHashedVoxelPointsMap::TInsertionOptions::loadFromConfigFile(
+	const mrpt::config::CConfigFileBase& source, const std::string& section)
+{
+	MRPT_LOAD_CONFIG_VAR(minDistBetweenPoints, float, source, section);
+	MRPT_LOAD_CONFIG_VAR(maxRange, float, source, section);
+}
+
+void CHashedVoxelPointsMap::TInsertionOptions::dumpToTextStream(
+	std::ostream& out) const
+{
+	out << "\n----------- [CHashedVoxelPointsMap::TInsertionOptions] "
+		   "------------ \n\n";
+
+	LOADABLEOPTS_DUMP_VAR(minDistBetweenPoints, float);
+	LOADABLEOPTS_DUMP_VAR(maxRange, float);
+}
+
+void CHashedVoxelPointsMap::TInsertionOptions::writeToStream(
+	mrpt::serialization::CArchive& out) const
+{
+	const int8_t version = 0;
+	out << version;
+	out << minDistBetweenPoints << maxRange;
+}
+
+void CHashedVoxelPointsMap::TInsertionOptions::readFromStream(
+	mrpt::serialization::CArchive& in)
+{
+	int8_t version;
+	in >> version;
+	switch (version)
+	{
+		case 0:
+		{
+			in >> minDistBetweenPoints >> maxRange;
+		}
+		break;
+		default: MRPT_THROW_UNKNOWN_SERIALIZATION_VERSION(version);
+	}
+}
+
+/*---------------------------------------------------------------
+						TLikelihoodOptions
+ ---------------------------------------------------------------*/
+void CHashedVoxelPointsMap::TLikelihoodOptions::loadFromConfigFile(
+	const mrpt::config::CConfigFileBase& source, const std::string& section)
+{
+	MRPT_LOAD_CONFIG_VAR(sigma_dist, double, source, section);
+	MRPT_LOAD_CONFIG_VAR(max_corr_distance, double, source, section);
+	MRPT_LOAD_CONFIG_VAR(decimation, int, source, section);
+}
+
+void CHashedVoxelPointsMap::TLikelihoodOptions::dumpToTextStream(
+	std::ostream& out) const
+{
+	out << "\n----------- [CHashedVoxelPointsMap::TLikelihoodOptions] "
+		   "------------ \n\n";
+
+	LOADABLEOPTS_DUMP_VAR(sigma_dist, double);
+	LOADABLEOPTS_DUMP_VAR(max_corr_distance, double);
+	LOADABLEOPTS_DUMP_VAR(decimation, int);
+}
+
+void CHashedVoxelPointsMap::TLikelihoodOptions::writeToStream(
+	mrpt::serialization::CArchive& out) const
+{
+	const int8_t version = 0;
+	out << version;
+	out << sigma_dist << max_corr_distance << decimation;
+}
+
+void CHashedVoxelPointsMap::TLikelihoodOptions::readFromStream(
+	mrpt::serialization::CArchive& in)
+{
+	int8_t version;
+	in >> version;
+	switch (version)
+	{
+		case 0:
+		{
+			in >> sigma_dist >> max_corr_distance >> decimation;
+		}
+		break;
+		default: MRPT_THROW_UNKNOWN_SERIALIZATION_VERSION(version);
+	}
+}
+
+/*---------------------------------------------------------------
+						TRenderOptions
+ ---------------------------------------------------------------*/
+void CHashedVoxelPointsMap::TRenderOptions::loadFromConfigFile(
+	const mrpt::config::CConfigFileBase& source, const std::string& section)
+{
+	MRPT_LOAD_CONFIG_VAR(point_size, float, source, section);
+	MRPT_LOAD_CONFIG_VAR(color.R, float, source, section);
+	MRPT_LOAD_CONFIG_VAR(color.G, float, source, section);
+	MRPT_LOAD_CONFIG_VAR(color.B, float, source, section);
+}
+
+void CHashedVoxelPointsMap::TRenderOptions::dumpToTextStream(
+	std::ostream& out) const
+{
+	out << "\n----------- [CHashedVoxelPointsMap::TRenderOptions] "
+		   "------------ \n\n";
+
+	LOADABLEOPTS_DUMP_VAR(point_size, float);
+	LOADABLEOPTS_DUMP_VAR(color.R, float);
+	LOADABLEOPTS_DUMP_VAR(color.G, float);
+	LOADABLEOPTS_DUMP_VAR(color.B, float);
+}
@@ -0,0 +1,248 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+#include <mrpt/io/CMemoryStream.h>
+#include <mrpt/maps/CHashedVoxelPointsMap.h>
+#include <mrpt/maps/CMultiMetricMap.h>
+#include <mrpt/maps/CSimplePointsMap.h>
+#include <mrpt/obs/CObservation2DRangeScan.h>
+#include <mrpt/obs/stock_observations.h>
+#include <mrpt/poses/CPose3D.h>
+#include <mrpt/random/RandomGenerators.h>
+#include <mrpt/serialization/CArchive.h>
+
+#include <algorithm>
+#include <limits>
+#include <set>
+
+using namespace mrpt;
+using namespace mrpt::maps;
+using namespace mrpt::obs;
+using namespace mrpt::poses;
+using namespace mrpt::math;
+using namespace std;
+
+static TPoint3Df randomPoint(float zMax = 3.0f)
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	return {
+		rng.drawUniform(-10.0f, 10.0f), rng.drawUniform(-10.0f, 10.0f),
+		rng.drawUniform(0.0f, zMax)};
+}
+
+TEST(CHashedVoxelPointsMapTests, onlineDecimation)
+{
+	CHashedVoxelPointsMap map(1.0, 4);
+	map.insertionOptions.minDistBetweenPoints = 0.1f;
+
+	EXPECT_TRUE(map.insertPoint(0.5f, 0.5f, 0.5f));
+	// Too close to an existing point:
+	EXPECT_FALSE(map.insertPoint(0.55f, 0.5f, 0.5f));
+	EXPECT_TRUE(map.insertPoint(0.1f, 0.1f, 0.1f));
+	EXPECT_TRUE(map.insertPoint(0.9f, 0.1f, 0.1f));
+	EXPECT_TRUE(map.insertPoint(0.1f, 0.9f, 0.1f));
+	// The voxel is full:
+	EXPECT_FALSE(map.insertPoint(0.9f, 0.9f, 0.9f));
+	// ...but not its neighbors, even for close points:
+	EXPECT_TRUE(map.insertPoint(1.01f, 0.5f, 0.5f));
+	EXPECT_TRUE(map.insertPoint(-0.5f, 0.5f, 0.5f));
+
+	EXPECT_EQ(map.size(), 6U);
+	EXPECT_EQ(map.getNumVoxels(), 3U);
+
+	map.clear();
+	EXPECT_TRUE(map.isEmpty());
+	EXPECT_EQ(map.getNumVoxels(), 0U);
+}
+
+TEST(CHashedVoxelPointsMapTests, nearestPoint)
+{
+	mrpt::random::getRandomGenerator().randomize(123);
+
+	for (const double voxelSize : {0.1, 0.5, 2.0})
+	{
+		CHashedVoxelPointsMap map(voxelSize, 8);
+		for (int i = 0; i < 5000; i++)
+			map.insertPoint(randomPoint());
+
+		for (int i = 0; i < 500; i++)
+		{
+			const auto q = randomPoint(4.0f);
+			const float maxDist =
+				mrpt::random::getRandomGenerator().drawUniform(0.05f, 1.5f);
+
+			// Brute-force search:
+			float gtDistSqr = std::numeric_limits<float>::max();
+			map.forEachPoint([&](const TPoint3Df& p) {
+				gtDistSqr = std::min(gtDistSqr, (p - q).sqrNorm());
+			});
+
+			TPoint3Df pt;
+			float distSqr;
+			size_t idx;
+			const bool found = map.nearestPoint(q, maxDist, pt, distSqr, idx);
+			EXPECT_EQ(found, gtDistSqr <= square(maxDist));
+			if (!found) continue;
+			EXPECT_EQ(distSqr, gtDistSqr);
+			EXPECT_EQ(distSqr, (pt - q).sqrNorm());
+			EXPECT_EQ(map.getPointByIndex(idx), pt);
+		}
+	}
+}
+
+// Without decimation, it must find the same pairs than a KD-tree:
+TEST(CHashedVoxelPointsMapTests, determineMatching3D)
+{
+	mrpt::random::getRandomGenerator().randomize(456);
+
+	CHashedVoxelPointsMap voxelMap(0.5, 10000);
+	voxelMap.insertionOptions.minDistBetweenPoints = 0;
+	CSimplePointsMap globalMap, localMap;
+	for (int i = 0; i < 5000; i++)
+	{
+		const auto p = randomPoint();
+		voxelMap.insertPoint(p);
+		globalMap.insertPoint(p.x, p.y, p.z);
+		localMap.insertPoint(p.x + 0.02f, p.y - 0.01f, p.z);
+	}
+	const CPose3D pose(0.05, -0.03, 0.02, 0.01, 0.005, -0.01);
+
+	TMatchingParams params;
+	params.maxDistForCorrespondence = 0.2f;
+	params.maxAngularDistForCorrespondence = 0.01f;
+
+	mrpt::tfest::TMatchingPairList ref, corrs;
+	TMatchingExtraResults refRes, res;
+	globalMap.determineMatching3D(&localMap, pose, ref, params, refRes);
+	EXPECT_GT(ref.size(), 1000U);
+
+	params.workspace = std::make_shared<TMatchingWorkspace>();
+	for (const size_t numThreads : {1, 4})
+	{
+		params.numThreads = numThreads;
+		voxelMap.determineMatching3D(&localMap, pose, corrs, params, res);
+
+		ASSERT_EQ(corrs.size(), ref.size());
+		for (size_t i = 0; i < corrs.size(); i++)
+		{
+			EXPECT_EQ(corrs[i].localIdx, ref[i].localIdx);
+			EXPECT_EQ(corrs[i].global, ref[i].global);
+			EXPECT_FLOAT_EQ(
+				corrs[i].errorSquareAfterTransformation,
+				ref[i].errorSquareAfterTransformation);
+			EXPECT_EQ(
+				voxelMap.getPointByIndex(corrs[i].globalIdx),
+				corrs[i].global);
+		}
+		EXPECT_FLOAT_EQ(res.sumSqrDist, refRes.sumSqrDist);
+		EXPECT_FLOAT_EQ(res.correspondencesRatio, refRes.correspondencesRatio);
+	}
+
+	// Unique pairs, indexed by voxel slots:
+	params.onlyUniqueRobust = true;
+	voxelMap.determineMatching3D(&localMap, pose, corrs, params, res);
+	EXPECT_GT(corrs.size(), 1000U);
+	std::set<size_t> globalIdxs;
+	for (const auto& c : corrs)
+		EXPECT_TRUE(globalIdxs.insert(c.globalIdx).second);
+}
+
+TEST(CHashedVoxelPointsMapTests, insertObservation)
+{
+	CObservation2DRangeScan scan;
+	stock_observations::example2DRangeScan(scan);
+
+	CSimplePointsMap pts;
+	pts.insertionOptions.minDistBetweenLaserPoints = 0;
+	pts.insertObservation(scan);
+
+	CHashedVoxelPointsMap map(0.2, 4);
+	map.insertObservation(scan);
+	EXPECT_GT(map.size(), 0U);
+	EXPECT_LE(map.size(), pts.size());
+	EXPECT_LE(map.size(), 4 * map.getNumVoxels());
+
+	map.clear();
+	map.insertionOptions.maxRange = 1.0f;
+	map.insertObservation(scan);
+	const TPoint3Df sensorPt(
+		d2f(scan.sensorPose.x()), d2f(scan.sensorPose.y()),
+		d2f(scan.sensorPose.z()));
+	map.forEachPoint([&](const TPoint3Df& p) {
+		EXPECT_LE((p - sensorPt).norm(), 1.0f + 1e-3f);
+	});
+}
+
+TEST(CHashedVoxelPointsMapTests, serialization)
+{
+	mrpt::random::getRandomGenerator().randomize(789);
+
+	CHashedVoxelPointsMap map(0.3, 6);
+	map.insertionOptions.minDistBetweenPoints = 0.02f;
+	for (int i = 0; i < 2000; i++)
+		map.insertPoint(randomPoint());
+
+	mrpt::io::CMemoryStream buf;
+	auto arch = mrpt::serialization::archiveFrom(buf);
+	arch << map;
+	buf.Seek(0);
+
+	CHashedVoxelPointsMap map2;
+	arch >> map2;
+
+	EXPECT_EQ(map2.size(), map.size());
+	EXPECT_EQ(map2.getNumVoxels(), map.getNumVoxels());
+	EXPECT_DOUBLE_EQ(map2.getVoxelSize(), 0.3);
+	EXPECT_EQ(map2.getMaxPointsPerVoxel(), 6U);
+	EXPECT_FLOAT_EQ(map2.insertionOptions.minDistBetweenPoints, 0.02f);
+
+	map.forEachPoint([&](const TPoint3Df& p) {
+		TPoint3Df pt;
+		float distSqr;
+		size_t idx;
+		ASSERT_TRUE(map2.nearestPoint(p, 0.01f, pt, distSqr, idx));
+		EXPECT_EQ(pt, p);
+	});
+}
+
+TEST(CHashedVoxelPointsMapTests, multiMetricMapMatching)
+{
+	CMultiMetricMap multiMap;
+	{
+		TSetOfMetricMapInitializers inits;
+		CHashedVoxelPointsMap::TMapDefinition def;
+		def.voxelSize = 0.5;
+		def.maxPointsPerVoxel = 1000;
+		def.insertionOpts.minDistBetweenPoints = 0;
+		inits.push_back(def);
+		multiMap.setListOfMaps(inits);
+	}
+	auto voxelMap = multiMap.mapByClass<CHashedVoxelPointsMap>();
+	ASSERT_TRUE(voxelMap);
+	EXPECT_DOUBLE_EQ(voxelMap->getVoxelSize(), 0.5);
+
+	mrpt::random::getRandomGenerator().randomize(1011);
+	CSimplePointsMap localMap;
+	for (int i = 0; i < 1000; i++)
+	{
+		const auto p = randomPoint();
+		voxelMap->insertPoint(p);
+		localMap.insertPoint(p.x, p.y, p.z);
+	}
+
+	TMatchingParams params;
+	params.maxDistForCorrespondence = 0.1f;
+	mrpt::tfest::TMatchingPairList corrs;
+	TMatchingExtraResults res;
+	multiMap.determineMatching3D(&localMap, CPose3D(), corrs, params, res);
+	EXPECT_EQ(corrs.size(), localMap.size());
+	EXPECT_FLOAT_EQ(res.correspondencesRatio, 1.0f);
+	EXPECT_FLOAT_EQ(res.sumSqrDist, 0.0f);
+}
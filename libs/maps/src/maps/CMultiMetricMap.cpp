@@ -11,6 +11,7 @@
 //
 #include <mrpt/config/CConfigFile.h>
 #include <mrpt/io/CMemoryStream.h>
+#include <mrpt/maps/CHashedVoxelPointsMap.h>
 #include <mrpt/maps/CMultiMetricMap.h>
 #include <mrpt/maps/CSimplePointsMap.h>
 #include <mrpt/poses/CPoint2D.h>
@@ -230,6 +231,32 @@ void CMultiMetricMap::determineMatching2D(
 	MRPT_END
 }
 
+void CMultiMetricMap::determineMatching3D(
+	const mrpt::maps::CMetricMap* otherMap, const CPose3D& otherMapPose,
+	TMatchingPairList& correspondences, const TMatchingParams& params,
+	TMatchingExtraResults& extraResults) const
+{
+	MRPT_START
+	if (const auto numVoxelMaps = countMapsByClass<CHashedVoxelPointsMap>();
+		numVoxelMaps != 0)
+	{
+		ASSERTMSG_(
+			numVoxelMaps == 1,
+			"There is more than 1 hashed voxel map in the multimetric map.");
+		mapByClass<CHashedVoxelPointsMap>()->determineMatching3D(
+			otherMap, otherMapPose, correspondences, params, extraResults);
+		return;
+	}
+	const auto numPointsMaps = countMapsByClass<CSimplePointsMap>();
+
+	ASSERTMSG_(
+		numPointsMaps == 1,
+		"There is not exactly 1 points maps in the multimetric map.");
+	mapByClass<CSimplePointsMap>()->determineMatching3D(
+		otherMap, otherMapPose, correspondences, params, extraResults);
+	MRPT_END
+}
+
 bool CMultiMetricMap::isEmpty() const
 {
 	bool is_empty;
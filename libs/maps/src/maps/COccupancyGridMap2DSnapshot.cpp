@@ -0,0 +1,73 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "maps-precomp.h"  // Precomp header
+//
+#include <mrpt/maps/COccupancyGridMap2DSnapshot.h>
+
+#include "COccupancyGridMap2D_impl.h"
+
+using namespace mrpt;
+using namespace mrpt::maps;
+using namespace mrpt::math;
+using namespace mrpt::poses;
+
+COccupancyGridMap2DSnapshot::Ptr COccupancyGridMap2DSnapshot::Create(
+	const COccupancyGridMap2D& grid, const Ptr& previous)
+{
+	std::shared_ptr<COccupancyGridMap2DSnapshot> s(
+		new COccupancyGridMap2DSnapshot());
+
+	s->m_epoch = previous ? previous->m_epoch + 1 : 1;
+	s->m_size_x = grid.getSizeX();
+	s->m_size_y = grid.getSizeY();
+	s->m_xMin = grid.getXMin();
+	s->m_xMax = grid.getXMax();
+	s->m_yMin = grid.getYMin();
+	s->m_yMax = grid.getYMax();
+	s->m_resolution = grid.getResolution();
+
+	// Share the bands: the grid will copy them before modifying them.
+	s->m_bands.assign(grid.m_map.begin(), grid.m_map.end());
+	return s;
+}
+
+void COccupancyGridMap2DSnapshot::getRawMapCopy(
+	std::vector<cellType>& out) const
+{
+	out.clear();
+	out.reserve(static_cast<size_t>(m_size_x) * m_size_y);
+	for (const auto& band : m_bands)
+		out.insert(out.end(), band->begin(), band->end());
+}
+
+float COccupancyGridMap2DSnapshot::computeClearance(
+	float x, float y, float maxSearchDistance) const
+{
+	return internal::computeClearance(
+		*this, [this](unsigned int cy) { return getRow(cy); }, x, y,
+		maxSearchDistance);
+}
+
+double COccupancyGridMap2DSnapshot::computeLikelihoodField_Thrun(
+	const CPointsMap& pm, const CPose2D* relativePose,
+	const COccupancyGridMap2D::TLikelihoodOptions& opts) const
+{
+	MRPT_START
+
+	// Immutable: no likelihood cache.
+	return internal::computeLikelihoodField_Thrun(
+		*this, [this](unsigned int cy) { return getRow(cy); },
+		[](unsigned int, unsigned int) -> std::atomic<double>* {
+			return nullptr;
+		},
+		pm, relativePose, opts);
+
+	MRPT_END
+}
@@ -129,7 +129,9 @@ void COccupancyGridMap2D::copyMapContentFrom(const COccupancyGridMap2D& o)
 	m_yMax = o.m_yMax;
 	m_size_x = o.m_size_x;
 	m_size_y = o.m_size_y;
+	// Cell bands are shared (copy-on-write) with the source map:
 	m_map = o.m_map;
+	m_cellBandStamps = o.m_cellBandStamps;
 
 	m_basis_map.clear();
 	m_voronoi_diagram.clear();
@@ -183,7 +185,7 @@ void COccupancyGridMap2D::setSize(
 #endif
 
 	// Cells memory:
-	m_map.resize(m_size_x * m_size_y, p2l(default_value));
+	allocCellBands(p2l(default_value));
 
 	// Free these buffers also:
 	m_basis_map.clear();
@@ -200,7 +202,6 @@ void COccupancyGridMap2D::resizeGrid(
 {
 	unsigned int extra_x_izq = 0, extra_y_arr = 0, new_size_x = 0,
 				 new_size_y = 0;
-	std::vector<cellType> new_map;
 
 	if (new_x_min > new_x_max)
 	{
@@ -279,26 +280,10 @@ void COccupancyGridMap2D::resizeGrid(
 	assert(0 == (new_size_x % 16));
 #endif
 
-	// Reserve new mem block
-	new_map.resize(new_size_x * new_size_y, p2l(new_cells_default_value));
-
-	// Copy all the old map rows into the new map:
-	{
-		cellType* dest_ptr = &new_map[extra_x_izq + extra_y_arr * new_size_x];
-		cellType* src_ptr = &m_map[0];
-		size_t row_size = m_size_x * sizeof(cellType);
-
-		for (size_t y = 0; y < m_size_y; y++)
-		{
-#if defined(_DEBUG) || (MRPT_ALWAYS_CHECKS_DEBUG)
-			assert(dest_ptr + row_size - 1 <= &new_map[new_map.size() - 1]);
-			assert(src_ptr + row_size - 1 <= &m_map[m_map.size() - 1]);
-#endif
-			memcpy(dest_ptr, src_ptr, row_size);
-			dest_ptr += new_size_x;
-			src_ptr += m_size_x;
-		}
-	}
+	// Keep the old cells while the new bands are allocated:
+	std::vector<std::shared_ptr<cell_band_t>> old_map;
+	old_map.swap(m_map);
+	const unsigned int old_size_x = m_size_x, old_size_y = m_size_y;
 
 	// Move new values into the new map:
 	m_xMin = new_x_min;
@@ -309,8 +294,22 @@ void COccupancyGridMap2D::resizeGrid(
 	m_size_x = new_size_x;
 	m_size_y = new_size_y;
 
-	// Free old map, replace by new one:
-	m_map.swap(new_map);
+	// Reserve new mem blocks:
+	allocCellBands(p2l(new_cells_default_value));
+
+	// Copy all the old map rows into the new map:
+	{
+		const size_t row_size = old_size_x * sizeof(cellType);
+
+		for (unsigned int y = 0; y < old_size_y; y++)
+		{
+			const cellType* src_ptr = old_map[y >> CELL_BAND_LOG2]->data() +
+				(y & CELL_BAND_MASK) * old_size_x;
+			memcpy(
+				cellRowForWrite(y + extra_y_arr) + extra_x_izq, src_ptr,
+				row_size);
+		}
+	}
 
 	// Free the other buffers:
 	m_basis_map.clear();
@@ -326,9 +325,11 @@ void COccupancyGridMap2D::freeMap()
 
 	// Free map and sectors
 	m_map.clear();
+	m_cellBandStamps.clear();
 
 	m_basis_map.clear();
 	m_voronoi_diagram.clear();
+	m_dynamic_voronoi.clear();
 
 	m_size_x = m_size_y = 0;
 
@@ -386,15 +387,18 @@ void COccupancyGridMap2D::computeEntropy(TEntropyInfo& info) const
 
 	info.H = info.I = 0;
 	info.effectiveMappedCells = 0;
-	for (signed char it : m_map)
+	for (const auto& band : m_map)
 	{
-		auto ctu = static_cast<cellTypeUnsigned>(it);
-		auto h = entropyTable[ctu];
-		info.H += h;
-		if (h < (MAX_H - 0.001f))
+		for (const cellType it : *band)
 		{
-			info.effectiveMappedCells++;
-			info.I -= h;
+			auto ctu = static_cast<cellTypeUnsigned>(it);
+			auto h = entropyTable[ctu];
+			info.H += h;
+			if (h < (MAX_H - 0.001f))
+			{
+				info.effectiveMappedCells++;
+				info.I -= h;
+			}
 		}
 	}
 
@@ -433,9 +437,8 @@ void COccupancyGridMap2D::internal_clear()
  ---------------------------------------------------------------*/
 void COccupancyGridMap2D::fill(float default_value)
 {
-	cellType defValue = p2l(default_value);
-	for (auto it = m_map.begin(); it < m_map.end(); ++it)
-		*it = defValue;
+	// Shared bands are not modified, simply replaced by new ones:
+	allocCellBands(p2l(default_value));
 	// For the precomputed likelihood trick:
 	m_likelihoodCacheOutDated = true;
 }
@@ -451,7 +454,7 @@ void COccupancyGridMap2D::updateCell(int x, int y, float v)
 		return;
 
 	// Get the current contents of the cell:
-	cellType& theCell = m_map[x + y * m_size_x];
+	cellType& theCell = cellRowForWrite(y)[x];
 
 	// Compute the new Bayesian-fused value of the cell:
 	if (updateInfoChangeOnly.enabled)
@@ -515,7 +518,40 @@ void COccupancyGridMap2D::subSample(int downRatio)
 	}
 
 	setSize(m_xMin, m_xMax, m_yMin, m_yMax, m_resolution);
-	m_map = newMap;
+	ASSERT_EQUAL_(newMap.size(), static_cast<size_t>(m_size_x) * m_size_y);
+	for (unsigned int y = 0; y < m_size_y; y++)
+		memcpy(
+			cellRowForWrite(y), &newMap[y * m_size_x],
+			m_size_x * sizeof(cellType));
+}
+
+void COccupancyGridMap2D::allocCellBands(cellType value)
+{
+	const unsigned int nBands = (m_size_y + CELL_BAND_MASK) >> CELL_BAND_LOG2;
+	m_map.clear();
+	m_map.reserve(nBands);
+	for (unsigned int b = 0; b < nBands; b++)
+	{
+		const unsigned int nRows =
+			std::min(CELL_BAND_ROWS, m_size_y - (b << CELL_BAND_LOG2));
+		m_map.emplace_back(std::make_shared<cell_band_t>(
+			static_cast<size_t>(nRows) * m_size_x, value));
+	}
+	m_cellBandStamps.assign(nBands, m_cellWriteStamp.value);
+}
+
+uint64_t COccupancyGridMap2D::TCellWriteStamp::next()
+{
+	static std::atomic<uint64_t> lastStamp{0};
+	return ++lastStamp;
+}
+
+void COccupancyGridMap2D::getRawMapCopy(std::vector<cellType>& out) const
+{
+	out.clear();
+	out.reserve(static_cast<size_t>(m_size_x) * m_size_y);
+	for (const auto& band : m_map)
+		out.insert(out.end(), band->begin(), band->end());
 }
 
 /*---------------------------------------------------------------
@@ -639,7 +675,7 @@ void COccupancyGridMap2D::determineMatching2D(
 			for (int cy = cy_min; cy <= cy_max; cy++)
 			{
 				// Is an occupied cell?
-				if (m_map[cx + cy * m_size_x] <
+				if (cellRow(cy)[cx] <
 					thresholdCellValue)	 //  getCell(cx,cy)<0.49)
 				{
 					const float residual_x = idx2x(cx) - x_local;
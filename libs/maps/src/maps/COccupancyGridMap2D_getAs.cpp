@@ -34,10 +34,10 @@ void COccupancyGridMap2D::getAsImage(
 		if (!forceRGB)
 		{  // 8bit gray-scale
 			img.resize(m_size_x, m_size_y, mrpt::img::CH_GRAY);
-			const cellType* srcPtr = &m_map[0];
 			unsigned char* destPtr;
 			for (unsigned int y = 0; y < m_size_y; y++)
 			{
+				const cellType* srcPtr = cellRow(y);
 				if (!verticalFlip) destPtr = img(0, m_size_y - 1 - y);
 				else
 					destPtr = img(0, y);
@@ -50,10 +50,10 @@ void COccupancyGridMap2D::getAsImage(
 		else
 		{  // 24bit RGB:
 			img.resize(m_size_x, m_size_y, mrpt::img::CH_RGB);
-			const cellType* srcPtr = &m_map[0];
 			unsigned char* destPtr;
 			for (unsigned int y = 0; y < m_size_y; y++)
 			{
+				const cellType* srcPtr = cellRow(y);
 				if (!verticalFlip) destPtr = img(0, m_size_y - 1 - y);
 				else
 					destPtr = img(0, y);
@@ -73,10 +73,10 @@ void COccupancyGridMap2D::getAsImage(
 		if (!forceRGB)
 		{  // 8bit gray-scale
 			img.resize(m_size_x, m_size_y, mrpt::img::CH_GRAY);
-			const cellType* srcPtr = &m_map[0];
 			unsigned char* destPtr;
 			for (unsigned int y = 0; y < m_size_y; y++)
 			{
+				const cellType* srcPtr = cellRow(y);
 				if (!verticalFlip) destPtr = img(0, m_size_y - 1 - y);
 				else
 					destPtr = img(0, y);
@@ -95,10 +95,10 @@ void COccupancyGridMap2D::getAsImage(
 		else
 		{  // 24bit RGB:
 			img.resize(m_size_x, m_size_y, mrpt::img::CH_RGB);
-			const cellType* srcPtr = &m_map[0];
 			unsigned char* destPtr;
 			for (unsigned int y = 0; y < m_size_y; y++)
 			{
+				const cellType* srcPtr = cellRow(y);
 				if (!verticalFlip) destPtr = img(0, m_size_y - 1 - y);
 				else
 					destPtr = img(0, y);
@@ -153,10 +153,10 @@ void COccupancyGridMap2D::getVisualizationInto(
 	CImage imgColor(m_size_x, m_size_y, mrpt::img::CH_GRAY);
 	CImage imgTrans(m_size_x, m_size_y, mrpt::img::CH_GRAY);
 
-	const cellType* srcPtr = &m_map[0];
 
 	for (unsigned int y = 0; y < m_size_y; y++)
 	{
+		const cellType* srcPtr = cellRow(y);
 		unsigned char* destPtr_color = imgColor(0, y);
 		unsigned char* destPtr_trans = imgTrans(0, y);
 		for (unsigned int x = 0; x < m_size_x; x++)
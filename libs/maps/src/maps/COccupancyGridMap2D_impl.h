@@ -0,0 +1,221 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/core/bits_math.h>
+#include <mrpt/core/round.h>
+#include <mrpt/maps/COccupancyGridMap2D.h>
+#include <mrpt/maps/CPointsMap.h>
+#include <mrpt/poses/CPose2D.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+// Shared implementation of the queries of COccupancyGridMap2D and
+// COccupancyGridMap2DSnapshot. `grid` is either of them, and `rowOf(cy)`
+// returns a pointer to the first cell of row `cy`, without bound checks.
+namespace mrpt::maps::internal
+{
+/** Value of the entries of the likelihood cache not computed yet */
+constexpr double LIKELIHOOD_CACHE_INVALID = 66;
+
+/** Distance to the closest occupied cell around (x,y), up to
+ * `maxSearchDistance`, or 0 if there are no free cells next to (x,y).
+ * \sa COccupancyGridMap2D::computeClearance() */
+template <class GRID, class ROW_ACCESSOR>
+float computeClearance(
+	const GRID& grid, ROW_ACCESSOR&& rowOf, float x, float y,
+	float maxSearchDistance)
+{
+	using cellType = COccupancyGridMap2D::cellType;
+
+	const int size_x = static_cast<int>(grid.getSizeX());
+	const int size_y = static_cast<int>(grid.getSizeY());
+	if (!size_x || !size_y) return 0;
+
+	const int xx1 = std::max(0, grid.x2idx(x - maxSearchDistance));
+	const int xx2 = std::min(size_x - 1, grid.x2idx(x + maxSearchDistance));
+	const int yy1 = std::max(0, grid.y2idx(y - maxSearchDistance));
+	const int yy2 = std::min(size_y - 1, grid.y2idx(y + maxSearchDistance));
+
+	const int cx = grid.x2idx(x);
+	const int cy = grid.y2idx(y);
+
+	const float resolution = grid.getResolution();
+	float clearance_sq = square(maxSearchDistance);
+	const cellType thresholdCellValue = COccupancyGridMap2D::p2l(0.5f);
+
+	// At least 1 free cell nearby!
+	bool atLeastOneFree = false;
+	for (int xx = cx - 1; !atLeastOneFree && xx <= cx + 1; xx++)
+		for (int yy = cy - 1; !atLeastOneFree && yy <= cy + 1; yy++)
+			if (grid.getCell(xx, yy) > 0.505f) atLeastOneFree = true;
+
+	if (!atLeastOneFree) return 0;
+
+	for (int yy = yy1; yy <= yy2; yy++)
+	{
+		const cellType* row = rowOf(yy);
+		for (int xx = xx1; xx <= xx2; xx++)
+			if (row[xx] < thresholdCellValue)
+				clearance_sq = std::min(
+					clearance_sq,
+					square(resolution) * (square(xx - cx) + square(yy - cy)));
+	}
+
+	return std::sqrt(clearance_sq);
+}
+
+/** Likelihood field (Thrun's) of the points in `pm`, transformed by
+ * `relativePose` if not nullptr. `cacheEntry(cx,cy)` returns a pointer to
+ * the cached likelihood of a cell, LIKELIHOOD_CACHE_INVALID if not computed
+ * yet, or nullptr if there is no cache.
+ * \sa COccupancyGridMap2D::computeLikelihoodField_Thrun() */
+template <class GRID, class ROW_ACCESSOR, class CACHE_ACCESSOR>
+double computeLikelihoodField_Thrun(
+	const GRID& grid, ROW_ACCESSOR&& rowOf, CACHE_ACCESSOR&& cacheEntry,
+	const CPointsMap& pm, const mrpt::poses::CPose2D* relativePose,
+	const COccupancyGridMap2D::TLikelihoodOptions& opts)
+{
+	using cellType = COccupancyGridMap2D::cellType;
+
+	const size_t N = pm.size();
+	if (!N) return -100;  // No way to estimate this likelihood!!
+
+	const float resolution = grid.getResolution();
+
+	// The size of the checking area for matchings:
+	const int K = static_cast<int>(
+		std::ceil(opts.LF_maxCorrsDistance /*m*/ / resolution));
+
+	const bool Product_T_OrSum_F = !opts.LF_alternateAverageMethod;
+
+	const float zHit = opts.LF_zHit;
+	const float zRandomTerm = opts.LF_zRandom / opts.LF_maxRange;
+	const float Q = -0.5f / square(opts.LF_stdHit);
+
+	const double maxCorrDist_sq = square(opts.LF_maxCorrsDistance);
+	const double minimumLik = zRandomTerm + zHit * std::exp(Q * maxCorrDist_sq);
+
+	const cellType thresholdCellValue = COccupancyGridMap2D::p2l(0.5f);
+	const size_t decimation = N < 10 ? 1 : opts.LF_decimation;
+
+	const double constDist2DiscrUnits = 100 / square(double(resolution));
+	const double constDist2DiscrUnits_INV = 1.0 / constDist2DiscrUnits;
+
+	const int size_x_1 = static_cast<int>(grid.getSizeX()) - 1;
+	const int size_y_1 = static_cast<int>(grid.getSizeY()) - 1;
+
+	double ccos = 1, ssin = 0;
+	if (relativePose)
+	{
+		ccos = std::cos(relativePose->phi());
+		ssin = std::sin(relativePose->phi());
+	}
+
+	double ret = 0;
+	int M = 0;
+	mrpt::math::TPoint2D pointLocal, pointGlobal;
+
+	for (size_t j = 0; j < N; j += decimation)
+	{
+		// Get the point and pass it to global coordinates:
+		if (relativePose)
+		{
+			pm.getPoint(j, pointLocal);
+			pointGlobal.x =
+				relativePose->x() + pointLocal.x * ccos - pointLocal.y * ssin;
+			pointGlobal.y =
+				relativePose->y() + pointLocal.x * ssin + pointLocal.y * ccos;
+		}
+		else
+			pm.getPoint(j, pointGlobal);
+
+		// Point to cell indixes
+		const int cx = grid.x2idx(pointGlobal.x);
+		const int cy = grid.y2idx(pointGlobal.y);
+
+		double thisLik;
+		// Tip: Comparison cx<0 is implicit in (unsigned)(x)>size...
+		if (static_cast<unsigned>(cx) >= static_cast<unsigned>(size_x_1) ||
+			static_cast<unsigned>(cy) >= static_cast<unsigned>(size_y_1))
+		{
+			// We are outside of the map: Assign the likelihood for the max.
+			// correspondence distance:
+			thisLik = minimumLik;
+		}
+		else
+		{
+			// We are into the map limits:
+			std::atomic<double>* cached = cacheEntry(cx, cy);
+			thisLik = cached ? cached->load(std::memory_order_relaxed)
+							 : LIKELIHOOD_CACHE_INVALID;
+
+			if (thisLik == LIKELIHOOD_CACHE_INVALID)
+			{
+				// Find the closest occupied cell within K cells.
+				// Optimized code: this part will be invoked a *lot* of times:
+				const int xx1 = std::max(0, cx - K);
+				const int xx2 = std::min(size_x_1, cx + K);
+				const int yy1 = std::max(0, cy - K);
+				const int yy2 = std::min(size_y_1, cy + K);
+
+				const signed int Ax0 = 10 * (xx1 - cx);
+				signed int Ay = 10 * (yy1 - cy);
+
+				unsigned int occupiedMinDistInt =
+					mrpt::round(maxCorrDist_sq * constDist2DiscrUnits);
+
+				for (int yy = yy1; yy <= yy2; yy++)
+				{
+					// Square is faster with unsigned:
+					const unsigned int Ay2 = square((unsigned int)(Ay));
+					signed short Ax = Ax0;
+					const cellType* mapPtr = rowOf(yy) + xx1;
+
+					for (int xx = xx1; xx <= xx2; xx++)
+					{
+						if (*mapPtr++ < thresholdCellValue)
+						{
+							const unsigned int d =
+								square((unsigned int)(Ax)) + Ay2;
+							keep_min(occupiedMinDistInt, d);
+						}
+						Ax += 10;
+					}
+					// Go to (xx1,yy++)
+					Ay += 10;
+				}
+
+				float occupiedMinDist =
+					occupiedMinDistInt * constDist2DiscrUnits_INV;
+				if (opts.LF_useSquareDist) occupiedMinDist *= occupiedMinDist;
+
+				thisLik = zRandomTerm + zHit * std::exp(Q * occupiedMinDist);
+
+				if (cached) cached->store(thisLik, std::memory_order_relaxed);
+			}
+		}
+
+		// Update the likelihood:
+		if (Product_T_OrSum_F) ret += std::log(thisLik);
+		else
+		{
+			ret += thisLik;
+			M++;
+		}
+	}  // end of for each point in the scan
+
+	if (!Product_T_OrSum_F) ret = std::log(ret / M);
+
+	return ret;
+}
+
+}  // namespace mrpt::maps::internal
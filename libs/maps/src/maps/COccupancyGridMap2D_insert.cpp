@@ -11,6 +11,7 @@
 //
 #include <mrpt/core/round.h>  // round()
 #include <mrpt/maps/COccupancyGridMap2D.h>
+#include <mrpt/maps/COccupancyGridMap2DSnapshot.h>
 #include <mrpt/obs/CObservation2DRangeScan.h>
 #include <mrpt/obs/CObservationRange.h>
 #include <mrpt/serialization/CArchive.h>
@@ -51,9 +52,9 @@ bool COccupancyGridMap2D::internal_insertObservation(
 	CPose2D robotPose2D;
 	CPose3D robotPose3D;
 
-	// This is required to indicate the grid map has changed!
-	// For the precomputed likelihood trick:
-	m_likelihoodCacheOutDated = true;
+	// Note: the grid map changes are tracked for the precomputed likelihood
+	// trick via markAreaAsModified() below, so only the affected region of
+	// the cache gets invalidated.
 
 	if (robotPose)
 	{
@@ -216,6 +217,12 @@ bool COccupancyGridMap2D::internal_insertObservation(
 					new_y_min = min(new_y_min, *scanPoint_y);
 				}
 
+				// The area which will be modified by the rays:
+				const float mod_x_min = min(new_x_min, px);
+				const float mod_x_max = max(new_x_max, px);
+				const float mod_y_min = min(new_y_min, py);
+				const float mod_y_max = max(new_y_max, py);
+
 				// Add an extra margin:
 				float securMargen = 15 * m_resolution;
 
@@ -239,10 +246,7 @@ bool COccupancyGridMap2D::internal_insertObservation(
 				//   Resize to make room:
 				// -----------------------
 				resizeGrid(new_x_min, new_x_max, new_y_min, new_y_max, 0.5);
-
-				// For updateCell_fast methods:
-				cellType* theMapArray = &m_map[0];
-				unsigned theMapSize_x = m_size_x;
+				markAreaAsModified(mod_x_min, mod_x_max, mod_y_min, mod_y_max);
 
 				int cx0 =
 					x2idx(px);	// Remember: This must be after the resizeGrid!!
@@ -293,11 +297,18 @@ bool COccupancyGridMap2D::internal_insertObservation(
 						? logodd_observation_free
 						: logodd_noecho_free;
 
+					// Only look up the row (and unshare it) when cy changes:
+					int rowCy = -1;
+					cellType* row = nullptr;
 					for (int nStep = 0; nStep < nStepsRay; nStep++)
 					{
+						if (cy != rowCy)
+						{
+							row = cellRowForWrite(cy);
+							rowCy = cy;
+						}
 						updateCell_fast_free(
-							cx, cy, logodd_free, logodd_thres_free, theMapArray,
-							theMapSize_x);
+							row + cx, logodd_free, logodd_thres_free);
 
 						frCX += frAcx;
 						frCY += frAcy;
@@ -313,8 +324,8 @@ bool COccupancyGridMap2D::internal_insertObservation(
 					if (o.getScanRangeValidity(idx) &&
 						o.getScanRange(idx) < maxDistanceInsertion)
 						updateCell_fast_occupied(
-							trg_cx, trg_cy, logodd_observation_occupied,
-							logodd_thres_occupied, theMapArray, theMapSize_x);
+							cellRowForWrite(trg_cy) + trg_cx,
+							logodd_observation_occupied, logodd_thres_occupied);
 
 				}  // End of each range
 
@@ -382,6 +393,12 @@ bool COccupancyGridMap2D::internal_insertObservation(
 					new_y_min = min(new_y_min, scanPoint_y);
 				}
 
+				// The area which will be modified by the rays:
+				const float mod_x_min = min(new_x_min, px);
+				const float mod_x_max = max(new_x_max, px);
+				const float mod_y_min = min(new_y_min, py);
+				const float mod_y_max = max(new_y_max, py);
+
 				// Add an extra margin:
 				float securMargen = 15 * m_resolution;
 
@@ -405,10 +422,7 @@ bool COccupancyGridMap2D::internal_insertObservation(
 				//   Resize to make room:
 				// -----------------------
 				resizeGrid(new_x_min, new_x_max, new_y_min, new_y_max, 0.5);
-
-				// For updateCell_fast methods:
-				cellType* theMapArray = &m_map[0];
-				unsigned theMapSize_x = m_size_x;
+				markAreaAsModified(mod_x_min, mod_x_max, mod_y_min, mod_y_max);
 
 				// int  cx0 = x2idx(px);		// Remember: This must be after
 				// the
@@ -514,10 +528,11 @@ bool COccupancyGridMap2D::internal_insertObservation(
 						int min_cx = min3(P0.cx, P1.cx, P2.cx);
 						int max_cx = max3(P0.cx, P1.cx, P2.cx);
 
+						cellType* row = cellRowForWrite(P0.cy);
 						for (int ccx = min_cx; ccx <= max_cx; ccx++)
 							updateCell_fast_free(
-								ccx, P0.cy, logodd_observation_free,
-								logodd_thres_free, theMapArray, theMapSize_x);
+								row + ccx,
+								logodd_observation_free, logodd_thres_free);
 					}
 					else
 					{
@@ -600,11 +615,11 @@ bool COccupancyGridMap2D::internal_insertObservation(
 								last_insert_cy = R1.cy;
 								//	last_insert_cx = R1.cx;
 
+								cellType* row = cellRowForWrite(R1.cy);
 								for (int ccx = R1.cx; ccx <= R2.cx; ccx++)
 									updateCell_fast_free(
-										ccx, R1.cy, logodd_observation_free,
-										logodd_thres_free, theMapArray,
-										theMapSize_x);
+										row + ccx, logodd_observation_free,
+										logodd_thres_free);
 							}
 
 							R1.frX += frAx_R1;
@@ -688,11 +703,11 @@ bool COccupancyGridMap2D::internal_insertObservation(
 							{
 								//	last_insert_cx = R1.cx;
 								last_insert_cy = R1.cy;
+								cellType* row = cellRowForWrite(R1.cy);
 								for (int ccx = R1.cx; ccx <= R2.cx; ccx++)
 									updateCell_fast_free(
-										ccx, R1.cy, logodd_observation_free,
-										logodd_thres_free, theMapArray,
-										theMapSize_x);
+										row + ccx, logodd_observation_free,
+										logodd_thres_free);
 							}
 
 							R1.frX += frAx_R1;
@@ -742,9 +757,9 @@ bool COccupancyGridMap2D::internal_insertObservation(
 						if (P2.cx == P1.cx && P2.cy == P1.cy)
 						{
 							updateCell_fast_occupied(
-								P1.cx, P1.cy, logodd_observation_occupied,
-								logodd_thres_occupied, theMapArray,
-								theMapSize_x);
+								cellRowForWrite(P1.cy) + P1.cx,
+								logodd_observation_occupied,
+								logodd_thres_occupied);
 						}
 						else
 						{
@@ -769,12 +784,18 @@ bool COccupancyGridMap2D::internal_insertObservation(
 							R1.frX = R1.cx << FRBITS;
 							R1.frY = R1.cy << FRBITS;
 
+							int rowCy = -1;
+							cellType* row = nullptr;
 							for (int nStep = 0; nStep <= nSteps; nStep++)
 							{
+								if (R1.cy != rowCy)
+								{
+									row = cellRowForWrite(R1.cy);
+									rowCy = R1.cy;
+								}
 								updateCell_fast_occupied(
-									R1.cx, R1.cy, logodd_observation_occupied,
-									logodd_thres_occupied, theMapArray,
-									theMapSize_x);
+									row + R1.cx, logodd_observation_occupied,
+									logodd_thres_occupied);
 
 								R1.frX += frAcxE;
 								R1.frY += frAcyE;
@@ -922,10 +943,10 @@ bool COccupancyGridMap2D::internal_insertObservation(
 			//   Resize to make room:
 			// -----------------------
 			resizeGrid(new_x_min, new_x_max, new_y_min, new_y_max, 0.5);
-
-			// For updateCell_fast methods:
-			cellType* theMapArray = &m_map[0];
-			unsigned theMapSize_x = m_size_x;
+			// Sonar cones may extend beyond the beam axis: be conservative.
+			markAreaAsModified(
+				px - maxDistanceInsertion, px + maxDistanceInsertion,
+				py - maxDistanceInsertion, py + maxDistanceInsertion);
 
 			// int  cx0 = x2idx(px);		// Remember: This must be after the
 			// resizeGrid!!
@@ -1021,10 +1042,11 @@ bool COccupancyGridMap2D::internal_insertObservation(
 					int min_cx = min3(P0.cx, P1.cx, P2.cx);
 					int max_cx = max3(P0.cx, P1.cx, P2.cx);
 
+					cellType* row = cellRowForWrite(P0.cy);
 					for (int ccx = min_cx; ccx <= max_cx; ccx++)
 						updateCell_fast_free(
-							ccx, P0.cy, logodd_observation_free,
-							logodd_thres_free, theMapArray, theMapSize_x);
+							row + ccx,
+							logodd_observation_free, logodd_thres_free);
 				}
 				else
 				{
@@ -1106,11 +1128,11 @@ bool COccupancyGridMap2D::internal_insertObservation(
 							last_insert_cy = R1.cy;
 							//	last_insert_cx = R1.cx;
 
+							cellType* row = cellRowForWrite(R1.cy);
 							for (int ccx = R1.cx; ccx <= R2.cx; ccx++)
 								updateCell_fast_free(
-									ccx, R1.cy, logodd_observation_free,
-									logodd_thres_free, theMapArray,
-									theMapSize_x);
+									row + ccx,
+									logodd_observation_free, logodd_thres_free);
 						}
 
 						R1.frX += frAx_R1;
@@ -1193,11 +1215,11 @@ bool COccupancyGridMap2D::internal_insertObservation(
 						{
 							//	last_insert_cx = R1.cx;
 							last_insert_cy = R1.cy;
+							cellType* row = cellRowForWrite(R1.cy);
 							for (int ccx = R1.cx; ccx <= R2.cx; ccx++)
 								updateCell_fast_free(
-									ccx, R1.cy, logodd_observation_free,
-									logodd_thres_free, theMapArray,
-									theMapSize_x);
+									row + ccx,
+									logodd_observation_free, logodd_thres_free);
 						}
 
 						R1.frX += frAx_R1;
@@ -1246,8 +1268,8 @@ bool COccupancyGridMap2D::internal_insertObservation(
 					if (P2.cx == P1.cx && P2.cy == P1.cy)
 					{
 						updateCell_fast_occupied(
-							P1.cx, P1.cy, logodd_observation_occupied,
-							logodd_thres_occupied, theMapArray, theMapSize_x);
+							cellRowForWrite(P1.cy) + P1.cx,
+							logodd_observation_occupied, logodd_thres_occupied);
 					}
 					else
 					{
@@ -1272,12 +1294,18 @@ bool COccupancyGridMap2D::internal_insertObservation(
 						R1.frX = R1.cx << FRBITS;
 						R1.frY = R1.cy << FRBITS;
 
+						int rowCy = -1;
+						cellType* row = nullptr;
 						for (int nStep = 0; nStep <= nSteps; nStep++)
 						{
+							if (R1.cy != rowCy)
+							{
+								row = cellRowForWrite(R1.cy);
+								rowCy = R1.cy;
+							}
 							updateCell_fast_occupied(
-								R1.cx, R1.cy, logodd_observation_occupied,
-								logodd_thres_occupied, theMapArray,
-								theMapSize_x);
+								row + R1.cx, logodd_observation_occupied,
+								logodd_thres_occupied);
 
 							R1.frX += frAcxE;
 							R1.frY += frAcyE;
@@ -1327,6 +1355,7 @@ void COccupancyGridMap2D::TInsertionOptions::loadFromConfigFile(
 	MRPT_LOAD_CONFIG_VAR(CFD_features_gaussian_size, float, iniFile, section);
 	MRPT_LOAD_CONFIG_VAR(CFD_features_median_size, float, iniFile, section);
 	MRPT_LOAD_CONFIG_VAR(wideningBeamsWithDistance, bool, iniFile, section);
+	MRPT_LOAD_CONFIG_VAR(publishSnapshots, bool, iniFile, section);
 }
 
 /*---------------------------------------------------------------
@@ -1351,6 +1380,7 @@ void COccupancyGridMap2D::TInsertionOptions::dumpToTextStream(
 	LOADABLEOPTS_DUMP_VAR(CFD_features_gaussian_size, float)
 	LOADABLEOPTS_DUMP_VAR(CFD_features_median_size, float)
 	LOADABLEOPTS_DUMP_VAR(wideningBeamsWithDistance, bool)
+	LOADABLEOPTS_DUMP_VAR(publishSnapshots, bool)
 
 	out << "\n";
 }
@@ -1359,4 +1389,27 @@ void COccupancyGridMap2D::OnPostSuccesfulInsertObs(
 	const mrpt::obs::CObservation&)
 {
 	m_is_empty = false;
+
+	if (insertionOptions.publishSnapshots) publishSnapshot();
+}
+
+void COccupancyGridMap2D::markAreaAsModified(
+	float x_min, float x_max, float y_min, float y_max)
+{
+	// One extra cell of margin for rounding in ray tracing:
+	m_likelihoodCacheModifiedArea.extend(
+		x2idx(x_min) - 1, x2idx(x_max) + 1, y2idx(y_min) - 1,
+		y2idx(y_max) + 1);
+}
+
+void COccupancyGridMap2D::publishSnapshot()
+{
+	auto snap = COccupancyGridMap2DSnapshot::Create(*this, getSnapshot());
+	std::atomic_store(&m_snapshot, snap);
+}
+
+std::shared_ptr<const COccupancyGridMap2DSnapshot>
+	COccupancyGridMap2D::getSnapshot() const
+{
+	return std::atomic_load(&m_snapshot);
 }
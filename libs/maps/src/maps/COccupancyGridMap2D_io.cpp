@@ -70,13 +70,16 @@ void COccupancyGridMap2D::serializeTo(mrpt::serialization::CArchive& out) const
 
 	out << m_size_x << m_size_y << m_xMin << m_xMax << m_yMin << m_yMax
 		<< m_resolution;
-	ASSERT_(m_size_x * m_size_y == m_map.size());
 
+	// Cells, row by row (each band holds a contiguous block of full rows):
+	for (const auto& band : m_map)
+	{
 #ifdef OCCUPANCY_GRIDMAP_CELL_SIZE_8BITS
-	out.WriteBuffer(&m_map[0], sizeof(m_map[0]) * m_size_x * m_size_y);
+		out.WriteBuffer(band->data(), sizeof(cellType) * band->size());
 #else
-	out.WriteBufferFixEndianness(&map[0], size_x * m_size_y);
+		out.WriteBufferFixEndianness(band->data(), band->size());
 #endif
+	}
 
 	// insertionOptions:
 	out << insertionOptions.mapAltitude << insertionOptions.useMapAltitude
@@ -152,57 +155,60 @@ void COccupancyGridMap2D::serializeFrom(
 				new_x_min, new_x_max, new_y_min, new_y_max, new_resolution,
 				0.5);
 
-			ASSERT_(m_size_x * m_size_y == m_map.size());
-
-			if (bitsPerCellStream == MyBitsPerCell)
+			// Cells, row by row. Bands are freshly allocated by setSize(),
+			// hence never shared at this point:
+			for (auto& band : m_map)
 			{
+				if (bitsPerCellStream == MyBitsPerCell)
+				{
 // Perfect:
 #ifdef OCCUPANCY_GRIDMAP_CELL_SIZE_8BITS
-				in.ReadBuffer(&m_map[0], sizeof(m_map[0]) * m_map.size());
+					in.ReadBuffer(band->data(), sizeof(cellType) * band->size());
 #else
-				in.ReadBufferFixEndianness(&map[0], map.size());
+					in.ReadBufferFixEndianness(band->data(), band->size());
 #endif
-			}
-			else
-			{
+				}
+				else
+				{
 // We must do a conversion...
 #ifdef OCCUPANCY_GRIDMAP_CELL_SIZE_8BITS
-				// We are 8-bit, stream is 16-bit
-				ASSERT_(bitsPerCellStream == 16);
-				std::vector<uint16_t> auxMap(m_map.size());
-				in.ReadBuffer(&auxMap[0], sizeof(auxMap[0]) * auxMap.size());
-
-				size_t i, N = m_map.size();
-				auto* ptrTrg = (uint8_t*)&m_map[0];
-				const auto* ptrSrc = (const uint16_t*)&auxMap[0];
-				for (i = 0; i < N; i++)
-					*ptrTrg++ = (*ptrSrc++) >> 8;
+					// We are 8-bit, stream is 16-bit
+					ASSERT_(bitsPerCellStream == 16);
+					std::vector<uint16_t> auxMap(band->size());
+					in.ReadBuffer(
+						&auxMap[0], sizeof(auxMap[0]) * auxMap.size());
+
+					size_t i, N = band->size();
+					auto* ptrTrg = (uint8_t*)band->data();
+					const auto* ptrSrc = (const uint16_t*)&auxMap[0];
+					for (i = 0; i < N; i++)
+						*ptrTrg++ = (*ptrSrc++) >> 8;
 #else
-				// We are 16-bit, stream is 8-bit
-				ASSERT_(bitsPerCellStream == 8);
-				std::vector<uint8_t> auxMap(map.size());
-				in.ReadBuffer(&auxMap[0], sizeof(auxMap[0]) * auxMap.size());
-
-				size_t i, N = map.size();
-				uint16_t* ptrTrg = (uint16_t*)&map[0];
-				const uint8_t* ptrSrc = (const uint8_t*)&auxMap[0];
-				for (i = 0; i < N; i++)
-					*ptrTrg++ = (*ptrSrc++) << 8;
+					// We are 16-bit, stream is 8-bit
+					ASSERT_(bitsPerCellStream == 8);
+					std::vector<uint8_t> auxMap(band->size());
+					in.ReadBuffer(
+						&auxMap[0], sizeof(auxMap[0]) * auxMap.size());
+
+					size_t i, N = band->size();
+					uint16_t* ptrTrg = (uint16_t*)band->data();
+					const uint8_t* ptrSrc = (const uint8_t*)&auxMap[0];
+					for (i = 0; i < N; i++)
+						*ptrTrg++ = (*ptrSrc++) << 8;
 #endif
-			}
+				}
 
-			// If we are converting an old dump, convert from probabilities to
-			// log-odds:
-			if (version < 3)
-			{
-				size_t i, N = m_map.size();
-				cellType* ptr = &m_map[0];
-				for (i = 0; i < N; i++)
+				// If we are converting an old dump, convert from
+				// probabilities to log-odds:
+				if (version < 3)
 				{
-					double p = cellTypeUnsigned(*ptr) * (1.0f / 0xFF);
-					if (p < 0) p = 0;
-					if (p > 1) p = 1;
-					*ptr++ = p2l(p);
+					for (cellType& c : *band)
+					{
+						double p = cellTypeUnsigned(c) * (1.0f / 0xFF);
+						if (p < 0) p = 0;
+						if (p > 1) p = 1;
+						c = p2l(p);
+					}
 				}
 			}
 
@@ -9,12 +9,15 @@
 
 #include "maps-precomp.h"  // Precomp header
 //
+#include <mrpt/core/lock_helper.h>
 #include <mrpt/maps/COccupancyGridMap2D.h>
 #include <mrpt/maps/CSimplePointsMap.h>
 #include <mrpt/obs/CObservation2DRangeScan.h>
 #include <mrpt/obs/CObservationRange.h>
 #include <mrpt/serialization/CArchive.h>
 
+#include "COccupancyGridMap2D_impl.h"
+
 using namespace mrpt;
 using namespace mrpt::math;
 using namespace mrpt::maps;
@@ -513,185 +516,59 @@ double COccupancyGridMap2D::computeLikelihoodField_Thrun(
 {
 	MRPT_START
 
-	double ret;
-	size_t N = pm->size();
-	int K = (int)ceil(
-		likelihoodOptions.LF_maxCorrsDistance /*m*/ /
-		m_resolution);	// The size of the checking area for matchings:
-
-	bool Product_T_OrSum_F = !likelihoodOptions.LF_alternateAverageMethod;
-
-	if (!N)
-	{
-		return -100;  // No way to estimate this likelihood!!
-	}
-
-	// Compute the likelihoods for each point:
-	ret = 0;
-
-	float stdHit = likelihoodOptions.LF_stdHit;
-	float zHit = likelihoodOptions.LF_zHit;
-	float zRandom = likelihoodOptions.LF_zRandom;
-	float zRandomMaxRange = likelihoodOptions.LF_maxRange;
-	float zRandomTerm = zRandom / zRandomMaxRange;
-	float Q = -0.5f / square(stdHit);
-	int M = 0;
-
-	unsigned int size_x_1 = m_size_x - 1;
-	unsigned int size_y_1 = m_size_y - 1;
-
-#define LIK_LF_CACHE_INVALID (66)
-
-	// Aux. variables for the "for j" loop:
-	double thisLik = LIK_LF_CACHE_INVALID;
-	double maxCorrDist_sq = square(likelihoodOptions.LF_maxCorrsDistance);
-	double minimumLik = zRandomTerm + zHit * exp(Q * maxCorrDist_sq);
-	double ccos, ssin;
-
-	if (likelihoodOptions.enableLikelihoodCache)
+	const bool useCache = likelihoodOptions.enableLikelihoodCache;
+	if (useCache)
 	{
-		// Reset the precomputed likelihood values map
-		if (m_likelihoodCacheOutDated)
+		// The size of the checking area for matchings:
+		const int K = (int)ceil(
+			likelihoodOptions.LF_maxCorrsDistance /*m*/ / m_resolution);
+
+		// Reset the precomputed likelihood values map. Several threads may
+		// get here at once for the same grid:
+		auto& cache = m_precomputedLikelihood;
+		auto lck = mrpt::lockHelper(cache.mtx);
+		if (m_likelihoodCacheOutDated || cache.bands.size() != m_map.size() ||
+			(!m_map.empty() &&
+			 cache.bands[0]->values.size() != m_map[0]->size()))
 		{
-			if (!m_map.empty())
-				m_precomputedLikelihood.assign(
-					m_map.size(), LIK_LF_CACHE_INVALID);
-			else
-				m_precomputedLikelihood.clear();
-
+			cache.bands.clear();
+			cache.bands.reserve(m_map.size());
+			for (const auto& band : m_map)
+				cache.bands.emplace_back(
+					std::make_shared<TLikelihoodCacheBand>(
+						band->size(), internal::LIKELIHOOD_CACHE_INVALID));
 			m_likelihoodCacheOutDated = false;
 		}
-	}
-
-	cellType thresholdCellValue = p2l(0.5f);
-	int decimation = likelihoodOptions.LF_decimation;
-
-	const double _resolution = this->m_resolution;
-	const double constDist2DiscrUnits = 100 / (_resolution * _resolution);
-	const double constDist2DiscrUnits_INV = 1.0 / constDist2DiscrUnits;
-
-	if (N < 10) decimation = 1;
-
-	TPoint2D pointLocal;
-	TPoint2D pointGlobal;
-
-	for (size_t j = 0; j < N; j += decimation)
-	{
-		// Get the point and pass it to global coordinates:
-		if (relativePose)
-		{
-			pm->getPoint(j, pointLocal);
-// pointGlobal = *relativePose + pointLocal;
-#ifdef HAVE_SINCOS
-			::sincos(relativePose->phi(), &ssin, &ccos);
-#else
-			ccos = cos(relativePose->phi());
-			ssin = sin(relativePose->phi());
-#endif
-			pointGlobal.x =
-				relativePose->x() + pointLocal.x * ccos - pointLocal.y * ssin;
-			pointGlobal.y =
-				relativePose->y() + pointLocal.x * ssin + pointLocal.y * ccos;
-		}
-		else
+		else if (!m_likelihoodCacheModifiedArea.empty())
 		{
-			pm->getPoint(j, pointGlobal);
-		}
-
-		// Point to cell indixes
-		int cx = x2idx(pointGlobal.x);
-		int cy = y2idx(pointGlobal.y);
-
-		// Precomputed table:
-		// Tip: Comparison cx<0 is implicit in (unsigned)(x)>size...
-		if (static_cast<unsigned>(cx) >= size_x_1 ||
-			static_cast<unsigned>(cy) >= size_y_1)
-		{
-			// We are outside of the map: Assign the likelihood for the max.
-			// correspondence distance:
-			thisLik = minimumLik;
-		}
-		else
-		{
-			// We are into the map limits:
-			if (likelihoodOptions.enableLikelihoodCache)
-			{ thisLik = m_precomputedLikelihood[cx + cy * m_size_x]; }
-
-			if (!likelihoodOptions.enableLikelihoodCache ||
-				thisLik == LIK_LF_CACHE_INVALID)
+			// Only invalidate the cached values which may depend on the
+			// modified cells, i.e. those within K cells from them, copying
+			// first the bands shared with other maps:
+			const auto& a = m_likelihoodCacheModifiedArea;
+			const int x0 = max(0, a.min_cx - K);
+			const int x1 = min<int>(m_size_x - 1, a.max_cx + K);
+			const int y0 = max(0, a.min_cy - K);
+			const int y1 = min<int>(m_size_y - 1, a.max_cy + K);
+			for (int cy = y0; cy <= y1; cy++)
 			{
-				// Compute now:
-				// -------------
-				// Find the closest occupied cell in a certain range, given by
-				// K:
-				int xx1 = max(0, cx - K);
-				int xx2 = min(size_x_1, (unsigned)(cx + K));
-				int yy1 = max(0, cy - K);
-				int yy2 = min(size_y_1, (unsigned)(cy + K));
-
-				// Optimized code: this part will be invoked a *lot* of times:
-				float occupiedMinDist;
-				{
-					// Initial pointer position
-					const cellType* mapPtr = &m_map[xx1 + yy1 * m_size_x];
-					unsigned incrAfterRow = m_size_x - ((xx2 - xx1) + 1);
-
-					signed int Ax0 = 10 * (xx1 - cx);
-					signed int Ay = 10 * (yy1 - cy);
-
-					unsigned int occupiedMinDistInt =
-						mrpt::round(maxCorrDist_sq * constDist2DiscrUnits);
-
-					for (int yy = yy1; yy <= yy2; yy++)
-					{
-						unsigned int Ay2 =
-							square((unsigned int)(Ay));	 // Square is faster
-						// with unsigned.
-						signed short Ax = Ax0;
-						cellType cell;
-
-						for (int xx = xx1; xx <= xx2; xx++)
-						{
-							if ((cell = *mapPtr++) < thresholdCellValue)
-							{
-								unsigned int d =
-									square((unsigned int)(Ax)) + Ay2;
-								keep_min(occupiedMinDistInt, d);
-							}
-							Ax += 10;
-						}
-						// Go to (xx1,yy++)
-						mapPtr += incrAfterRow;
-						Ay += 10;
-					}
-
-					occupiedMinDist =
-						occupiedMinDistInt * constDist2DiscrUnits_INV;
-				}
-
-				if (likelihoodOptions.LF_useSquareDist)
-					occupiedMinDist *= occupiedMinDist;
-
-				thisLik = zRandomTerm + zHit * exp(Q * occupiedMinDist);
-
-				if (likelihoodOptions.enableLikelihoodCache)
-					// And save it into the table and into "thisLik":
-					m_precomputedLikelihood[cx + cy * m_size_x] = thisLik;
+				auto& band = cache.bands[cy >> CELL_BAND_LOG2];
+				if (band.use_count() > 1)
+					band = std::make_shared<TLikelihoodCacheBand>(*band);
+				for (int cx = x0; cx <= x1; cx++)
+					likelihoodCacheEntry(cx, cy).store(
+						internal::LIKELIHOOD_CACHE_INVALID,
+						std::memory_order_relaxed);
 			}
 		}
+		m_likelihoodCacheModifiedArea.clear();
+	}
 
-		// Update the likelihood:
-		if (Product_T_OrSum_F) { ret += log(thisLik); }
-		else
-		{
-			ret += thisLik;
-			M++;
-		}
-	}  // end of for each point in the scan
-
-	if (!Product_T_OrSum_F) ret = log(ret / M);
-
-	return ret;
+	return internal::computeLikelihoodField_Thrun(
+		*this, [this](unsigned int cy) { return cellRow(cy); },
+		[this, useCache](unsigned int cx, unsigned int cy) {
+			return useCache ? &likelihoodCacheEntry(cx, cy) : nullptr;
+		},
+		*pm, relativePose, likelihoodOptions);
 
 	MRPT_END
 }
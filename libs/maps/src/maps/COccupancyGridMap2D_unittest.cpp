@@ -8,7 +8,10 @@
    +------------------------------------------------------------------------+ */
 
 #include <gtest/gtest.h>
+#include <mrpt/core/parallel_for.h>
 #include <mrpt/maps/COccupancyGridMap2D.h>
+#include <mrpt/maps/COccupancyGridMap2DSnapshot.h>
+#include <mrpt/maps/CSimplePointsMap.h>
 #include <mrpt/obs/CObservation2DRangeScan.h>
 #include <mrpt/obs/stock_observations.h>
 //
@@ -37,6 +40,190 @@ TEST(COccupancyGridMap2DTests, insert2DScan)
 	}
 }
 
+TEST(COccupancyGridMap2DTests, snapshots)
+{
+	mrpt::obs::CObservation2DRangeScan scan1;
+	stock_observations::example2DRangeScan(scan1);
+
+	COccupancyGridMap2D grid(-50.0f, 50.0f, -50.0f, 50.0f, 0.10f);
+	EXPECT_FALSE(grid.getSnapshot());
+
+	grid.insertionOptions.publishSnapshots = true;
+	grid.insertObservation(scan1);
+
+	const auto snap1 = grid.getSnapshot();
+	ASSERT_TRUE(snap1);
+	EXPECT_EQ(snap1->epoch(), 1U);
+	EXPECT_EQ(snap1->getSizeX(), grid.getSizeX());
+	EXPECT_EQ(snap1->getSizeY(), grid.getSizeY());
+
+	// Same contents than the original grid:
+	std::vector<COccupancyGridMap2D::cellType> cells, gridCells;
+	snap1->getRawMapCopy(cells);
+	grid.getRawMapCopy(gridCells);
+	EXPECT_TRUE(cells == gridCells);
+	EXPECT_EQ(snap1->getPos(0.5, 0), grid.getPos(0.5, 0));
+	EXPECT_NEAR(
+		snap1->computeClearance(0.5, 0, 2.0f),
+		grid.computeClearance(0.5, 0, 2.0f), 1e-6);
+
+	CSimplePointsMap pts;
+	pts.loadFromRangeScan(scan1);
+	const CPose2D p(0.1, 0.05, 0.02);
+	grid.likelihoodOptions.enableLikelihoodCache = false;
+	EXPECT_NEAR(
+		snap1->computeLikelihoodField_Thrun(pts, &p, grid.likelihoodOptions),
+		grid.computeLikelihoodField_Thrun(&pts, &p), 1e-6);
+
+	// Modify one cell: readers holding the old version see no change, and
+	// untouched bands of rows are shared between versions and the grid:
+	const float oldValue = grid.getCell(10, 10);
+	grid.setCell(10, 10, 0.01f);
+	grid.publishSnapshot();
+	const auto snap2 = grid.getSnapshot();
+	ASSERT_TRUE(snap2);
+	EXPECT_EQ(snap2->epoch(), 2U);
+	EXPECT_NEAR(snap1->getCell(10, 10), oldValue, 1e-6);
+	EXPECT_NEAR(snap2->getCell(10, 10), grid.getCell(10, 10), 1e-6);
+	EXPECT_NE(snap1->getBand(0), snap2->getBand(0));
+	EXPECT_EQ(snap1->getBand(1), snap2->getBand(1));
+	const auto& cgrid = grid;
+	EXPECT_EQ(snap2->getRow(0), cgrid.getRow(0));
+
+	// Writing to the grid does not change the published version:
+	const auto* sharedRow = snap2->getRow(40);
+	grid.setCell(20, 40, 0.99f);
+	EXPECT_EQ(snap2->getRow(40), sharedRow);
+	EXPECT_NE(cgrid.getRow(40), sharedRow);
+	EXPECT_NEAR(snap2->getCell(20, 40), 0.5f, 0.02f);
+}
+
+TEST(COccupancyGridMap2DTests, likelihoodCacheIncrementalInvalidation)
+{
+	mrpt::obs::CObservation2DRangeScan scan1;
+	stock_observations::example2DRangeScan(scan1);
+
+	CSimplePointsMap pts;
+	pts.loadFromRangeScan(scan1);
+
+	COccupancyGridMap2D grid(-50.0f, 50.0f, -50.0f, 50.0f, 0.10f);
+	grid.insertObservation(scan1);
+
+	const CPose2D p(0.1, 0.05, 0.02);
+
+	// Fill in the cache:
+	grid.likelihoodOptions.enableLikelihoodCache = true;
+	grid.computeLikelihoodField_Thrun(&pts, &p);
+
+	// A copy shares the cache with the original one:
+	COccupancyGridMap2D copy = grid;
+	const double likBefore = grid.computeLikelihoodField_Thrun(&pts, &p);
+
+	// Modify the map: only part of the cache gets invalidated, but results
+	// must be identical to those without any cache:
+	grid.insertObservation(
+		scan1, mrpt::poses::CPose3D(0.3, 0.2, 0, 0.1, 0, 0));
+
+	const double likCached = grid.computeLikelihoodField_Thrun(&pts, &p);
+	grid.likelihoodOptions.enableLikelihoodCache = false;
+	const double likNoCache = grid.computeLikelihoodField_Thrun(&pts, &p);
+
+	EXPECT_NEAR(likCached, likNoCache, 1e-9);
+
+	// ...and must not affect the cache of the copy, which keeps filling in
+	// its shared parts:
+	const CPose2D p2(-0.2, 0.1, -0.05);
+	EXPECT_NEAR(copy.computeLikelihoodField_Thrun(&pts, &p), likBefore, 1e-9);
+	const double likCopyCached = copy.computeLikelihoodField_Thrun(&pts, &p2);
+	copy.likelihoodOptions.enableLikelihoodCache = false;
+	EXPECT_NEAR(
+		likCopyCached, copy.computeLikelihoodField_Thrun(&pts, &p2), 1e-9);
+}
+
+TEST(COccupancyGridMap2DTests, likelihoodCacheParallelReaders)
+{
+	mrpt::obs::CObservation2DRangeScan scan1;
+	stock_observations::example2DRangeScan(scan1);
+
+	CSimplePointsMap pts;
+	pts.loadFromRangeScan(scan1);
+
+	COccupancyGridMap2D grid(-50.0f, 50.0f, -50.0f, 50.0f, 0.10f);
+	grid.insertObservation(scan1);
+
+	// Several threads filling in the (initially outdated) cache at once must
+	// get the same values than a single thread without any cache:
+	const size_t nPoses = 64;
+	std::vector<double> liks(nPoses);
+	grid.likelihoodOptions.enableLikelihoodCache = true;
+	mrpt::parallelFor(nPoses, 1, 4, [&](size_t first, size_t last) {
+		for (size_t i = first; i < last; i++)
+		{
+			const CPose2D p(0.01 * i, -0.02 * i, 0.001 * i);
+			liks[i] = grid.computeLikelihoodField_Thrun(&pts, &p);
+		}
+	});
+
+	grid.likelihoodOptions.enableLikelihoodCache = false;
+	for (size_t i = 0; i < nPoses; i++)
+	{
+		const CPose2D p(0.01 * i, -0.02 * i, 0.001 * i);
+		EXPECT_NEAR(liks[i], grid.computeLikelihoodField_Thrun(&pts, &p), 1e-9);
+	}
+
+	// Copies of the grid keep the cached values:
+	grid.likelihoodOptions.enableLikelihoodCache = true;
+	const COccupancyGridMap2D gridCopy = grid;
+	const CPose2D p(0.1, 0.05, 0.02);
+	EXPECT_NEAR(
+		gridCopy.computeLikelihoodField_Thrun(&pts, &p),
+		grid.computeLikelihoodField_Thrun(&pts, &p), 1e-9);
+}
+
+TEST(COccupancyGridMap2DTests, copyOnWriteCells)
+{
+	mrpt::obs::CObservation2DRangeScan scan1;
+	stock_observations::example2DRangeScan(scan1);
+
+	COccupancyGridMap2D grid(-10.0f, 10.0f, -10.0f, 10.0f, 0.10f);
+	grid.insertObservation(scan1);
+	std::vector<COccupancyGridMap2D::cellType> cellsBefore, cells;
+	grid.getRawMapCopy(cellsBefore);
+
+	// Copies share all their cells until modified:
+	COccupancyGridMap2D copy = grid;
+	const auto& cgrid = grid;
+	const auto& ccopy = copy;
+	for (unsigned int cy = 0; cy < grid.getSizeY(); cy++)
+		EXPECT_EQ(cgrid.getRow(cy), ccopy.getRow(cy));
+
+	// Modify the copy: only the affected rows are detached:
+	const int cy = grid.getSizeY() - 1;
+	copy.setCell(3, cy, 0.9f);
+	copy.insertObservation(
+		scan1, mrpt::poses::CPose3D(0.3, 0.2, 0, 0.1, 0, 0));
+	EXPECT_NE(cgrid.getRow(cy), ccopy.getRow(cy));
+	EXPECT_EQ(cgrid.getRow(0), ccopy.getRow(0));
+
+	// The original must remain untouched:
+	grid.getRawMapCopy(cells);
+	EXPECT_TRUE(cellsBefore == cells);
+	copy.getRawMapCopy(cells);
+	EXPECT_FALSE(cellsBefore == cells);
+	EXPECT_NEAR(copy.getCell(3, cy), 0.9f, 0.02f);
+	EXPECT_NEAR(grid.getCell(3, cy), 0.5f, 0.02f);
+
+	// Grid growth keeps the contents:
+	COccupancyGridMap2D grown = grid;
+	grown.resizeGrid(-20.0f, 15.0f, -12.0f, 30.0f);
+	for (unsigned int y = 0; y < grid.getSizeY(); y += 7)
+		for (unsigned int x = 0; x < grid.getSizeX(); x += 5)
+			EXPECT_EQ(
+				cgrid.getRow(y)[x],
+				grown.getRow(grown.y2idx(grid.idx2y(y)))
+					[grown.x2idx(grid.idx2x(x))]);
+}
+
 // We need OPENCV to read the image.
 #if MRPT_HAS_OPENCV && MRPT_HAS_FYAML
 
@@ -12,6 +12,8 @@
 #include <mrpt/core/round.h>  // round()
 #include <mrpt/maps/COccupancyGridMap2D.h>
 
+#include "COccupancyGridMap2D_impl.h"
+
 using namespace mrpt;
 using namespace mrpt::maps;
 using namespace mrpt::obs;
@@ -50,6 +52,7 @@ void COccupancyGridMap2D::buildVoronoiDiagram(
 	ASSERT_EQUAL_(m_voronoi_diagram.getSizeX(), m_size_x);
 	ASSERT_EQUAL_(m_voronoi_diagram.getSizeY(), m_size_y);
 	m_voronoi_diagram.fill(0);
+	m_voronoi_robot_size_units = -1;
 
 	// freeness threshold
 	voroni_free_threshold = 1.0f - threshold;
@@ -92,6 +95,75 @@ void COccupancyGridMap2D::buildVoronoiDiagram(
 	}
 }
 
+/*---------------------------------------------------------------
+				updateVoronoiDiagram
+  ---------------------------------------------------------------*/
+void COccupancyGridMap2D::updateVoronoiDiagram(
+	float threshold, float robot_size)
+{
+	MRPT_START
+
+	// freeness threshold
+	voroni_free_threshold = 1.0f - threshold;
+
+	bool rebuilt = false;
+	if (!m_dynamic_voronoi.isInitialized() ||
+		m_dynamic_voronoi.getFreeThreshold() != voroni_free_threshold ||
+		m_dynamic_voronoi.getSizeX() != m_size_x ||
+		m_dynamic_voronoi.getSizeY() != m_size_y)
+	{
+		m_dynamic_voronoi.initialize(*this, voroni_free_threshold);
+		rebuilt = true;
+	}
+	else
+		m_dynamic_voronoi.update(*this);
+
+	const int robot_size_units = round(100 * robot_size / m_resolution);
+
+	// Of each pair of neighbors across an equidistance line, only the cell
+	// closest to it is marked (both, on ties), so no thinning is required:
+	const auto refreshCell = [&](unsigned int x, unsigned int y) {
+		uint16_t clearance = 0;
+		if (m_dynamic_voronoi.isVoronoi(x, y))
+		{
+			// Clearance in 1/100 of cells:
+			const int c = round(100 * m_dynamic_voronoi.getDistance(x, y));
+			if (c > robot_size_units)
+				clearance = static_cast<uint16_t>(std::min(c, 0xFFFF));
+		}
+		setVoroniClearance(x, y, clearance);
+	};
+
+	if (rebuilt || robot_size_units != m_voronoi_robot_size_units ||
+		m_voronoi_diagram.getSizeX() != m_size_x ||
+		m_voronoi_diagram.getSizeY() != m_size_y)
+	{
+		m_voronoi_diagram.setSize(
+			m_xMin, m_xMax, m_yMin, m_yMax, m_resolution);
+		ASSERT_EQUAL_(m_voronoi_diagram.getSizeX(), m_size_x);
+		ASSERT_EQUAL_(m_voronoi_diagram.getSizeY(), m_size_y);
+		for (unsigned int y = 0; y < m_size_y; y++)
+			for (unsigned int x = 0; x < m_size_x; x++)
+				refreshCell(x, y);
+		m_voronoi_robot_size_units = robot_size_units;
+	}
+	else
+	{
+		// Only the cells whose closest obstacle changed and their neighbors:
+		for (const int32_t s : m_dynamic_voronoi.getLastUpdatedCells())
+		{
+			const int cx = s % m_size_x, cy = s / m_size_x;
+			for (int y = std::max(0, cy - 1);
+				 y <= std::min(cy + 1, static_cast<int>(m_size_y) - 1); y++)
+				for (int x = std::max(0, cx - 1);
+					 x <= std::min(cx + 1, static_cast<int>(m_size_x) - 1); x++)
+					refreshCell(x, y);
+		}
+	}
+
+	MRPT_END
+}
+
 /*---------------------------------------------------------------
 					findCriticalPoints
   ---------------------------------------------------------------*/
@@ -263,7 +335,7 @@ int COccupancyGridMap2D::computeClearance(
 		static_cast<unsigned>(cy) >= m_size_y)
 		return 0;
 
-	if (m_map[cx + cy * m_size_y] < thresholdCellValue) return 0;
+	if (cellRow(cy)[cx] < thresholdCellValue) return 0;
 
 	// Truco para acelerar MUCHO:
 	//  Si miramos un punto junto al mirado antes,
@@ -350,7 +422,7 @@ int COccupancyGridMap2D::computeClearance(
 				yy < static_cast<int>(m_size_y))
 			{
 				// if ( getCell(xx,yy)<=voroni_free_threshold )
-				if (m_map[xx + yy * m_size_y] < thresholdCellValue)
+				if (cellRow(yy)[xx] < thresholdCellValue)
 				{
 					if (!dentro_obs)
 					{
@@ -544,36 +616,7 @@ int COccupancyGridMap2D::direction2idx(int dx, int dy)
 float COccupancyGridMap2D::computeClearance(
 	float x, float y, float maxSearchDistance) const
 {
-	int xx1 = max(0, x2idx(x - maxSearchDistance));
-	int xx2 =
-		min(static_cast<unsigned>(m_size_x - 1),
-			static_cast<unsigned>(x2idx(x + maxSearchDistance)));
-	int yy1 = max(0, y2idx(y - maxSearchDistance));
-	int yy2 =
-		min(static_cast<unsigned>(m_size_y - 1),
-			static_cast<unsigned>(y2idx(y + maxSearchDistance)));
-
-	int cx = x2idx(x);
-	int cy = y2idx(y);
-
-	int xx, yy;
-	float clearance_sq = square(maxSearchDistance);
-	cellType thresholdCellValue = p2l(0.5f);
-
-	// At least 1 free cell nearby!
-	bool atLeastOneFree = false;
-	for (xx = cx - 1; !atLeastOneFree && xx <= cx + 1; xx++)
-		for (yy = cy - 1; !atLeastOneFree && yy <= cy + 1; yy++)
-			if (getCell(xx, yy) > 0.505f) atLeastOneFree = true;
-
-	if (!atLeastOneFree) return 0;
-
-	for (xx = xx1; xx <= xx2; xx++)
-		for (yy = yy1; yy <= yy2; yy++)
-			if (m_map[xx + yy * m_size_x] < thresholdCellValue)
-				clearance_sq = min(
-					clearance_sq,
-					square(m_resolution) * (square(xx - cx) + square(yy - cy)));
-
-	return sqrt(clearance_sq);
+	return internal::computeClearance(
+		*this, [this](unsigned int cy) { return cellRow(cy); }, x, y,
+		maxSearchDistance);
 }
@@ -61,7 +61,7 @@ bool COctoMapBase<OCTREE, OCTREE_NODE>::
 		CPose3D sensorPose(UNINITIALIZED_POSE);
 		sensorPose.composeFrom(robotPose3D, o.sensorPose);
 		sensorPt =
-			octomap::point3d(sensorPose.x(), sensorPose.y(), sensorPose.z());
+			octomap_point3d(sensorPose.x(), sensorPose.y(), sensorPose.z());
 
 		const auto* scanPts = o.buildAuxPointsMap<mrpt::maps::CPointsMap>();
 		const size_t nPts = scanPts->size();
@@ -110,7 +110,7 @@ bool COctoMapBase<OCTREE, OCTREE_NODE>::
 		obs.getSensorPose(sensorPose);
 		sensorPose.composeFrom(robotPose3D, sensorPose);
 		sensorPt =
-			octomap::point3d(sensorPose.x(), sensorPose.y(), sensorPose.z());
+			octomap_point3d(sensorPose.x(), sensorPose.y(), sensorPose.z());
 
 		obs.load();	 // ensure points are loaded from an external source
 
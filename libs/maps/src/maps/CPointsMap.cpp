@@ -12,7 +12,11 @@
 #include <mrpt/config/CConfigFile.h>
 #include <mrpt/core/SSE_macros.h>
 #include <mrpt/core/SSE_types.h>
+#include <mrpt/core/parallel_for.h>
+#include <mrpt/io/CFileInputStream.h>
+#include <mrpt/io/CFileOutputStream.h>
 #include <mrpt/maps/CPointsMap.h>
+#include <mrpt/maps/CPointsMapRingBuffer.h>
 #include <mrpt/maps/CSimplePointsMap.h>
 #include <mrpt/math/TPose2D.h>
 #include <mrpt/math/geometry.h>
@@ -28,9 +32,13 @@
 #include <mrpt/system/CTimeLogger.h>
 #include <mrpt/system/os.h>
 
+#include <Eigen/Dense>
+#include <cstring>
 #include <fstream>
 #include <sstream>
 
+#include "TMatchingWorkspace_impl.h"
+
 #if MRPT_HAS_MATLAB
 #include <mexplus.h>
 #endif
@@ -46,6 +54,8 @@ using namespace std;
 
 IMPLEMENTS_VIRTUAL_SERIALIZABLE(CPointsMap, CMetricMap, mrpt::maps)
 
+using mrpt::maps::internal::matchPointsInBlocks;
+
 /*---------------------------------------------------------------
 						Constructor
   ---------------------------------------------------------------*/
@@ -142,6 +152,125 @@ bool CPointsMap::load2Dor3D_from_text_stream(
 	MRPT_END
 }
 
+namespace
+{
+constexpr char BINARY_FILE_MAGIC[8] = {'M', 'R', 'P', 'T', 'P', 'T', 'S', '1'};
+constexpr size_t BINARY_FIELD_NAME_LEN = 16;
+constexpr uint64_t BINARY_ARRAY_ALIGN = 64;
+
+uint64_t alignBinaryOffset(uint64_t off)
+{
+	return (off + BINARY_ARRAY_ALIGN - 1) & ~(BINARY_ARRAY_ALIGN - 1);
+}
+}  // namespace
+
+bool CPointsMap::saveToBinaryFile(const std::string& file) const
+{
+	try
+	{
+		field_buffers_t fields = {
+			{"x", const_cast<mrpt::aligned_std_vector<float>*>(&m_x)},
+			{"y", const_cast<mrpt::aligned_std_vector<float>*>(&m_y)},
+			{"z", const_cast<mrpt::aligned_std_vector<float>*>(&m_z)}};
+		const_cast<CPointsMap*>(this)->getExtraFieldBuffers(fields);
+
+		const uint64_t N = m_x.size();
+		mrpt::io::CFileOutputStream f;
+		if (!f.open(file, mrpt::io::OpenMode::TRUNCATE))
+			THROW_EXCEPTION_FMT("Cannot create file: `%s`", file.c_str());
+		auto ar = mrpt::serialization::archiveFrom(f);
+
+		f.Write(BINARY_FILE_MAGIC, sizeof(BINARY_FILE_MAGIC));
+		ar << N << static_cast<uint32_t>(fields.size());
+
+		uint64_t offset = alignBinaryOffset(
+			sizeof(BINARY_FILE_MAGIC) + 8 + 4 +
+			fields.size() * (BINARY_FIELD_NAME_LEN + 8));
+		for (const auto& field : fields)
+		{
+			ASSERT_EQUAL_(field.second->size(), N);
+			char name[BINARY_FIELD_NAME_LEN] = {0};
+			ASSERT_LT_(field.first.size(), BINARY_FIELD_NAME_LEN);
+			std::memcpy(name, field.first.c_str(), field.first.size());
+			f.Write(name, sizeof(name));
+			ar << offset;
+			offset = alignBinaryOffset(offset + N * sizeof(float));
+		}
+
+		const char zeros[BINARY_ARRAY_ALIGN] = {0};
+		for (const auto& field : fields)
+		{
+			if (!N) break;
+			const uint64_t pos = f.getPosition();
+			f.Write(zeros, alignBinaryOffset(pos) - pos);
+			ar.WriteBufferFixEndianness(field.second->data(), N);
+		}
+		return true;
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "[CPointsMap::saveToBinaryFile] " << e.what() << "\n";
+		return false;
+	}
+}
+
+bool CPointsMap::loadFromBinaryFile(const std::string& file)
+{
+	try
+	{
+		mrpt::io::CFileInputStream f;
+		if (!f.open(file))
+			THROW_EXCEPTION_FMT("Cannot open file: `%s`", file.c_str());
+		auto ar = mrpt::serialization::archiveFrom(f);
+
+		char magic[sizeof(BINARY_FILE_MAGIC)];
+		if (f.Read(magic, sizeof(magic)) != sizeof(magic) ||
+			std::memcmp(magic, BINARY_FILE_MAGIC, sizeof(magic)) != 0)
+			THROW_EXCEPTION_FMT(
+				"Not a binary point cloud file: `%s`", file.c_str());
+
+		uint64_t N;
+		uint32_t nFields;
+		ar >> N >> nFields;
+		std::vector<std::pair<std::string, uint64_t>> fileFields(nFields);
+		for (auto& ff : fileFields)
+		{
+			char name[BINARY_FIELD_NAME_LEN];
+			ar.ReadBuffer(name, sizeof(name));
+			ff.first.assign(name, strnlen(name, sizeof(name)));
+			ar >> ff.second;
+			// Written this way so that corrupted sizes cannot overflow:
+			const uint64_t fileSize = f.getTotalBytesCount();
+			ASSERT_LE_(ff.second, fileSize);
+			ASSERT_LE_(N, (fileSize - ff.second) / sizeof(float));
+		}
+
+		// Start from an empty map, so missing fields get default values:
+		this->resize(0);
+		this->resize(N);
+
+		field_buffers_t fields = {{"x", &m_x}, {"y", &m_y}, {"z", &m_z}};
+		getExtraFieldBuffers(fields);
+		for (const auto& ff : fileFields)
+		{
+			for (const auto& field : fields)
+			{
+				if (field.first != ff.first || !N) continue;
+				f.Seek(ff.second);
+				ar.ReadBufferFixEndianness(field.second->data(), N);
+			}
+		}
+		mark_as_modified();
+		return true;
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "[CPointsMap::loadFromBinaryFile] " << e.what() << "\n";
+		this->clear();
+		return false;
+	}
+}
+
 bool CPointsMap::load2Dor3D_from_text_file(
 	const std::string& file, const bool is_3D)
 {
@@ -297,30 +426,25 @@ void CPointsMap::determineMatching2D(
 
 	const size_t nLocalPoints = otherMap->size();
 	const size_t nGlobalPoints = this->size();
-	float _sumSqrDist = 0;
-	size_t _sumSqrCount = 0;
-	size_t nOtherMapPointsWithCorrespondence =
-		0;	// Number of points with one corrs. at least
 
 	auto bbLocal = mrpt::math::TBoundingBoxf::PlusMinusInfinity();
 
-	double maxDistForCorrespondenceSquared;
-	float x_local, y_local;
-	unsigned int localIdx;
-
-	const float *x_other_it, *y_other_it, *z_other_it;
-
 	// Prepare output: no correspondences initially:
 	correspondences.clear();
-	correspondences.reserve(nLocalPoints);
 	extraResults.correspondencesRatio = 0;
 
-	TMatchingPairList tempCorrs;
-	tempCorrs.reserve(nLocalPoints);
-
 	// Nothing to do if we have an empty map!
 	if (!nGlobalPoints || !nLocalPoints) return;
 
+	// Reuse the user-provided buffers, if any:
+	TMatchingWorkspace tempWorkspace;
+	TMatchingWorkspace& ws =
+		params.workspace ? *params.workspace : tempWorkspace;
+	auto& x_locals = ws.xs;
+	auto& y_locals = ws.ys;
+	x_locals.resize(nLocalPoints);
+	y_locals.resize(nLocalPoints);
+
 	const double sin_phi = sin(otherMapPose.phi);
 	const double cos_phi = cos(otherMapPose.phi);
 
@@ -332,8 +456,6 @@ void CPointsMap::determineMatching2D(
 	// Number of 4-floats:
 	size_t nPackets = nLocalPoints / 4;
 
-	Eigen::ArrayXf x_locals(nLocalPoints), y_locals(nLocalPoints);
-
 	// load 4 copies of the same value
 	const __m128 cos_4val = _mm_set1_ps(cos_phi);
 	const __m128 sin_4val = _mm_set1_ps(sin_phi);
@@ -363,8 +485,8 @@ void CPointsMap::determineMatching2D(
 		const __m128 lys = _mm_add_ps(
 			y0_4val,
 			_mm_add_ps(_mm_mul_ps(xs, sin_4val), _mm_mul_ps(ys, cos_4val)));
-		_mm_store_ps(ptr_out_x, lxs);
-		_mm_store_ps(ptr_out_y, lys);
+		_mm_storeu_ps(ptr_out_x, lxs);
+		_mm_storeu_ps(ptr_out_y, lys);
 
 		x_mins = _mm_min_ps(x_mins, lxs);
 		x_maxs = _mm_max_ps(x_maxs, lxs);
@@ -413,15 +535,17 @@ void CPointsMap::determineMatching2D(
 	const Eigen::Map<Eigen::Matrix<float, Eigen::Dynamic, 1>> y_org(
 		const_cast<float*>(&otherMap->m_y[0]), otherMap->m_y.size(), 1);
 
-	Eigen::Array<float, Eigen::Dynamic, 1> x_locals =
+	Eigen::Map<Eigen::ArrayXf> x_locals_map(x_locals.data(), nLocalPoints);
+	Eigen::Map<Eigen::ArrayXf> y_locals_map(y_locals.data(), nLocalPoints);
+	x_locals_map =
 		otherMapPose.x + cos_phi * x_org.array() - sin_phi * y_org.array();
-	Eigen::Array<float, Eigen::Dynamic, 1> y_locals =
+	y_locals_map =
 		otherMapPose.y + sin_phi * x_org.array() + cos_phi * y_org.array();
 
-	bbLocal.min.x = x_locals.minCoeff();
-	bbLocal.min.y = y_locals.minCoeff();
-	bbLocal.max.x = x_locals.maxCoeff();
-	bbLocal.max.y = y_locals.maxCoeff();
+	bbLocal.min.x = x_locals_map.minCoeff();
+	bbLocal.min.y = y_locals_map.minCoeff();
+	bbLocal.max.x = x_locals_map.maxCoeff();
+	bbLocal.max.y = y_locals_map.maxCoeff();
 #endif
 
 	// Find the bounding box:
@@ -433,70 +557,58 @@ void CPointsMap::determineMatching2D(
 		bbLocal.min.y > bbGlobal.max.y || bbLocal.max.y < bbGlobal.min.y)
 		return;	 // We know for sure there is no matching at all
 
-	// Loop for each point in local map:
-	// --------------------------------------------------
-	for (localIdx = params.offset_other_map_points,
-		x_other_it = &otherMap->m_x[params.offset_other_map_points],
-		y_other_it = &otherMap->m_y[params.offset_other_map_points],
-		z_other_it = &otherMap->m_z[params.offset_other_map_points];
-		 localIdx < nLocalPoints;
-		 x_other_it += params.decimation_other_map_points,
-		y_other_it += params.decimation_other_map_points,
-		z_other_it += params.decimation_other_map_points,
-		localIdx += params.decimation_other_map_points)
-	{
-		// For speed-up:
-		x_local = x_locals[localIdx];  // *x_locals_it;
-		y_local = y_locals[localIdx];  // *y_locals_it;
-
-		// Find all the matchings in the requested distance:
-
-		// KD-TREE implementation =================================
-		// Use a KD-tree to look for the nearnest neighbor of:
-		//   (x_local, y_local, z_local)
-		// In "this" (global/reference) points map.
-
-		float tentativ_err_sq;
-		unsigned int tentativ_this_idx = kdTreeClosestPoint2D(
-			x_local, y_local,  // Look closest to this guy
-			tentativ_err_sq	 // save here the min. distance squared
-		);
-
-		// Compute max. allowed distance:
-		maxDistForCorrespondenceSquared = square(
-			params.maxAngularDistForCorrespondence *
-				std::sqrt(
-					square(params.angularDistPivotPoint.x - x_local) +
-					square(params.angularDistPivotPoint.y - y_local)) +
-			params.maxDistForCorrespondence);
+	// All KD-tree queries below are read-only, and can run in parallel:
+	kdTreeEnsureIndexBuilt2D();
 
-		// Distance below the threshold??
-		if (tentativ_err_sq < maxDistForCorrespondenceSquared)
-		{
-			// Save all the correspondences:
-			TMatchingPair& p = tempCorrs.emplace_back();
+	// Loop for each point in local map, in blocks of points:
+	// --------------------------------------------------
+	auto& allCorrs = params.onlyUniqueRobust ? ws.allCorrs : correspondences;
+	const float sumSqrDist = matchPointsInBlocks(
+		params, nLocalPoints, ws, allCorrs,
+		[&](size_t localIdx, TMatchingPairList& corrs) {
+			const float x_local = x_locals[localIdx];
+			const float y_local = y_locals[localIdx];
+
+			// KD-TREE implementation =================================
+			// Use a KD-tree to look for the nearnest neighbor of:
+			//   (x_local, y_local, z_local)
+			// In "this" (global/reference) points map.
 
-			p.globalIdx = tentativ_this_idx;
-			p.global.x = m_x[tentativ_this_idx];
-			p.global.y = m_y[tentativ_this_idx];
-			p.global.z = m_z[tentativ_this_idx];
+			float tentativ_err_sq;
+			const unsigned int tentativ_this_idx = kdTreeClosestPoint2D(
+				x_local, y_local,  // Look closest to this guy
+				tentativ_err_sq	 // save here the min. distance squared
+			);
 
-			p.localIdx = localIdx;
-			p.local.x = *x_other_it;
-			p.local.y = *y_other_it;
-			p.local.z = *z_other_it;
+			// Compute max. allowed distance:
+			const double maxDistForCorrespondenceSquared = square(
+				params.maxAngularDistForCorrespondence *
+					std::sqrt(
+						square(params.angularDistPivotPoint.x - x_local) +
+						square(params.angularDistPivotPoint.y - y_local)) +
+				params.maxDistForCorrespondence);
 
-			p.errorSquareAfterTransformation = tentativ_err_sq;
+			// Distance below the threshold??
+			if (tentativ_err_sq < maxDistForCorrespondenceSquared)
+			{
+				// Save all the correspondences:
+				TMatchingPair& p = corrs.emplace_back();
 
-			// At least one:
-			nOtherMapPointsWithCorrespondence++;
+				p.globalIdx = tentativ_this_idx;
+				p.global.x = m_x[tentativ_this_idx];
+				p.global.y = m_y[tentativ_this_idx];
+				p.global.z = m_z[tentativ_this_idx];
 
-			// Accumulate the MSE:
-			_sumSqrDist += p.errorSquareAfterTransformation;
-			_sumSqrCount++;
-		}
+				p.localIdx = localIdx;
+				p.local.x = otherMap->m_x[localIdx];
+				p.local.y = otherMap->m_y[localIdx];
+				p.local.z = otherMap->m_z[localIdx];
 
-	}  // For each local point
+				p.errorSquareAfterTransformation = tentativ_err_sq;
+			}
+		});
+	// Number of points with one corrs. at least:
+	const size_t nOtherMapPointsWithCorrespondence = allCorrs.size();
 
 	// Additional consistency filter: "onlyKeepTheClosest" up to now
 	//  led to just one correspondence for each "local map" point, but
@@ -508,18 +620,14 @@ void CPointsMap::determineMatching2D(
 			params.onlyKeepTheClosest,
 			"ERROR: onlyKeepTheClosest must be also set to true when "
 			"onlyUniqueRobust=true.");
-		tempCorrs.filterUniqueRobustPairs(nGlobalPoints, correspondences);
-	}
-	else
-	{
-		correspondences.swap(tempCorrs);
+		allCorrs.filterUniqueRobustPairs(nGlobalPoints, correspondences);
 	}
 
 	// If requested, copy sum of squared distances to output pointer:
 	// -------------------------------------------------------------------
-	if (_sumSqrCount)
-		extraResults.sumSqrDist =
-			_sumSqrDist / static_cast<double>(_sumSqrCount);
+	if (nOtherMapPointsWithCorrespondence)
+		extraResults.sumSqrDist = sumSqrDist /
+			static_cast<double>(nOtherMapPointsWithCorrespondence);
 	else
 		extraResults.sumSqrDist = 0;
 
@@ -1019,29 +1127,28 @@ void CPointsMap::determineMatching3D(
 
 	const size_t nLocalPoints = otherMap->size();
 	const size_t nGlobalPoints = this->size();
-	float _sumSqrDist = 0;
-	size_t _sumSqrCount = 0;
-	size_t nOtherMapPointsWithCorrespondence =
-		0;	// Number of points with one corrs. at least
 
 	auto bbLocal = mrpt::math::TBoundingBoxf::PlusMinusInfinity();
 
-	double maxDistForCorrespondenceSquared;
-
 	// Prepare output: no correspondences initially:
 	correspondences.clear();
-	correspondences.reserve(nLocalPoints);
-
-	TMatchingPairList tempCorrs;
-	tempCorrs.reserve(nLocalPoints);
 
 	// Empty maps?  Nothing to do
 	if (!nGlobalPoints || !nLocalPoints) return;
 
+	// Reuse the user-provided buffers, if any:
+	TMatchingWorkspace tempWorkspace;
+	TMatchingWorkspace& ws =
+		params.workspace ? *params.workspace : tempWorkspace;
+
 	// Try to do matching only if the bounding boxes have some overlap:
 	// Transform all local points:
-	vector<float> x_locals(nLocalPoints), y_locals(nLocalPoints),
-		z_locals(nLocalPoints);
+	auto& x_locals = ws.xs;
+	auto& y_locals = ws.ys;
+	auto& z_locals = ws.zs;
+	x_locals.resize(nLocalPoints);
+	y_locals.resize(nLocalPoints);
+	z_locals.resize(nLocalPoints);
 
 	for (unsigned int localIdx = params.offset_other_map_points;
 		 localIdx < nLocalPoints;
@@ -1068,18 +1175,20 @@ void CPointsMap::determineMatching3D(
 	if (!bbLocal.intersection(bbGlobal).has_value())
 		return;	 // No need to compute: matching is ZERO.
 
-	// Loop for each point in local map:
+	// All KD-tree queries below are read-only, and can run in parallel:
+	kdTreeEnsureIndexBuilt3D();
+
+	// Loop for each point in local map, in blocks of points:
 	// --------------------------------------------------
-	for (unsigned int localIdx = params.offset_other_map_points;
-		 localIdx < nLocalPoints;
-		 localIdx += params.decimation_other_map_points)
-	{
-		// For speed-up:
-		const float x_local = x_locals[localIdx];
-		const float y_local = y_locals[localIdx];
-		const float z_local = z_locals[localIdx];
+	auto& allCorrs = params.onlyUniqueRobust ? ws.allCorrs : correspondences;
+	const float sumSqrDist = matchPointsInBlocks(
+		params, nLocalPoints, ws, allCorrs,
+		[&](size_t localIdx, TMatchingPairList& corrs) {
+			// For speed-up:
+			const float x_local = x_locals[localIdx];
+			const float y_local = y_locals[localIdx];
+			const float z_local = z_locals[localIdx];
 
-		{
 			// KD-TREE implementation
 			// Use a KD-tree to look for the nearnest neighbor of:
 			//   (x_local, y_local, z_local)
@@ -1092,7 +1201,7 @@ void CPointsMap::determineMatching3D(
 			);
 
 			// Compute max. allowed distance:
-			maxDistForCorrespondenceSquared = square(
+			const double maxDistForCorrespondenceSquared = square(
 				params.maxAngularDistForCorrespondence *
 					params.angularDistPivotPoint.distanceTo(
 						TPoint3D(x_local, y_local, z_local)) +
@@ -1102,7 +1211,7 @@ void CPointsMap::determineMatching3D(
 			if (tentativ_err_sq < maxDistForCorrespondenceSquared)
 			{
 				// Save all the correspondences:
-				TMatchingPair& p = tempCorrs.emplace_back();
+				TMatchingPair& p = corrs.emplace_back();
 
 				p.globalIdx = tentativ_this_idx;
 				p.global.x = m_x[tentativ_this_idx];
@@ -1115,17 +1224,10 @@ void CPointsMap::determineMatching3D(
 				p.local.z = otherMap->m_z[localIdx];
 
 				p.errorSquareAfterTransformation = tentativ_err_sq;
-
-				// At least one:
-				nOtherMapPointsWithCorrespondence++;
-
-				// Accumulate the MSE:
-				_sumSqrDist += p.errorSquareAfterTransformation;
-				_sumSqrCount++;
 			}
-
-		}  // End of test_match
-	}  // For each local point
+		});
+	// Number of points with one corrs. at least:
+	const size_t nOtherMapPointsWithCorrespondence = allCorrs.size();
 
 	// Additional consistency filter: "onlyKeepTheClosest" up to now
 	//  led to just one correspondence for each "local map" point, but
@@ -1137,23 +1239,161 @@ void CPointsMap::determineMatching3D(
 			params.onlyKeepTheClosest,
 			"ERROR: onlyKeepTheClosest must be also set to true when "
 			"onlyUniqueRobust=true.");
-		tempCorrs.filterUniqueRobustPairs(nGlobalPoints, correspondences);
-	}
-	else
-	{
-		correspondences = std::move(tempCorrs);
+		allCorrs.filterUniqueRobustPairs(nGlobalPoints, correspondences);
 	}
 
 	// If requested, copy sum of squared distances to output pointer:
 	// -------------------------------------------------------------------
-	extraResults.sumSqrDist =
-		(_sumSqrCount) ? _sumSqrDist / static_cast<double>(_sumSqrCount) : 0;
+	extraResults.sumSqrDist = nOtherMapPointsWithCorrespondence
+		? sumSqrDist / static_cast<double>(nOtherMapPointsWithCorrespondence)
+		: 0;
 	extraResults.correspondencesRatio = params.decimation_other_map_points *
 		nOtherMapPointsWithCorrespondence / d2f(nLocalPoints);
 
 	MRPT_END
 }
 
+/*---------------------------------------------------------------
+				getLocalGeometry
+---------------------------------------------------------------*/
+const CPointsMap::TLocalGeometry& CPointsMap::getLocalGeometry(
+	unsigned int numNeighbors, float epsilon, unsigned int numThreads) const
+{
+	MRPT_START
+
+	ASSERT_GE_(numNeighbors, 3U);
+	ASSERT_GT_(epsilon, 0.0f);
+
+	auto& cache = m_localGeometry;
+	std::lock_guard<std::mutex> lck(cache.mtx);
+	auto& normals = cache.data.normals;
+	auto& covs = cache.data.covariances;
+
+	const size_t N = size();
+	if (cache.numNeighbors != numNeighbors || cache.epsilon != epsilon ||
+		normals.size() > N)
+	{
+		normals.clear();
+		covs.clear();
+		cache.numNeighbors = numNeighbors;
+		cache.epsilon = epsilon;
+	}
+	// Only points appended since the last call need to be estimated:
+	const size_t first = normals.size();
+	if (first == N) return cache.data;
+
+	normals.resize(N);
+	covs.resize(N);
+	kdTreeEnsureIndexBuilt3D();
+
+	const auto estimate = [&](size_t i0, size_t i1) {
+		std::vector<size_t> idxs;
+		std::vector<float> dists;
+		for (size_t i = i0; i < i1; i++)
+		{
+			normals[i] = mrpt::math::TPoint3Df(0, 0, 0);
+			covs[i].setIdentity();
+
+			kdTreeNClosestPoint3DIdx(
+				m_x[i], m_y[i], m_z[i], numNeighbors, idxs, dists);
+			if (idxs.size() < 3) continue;
+
+			Eigen::Vector3f mean = Eigen::Vector3f::Zero();
+			for (const size_t j : idxs)
+				mean += Eigen::Vector3f(m_x[j], m_y[j], m_z[j]);
+			mean /= static_cast<float>(idxs.size());
+
+			Eigen::Matrix3f cov = Eigen::Matrix3f::Zero();
+			for (const size_t j : idxs)
+			{
+				const Eigen::Vector3f d =
+					Eigen::Vector3f(m_x[j], m_y[j], m_z[j]) - mean;
+				cov.noalias() += d * d.transpose();
+			}
+			cov /= static_cast<float>(idxs.size());
+
+			// Eigenvalues in ascending order: the first eigenvector is the
+			// normal of the local plane.
+			const Eigen::SelfAdjointEigenSolver<Eigen::Matrix3f> eig(cov);
+			if (eig.info() != Eigen::Success) continue;
+			const Eigen::Matrix3f& V = eig.eigenvectors();
+			normals[i] = mrpt::math::TPoint3Df(V(0, 0), V(1, 0), V(2, 0));
+			covs[i].asEigen() =
+				V * Eigen::Vector3f(epsilon, 1.0f, 1.0f).asDiagonal() *
+				V.transpose();
+		}
+	};
+
+	// Blocks large enough to be worth a thread:
+	constexpr size_t POINTS_PER_BLOCK = 512;
+	mrpt::parallelFor(
+		N - first, POINTS_PER_BLOCK, numThreads,
+		[&](size_t i0, size_t i1) { estimate(first + i0, first + i1); });
+	return cache.data;
+
+	MRPT_END
+}
+
+/*---------------------------------------------------------------
+				getVoxelDecimated
+---------------------------------------------------------------*/
+const CPointsMap& CPointsMap::getVoxelDecimated(float voxelSize) const
+{
+	MRPT_START
+
+	ASSERT_GT_(voxelSize, 0.0f);
+	// Number of voxel sizes kept in the cache:
+	constexpr size_t MAX_CACHED_LEVELS = 8;
+
+	auto& cache = m_voxelDecimated;
+	std::lock_guard<std::mutex> lck(cache.mtx);
+
+	auto it = std::find_if(
+		cache.levels.begin(), cache.levels.end(),
+		[voxelSize](const auto& l) { return l.voxelSize == voxelSize; });
+	if (it == cache.levels.end())
+	{
+		if (cache.levels.size() >= MAX_CACHED_LEVELS) cache.levels.pop_back();
+		auto& l = cache.levels.emplace_front();
+		l.voxelSize = voxelSize;
+		auto m = std::make_shared<CSimplePointsMap>();
+		m->kdtree_search_params = kdtree_search_params;
+		l.map = m;
+	}
+	else if (it != cache.levels.begin())
+	{
+		// Move to the front (most recently used):
+		auto l = std::move(*it);
+		cache.levels.erase(it);
+		cache.levels.push_front(std::move(l));
+	}
+	auto& level = cache.levels.front();
+
+	// Add the points appended since the last call:
+	const size_t N = size();
+	ASSERT_LE_(level.numSourcePoints, N);
+	const float invSize = 1.0f / voxelSize;
+	constexpr uint64_t MASK = (uint64_t(1) << 21) - 1;
+	constexpr int64_t OFFSET = int64_t(1) << 20;
+	for (size_t i = level.numSourcePoints; i < N; i++)
+	{
+		// 21 bits per axis, wrapping around far away coordinates:
+		const auto cell = [&](float v) {
+			return uint64_t(int64_t(std::floor(v * invSize)) + OFFSET) & MASK;
+		};
+		const uint64_t key =
+			cell(m_x[i]) | (cell(m_y[i]) << 21) | (cell(m_z[i]) << 42);
+		if (level.voxels.insert(key).second)
+			level.map->insertPointFast(m_x[i], m_y[i], m_z[i]);
+	}
+	if (level.numSourcePoints != N) level.map->mark_as_appended();
+	level.numSourcePoints = N;
+
+	return *level.map;
+
+	MRPT_END
+}
+
 /*---------------------------------------------------------------
 				extractCylinder
 ---------------------------------------------------------------*/
@@ -1514,13 +1754,16 @@ void internal_build_points_map_from_scan2D(
 	// Create on first call:
 	if (out_map) return;  // Already done!
 
-	out_map = std::make_shared<CSimplePointsMap>();
+	// Reuse a map from the global pool, with its memory and sin/cos tables
+	// (this only allocates a new map if the pool has no free maps):
+	auto m = CPointsMapRingBuffer::Instance().next();
 
 	if (insertOps)
-		static_cast<CSimplePointsMap*>(out_map.get())->insertionOptions =
+		m->insertionOptions =
 			*static_cast<const CPointsMap::TInsertionOptions*>(insertOps);
 
-	out_map->insertObservation(obs);
+	m->insertObservation(obs);
+	out_map = std::move(m);
 }
 
 struct TAuxLoadFunctor
@@ -1636,7 +1879,7 @@ void CPointsMap::insertAnotherMap(
 	// Also copy other data fields (color, ...)
 	addFrom_classSpecific(*otherMap, N_this, filterOutPointsAtZero);
 
-	mark_as_modified();
+	mark_as_appended();
 }
 
 /** Helper method for ::copyFrom() */
@@ -1690,7 +1933,7 @@ bool CPointsMap::internal_insertObservation(
 		/********************************************************************
 					OBSERVATION TYPE: CObservation2DRangeScan
 		 ********************************************************************/
-		mark_as_modified();
+		mark_as_appended();
 
 		const auto& o = static_cast<const CObservation2DRangeScan&>(obs);
 		// Insert only HORIZONTAL scans??
@@ -1710,18 +1953,18 @@ bool CPointsMap::internal_insertObservation(
 			// ----------------------------------------------
 			if (insertionOptions.fuseWithExisting)
 			{
-				CSimplePointsMap auxMap;
+				auto auxMap = CPointsMapRingBuffer::Instance().next();
 				// Fuse:
-				auxMap.insertionOptions = insertionOptions;
-				auxMap.insertionOptions.addToExistingPointsMap = false;
+				auxMap->insertionOptions = insertionOptions;
+				auxMap->insertionOptions.addToExistingPointsMap = false;
 
-				auxMap.loadFromRangeScan(
+				auxMap->loadFromRangeScan(
 					o,	// The laser range scan observation
 					robotPose3D	 // The robot pose
 				);
 
 				fuseWith(
-					&auxMap,  // Fuse with this map
+					auxMap.get(),  // Fuse with this map
 					insertionOptions.minDistBetweenLaserPoints,	 // Min dist.
 					&checkForDeletion  // Set to "false" if a point in "map"
 									   // has
@@ -1737,7 +1980,7 @@ bool CPointsMap::internal_insertObservation(
 					CPolygon pol;
 					const float *xs, *ys, *zs;
 					size_t n;
-					auxMap.getPointsBuffer(n, xs, ys, zs);
+					auxMap->getPointsBuffer(n, xs, ys, zs);
 					pol.setAllVertices(n, xs, ys);
 
 					// Check for deletion of points in "map"
@@ -1784,7 +2027,7 @@ bool CPointsMap::internal_insertObservation(
 		/********************************************************************
 					OBSERVATION TYPE: CObservation3DRangeScan
 		 ********************************************************************/
-		mark_as_modified();
+		mark_as_appended();
 
 		const auto& o = static_cast<const CObservation3DRangeScan&>(obs);
 		// Insert only HORIZONTAL scans??
@@ -1841,7 +2084,7 @@ bool CPointsMap::internal_insertObservation(
 		/********************************************************************
 					OBSERVATION TYPE: CObservationRange  (IRs, Sonars, etc.)
 		 ********************************************************************/
-		mark_as_modified();
+		mark_as_appended();
 
 		const auto& o = static_cast<const CObservationRange&>(obs);
 
@@ -1914,7 +2157,7 @@ bool CPointsMap::internal_insertObservation(
 	}
 	else if (IS_CLASS(obs, CObservationPointCloud))
 	{
-		mark_as_modified();
+		mark_as_appended();
 
 		const auto& o = static_cast<const CObservationPointCloud&>(obs);
 		ASSERT_(o.pointcloud);
@@ -0,0 +1,105 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "maps-precomp.h"  // Precomp header
+//
+#include <mrpt/core/lock_helper.h>
+#include <mrpt/maps/CPointsMapRingBuffer.h>
+
+using namespace mrpt::maps;
+
+static std::unique_ptr<CSimplePointsMap> newPoolMap(size_t reservePoints)
+{
+	auto m = std::make_unique<CSimplePointsMap>();
+	if (reservePoints) m->reserve(reservePoints);
+	return m;
+}
+
+CPointsMapRingBuffer::CPointsMapRingBuffer(
+	size_t numMaps, size_t reservePoints)
+	: m_impl(std::make_shared<Impl>())
+{
+	resize(numMaps, reservePoints);
+}
+
+CSimplePointsMap::Ptr CPointsMapRingBuffer::next()
+{
+	auto lck = mrpt::lockHelper(m_impl->mtx);
+
+	std::unique_ptr<CSimplePointsMap> m;
+	if (!m_impl->freeMaps.empty())
+	{
+		// The most recently released map, likely still in the CPU caches:
+		m = std::move(m_impl->freeMaps.back());
+		m_impl->freeMaps.pop_back();
+
+		// Reset the state, but resize(0) instead of clear() to keep the
+		// memory of the point buffers:
+		m->insertionOptions = CPointsMap::TInsertionOptions();
+		m->likelihoodOptions = CPointsMap::TLikelihoodOptions();
+		m->enableFilterByHeight(false);
+		m->resize(0);
+	}
+	else
+	{
+		m = newPoolMap(0);
+		m_impl->allocations++;
+	}
+	m_impl->checkedOut++;
+
+	// Return the map to the pool when the last reference is released:
+	std::weak_ptr<Impl> weakImpl = m_impl;
+	return CSimplePointsMap::Ptr(m.release(), [weakImpl](CSimplePointsMap* p) {
+		std::unique_ptr<CSimplePointsMap> released(p);
+		auto impl = weakImpl.lock();
+		if (!impl) return;	// The pool no longer exists
+		auto lck2 = mrpt::lockHelper(impl->mtx);
+		impl->checkedOut--;
+		if (impl->freeMaps.size() < impl->maxFree)
+			impl->freeMaps.push_back(std::move(released));
+	});
+}
+
+size_t CPointsMapRingBuffer::size() const
+{
+	auto lck = mrpt::lockHelper(m_impl->mtx);
+	return m_impl->maxFree;
+}
+
+size_t CPointsMapRingBuffer::checkedOutCount() const
+{
+	auto lck = mrpt::lockHelper(m_impl->mtx);
+	return m_impl->checkedOut;
+}
+
+void CPointsMapRingBuffer::resize(size_t numMaps, size_t reservePoints)
+{
+	auto lck = mrpt::lockHelper(m_impl->mtx);
+
+	m_impl->maxFree = numMaps;
+	if (m_impl->freeMaps.size() > numMaps) m_impl->freeMaps.resize(numMaps);
+	if (reservePoints)
+		for (auto& m : m_impl->freeMaps)
+			m->reserve(reservePoints);
+	// Maps in use will also come back to the pool, when released:
+	while (m_impl->freeMaps.size() + m_impl->checkedOut < numMaps)
+		m_impl->freeMaps.push_back(newPoolMap(reservePoints));
+}
+
+size_t CPointsMapRingBuffer::allocationCount() const
+{
+	auto lck = mrpt::lockHelper(m_impl->mtx);
+	return m_impl->allocations;
+}
+
+CPointsMapRingBuffer& CPointsMapRingBuffer::Instance()
+{
+	static CPointsMapRingBuffer instance(DEFAULT_GLOBAL_SIZE);
+	return instance;
+}
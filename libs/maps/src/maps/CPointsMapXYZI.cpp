@@ -202,7 +202,7 @@ void CPointsMapXYZI::insertPointRGB(
 	m_y.push_back(y);
 	m_z.push_back(z);
 	m_intensity.push_back(R_intensity);
-	mark_as_modified();
+	mark_as_appended();
 }
 
 void CPointsMapXYZI::getVisualizationInto(mrpt::opengl::CSetOfObjects& o) const
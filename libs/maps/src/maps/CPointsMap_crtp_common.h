@@ -14,6 +14,79 @@
 
 namespace mrpt::maps::detail
 {
+/** Transforms `n` ranges of a 2D scan into 3D points (gx,gy,gz), given the
+ * cos/sin of each ray and the pose of the sensor as the rows
+ * `(m00,m01,m03)`, `(m10,m11,m13)`, `(m20,m21,m23)` of its homogeneous
+ * matrix (z=0 for all points in the sensor frame).
+ * `ccos`, `csin` and the outputs must be 16-byte aligned and, like `ranges`,
+ * have room for `n` rounded up to a multiple of 4 floats.
+ */
+inline void transformRangesBlock(
+	const float* ranges, const float* ccos, const float* csin, const int n,
+	const float (&M)[3][3], float* gx, float* gy, float* gz)
+{
+#if MRPT_HAS_SSE2
+	// We want to implement:
+	//   scan_gx = m00*scan_x+m01*scan_y+m03;
+	//   scan_gy = m10*scan_x+m11*scan_y+m13;
+	//   scan_gz = m20*scan_x+m21*scan_y+m23;
+	//
+	//  With: scan_x = ccos*range
+	//        scan_y = csin*range
+	//
+	const __m128 m00_4val = _mm_set1_ps(M[0][0]);  // load 4 copies
+	const __m128 m01_4val = _mm_set1_ps(M[0][1]);
+	const __m128 m03_4val = _mm_set1_ps(M[0][2]);
+
+	const __m128 m10_4val = _mm_set1_ps(M[1][0]);
+	const __m128 m11_4val = _mm_set1_ps(M[1][1]);
+	const __m128 m13_4val = _mm_set1_ps(M[1][2]);
+
+	const __m128 m20_4val = _mm_set1_ps(M[2][0]);
+	const __m128 m21_4val = _mm_set1_ps(M[2][1]);
+	const __m128 m23_4val = _mm_set1_ps(M[2][2]);
+
+	for (int i = 0; i < n; i += 4)
+	{
+		const __m128 scan_4vals = _mm_loadu_ps(ranges + i);  // *Unaligned*
+
+		const __m128 xs = _mm_mul_ps(scan_4vals, _mm_load_ps(ccos + i));
+		const __m128 ys = _mm_mul_ps(scan_4vals, _mm_load_ps(csin + i));
+
+		_mm_store_ps(
+			gx + i,
+			_mm_add_ps(
+				m03_4val,
+				_mm_add_ps(
+					_mm_mul_ps(xs, m00_4val),
+					_mm_mul_ps(ys, m01_4val))));
+		_mm_store_ps(
+			gy + i,
+			_mm_add_ps(
+				m13_4val,
+				_mm_add_ps(
+					_mm_mul_ps(xs, m10_4val),
+					_mm_mul_ps(ys, m11_4val))));
+		_mm_store_ps(
+			gz + i,
+			_mm_add_ps(
+				m23_4val,
+				_mm_add_ps(
+					_mm_mul_ps(xs, m20_4val),
+					_mm_mul_ps(ys, m21_4val))));
+	}
+#else
+	// Plain loop, vectorized by the compiler for the target architecture:
+	for (int i = 0; i < n; i++)
+	{
+		const float x = ranges[i] * ccos[i], y = ranges[i] * csin[i];
+		gx[i] = M[0][0] * x + M[0][1] * y + M[0][2];
+		gy[i] = M[1][0] * x + M[1][1] * y + M[1][2];
+		gz[i] = M[2][0] * x + M[2][1] * y + M[2][2];
+	}
+#endif
+}
+
 template <class Derived>
 struct loadFromRangeImpl
 {
@@ -24,7 +97,8 @@ struct loadFromRangeImpl
 		using namespace mrpt::poses;
 		using mrpt::DEG2RAD;
 		using mrpt::square;
-		obj.mark_as_modified();
+		// (resize(0) below marks the map as modified, if not appending)
+		obj.mark_as_appended();
 
 		// The next may seem useless, but it's required in case the observation
 		// underwent a move or copy operator, which may change the reserved mem
@@ -60,15 +134,10 @@ struct loadFromRangeImpl
 		sensorPose3D.getHomogeneousMatrix(lric.HM);
 
 		// For quicker access as "float" numbers:
-		float m00 = lric.HM(0, 0);
-		float m01 = lric.HM(0, 1);
-		float m03 = lric.HM(0, 3);
-		float m10 = lric.HM(1, 0);
-		float m11 = lric.HM(1, 1);
-		float m13 = lric.HM(1, 3);
-		float m20 = lric.HM(2, 0);
-		float m21 = lric.HM(2, 1);
-		float m23 = lric.HM(2, 3);
+		const float M[3][3] = {
+			{d2f(lric.HM(0, 0)), d2f(lric.HM(0, 1)), d2f(lric.HM(0, 3))},
+			{d2f(lric.HM(1, 0)), d2f(lric.HM(1, 1)), d2f(lric.HM(1, 3))},
+			{d2f(lric.HM(2, 0)), d2f(lric.HM(2, 1)), d2f(lric.HM(2, 3))}};
 
 		float lx_1, ly_1, lz_1, lx = 0, ly = 0,
 								lz = 0;	 // Punto anterior y actual:
@@ -120,126 +189,28 @@ struct loadFromRangeImpl
 		const mrpt::obs::CSinCosLookUpTableFor2DScans::TSinCosValues&
 			sincos_vals = obj.m_scans_sincos_cache.getSinCosForScan(rangeScan);
 
-		// Build list of points in global coordinates:
-		Eigen::Array<float, Eigen::Dynamic, 1> scan_gx(sizeRangeScan + 3),
-			scan_gy(sizeRangeScan + 3),
-			scan_gz(
-				sizeRangeScan +
-				3);	 // The +3 is to assure there's room for "nPackets*4"
-		{
-#if MRPT_HAS_SSE2
-			// Number of 4-floats:
-			size_t nPackets = sizeRangeScan / 4;
-			if ((sizeRangeScan & 0x03) != 0) nPackets++;
-
-			// We want to implement:
-			//   scan_gx = m00*scan_x+m01*scan_y+m03;
-			//   scan_gy = m10*scan_x+m11*scan_y+m13;
-			//   scan_gz = m20*scan_x+m21*scan_y+m23;
-			//
-			//  With: scan_x = ccos*range
-			//        scan_y = csin*range
-			//
-			const __m128 m00_4val =
-				_mm_set1_ps(m00);  // load 4 copies of the same value
-			const __m128 m01_4val = _mm_set1_ps(m01);
-			const __m128 m03_4val = _mm_set1_ps(m03);
-
-			const __m128 m10_4val = _mm_set1_ps(m10);
-			const __m128 m11_4val = _mm_set1_ps(m11);
-			const __m128 m13_4val = _mm_set1_ps(m13);
-
-			const __m128 m20_4val = _mm_set1_ps(m20);
-			const __m128 m21_4val = _mm_set1_ps(m21);
-			const __m128 m23_4val = _mm_set1_ps(m23);
-
-			// Make sure the input std::vector<> has room enough for reads of
-			// 4-float at a time:
-			// Invalid reads should not be a problem, but just for safety...
-			// JLBC: OCT/2016: rangeScan.scan() is now, by design, ensured to
-			// hold vectors of 4*N capacity, so there is no need to call
-			// reserve() here.
-
-			const float* ptr_in_scan = &rangeScan.getScanRange(0);
-			const float* ptr_in_cos = &sincos_vals.ccos[0];
-			const float* ptr_in_sin = &sincos_vals.csin[0];
-
-			float* ptr_out_x = &scan_gx[0];
-			float* ptr_out_y = &scan_gy[0];
-			float* ptr_out_z = &scan_gz[0];
-
-			for (; nPackets; nPackets--, ptr_in_scan += 4, ptr_in_cos += 4,
-							 ptr_in_sin += 4, ptr_out_x += 4, ptr_out_y += 4,
-							 ptr_out_z += 4)
-			{
-				const __m128 scan_4vals =
-					_mm_loadu_ps(ptr_in_scan);	// *Unaligned* load
-
-				const __m128 xs =
-					_mm_mul_ps(scan_4vals, _mm_load_ps(ptr_in_cos));
-				const __m128 ys =
-					_mm_mul_ps(scan_4vals, _mm_load_ps(ptr_in_sin));
-
-				_mm_store_ps(
-					ptr_out_x,
-					_mm_add_ps(
-						m03_4val,
-						_mm_add_ps(
-							_mm_mul_ps(xs, m00_4val),
-							_mm_mul_ps(ys, m01_4val))));
-				_mm_store_ps(
-					ptr_out_y,
-					_mm_add_ps(
-						m13_4val,
-						_mm_add_ps(
-							_mm_mul_ps(xs, m10_4val),
-							_mm_mul_ps(ys, m11_4val))));
-				_mm_store_ps(
-					ptr_out_z,
-					_mm_add_ps(
-						m23_4val,
-						_mm_add_ps(
-							_mm_mul_ps(xs, m20_4val),
-							_mm_mul_ps(ys, m21_4val))));
-			}
-#else  // MRPT_HAS_SSE2
-	   // The "+3" is to assure the buffer has room for the SSE2 method
-	   // which works with 4-tuples of floats.
-			Eigen::Array<float, Eigen::Dynamic, 1> scan_x(sizeRangeScan + 3),
-				scan_y(sizeRangeScan + 3);
-
-			// Convert from the std::vector format:
-			const Eigen::Map<Eigen::Matrix<float, Eigen::Dynamic, 1>> scan_vals(
-				const_cast<float*>(&rangeScan.getScanRange(0)),
-				rangeScan.getScanSize(), 1);
-			// SinCos table allocates N+4 floats for the convenience of SSE2:
-			// Map to make it appears it has the correct size:
-			const Eigen::Map<Eigen::Matrix<float, Eigen::Dynamic, 1>> ccos(
-				const_cast<float*>(&sincos_vals.ccos[0]),
-				rangeScan.getScanSize(), 1);
-			const Eigen::Map<Eigen::Matrix<float, Eigen::Dynamic, 1>> csin(
-				const_cast<float*>(&sincos_vals.csin[0]),
-				rangeScan.getScanSize(), 1);
-
-			// Vectorized (optimized) scalar multiplications:
-			scan_x = scan_vals.array() * ccos.array();
-			scan_y = scan_vals.array() * csin.array();
-
-			// To global:
-			// Non (manually) vectorized version:
-			scan_gx = m00 * scan_x + m01 * scan_y + m03;
-			scan_gy = m10 * scan_x + m11 * scan_y + m13;
-			scan_gz = m20 * scan_x + m21 * scan_y + m23;
-#endif	// MRPT_HAS_SSE2
-		}
+		// Transform the scan into global coordinates and filter it in one
+		// pass, in blocks of a fixed number of rays held in the stack, so no
+		// temporary buffer is allocated:
+		constexpr int BLOCK = 64;
+		alignas(16) float scan_gx[BLOCK], scan_gy[BLOCK], scan_gz[BLOCK];
 
+		const float* ranges = &rangeScan.getScanRange(0);
 		for (int i = 0; i < sizeRangeScan; i++)
 		{
+			// Transform the next block of rays:
+			const int k = i % BLOCK;
+			if (k == 0)
+				transformRangesBlock(
+					ranges + i, &sincos_vals.ccos[i], &sincos_vals.csin[i],
+					std::min(BLOCK, sizeRangeScan - i), M, scan_gx, scan_gy,
+					scan_gz);
+
 			if (rangeScan.getScanRangeValidity(i))
 			{
-				lx = scan_gx[i];
-				ly = scan_gy[i];
-				lz = scan_gz[i];
+				lx = scan_gx[k];
+				ly = scan_gy[k];
+				lz = scan_gz[k];
 
 				// Specialized work in derived classes:
 				pointmap_traits<Derived>::
@@ -377,7 +348,8 @@ struct loadFromRangeImpl
 	{
 		using namespace mrpt::poses;
 		using mrpt::square;
-		obj.mark_as_modified();
+		// (resize(0) below marks the map as modified, if not appending)
+		obj.mark_as_appended();
 
 		// If robot pose is supplied, compute sensor pose relative to it.
 		CPose3D sensorPose3D(UNINITIALIZED_POSE);
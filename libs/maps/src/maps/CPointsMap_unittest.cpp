@@ -9,11 +9,21 @@
 
 #include <gtest/gtest.h>
 #include <mrpt/maps/CColouredPointsMap.h>
+#include <mrpt/maps/CPointsMapRingBuffer.h>
 #include <mrpt/maps/CPointsMapXYZI.h>
 #include <mrpt/maps/CSimplePointsMap.h>
 #include <mrpt/maps/CWeightedPointsMap.h>
+#include <mrpt/obs/CObservation2DRangeScan.h>
+#include <mrpt/obs/stock_observations.h>
 #include <mrpt/poses/CPoint2D.h>
-
+#include <mrpt/poses/CPose2D.h>
+#include <mrpt/poses/CPose3D.h>
+#include <mrpt/random/RandomGenerators.h>
+#include <mrpt/system/filesystem.h>
+
+#include <array>
+#include <cmath>
+#include <set>
 #include <sstream>
 
 using namespace mrpt;
@@ -303,3 +313,491 @@ TEST(CColouredPointsMapTests, loadSaveStreams)
 {
 	do_tests_loadSaveStreams<CColouredPointsMap>();
 }
+
+// Parallel and reused-buffers matching must give exactly the same results:
+TEST(CSimplePointsMapTests, determineMatchingParallel)
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(123);
+
+	CSimplePointsMap map1, map2;
+	for (int i = 0; i < 10000; i++)
+	{
+		const float x = rng.drawUniform(-20.0f, 20.0f);
+		const float y = rng.drawUniform(-20.0f, 20.0f);
+		const float z = rng.drawUniform(0.0f, 3.0f);
+		map1.insertPoint(x, y, z);
+		map2.insertPoint(x + 0.02f, y - 0.01f, z);
+	}
+	const CPose2D pose2D(0.05, -0.03, 0.01);
+	const CPose3D pose3D(0.05, -0.03, 0.02, 0.01, 0.005, -0.01);
+
+	for (const bool uniqueRobust : {false, true})
+	{
+		TMatchingParams params;
+		params.maxDistForCorrespondence = 0.2f;
+		params.decimation_other_map_points = 3;
+		params.offset_other_map_points = 1;
+		params.onlyUniqueRobust = uniqueRobust;
+
+		mrpt::tfest::TMatchingPairList ref2D, ref3D;
+		TMatchingExtraResults res2D, res3D;
+		map1.determineMatching2D(&map2, pose2D, ref2D, params, res2D);
+		map1.determineMatching3D(&map2, pose3D, ref3D, params, res3D);
+		EXPECT_GT(ref2D.size(), 1000U);
+		EXPECT_GT(ref3D.size(), 1000U);
+
+		params.workspace = std::make_shared<TMatchingWorkspace>();
+		for (const size_t numThreads : {1, 2, 4})
+		{
+			params.numThreads = numThreads;
+			mrpt::tfest::TMatchingPairList corrs;
+			TMatchingExtraResults res;
+			// Twice, to reuse the same buffers:
+			for (int rep = 0; rep < 2; rep++)
+			{
+				map1.determineMatching2D(&map2, pose2D, corrs, params, res);
+				EXPECT_EQ(corrs, ref2D);
+				EXPECT_EQ(res.sumSqrDist, res2D.sumSqrDist);
+				EXPECT_EQ(res.correspondencesRatio, res2D.correspondencesRatio);
+
+				map1.determineMatching3D(&map2, pose3D, corrs, params, res);
+				EXPECT_EQ(corrs, ref3D);
+				EXPECT_EQ(res.sumSqrDist, res3D.sumSqrDist);
+				EXPECT_EQ(res.correspondencesRatio, res3D.correspondencesRatio);
+			}
+		}
+	}
+}
+
+TEST(CSimplePointsMapTests, dynamicKDTreeIndex)
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(321);
+
+	CSimplePointsMap mapStatic, mapDynamic;
+	mapDynamic.kdtree_search_params.dynamic_index = true;
+
+	for (int batch = 0; batch < 30; batch++)
+	{
+		// Grow both maps, as done with new keyframes in ICP-SLAM:
+		CSimplePointsMap newPoints;
+		for (int i = 0; i < 100; i++)
+			newPoints.insertPoint(
+				rng.drawUniform(-20.0f, 20.0f), rng.drawUniform(-20.0f, 20.0f),
+				rng.drawUniform(0.0f, 3.0f));
+		if (batch % 2 == 0)
+		{
+			mapStatic.insertAnotherMap(&newPoints, CPose3D());
+			mapDynamic.insertAnotherMap(&newPoints, CPose3D());
+		}
+		else
+		{
+			for (size_t i = 0; i < newPoints.size(); i++)
+			{
+				float x, y, z;
+				newPoints.getPoint(i, x, y, z);
+				mapStatic.insertPoint(x, y, z);
+				mapDynamic.insertPoint(x, y, z);
+			}
+		}
+
+		for (int q = 0; q < 10; q++)
+		{
+			const float qx = rng.drawUniform(-20.0f, 20.0f);
+			const float qy = rng.drawUniform(-20.0f, 20.0f);
+			const float qz = rng.drawUniform(0.0f, 3.0f);
+			float x, y, z, d1, d2;
+			EXPECT_EQ(
+				mapStatic.kdTreeClosestPoint3D(qx, qy, qz, x, y, z, d1),
+				mapDynamic.kdTreeClosestPoint3D(qx, qy, qz, x, y, z, d2));
+			EXPECT_EQ(d1, d2);
+			EXPECT_EQ(
+				mapStatic.kdTreeClosestPoint2D(qx, qy, x, y, d1),
+				mapDynamic.kdTreeClosestPoint2D(qx, qy, x, y, d2));
+			EXPECT_EQ(d1, d2);
+		}
+	}
+
+	// Deleting points (which changes the indices of the rest) rebuilds the
+	// whole index:
+	std::vector<bool> deletionMask(mapDynamic.size(), false);
+	for (size_t i = 0; i < deletionMask.size(); i += 2)
+		deletionMask[i] = true;
+	mapStatic.applyDeletionMask(deletionMask);
+	mapDynamic.applyDeletionMask(deletionMask);
+	float x, y, z, d1, d2;
+	EXPECT_EQ(
+		mapStatic.kdTreeClosestPoint3D(1.0f, 2.0f, 1.0f, x, y, z, d1),
+		mapDynamic.kdTreeClosestPoint3D(1.0f, 2.0f, 1.0f, x, y, z, d2));
+	EXPECT_EQ(d1, d2);
+}
+
+TEST(CSimplePointsMapTests, localGeometry)
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(555);
+
+	// A tilted plane:
+	const CPose3D planePose(1.0, 2.0, 0.5, 0.3, 0.2, -0.1);
+	const auto planeNormal = planePose.rotateVector(TVector3D(0, 0, 1));
+	const auto addPoints = [&](CSimplePointsMap& m, size_t n) {
+		for (size_t i = 0; i < n; i++)
+			m.insertPoint(planePose.composePoint(TPoint3D(
+				rng.drawUniform(-5.0, 5.0), rng.drawUniform(-5.0, 5.0), 0)));
+	};
+
+	CSimplePointsMap map;
+	addPoints(map, 2000);
+
+	const auto& geom = map.getLocalGeometry(10, 1e-3f, 1);
+	ASSERT_EQ(geom.normals.size(), map.size());
+	ASSERT_EQ(geom.covariances.size(), map.size());
+	for (size_t i = 0; i < map.size(); i++)
+	{
+		const auto& n = geom.normals[i];
+		EXPECT_NEAR(
+			std::abs(n.x * planeNormal.x + n.y * planeNormal.y +
+					 n.z * planeNormal.z),
+			1.0, 1e-3);
+		// Covariances are thin disks along the plane:
+		const Eigen::Vector3f nf(n.x, n.y, n.z);
+		EXPECT_NEAR(nf.dot(geom.covariances[i].asEigen() * nf), 1e-3f, 1e-4f);
+		EXPECT_NEAR(geom.covariances[i].asEigen().trace(), 2.001f, 1e-4f);
+	}
+
+	// Parallel estimation gives the same results:
+	{
+		CSimplePointsMap map2 = map;
+		const auto& geom2 = map2.getLocalGeometry(10, 1e-3f, 4);
+		EXPECT_EQ(geom2.normals, geom.normals);
+	}
+
+	// Appended points only extend the cache:
+	const auto n0 = geom.normals[0];
+	addPoints(map, 100);
+	const auto& geom3 = map.getLocalGeometry(10, 1e-3f, 1);
+	EXPECT_EQ(geom3.normals.size(), map.size());
+	EXPECT_EQ(geom3.normals[0], n0);
+
+	// ...while modified points reset it:
+	map.setPoint(0, 0.0f, 0.0f, 100.0f);
+	const auto& geom4 = map.getLocalGeometry(10, 1e-3f, 1);
+	EXPECT_EQ(geom4.normals.size(), map.size());
+	EXPECT_NE(geom4.normals[0], n0);
+}
+
+TEST(CSimplePointsMapTests, voxelDecimated)
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(777);
+
+	const float voxelSize = 0.5f;
+	// Reference: first point in each voxel
+	const auto decimate = [&](const CPointsMap& m) {
+		std::set<std::array<int, 3>> voxels;
+		std::vector<TPoint3Df> pts;
+		for (size_t i = 0; i < m.size(); i++)
+		{
+			float x, y, z;
+			m.getPoint(i, x, y, z);
+			const std::array<int, 3> v = {
+				static_cast<int>(std::floor(x / voxelSize)),
+				static_cast<int>(std::floor(y / voxelSize)),
+				static_cast<int>(std::floor(z / voxelSize))};
+			if (voxels.insert(v).second) pts.emplace_back(x, y, z);
+		}
+		return pts;
+	};
+	const auto checkEqual = [](const CPointsMap& m,
+							   const std::vector<TPoint3Df>& pts) {
+		ASSERT_EQ(m.size(), pts.size());
+		for (size_t i = 0; i < pts.size(); i++)
+		{
+			float x, y, z;
+			m.getPoint(i, x, y, z);
+			EXPECT_EQ(TPoint3Df(x, y, z), pts[i]);
+		}
+	};
+	const auto addPoints = [&](CSimplePointsMap& m, size_t n) {
+		for (size_t i = 0; i < n; i++)
+			m.insertPoint(
+				rng.drawUniform(-5.0f, 5.0f), rng.drawUniform(-5.0f, 5.0f),
+				rng.drawUniform(-1.0f, 1.0f));
+	};
+
+	CSimplePointsMap map;
+	addPoints(map, 5000);
+
+	const CPointsMap& dec = map.getVoxelDecimated(voxelSize);
+	checkEqual(dec, decimate(map));
+	EXPECT_LT(dec.size(), map.size());
+
+	// Cached:
+	map.getVoxelDecimated(2 * voxelSize);
+	EXPECT_EQ(&map.getVoxelDecimated(voxelSize), &dec);
+
+	// Appended points are incrementally added to the same map:
+	addPoints(map, 1000);
+	EXPECT_EQ(&map.getVoxelDecimated(voxelSize), &dec);
+	checkEqual(dec, decimate(map));
+
+	// Modified points reset the cache:
+	map.setPoint(0, 100.0f, 100.0f, 100.0f);
+	checkEqual(map.getVoxelDecimated(voxelSize), decimate(map));
+
+	// Copies do not share the cache:
+	CSimplePointsMap map2 = map;
+	EXPECT_NE(
+		&map2.getVoxelDecimated(voxelSize), &map.getVoxelDecimated(voxelSize));
+	checkEqual(map2.getVoxelDecimated(voxelSize), decimate(map));
+}
+
+TEST(CSimplePointsMapTests, loadFromRangeScanFilters)
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(888);
+
+	// Not a multiple of the block size, nor of 4:
+	const size_t N = 250;
+	mrpt::obs::CObservation2DRangeScan scan;
+	scan.aperture = 200.0_deg;
+	scan.sensorPose = CPose3D(0.1, 0.2, 0.3, 10.0_deg, 20.0_deg, 5.0_deg);
+	scan.resizeScan(N);
+	for (size_t i = 0; i < N; i++)
+	{
+		scan.setScanRange(i, rng.drawUniform(0.5f, 5.0f));
+		scan.setScanRangeValidity(i, rng.drawUniform(0.0, 1.0) > 0.1);
+	}
+
+	CSimplePointsMap map;
+	map.insertionOptions.minDistBetweenLaserPoints = 0.3f;
+	map.insertionOptions.addToExistingPointsMap = false;
+	map.enableFilterByHeight(true);
+	map.setHeightFilterLevels(-0.5, 0.8);
+
+	// Reference implementation of the validity, min. distance and height
+	// filters:
+	std::vector<TPoint3D> expected;
+	const double minDist2 = mrpt::square(0.3);
+	const auto zPass = [](const TPoint3D& p) {
+		return p.z >= -0.5 && p.z <= 0.8;
+	};
+	bool lastValid = true, first = true, lastInserted = false;
+	TPoint3D last(-100, -100, -100), p;
+	for (size_t i = 0; i < N; i++)
+	{
+		const bool valid = scan.getScanRangeValidity(i);
+		if (valid)
+		{
+			const double a =
+				-0.5 * scan.aperture + i * scan.aperture / (N - 1);
+			const double r = scan.getScanRange(i);
+			p = scan.sensorPose.composePoint(
+				TPoint3D(r * std::cos(a), r * std::sin(a), 0));
+			lastInserted = false;
+			const bool pass = lastValid && (p - last).sqrNorm() > minDist2;
+			if (first || pass)
+			{
+				first = false;
+				if (zPass(p))
+				{
+					expected.push_back(p);
+					lastInserted = true;
+					last = p;
+				}
+			}
+		}
+		lastValid = valid;
+	}
+	if (lastValid && !lastInserted && zPass(p)) expected.push_back(p);
+
+	// Reuse the map, so the second time no memory is allocated:
+	for (int pass = 0; pass < 2; pass++)
+	{
+		map.loadFromRangeScan(scan);
+		ASSERT_EQ(map.size(), expected.size());
+		for (size_t i = 0; i < map.size(); i++)
+		{
+			float x, y, z;
+			map.getPoint(i, x, y, z);
+			EXPECT_NEAR(x, expected[i].x, 1e-4);
+			EXPECT_NEAR(y, expected[i].y, 1e-4);
+			EXPECT_NEAR(z, expected[i].z, 1e-4);
+		}
+	}
+	// Some points must have been filtered out, but not all:
+	EXPECT_LT(map.size(), N);
+	EXPECT_GT(map.size(), 10U);
+}
+
+TEST(CPointsMapRingBuffer, reuse)
+{
+	CPointsMapRingBuffer ring(2, 100);
+	EXPECT_EQ(ring.size(), 2U);
+
+	auto m1 = ring.next();
+	auto m2 = ring.next();
+	EXPECT_NE(m2.get(), m1.get());
+	const auto* m2Ptr = m2.get();
+	m2.reset();
+
+	// m1 is still in use, m2 is not:
+	auto m3 = ring.next();
+	EXPECT_EQ(m3.get(), m2Ptr);
+	EXPECT_EQ(ring.allocationCount(), 0U);
+
+	// All maps in use: a new one is allocated:
+	auto m4 = ring.next();
+	EXPECT_EQ(ring.allocationCount(), 1U);
+	EXPECT_NE(m4.get(), m1.get());
+	EXPECT_NE(m4.get(), m3.get());
+
+	// Released maps are reused, empty and with default options:
+	m3->insertPoint(1.0f, 2.0f, 3.0f);
+	m3->insertionOptions.minDistBetweenLaserPoints = 1.0f;
+	m3.reset();
+	auto m5 = ring.next();
+	EXPECT_EQ(m5.get(), m2Ptr);
+	EXPECT_TRUE(m5->empty());
+	EXPECT_EQ(
+		m5->insertionOptions.minDistBetweenLaserPoints,
+		CPointsMap::TInsertionOptions().minDistBetweenLaserPoints);
+	EXPECT_EQ(ring.allocationCount(), 1U);
+	EXPECT_EQ(ring.checkedOutCount(), 3U);
+
+	// At most size() free maps are kept:
+	m1.reset();
+	m4.reset();
+	m5.reset();
+	EXPECT_EQ(ring.checkedOutCount(), 0U);
+	auto a = ring.next(), b = ring.next(), c = ring.next();
+	EXPECT_EQ(ring.allocationCount(), 2U);
+
+	// Maps may outlive the pool:
+	{
+		CPointsMapRingBuffer ring2(1);
+		a = ring2.next();
+	}
+	a->insertPoint(1.0f, 2.0f, 3.0f);
+	a.reset();
+
+	// The global pool is enabled by default:
+	EXPECT_EQ(
+		CPointsMapRingBuffer::Instance().size(),
+		CPointsMapRingBuffer::DEFAULT_GLOBAL_SIZE);
+}
+
+TEST(CPointsMapRingBuffer, buildAuxPointsMapReusesMaps)
+{
+	mrpt::obs::CObservation2DRangeScan scan;
+	mrpt::obs::stock_observations::example2DRangeScan(scan);
+
+	auto& pool = CPointsMapRingBuffer::Instance();
+	const auto allocs = pool.allocationCount();
+
+	// With the default global pool, the cached map of each new scan is the
+	// one released by the previous scan, with the same point buffers:
+	const CPointsMap* lastMap = nullptr;
+	const float* lastXs = nullptr;
+	for (int i = 0; i < 5; i++)
+	{
+		auto obs = std::make_shared<mrpt::obs::CObservation2DRangeScan>(scan);
+		const auto* m = obs->buildAuxPointsMap<CPointsMap>();
+		ASSERT_TRUE(m != nullptr);
+		EXPECT_GT(m->size(), 0U);
+		const float* xs = m->getPointsBufferRef_x().data();
+		if (i > 0)
+		{
+			EXPECT_EQ(m, lastMap);
+			EXPECT_EQ(xs, lastXs);
+		}
+		lastMap = m;
+		lastXs = xs;
+	}
+	EXPECT_EQ(pool.allocationCount(), allocs);
+	EXPECT_EQ(pool.checkedOutCount(), 0U);
+}
+
+template <class MAP>
+void do_test_binaryFile()
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(123);
+
+	// Random values in all fields, including color or intensity:
+	const size_t N = 1001;
+	MAP pts;
+	pts.resize(N);
+	std::vector<float> fields;
+	pts.getPointAllFieldsFast(0, fields);
+	for (size_t i = 0; i < N; i++)
+	{
+		for (auto& v : fields)
+			v = rng.drawUniform(0.0f, 1.0f);
+		pts.setPointAllFieldsFast(i, fields);
+	}
+
+	const auto fil = mrpt::system::getTempFileName();
+	ASSERT_TRUE(pts.saveToBinaryFile(fil));
+
+	MAP pts2;
+	pts2.insertPoint(1.0f, 2.0f, 3.0f);	 // must be replaced
+	ASSERT_TRUE(pts2.loadFromBinaryFile(fil));
+	ASSERT_EQ(pts2.size(), N);
+	std::vector<float> fields2;
+	for (size_t i = 0; i < N; i++)
+	{
+		pts.getPointAllFieldsFast(i, fields);
+		pts2.getPointAllFieldsFast(i, fields2);
+		EXPECT_EQ(fields, fields2);
+	}
+
+	// Other classes only take the common fields:
+	CSimplePointsMap pts3;
+	ASSERT_TRUE(pts3.loadFromBinaryFile(fil));
+	ASSERT_EQ(pts3.size(), N);
+	EXPECT_EQ(pts3.getPointsBufferRef_z(), pts.getPointsBufferRef_z());
+
+	mrpt::system::deleteFile(fil);
+
+	EXPECT_FALSE(pts3.loadFromBinaryFile(fil));
+	EXPECT_EQ(pts3.size(), 0U);
+}
+
+TEST(CSimplePointsMapTests, binaryFile)
+{
+	do_test_binaryFile<CSimplePointsMap>();
+}
+
+TEST(CColouredPointsMapTests, binaryFile)
+{
+	do_test_binaryFile<CColouredPointsMap>();
+}
+
+TEST(CPointsMapXYZI, binaryFile) { do_test_binaryFile<CPointsMapXYZI>(); }
+
+TEST(CSimplePointsMapTests, binaryPlyFile)
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(123);
+
+	// More than one block of vertices:
+	CSimplePointsMap pts;
+	for (size_t i = 0; i < 10000; i++)
+		pts.insertPoint(
+			rng.drawUniform(-10.0f, 10.0f), rng.drawUniform(-10.0f, 10.0f),
+			rng.drawUniform(-10.0f, 10.0f));
+
+	const auto fil = mrpt::system::getTempFileName() + ".ply";
+	ASSERT_TRUE(pts.saveToPlyFile(fil, true /*binary*/));
+
+	CSimplePointsMap pts2;
+	ASSERT_TRUE(pts2.loadFromPlyFile(fil));
+	ASSERT_EQ(pts2.size(), pts.size());
+	EXPECT_EQ(pts2.getPointsBufferRef_x(), pts.getPointsBufferRef_x());
+	EXPECT_EQ(pts2.getPointsBufferRef_y(), pts.getPointsBufferRef_y());
+	EXPECT_EQ(pts2.getPointsBufferRef_z(), pts.getPointsBufferRef_z());
+
+	mrpt::system::deleteFile(fil);
+}
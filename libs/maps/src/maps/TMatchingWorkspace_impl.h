@@ -0,0 +1,75 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/core/parallel_for.h>
+#include <mrpt/maps/metric_map_types.h>
+
+#include <algorithm>
+#include <vector>
+
+// Shared implementation of the search for correspondences in blocks of
+// query points, used by determineMatching*() of several map classes.
+namespace mrpt::maps::internal
+{
+// Number of query points in each block of the search for correspondences.
+// Blocks are merged in order, so results do not depend on the threads count.
+constexpr size_t MATCHING_BLOCK_SIZE = 1024;
+
+/** Calls `matchPoint(localIdx, blockCorrs)` for each query point
+ * `localIdx = offset + k*decimation < nLocalPoints`, with the queries split
+ * in blocks distributed among `params.numThreads` threads, then concatenates
+ * the pairings of all blocks into `out`, in order.
+ * \return The sum of the squared errors of all pairings.
+ */
+template <class FUNC>
+float matchPointsInBlocks(
+	const mrpt::maps::TMatchingParams& params, size_t nLocalPoints,
+	mrpt::maps::TMatchingWorkspace& ws, mrpt::tfest::TMatchingPairList& out,
+	FUNC&& matchPoint)
+{
+	const size_t offset = params.offset_other_map_points;
+	const size_t decim = params.decimation_other_map_points;
+	const size_t nQueries =
+		offset < nLocalPoints ? (nLocalPoints - offset + decim - 1) / decim : 0;
+	const size_t nBlocks =
+		(nQueries + MATCHING_BLOCK_SIZE - 1) / MATCHING_BLOCK_SIZE;
+
+	if (ws.blockCorrs.size() < nBlocks) ws.blockCorrs.resize(nBlocks);
+	ws.blockSqrDist.assign(nBlocks, 0);
+
+	mrpt::parallelFor(nBlocks, 1, params.numThreads, [&](size_t b, size_t) {
+		auto& corrs = ws.blockCorrs[b];
+		corrs.clear();
+		const size_t k1 = std::min(nQueries, (b + 1) * MATCHING_BLOCK_SIZE);
+		for (size_t k = b * MATCHING_BLOCK_SIZE; k < k1; k++)
+			matchPoint(offset + k * decim, corrs);
+
+		float sumSqr = 0;
+		for (const auto& p : corrs)
+			sumSqr += p.errorSquareAfterTransformation;
+		ws.blockSqrDist[b] = sumSqr;
+	});
+
+	// Merge, in order:
+	size_t nTotal = 0;
+	for (size_t b = 0; b < nBlocks; b++)
+		nTotal += ws.blockCorrs[b].size();
+	out.clear();
+	out.reserve(nTotal);
+
+	float sumSqrDist = 0;
+	for (size_t b = 0; b < nBlocks; b++)
+	{
+		out.insert(out.end(), ws.blockCorrs[b].begin(), ws.blockCorrs[b].end());
+		sumSqrDist += ws.blockSqrDist[b];
+	}
+	return sumSqrDist;
+}
+}  // namespace mrpt::maps::internal
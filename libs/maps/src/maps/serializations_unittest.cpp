@@ -44,6 +44,8 @@ TEST_CLASS_MOVE_COPY_CTORS(CWeightedPointsMap);
 TEST_CLASS_MOVE_COPY_CTORS(CPointsMapXYZI);
 TEST_CLASS_MOVE_COPY_CTORS(COctoMap);
 TEST_CLASS_MOVE_COPY_CTORS(CColouredOctoMap);
+TEST_CLASS_MOVE_COPY_CTORS(CHashedOctoMap);
+TEST_CLASS_MOVE_COPY_CTORS(CHashedVoxelPointsMap);
 TEST_CLASS_MOVE_COPY_CTORS(CSinCosLookUpTableFor2DScans);
 // obs:
 TEST_CLASS_MOVE_COPY_CTORS(CObservationPointCloud);
@@ -72,6 +74,8 @@ TEST(SerializeTestMaps, WriteReadToMem)
 		CLASS_ID(CPointsMapXYZI),
 		CLASS_ID(COctoMap),
 		CLASS_ID(CColouredOctoMap),
+		CLASS_ID(CHashedOctoMap),
+		CLASS_ID(CHashedVoxelPointsMap),
 		// obs:
 		CLASS_ID(CObservationPointCloud),
 		CLASS_ID(CObservationRotatingScan),
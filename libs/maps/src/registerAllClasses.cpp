@@ -45,6 +45,8 @@ MRPT_INITIALIZER(registerAllClasses_mrpt_maps)
 
 	registerClass(CLASS_ID(COctoMap));
 	registerClass(CLASS_ID(CColouredOctoMap));
+	registerClass(CLASS_ID(CHashedOctoMap));
+	registerClass(CLASS_ID(CHashedVoxelPointsMap));
 
 	registerClass(CLASS_ID(CAngularObservationMesh));
 	registerClass(CLASS_ID(CPlanarLaserScan));
@@ -14,11 +14,14 @@
 #include <mrpt/math/TPoint2D.h>
 #include <mrpt/math/TPoint3D.h>
 
+#include <algorithm>
 #include <array>
 #include <atomic>
+#include <cstdint>
 #include <memory>  // unique_ptr
 #include <mutex>
 #include <nanoflann.hpp>
+#include <vector>
 
 namespace mrpt::math
 {
@@ -61,13 +64,27 @@ namespace mrpt::math
  *  \endcode
  *
  * The KD-tree index will be built on demand only upon call of any of the query
- * methods provided by this class.
+ * methods provided by this class. One 2D and one 3D index are cached, and
+ * both are invalidated when the data points change.
  *
- * Notice that there is only ONE internal cached KD-tree, so if a method to
- * query a 2D point is called, then another method for 3D points, then again
- * the 2D method, three KD-trees will be built. So, try to group all the calls
- * for a given dimensionality together or build different class instances for
- * queries of each dimensionality.
+ * <b>Dynamic index mode:</b> If `kdtree_search_params.dynamic_index` is
+ * enabled, points are indexed in a "logarithmic forest" of static KD-trees
+ * (Bentley-Saxe) instead of a single tree. Derived classes which only append
+ * new points at the end of the data set can then call
+ * `kdtree_mark_as_appended()` instead of `kdtree_mark_as_outdated()`: new
+ * points go to a new small tree, merged with the smaller existing ones when
+ * they reach its size. Each point is re-indexed O(log N) times, instead of
+ * rebuilding a tree with all N points after each change. Derived classes
+ * with stable point indices can also remove points via
+ * `kdtree_mark_as_removed()`: they are skipped by queries, and the forest is
+ * compacted once they are too many. Queries visit O(log N) trees, so they
+ * are somewhat slower than in the static mode.
+ *
+ * <b>Thread safety:</b> Queries may run concurrently among themselves, and
+ * build the index on demand under an internal lock. However, queries must not
+ * overlap with changes to the data points or calls to the `kdtree_mark_as_*()`
+ * methods: the data and the removal marks are read without a lock during the
+ * query, so the caller must serialize them.
  *
  * \sa See some of the derived classes for example implementations. See also
  * the documentation of nanoflann
@@ -85,10 +102,16 @@ class KDTreeCapable
 
 	/// Constructor
 	inline KDTreeCapable() = default;
-	KDTreeCapable(const KDTreeCapable&) : KDTreeCapable() {}
-	KDTreeCapable& operator=(const KDTreeCapable&)
+	/** Copy ctor: copies the search parameters and removal marks, but not the
+	 * index, which will be rebuilt if required */
+	KDTreeCapable(const KDTreeCapable& o) : KDTreeCapable() { *this = o; }
+	KDTreeCapable& operator=(const KDTreeCapable& o)
 	{
+		if (&o == this) return *this;
 		kdtree_mark_as_outdated();
+		std::lock_guard<std::mutex> lck(o.m_kdtree_mtx);
+		kdtree_search_params = o.kdtree_search_params;
+		m_kdtree_removed = o.m_kdtree_removed;
 		return *this;
 	}
 
@@ -104,6 +127,9 @@ class KDTreeCapable
 		TKDTreeSearchParams() = default;
 		/** Max points per leaf */
 		size_t leaf_max_size = 10;
+		/** Use a forest of KD-trees which can be incrementally updated as
+		 * points are appended or removed (see KDTreeCapable docs) */
+		bool dynamic_index = false;
 	};
 
 	/** Parameters to tune KD-tree searches. Refer to nanoflann docs.
@@ -145,8 +171,7 @@ class KDTreeCapable
 		resultSet.init(&ret_index, &out_dist_sqr);
 
 		const std::array<num_t, 2> query_point{{x0, y0}};
-		m_kdtree2d_data.index->findNeighbors(
-			resultSet, &query_point[0], nanoflann::SearchParams());
+		kdtree_find_neighbors(m_kdtree2d_data, resultSet, &query_point[0]);
 
 		// Copy output to user vars:
 		out_x = derived().kdtree_get_pt(ret_index, 0);
@@ -171,8 +196,7 @@ class KDTreeCapable
 		resultSet.init(&ret_index, &out_dist_sqr);
 
 		const std::array<num_t, 2> query_point{{x0, y0}};
-		m_kdtree2d_data.index->findNeighbors(
-			resultSet, &query_point[0], nanoflann::SearchParams());
+		kdtree_find_neighbors(m_kdtree2d_data, resultSet, &query_point[0]);
 
 		return ret_index;
 		MRPT_END
@@ -241,8 +265,7 @@ class KDTreeCapable
 		resultSet.init(&ret_indexes[0], &ret_sqdist[0]);
 
 		const std::array<num_t, 2> query_point{{x0, y0}};
-		m_kdtree2d_data.index->findNeighbors(
-			resultSet, &query_point[0], nanoflann::SearchParams());
+		kdtree_find_neighbors(m_kdtree2d_data, resultSet, &query_point[0]);
 
 		// Copy output to user vars:
 		out_x1 = derived().kdtree_get_pt(ret_indexes[0], 0);
@@ -308,8 +331,7 @@ class KDTreeCapable
 		resultSet.init(&ret_indexes[0], &out_dist_sqr[0]);
 
 		const std::array<num_t, 2> query_point{{x0, y0}};
-		m_kdtree2d_data.index->findNeighbors(
-			resultSet, &query_point[0], nanoflann::SearchParams());
+		kdtree_find_neighbors(m_kdtree2d_data, resultSet, &query_point[0]);
 
 		for (size_t i = 0; i < knn; i++)
 		{
@@ -367,8 +389,7 @@ class KDTreeCapable
 		resultSet.init(&out_idx[0], &out_dist_sqr[0]);
 
 		const std::array<num_t, 2> query_point{{x0, y0}};
-		m_kdtree2d_data.index->findNeighbors(
-			resultSet, &query_point[0], nanoflann::SearchParams());
+		kdtree_find_neighbors(m_kdtree2d_data, resultSet, &query_point[0]);
 		MRPT_END
 	}
 
@@ -414,8 +435,7 @@ class KDTreeCapable
 		resultSet.init(&ret_index, &out_dist_sqr);
 
 		const std::array<num_t, 3> query_point{{x0, y0, z0}};
-		m_kdtree3d_data.index->findNeighbors(
-			resultSet, &query_point[0], nanoflann::SearchParams());
+		kdtree_find_neighbors(m_kdtree3d_data, resultSet, &query_point[0]);
 
 		// Copy output to user vars:
 		out_x = derived().kdtree_get_pt(ret_index, 0);
@@ -441,8 +461,7 @@ class KDTreeCapable
 		resultSet.init(&ret_index, &out_dist_sqr);
 
 		const std::array<num_t, 3> query_point{{x0, y0, z0}};
-		m_kdtree3d_data.index->findNeighbors(
-			resultSet, &query_point[0], nanoflann::SearchParams());
+		kdtree_find_neighbors(m_kdtree3d_data, resultSet, &query_point[0]);
 
 		return ret_index;
 		MRPT_END
@@ -503,8 +522,7 @@ class KDTreeCapable
 		resultSet.init(&ret_indexes[0], &out_dist_sqr[0]);
 
 		const std::array<num_t, 3> query_point{{x0, y0, z0}};
-		m_kdtree3d_data.index->findNeighbors(
-			resultSet, &query_point[0], nanoflann::SearchParams());
+		kdtree_find_neighbors(m_kdtree3d_data, resultSet, &query_point[0]);
 
 		for (size_t i = 0; i < knn; i++)
 		{
@@ -558,8 +576,7 @@ class KDTreeCapable
 		resultSet.init(&out_idx[0], &out_dist_sqr[0]);
 
 		const std::array<num_t, 3> query_point{{x0, y0, z0}};
-		m_kdtree3d_data.index->findNeighbors(
-			resultSet, &query_point[0], nanoflann::SearchParams());
+		kdtree_find_neighbors(m_kdtree3d_data, resultSet, &query_point[0]);
 
 		for (size_t i = 0; i < knn; i++)
 		{
@@ -614,9 +631,8 @@ class KDTreeCapable
 		if (m_kdtree3d_data.m_num_points != 0)
 		{
 			const num_t xyz[3] = {x0, y0, z0};
-			m_kdtree3d_data.index->radiusSearch(
-				&xyz[0], maxRadiusSqr, out_indices_dist,
-				nanoflann::SearchParams());
+			kdtree_radius_search(
+				m_kdtree3d_data, &xyz[0], maxRadiusSqr, out_indices_dist);
 		}
 		return out_indices_dist.size();
 		MRPT_END
@@ -648,9 +664,8 @@ class KDTreeCapable
 		if (m_kdtree2d_data.m_num_points != 0)
 		{
 			const num_t xyz[2] = {x0, y0};
-			m_kdtree2d_data.index->radiusSearch(
-				&xyz[0], maxRadiusSqr, out_indices_dist,
-				nanoflann::SearchParams());
+			kdtree_radius_search(
+				m_kdtree2d_data, &xyz[0], maxRadiusSqr, out_indices_dist);
 		}
 		return out_indices_dist.size();
 		MRPT_END
@@ -688,8 +703,7 @@ class KDTreeCapable
 		resultSet.init(&out_idx[0], &out_dist_sqr[0]);
 
 		const std::array<num_t, 3> query_point{{x0, y0, z0}};
-		m_kdtree3d_data.index->findNeighbors(
-			resultSet, &query_point[0], nanoflann::SearchParams());
+		kdtree_find_neighbors(m_kdtree3d_data, resultSet, &query_point[0]);
 		MRPT_END
 	}
 
@@ -701,8 +715,8 @@ class KDTreeCapable
 			d2f(p0.x), d2f(p0.y), d2f(p0.z), N, outIdx, outDistSqr);
 	}
 
-	inline void kdTreeEnsureIndexBuilt3D() { rebuild_kdTree_3D(); }
-	inline void kdTreeEnsureIndexBuilt2D() { rebuild_kdTree_2D(); }
+	inline void kdTreeEnsureIndexBuilt3D() const { rebuild_kdTree_3D(); }
+	inline void kdTreeEnsureIndexBuilt2D() const { rebuild_kdTree_2D(); }
 
 	/* @} */
 
@@ -711,10 +725,53 @@ class KDTreeCapable
 	inline void kdtree_mark_as_outdated() const
 	{
 		std::lock_guard<std::mutex> lck(m_kdtree_mtx);
-		m_kdtree_is_uptodate = false;
+		m_kdtree2d_data.mark_as_outdated(true);
+		m_kdtree3d_data.mark_as_outdated(true);
+		m_kdtree_removed.clear();
+	}
+
+	/** To be called by child classes instead of kdtree_mark_as_outdated()
+	 * when the only change in the data is that new points have been appended
+	 * after the existing ones. In the dynamic index mode, only the new points
+	 * will be indexed; otherwise, it is like kdtree_mark_as_outdated(). */
+	inline void kdtree_mark_as_appended() const
+	{
+		std::lock_guard<std::mutex> lck(m_kdtree_mtx);
+		m_kdtree2d_data.mark_as_outdated(false);
+		m_kdtree3d_data.mark_as_outdated(false);
+	}
+
+	/** Marks the data point with index `idx` as removed, so it is not returned
+	 * by any further query. For child classes which keep the indices of the
+	 * rest of points unchanged (e.g. with a free list of slots). Requires the
+	 * dynamic index mode. Removal marks are reset by kdtree_mark_as_outdated().
+	 * Must not be called while a query is running (see class thread safety).
+	 */
+	inline void kdtree_mark_as_removed(size_t idx) const
+	{
+		ASSERTMSG_(
+			kdtree_search_params.dynamic_index,
+			"Removing points requires kdtree_search_params.dynamic_index");
+		std::lock_guard<std::mutex> lck(m_kdtree_mtx);
+		if (idx >= m_kdtree_removed.size()) m_kdtree_removed.resize(idx + 1, 0);
+		if (m_kdtree_removed[idx]) return;
+		m_kdtree_removed[idx] = 1;
+		m_kdtree2d_data.mark_as_removed(idx);
+		m_kdtree3d_data.mark_as_removed(idx);
 	}
 
    private:
+	/** Changes the data source type of a nanoflann metric class */
+	template <class METRIC, class DATASOURCE>
+	struct rebind_metric;
+	template <
+		template <class, class, class...> class METRIC, class T, class D,
+		class... ARGS, class DATASOURCE>
+	struct rebind_metric<METRIC<T, D, ARGS...>, DATASOURCE>
+	{
+		using type = METRIC<T, DATASOURCE, ARGS...>;
+	};
+
 	/** Internal structure with the KD-tree representation (mainly used to avoid
 	 * copying pointers with the = operator) */
 	template <int _DIM = -1>
@@ -730,96 +787,260 @@ class KDTreeCapable
 		 * will be created if required!  */
 		inline TKDTreeDataHolder& operator=(const TKDTreeDataHolder& o) noexcept
 		{
-			if (&o != this) clear();
+			if (&o != this)
+			{
+				clear();
+				mark_as_outdated(true);
+			}
 			return *this;
 		}
 
 		/** Free memory (if allocated)  */
-		inline void clear() noexcept { index.reset(); }
+		inline void clear() noexcept
+		{
+			index.reset();
+			forest.clear();
+			m_num_points = 0;
+			m_num_indexed = 0;
+			m_num_removed = 0;
+		}
 		using kdtree_index_t = nanoflann::KDTreeSingleIndexAdaptor<
 			metric_t, Derived, _DIM, std::size_t /*index*/>;
 
-		/** nullptr or the up-to-date index */
+		/** Dynamic mode: a static KD-tree over a subset of the data points,
+		 * which also acts as the nanoflann data set adaptor of the subset */
+		struct TSubTree
+		{
+			using index_t = nanoflann::KDTreeSingleIndexAdaptor<
+				typename rebind_metric<metric_t, TSubTree>::type, TSubTree,
+				_DIM, std::size_t>;
+
+			TSubTree(
+				const Derived& data, std::vector<size_t>&& indices,
+				size_t leaf_max_size)
+				: m_data(data), idxs(std::move(indices))
+			{
+				index = std::make_unique<index_t>(
+					_DIM, *this,
+					nanoflann::KDTreeSingleIndexAdaptorParams(leaf_max_size));
+				index->buildIndex();
+			}
+			TSubTree(const TSubTree&) = delete;
+			TSubTree& operator=(const TSubTree&) = delete;
+
+			// nanoflann data set adaptor interface:
+			inline size_t kdtree_get_point_count() const { return idxs.size(); }
+			inline num_t kdtree_get_pt(size_t i, int dim) const
+			{
+				return m_data.kdtree_get_pt(idxs[i], dim);
+			}
+			template <class BBOX>
+			bool kdtree_get_bbox(BBOX&) const
+			{
+				return false;
+			}
+
+			const Derived& m_data;
+			/** Indices of the data points in this tree */
+			std::vector<size_t> idxs;
+			std::unique_ptr<index_t> index;
+		};
+
+		/** nullptr or the up-to-date index (static mode) */
 		std::unique_ptr<kdtree_index_t> index;
+		/** Dynamic mode: trees over disjoint subsets of points, from the
+		 * oldest (largest) to the newest (smallest) one */
+		std::vector<std::unique_ptr<TSubTree>> forest;
 
 		/** Dimensionality. typ: 2,3 */
 		size_t m_dim = _DIM;
+		/** Number of indexed points, not counting removed ones */
 		size_t m_num_points = 0;
+		/** Dynamic mode: data points [0,m_num_indexed) are in the forest */
+		size_t m_num_indexed = 0;
+		/** Dynamic mode: removed points still present in the forest */
+		size_t m_num_removed = 0;
+		/** Whether the index was built in the dynamic mode */
+		bool dynamic = false;
+		/** Whether the index must be fully rebuilt (vs. new points appended) */
+		bool needs_full_rebuild = true;
+		/** Whether the index needs to be updated or not */
+		std::atomic_bool is_uptodate{false};
+
+		void mark_as_outdated(bool fullRebuild)
+		{
+			if (fullRebuild) needs_full_rebuild = true;
+			is_uptodate = false;
+		}
+		void mark_as_removed(size_t idx)
+		{
+			if (!dynamic || needs_full_rebuild || idx >= m_num_indexed) return;
+			m_num_removed++;
+			m_num_points--;
+			// Compact the forest if there are too many removed points:
+			if (m_num_removed > m_num_points) is_uptodate = false;
+		}
 	};
 
-	mutable std::mutex m_kdtree_mtx;
-	mutable TKDTreeDataHolder<2> m_kdtree2d_data;
-	mutable TKDTreeDataHolder<3> m_kdtree3d_data;
-	/** whether the KD tree needs to be rebuilt or not. */
-	mutable std::atomic_bool m_kdtree_is_uptodate{false};
-
-	/// Rebuild, if needed the KD-tree for 2D (nDims=2), 3D (nDims=3), ...
-	/// asking the child class for the data points.
-	void rebuild_kdTree_2D() const
+	/** Wraps a nanoflann result set to return indices of the data points
+	 * from the indices within a TSubTree, skipping removed points */
+	template <class RESULTSET>
+	struct TSubsetResultSet
 	{
-		if (m_kdtree_is_uptodate) return;
+		RESULTSET& results;
+		const std::vector<size_t>& idxs;
+		/** nullptr if there are no removed points */
+		const std::vector<uint8_t>* removed;
 
-		std::lock_guard<std::mutex> lck(m_kdtree_mtx);
-		using tree2d_t = typename TKDTreeDataHolder<2>::kdtree_index_t;
+		inline bool addPoint(num_t dist, size_t i)
+		{
+			const size_t idx = idxs[i];
+			if (removed && idx < removed->size() && (*removed)[idx])
+				return true;  // Skip it, and go on searching
+			return results.addPoint(dist, idx);
+		}
+		inline num_t worstDist() const { return results.worstDist(); }
+		inline bool full() const { return results.full(); }
+	};
 
-		if (!m_kdtree_is_uptodate)
+	/// Runs a nanoflann search on the static index or the forest of trees
+	template <class HOLDER, class RESULTSET>
+	void kdtree_find_neighbors(
+		const HOLDER& d, RESULTSET& resultSet, const num_t* query) const
+	{
+		if (!d.dynamic)
+		{
+			d.index->findNeighbors(resultSet, query, nanoflann::SearchParams());
+			return;
+		}
+		const std::vector<uint8_t>* removed =
+			d.m_num_removed ? &m_kdtree_removed : nullptr;
+		for (const auto& tree : d.forest)
 		{
-			m_kdtree2d_data.clear();
-			m_kdtree3d_data.clear();
+			TSubsetResultSet<RESULTSET> subsetResults{
+				resultSet, tree->idxs, removed};
+			tree->index->findNeighbors(
+				subsetResults, query, nanoflann::SearchParams());
 		}
+	}
 
-		if (!m_kdtree2d_data.index)
+	/// Radius search, sorted by ascending distances
+	template <class HOLDER>
+	void kdtree_radius_search(
+		const HOLDER& d, const num_t* query, const num_t maxRadiusSqr,
+		std::vector<std::pair<size_t, num_t>>& out_indices_dist) const
+	{
+		if (!d.dynamic)
 		{
-			// Erase previous tree:
-			m_kdtree2d_data.clear();
-			// And build new index:
-			const size_t N = derived().kdtree_get_point_count();
-			m_kdtree2d_data.m_num_points = N;
-			m_kdtree2d_data.m_dim = 2;
-			if (N)
-			{
-				m_kdtree2d_data.index = std::make_unique<tree2d_t>(
-					2, derived(),
-					nanoflann::KDTreeSingleIndexAdaptorParams(
-						kdtree_search_params.leaf_max_size));
-				m_kdtree2d_data.index->buildIndex();
-			}
-			m_kdtree_is_uptodate = true;
+			d.index->radiusSearch(
+				query, maxRadiusSqr, out_indices_dist,
+				nanoflann::SearchParams());
+			return;
 		}
+		nanoflann::RadiusResultSet<num_t, size_t> resultSet(
+			maxRadiusSqr, out_indices_dist);
+		kdtree_find_neighbors(d, resultSet, query);
+		std::sort(
+			out_indices_dist.begin(), out_indices_dist.end(),
+			[](const auto& a, const auto& b) { return a.second < b.second; });
 	}
 
+	mutable std::mutex m_kdtree_mtx;
+	mutable TKDTreeDataHolder<2> m_kdtree2d_data;
+	mutable TKDTreeDataHolder<3> m_kdtree3d_data;
+	/** Dynamic mode: removal marks of data points (1=removed) */
+	mutable std::vector<uint8_t> m_kdtree_removed;
+
+	/// Rebuild, if needed the KD-tree for 2D (nDims=2), 3D (nDims=3), ...
+	/// asking the child class for the data points.
+	void rebuild_kdTree_2D() const { rebuild_kdTree(m_kdtree2d_data); }
+
 	/// Rebuild, if needed the KD-tree for 2D (nDims=2), 3D (nDims=3), ...
 	/// asking the child class for the data points.
-	void rebuild_kdTree_3D() const
+	void rebuild_kdTree_3D() const { rebuild_kdTree(m_kdtree3d_data); }
+
+	template <int _DIM>
+	void rebuild_kdTree(TKDTreeDataHolder<_DIM>& d) const
 	{
-		if (m_kdtree_is_uptodate) return;
+		using holder_t = TKDTreeDataHolder<_DIM>;
+
+		if (d.is_uptodate) return;
 		std::lock_guard<std::mutex> lck(m_kdtree_mtx);
-		using tree3d_t = typename TKDTreeDataHolder<3>::kdtree_index_t;
+		if (d.is_uptodate) return;
 
-		if (!m_kdtree_is_uptodate)
-		{
-			m_kdtree2d_data.clear();
-			m_kdtree3d_data.clear();
-		}
+		const size_t N = derived().kdtree_get_point_count();
+		const bool dynamic = kdtree_search_params.dynamic_index;
 
-		if (!m_kdtree3d_data.index)
+		if (d.needs_full_rebuild || dynamic != d.dynamic ||
+			N < d.m_num_indexed)
+			d.clear();	// Erase previous tree(s)
+		d.m_dim = _DIM;
+		d.dynamic = dynamic;
+		d.needs_full_rebuild = false;
+
+		if (!dynamic)
 		{
-			// Erase previous tree:
-			m_kdtree3d_data.clear();
 			// And build new index:
-			const size_t N = derived().kdtree_get_point_count();
-			m_kdtree3d_data.m_num_points = N;
-			m_kdtree3d_data.m_dim = 3;
+			d.m_num_points = N;
 			if (N)
 			{
-				m_kdtree3d_data.index = std::make_unique<tree3d_t>(
-					3, derived(),
+				d.index = std::make_unique<typename holder_t::kdtree_index_t>(
+					_DIM, derived(),
 					nanoflann::KDTreeSingleIndexAdaptorParams(
 						kdtree_search_params.leaf_max_size));
-				m_kdtree3d_data.index->buildIndex();
+				d.index->buildIndex();
 			}
-			m_kdtree_is_uptodate = true;
+			d.is_uptodate = true;
+			return;
 		}
+
+		const auto isRemoved = [this](size_t idx) {
+			return idx < m_kdtree_removed.size() && m_kdtree_removed[idx];
+		};
+		// Takes the non-removed points out of the newest tree:
+		const auto popNewestTree = [&](std::vector<size_t>& idxs) {
+			const auto& treeIdxs = d.forest.back()->idxs;
+			std::vector<size_t> live;
+			live.reserve(treeIdxs.size() + idxs.size());
+			for (const size_t idx : treeIdxs)
+			{
+				if (isRemoved(idx)) d.m_num_removed--;
+				else
+					live.push_back(idx);
+			}
+			live.insert(live.end(), idxs.begin(), idxs.end());
+			idxs = std::move(live);
+			d.forest.pop_back();
+		};
+
+		std::vector<size_t> newIdxs;
+		// Compact all trees into one if there are too many removed points:
+		if (d.m_num_removed > d.m_num_points)
+			while (!d.forest.empty())
+				popNewestTree(newIdxs);
+
+		// Points appended since the last update:
+		for (size_t idx = d.m_num_indexed; idx < N; idx++)
+			if (!isRemoved(idx)) newIdxs.push_back(idx);
+		d.m_num_indexed = N;
+
+		// Logarithmic merge: a new tree absorbs all the newer trees which
+		// are not larger than it:
+		while (!d.forest.empty() &&
+			   d.forest.back()->idxs.size() <= newIdxs.size())
+			popNewestTree(newIdxs);
+
+		if (!newIdxs.empty())
+			d.forest.emplace_back(std::make_unique<typename holder_t::TSubTree>(
+				derived(), std::move(newIdxs),
+				kdtree_search_params.leaf_max_size));
+
+		d.m_num_points = 0;
+		for (const auto& tree : d.forest)
+			d.m_num_points += tree->idxs.size();
+		d.m_num_points -= d.m_num_removed;
+
+		d.is_uptodate = true;
 	}
 
 };	// end of KDTreeCapable
@@ -11,9 +11,202 @@
 #include <mrpt/math/KDTreeCapable.h>
 #include <mrpt/random.h>
 
+#include <algorithm>
+#include <array>
+
 using namespace mrpt;
 using namespace mrpt::math;
 using namespace mrpt::random;
 using namespace std;
 
-TEST(KDTreeCapable, test1) { MRPT_TODO("Write me!"); }
+namespace
+{
+// A minimal point cloud with stable point indices:
+struct TestCloud : public KDTreeCapable<TestCloud>
+{
+	std::vector<std::array<float, 3>> pts;
+	std::vector<bool> removed;
+
+	explicit TestCloud(bool dynamic)
+	{
+		kdtree_search_params.dynamic_index = dynamic;
+	}
+
+	void append(float x, float y, float z)
+	{
+		pts.push_back({x, y, z});
+		removed.push_back(false);
+		kdtree_mark_as_appended();
+	}
+	void remove(size_t idx)
+	{
+		removed.at(idx) = true;
+		kdtree_mark_as_removed(idx);
+	}
+
+	// Brute-force search of the squared distances to the "k" closest points
+	std::vector<float> closestSqrDists(
+		const std::array<float, 3>& q, size_t k, int dims) const
+	{
+		std::vector<float> d;
+		for (size_t i = 0; i < pts.size(); i++)
+		{
+			if (removed[i]) continue;
+			float d2 = 0;
+			for (int j = 0; j < dims; j++)
+				d2 += (pts[i][j] - q[j]) * (pts[i][j] - q[j]);
+			d.push_back(d2);
+		}
+		std::sort(d.begin(), d.end());
+		if (d.size() > k) d.resize(k);
+		return d;
+	}
+
+	// KDTreeCapable interface:
+	inline size_t kdtree_get_point_count() const { return pts.size(); }
+	inline float kdtree_get_pt(size_t idx, int dim) const
+	{
+		return pts[idx][dim];
+	}
+	template <class BBOX>
+	bool kdtree_get_bbox(BBOX&) const
+	{
+		return false;
+	}
+};
+
+std::array<float, 3> randomPoint()
+{
+	auto& rnd = getRandomGenerator();
+	return {
+		rnd.drawUniform<float>(-10.0f, 10.0f),
+		rnd.drawUniform<float>(-10.0f, 10.0f),
+		rnd.drawUniform<float>(-1.0f, 1.0f)};
+}
+
+void checkQueries(const TestCloud& cloud)
+{
+	const size_t K = 5;
+	for (int i = 0; i < 20; i++)
+	{
+		const auto q = randomPoint();
+
+		float x, y, z, d2;
+		const size_t idx3 =
+			cloud.kdTreeClosestPoint3D(q[0], q[1], q[2], x, y, z, d2);
+		EXPECT_FALSE(cloud.removed[idx3]);
+		EXPECT_FLOAT_EQ(d2, cloud.closestSqrDists(q, 1, 3).at(0));
+
+		const size_t idx2 = cloud.kdTreeClosestPoint2D(q[0], q[1], x, y, d2);
+		EXPECT_FALSE(cloud.removed[idx2]);
+		EXPECT_FLOAT_EQ(d2, cloud.closestSqrDists(q, 1, 2).at(0));
+
+		std::vector<size_t> idxs;
+		std::vector<float> dists;
+		cloud.kdTreeNClosestPoint3DIdx(q[0], q[1], q[2], K, idxs, dists);
+		const auto gtDists = cloud.closestSqrDists(q, K, 3);
+		for (size_t k = 0; k < gtDists.size(); k++)
+		{
+			EXPECT_FALSE(cloud.removed[idxs[k]]);
+			EXPECT_FLOAT_EQ(dists[k], gtDists[k]);
+		}
+
+		std::vector<std::pair<size_t, float>> inRange;
+		const float radiusSqr = 4.0f;
+		cloud.kdTreeRadiusSearch3D(q[0], q[1], q[2], radiusSqr, inRange);
+		const auto allDists = cloud.closestSqrDists(q, cloud.pts.size(), 3);
+		const auto nInRange = std::count_if(
+			allDists.begin(), allDists.end(),
+			[&](float d) { return d < radiusSqr; });
+		EXPECT_EQ(inRange.size(), static_cast<size_t>(nInRange));
+		for (size_t k = 1; k < inRange.size(); k++)
+			EXPECT_LE(inRange[k - 1].second, inRange[k].second);
+	}
+}
+}  // namespace
+
+TEST(KDTreeCapable, dynamicIndexAppendPoints)
+{
+	getRandomGenerator().randomize(1234);
+
+	TestCloud staticCloud(false), dynamicCloud(true);
+	while (dynamicCloud.pts.size() < 1000)
+	{
+		const size_t batch = getRandomGenerator().drawUniform32bit() % 50 + 1;
+		for (size_t i = 0; i < batch; i++)
+		{
+			const auto p = randomPoint();
+			staticCloud.append(p[0], p[1], p[2]);
+			dynamicCloud.append(p[0], p[1], p[2]);
+		}
+		checkQueries(staticCloud);
+		checkQueries(dynamicCloud);
+
+		// Both modes must return exactly the same closest points:
+		const auto q = randomPoint();
+		float x, y, z, d2s, d2d;
+		EXPECT_EQ(
+			staticCloud.kdTreeClosestPoint3D(q[0], q[1], q[2], x, y, z, d2s),
+			dynamicCloud.kdTreeClosestPoint3D(q[0], q[1], q[2], x, y, z, d2d));
+		EXPECT_EQ(d2s, d2d);
+	}
+}
+
+TEST(KDTreeCapable, dynamicIndexRemovePoints)
+{
+	getRandomGenerator().randomize(4321);
+
+	TestCloud cloud(true);
+	for (int i = 0; i < 500; i++)
+	{
+		const auto p = randomPoint();
+		cloud.append(p[0], p[1], p[2]);
+	}
+	checkQueries(cloud);
+
+	// Remove most points, interleaved with appends and queries, so the
+	// forest gets compacted a few times:
+	for (int i = 0; i < 400; i++)
+	{
+		size_t idx;
+		do
+		{
+			idx = getRandomGenerator().drawUniform32bit() % cloud.pts.size();
+		} while (cloud.removed[idx]);
+		cloud.remove(idx);
+
+		if (i % 4 == 0)
+		{
+			const auto p = randomPoint();
+			cloud.append(p[0], p[1], p[2]);
+		}
+		if (i % 25 == 0) checkQueries(cloud);
+	}
+	checkQueries(cloud);
+
+	// Removing a point twice has no effect:
+	size_t idx = 0;
+	while (!cloud.removed[idx])
+		idx++;
+	cloud.remove(idx);
+	checkQueries(cloud);
+}
+
+TEST(KDTreeCapable, copyKeepsRemovedPoints)
+{
+	getRandomGenerator().randomize(1111);
+
+	TestCloud cloud(true);
+	for (int i = 0; i < 100; i++)
+	{
+		const auto p = randomPoint();
+		cloud.append(p[0], p[1], p[2]);
+	}
+	for (size_t i = 0; i < 100; i += 3)
+		cloud.remove(i);
+	checkQueries(cloud);
+
+	const TestCloud cloud2 = cloud;
+	EXPECT_TRUE(cloud2.kdtree_search_params.dynamic_index);
+	checkQueries(cloud2);
+}
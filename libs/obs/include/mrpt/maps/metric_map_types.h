@@ -12,9 +12,31 @@
 #include <mrpt/math/TPoint3D.h>
 #include <mrpt/obs/obs_frwds.h>
 #include <mrpt/serialization/CSerializable.h>
+#include <mrpt/tfest/TMatchingPair.h>
+
+#include <memory>
+#include <vector>
 
 namespace mrpt::maps
 {
+/** Reusable memory buffers for
+ * CMetricMap::determineMatching2D() and CMetricMap::determineMatching3D().
+ * Keep one instance alive between calls with similar inputs (e.g. the
+ * iterations of ICP) to avoid reallocating them on each call. Its contents
+ * are implementation details of each map class.
+ * \sa TMatchingParams::workspace */
+struct TMatchingWorkspace
+{
+	/** The "other" map points, transformed with the query pose */
+	std::vector<float> xs, ys, zs;
+	/** Pairings found for each block of query points */
+	std::vector<mrpt::tfest::TMatchingPairList> blockCorrs;
+	/** Sum of squared errors of each block of query points */
+	std::vector<float> blockSqrDist;
+	/** All pairings, before the optional "onlyUniqueRobust" filter */
+	mrpt::tfest::TMatchingPairList allCorrs;
+};
+
 /** Parameters for the determination of matchings between point clouds, etc. \sa
  * CMetricMap::determineMatching2D, CMetricMap::determineMatching3D */
 struct TMatchingParams
@@ -40,6 +62,15 @@ struct TMatchingParams
 	/** The point used to calculate angular distances: e.g. the coordinates of
 	 * the sensor for a 2D laser scanner. */
 	mrpt::math::TPoint3D angularDistPivotPoint{0, 0, 0};
+	/** Number of threads for the search of correspondences (0: as many as
+	 * hardware threads). Query points are split in fixed-size blocks whose
+	 * results are merged in order, so the output does not depend on this
+	 * value. (Default=1) */
+	size_t numThreads{1};
+	/** Optional buffers to be reused among calls (e.g. ICP iterations). If
+	 * empty, temporary ones are used. A workspace must not be shared by
+	 * concurrent calls. */
+	std::shared_ptr<TMatchingWorkspace> workspace;
 
 	/** Ctor: default values */
 	TMatchingParams() = default;
@@ -52,7 +52,9 @@ WARRANTY OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE.
 #include <mrpt/opengl/PLY_import_export.h>
 #include <mrpt/system/string_utils.h>
 
+#include <algorithm>
 #include <cstdio>
+#include <cstring>
 
 using namespace std;
 using namespace mrpt;
@@ -1814,6 +1816,100 @@ const PlyProperty face_props[] =
 	 {"vertex_indices", PLY_INT, PLY_INT, offsetof(TFace, verts), 1, PLY_UCHAR,
 	  PLY_UCHAR, offsetof(TFace, nverts)}};
 
+/* Number of vertices read or written at once in binary files */
+const size_t VERTEX_BLOCK = 4096;
+
+/* Decodes a scalar from its raw bytes in a binary file */
+double decode_binary_item(const char* data, int type, bool do_reverse)
+{
+	char c[8];
+	const int n = ply_type_size[type];
+	if (do_reverse) std::reverse_copy(data, data + n, c);
+	else
+		std::memcpy(c, data, n);
+
+	switch (type)
+	{
+		case PLY_CHAR: return *reinterpret_cast<const char*>(c);
+		case PLY_UCHAR: return *reinterpret_cast<const unsigned char*>(c);
+		case PLY_SHORT: return *reinterpret_cast<const short*>(c);
+		case PLY_USHORT: return *reinterpret_cast<const unsigned short*>(c);
+		case PLY_INT: return *reinterpret_cast<const int*>(c);
+		case PLY_UINT: return *reinterpret_cast<const unsigned int*>(c);
+		case PLY_FLOAT: return *reinterpret_cast<const float*>(c);
+		case PLY_DOUBLE: return *reinterpret_cast<const double*>(c);
+		default:
+			throw std::runtime_error(
+				format("decode_binary_item: bad type = %d", type));
+	}
+}
+
+/* Fast path to read the vertices of binary files, if all their properties
+   are scalars (the usual case for point clouds): vertex records have a fixed
+   size, so they are read in large blocks instead of one fread() per
+   property, and decoded from their known offsets.
+   Returns false, without reading anything, if the file does not qualify. */
+template <class SET_VERTEX>
+bool binary_read_vertices(
+	PlyFile* plyfile, const PlyElement& elem, const SET_VERTEX& setVertex)
+{
+	if (plyfile->file_type == PLY_ASCII) return false;
+
+	// Offsets and types of x,y,z,intensity within each record:
+	const size_t nWanted = sizeof(vert_props) / sizeof(vert_props[0]);
+	int offsets[nWanted], types[nWanted];
+	std::fill(offsets, offsets + nWanted, -1);
+	size_t stride = 0;
+	for (const auto& prop : elem.props)
+	{
+		if (prop.is_list) return false;
+		for (size_t k = 0; k < nWanted; k++)
+			if (prop.name == vert_props[k].name)
+			{
+				offsets[k] = static_cast<int>(stride);
+				types[k] = prop.external_type;
+			}
+		stride += ply_type_size[prop.external_type];
+	}
+	if (offsets[0] < 0 || offsets[1] < 0 || offsets[2] < 0) return false;
+	const bool hasIntensity = offsets[3] >= 0;
+
+#if MRPT_IS_BIG_ENDIAN
+	const bool do_reverse = (plyfile->file_type == PLY_BINARY_LE);
+#else
+	const bool do_reverse = (plyfile->file_type == PLY_BINARY_BE);
+#endif
+
+	std::vector<char> buf(stride * VERTEX_BLOCK);
+	for (size_t j = 0; j < static_cast<size_t>(elem.num);)
+	{
+		const size_t n =
+			std::min(VERTEX_BLOCK, static_cast<size_t>(elem.num) - j);
+		if (fread(buf.data(), stride, n, plyfile->fp) != n)
+			throw std::runtime_error(
+				"binary_read_vertices: unexpected end of file");
+
+		for (size_t i = 0; i < n; i++, j++)
+		{
+			const char* rec = &buf[i * stride];
+			float v[nWanted];
+			for (size_t k = 0; k < (hasIntensity ? 4U : 3U); k++)
+				v[k] = d2f(decode_binary_item(
+					rec + offsets[k], types[k], do_reverse));
+
+			const TPoint3Df xyz(v[0], v[1], v[2]);
+			if (hasIntensity)
+			{
+				const TColorf col(v[3], v[3], v[3]);
+				setVertex(j, xyz, &col);
+			}
+			else
+				setVertex(j, xyz, nullptr);
+		}
+	}
+	return true;
+}
+
 /*
 		Loads from a PLY file.
 */
@@ -1847,12 +1943,23 @@ bool PLY_Importer::loadFromPlyFile(
 			/* if we're on vertex elements, read them in */
 			if ("vertex" == elem_name)
 			{
+				this->PLY_import_set_vertex_count(num_elems);
+
+				/* binary files: read all vertices in blocks, if possible */
+				if (binary_read_vertices(
+						ply, *find_element(ply, elem_name),
+						[this](
+							size_t idx, const TPoint3Df& pt,
+							const TColorf* col) {
+							this->PLY_import_set_vertex(idx, pt, col);
+						}))
+					continue;
+
 				/* set up for getting vertex elements */
 				for (const auto& vert_prop : vert_props)
 					ply_get_property(ply, elem_name, &vert_prop);
 
 				/* grab all the vertex elements */
-				this->PLY_import_set_vertex_count(num_elems);
 				for (int j = 0; j < num_elems; j++)
 				{
 					TVertex pt;
@@ -1954,6 +2061,7 @@ bool PLY_Exporter::saveToPlyFile(
 
 		const size_t nverts = this->PLY_export_get_vertex_count();
 		const size_t nfaces = this->PLY_export_get_face_count();
+		bool with_intensity = false;
 
 		if (nverts)
 		{
@@ -1962,6 +2070,7 @@ bool PLY_Exporter::saveToPlyFile(
 			bool pt_has_color;
 			TColorf pt_color;
 			this->PLY_export_get_vertex(0, pt, pt_has_color, pt_color);
+			with_intensity = pt_has_color;
 
 			ply_element_count(ply, "vertex", nverts);
 			ply_describe_property(ply, "vertex", &vert_props[0]);  // x
@@ -1990,26 +2099,57 @@ bool PLY_Exporter::saveToPlyFile(
 
 		/* set up and write the vertex elements */
 		ply_put_element_setup(ply, "vertex");
-		for (size_t i = 0; i < nverts; i++)
+		if (save_in_binary)
 		{
-			TPoint3Df pt;
-			bool pt_has_color;
-			TColorf pt_color;
-			this->PLY_export_get_vertex(i, pt, pt_has_color, pt_color);
-
-			TVertex ver;
-			ver.x = pt.x;
-			ver.y = pt.y;
-			ver.z = pt.z;
-
-			if (pt_has_color)
-				ver.intensity =
-					(1.0f / 3.0f) * (pt_color.R + pt_color.G + pt_color.B);
-			else
-				ver.intensity = 0.5;
-
-			ply_put_element(ply, (void*)&ver);
+			/* binary files: write blocks of vertex records at once, since they
+			 * are just 3 or 4 floats in the native byte order */
+			const size_t nFields = with_intensity ? 4 : 3;
+			std::vector<float> buf(nFields * std::min(nverts, VERTEX_BLOCK));
+			for (size_t i = 0; i < nverts;)
+			{
+				const size_t n = std::min(VERTEX_BLOCK, nverts - i);
+				float* rec = buf.data();
+				for (size_t k = 0; k < n; k++, i++, rec += nFields)
+				{
+					TPoint3Df pt;
+					bool pt_has_color;
+					TColorf pt_color;
+					this->PLY_export_get_vertex(i, pt, pt_has_color, pt_color);
+					rec[0] = pt.x;
+					rec[1] = pt.y;
+					rec[2] = pt.z;
+					if (!with_intensity) continue;
+					rec[3] = pt_has_color
+						? (1.0f / 3.0f) * (pt_color.R + pt_color.G + pt_color.B)
+						: 0.5f;
+				}
+				if (fwrite(buf.data(), sizeof(float) * nFields, n, ply->fp) !=
+					n)
+					throw std::runtime_error(
+						"saveToPlyFile: error writing to file");
+			}
 		}
+		else
+			for (size_t i = 0; i < nverts; i++)
+			{
+				TPoint3Df pt;
+				bool pt_has_color;
+				TColorf pt_color;
+				this->PLY_export_get_vertex(i, pt, pt_has_color, pt_color);
+
+				TVertex ver;
+				ver.x = pt.x;
+				ver.y = pt.y;
+				ver.z = pt.z;
+
+				if (pt_has_color)
+					ver.intensity =
+						(1.0f / 3.0f) * (pt_color.R + pt_color.G + pt_color.B);
+				else
+					ver.intensity = 0.5;
+
+				ply_put_element(ply, (void*)&ver);
+			}
 
 		/* set up and write the face elements */
 		/*		ply_put_element_setup (ply, "face");
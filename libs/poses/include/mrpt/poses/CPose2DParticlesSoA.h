@@ -0,0 +1,134 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/bayes/CParticleFilterDataSoA.h>
+#include <mrpt/math/CMatrixFixed.h>
+#include <mrpt/math/TPose2D.h>
+#include <mrpt/poses/CPose2D.h>
+
+#include <tuple>
+
+namespace mrpt::poses
+{
+class CPosePDFParticles;
+class CPoseRandomSampler;
+
+/** A set of weighted 2D pose (x,y,phi) particles stored as a structure of
+ * arrays: contiguous `x[]`, `y[]`, `phi[]` and `log_w[]` vectors.
+ *
+ * This is a drop-in alternative to the particle set of CPosePDFParticles for
+ * large particle counts: motion model sampling (drawMotionSamples()), pose
+ * composition, weight normalization, ESS and resampling run as tight loops
+ * over contiguous memory. Use copyFrom() / copyTo() to convert from/to
+ * CPosePDFParticles.
+ *
+ * Being a mrpt::bayes::CParticleFilterCapable, derived classes implementing
+ * the prediction and update stages can be run by
+ * mrpt::bayes::CParticleFilter, e.g. mrpt::slam::CMonteCarloLocalization2DSoA.
+ *
+ * \sa CPosePDFParticles, CPose3DParticlesSoA,
+ * mrpt::bayes::CParticleFilterDataSoA
+ * \ingroup poses_pdf_grp
+ */
+class CPose2DParticlesSoA : public mrpt::bayes::CParticleFilterDataSoA<3>
+{
+   public:
+	/** Constructor
+	 * \param M The number of particles, all of them at the origin.
+	 */
+	CPose2DParticlesSoA(size_t M = 1);
+
+	/** \name Direct access to the particle arrays
+	 * @{ */
+	inline const std::vector<double>& x() const { return m_state[0]; }
+	inline std::vector<double>& x() { return m_state[0]; }
+	inline const std::vector<double>& y() const { return m_state[1]; }
+	inline std::vector<double>& y() { return m_state[1]; }
+	inline const std::vector<double>& phi() const { return m_state[2]; }
+	inline std::vector<double>& phi() { return m_state[2]; }
+	/** @} */
+
+	/** Returns the pose of the i'th particle. */
+	mrpt::math::TPose2D getParticlePose(size_t i) const
+	{
+		return {m_state[0][i], m_state[1][i], m_state[2][i]};
+	}
+	/** Changes the pose of the i'th particle. */
+	void setParticlePose(size_t i, const mrpt::math::TPose2D& p)
+	{
+		m_state[0][i] = p.x;
+		m_state[1][i] = p.y;
+		m_state[2][i] = p.phi;
+	}
+
+	/** Reset the PDF to a single point: All particles will be set exactly to
+	 * the supplied pose.
+	 * \param particlesCount If set to 0 the number of particles remains
+	 * unchanged.
+	 * \sa resetUniform
+	 */
+	void resetDeterministic(
+		const mrpt::math::TPose2D& location, size_t particlesCount = 0);
+
+	/** Reset the PDF to an uniformly distributed one, inside of the defined
+	 * 2D area `[x_min,x_max]x[y_min,y_max]` (in meters) and for
+	 * orientations `[phi_min, phi_max]` (in radians).
+	 * \param particlesCount New particle count, or leave count unchanged if set
+	 * to -1 (default).
+	 * \sa resetDeterministic
+	 */
+	void resetUniform(
+		const double x_min, const double x_max, const double y_min,
+		const double y_max, const double phi_min = -M_PI,
+		const double phi_max = M_PI, const int particlesCount = -1);
+
+	/** Weighted average of all particles in SE(2). */
+	void getMean(CPose2D& mean_pose) const;
+
+	/** Weighted mean and covariance of all particles. */
+	std::tuple<mrpt::math::CMatrixDouble33, CPose2D> getCovarianceAndMean()
+		const;
+
+	/** Returns the pose of the particle with the highest weight. */
+	mrpt::math::TPose2D getMostLikelyParticle() const
+	{
+		return getParticlePose(getMostLikelyParticleIndex());
+	}
+
+	/** Replaces the particles by those in a CPosePDFParticles */
+	void copyFrom(const CPosePDFParticles& o);
+
+	/** Copies all particles into a CPosePDFParticles */
+	void copyTo(CPosePDFParticles& o) const;
+
+	/** Appends (pose-composition) a given pose "Ap" to each particle */
+	void operator+=(const mrpt::math::TPose2D& Ap);
+
+	/** Appends (pose-composition) a different pose increment to each particle,
+	 * given as three arrays with as many elements as particles:
+	 * `p[i] = p[i] (+) (dx[i], dy[i], dphi[i])`.
+	 */
+	void composeWithIncrements(
+		const std::vector<double>& dx, const std::vector<double>& dy,
+		const std::vector<double>& dphi);
+
+	/** Prediction stage of a motion model: draws one pose increment per
+	 * particle from the PDF loaded in \a sampler (all at once, see
+	 * CPoseRandomSampler::drawSamples2D()) and composes it with the particle.
+	 */
+	void drawMotionSamples(const CPoseRandomSampler& sampler);
+
+   private:
+	/** Pose increments, reused by drawMotionSamples() */
+	std::vector<double> m_incr_x, m_incr_y, m_incr_phi;
+
+};	// End of class def.
+
+}  // namespace mrpt::poses
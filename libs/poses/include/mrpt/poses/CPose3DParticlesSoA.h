@@ -0,0 +1,104 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/bayes/CParticleFilterDataSoA.h>
+#include <mrpt/math/TPose3D.h>
+#include <mrpt/poses/CPose3D.h>
+
+namespace mrpt::poses
+{
+class CPose3DPDFParticles;
+class CPoseRandomSampler;
+
+/** A set of weighted 3D pose (x,y,z,yaw,pitch,roll) particles stored as a
+ * structure of arrays: one contiguous vector per coordinate, plus `log_w[]`.
+ *
+ * The 3D counterpart of CPose2DParticlesSoA. Weight normalization, ESS and
+ * resampling are inherited from mrpt::bayes::CParticleFilterDataSoA. Use
+ * copyFrom() / copyTo() to convert from/to CPose3DPDFParticles.
+ *
+ * \sa CPose3DPDFParticles, CPose2DParticlesSoA
+ * \ingroup poses_pdf_grp
+ */
+class CPose3DParticlesSoA : public mrpt::bayes::CParticleFilterDataSoA<6>
+{
+   public:
+	/** Constructor
+	 * \param M The number of particles, all of them at the origin.
+	 */
+	CPose3DParticlesSoA(size_t M = 1);
+
+	/** \name Direct access to the particle arrays
+	 * @{ */
+	inline const std::vector<double>& x() const { return m_state[0]; }
+	inline std::vector<double>& x() { return m_state[0]; }
+	inline const std::vector<double>& y() const { return m_state[1]; }
+	inline std::vector<double>& y() { return m_state[1]; }
+	inline const std::vector<double>& z() const { return m_state[2]; }
+	inline std::vector<double>& z() { return m_state[2]; }
+	inline const std::vector<double>& yaw() const { return m_state[3]; }
+	inline std::vector<double>& yaw() { return m_state[3]; }
+	inline const std::vector<double>& pitch() const { return m_state[4]; }
+	inline std::vector<double>& pitch() { return m_state[4]; }
+	inline const std::vector<double>& roll() const { return m_state[5]; }
+	inline std::vector<double>& roll() { return m_state[5]; }
+	/** @} */
+
+	/** Returns the pose of the i'th particle. */
+	mrpt::math::TPose3D getParticlePose(size_t i) const
+	{
+		return {m_state[0][i], m_state[1][i], m_state[2][i],
+				m_state[3][i], m_state[4][i], m_state[5][i]};
+	}
+	/** Changes the pose of the i'th particle. */
+	void setParticlePose(size_t i, const mrpt::math::TPose3D& p)
+	{
+		m_state[0][i] = p.x;
+		m_state[1][i] = p.y;
+		m_state[2][i] = p.z;
+		m_state[3][i] = p.yaw;
+		m_state[4][i] = p.pitch;
+		m_state[5][i] = p.roll;
+	}
+
+	/** Reset the PDF to a single point: All particles will be set exactly to
+	 * the supplied pose.
+	 * \param particlesCount If set to 0 the number of particles remains
+	 * unchanged.
+	 */
+	void resetDeterministic(
+		const mrpt::math::TPose3D& location, size_t particlesCount = 0);
+
+	/** Weighted average of all particles in SE(3). */
+	void getMean(CPose3D& mean_pose) const;
+
+	/** Returns the pose of the particle with the highest weight. */
+	mrpt::math::TPose3D getMostLikelyParticle() const
+	{
+		return getParticlePose(getMostLikelyParticleIndex());
+	}
+
+	/** Replaces the particles by those in a CPose3DPDFParticles */
+	void copyFrom(const CPose3DPDFParticles& o);
+
+	/** Copies all particles into a CPose3DPDFParticles */
+	void copyTo(CPose3DPDFParticles& o) const;
+
+	/** Appends (pose-composition) a given pose "Ap" to each particle */
+	void operator+=(const mrpt::math::TPose3D& Ap);
+
+	/** Prediction stage of a motion model: draws one pose increment per
+	 * particle from the PDF loaded in \a sampler and composes it with the
+	 * particle. */
+	void drawMotionSamples(const CPoseRandomSampler& sampler);
+
+};	// End of class def.
+
+}  // namespace mrpt::poses
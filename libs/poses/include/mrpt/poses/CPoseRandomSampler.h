@@ -16,6 +16,12 @@
 #include <mrpt/poses/CPosePDF.h>
 
 #include <memory>  // unique_ptr
+#include <vector>
+
+namespace mrpt::random
+{
+class CRandomGenerator;
+}
 
 namespace mrpt::poses
 {
@@ -58,9 +64,9 @@ class CPoseRandomSampler
 	void clear();
 
 	/** Used internally: sample from m_pdf2D */
-	void do_sample_2D(CPose2D& p) const;
+	void do_sample_2D(CPose2D& p, mrpt::random::CRandomGenerator& rng) const;
 	/** Used internally: sample from m_pdf3D */
-	void do_sample_3D(CPose3D& p) const;
+	void do_sample_3D(CPose3D& p, mrpt::random::CRandomGenerator& rng) const;
 
    public:
 	/** Default constructor */
@@ -93,6 +99,30 @@ class CPoseRandomSampler
 	 */
 	CPose3D& drawSample(CPose3D& p) const;
 
+	/** Like drawSample(CPose2D&), but drawing random numbers from \a rng
+	 * instead of mrpt::random::getRandomGenerator(). Can be called from
+	 * several threads at once, each one with its own generator.
+	 */
+	CPose2D& drawSample(
+		CPose2D& p, mrpt::random::CRandomGenerator& rng) const;
+
+	/** Like drawSample(CPose3D&), but drawing random numbers from \a rng
+	 * instead of mrpt::random::getRandomGenerator(). Can be called from
+	 * several threads at once, each one with its own generator.
+	 */
+	CPose3D& drawSample(
+		CPose3D& p, mrpt::random::CRandomGenerator& rng) const;
+
+	/** Generate N samples from the selected PDF at once, as separate arrays
+	 * of \f$ x \f$, \f$ y \f$ and \f$ \phi \f$ values (resized to N).
+	 * For Gaussian 2D PDFs, random numbers are drawn in bulk and transformed
+	 * in a single vectorizable loop; other PDFs are sampled one by one.
+	 * \sa drawSample, setPosePDF
+	 */
+	void drawSamples2D(
+		size_t N, std::vector<double>& out_x, std::vector<double>& out_y,
+		std::vector<double>& out_phi) const;
+
 	/** Return true if samples can be generated, which only requires a previous
 	 * call to setPosePDF */
 	bool isPrepared() const;
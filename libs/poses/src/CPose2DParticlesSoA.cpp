@@ -0,0 +1,195 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "poses-precomp.h"	// Precompiled headers
+//
+#include <mrpt/math/wrap2pi.h>
+#include <mrpt/poses/CPose2DParticlesSoA.h>
+#include <mrpt/poses/CPosePDFParticles.h>
+#include <mrpt/poses/CPoseRandomSampler.h>
+#include <mrpt/random.h>
+
+using namespace mrpt;
+using namespace mrpt::poses;
+using namespace mrpt::math;
+using namespace mrpt::random;
+
+CPose2DParticlesSoA::CPose2DParticlesSoA(size_t M) { resizeParticles(M); }
+
+void CPose2DParticlesSoA::resetDeterministic(
+	const TPose2D& location, size_t particlesCount)
+{
+	if (particlesCount > 0) resizeParticles(particlesCount);
+
+	std::fill(x().begin(), x().end(), location.x);
+	std::fill(y().begin(), y().end(), location.y);
+	std::fill(phi().begin(), phi().end(), location.phi);
+	std::fill(m_log_w.begin(), m_log_w.end(), .0);
+}
+
+void CPose2DParticlesSoA::resetUniform(
+	const double x_min, const double x_max, const double y_min,
+	const double y_max, const double phi_min, const double phi_max,
+	const int particlesCount)
+{
+	MRPT_START
+	if (particlesCount > 0) resizeParticles(particlesCount);
+
+	auto& rng = getRandomGenerator();
+	rng.drawUniformVector(x(), x_min, x_max);
+	rng.drawUniformVector(y(), y_min, y_max);
+	rng.drawUniformVector(phi(), phi_min, phi_max);
+	std::fill(m_log_w.begin(), m_log_w.end(), .0);
+	MRPT_END
+}
+
+void CPose2DParticlesSoA::getMean(CPose2D& mean_pose) const
+{
+	const size_t N = size();
+	if (!N)
+	{
+		mean_pose = CPose2D();
+		return;
+	}
+	const double* xs = x().data();
+	const double* ys = y().data();
+	const double* phis = phi().data();
+	const double* w = m_log_w.data();
+	const double maxW = *std::max_element(w, w + N);
+
+	// Same as SE_average<2>: weighted mean of translations and of the
+	// orientation unit vectors.
+	double sumW = 0, sx = 0, sy = 0, sc = 0, ss = 0;
+	for (size_t i = 0; i < N; i++)
+	{
+		const double lw = std::exp(w[i] - maxW);
+		sumW += lw;
+		sx += lw * xs[i];
+		sy += lw * ys[i];
+		sc += lw * std::cos(phis[i]);
+		ss += lw * std::sin(phis[i]);
+	}
+	mean_pose = CPose2D(sx / sumW, sy / sumW, std::atan2(ss, sc));
+}
+
+std::tuple<CMatrixDouble33, CPose2D> CPose2DParticlesSoA::getCovarianceAndMean()
+	const
+{
+	CMatrixDouble33 cov;
+	CPose2D mean;
+	cov.setZero();
+	getMean(mean);
+
+	const size_t N = size();
+	if (N < 2) return {cov, mean};  // Not enough information
+
+	const double* xs = x().data();
+	const double* ys = y().data();
+	const double* phis = phi().data();
+	const double* w = m_log_w.data();
+	const double maxW = *std::max_element(w, w + N);
+
+	double sumW = 0;
+	double var_x = 0, var_y = 0, var_p = 0, var_xy = 0, var_xp = 0, var_yp = 0;
+	for (size_t i = 0; i < N; i++)
+	{
+		const double lw = std::exp(w[i] - maxW);
+		const double err_x = xs[i] - mean.x();
+		const double err_y = ys[i] - mean.y();
+		const double err_phi = mrpt::math::wrapToPi(phis[i] - mean.phi());
+		sumW += lw;
+		var_x += lw * err_x * err_x;
+		var_y += lw * err_y * err_y;
+		var_p += lw * err_phi * err_phi;
+		var_xy += lw * err_x * err_y;
+		var_xp += lw * err_x * err_phi;
+		var_yp += lw * err_y * err_phi;
+	}
+	const double k = 1.0 / sumW;
+	cov(0, 0) = var_x * k;
+	cov(1, 1) = var_y * k;
+	cov(2, 2) = var_p * k;
+	cov(1, 0) = cov(0, 1) = var_xy * k;
+	cov(2, 0) = cov(0, 2) = var_xp * k;
+	cov(1, 2) = cov(2, 1) = var_yp * k;
+	return {cov, mean};
+}
+
+void CPose2DParticlesSoA::copyFrom(const CPosePDFParticles& o)
+{
+	const size_t N = o.m_particles.size();
+	resizeParticles(N);
+	for (size_t i = 0; i < N; i++)
+	{
+		const auto& p = o.m_particles[i];
+		setParticlePose(i, p.d);
+		m_log_w[i] = p.log_w;
+	}
+}
+
+void CPose2DParticlesSoA::copyTo(CPosePDFParticles& o) const
+{
+	const size_t N = size();
+	o.m_particles.resize(N);
+	for (size_t i = 0; i < N; i++)
+	{
+		auto& p = o.m_particles[i];
+		p.d = getParticlePose(i);
+		p.log_w = m_log_w[i];
+	}
+}
+
+void CPose2DParticlesSoA::operator+=(const TPose2D& Ap)
+{
+	const size_t N = size();
+	double* xs = x().data();
+	double* ys = y().data();
+	double* phis = phi().data();
+	for (size_t i = 0; i < N; i++)
+	{
+		const double c = std::cos(phis[i]), s = std::sin(phis[i]);
+		xs[i] += c * Ap.x - s * Ap.y;
+		ys[i] += s * Ap.x + c * Ap.y;
+		phis[i] = mrpt::math::wrapToPi(phis[i] + Ap.phi);
+	}
+}
+
+void CPose2DParticlesSoA::composeWithIncrements(
+	const std::vector<double>& dx, const std::vector<double>& dy,
+	const std::vector<double>& dphi)
+{
+	const size_t N = size();
+	ASSERT_EQUAL_(dx.size(), N);
+	ASSERT_EQUAL_(dy.size(), N);
+	ASSERT_EQUAL_(dphi.size(), N);
+
+	double* xs = x().data();
+	double* ys = y().data();
+	double* phis = phi().data();
+	const double* dxs = dx.data();
+	const double* dys = dy.data();
+	const double* dphis = dphi.data();
+	for (size_t i = 0; i < N; i++)
+	{
+		const double c = std::cos(phis[i]), s = std::sin(phis[i]);
+		xs[i] += c * dxs[i] - s * dys[i];
+		ys[i] += s * dxs[i] + c * dys[i];
+		phis[i] += dphis[i];
+	}
+	for (size_t i = 0; i < N; i++)
+		phis[i] = mrpt::math::wrapToPi(phis[i]);
+}
+
+void CPose2DParticlesSoA::drawMotionSamples(const CPoseRandomSampler& sampler)
+{
+	MRPT_START
+	sampler.drawSamples2D(size(), m_incr_x, m_incr_y, m_incr_phi);
+	composeWithIncrements(m_incr_x, m_incr_y, m_incr_phi);
+	MRPT_END
+}
@@ -0,0 +1,197 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <CTraitsTest.h>
+#include <gtest/gtest.h>
+#include <mrpt/poses/CPose2DParticlesSoA.h>
+#include <mrpt/poses/CPose3DPDFParticles.h>
+#include <mrpt/poses/CPose3DParticlesSoA.h>
+#include <mrpt/poses/CPosePDFGaussian.h>
+#include <mrpt/poses/CPosePDFParticles.h>
+#include <mrpt/poses/CPoseRandomSampler.h>
+#include <mrpt/random.h>
+
+using namespace mrpt;
+using namespace mrpt::poses;
+using namespace mrpt::math;
+using namespace mrpt::random;
+
+template class mrpt::CTraitsTest<mrpt::poses::CPose2DParticlesSoA>;
+template class mrpt::CTraitsTest<mrpt::poses::CPose3DParticlesSoA>;
+
+namespace
+{
+// Same random particles in both representations:
+void makeRandomParticles(
+	size_t N, CPosePDFParticles& aos, CPose2DParticlesSoA& soa)
+{
+	auto& rng = getRandomGenerator();
+	aos.resetUniform(-2.0, 3.0, 1.0, 4.0, -0.5, 0.5, N);
+	for (auto& p : aos.m_particles)
+		p.log_w = rng.drawUniform(-5.0, 0.0);
+	soa.copyFrom(aos);
+}
+}  // namespace
+
+TEST(CPose2DParticlesSoA, copyFromTo)
+{
+	getRandomGenerator().randomize(123);
+	CPosePDFParticles aos, aos2;
+	CPose2DParticlesSoA soa;
+	makeRandomParticles(100, aos, soa);
+
+	EXPECT_EQ(soa.size(), 100U);
+	soa.copyTo(aos2);
+	ASSERT_EQ(aos2.size(), aos.size());
+	for (size_t i = 0; i < aos.size(); i++)
+	{
+		EXPECT_EQ(aos2.m_particles[i].d, aos.m_particles[i].d);
+		EXPECT_EQ(aos2.m_particles[i].log_w, aos.m_particles[i].log_w);
+		EXPECT_EQ(soa.getParticlePose(i), aos.m_particles[i].d);
+	}
+}
+
+TEST(CPose2DParticlesSoA, weightsMatchAoS)
+{
+	getRandomGenerator().randomize(456);
+	CPosePDFParticles aos;
+	CPose2DParticlesSoA soa;
+	makeRandomParticles(500, aos, soa);
+
+	EXPECT_NEAR(soa.ESS(), aos.ESS(), 1e-9);
+
+	double maxW_aos, maxW_soa;
+	const double r_aos = aos.normalizeWeights(&maxW_aos);
+	const double r_soa = soa.normalizeWeights(&maxW_soa);
+	EXPECT_DOUBLE_EQ(maxW_aos, maxW_soa);
+	EXPECT_NEAR(r_aos, r_soa, 1e-9 * r_aos);
+	for (size_t i = 0; i < aos.size(); i++)
+		EXPECT_DOUBLE_EQ(soa.getW(i), aos.getW(i));
+
+	EXPECT_EQ(soa.getMostLikelyParticle(), aos.getMostLikelyParticle());
+
+	const auto [covA, meanA] = aos.getCovarianceAndMean();
+	const auto [covS, meanS] = soa.getCovarianceAndMean();
+	EXPECT_NEAR((meanA - meanS).norm(), 0, 1e-9);
+	EXPECT_NEAR(meanA.phi(), meanS.phi(), 1e-9);
+	// (Only compare terms whose definition is the same in both classes)
+	for (int r = 0; r < 3; r++)
+		EXPECT_NEAR(covA(r, r), covS(r, r), 1e-9);
+	EXPECT_NEAR(covA(0, 1), covS(0, 1), 1e-9);
+}
+
+TEST(CPose2DParticlesSoA, performSubstitution)
+{
+	getRandomGenerator().randomize(789);
+	CPosePDFParticles aos;
+	CPose2DParticlesSoA soa;
+	makeRandomParticles(50, aos, soa);
+
+	// Change the number of particles, with repeated indices:
+	std::vector<size_t> idxs;
+	for (size_t i = 0; i < 80; i++)
+		idxs.push_back((i * 7) % 50);
+
+	aos.performSubstitution(idxs);
+	soa.performSubstitution(idxs);
+
+	ASSERT_EQ(soa.size(), aos.size());
+	for (size_t i = 0; i < aos.size(); i++)
+	{
+		EXPECT_EQ(soa.getParticlePose(i), aos.m_particles[i].d);
+		EXPECT_EQ(soa.getW(i), aos.m_particles[i].log_w);
+	}
+}
+
+TEST(CPose2DParticlesSoA, drawMotionSamples)
+{
+	getRandomGenerator().randomize(1234);
+
+	CPosePDFGaussian motion;
+	motion.mean = CPose2D(1.0, 0.5, 0.2);
+	motion.cov.setZero();
+	motion.cov(0, 0) = square(0.10);
+	motion.cov(1, 1) = square(0.05);
+	motion.cov(2, 2) = square(0.02);
+	motion.cov(0, 1) = motion.cov(1, 0) = 0.5 * 0.10 * 0.05;
+
+	CPoseRandomSampler sampler;
+	sampler.setPosePDF(motion);
+
+	// All particles start at the same pose, rotated 90 deg:
+	const TPose2D p0(2.0, -1.0, 90.0_deg);
+	CPose2DParticlesSoA soa;
+	soa.resetDeterministic(p0, 50000);
+	soa.drawMotionSamples(sampler);
+
+	const auto [cov, mean] = soa.getCovarianceAndMean();
+	const CPose2D expectedMean = CPose2D(p0) + motion.mean;
+	EXPECT_NEAR(mean.x(), expectedMean.x(), 2e-3);
+	EXPECT_NEAR(mean.y(), expectedMean.y(), 2e-3);
+	EXPECT_NEAR(mean.phi(), expectedMean.phi(), 1e-3);
+
+	// Covariance rotated by 90 deg: x <-> y
+	EXPECT_NEAR(cov(0, 0), motion.cov(1, 1), 1e-3);
+	EXPECT_NEAR(cov(1, 1), motion.cov(0, 0), 1e-3);
+	EXPECT_NEAR(cov(0, 1), -motion.cov(0, 1), 1e-3);
+	EXPECT_NEAR(cov(2, 2), motion.cov(2, 2), 1e-4);
+
+	// The same composition, particle by particle:
+	CPose2DParticlesSoA soa2;
+	soa2.resetDeterministic(p0, 10);
+	std::vector<double> dx(10), dy(10), dphi(10);
+	for (size_t i = 0; i < 10; i++)
+	{
+		dx[i] = 0.1 * i;
+		dy[i] = -0.05 * i;
+		dphi[i] = 0.4 * i;
+	}
+	soa2.composeWithIncrements(dx, dy, dphi);
+	for (size_t i = 0; i < 10; i++)
+	{
+		const TPose2D expected = p0 + TPose2D(dx[i], dy[i], dphi[i]);
+		const TPose2D p = soa2.getParticlePose(i);
+		EXPECT_NEAR(p.x, expected.x, 1e-12);
+		EXPECT_NEAR(p.y, expected.y, 1e-12);
+		EXPECT_NEAR(p.phi, expected.phi, 1e-12);
+	}
+}
+
+TEST(CPose3DParticlesSoA, copyAndResample)
+{
+	getRandomGenerator().randomize(321);
+	CPose3DPDFParticles aos;
+	aos.resetUniform(
+		TPose3D(-1, -1, -1, -0.3, -0.2, -0.1),
+		TPose3D(1, 1, 1, 0.3, 0.2, 0.1), 40);
+	for (auto& p : aos.m_particles)
+		p.log_w = getRandomGenerator().drawUniform(-3.0, 0.0);
+
+	CPose3DParticlesSoA soa;
+	soa.copyFrom(aos);
+	EXPECT_NEAR(soa.ESS(), aos.ESS(), 1e-9);
+
+	CPose3D meanA, meanS;
+	aos.getMean(meanA);
+	soa.getMean(meanS);
+	EXPECT_NEAR((meanA.asVectorVal() - meanS.asVectorVal()).norm(), 0, 1e-9);
+
+	std::vector<size_t> idxs = {3, 3, 0, 39, 12, 12, 12};
+	aos.performSubstitution(idxs);
+	soa.performSubstitution(idxs);
+
+	CPose3DPDFParticles aos2;
+	soa.copyTo(aos2);
+	ASSERT_EQ(aos2.size(), aos.size());
+	for (size_t i = 0; i < aos.size(); i++)
+	{
+		EXPECT_EQ(aos2.m_particles[i].d, aos.m_particles[i].d);
+		EXPECT_EQ(aos2.m_particles[i].log_w, aos.m_particles[i].log_w);
+	}
+}
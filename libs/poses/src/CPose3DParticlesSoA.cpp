@@ -0,0 +1,92 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "poses-precomp.h"	// Precompiled headers
+//
+#include <mrpt/poses/CPose3DPDFParticles.h>
+#include <mrpt/poses/CPose3DParticlesSoA.h>
+#include <mrpt/poses/CPoseRandomSampler.h>
+#include <mrpt/poses/SO_SE_average.h>
+
+using namespace mrpt;
+using namespace mrpt::poses;
+using namespace mrpt::math;
+
+CPose3DParticlesSoA::CPose3DParticlesSoA(size_t M) { resizeParticles(M); }
+
+void CPose3DParticlesSoA::resetDeterministic(
+	const TPose3D& location, size_t particlesCount)
+{
+	if (particlesCount > 0) resizeParticles(particlesCount);
+
+	const size_t N = size();
+	for (size_t i = 0; i < N; i++)
+		setParticlePose(i, location);
+	std::fill(m_log_w.begin(), m_log_w.end(), .0);
+}
+
+void CPose3DParticlesSoA::getMean(CPose3D& mean_pose) const
+{
+	const size_t N = size();
+	if (!N)
+	{
+		mean_pose = CPose3D();
+		return;
+	}
+	const double maxW = m_log_w[getMostLikelyParticleIndex()];
+
+	mrpt::poses::SE_average<3> se_averager;
+	for (size_t i = 0; i < N; i++)
+		se_averager.append(getParticlePose(i), std::exp(m_log_w[i] - maxW));
+	se_averager.get_average(mean_pose);
+}
+
+void CPose3DParticlesSoA::copyFrom(const CPose3DPDFParticles& o)
+{
+	const size_t N = o.m_particles.size();
+	resizeParticles(N);
+	for (size_t i = 0; i < N; i++)
+	{
+		const auto& p = o.m_particles[i];
+		setParticlePose(i, p.d);
+		m_log_w[i] = p.log_w;
+	}
+}
+
+void CPose3DParticlesSoA::copyTo(CPose3DPDFParticles& o) const
+{
+	const size_t N = size();
+	o.m_particles.resize(N);
+	for (size_t i = 0; i < N; i++)
+	{
+		auto& p = o.m_particles[i];
+		p.d = getParticlePose(i);
+		p.log_w = m_log_w[i];
+	}
+}
+
+void CPose3DParticlesSoA::operator+=(const TPose3D& Ap)
+{
+	const size_t N = size();
+	for (size_t i = 0; i < N; i++)
+		setParticlePose(i, getParticlePose(i) + Ap);
+}
+
+void CPose3DParticlesSoA::drawMotionSamples(const CPoseRandomSampler& sampler)
+{
+	MRPT_START
+	const size_t N = size();
+	CPose3D incr;
+	for (size_t i = 0; i < N; i++)
+	{
+		sampler.drawSample(incr);
+		setParticlePose(i, getParticlePose(i) + incr.asTPose());
+	}
+	MRPT_END
+}
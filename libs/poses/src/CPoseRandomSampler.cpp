@@ -9,6 +9,7 @@
 
 #include "poses-precomp.h"	// Precompiled headers
 //
+#include <mrpt/math/wrap2pi.h>
 #include <mrpt/poses/CPose3DPDFGaussian.h>
 #include <mrpt/poses/CPose3DPDFParticles.h>
 #include <mrpt/poses/CPose3DPDFSOG.h>
@@ -182,14 +183,20 @@ void CPoseRandomSampler::setPosePDF(const CPose3DPDF& pdf)
 					drawSample
   ---------------------------------------------------------------*/
 CPose2D& CPoseRandomSampler::drawSample(CPose2D& p) const
+{
+	return drawSample(p, getRandomGenerator());
+}
+
+CPose2D& CPoseRandomSampler::drawSample(
+	CPose2D& p, CRandomGenerator& rng) const
 {
 	MRPT_START
 
-	if (m_pdf2D) { do_sample_2D(p); }
+	if (m_pdf2D) { do_sample_2D(p, rng); }
 	else if (m_pdf3D)
 	{
 		CPose3D q;
-		do_sample_3D(q);
+		do_sample_3D(q, rng);
 		p.x(q.x());
 		p.y(q.y());
 		p.phi(q.yaw());
@@ -205,18 +212,24 @@ CPose2D& CPoseRandomSampler::drawSample(CPose2D& p) const
 					drawSample
   ---------------------------------------------------------------*/
 CPose3D& CPoseRandomSampler::drawSample(CPose3D& p) const
+{
+	return drawSample(p, getRandomGenerator());
+}
+
+CPose3D& CPoseRandomSampler::drawSample(
+	CPose3D& p, CRandomGenerator& rng) const
 {
 	MRPT_START
 
 	if (m_pdf2D)
 	{
 		CPose2D q;
-		do_sample_2D(q);
+		do_sample_2D(q, rng);
 		p.setFromValues(q.x(), q.y(), 0, q.phi(), 0, 0);
 	}
 	else if (m_pdf3D)
 	{
-		do_sample_3D(p);
+		do_sample_3D(p, rng);
 	}
 	else
 		THROW_EXCEPTION("No associated pdf: setPosePDF must be called first.");
@@ -225,10 +238,68 @@ CPose3D& CPoseRandomSampler::drawSample(CPose3D& p) const
 	MRPT_END
 }
 
+/*---------------------------------------------------------------
+					drawSamples2D
+  ---------------------------------------------------------------*/
+void CPoseRandomSampler::drawSamples2D(
+	size_t N, std::vector<double>& out_x, std::vector<double>& out_y,
+	std::vector<double>& out_phi) const
+{
+	MRPT_START
+
+	out_x.resize(N);
+	out_y.resize(N);
+	out_phi.resize(N);
+
+	if (m_pdf2D && IS_CLASS(*m_pdf2D, CPosePDFGaussian))
+	{
+		// Draw all the normalized random numbers first...
+		auto& rng = getRandomGenerator();
+		rng.drawGaussian1DVector(out_x);
+		rng.drawGaussian1DVector(out_y);
+		rng.drawGaussian1DVector(out_phi);
+
+		// ...then transform them in place with: mean + Z * rnd
+		const auto& Z = m_fastdraw_gauss_Z3;
+		const double Z00 = Z(0, 0), Z01 = Z(0, 1), Z02 = Z(0, 2);
+		const double Z10 = Z(1, 0), Z11 = Z(1, 1), Z12 = Z(1, 2);
+		const double Z20 = Z(2, 0), Z21 = Z(2, 1), Z22 = Z(2, 2);
+		const double mx = m_fastdraw_gauss_M_2D.x();
+		const double my = m_fastdraw_gauss_M_2D.y();
+		const double mphi = m_fastdraw_gauss_M_2D.phi();
+		double* xs = out_x.data();
+		double* ys = out_y.data();
+		double* phis = out_phi.data();
+		for (size_t i = 0; i < N; i++)
+		{
+			const double r0 = xs[i], r1 = ys[i], r2 = phis[i];
+			xs[i] = mx + Z00 * r0 + Z01 * r1 + Z02 * r2;
+			ys[i] = my + Z10 * r0 + Z11 * r1 + Z12 * r2;
+			phis[i] = mphi + Z20 * r0 + Z21 * r1 + Z22 * r2;
+		}
+		for (size_t i = 0; i < N; i++)
+			phis[i] = mrpt::math::wrapToPi(phis[i]);
+	}
+	else
+	{
+		CPose2D p;
+		for (size_t i = 0; i < N; i++)
+		{
+			drawSample(p);
+			out_x[i] = p.x();
+			out_y[i] = p.y();
+			out_phi[i] = p.phi();
+		}
+	}
+
+	MRPT_END
+}
+
 /*---------------------------------------------------------------
 				  do_sample_2D: Sample from a 2D PDF
   ---------------------------------------------------------------*/
-void CPoseRandomSampler::do_sample_2D(CPose2D& p) const
+void CPoseRandomSampler::do_sample_2D(
+	CPose2D& p, CRandomGenerator& rng) const
 {
 	MRPT_START
 	ASSERT_(m_pdf2D);
@@ -243,7 +314,7 @@ void CPoseRandomSampler::do_sample_2D(CPose2D& p) const
 		rndVector.setZero();
 		for (size_t i = 0; i < 3; i++)
 		{
-			double rnd = getRandomGenerator().drawGaussian1D_normalized();
+			double rnd = rng.drawGaussian1D_normalized();
 			for (size_t d = 0; d < 3; d++)
 				rndVector[d] += (m_fastdraw_gauss_Z3(d, i) * rnd);
 		}
@@ -265,8 +336,21 @@ void CPoseRandomSampler::do_sample_2D(CPose2D& p) const
 		// -------------------------------------
 		//      Particles: just sample as usual
 		// -------------------------------------
+		// (Same as CPosePDFParticles::drawSingleSample(), with our "rng")
 		const auto& pdf = dynamic_cast<const CPosePDFParticles&>(*m_pdf2D);
-		pdf.drawSingleSample(p);
+		ASSERT_(!pdf.m_particles.empty());
+		const double uni = rng.drawUniform(0.0, 0.9999);
+		double cum = 0;
+		p = CPose2D(pdf.m_particles.rbegin()->d);
+		for (const auto& part : pdf.m_particles)
+		{
+			cum += exp(part.log_w);
+			if (uni <= cum)
+			{
+				p = CPose2D(part.d);
+				break;
+			}
+		}
 	}
 	else
 		THROW_EXCEPTION_FMT(
@@ -278,7 +362,8 @@ void CPoseRandomSampler::do_sample_2D(CPose2D& p) const
 /*---------------------------------------------------------------
 				  do_sample_3D: Sample from a 3D PDF
   ---------------------------------------------------------------*/
-void CPoseRandomSampler::do_sample_3D(CPose3D& p) const
+void CPoseRandomSampler::do_sample_3D(
+	CPose3D& p, CRandomGenerator& rng) const
 {
 	MRPT_START
 	ASSERT_(m_pdf3D);
@@ -293,7 +378,7 @@ void CPoseRandomSampler::do_sample_3D(CPose3D& p) const
 		rndVector.setZero();
 		for (size_t i = 0; i < 6; i++)
 		{
-			double rnd = getRandomGenerator().drawGaussian1D_normalized();
+			double rnd = rng.drawGaussian1D_normalized();
 			for (size_t d = 0; d < 6; d++)
 				rndVector[d] += (m_fastdraw_gauss_Z6(d, i) * rnd);
 		}
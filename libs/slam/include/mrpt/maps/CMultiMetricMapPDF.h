@@ -12,12 +12,17 @@
 #include <mrpt/config/CLoadableOptions.h>
 #include <mrpt/maps/CMultiMetricMap.h>
 #include <mrpt/maps/CSimpleMap.h>
+#include <mrpt/math/TPose3D.h>
 #include <mrpt/poses/CPose3DPDFParticles.h>
 #include <mrpt/poses/CPosePDFParticles.h>
 #include <mrpt/poses/CPoseRandomSampler.h>
 #include <mrpt/slam/CICP.h>
 #include <mrpt/slam/PF_implementations_data.h>
 
+#include <deque>
+#include <memory>
+#include <vector>
+
 namespace mrpt
 {
 namespace slam
@@ -26,6 +31,105 @@ class CMetricMapBuilderRBPF;
 }
 namespace maps
 {
+/** The path of one particle in mrpt::maps::CMultiMetricMapPDF, stored as a
+ * leaf of an ancestry tree (as in DP-SLAM): each pose is a node with a
+ * reference-counted pointer to the previous one, so the paths of particles
+ * which descend from the same ancestor share all their common poses.
+ * Copying a path (e.g. when particles are duplicated in resampling) is O(1),
+ * and nodes are freed as soon as no particle descends from them.
+ *
+ * Appending and accessing the last pose are O(1); accessing the i'th pose is
+ * O(size()-i). Use getPath() to reconstruct the whole path at once.
+ * \ingroup mrpt_slam_grp
+ */
+class CRBPFParticlePath
+{
+   public:
+	CRBPFParticlePath() = default;
+
+	/** Number of poses in the path */
+	size_t size() const { return m_leaf ? m_leaf->index + 1 : 0; }
+	bool empty() const { return !m_leaf; }
+	void clear() { m_leaf.reset(); }
+
+	/** The last pose. \exception std::exception If the path is empty. */
+	const mrpt::math::TPose3D& back() const
+	{
+		ASSERT_(m_leaf);
+		return m_leaf->pose;
+	}
+	/** Appends a new pose, without modifying the paths sharing this one. */
+	void push_back(const mrpt::math::TPose3D& p);
+
+	/** The i'th pose, from 0 (the first one) to size()-1. O(size()-i).
+	 * \exception std::exception On index out of bounds. */
+	const mrpt::math::TPose3D& operator[](size_t i) const;
+
+	/** Reconstructs the whole path. O(size()) */
+	void getPath(std::deque<mrpt::math::TPose3D>& out_path) const;
+	/** \overload */
+	void getPath(std::vector<mrpt::math::TPose3D>& out_path) const;
+
+	/** Calls f(i, pose) for each pose in the path, from the last one
+	 * (i=size()-1) backwards to the first one. */
+	template <class FUNCTOR>
+	void visitPosesBackwards(FUNCTOR&& f) const
+	{
+		for (const TNode* n = m_leaf.get(); n; n = n->parent.get())
+			f(n->index, n->pose);
+	}
+
+	/** Returns true if the last pose of both paths is the same node of the
+	 * ancestry tree (i.e. the paths are identical). */
+	bool sharesLastPoseWith(const CRBPFParticlePath& o) const
+	{
+		return m_leaf && m_leaf == o.m_leaf;
+	}
+
+   private:
+	struct TNode
+	{
+		TNode(
+			const mrpt::math::TPose3D& p, std::shared_ptr<TNode> parentNode)
+			: pose(p),
+			  index(parentNode ? parentNode->index + 1 : 0),
+			  parent(std::move(parentNode))
+		{
+		}
+		~TNode();
+
+		mrpt::math::TPose3D pose;
+		/** Index of this pose in the path */
+		size_t index;
+		std::shared_ptr<TNode> parent;
+	};
+	std::shared_ptr<TNode> m_leaf;
+
+   public:
+	/** Walks a path backwards, one pose at a time, from the last one to the
+	 * first one. Useful to walk the paths of several particles in lockstep.
+	 * The path must outlive the cursor and not change meanwhile. */
+	class BackwardCursor
+	{
+	   public:
+		explicit BackwardCursor(const CRBPFParticlePath& path)
+			: m_node(path.m_leaf.get())
+		{
+		}
+		/** False once past the first pose (or if the path is empty) */
+		bool valid() const { return m_node != nullptr; }
+		/** Index of the current pose in the path. Requires valid(). */
+		size_t index() const { return m_node->index; }
+		/** The current pose. Requires valid(). */
+		const mrpt::math::TPose3D& pose() const { return m_node->pose; }
+		/** Moves to the previous pose. Requires valid(). */
+		void prev() { m_node = m_node->parent.get(); }
+
+	   private:
+		const TNode* m_node;
+	};
+};
+
 /** Auxiliary class used in mrpt::maps::CMultiMetricMapPDF
  * \ingroup mrpt_slam_grp
  */
@@ -40,7 +144,9 @@ class CRBPFParticleData : public mrpt::serialization::CSerializable
 	}
 
 	CMultiMetricMap mapTillNow;
-	std::deque<mrpt::math::TPose3D> robotPath;
+	/** The path of this particle, sharing the poses of its ancestors with the
+	 * other particles. */
+	CRBPFParticlePath robotPath;
 };
 
 /** Declares a class that represents a Rao-Blackwellized set of particles for
@@ -173,6 +279,13 @@ class CMultiMetricMapPDF
 		size_t timeStep,
 		mrpt::poses::CPose3DPDFParticles& out_estimation) const;
 
+	/** Like getEstimatedPosePDFAtTime(), for several instants of time at
+	 * once, reconstructing the path of each particle only once.
+	 */
+	void getEstimatedPosePDFsAtTimes(
+		const std::vector<size_t>& timeSteps,
+		std::vector<mrpt::poses::CPose3DPDFParticles>& out_estimations) const;
+
 	/** Returns the current estimate of the robot pose, as a particles PDF.
 	 * \sa getEstimatedPosePDFAtTime
 	 */
@@ -200,6 +313,16 @@ class CMultiMetricMapPDF
 	 */
 	bool insertObservation(mrpt::obs::CSensoryFrame& sf);
 
+	/** \overload Since each particle owns its metric map, the SF is inserted
+	 * into all of them in parallel, as set by
+	 * TParticleFilterOptions::numThreads. The first particle is updated
+	 * alone, so lazily-built caches of the observations (e.g. their points
+	 * clouds) are ready before other threads read them.
+	 */
+	bool insertObservation(
+		mrpt::obs::CSensoryFrame& sf,
+		const bayes::CParticleFilter::TParticleFilterOptions& PF_options);
+
 	/** Return the path (in absolute coordinate poses) for the i'th particle.
 	 * \exception On index out of bounds
 	 */
@@ -208,6 +331,7 @@ class CMultiMetricMapPDF
 	/** Returns the current entropy of paths, computed as the average entropy of
 	 * poses along the path, where entropy of each pose estimation is computed
 	 * as the entropy of the gaussian approximation covariance.
+	 * All paths are walked backwards at once, in O(N) memory for N particles.
 	 */
 	double getCurrentEntropyOfPaths();
 
@@ -19,7 +19,13 @@ namespace mrpt::slam
 enum TICPAlgorithm
 {
 	icpClassic = 0,
-	icpLevenbergMarquardt
+	icpLevenbergMarquardt,
+	/** [ICP-3D only] Point-to-plane ICP: minimizes the distances of points
+	   to the local planes of their pairings in the reference map */
+	icpPointToPlane,
+	/** [ICP-3D only] Generalized ICP (Segal et al., 2009): plane-to-plane
+	   distances, from the local covariances of points in both maps */
+	icpGeneralized
 };
 
 /** ICP covariance estimation methods, used in mrpt::slam::CICP::options
@@ -174,6 +180,41 @@ class CICP : public mrpt::slam::CMetricMapsAlignmentAlgorithm
 		 * queries,
 		 *  the most expensive step in ICP */
 		uint32_t corresponding_points_decimation{5};
+
+		/** Number of threads for the search of correspondences, in point maps
+		 * (0: as many as hardware threads). ICP results do not depend on this
+		 * value (default=1) */
+		uint32_t numThreads{1};
+
+		/** [icpPointToPlane and icpGeneralized only] Number of closest
+		 * points used to estimate the normal and covariance of each point.
+		 * See mrpt::maps::CPointsMap::getLocalGeometry() (default=10) */
+		uint32_t normals_numNeighbors{10};
+		/** [icpGeneralized only] Smallest eigenvalue of the local
+		 * covariances, relative to the other two ones (default=1e-3) */
+		double gicp_epsilon{1e-3};
+
+		/** @name Coarse-to-fine (multi-resolution) ICP
+			@{ */
+		/** Number of resolution levels (default=1: disabled). With N>1
+		 * levels, point maps are first aligned after downsampling them into
+		 * voxels of pyramid_voxelSize*2^(N-2), ..., 2*pyramid_voxelSize,
+		 * pyramid_voxelSize meters, each level starting from the result of
+		 * the previous one, and then at full resolution. In downsampled
+		 * levels, the correspondence thresholds are at least twice
+		 * (thresholdDist) and once (smallestThresholdDist) the voxel size,
+		 * and all their points are used (no corresponding_points_decimation).
+		 *
+		 * Downsampled maps are cached in the maps themselves (see
+		 * mrpt::maps::CPointsMap::getVoxelDecimated()), so the levels of the
+		 * reference map are reused by the next calls while it does not
+		 * change, and extended incrementally if points are appended to it.
+		 */
+		uint32_t pyramid_levels{1};
+		/** Voxel size (meters) of the finest downsampled level (default=0.2)
+		 */
+		double pyramid_voxelSize{0.2};
+		/** @} */
 	};
 
 	/** The options employed by the ICP align. */
@@ -192,7 +233,8 @@ class CICP : public mrpt::slam::CMetricMapsAlignmentAlgorithm
 		TReturnInfo() = default;
 		virtual ~TReturnInfo() override = default;
 
-		/** The number of executed iterations until convergence */
+		/** The number of executed iterations until convergence (in all the
+		 * levels, for coarse-to-fine ICP) */
 		unsigned int nIterations = 0;
 
 		/** A goodness measure for the alignment, it is a [0,1] range indicator
@@ -221,7 +263,21 @@ class CICP : public mrpt::slam::CMetricMapsAlignmentAlgorithm
 		mrpt::optional_ref<TMetricMapAlignmentResult> outInfo =
 			std::nullopt) override;
 
-	// See base class for docs
+	/** See base class for docs.
+	 * The reference map \a m1 can be any map implementing
+	 * mrpt::maps::CMetricMap::determineMatching3D(), e.g. a
+	 * mrpt::maps::CPointsMap or a mrpt::maps::CHashedVoxelPointsMap (which
+	 * needs no KD-tree), or a mrpt::maps::CMultiMetricMap with one of them.
+	 * \a m2 must be a mrpt::maps::CPointsMap.
+	 *
+	 * With `options.ICP_algorithm` set to icpPointToPlane or icpGeneralized,
+	 * \a m1 must be a mrpt::maps::CPointsMap too, and each iteration is a
+	 * Gauss-Newton step on the point-to-plane or plane-to-plane errors,
+	 * which usually converges in much fewer iterations than icpClassic on
+	 * structured scenes. Normals and covariances are cached in the maps
+	 * (see mrpt::maps::CPointsMap::getLocalGeometry()), so aligning new
+	 * scans against the same reference map only estimates them once.
+	 */
 	mrpt::poses::CPose3DPDF::Ptr Align3DPDF(
 		const mrpt::maps::CMetricMap* m1, const mrpt::maps::CMetricMap* m2,
 		const mrpt::poses::CPose3DPDFGaussian& initialEstimationPDF,
@@ -243,6 +299,8 @@ class CICP : public mrpt::slam::CMetricMapsAlignmentAlgorithm
 		const mrpt::maps::CMetricMap* m1, const mrpt::maps::CMetricMap* m2,
 		const mrpt::poses::CPosePDFGaussian& initialEstimationPDF,
 		TReturnInfo& outInfo);
+	/** ICP-3D loop, for all the 3D methods (icpClassic, icpPointToPlane,
+	 * and icpGeneralized) */
 	mrpt::poses::CPose3DPDF::Ptr ICP3D_Method_Classic(
 		const mrpt::maps::CMetricMap* m1, const mrpt::maps::CMetricMap* m2,
 		const mrpt::poses::CPose3DPDFGaussian& initialEstimationPDF,
@@ -253,6 +311,8 @@ MRPT_ENUM_TYPE_BEGIN(mrpt::slam::TICPAlgorithm)
 using namespace mrpt::slam;
 MRPT_FILL_ENUM(icpClassic);
 MRPT_FILL_ENUM(icpLevenbergMarquardt);
+MRPT_FILL_ENUM(icpPointToPlane);
+MRPT_FILL_ENUM(icpGeneralized);
 MRPT_ENUM_TYPE_END()
 
 MRPT_ENUM_TYPE_BEGIN(mrpt::slam::TICPCovarianceMethod)
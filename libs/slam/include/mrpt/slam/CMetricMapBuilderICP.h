@@ -72,6 +72,12 @@ class CMetricMapBuilderICP : public mrpt::slam::CMetricMapBuilder
 		 * position (default: 0.40) */
 		double minICPgoodnessToAccept;
 
+		/** Use the dynamic (incremental) KD-tree index in the point maps, so
+		 * each new keyframe only indexes the new points instead of rebuilding
+		 * the KD-tree of the whole map (default: true).
+		 * \sa mrpt::math::KDTreeCapable */
+		bool dynamicKDTreeIndex{true};
+
 		mrpt::system::VerbosityLevel& verbosity_level;
 
 		/** What maps to create (at least one points map and/or a grid map are
@@ -16,6 +16,7 @@
 #include <mrpt/maps/CMultiMetricMap.h>
 #include <mrpt/maps/CMultiMetricMapPDF.h>
 #include <mrpt/slam/CMetricMapBuilder.h>
+#include <mrpt/system/CTimeLogger.h>
 
 namespace mrpt::slam
 {
@@ -75,6 +76,10 @@ class CMetricMapBuilderRBPF : public mrpt::slam::CMetricMapBuilder
 	/** Traveled distance since last map update */
 	mrpt::poses::CPose3D odoIncrementSinceLastMapUpdate;
 
+	/** Time spent in each stage of processActionObservation() \sa
+	 * enableTimeLog() */
+	mrpt::system::CTimeLogger m_timelogger{false};	// default: disabled
+
    public:
 	/** Options for building a CMetricMapBuilderRBPF object, passed to the
 	 * constructor.
@@ -188,6 +193,21 @@ of type CMetricMapBuilderRBPF  */
 
 	double getCurrentJointEntropy();
 
+	/** Enables/disables the time logger of the stages of
+	 * processActionObservation(): the particle filter step, the insertion of
+	 * observations into the particles' maps, etc. (default:disabled upon
+	 * construction). When enabled, a report will be dumped to std::cout upon
+	 * destruction.
+	 * \sa getTimeLogger
+	 */
+	void enableTimeLog(bool enable = true) { m_timelogger.enable(enable); }
+	/** Gives access to a const-ref to the internal time logger \sa
+	 * enableTimeLog */
+	const mrpt::system::CTimeLogger& getTimeLogger() const
+	{
+		return m_timelogger;
+	}
+
 	/** This structure will hold stats after each execution of
 	 * processActionObservation
 	 */
@@ -0,0 +1,94 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/obs/obs_frwds.h>
+#include <mrpt/poses/CPose2DParticlesSoA.h>
+#include <mrpt/poses/CPoseRandomSampler.h>
+#include <mrpt/slam/PF_aux_structs.h>
+#include <mrpt/slam/TMonteCarloLocalizationParams.h>
+
+namespace mrpt
+{
+namespace maps
+{
+class COccupancyGridMap2D;
+}
+
+namespace slam
+{
+/** 2D Monte-Carlo localization (MCL) over particles stored as a structure of
+ * arrays (mrpt::poses::CPose2DParticlesSoA).
+ *
+ * It implements the same algorithm as CMonteCarloLocalization2D with the
+ * `pfStandardProposal` PF algorithm (with or without KLD adaptive sample
+ * size), but motion sampling, weight normalization and resampling run over
+ * contiguous arrays, which pays off for large particle counts (e.g. 10k+).
+ * Other PF algorithms are not implemented and raise an exception.
+ *
+ * \sa CMonteCarloLocalization2D, mrpt::poses::CPose2DParticlesSoA
+ * \ingroup mrpt_slam_grp
+ */
+class CMonteCarloLocalization2DSoA : public mrpt::poses::CPose2DParticlesSoA
+{
+   public:
+	/** MCL parameters */
+	TMonteCarloLocalizationParams options;
+
+	/** Constructor
+	 * \param M The number of particles.
+	 */
+	CMonteCarloLocalization2DSoA(size_t M = 1);
+
+	/** Reset the PDF to an uniformly distributed one, but only in the
+	 * free-space of a given 2D occupancy-grid-map.
+	 * See CMonteCarloLocalization2D::resetUniformFreeSpace() for the meaning
+	 * of all parameters.
+	 */
+	void resetUniformFreeSpace(
+		mrpt::maps::COccupancyGridMap2D* theMap,
+		const double freeCellsThreshold = 0.7, const int particlesCount = -1,
+		const double x_min = -1e10f, const double x_max = 1e10f,
+		const double y_min = -1e10f, const double y_max = 1e10f,
+		const double phi_min = -M_PI, const double phi_max = M_PI);
+
+	/** Draws new particle poses from the motion model in \a action, then
+	 * updates the particle weights with the likelihood of \a observation in
+	 * options.metricMap (or options.metricMaps).
+	 * \sa options
+	 */
+	void prediction_and_update_pfStandardProposal(
+		const mrpt::obs::CActionCollection* action,
+		const mrpt::obs::CSensoryFrame* observation,
+		const bayes::CParticleFilter::TParticleFilterOptions& PF_options)
+		override;
+
+   protected:
+	/** Draws a new particle set of adaptive size (KLD-sampling) from the
+	 * motion model already loaded in m_movementDrawer. */
+	void predictionKLD(
+		const bayes::CParticleFilter::TParticleFilterOptions& PF_options);
+
+	/** Adds the observation log-likelihood of each particle to its weight. */
+	void updateWeights(
+		const mrpt::obs::CSensoryFrame& observation,
+		const bayes::CParticleFilter::TParticleFilterOptions& PF_options);
+
+	/** Used to draw pose increments from the motion model */
+	mrpt::poses::CPoseRandomSampler m_movementDrawer;
+
+	/** Reused by predictionKLD() */
+	std::vector<double> m_new_x, m_new_y, m_new_phi;
+	mrpt::slam::detail::TKLDBinsHashSet<mrpt::slam::detail::TPoseBin2D>
+		m_kldBins;
+
+};	// End of class def.
+
+}  // namespace slam
+}  // namespace mrpt
@@ -212,6 +212,10 @@ class CRangeBearingKFSLAM
 		/** Only if data_assoc_IC_metric==ML, the log-ML threshold (Default=0.0)
 		 */
 		double data_assoc_IC_ml_threshold{0.0};
+		/** Number of threads to explore the JCBB interpretation tree, if
+		 * data_assoc_method==assocJCBB (0: all hardware threads). Results do
+		 * not depend on it. (Default=1) */
+		unsigned int data_assoc_JCBB_numThreads{1};
 
 		/** Whether to fill m_SFs (default=false) */
 		bool create_simplemap{false};
@@ -400,6 +404,14 @@ class CRangeBearingKFSLAM
 		size_t idx_landmark_to_predict, KFMatrix_OxV& Hx,
 		KFMatrix_OxF& Hy) const override;
 
+	/** Like OnObservationJacobians(), for all the landmarks at once: the
+	 * sensor pose and its Jacobian wrt the vehicle pose are computed only
+	 * once per iteration. */
+	void OnObservationJacobiansBatch(
+		const std::vector<size_t>& idx_landmarks_to_predict,
+		std::vector<KFMatrix_OxV>& out_Hx,
+		std::vector<KFMatrix_OxF>& out_Hy) const override;
+
 	/** Computes A=A-B, which may need to be re-implemented depending on the
 	 * topology of the individual scalar components (eg, angles).
 	 */
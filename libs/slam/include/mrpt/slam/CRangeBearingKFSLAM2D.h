@@ -16,6 +16,7 @@
 #include <mrpt/maps/CLandmark.h>
 #include <mrpt/maps/CSimpleMap.h>
 #include <mrpt/math/CMatrixDynamic.h>
+#include <mrpt/math/TPoint2D.h>
 #include <mrpt/obs/CActionCollection.h>
 #include <mrpt/obs/CObservationBearingRange.h>
 #include <mrpt/obs/CSensoryFrame.h>
@@ -35,6 +36,15 @@ namespace mrpt::slam
  *	- [2d-slam-demo](app_2d-slam-demo.html)
  *	- [kf-slam](page_app_kf-slam.html)
  *
+ * Setting TOptions::use_compressed_ekf enables the compressed EKF (CEKF) of
+ * Guivant & Nebot (2001): each KF step only updates a local region with the
+ * robot and the nearby landmarks, while its effect on the rest of the map is
+ * accumulated in small auxiliary matrices and applied in one batch when the
+ * robot leaves the region. The per-step cost then does not depend on the map
+ * size, and the result is the same as the full EKF. Landmark indices in the
+ * public API (m_IDs, getLastDataAssociation(), getLandmarkMean()) always
+ * refer to the full map.
+ *
  * \sa CRangeBearingKFSLAM  \ingroup metric_slam_grp
  */
 class CRangeBearingKFSLAM2D
@@ -91,6 +101,14 @@ class CRangeBearingKFSLAM2D
 	void getCurrentRobotPose(
 		mrpt::poses::CPosePDFGaussian& out_robotPose) const;
 
+	/** Returns the mean of the idx'th landmark in the full map.
+	 * \exception std::exception On idx out of range.
+	 */
+	void getLandmarkMean(size_t idx, KFArray_FEAT& feat) const override;
+
+	/** Returns the covariance of the idx'th landmark in the full map. */
+	void getLandmarkCov(size_t idx, KFMatrix_FxF& feat_cov) const override;
+
 	/** Returns a 3D representation of the landmarks in the map and the robot 3D
 	 * position according to the current filter state.
 	 *  \param out_objects
@@ -140,6 +158,19 @@ class CRangeBearingKFSLAM2D
 		/** Only if data_assoc_IC_metric==ML, the log-ML threshold (Default=0.0)
 		 */
 		double data_assoc_IC_ml_threshold{0.0};
+		/** Number of threads to explore the JCBB interpretation tree, if
+		 * data_assoc_method==assocJCBB (0: all hardware threads). Results do
+		 * not depend on it. (Default=1) */
+		unsigned int data_assoc_JCBB_numThreads{1};
+
+		/** Use the compressed EKF (see the class description). Requires
+		 * KF_options.method=kfEKFNaive. (Default=false) */
+		bool use_compressed_ekf{false};
+		/** Only for the compressed EKF: how far (meters) the robot may move
+		 * from the point where the current local region was created before
+		 * the region is closed. Landmarks within this distance plus the
+		 * sensor range are active in the region. (Default=10) */
+		double compressed_ekf_region_radius{10.0};
 	};
 
 	/** The options for the algorithm */
@@ -278,6 +309,14 @@ class CRangeBearingKFSLAM2D
 		size_t idx_landmark_to_predict, KFMatrix_OxV& Hx,
 		KFMatrix_OxF& Hy) const override;
 
+	/** Like OnObservationJacobians(), for all the landmarks at once: the
+	 * sensor pose and the terms which only depend on it are computed only
+	 * once per iteration. */
+	void OnObservationJacobiansBatch(
+		const std::vector<size_t>& idx_landmarks_to_predict,
+		std::vector<KFMatrix_OxV>& out_Hx,
+		std::vector<KFMatrix_OxF>& out_Hy) const override;
+
 	/** Only called if using a numeric approximation of the observation
 	 * Jacobians, this method must return the increments in each dimension of
 	 * the vehicle state vector while estimating the Jacobian.
@@ -361,6 +400,9 @@ class CRangeBearingKFSLAM2D
 	 */
 	void OnNormalizeStateVector() override;
 
+	/** This method is called at the end of each KF iteration. */
+	void OnPostIteration() override;
+
 	/** @}
 	 */
 
@@ -388,5 +430,61 @@ class CRangeBearingKFSLAM2D
 
 	/** Last data association */
 	TDataAssocInfo m_last_data_association;
+
+	/** @name Compressed EKF (CEKF)
+	 * While a local region is active, m_xkk and m_pkk only hold the robot pose
+	 * and the active landmarks (A). The rest of the map (B) is kept as it was
+	 * when the region started (m_cekfGlobalXkk, m_cekfGlobalPkk), and:
+	 *  - P_AB = Phi * P_A0B
+	 *  - P_BB = P_BB0 - P_BA0 * Psi * P_A0B
+	 *  - x_B = x_B0 + P_BA0 * beta
+	 * with A0 being the active state at the beginning of the region.
+		@{ */
+	/** Whether m_xkk/m_pkk currently hold a CEKF local region */
+	bool m_cekfActive{false};
+	/** Where the current local region was created */
+	mrpt::math::TPoint2D m_cekfRegionCenter;
+	/** Landmarks closer than this to m_cekfRegionCenter are active */
+	double m_cekfRegionLandmarksRadius{0};
+	/** Full state mean & covariance at the beginning of the local region */
+	KFVector m_cekfGlobalXkk;
+	KFMatrix m_cekfGlobalPkk;
+	/** Indices in m_cekfGlobalXkk of the A0 and B state entries */
+	std::vector<size_t> m_cekfIdxA0, m_cekfIdxB;
+	/** The full map landmark index of each landmark in m_xkk */
+	std::vector<size_t> m_cekfLocalToGlobal;
+	/** The index in m_xkk of each full map landmark, or -1 if passive */
+	std::vector<int> m_cekfGlobalToLocal;
+	KFMatrix m_cekfPhi, m_cekfPsi;
+	KFVector m_cekfBeta;
+	/** Phi, Psi and beta after the KF update in progress, which are only
+	 * applied once the update is actually done (in OnPostIteration) */
+	KFMatrix m_cekfPhiUpd, m_cekfPsiUpd;
+	KFVector m_cekfBetaUpd;
+	bool m_cekfPendingUpdate{false};
+
+	/** Number of landmarks in the full map */
+	size_t getNumberOfLandmarksInFullMap() const;
+	/** Maps an index in the full map to an index in m_xkk, or -1 */
+	int landmarkIndexFullToLocal(size_t idx) const;
+	/** Maps an index in m_xkk to an index in the full map */
+	size_t landmarkIndexLocalToFull(size_t idx) const;
+	/** Max. distance from the robot at which the current observation may
+	 * sense landmarks, including the robot pose uncertainty */
+	double cekfSensorReach() const;
+	/** Starts a local region around the robot. m_xkk, m_pkk must hold the
+	 * full map. */
+	void cekfStartRegion(double sensorReach);
+	/** Closes the current local region, leaving the full map in m_xkk and
+	 * m_pkk. */
+	void cekfFlush();
+	/** Computes the full map mean and covariance from the CEKF state. */
+	void cekfGetFullState(KFVector& x, KFMatrix& P) const;
+	/** Computes m_cekf*Upd for the KF update about to be done */
+	void cekfPrepareUpdate(
+		const vector_KFArray_OBS& Z, const std::vector<int>& data_association,
+		const vector_KFArray_OBS& all_predictions, const KFMatrix_OxO& R);
+	void cekfCommitUpdate();
+	/** @} */
 };	// end class
 }  // namespace mrpt::slam
@@ -8,15 +8,35 @@
    +------------------------------------------------------------------------+ */
 #pragma once
 
+#include <mrpt/core/exceptions.h>
+
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
 #include <iterator>
+#include <utility>
 #include <vector>
 
 namespace mrpt::slam::detail
 {
-using namespace mrpt;
-using namespace mrpt::math;
-using namespace std;
+/** Mixes the bits of a 64-bit key (finalizer of splitmix64), used to hash
+ * KLD-sampling bins. */
+constexpr uint64_t kld_hash_mix(uint64_t h)
+{
+	h ^= h >> 30;
+	h *= UINT64_C(0xbf58476d1ce4e5b9);
+	h ^= h >> 27;
+	h *= UINT64_C(0x94d049bb133111eb);
+	h ^= h >> 31;
+	return h;
+}
+
+/** Packs two bin indices into one 64-bit key */
+constexpr uint64_t kld_pack2(int a, int b)
+{
+	return (static_cast<uint64_t>(static_cast<uint32_t>(a)) << 32) |
+		static_cast<uint32_t>(b);
+}
 
 /** Auxiliary structure used in KLD-sampling in particle filters \sa
  * CPosePDFParticles, CMultiMetricMapPDF */
@@ -26,6 +46,17 @@ struct TPoseBin2D
 	/** Bin indices */
 	int x{0}, y{0}, phi{0};
 
+	bool operator==(const TPoseBin2D& o) const
+	{
+		return x == o.x && y == o.y && phi == o.phi;
+	}
+
+	/** Hash of the bin, for usage in TKLDBinsHashSet */
+	uint64_t hash() const
+	{
+		return kld_hash_mix(kld_hash_mix(kld_pack2(x, y)) ^ uint32_t(phi));
+	}
+
 	/** less-than ordering of bins for usage in STL containers */
 	struct lt_operator
 	{
@@ -40,11 +71,32 @@ struct TPoseBin2D
 	};
 };
 
-/** Auxiliary structure   */
+/** Auxiliary structure used in KLD-sampling in particle filters, with one
+ * bin per pose of a robot path. \sa CMultiMetricMapPDF */
 struct TPathBin2D
 {
+	/** Bins of the path poses. Once hash() has been called, bins may only be
+	 * appended: use clear() to start a new path. */
 	std::vector<TPoseBin2D> bins;
 
+	bool operator==(const TPathBin2D& o) const { return bins == o.bins; }
+
+	void clear()
+	{
+		bins.clear();
+		m_hash = 0;
+		m_hashedBins = 0;
+	}
+
+	/** Hash of the whole path. It is computed incrementally: only bins
+	 * appended since the last call are hashed. */
+	uint64_t hash() const
+	{
+		for (; m_hashedBins < bins.size(); m_hashedBins++)
+			m_hash = kld_hash_mix(m_hash ^ bins[m_hashedBins].hash());
+		return m_hash;
+	}
+
 	/** less-than ordering of bins for usage in STL containers */
 	struct lt_operator
 	{
@@ -64,6 +116,10 @@ struct TPathBin2D
 			return false;  // If they're exactly equal, s1 is NOT < s2.
 		}
 	};
+
+   private:
+	mutable uint64_t m_hash{0};
+	mutable size_t m_hashedBins{0};
 };
 
 /** Auxiliary structure used in KLD-sampling in particle filters \sa
@@ -74,6 +130,20 @@ struct TPoseBin3D
 	/** Bin indices */
 	int x{0}, y{0}, z{0}, yaw{0}, pitch{0}, roll{0};
 
+	bool operator==(const TPoseBin3D& o) const
+	{
+		return x == o.x && y == o.y && z == o.z && yaw == o.yaw &&
+			pitch == o.pitch && roll == o.roll;
+	}
+
+	/** Hash of the bin, for usage in TKLDBinsHashSet */
+	uint64_t hash() const
+	{
+		uint64_t h = kld_hash_mix(kld_pack2(x, y));
+		h = kld_hash_mix(h ^ kld_pack2(z, yaw));
+		return kld_hash_mix(h ^ kld_pack2(pitch, roll));
+	}
+
 	/** less-than ordering of bins for usage in STL containers */
 	struct lt_operator
 	{
@@ -94,4 +164,104 @@ struct TPoseBin3D
 	};
 };
 
+/** Set of KLD-sampling bins (TPoseBin2D, TPathBin2D, TPoseBin3D), as an
+ * open-addressing hash table with linear probing.
+ *
+ * Bins are stored contiguously in insertion order, so each distinct bin gets
+ * a stable index in [0, size()). clear() keeps all the allocated memory, so
+ * a set reused along filter iterations does not allocate memory once it has
+ * grown to the typical number of bins.
+ */
+template <class BINTYPE>
+class TKLDBinsHashSet
+{
+   public:
+	/** Returned by find() for missing bins */
+	static constexpr size_t INVALID_INDEX = static_cast<size_t>(-1);
+
+	/** Allocates memory for \a n bins */
+	void reserve(size_t n)
+	{
+		m_bins.reserve(n);
+		m_hashes.reserve(n);
+		if (2 * n > m_slots.size()) rehash(2 * n);
+	}
+
+	/** Removes all bins, keeping the allocated memory */
+	void clear()
+	{
+		m_bins.clear();
+		m_hashes.clear();
+		std::fill(m_slots.begin(), m_slots.end(), 0);
+	}
+
+	size_t size() const { return m_bins.size(); }
+	bool empty() const { return m_bins.empty(); }
+
+	/** The i-th inserted bin */
+	const BINTYPE& operator[](size_t i) const { return m_bins[i]; }
+
+	/** Returns the index of \a bin, or INVALID_INDEX if not in the set */
+	size_t find(const BINTYPE& bin) const
+	{
+		if (m_slots.empty()) return INVALID_INDEX;
+		const uint64_t h = bin.hash();
+		for (size_t s = h & m_mask;; s = (s + 1) & m_mask)
+		{
+			const uint32_t slot = m_slots[s];
+			if (!slot) return INVALID_INDEX;
+			if (m_hashes[slot - 1] == h && m_bins[slot - 1] == bin)
+				return slot - 1;
+		}
+	}
+
+	/** Inserts \a bin if it is not in the set yet.
+	 * \return The index of the bin, and whether it was inserted now.
+	 */
+	std::pair<size_t, bool> insert(const BINTYPE& bin)
+	{
+		// Keep the load factor <= 0.5:
+		if (2 * (m_bins.size() + 1) > m_slots.size())
+			rehash(std::max<size_t>(16, 2 * m_slots.size()));
+
+		const uint64_t h = bin.hash();
+		size_t s = h & m_mask;
+		for (; m_slots[s]; s = (s + 1) & m_mask)
+		{
+			const uint32_t slot = m_slots[s];
+			if (m_hashes[slot - 1] == h && m_bins[slot - 1] == bin)
+				return {slot - 1, false};
+		}
+		ASSERT_(m_bins.size() < UINT32_MAX);
+		m_bins.push_back(bin);
+		m_hashes.push_back(h);
+		m_slots[s] = static_cast<uint32_t>(m_bins.size());
+		return {m_bins.size() - 1, true};
+	}
+
+   private:
+	/** Bins, in insertion order, and their hashes */
+	std::vector<BINTYPE> m_bins;
+	std::vector<uint64_t> m_hashes;
+	/** Hash table: 0 for empty slots, or 1 + the index of a bin */
+	std::vector<uint32_t> m_slots;
+	size_t m_mask = 0;
+
+	void rehash(size_t minSlots)
+	{
+		size_t n = 16;
+		while (n < minSlots)
+			n *= 2;
+		m_slots.assign(n, 0);
+		m_mask = n - 1;
+		for (size_t i = 0; i < m_hashes.size(); i++)
+		{
+			size_t s = m_hashes[i] & m_mask;
+			while (m_slots[s])
+				s = (s + 1) & m_mask;
+			m_slots[s] = static_cast<uint32_t>(i + 1);
+		}
+	}
+};
+
 }  // namespace mrpt::slam::detail
@@ -17,6 +17,7 @@
 #include <mrpt/obs/CActionRobotMovement2D.h>
 #include <mrpt/obs/CActionRobotMovement3D.h>
 #include <mrpt/random.h>
+#include <mrpt/slam/PF_aux_structs.h>
 #include <mrpt/slam/PF_implementations_data.h>
 #include <mrpt/slam/TKLDParams.h>
 
@@ -183,7 +184,7 @@ void PF_implementation<PARTICLE_TYPE, MYSELF, STORAGE>::
 		const TKLDParams& KLD_options)
 {
 	MRPT_START
-	using TSetStateSpaceBins = std::set<BINTYPE, typename BINTYPE::lt_operator>;
+	using TSetStateSpaceBins = detail::TKLDBinsHashSet<BINTYPE>;
 
 	auto* me = static_cast<MYSELF*>(this);
 
@@ -237,31 +238,39 @@ void PF_implementation<PARTICLE_TYPE, MYSELF, STORAGE>::
 			// -------------------------------------------------------------
 			// FIXED SAMPLE SIZE
 			// -------------------------------------------------------------
-			mrpt::poses::CPose3D incrPose;
-			for (size_t i = 0; i < M; i++)
-			{
-				// Generate gaussian-distributed 2D-pose increments according to
-				// mean-cov:
-				m_movementDrawer.drawSample(incrPose);
-				bool pose_is_valid;
-				const mrpt::poses::CPose3D finalPose =
-					mrpt::poses::CPose3D(getLastPose(i, pose_is_valid)) +
-					incrPose;
-
-				// Update the particle with the new pose: this part is
-				// caller-dependant and must be implemented there:
-				if constexpr (
-					STORAGE == mrpt::bayes::particle_storage_mode::POINTER)
+			const auto drawParticles = [&](size_t first, size_t last,
+										   mrpt::random::CRandomGenerator& rng) {
+				mrpt::poses::CPose3D incrPose;
+				for (size_t i = first; i < last; i++)
 				{
-					PF_SLAM_implementation_custom_update_particle_with_new_pose(
-						me->m_particles[i].d.get(), finalPose.asTPose());
-				}
-				else
-				{
-					PF_SLAM_implementation_custom_update_particle_with_new_pose(
-						&me->m_particles[i].d, finalPose.asTPose());
+					// Generate gaussian-distributed 2D-pose increments
+					// according to mean-cov:
+					m_movementDrawer.drawSample(incrPose, rng);
+					bool pose_is_valid;
+					const mrpt::poses::CPose3D finalPose =
+						mrpt::poses::CPose3D(getLastPose(i, pose_is_valid)) +
+						incrPose;
+
+					// Update the particle with the new pose: this part is
+					// caller-dependant and must be implemented there:
+					if constexpr (
+						STORAGE == mrpt::bayes::particle_storage_mode::POINTER)
+					{
+						PF_SLAM_implementation_custom_update_particle_with_new_pose(
+							me->m_particles[i].d.get(), finalPose.asTPose());
+					}
+					else
+					{
+						PF_SLAM_implementation_custom_update_particle_with_new_pose(
+							&me->m_particles[i].d, finalPose.asTPose());
+					}
 				}
-			}
+			};
+
+			// Per-block generators, also with a single thread, so samples do
+			// not depend on the number of threads:
+			mrpt::bayes::CParticleFilter::forEachParticleBlock(
+				PF_options, M, drawParticles);
 		}
 		else
 		{
@@ -272,6 +281,7 @@ void PF_implementation<PARTICLE_TYPE, MYSELF, STORAGE>::
 			//  19-Jan-2009 (JLBC): Rewritten within a generic template
 			// -------------------------------------------------------------
 			TSetStateSpaceBins stateSpaceBins;
+			stateSpaceBins.reserve(me->m_particles.size());
 
 			size_t Nx = KLD_options.KLD_minSampleSize;
 			const double delta_1 = 1.0 - KLD_options.KLD_delta;
@@ -321,12 +331,9 @@ void PF_implementation<PARTICLE_TYPE, MYSELF, STORAGE>::
 				KLF_loadBinFromParticle<PARTICLE_TYPE, BINTYPE>(
 					p, KLD_options, part, &newPose_s);
 
-				if (stateSpaceBins.find(p) == stateSpaceBins.end())
+				if (stateSpaceBins.insert(p).second)
 				{
-					// It falls into a new bin:
-					// Add to the stateSpaceBins:
-					stateSpaceBins.insert(p);
-
+					// It falls into a new bin (now in stateSpaceBins):
 					// K = K + 1
 					size_t K = stateSpaceBins.size();
 					if (K > 1)	//&& newParticles.size() >
@@ -361,18 +368,35 @@ void PF_implementation<PARTICLE_TYPE, MYSELF, STORAGE>::
 		//	UPDATE STAGE
 		// ----------------------------------------------------------------------
 		// Compute all the likelihood values & update particles weight:
-		for (size_t i = 0; i < M; i++)
+		const auto updateWeights = [&](size_t first, size_t last) {
+			for (size_t i = first; i < last; i++)
+			{
+				bool pose_is_valid;
+				const mrpt::math::TPose3D partPose =
+					getLastPose(i, pose_is_valid);	// Take the particle data:
+				auto partPose2 = mrpt::poses::CPose3D(partPose);
+				const double obs_log_lik =
+					PF_SLAM_computeObservationLikelihoodForParticle(
+						PF_options, i, *sf, partPose2);
+				ASSERT_(
+					!std::isnan(obs_log_lik) && std::isfinite(obs_log_lik));
+				me->m_particles[i].log_w += obs_log_lik * PF_options.powFactor;
+			}  // for each particle "i"
+		};
+
+		if (PF_options.numThreads == 1 || M < 2) updateWeights(0, M);
+		else
 		{
-			bool pose_is_valid;
-			const mrpt::math::TPose3D partPose =
-				getLastPose(i, pose_is_valid);	// Take the particle data:
-			auto partPose2 = mrpt::poses::CPose3D(partPose);
-			const double obs_log_lik =
-				PF_SLAM_computeObservationLikelihoodForParticle(
-					PF_options, i, *sf, partPose2);
-			ASSERT_(!std::isnan(obs_log_lik) && std::isfinite(obs_log_lik));
-			me->m_particles[i].log_w += obs_log_lik * PF_options.powFactor;
-		}  // for each particle "i"
+			// The first particle goes alone, so lazily-built caches of the
+			// map(s) and the observations are ready for the other threads:
+			updateWeights(0, 1);
+			mrpt::bayes::CParticleFilter::forEachParticleBlock(
+				PF_options, M - 1,
+				[&](size_t first, size_t last,
+					[[maybe_unused]] mrpt::random::CRandomGenerator& rng) {
+					updateWeights(first + 1, last + 1);
+				});
+		}
 
 		// Normalization of weights is done outside of this method
 		// automatically.
@@ -610,7 +634,7 @@ void PF_implementation<PARTICLE_TYPE, MYSELF, STORAGE>::
 		const TKLDParams& KLD_options, const bool USE_OPTIMAL_SAMPLING)
 {
 	MRPT_START
-	using TSetStateSpaceBins = std::set<BINTYPE, typename BINTYPE::lt_operator>;
+	using TSetStateSpaceBins = detail::TKLDBinsHashSet<BINTYPE>;
 
 	auto* me = static_cast<MYSELF*>(this);
 
@@ -777,6 +801,7 @@ void PF_implementation<PARTICLE_TYPE, MYSELF, STORAGE>::
 		//  - Added JLBC (01/DEC/2006)
 		// ------------------------------------------------------------------------------
 		TSetStateSpaceBins stateSpaceBinsLastTimestep;
+		stateSpaceBinsLastTimestep.reserve(M);
 		std::vector<std::vector<uint32_t>> stateSpaceBinsLastTimestepParticles;
 		typename MYSELF::CParticleList::iterator partIt;
 		unsigned int partIndex;
@@ -798,16 +823,13 @@ void PF_implementation<PARTICLE_TYPE, MYSELF, STORAGE>::
 				p, KLD_options, part);
 
 			// Is it a new bin?
-			auto posFound = stateSpaceBinsLastTimestep.find(p);
-			if (posFound == stateSpaceBinsLastTimestep.end())
+			const auto [idx, isNew] = stateSpaceBinsLastTimestep.insert(p);
+			if (isNew)
 			{  // Yes, create a new pair <bin,index_list> in the list:
-				stateSpaceBinsLastTimestep.insert(p);
 				stateSpaceBinsLastTimestepParticles.emplace_back(1, partIndex);
 			}
 			else
 			{  // No, add the particle's index to the existing entry:
-				const size_t idx =
-					std::distance(stateSpaceBinsLastTimestep.begin(), posFound);
 				stateSpaceBinsLastTimestepParticles[idx].push_back(partIndex);
 			}
 		}
@@ -857,6 +879,7 @@ void PF_implementation<PARTICLE_TYPE, MYSELF, STORAGE>::
 		size_t N = 0;
 
 		TSetStateSpaceBins stateSpaceBins;
+		stateSpaceBins.reserve(M);
 
 		do	// "N" is the index of the current "new particle":
 		{
@@ -966,12 +989,10 @@ void PF_implementation<PARTICLE_TYPE, MYSELF, STORAGE>::
 			//  then we may increase the desired particle number:
 			// -----------------------------------------------------------------------------
 
-			// Found?
-			if (stateSpaceBins.find(p) == stateSpaceBins.end())
+			// Found? If not, it's added now:
+			if (stateSpaceBins.insert(p).second)
 			{
-				// It falls into a new bin: add to the stateSpaceBins:
-				stateSpaceBins.insert(p);
-
+				// It falls into a new bin.
 				// K = K + 1
 				int K = stateSpaceBins.size();
 				if (K > 1)
@@ -108,7 +108,7 @@ struct TDataAssociationResults
 	std::vector<uint32_t> indiv_compatibility_counts;
 
 	/** Only for the JCBB method,the number of recursive calls expent in the
-	 * algorithm. */
+	 * algorithm (summed over all threads). */
 	size_t nNodesExploredInJCBB{0};
 };
 
@@ -122,6 +122,10 @@ struct TDataAssociationResults
  *  With both a Mahalanobis-distance or Matching-likelihood metric. For a
  *comparison of both methods, see paper \cite blanco2012amd
  *
+ * With JCBB and a Mahalanobis compatibility test (compatibilityTestMetric),
+ *hypotheses must also pass the chi2 test of their joint Mahalanobis distance,
+ *which prunes the search tree.
+ *
  * \param Z_observations_mean [IN] An MxO matrix with the M observations, each
  *row containing the observation "mean".
  * \param Y_predictions_mean [IN] An NxO matrix with the N predictions, each
@@ -140,6 +144,9 @@ struct TDataAssociationResults
  * \param predictions_IDs [IN, optional] (default:none) An N-vector. If
  *provided, the resulting associations in "results.associations" will not
  *contain prediction indices "i", but "predictions_IDs[i]".
+ * \param JCBB_numThreads [IN, optional] Number of threads to explore the
+ *JCBB tree (default=1, 0=all CPU cores). The result does not depend on it,
+ *only nNodesExploredInJCBB does.
  *
  * \sa data_association_independent_predictions,
  *data_association_independent_2d_points,
@@ -156,7 +163,8 @@ void data_association_full_covariance(
 	const std::vector<prediction_index_t>& predictions_IDs =
 		std::vector<prediction_index_t>(),
 	const TDataAssociationMetric compatibilityTestMetric = metricMaha,
-	const double log_ML_compat_test_threshold = 0.0);
+	const double log_ML_compat_test_threshold = 0.0,
+	const size_t JCBB_numThreads = 1);
 
 /** Computes the data-association between the prediction of a set of landmarks
  *and their observations, all of them with covariance matrices - Generic
@@ -186,6 +194,9 @@ void data_association_full_covariance(
  * \param predictions_IDs [IN, optional] (default:none) An N-vector. If
  *provided, the resulting associations in "results.associations" will not
  *contain prediction indices "i", but "predictions_IDs[i]".
+ * \param JCBB_numThreads [IN, optional] Number of threads to explore the
+ *JCBB tree (default=1, 0=all CPU cores). The result does not depend on it,
+ *only nNodesExploredInJCBB does.
  *
  * \sa data_association_full_covariance,
  *data_association_independent_2d_points,
@@ -202,7 +213,8 @@ void data_association_independent_predictions(
 	const std::vector<prediction_index_t>& predictions_IDs =
 		std::vector<prediction_index_t>(),
 	const TDataAssociationMetric compatibilityTestMetric = metricMaha,
-	const double log_ML_compat_test_threshold = 0.0);
+	const double log_ML_compat_test_threshold = 0.0,
+	const size_t JCBB_numThreads = 1);
 
 /** @} */
 
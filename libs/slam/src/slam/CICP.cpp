@@ -19,6 +19,7 @@
 #include <mrpt/poses/CPosePDF.h>
 #include <mrpt/poses/CPosePDFGaussian.h>
 #include <mrpt/poses/CPosePDFSOG.h>
+#include <mrpt/poses/Lie/SE.h>
 #include <mrpt/serialization/CArchive.h>
 #include <mrpt/slam/CICP.h>
 #include <mrpt/system/CTicTac.h>
@@ -34,6 +35,38 @@ using namespace mrpt::system;
 using namespace mrpt::poses;
 using namespace std;
 
+namespace
+{
+/** Voxel size of the downsampled level "level" (>0) of coarse-to-fine ICP */
+double pyramidVoxelSize(const CICP::TConfigParams& o, unsigned int level)
+{
+	return o.pyramid_voxelSize * std::pow(2.0, static_cast<int>(level) - 1);
+}
+
+/** ICP options for a downsampled level of coarse-to-fine ICP */
+CICP::TConfigParams pyramidLevelOptions(
+	const CICP::TConfigParams& o, double voxelSize)
+{
+	CICP::TConfigParams lo = o;
+	lo.pyramid_levels = 1;
+	lo.thresholdDist = std::max(o.thresholdDist, 2 * voxelSize);
+	lo.smallestThresholdDist = std::max(o.smallestThresholdDist, voxelSize);
+	lo.corresponding_points_decimation = 1;
+	lo.doRANSAC = false;
+	lo.skip_cov_calculation = true;
+	lo.skip_quality_calculation = true;
+	return lo;
+}
+
+/** The downsampled version of a points map, or any other map as is */
+const CMetricMap* pyramidLevelMap(const CMetricMap* m, double voxelSize)
+{
+	if (const auto* pm = dynamic_cast<const CPointsMap*>(m); pm)
+		return &pm->getVoxelDecimated(mrpt::d2f(voxelSize));
+	return m;
+}
+}  // namespace
+
 CPosePDF::Ptr CICP::AlignPDF(
 	const mrpt::maps::CMetricMap* m1, const mrpt::maps::CMetricMap* mm2,
 	const CPosePDFGaussian& initialEstimationPDF,
@@ -47,15 +80,35 @@ CPosePDF::Ptr CICP::AlignPDF(
 
 	if (outInfo) tictac.Tic();
 
+	// Coarse-to-fine ICP: refine the initial estimation with downsampled
+	// maps, from the coarsest level:
+	CPosePDFGaussian initialPDF = initialEstimationPDF;
+	unsigned int pyramidIterations = 0;
+	for (unsigned int level = options.pyramid_levels; level-- > 1;)
+	{
+		const double voxelSize = pyramidVoxelSize(options, level);
+		CICP levelICP(pyramidLevelOptions(options, voxelSize));
+		TReturnInfo levelInfo;
+		const auto levelPDF = levelICP.AlignPDF(
+			pyramidLevelMap(m1, voxelSize), pyramidLevelMap(mm2, voxelSize),
+			initialPDF, levelInfo);
+		initialPDF.mean = levelPDF->getMeanVal();
+		pyramidIterations += levelInfo.nIterations;
+	}
+
 	switch (options.ICP_algorithm)
 	{
 		case icpClassic:
-			resultPDF =
-				ICP_Method_Classic(m1, mm2, initialEstimationPDF, outInfoVal);
+			resultPDF = ICP_Method_Classic(m1, mm2, initialPDF, outInfoVal);
 			break;
 		case icpLevenbergMarquardt:
-			resultPDF =
-				ICP_Method_LM(m1, mm2, initialEstimationPDF, outInfoVal);
+			resultPDF = ICP_Method_LM(m1, mm2, initialPDF, outInfoVal);
+			break;
+		case icpPointToPlane:
+		case icpGeneralized:
+			THROW_EXCEPTION(
+				"icpPointToPlane and icpGeneralized are only implemented for "
+				"ICP-3D");
 			break;
 		default:
 			THROW_EXCEPTION_FMT(
@@ -63,6 +116,7 @@ CPosePDF::Ptr CICP::AlignPDF(
 				static_cast<int>(options.ICP_algorithm));
 	}  // end switch
 
+	outInfoVal.nIterations += pyramidIterations;
 	if (outInfo) outInfoVal.executionTime = tictac.Tac();
 
 	// Copy the output info if requested:
@@ -122,6 +176,11 @@ void CICP::TConfigParams::loadFromConfigFile(
 
 	MRPT_LOAD_CONFIG_VAR(
 		corresponding_points_decimation, int, iniFile, section);
+	MRPT_LOAD_CONFIG_VAR(numThreads, int, iniFile, section);
+	MRPT_LOAD_CONFIG_VAR(normals_numNeighbors, int, iniFile, section);
+	MRPT_LOAD_CONFIG_VAR(gicp_epsilon, double, iniFile, section);
+	MRPT_LOAD_CONFIG_VAR(pyramid_levels, int, iniFile, section);
+	MRPT_LOAD_CONFIG_VAR(pyramid_voxelSize, double, iniFile, section);
 }
 
 void CICP::TConfigParams::saveToConfigFile(
@@ -170,6 +229,20 @@ void CICP::TConfigParams::saveToConfigFile(
 	MRPT_SAVE_CONFIG_VAR_COMMENT(skip_cov_calculation, "");
 	MRPT_SAVE_CONFIG_VAR_COMMENT(skip_quality_calculation, "");
 	MRPT_SAVE_CONFIG_VAR_COMMENT(corresponding_points_decimation, "");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		numThreads,
+		"Threads for the search of correspondences (0: all hardware threads)");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		normals_numNeighbors,
+		"Neighbors to estimate normals and covariances (point-to-plane and "
+		"generalized ICP)");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		gicp_epsilon, "Smallest eigenvalue of covariances in generalized ICP");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		pyramid_levels, "Levels of coarse-to-fine ICP (1: disabled)");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		pyramid_voxelSize,
+		"Voxel size of the finest downsampled level of coarse-to-fine ICP");
 }
 
 float CICP::kernel(float x2, float rho2)
@@ -232,6 +305,9 @@ CPosePDF::Ptr CICP::ICP_Method_Classic(
 	matchParams.onlyUniqueRobust = options.onlyUniqueRobust;
 	matchParams.decimation_other_map_points =
 		options.corresponding_points_decimation;
+	matchParams.numThreads = options.numThreads;
+	// Reuse buffers along all the ICP iterations:
+	matchParams.workspace = std::make_shared<TMatchingWorkspace>();
 
 	// Ensure maps are not empty!
 	// ------------------------------------------------------
@@ -596,6 +672,8 @@ CPosePDF::Ptr CICP::ICP_Method_LM(
 	matchParams.onlyUniqueRobust = onlyUniqueRobust;
 	matchParams.decimation_other_map_points =
 		options.corresponding_points_decimation;
+	matchParams.numThreads = options.numThreads;
+	matchParams.workspace = std::make_shared<TMatchingWorkspace>();
 
 	// The gaussian PDF to estimate:
 	// ------------------------------------------------------
@@ -906,20 +984,38 @@ CPose3DPDF::Ptr CICP::Align3DPDF(
 {
 	MRPT_START
 
-	static CTicTac tictac;
+	CTicTac tictac;
 	TReturnInfo outInfoVal;
 	CPose3DPDF::Ptr resultPDF;
 
 	if (outInfo) tictac.Tic();
 
+	// Coarse-to-fine ICP: refine the initial estimation with downsampled
+	// maps, from the coarsest level:
+	CPose3DPDFGaussian initialPDF = initialEstimationPDF;
+	unsigned int pyramidIterations = 0;
+	for (unsigned int level = options.pyramid_levels; level-- > 1;)
+	{
+		const double voxelSize = pyramidVoxelSize(options, level);
+		CICP levelICP(pyramidLevelOptions(options, voxelSize));
+		TReturnInfo levelInfo;
+		const auto levelPDF = levelICP.Align3DPDF(
+			pyramidLevelMap(m1, voxelSize), pyramidLevelMap(mm2, voxelSize),
+			initialPDF, levelInfo);
+		initialPDF.mean = levelPDF->getMeanVal();
+		pyramidIterations += levelInfo.nIterations;
+	}
+
 	switch (options.ICP_algorithm)
 	{
 		case icpClassic:
-			resultPDF =
-				ICP3D_Method_Classic(m1, mm2, initialEstimationPDF, outInfoVal);
+		case icpPointToPlane:
+		case icpGeneralized:
+			resultPDF = ICP3D_Method_Classic(m1, mm2, initialPDF, outInfoVal);
 			break;
 		case icpLevenbergMarquardt:
-			THROW_EXCEPTION("Only icpClassic is implemented for ICP-3D");
+			THROW_EXCEPTION(
+				"icpLevenbergMarquardt is not implemented for ICP-3D");
 			break;
 		default:
 			THROW_EXCEPTION_FMT(
@@ -927,6 +1023,7 @@ CPose3DPDF::Ptr CICP::Align3DPDF(
 				static_cast<int>(options.ICP_algorithm));
 	}  // end switch
 
+	outInfoVal.nIterations += pyramidIterations;
 	if (outInfo) outInfoVal.executionTime = tictac.Tac();
 
 	// Copy the output info if requested:
@@ -939,6 +1036,84 @@ CPose3DPDF::Ptr CICP::Align3DPDF(
 	MRPT_END
 }
 
+namespace
+{
+/** One Gauss-Newton step of point-to-plane ICP (if geom2 is nullptr) or
+ * generalized ICP, from the pairings found at the current pose, solving the
+ * 6x6 normal equations of the linearized errors wrt an increment in SE(3)
+ * on the left of \a pose.
+ * \return false if the system is singular (e.g. all planes are parallel) */
+bool gaussNewtonStep3D(
+	const TMatchingPairList& corrs, const CPose3D& pose,
+	const CPointsMap::TLocalGeometry& geom1,
+	const CPointsMap::TLocalGeometry* geom2, CPose3D& newPose)
+{
+	using Vector6d = Eigen::Matrix<double, 6, 1>;
+	using Matrix6d = Eigen::Matrix<double, 6, 6>;
+
+	Matrix6d H = Matrix6d::Zero();
+	Vector6d g = Vector6d::Zero();
+	const Eigen::Matrix3d R = pose.getRotationMatrix().asEigen();
+
+	for (const auto& c : corrs)
+	{
+		// Local point in the reference map frame, and its pairing:
+		Eigen::Vector3d p;
+		pose.composePoint(c.local.x, c.local.y, c.local.z, p.x(), p.y(), p.z());
+		const Eigen::Vector3d q(c.global.x, c.global.y, c.global.z);
+
+		if (!geom2)
+		{
+			// Error: n^T (p - q)
+			// Jacobian wrt [dx dy dz, wx wy wz]: [n^T, (p x n)^T]
+			const auto& nf = geom1.normals.at(c.globalIdx);
+			const Eigen::Vector3d n(nf.x, nf.y, nf.z);
+			if (n.isZero()) continue;
+
+			Vector6d J;
+			J.head<3>() = n;
+			J.tail<3>() = p.cross(n);
+			H.noalias() += J * J.transpose();
+			g.noalias() += J * n.dot(p - q);
+		}
+		else
+		{
+			// Error: q - p, with information matrix (C1 + R*C2*R^T)^-1
+			// Jacobian wrt [dx dy dz, wx wy wz]: [-I, skew(p)]
+			const Eigen::Matrix3d C =
+				geom1.covariances.at(c.globalIdx).asEigen().cast<double>() +
+				R *
+					geom2->covariances.at(c.localIdx)
+						.asEigen()
+						.cast<double>() *
+					R.transpose();
+			const Eigen::Matrix3d W = C.inverse();
+
+			Eigen::Matrix<double, 3, 6> J;
+			J.leftCols<3>() = -Eigen::Matrix3d::Identity();
+			J.rightCols<3>() << 0, -p.z(), p.y(), p.z(), 0, -p.x(), -p.y(),
+				p.x(), 0;
+			const Eigen::Matrix<double, 6, 3> JtW = J.transpose() * W;
+			H.noalias() += JtW * J;
+			g.noalias() += JtW * (q - p);
+		}
+	}
+
+	const Eigen::LDLT<Matrix6d> ldlt(H);
+	if (ldlt.info() != Eigen::Success) return false;
+	const Vector6d D = ldlt.vectorD().cwiseAbs();
+	if (D.minCoeff() <= 1e-9 * D.maxCoeff()) return false;
+
+	const Vector6d delta = -ldlt.solve(g);
+	if (!delta.allFinite()) return false;
+
+	newPose = mrpt::poses::Lie::SE<3>::exp(
+				  mrpt::poses::Lie::SE<3>::tangent_vector(delta)) +
+		pose;
+	return true;
+}
+}  // namespace
+
 CPose3DPDF::Ptr CICP::ICP3D_Method_Classic(
 	const mrpt::maps::CMetricMap* m1, const mrpt::maps::CMetricMap* mm2,
 	const CPose3DPDFGaussian& initialEstimationPDF, TReturnInfo& outInfo)
@@ -953,6 +1128,8 @@ CPose3DPDF::Ptr CICP::ICP3D_Method_Classic(
 	bool keepApproaching;
 	CPose3D grossEst = initialEstimationPDF.mean;
 	mrpt::tfest::TMatchingPairList correspondences, old_correspondences;
+	// SoA copy of the correspondences for se3_l2(), reused along iterations:
+	mrpt::tfest::TMatchingPairListSoA correspondencesSoA;
 	CPose3D lastMeanPose;
 
 	// Assure the class of the maps:
@@ -963,6 +1140,25 @@ CPose3DPDF::Ptr CICP::ICP3D_Method_Classic(
 	// -----------------
 	ASSERT_(options.ALFA > 0 && options.ALFA < 1);
 
+	// Local geometry of the maps, for point-to-plane and generalized ICP:
+	const CPointsMap::TLocalGeometry* geom1 = nullptr;
+	const CPointsMap::TLocalGeometry* geom2 = nullptr;
+	if (options.ICP_algorithm != icpClassic && !m2->isEmpty())
+	{
+		const auto* pm1 = dynamic_cast<const CPointsMap*>(m1);
+		ASSERTMSG_(
+			pm1,
+			"icpPointToPlane and icpGeneralized require a CPointsMap as "
+			"reference map");
+		geom1 = &pm1->getLocalGeometry(
+			options.normals_numNeighbors, d2f(options.gicp_epsilon),
+			options.numThreads);
+		if (options.ICP_algorithm == icpGeneralized)
+			geom2 = &m2->getLocalGeometry(
+				options.normals_numNeighbors, d2f(options.gicp_epsilon),
+				options.numThreads);
+	}
+
 	// The algorithm output auxiliar info:
 	// -------------------------------------------------
 	outInfo.nIterations = 0;
@@ -988,6 +1184,8 @@ CPose3DPDF::Ptr CICP::ICP3D_Method_Classic(
 	matchParams.onlyUniqueRobust = options.onlyUniqueRobust;
 	matchParams.decimation_other_map_points =
 		options.corresponding_points_decimation;
+	matchParams.numThreads = options.numThreads;
+	matchParams.workspace = std::make_shared<TMatchingWorkspace>();
 
 	// Ensure maps are not empty!
 	// ------------------------------------------------------
@@ -1020,18 +1218,32 @@ CPose3DPDF::Ptr CICP::ICP3D_Method_Classic(
 			}
 			else
 			{
-				// Compute the estimated pose, using Horn's method.
-				// ----------------------------------------------------------------------
-				mrpt::poses::CPose3DQuat estPoseQuat;
-				double transf_scale;
-				mrpt::tfest::se3_l2(
-					correspondences, estPoseQuat, transf_scale,
-					false /* dont force unit scale */);
-				gaussPdf->mean = mrpt::poses::CPose3D(estPoseQuat);
+				keepApproaching = true;
+				if (options.ICP_algorithm == icpClassic)
+				{
+					// Compute the estimated pose, using Horn's method.
+					// -------------------------------------------------------
+					mrpt::poses::CPose3DQuat estPoseQuat;
+					double transf_scale;
+					correspondencesSoA.assign(correspondences);
+					mrpt::tfest::se3_l2(
+						correspondencesSoA, estPoseQuat, transf_scale,
+						false /* dont force unit scale */);
+					gaussPdf->mean = mrpt::poses::CPose3D(estPoseQuat);
+				}
+				else
+				{
+					// One Gauss-Newton step on point-to-plane or
+					// plane-to-plane errors:
+					CPose3D newPose;
+					if (gaussNewtonStep3D(
+							correspondences, gaussPdf->mean, *geom1, geom2,
+							newPose))
+						gaussPdf->mean = newPose;
+				}
 
 				// If matching has not changed, decrease the thresholds:
 				// --------------------------------------------------------
-				keepApproaching = true;
 				if (!(fabs(lastMeanPose.x() - gaussPdf->mean.x()) >
 						  options.minAbsStep_trans ||
 					  fabs(lastMeanPose.y() - gaussPdf->mean.y()) >
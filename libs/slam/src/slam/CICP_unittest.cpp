@@ -8,6 +8,7 @@
    +------------------------------------------------------------------------+ */
 
 #include <gtest/gtest.h>
+#include <mrpt/maps/CHashedVoxelPointsMap.h>
 #include <mrpt/maps/CSimplePointsMap.h>
 #include <mrpt/obs/stock_observations.h>
 #include <mrpt/opengl/CAngularObservationMesh.h>
@@ -19,6 +20,7 @@
 #include <mrpt/opengl/stock_objects.h>
 #include <mrpt/poses/CPose3DPDF.h>
 #include <mrpt/poses/CPosePDF.h>
+#include <mrpt/random/RandomGenerators.h>
 #include <mrpt/slam/CICP.h>
 
 #include <Eigen/Dense>
@@ -213,3 +215,190 @@ TEST_F(ICPTests, RayTracingICP3D)
 		<< "ICP output: mean= " << mean << endl
 		<< "Real displacement: " << SCAN2_POSE_ERROR << endl;
 }
+
+// A world made of spheres:
+static CSimplePointsMap sphereWorld()
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(1234);
+
+	CSimplePointsMap world;
+	for (int i = 0; i < 12; i++)
+	{
+		const TPoint3D center(
+			rng.drawUniform(-8.0, 8.0), rng.drawUniform(-8.0, 8.0),
+			rng.drawUniform(0.0, 3.0));
+		for (int j = 0; j < 400; j++)
+		{
+			TPoint3D dir(
+				rng.drawGaussian1D_normalized(),
+				rng.drawGaussian1D_normalized(),
+				rng.drawGaussian1D_normalized());
+			dir *= 0.6 / dir.norm();
+			world.insertPoint(center + dir);
+		}
+	}
+	return world;
+}
+
+// ICP-3D with a voxel map as reference must give the same result than with a
+// points map, if no point was decimated:
+TEST_F(ICPTests, ICP3D_HashedVoxelPointsMap)
+{
+	const CSimplePointsMap world = sphereWorld();
+
+	CHashedVoxelPointsMap voxelMap(0.5, 1000);
+	voxelMap.insertionOptions.minDistBetweenPoints = 0;
+	voxelMap.insertAnotherMap(&world, CPose3D());
+	ASSERT_EQ(voxelMap.size(), world.size());
+
+	// The same world, seen from "truePose":
+	const CPose3D truePose(0.5, -0.3, 0.1, 10.0_deg, 2.0_deg, -3.0_deg);
+	CPose3D invPose = truePose;
+	invPose.inverse();
+	CSimplePointsMap local = world;
+	local.changeCoordinatesReference(invPose);
+
+	const CPose3D initialGuess =
+		truePose + CPose3D(0.1, -0.05, 0.05, 2.0_deg, 1.0_deg, -1.0_deg);
+
+	CICP icp;
+	icp.options.thresholdDist = 0.40;
+	icp.options.thresholdAng = 0;
+	icp.options.smallestThresholdDist = 0.05;
+	icp.options.maxIterations = 100;
+
+	const CPose3D refPose =
+		icp.Align3D(&world, &local, initialGuess)->getMeanVal();
+	const CPose3D voxelPose =
+		icp.Align3D(&voxelMap, &local, initialGuess)->getMeanVal();
+
+	EXPECT_NEAR(
+		0,
+		(voxelPose.asVectorVal() - truePose.asVectorVal())
+			.array()
+			.abs()
+			.maxCoeff(),
+		0.01)
+		<< "ICP output: " << voxelPose << endl
+		<< "Real pose: " << truePose << endl;
+	EXPECT_NEAR(
+		0,
+		(voxelPose.asVectorVal() - refPose.asVectorVal())
+			.array()
+			.abs()
+			.maxCoeff(),
+		1e-4)
+		<< "Voxel map ICP: " << voxelPose << endl
+		<< "Points map ICP: " << refPose << endl;
+}
+
+// Point-to-plane and generalized ICP on a planar scene:
+TEST_F(ICPTests, ICP3D_PointToPlaneAndGICP)
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(4321);
+
+	// A corner: floor and two walls
+	CSimplePointsMap world;
+	for (int i = 0; i < 1000; i++)
+	{
+		const double a = rng.drawUniform(0.0, 6.0);
+		const double b = rng.drawUniform(0.0, 6.0);
+		world.insertPoint(a, b, 0);
+		world.insertPoint(0, a, b * 0.5);
+		world.insertPoint(a, 0, b * 0.5);
+	}
+
+	const CPose3D truePose(0.2, -0.1, 0.05, 5.0_deg, 1.0_deg, -2.0_deg);
+	CPose3D invPose = truePose;
+	invPose.inverse();
+	CSimplePointsMap local = world;
+	local.changeCoordinatesReference(invPose);
+
+	const CPose3D initialGuess =
+		truePose + CPose3D(0.1, 0.1, -0.05, 2.0_deg, -1.0_deg, 1.0_deg);
+
+	CICP icp;
+	icp.options.thresholdDist = 0.5;
+	icp.options.thresholdAng = 0;
+	icp.options.smallestThresholdDist = 0.05;
+	icp.options.corresponding_points_decimation = 1;
+	icp.options.maxIterations = 200;
+
+	icp.options.ICP_algorithm = icpClassic;
+	CICP::TReturnInfo classicInfo;
+	icp.Align3D(&world, &local, initialGuess, classicInfo);
+
+	for (const auto method : {icpPointToPlane, icpGeneralized})
+	{
+		icp.options.ICP_algorithm = method;
+		CICP::TReturnInfo info;
+		const CPose3D pose =
+			icp.Align3D(&world, &local, initialGuess, info)->getMeanVal();
+
+		EXPECT_NEAR(
+			0,
+			(pose.asVectorVal() - truePose.asVectorVal())
+				.array()
+				.abs()
+				.maxCoeff(),
+			1e-3)
+			<< "Method: " << mrpt::typemeta::enum2str(method) << endl
+			<< "ICP output: " << pose << endl
+			<< "Real pose: " << truePose << endl;
+		EXPECT_LT(info.nIterations, classicInfo.nIterations)
+			<< "Method: " << mrpt::typemeta::enum2str(method);
+	}
+
+	// Only implemented for ICP-3D:
+	icp.options.ICP_algorithm = icpPointToPlane;
+	EXPECT_ANY_THROW(icp.Align(&world, &local, CPose2D()));
+}
+
+TEST_F(ICPTests, ICP3D_CoarseToFine)
+{
+	const CSimplePointsMap world = sphereWorld();
+
+	const CPose3D truePose(0.5, -0.3, 0.1, 10.0_deg, 2.0_deg, -3.0_deg);
+	CPose3D invPose = truePose;
+	invPose.inverse();
+	CSimplePointsMap local = world;
+	local.changeCoordinatesReference(invPose);
+
+	const CPose3D initialGuess =
+		truePose + CPose3D(0.3, -0.2, 0.1, 5.0_deg, 2.0_deg, -2.0_deg);
+
+	CICP icp;
+	icp.options.thresholdDist = 0.3;
+	icp.options.thresholdAng = 0;
+	icp.options.smallestThresholdDist = 0.05;
+	icp.options.maxIterations = 100;
+	icp.options.pyramid_levels = 3;
+	icp.options.pyramid_voxelSize = 0.2;
+
+	const CPointsMap* finestLevel = nullptr;
+	for (int rep = 0; rep < 2; rep++)
+	{
+		CICP::TReturnInfo info;
+		const CPose3D pose =
+			icp.Align3D(&world, &local, initialGuess, info)->getMeanVal();
+
+		EXPECT_NEAR(
+			0,
+			(pose.asVectorVal() - truePose.asVectorVal())
+				.array()
+				.abs()
+				.maxCoeff(),
+			1e-3)
+			<< "ICP output: " << pose << endl
+			<< "Real pose: " << truePose << endl;
+		EXPECT_GE(info.nIterations, 3U);
+
+		// The downsampled reference maps are kept for the next calls:
+		const CPointsMap* level = &world.getVoxelDecimated(0.2f);
+		if (finestLevel) EXPECT_EQ(level, finestLevel);
+		finestLevel = level;
+		EXPECT_LT(level->size(), world.size());
+	}
+}
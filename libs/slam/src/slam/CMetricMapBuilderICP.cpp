@@ -76,6 +76,7 @@ CMetricMapBuilderICP::TConfigParams&
 	localizationLinDistance = other.localizationLinDistance;
 	localizationAngDistance = other.localizationAngDistance;
 	minICPgoodnessToAccept = other.minICPgoodnessToAccept;
+	dynamicKDTreeIndex = other.dynamicKDTreeIndex;
 	//	We can't copy a reference type
 	//	verbosity_level         = other.verbosity_level;
 	mapInitializers = other.mapInitializers;
@@ -94,6 +95,7 @@ void CMetricMapBuilderICP::TConfigParams::loadFromConfigFile(
 		section, "verbosity_level", verbosity_level);
 
 	MRPT_LOAD_CONFIG_VAR(minICPgoodnessToAccept, double, source, section)
+	MRPT_LOAD_CONFIG_VAR(dynamicKDTreeIndex, bool, source, section)
 
 	mapInitializers.loadFromConfigFile(source, section);
 }
@@ -121,6 +123,9 @@ void CMetricMapBuilderICP::TConfigParams::dumpToTextStream(
 		mrpt::typemeta::TEnumType<mrpt::system::VerbosityLevel>::value2name(
 			verbosity_level)
 			.c_str());
+	out << mrpt::format(
+		"dynamicKDTreeIndex                      = %s\n",
+		dynamicKDTreeIndex ? "YES" : "NO");
 
 	out << "  Now showing 'mapsInitializers':\n";
 	mapInitializers.dumpToTextStream(out);
@@ -538,6 +543,10 @@ void CMetricMapBuilderICP::initialize(
 
 	// Create metric maps:
 	metricMap.setListOfMaps(ICP_options.mapInitializers);
+	for (auto& m : metricMap.maps)
+		if (auto pts = std::dynamic_pointer_cast<CPointsMap>(m); pts)
+			pts->kdtree_search_params.dynamic_index =
+				ICP_options.dynamicKDTreeIndex;
 
 	// copy map:
 	SF_Poses_seq = initialMap;
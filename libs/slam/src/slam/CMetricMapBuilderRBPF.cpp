@@ -67,6 +67,7 @@ CMetricMapBuilderRBPF& CMetricMapBuilderRBPF::operator=(
 	localizeAngDistance = src.localizeAngDistance;
 	odoIncrementSinceLastLocalization = src.odoIncrementSinceLastLocalization;
 	odoIncrementSinceLastMapUpdate = src.odoIncrementSinceLastMapUpdate;
+	m_timelogger = src.m_timelogger;
 	m_statsLastIteration = src.m_statsLastIteration;
 	return *this;
 }
@@ -102,6 +103,8 @@ void CMetricMapBuilderRBPF::processActionObservation(
 {
 	MRPT_START
 	auto lck = mrpt::lockHelper(critZoneChangingMap);
+	mrpt::system::CTimeLoggerEntry tle(
+		m_timelogger, "processActionObservation");
 
 	// Update the traveled distance estimations:
 	{
@@ -213,7 +216,9 @@ void CMetricMapBuilderRBPF::processActionObservation(
 		pf.m_options = m_PF_options;
 		pf.setVerbosityLevel(this->getMinLoggingLevel());
 
+		m_timelogger.enter("processActionObservation.PF");
 		pf.executeOn(mapPDF, &fakeActs, &observations);
+		m_timelogger.leave("processActionObservation.PF");
 
 		if (isLoggingLevelVisible(mrpt::system::LVL_INFO))
 		{
@@ -244,7 +249,11 @@ void CMetricMapBuilderRBPF::processActionObservation(
 		MRPT_LOG_INFO("New observation inserted into the map.");
 
 		// Add current observation to the map:
-		const bool anymap_update = mapPDF.insertObservation(observations);
+		// (in parallel for all particles, if so set in the PF options)
+		m_timelogger.enter("processActionObservation.insertObservation");
+		const bool anymap_update =
+			mapPDF.insertObservation(observations, m_PF_options);
+		m_timelogger.leave("processActionObservation.insertObservation");
 		if (!anymap_update)
 			MRPT_LOG_WARN_STREAM(
 				"**No map was updated** after inserting a CSensoryFrame with "
@@ -260,8 +269,10 @@ void CMetricMapBuilderRBPF::processActionObservation(
 	// Added 29/JUN/2007 JLBC: Tell all maps that they can now free aux.
 	// variables
 	//  (if any) since one PF cycle is over:
+	m_timelogger.enter("processActionObservation.auxParticleFilterCleanUp");
 	for (auto& m_particle : mapPDF.m_particles)
 		m_particle.d->mapTillNow.auxParticleFilterCleanUp();
+	m_timelogger.leave("processActionObservation.auxParticleFilterCleanUp");
 
 	MRPT_END
 }
@@ -337,8 +348,10 @@ void CMetricMapBuilderRBPF::getCurrentMostLikelyPath(
   ---------------------------------------------------------------*/
 void CMetricMapBuilderRBPF::getCurrentlyBuiltMap(CSimpleMap& out_map) const
 {
-	const_cast<CMetricMapBuilderRBPF*>(this)
-		->mapPDF.updateSensoryFrameSequence();
+	auto* me = const_cast<CMetricMapBuilderRBPF*>(this);
+	mrpt::system::CTimeLoggerEntry tle(
+		me->m_timelogger, "getCurrentlyBuiltMap.updateSensoryFrameSequence");
+	me->mapPDF.updateSensoryFrameSequence();
 	out_map = mapPDF.SFs;
 }
 
@@ -0,0 +1,239 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "slam-precomp.h"  // Precompiled headers
+//
+#include <mrpt/maps/COccupancyGridMap2D.h>
+#include <mrpt/math/distributions.h>  // chi2inv
+#include <mrpt/obs/CActionCollection.h>
+#include <mrpt/obs/CActionRobotMovement2D.h>
+#include <mrpt/obs/CActionRobotMovement3D.h>
+#include <mrpt/obs/CSensoryFrame.h>
+#include <mrpt/random.h>
+#include <mrpt/slam/CMonteCarloLocalization2DSoA.h>
+#include <mrpt/slam/PF_aux_structs.h>
+
+using namespace mrpt;
+using namespace mrpt::bayes;
+using namespace mrpt::poses;
+using namespace mrpt::math;
+using namespace mrpt::maps;
+using namespace mrpt::obs;
+using namespace mrpt::slam;
+using namespace mrpt::random;
+
+CMonteCarloLocalization2DSoA::CMonteCarloLocalization2DSoA(size_t M)
+	: CPose2DParticlesSoA(M)
+{
+}
+
+void CMonteCarloLocalization2DSoA::prediction_and_update_pfStandardProposal(
+	const CActionCollection* actions, const CSensoryFrame* sf,
+	const CParticleFilter::TParticleFilterOptions& PF_options)
+{
+	MRPT_START
+
+	if (actions)
+	{
+		// Load the motion model:
+		if (auto robotMovement2D = actions->getBestMovementEstimation();
+			robotMovement2D)
+		{
+			ASSERT_(robotMovement2D->poseChange);
+			m_movementDrawer.setPosePDF(*robotMovement2D->poseChange);
+		}
+		else if (auto robotMovement3D =
+					 actions->getActionByClass<CActionRobotMovement3D>();
+				 robotMovement3D)
+		{
+			m_movementDrawer.setPosePDF(robotMovement3D->poseChange);
+		}
+		else
+		{
+			THROW_EXCEPTION(
+				"Action list does not contain any CActionRobotMovement2D or "
+				"CActionRobotMovement3D object!");
+		}
+
+		if (!PF_options.adaptiveSampleSize)
+			drawMotionSamples(m_movementDrawer);
+		else
+			predictionKLD(PF_options);
+	}
+
+	if (sf)
+	{
+		// A map MUST be supplied!
+		ASSERT_(options.metricMap || options.metricMaps.size() > 0);
+		if (!options.metricMap)
+			ASSERT_EQUAL_(options.metricMaps.size(), size());
+
+		updateWeights(*sf, PF_options);
+		// Normalization of weights is done outside of this method.
+	}
+
+	MRPT_END
+}
+
+void CMonteCarloLocalization2DSoA::predictionKLD(
+	const CParticleFilter::TParticleFilterOptions& PF_options)
+{
+	MRPT_START
+
+	// Implementation of Dieter Fox's KLD algorithm, as in
+	// PF_implementation::PF_SLAM_implementation_pfStandardProposal()
+	using bin_t = mrpt::slam::detail::TPoseBin2D;
+	m_kldBins.clear();
+	m_kldBins.reserve(size());
+
+	const TKLDParams& KLD = options.KLD_params;
+	size_t Nx = KLD.KLD_minSampleSize;
+	const double delta_1 = 1.0 - KLD.KLD_delta;
+	const double epsilon_1 = 0.5 / KLD.KLD_epsilon;
+
+	prepareFastDrawSample(PF_options);
+
+	m_new_x.clear();
+	m_new_y.clear();
+	m_new_phi.clear();
+
+	CPose2D incr;
+	size_t N = 0;
+	do
+	{
+		m_movementDrawer.drawSample(incr);
+		const size_t drawn_idx = fastDrawSample(PF_options);
+		const TPose2D newPose = getParticlePose(drawn_idx) + incr.asTPose();
+
+		m_new_x.push_back(newPose.x);
+		m_new_y.push_back(newPose.y);
+		m_new_phi.push_back(newPose.phi);
+
+		bin_t p;
+		p.x = round(newPose.x / KLD.KLD_binSize_XY);
+		p.y = round(newPose.y / KLD.KLD_binSize_XY);
+		p.phi = round(newPose.phi / KLD.KLD_binSize_PHI);
+
+		if (m_kldBins.insert(p).second)
+		{
+			// It falls into a new bin:
+			const size_t K = m_kldBins.size();
+			if (K > 1) Nx = round(epsilon_1 * math::chi2inv(delta_1, K - 1));
+		}
+		N = m_new_x.size();
+	} while (N < std::max(Nx, (size_t)KLD.KLD_minSampleSize) &&
+			 N < KLD.KLD_maxSampleSize);
+
+	// Replace the old particle set, with equal weights:
+	x().swap(m_new_x);
+	y().swap(m_new_y);
+	phi().swap(m_new_phi);
+	m_log_w.assign(N, .0);
+
+	MRPT_END
+}
+
+void CMonteCarloLocalization2DSoA::updateWeights(
+	const CSensoryFrame& sf,
+	const CParticleFilter::TParticleFilterOptions& PF_options)
+{
+	MRPT_START
+
+	const size_t M = size();
+	const double* xs = x().data();
+	const double* ys = y().data();
+	const double* phis = phi().data();
+	double* w = m_log_w.data();
+
+	const auto updateRange = [&](size_t first, size_t last) {
+		for (size_t i = first; i < last; i++)
+		{
+			// All particles, one map, or one map per particle:
+			const CMetricMap* map = options.metricMap
+				? options.metricMap.get()
+				: options.metricMaps[i].get();
+
+			const CPose3D pose(xs[i], ys[i], 0, phis[i], 0, 0);
+			double obs_log_lik = 0;
+			for (const auto& obs : sf)
+				obs_log_lik += map->computeObservationLikelihood(*obs, pose);
+
+			ASSERT_(!std::isnan(obs_log_lik) && std::isfinite(obs_log_lik));
+			w[i] += obs_log_lik * PF_options.powFactor;
+		}
+	};
+
+	if (PF_options.numThreads == 1 || M < 2) updateRange(0, M);
+	else
+	{
+		// First particle alone, to build the lazy caches of maps and obs:
+		updateRange(0, 1);
+		CParticleFilter::forEachParticleBlock(
+			PF_options, M - 1,
+			[&](size_t first, size_t last,
+				[[maybe_unused]] CRandomGenerator& rng) {
+				updateRange(first + 1, last + 1);
+			});
+	}
+
+	MRPT_END
+}
+
+void CMonteCarloLocalization2DSoA::resetUniformFreeSpace(
+	COccupancyGridMap2D* theMap, const double freeCellsThreshold,
+	const int particlesCount, const double x_min, const double x_max,
+	const double y_min, const double y_max, const double phi_min,
+	const double phi_max)
+{
+	MRPT_START
+
+	ASSERT_(theMap != nullptr);
+	const int sizeX = theMap->getSizeX();
+	const int sizeY = theMap->getSizeY();
+	const double gridRes = theMap->getResolution();
+
+	const int xIdx1 =
+		x_min > theMap->getXMin() ? std::max(0, theMap->x2idx(x_min)) : 0;
+	const int xIdx2 = x_max < theMap->getXMax()
+		? std::min(sizeX - 1, theMap->x2idx(x_max))
+		: sizeX - 1;
+	const int yIdx1 =
+		y_min > theMap->getYMin() ? std::max(0, theMap->y2idx(y_min)) : 0;
+	const int yIdx2 = y_max < theMap->getYMax()
+		? std::min(sizeY - 1, theMap->y2idx(y_max))
+		: sizeY - 1;
+
+	std::vector<double> freeCells_x, freeCells_y;
+	for (int cx = xIdx1; cx <= xIdx2; cx++)
+		for (int cy = yIdx1; cy <= yIdx2; cy++)
+			if (theMap->getCell(cx, cy) >= freeCellsThreshold)
+			{
+				freeCells_x.push_back(theMap->idx2x(cx));
+				freeCells_y.push_back(theMap->idx2y(cy));
+			}
+
+	// Assure that map is not fully occupied!
+	const size_t nFreeCells = freeCells_x.size();
+	ASSERT_(nFreeCells);
+
+	if (particlesCount > 0) resizeParticles(particlesCount);
+
+	auto& rng = getRandomGenerator();
+	const size_t M = size();
+	for (size_t i = 0; i < M; i++)
+	{
+		const int idx = round(rng.drawUniform(0.0, nFreeCells - 1.001));
+		x()[i] = freeCells_x[idx] + rng.drawUniform(-gridRes, gridRes);
+		y()[i] = freeCells_y[idx] + rng.drawUniform(-gridRes, gridRes);
+		phi()[i] = rng.drawUniform(phi_min, phi_max);
+	}
+	std::fill(m_log_w.begin(), m_log_w.end(), .0);
+
+	MRPT_END
+}
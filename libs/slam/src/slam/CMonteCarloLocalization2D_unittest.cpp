@@ -17,6 +17,7 @@
 #include <mrpt/random.h>
 #include <mrpt/serialization/CArchive.h>
 #include <mrpt/slam/CMonteCarloLocalization2D.h>
+#include <mrpt/slam/CMonteCarloLocalization2DSoA.h>
 #include <mrpt/system/filesystem.h>
 #include <mrpt/system/os.h>
 #include <test_mrpt_common.h>
@@ -34,6 +35,7 @@ using namespace mrpt::system;
 using namespace mrpt::obs;
 using namespace std;
 
+template <class PDF>
 void run_test_pf_localization(CPose2D& meanPose, CMatrixDouble33& cov)
 {
 	// ------------------------------------------------------
@@ -150,7 +152,7 @@ void run_test_pf_localization(CPose2D& meanPose, CMatrixDouble33& cov)
 		tictacGlobal.Tic();
 		for (int repetition = 0; repetition < NUM_REPS; repetition++)
 		{
-			CMonteCarloLocalization2D pdf(PARTICLE_COUNT);
+			PDF pdf(PARTICLE_COUNT);
 
 			// PDF Options:
 			pdf.options = pdfPredictionOptions;
@@ -259,8 +261,8 @@ void run_test_pf_localization(CPose2D& meanPose, CMatrixDouble33& cov)
 	}  // end of loop for different # of particles
 }
 
-// TEST =================
-TEST(MonteCarlo2D, RunSampleDataset)
+template <class PDF>
+void run_test_pf_localization_converges()
 {
 	try
 	{
@@ -276,7 +278,7 @@ TEST(MonteCarlo2D, RunSampleDataset)
 		// even twice in an extreme bad luck:
 		for (int op = 0; op < 3; op++)
 		{
-			run_test_pf_localization(meanPose, cov);
+			run_test_pf_localization<PDF>(meanPose, cov);
 
 			const double final_pf_cov_trace = cov.trace();
 			const CPose2D final_pf_pose = meanPose;
@@ -299,3 +301,14 @@ TEST(MonteCarlo2D, RunSampleDataset)
 		FAIL() << mrpt::exception_to_str(e);
 	}
 }
+
+// TEST =================
+TEST(MonteCarlo2D, RunSampleDataset)
+{
+	run_test_pf_localization_converges<CMonteCarloLocalization2D>();
+}
+
+TEST(MonteCarlo2D, RunSampleDatasetSoA)
+{
+	run_test_pf_localization_converges<CMonteCarloLocalization2DSoA>();
+}
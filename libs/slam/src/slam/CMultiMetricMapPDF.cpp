@@ -26,6 +26,8 @@
 #include <mrpt/system/CTicTac.h>
 #include <mrpt/system/os.h>
 
+#include <numeric>
+
 using namespace mrpt;
 using namespace mrpt::math;
 using namespace mrpt::slam;
@@ -39,6 +41,44 @@ using namespace std;
 IMPLEMENTS_SERIALIZABLE(CMultiMetricMapPDF, CSerializable, mrpt::maps)
 IMPLEMENTS_SERIALIZABLE(CRBPFParticleData, CSerializable, mrpt::maps)
 
+CRBPFParticlePath::TNode::~TNode()
+{
+	// Free the chain of ancestors only referenced from here iteratively,
+	// instead of through recursive destructors, which could overflow the
+	// stack for long paths:
+	std::shared_ptr<TNode> p = std::move(parent);
+	while (p && p.use_count() == 1)
+		p = std::move(p->parent);
+}
+
+void CRBPFParticlePath::push_back(const TPose3D& p)
+{
+	m_leaf = std::make_shared<TNode>(p, std::move(m_leaf));
+}
+
+const TPose3D& CRBPFParticlePath::operator[](size_t i) const
+{
+	ASSERTMSG_(i < size(), "Index out of bounds");
+	const TNode* n = m_leaf.get();
+	while (n->index != i)
+		n = n->parent.get();
+	return n->pose;
+}
+
+void CRBPFParticlePath::getPath(std::deque<TPose3D>& out_path) const
+{
+	out_path.resize(size());
+	visitPosesBackwards(
+		[&](size_t i, const TPose3D& p) { out_path[i] = p; });
+}
+
+void CRBPFParticlePath::getPath(std::vector<TPose3D>& out_path) const
+{
+	out_path.resize(size());
+	visitPosesBackwards(
+		[&](size_t i, const TPose3D& p) { out_path[i] = p; });
+}
+
 /*---------------------------------------------------------------
 				Constructor
   ---------------------------------------------------------------*/
@@ -84,8 +124,8 @@ void CMultiMetricMapPDF::clear(const CPose3D& initialPose)
 
 		m_particles[i].d->mapTillNow.clear();
 
-		m_particles[i].d->robotPath.resize(1);
-		m_particles[i].d->robotPath[0] = initialPose.asTPose();
+		m_particles[i].d->robotPath.clear();
+		m_particles[i].d->robotPath.push_back(initialPose.asTPose());
 	}
 
 	SFs.clear();
@@ -112,7 +152,7 @@ void CMultiMetricMapPDF::clear(
 
 		p.d->mapTillNow.clear();
 
-		p.d->robotPath.resize(nOldKeyframes);
+		p.d->robotPath.clear();
 		for (size_t i = 0; i < nOldKeyframes; i++)
 		{
 			const auto [keyframe_pose, sfkeyframe_sf] = prevMap.get(i);
@@ -135,7 +175,7 @@ void CMultiMetricMapPDF::clear(
 				}
 			}
 			if (!kf_pose_set) { kf_pose = keyframe_pose->getMeanVal(); }
-			p.d->robotPath[i] = kf_pose.asTPose();
+			p.d->robotPath.push_back(kf_pose.asTPose());
 			for (const auto& obs : *sfkeyframe_sf)
 				p.d->mapTillNow.insertObservation(*obs, kf_pose);
 		}
@@ -185,6 +225,30 @@ void CMultiMetricMapPDF::getEstimatedPosePDFAtTime(
 	}
 }
 
+void CMultiMetricMapPDF::getEstimatedPosePDFsAtTimes(
+	const std::vector<size_t>& timeSteps,
+	std::vector<CPose3DPDFParticles>& out_estimations) const
+{
+	const size_t n = m_particles.size(), nTimes = timeSteps.size();
+
+	out_estimations.resize(nTimes);
+	for (auto& e : out_estimations)
+		e.m_particles.resize(n);
+
+	// Reconstruct each path only once:
+	std::vector<TPose3D> path;
+	for (size_t i = 0; i < n; i++)
+	{
+		m_particles[i].d->robotPath.getPath(path);
+		for (size_t k = 0; k < nTimes; k++)
+		{
+			ASSERT_(timeSteps[k] < path.size());
+			out_estimations[k].m_particles[i].d = path[timeSteps[k]];
+			out_estimations[k].m_particles[i].log_w = m_particles[i].log_w;
+		}
+	}
+}
+
 uint8_t CRBPFParticleData::serializeGetVersion() const { return 0; }
 void CRBPFParticleData::serializeTo(mrpt::serialization::CArchive&) const
 {
@@ -205,8 +269,10 @@ void CMultiMetricMapPDF::serializeTo(mrpt::serialization::CArchive& out) const
 	{
 		out << part.log_w;
 		out << part.d->mapTillNow;
-		out.WriteAs<uint32_t>(part.d->robotPath.size());
-		for (const auto& p : part.d->robotPath)
+		std::vector<TPose3D> path;
+		part.d->robotPath.getPath(path);
+		out.WriteAs<uint32_t>(path.size());
+		for (const auto& p : path)
 			out << p;
 	}
 	out << SFs << SF2robotPath;
@@ -242,9 +308,12 @@ void CMultiMetricMapPDF::serializeFrom(
 				in >> m_particles[i].log_w >> m_particles[i].d->mapTillNow;
 
 				in >> m;
-				m_particles[i].d->robotPath.resize(m);
 				for (j = 0; j < m; j++)
-					in >> m_particles[i].d->robotPath[j];
+				{
+					TPose3D p;
+					in >> p;
+					m_particles[i].d->robotPath.push_back(p);
+				}
 			}
 
 			in >> SFs >> SF2robotPath;
@@ -267,7 +336,7 @@ TPose3D CMultiMetricMapPDF::getLastPose(
 	}
 	else
 	{
-		return *m_particles[i].d->robotPath.rbegin();
+		return m_particles[i].d->robotPath.back();
 	}
 }
 
@@ -343,8 +412,10 @@ void CMultiMetricMapPDF::rebuildAverageMap()
 
 		// Reserve a float grid-map, add weight all maps
 		// -------------------------------------------------------------------------------------------
+		const unsigned int sizeX = avrg_grid->getSizeX();
+		const unsigned int sizeY = avrg_grid->getSizeY();
 		std::vector<float> floatMap;
-		floatMap.resize(avrg_grid->m_map.size(), 0);
+		floatMap.resize(static_cast<size_t>(sizeX) * sizeY, 0);
 
 		// For each particle in the RBPF:
 		double sumW = 0;
@@ -355,33 +426,33 @@ void CMultiMetricMapPDF::rebuildAverageMap()
 
 		for (auto& p : m_particles)
 		{
-			auto grid = p.d->mapTillNow.mapByClass<COccupancyGridMap2D>(0);
-			// Variables:
-			std::vector<COccupancyGridMap2D::cellType>::iterator srcCell;
-			auto firstSrcCell = grid->m_map.begin();
-			auto lastSrcCell = grid->m_map.end();
-			std::vector<float>::iterator destCell;
+			// Read-only access, so cells shared among particles are not
+			// copied:
+			const COccupancyGridMap2D& grid =
+				*p.d->mapTillNow.mapByClass<COccupancyGridMap2D>(0);
 
 			// The weight of particle:
 			float w = exp(p.log_w) / sumW;
 
-			ASSERT_(grid->m_map.size() == floatMap.size());
-
 			// For each cell in individual maps:
-			for (srcCell = firstSrcCell, destCell = floatMap.begin();
-				 srcCell != lastSrcCell; srcCell++, destCell++)
-				(*destCell) += w * (*srcCell);
+			for (unsigned int cy = 0; cy < sizeY; cy++)
+			{
+				const COccupancyGridMap2D::cellType* srcCell = grid.getRow(cy);
+				float* destCell = &floatMap[static_cast<size_t>(cy) * sizeX];
+				for (unsigned int cx = 0; cx < sizeX; cx++)
+					destCell[cx] += w * srcCell[cx];
+			}
 		}
 
 		// Copy to fixed point map:
-		std::vector<float>::iterator srcCell;
-		auto destCell = avrg_grid->m_map.begin();
-
-		ASSERT_(avrg_grid->m_map.size() == floatMap.size());
-
-		for (srcCell = floatMap.begin(); srcCell != floatMap.end();
-			 srcCell++, destCell++)
-			*destCell = static_cast<COccupancyGridMap2D::cellType>(*srcCell);
+		for (unsigned int cy = 0; cy < sizeY; cy++)
+		{
+			const float* srcCell = &floatMap[static_cast<size_t>(cy) * sizeX];
+			COccupancyGridMap2D::cellType* destCell = avrg_grid->getRow(cy);
+			for (unsigned int cx = 0; cx < sizeX; cx++)
+				destCell[cx] =
+					static_cast<COccupancyGridMap2D::cellType>(srcCell[cx]);
+		}
 
 		MRPT_END
 	}  // End of SSE not supported
@@ -394,6 +465,14 @@ void CMultiMetricMapPDF::rebuildAverageMap()
 						insertObservation
  ---------------------------------------------------------------*/
 bool CMultiMetricMapPDF::insertObservation(CSensoryFrame& sf)
+{
+	return insertObservation(
+		sf, mrpt::bayes::CParticleFilter::TParticleFilterOptions());
+}
+
+bool CMultiMetricMapPDF::insertObservation(
+	CSensoryFrame& sf,
+	const mrpt::bayes::CParticleFilter::TParticleFilterOptions& PF_options)
 {
 	const size_t M = particlesCount();
 
@@ -407,15 +486,38 @@ bool CMultiMetricMapPDF::insertObservation(CSensoryFrame& sf)
 	SF2robotPath.resize(new_sf_id + 1);
 	SF2robotPath[new_sf_id] = m_particles[0].d->robotPath.size() - 1;
 
-	bool anymap = false;
-	for (size_t i = 0; i < M; i++)
-	{
+	auto insertInto = [&](size_t i) {
 		bool pose_is_valid;
 		const CPose3D robotPose = CPose3D(getLastPose(i, pose_is_valid));
 		// ASSERT_(pose_is_valid); // if not, use the default (0,0,0)
-		const bool map_modified =
-			sf.insertObservationsInto(m_particles[i].d->mapTillNow, robotPose);
-		anymap = anymap || map_modified;
+		return sf.insertObservationsInto(
+			m_particles[i].d->mapTillNow, robotPose);
+	};
+
+	bool anymap = false;
+	if (PF_options.numThreads != 1 && M > 1)
+	{
+		// Each particle owns its map (grid maps may share bands of cells,
+		// copied by each map on writing). The first one goes alone, so lazy
+		// caches of the observations are built before the other threads:
+		std::vector<uint8_t> map_modified(M, 0);
+		map_modified[0] = insertInto(0) ? 1 : 0;
+		mrpt::bayes::CParticleFilter::forEachParticleBlock(
+			PF_options, M - 1,
+			[&](size_t first, size_t last, CRandomGenerator&) {
+				for (size_t k = first + 1; k < last + 1; k++)
+					map_modified[k] = insertInto(k) ? 1 : 0;
+			});
+		for (const auto m : map_modified)
+			anymap = anymap || m;
+	}
+	else
+	{
+		for (size_t i = 0; i < M; i++)
+		{
+			const bool map_modified = insertInto(i);
+			anymap = anymap || map_modified;
+		}
 	}
 
 	averageMapIsUpdated = false;
@@ -429,7 +531,7 @@ void CMultiMetricMapPDF::getPath(
 	size_t i, std::deque<math::TPose3D>& out_path) const
 {
 	if (i >= m_particles.size()) THROW_EXCEPTION("Index out of bounds");
-	out_path = m_particles[i].d->robotPath;
+	m_particles[i].d->robotPath.getPath(out_path);
 }
 
 /*---------------------------------------------------------------
@@ -437,7 +539,7 @@ void CMultiMetricMapPDF::getPath(
   ---------------------------------------------------------------*/
 double CMultiMetricMapPDF::getCurrentEntropyOfPaths()
 {
-	size_t i;
+	const size_t M = m_particles.size();
 	size_t N =
 		m_particles[0].d->robotPath.size();	 // The poses count along the paths
 
@@ -447,15 +549,27 @@ double CMultiMetricMapPDF::getCurrentEntropyOfPaths()
 
 	if (N)
 	{
-		// For each pose along the path:
-		for (i = 0; i < N; i++)
+		// Walk all the paths backwards in lockstep, reusing one pose PDF
+		// with the M particles of each time step:
+		std::vector<CRBPFParticlePath::BackwardCursor> cursors;
+		cursors.reserve(M);
+		CPose3DPDFParticles posePDF(M);
+		for (size_t i = 0; i < M; i++)
 		{
-			// Get pose est. as m_particles:
-			CPose3DPDFParticles posePDFParts;
-			getEstimatedPosePDFAtTime(i, posePDFParts);
+			ASSERT_EQUAL_(m_particles[i].d->robotPath.size(), N);
+			cursors.emplace_back(m_particles[i].d->robotPath);
+			posePDF.m_particles[i].log_w = m_particles[i].log_w;
+		}
 
-			// Approximate to gaussian and compute entropy of covariance:
-			H_paths += posePDFParts.getCovarianceEntropy();
+		// Approximate to gaussian and compute entropy of covariance:
+		for (size_t k = 0; k < N; k++)
+		{
+			for (size_t i = 0; i < M; i++)
+			{
+				posePDF.m_particles[i].d = cursors[i].pose();
+				cursors[i].prev();
+			}
+			H_paths += posePDF.getCovarianceEntropy();
 		}
 		H_paths /= N;
 	}
@@ -541,20 +655,22 @@ const CMultiMetricMap* CMultiMetricMapPDF::getCurrentMostLikelyMetricMap() const
 void CMultiMetricMapPDF::updateSensoryFrameSequence()
 {
 	MRPT_START
-	CPose3DPDFParticles posePartsPDF;
 	CPose3DPDF::Ptr previousPosePDF;
 	CSensoryFrame::Ptr dummy;
 
+	// Compute the new estimations, reconstructing the paths only once:
+	const std::vector<size_t> timeSteps(
+		SF2robotPath.begin(), SF2robotPath.end());
+	std::vector<CPose3DPDFParticles> posePartsPDFs;
+	getEstimatedPosePDFsAtTimes(timeSteps, posePartsPDFs);
+
 	for (size_t i = 0; i < SFs.size(); i++)
 	{
 		// Get last estimation:
 		SFs.get(i, previousPosePDF, dummy);
 
-		// Compute the new one:
-		getEstimatedPosePDFAtTime(SF2robotPath[i], posePartsPDF);
-
 		// Copy into SFs:
-		previousPosePDF->copyFrom(posePartsPDF);
+		previousPosePDF->copyFrom(posePartsPDFs[i]);
 	}
 
 	MRPT_END
@@ -569,12 +685,12 @@ void CMultiMetricMapPDF::saveCurrentPathEstimationToTextFile(
 	FILE* f = os::fopen(fil.c_str(), "wt");
 	if (!f) return;
 
+	std::vector<TPose3D> path;
 	for (auto& m_particle : m_particles)
 	{
-		for (size_t i = 0; i < m_particle.d->robotPath.size(); i++)
+		m_particle.d->robotPath.getPath(path);
+		for (const auto& p : path)
 		{
-			const mrpt::math::TPose3D& p = m_particle.d->robotPath[i];
-
 			os::fprintf(
 				f, "%.04f %.04f %.04f %.04f %.04f %.04f ", p.x, p.y, p.z, p.yaw,
 				p.pitch, p.roll);
@@ -58,7 +58,7 @@ void KLF_loadBinFromParticle(
 	{
 		ASSERT_(
 			currentParticleValue && !currentParticleValue->robotPath.empty());
-		const TPose3D& p = *currentParticleValue->robotPath.rbegin();
+		const TPose3D& p = currentParticleValue->robotPath.back();
 		outBin.x = round(p.x / opts.KLD_binSize_XY);
 		outBin.y = round(p.y / opts.KLD_binSize_XY);
 		outBin.phi = round(p.yaw / opts.KLD_binSize_PHI);
@@ -83,15 +83,12 @@ void KLF_loadBinFromParticle(
 
 	// Is a path provided??
 	if (currentParticleValue != nullptr)
-		for (size_t i = 0; i < lenBinPath; ++i)	 // Fill the bin data:
-		{
-			outBin.bins[i].x = round(
-				currentParticleValue->robotPath[i].x / opts.KLD_binSize_XY);
-			outBin.bins[i].y = round(
-				currentParticleValue->robotPath[i].y / opts.KLD_binSize_XY);
-			outBin.bins[i].phi = round(
-				currentParticleValue->robotPath[i].yaw / opts.KLD_binSize_PHI);
-		}
+		currentParticleValue->robotPath.visitPosesBackwards(
+			[&](size_t i, const TPose3D& p) {  // Fill the bin data:
+				outBin.bins[i].x = round(p.x / opts.KLD_binSize_XY);
+				outBin.bins[i].y = round(p.y / opts.KLD_binSize_XY);
+				outBin.bins[i].phi = round(p.yaw / opts.KLD_binSize_PHI);
+			});
 
 	// Is a newPose provided??
 	if (newPoseToBeInserted != nullptr)
@@ -194,14 +191,12 @@ void CMultiMetricMapPDF::prediction_and_update_pfOptimalProposal(
 	// ----------------------------------------------------------------------
 	//						PREDICTION STAGE
 	// ----------------------------------------------------------------------
-	CVectorDouble rndSamples;
 	bool updateStageAlreadyDone = false;
 	CPose3D initialPose, incrPose, finalPose;
 
 	// ICP used if "pfOptimalProposal_mapSelection" = 0 or 1
 	CICP icp(
 		options.icp_params);  // Set our ICP params instead of default ones.
-	CICP::TReturnInfo icpInfo;
 
 	CParticleList::iterator partIt;
 
@@ -255,140 +250,156 @@ void CMultiMetricMapPDF::prediction_and_update_pfOptimalProposal(
 
 	//   The paths MUST already contain the starting location for each particle:
 	ASSERT_(!m_particles[0].d->robotPath.empty());
-	// Build the local map of points for ICP:
+
+	// Use ICP with the map associated to particle?
+	const bool useICP = options.pfOptimalProposal_mapSelection == 0 ||
+		options.pfOptimalProposal_mapSelection == 1 ||
+		options.pfOptimalProposal_mapSelection == 3;
+
+	// Build the local map of points (or landmarks) for ICP:
 	CSimplePointsMap localMapPoints;
 	CLandmarksMap localMapLandmarks;
-	bool built_map_points = false;
-	bool built_map_lms = false;
-
-	// Update particle poses:
-	size_t i;
-	for (i = 0, partIt = m_particles.begin(); partIt != m_particles.end();
-		 partIt++, i++)
+	if (options.pfOptimalProposal_mapSelection == 0 ||
+		options.pfOptimalProposal_mapSelection == 3)
 	{
-		double extra_log_lik = 0;  // Used for the optimal_PF with ICP
+		localMapPoints.insertionOptions.minDistBetweenLaserPoints = 0.02f;
+		localMapPoints.insertionOptions.isPlanarMap = true;
+		sf->insertObservationsInto(localMapPoints);
+	}
+	else if (options.pfOptimalProposal_mapSelection == 1)
+		sf->insertObservationsInto(localMapLandmarks);
 
+	// Draws the new pose of the i'th particle around the ICP alignment of
+	// the observation to its map:
+	const auto drawPoseWithICP = [&](size_t i, CICP& theICP,
+									 CRandomGenerator& rng) {
 		// Set initial robot pose estimation for this particle:
 		const CPose3D ith_last_pose = CPose3D(
-			*partIt->d->robotPath.rbegin());  // The last robot pose in the path
-
-		CPose3D initialPoseEstimation = ith_last_pose + motionModelMeanIncr;
-
-		// Use ICP with the map associated to particle?
-		if (options.pfOptimalProposal_mapSelection == 0 ||
-			options.pfOptimalProposal_mapSelection == 1 ||
-			options.pfOptimalProposal_mapSelection == 3)
-		{
-			CPosePDFGaussian icpEstimation;
+			m_particles[i].d->robotPath.back());	 // The last pose in path
 
-			// Configure the matchings that will take place in the ICP process:
-			auto partMap = partIt->d->mapTillNow;
-			const auto numPtMaps = partMap.countMapsByClass<CSimplePointsMap>();
+		const CPose3D initialPoseEstimation =
+			ith_last_pose + motionModelMeanIncr;
 
-			ASSERT_(numPtMaps == 0 || numPtMaps == 1);
+		CPosePDFGaussian icpEstimation;
+		CICP::TReturnInfo icpInfo;
 
-			CMetricMap* map_to_align_to = nullptr;
+		// Configure the matchings that will take place in the ICP process:
+		auto& partMap = m_particles[i].d->mapTillNow;
+		const auto numPtMaps = partMap.countMapsByClass<CSimplePointsMap>();
 
-			if (options.pfOptimalProposal_mapSelection == 0)  // Grid map
-			{
-				auto grid = partMap.mapByClass<COccupancyGridMap2D>();
-				ASSERT_(grid);
+		ASSERT_(numPtMaps == 0 || numPtMaps == 1);
 
-				// Build local map of points.
-				if (!built_map_points)
-				{
-					built_map_points = true;
+		CMetricMap* map_to_align_to = nullptr;
 
-					localMapPoints.insertionOptions.minDistBetweenLaserPoints =
-						0.02f;
-					localMapPoints.insertionOptions.isPlanarMap = true;
-					sf->insertObservationsInto(localMapPoints);
-				}
-
-				map_to_align_to = grid.get();
-			}
-			// Map of points
-			else if (options.pfOptimalProposal_mapSelection == 3)
-			{
-				auto ptsMap = partMap.mapByClass<CSimplePointsMap>();
-				ASSERT_(ptsMap);
-
-				// Build local map of points.
-				if (!built_map_points)
-				{
-					built_map_points = true;
-
-					localMapPoints.insertionOptions.minDistBetweenLaserPoints =
-						0.02f;
-					localMapPoints.insertionOptions.isPlanarMap = true;
-					sf->insertObservationsInto(localMapPoints);
-				}
+		if (options.pfOptimalProposal_mapSelection == 0)  // Grid map
+		{
+			auto grid = partMap.mapByClass<COccupancyGridMap2D>();
+			ASSERT_(grid);
+			map_to_align_to = grid.get();
+		}
+		// Map of points
+		else if (options.pfOptimalProposal_mapSelection == 3)
+		{
+			auto ptsMap = partMap.mapByClass<CSimplePointsMap>();
+			ASSERT_(ptsMap);
+			map_to_align_to = ptsMap.get();
+		}
+		else
+		{
+			auto lmMap = partMap.mapByClass<CLandmarksMap>();
+			ASSERT_(lmMap);
+			map_to_align_to = lmMap.get();
+		}
 
-				map_to_align_to = ptsMap.get();
-			}
-			else
-			{
-				auto lmMap = partMap.mapByClass<CLandmarksMap>();
-				ASSERT_(lmMap);
+		ASSERT_(map_to_align_to != nullptr);
 
-				// Build local map of LMs.
-				if (!built_map_lms)
-				{
-					built_map_lms = true;
-					sf->insertObservationsInto(localMapLandmarks);
-				}
+		// Use ICP to align to each particle's map:
+		{
+			CPosePDF::Ptr alignEst = theICP.Align(
+				map_to_align_to, &localMapPoints,
+				CPose2D(initialPoseEstimation), icpInfo);
+			icpEstimation.copyFrom(*alignEst);
+		}
 
-				map_to_align_to = lmMap.get();
-			}
+		if (i == particleWithHighestW)
+		{
+			newInfoIndex = 1 - icpInfo.goodness;  // newStaticPointsRatio;
+			// //* icpInfo.goodness;
+		}
 
-			ASSERT_(map_to_align_to != nullptr);
+		// Set the gaussian pose:
+		CPose3DPDFGaussian finalEstimatedPoseGauss(icpEstimation);
 
-			// Use ICP to align to each particle's map:
-			{
-				CPosePDF::Ptr alignEst = icp.Align(
-					map_to_align_to, &localMapPoints,
-					CPose2D(initialPoseEstimation), icpInfo);
-				icpEstimation.copyFrom(*alignEst);
-			}
+		MRPT_LOG_DEBUG_FMT(
+			"gridICP[particle %u]: %.02f%%", static_cast<unsigned int>(i),
+			100 * icpInfo.goodness);
+		if (icpInfo.goodness < options.ICPGlobalAlign_MinQuality && SFs.size())
+		{
+			MRPT_LOG_WARN_FMT(
+				"gridICP[particle %u]: %.02f%% -> Using odometry instead!",
+				(unsigned int)i, 100 * icpInfo.goodness);
+			icpEstimation.mean = CPose2D(initialPoseEstimation);
+		}
 
-			if (i == particleWithHighestW)
-			{
-				newInfoIndex = 1 - icpInfo.goodness;  // newStaticPointsRatio;
-				// //* icpInfo.goodness;
-			}
+		// Use real ICP covariance (with a minimum level):
+		keep_max(finalEstimatedPoseGauss.cov(0, 0), square(0.002));
+		keep_max(finalEstimatedPoseGauss.cov(1, 1), square(0.002));
+		keep_max(finalEstimatedPoseGauss.cov(2, 2), square(0.1_deg));
+
+		// Generate gaussian-distributed 2D-pose increments according to
+		// "finalEstimatedPoseGauss":
+		// ------------------------------------------------------------
+		CPose3D newPose =
+			finalEstimatedPoseGauss.mean;  // Add to the new robot pose:
+		CVectorDouble rndSamples;
+		rng.drawGaussianMultivariate(rndSamples, finalEstimatedPoseGauss.cov);
+		// Add noise:
+		newPose.setFromValues(
+			newPose.x() + rndSamples[0], newPose.y() + rndSamples[1],
+			newPose.z(), newPose.yaw() + rndSamples[2], newPose.pitch(),
+			newPose.roll());
+		return newPose;
+	};
+
+	// ICP for all particles is done first, in parallel blocks with their own
+	// random generators (also with one thread, so the drawn poses do not
+	// depend on the number of threads). The first particle goes alone, so
+	// lazily-built caches of the local map are ready for the other threads:
+	std::vector<CPose3D> icpPoses;
+	if (useICP)
+	{
+		icpPoses.resize(M);
+		CParticleFilter::forEachParticleBlock(
+			PF_options, 1, [&](size_t, size_t, CRandomGenerator& rng) {
+				icpPoses[0] = drawPoseWithICP(0, icp, rng);
+			});
+		CParticleFilter::forEachParticleBlock(
+			PF_options, M - 1,
+			[&](size_t first, size_t last, CRandomGenerator& rng) {
+				CICP blockICP(options.icp_params);
+				for (size_t k = first + 1; k < last + 1; k++)
+					icpPoses[k] = drawPoseWithICP(k, blockICP, rng);
+			});
+	}
 
-			// Set the gaussian pose:
-			CPose3DPDFGaussian finalEstimatedPoseGauss(icpEstimation);
+	// The same for the update stage, done after all new poses are drawn:
+	const bool parallelUpdate = PF_options.numThreads != 1 &&
+		options.pfOptimalProposal_mapSelection != 2;
 
-			MRPT_LOG_DEBUG_FMT(
-				"gridICP[particle %u]: %.02f%%", static_cast<unsigned int>(i),
-				100 * icpInfo.goodness);
-			if (icpInfo.goodness < options.ICPGlobalAlign_MinQuality &&
-				SFs.size())
-			{
-				MRPT_LOG_WARN_FMT(
-					"gridICP[particle %u]: %.02f%% -> Using odometry instead!",
-					(unsigned int)i, 100 * icpInfo.goodness);
-				icpEstimation.mean = CPose2D(initialPoseEstimation);
-			}
+	// Update particle poses:
+	size_t i;
+	for (i = 0, partIt = m_particles.begin(); partIt != m_particles.end();
+		 partIt++, i++)
+	{
+		double extra_log_lik = 0;  // Used for the optimal_PF with ICP
 
-			// Use real ICP covariance (with a minimum level):
-			keep_max(finalEstimatedPoseGauss.cov(0, 0), square(0.002));
-			keep_max(finalEstimatedPoseGauss.cov(1, 1), square(0.002));
-			keep_max(finalEstimatedPoseGauss.cov(2, 2), square(0.1_deg));
+		// Set initial robot pose estimation for this particle:
+		const CPose3D ith_last_pose = CPose3D(
+			partIt->d->robotPath.back());  // The last robot pose in the path
 
-			// Generate gaussian-distributed 2D-pose increments according to
-			// "finalEstimatedPoseGauss":
-			// ------------------------------------------------------------
-			finalPose =
-				finalEstimatedPoseGauss.mean;  // Add to the new robot pose:
-			getRandomGenerator().drawGaussianMultivariate(
-				rndSamples, finalEstimatedPoseGauss.cov);
-			// Add noise:
-			finalPose.setFromValues(
-				finalPose.x() + rndSamples[0], finalPose.y() + rndSamples[1],
-				finalPose.z(), finalPose.yaw() + rndSamples[2],
-				finalPose.pitch(), finalPose.roll());
+		if (useICP)
+		{
+			finalPose = icpPoses[i];
 		}
 		else if (options.pfOptimalProposal_mapSelection == 2)
 		{
@@ -874,7 +885,7 @@ void CMultiMetricMapPDF::prediction_and_update_pfOptimalProposal(
 		// ----------------------------------------------------------------------
 		//						UPDATE STAGE
 		// ----------------------------------------------------------------------
-		if (!updateStageAlreadyDone)
+		if (!updateStageAlreadyDone && !parallelUpdate)
 		{
 			partIt->log_w += PF_options.powFactor *
 				(PF_SLAM_computeObservationLikelihoodForParticle(
@@ -884,6 +895,29 @@ void CMultiMetricMapPDF::prediction_and_update_pfOptimalProposal(
 
 	}  // end of for each particle "i" & "partIt"
 
+	if (parallelUpdate)
+	{
+		const auto updateWeights = [&](size_t first, size_t last) {
+			for (size_t k = first; k < last; k++)
+			{
+				auto& part = m_particles[k];
+				const double obs_log_lik =
+					PF_SLAM_computeObservationLikelihoodForParticle(
+						PF_options, k, *sf,
+						CPose3D(part.d->robotPath.back()));
+				part.log_w += PF_options.powFactor * obs_log_lik;
+			}
+		};
+		// First particle alone, to build the lazy caches of observations:
+		updateWeights(0, 1);
+		CParticleFilter::forEachParticleBlock(
+			PF_options, M - 1,
+			[&](size_t first, size_t last,
+				[[maybe_unused]] CRandomGenerator& rng) {
+				updateWeights(first + 1, last + 1);
+			});
+	}
+
 	MRPT_LOG_DEBUG("Stage 1) Prediction done.");
 
 	MRPT_END
@@ -0,0 +1,218 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+#include <mrpt/maps/CMultiMetricMapPDF.h>
+#include <mrpt/maps/COccupancyGridMap2D.h>
+#include <mrpt/maps/CSimplePointsMap.h>
+#include <mrpt/obs/CObservation2DRangeScan.h>
+#include <mrpt/obs/stock_observations.h>
+#include <mrpt/random/RandomGenerators.h>
+
+using namespace mrpt::maps;
+using mrpt::math::TPose3D;
+
+namespace
+{
+TPose3D poseAt(double t) { return TPose3D(t, 2 * t, 0, 0.1 * t, 0, 0); }
+}  // namespace
+
+TEST(CRBPFParticlePath, sharedAncestors)
+{
+	CRBPFParticlePath a;
+	EXPECT_TRUE(a.empty());
+	for (int i = 0; i < 10; i++)
+		a.push_back(poseAt(i));
+	ASSERT_EQ(a.size(), 10U);
+
+	// Copies share all the poses, and branch when appending:
+	CRBPFParticlePath b = a;
+	EXPECT_TRUE(b.sharesLastPoseWith(a));
+	b.push_back(poseAt(100));
+	a.push_back(poseAt(10));
+	EXPECT_FALSE(b.sharesLastPoseWith(a));
+
+	EXPECT_EQ(a.size(), 11U);
+	EXPECT_EQ(b.size(), 11U);
+	EXPECT_EQ(a.back(), poseAt(10));
+	EXPECT_EQ(b.back(), poseAt(100));
+
+	std::deque<TPose3D> pa, pb;
+	a.getPath(pa);
+	b.getPath(pb);
+	ASSERT_EQ(pa.size(), 11U);
+	ASSERT_EQ(pb.size(), 11U);
+	for (size_t i = 0; i < 10; i++)
+	{
+		EXPECT_EQ(pa[i], poseAt(i));
+		EXPECT_EQ(pb[i], poseAt(i));
+		EXPECT_EQ(a[i], poseAt(i));
+		EXPECT_EQ(&a[i], &b[i]);  // The very same node
+	}
+	EXPECT_EQ(pa[10], poseAt(10));
+	EXPECT_EQ(pb[10], poseAt(100));
+
+	// The ancestors stay alive while any descendant does:
+	a.clear();
+	EXPECT_TRUE(a.empty());
+	b.getPath(pb);
+	for (size_t i = 0; i < 10; i++)
+		EXPECT_EQ(pb[i], poseAt(i));
+}
+
+TEST(CRBPFParticlePath, longPathDestruction)
+{
+	// Must not overflow the stack with recursive destructors:
+	CRBPFParticlePath a;
+	for (int i = 0; i < 1000000; i++)
+		a.push_back(poseAt(i));
+	CRBPFParticlePath b = a;
+	a.clear();
+	EXPECT_EQ(b.size(), 1000000U);
+	b.clear();
+}
+
+TEST(CMultiMetricMapPDF, posePDFsAtTimes)
+{
+	mrpt::bayes::CParticleFilter::TParticleFilterOptions pfOpts;
+	pfOpts.sampleSize = 5;
+	CMultiMetricMapPDF pdf(pfOpts, TSetOfMetricMapInitializers(), {});
+
+	// Branching paths, as after resampling:
+	for (int t = 0; t < 20; t++)
+	{
+		for (size_t i = 0; i < pdf.m_particles.size(); i++)
+			pdf.m_particles[i].d->robotPath.push_back(poseAt(t + 0.01 * i));
+		if (t % 5 == 4)
+			for (size_t i = 1; i < pdf.m_particles.size(); i++)
+				pdf.m_particles[i].d->robotPath =
+					pdf.m_particles[i - 1].d->robotPath;
+	}
+
+	const std::vector<size_t> timeSteps = {0, 3, 4, 5, 13, 20};
+	std::vector<mrpt::poses::CPose3DPDFParticles> pdfs;
+	pdf.getEstimatedPosePDFsAtTimes(timeSteps, pdfs);
+	ASSERT_EQ(pdfs.size(), timeSteps.size());
+	for (size_t k = 0; k < timeSteps.size(); k++)
+	{
+		mrpt::poses::CPose3DPDFParticles expected;
+		pdf.getEstimatedPosePDFAtTime(timeSteps[k], expected);
+		ASSERT_EQ(pdfs[k].particlesCount(), expected.particlesCount());
+		for (size_t i = 0; i < expected.particlesCount(); i++)
+		{
+			EXPECT_EQ(pdfs[k].m_particles[i].d, expected.m_particles[i].d);
+			EXPECT_EQ(
+				pdfs[k].m_particles[i].log_w, expected.m_particles[i].log_w);
+		}
+	}
+}
+
+TEST(CMultiMetricMapPDF, entropyOfPaths)
+{
+	mrpt::bayes::CParticleFilter::TParticleFilterOptions pfOpts;
+	pfOpts.sampleSize = 12;
+	CMultiMetricMapPDF pdf(pfOpts, TSetOfMetricMapInitializers(), {});
+
+	// Noisy poses (full-rank covariances) on branching paths:
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(123);
+	for (int t = 0; t < 15; t++)
+	{
+		for (size_t i = 0; i < pdf.m_particles.size(); i++)
+		{
+			TPose3D p = poseAt(t);
+			for (int d = 0; d < 6; d++)
+				p[d] += rng.drawGaussian1D(0, 0.1);
+			pdf.m_particles[i].d->robotPath.push_back(p);
+		}
+		if (t % 4 == 3)
+			pdf.m_particles[1].d->robotPath = pdf.m_particles[0].d->robotPath;
+	}
+	for (size_t i = 0; i < pdf.m_particles.size(); i++)
+		pdf.m_particles[i].log_w = -0.3 * i;
+
+	// Average entropy of the pose PDF at each time step:
+	const size_t N = pdf.m_particles[0].d->robotPath.size();
+	double expected = 0;
+	for (size_t k = 0; k < N; k++)
+	{
+		mrpt::poses::CPose3DPDFParticles posePDF;
+		pdf.getEstimatedPosePDFAtTime(k, posePDF);
+		expected += posePDF.getCovarianceEntropy();
+	}
+	expected /= N;
+
+	EXPECT_NEAR(pdf.getCurrentEntropyOfPaths(), expected, 1e-9);
+}
+
+TEST(CMultiMetricMapPDF, parallelInsertObservation)
+{
+	TSetOfMetricMapInitializers inits;
+	{
+		COccupancyGridMap2D::TMapDefinition def;
+		def.resolution = 0.1f;
+		inits.push_back(def);
+	}
+	inits.push_back(CSimplePointsMap::TMapDefinition());
+
+	mrpt::bayes::CParticleFilter::TParticleFilterOptions pfOpts;
+	pfOpts.sampleSize = 9;
+	CMultiMetricMapPDF serial(pfOpts, inits, {});
+	CMultiMetricMapPDF parallel(pfOpts, inits, {});
+	for (auto* pdf : {&serial, &parallel})
+		for (size_t i = 0; i < pdf->m_particles.size(); i++)
+			pdf->m_particles[i].d->robotPath.push_back(poseAt(0.1 * i));
+
+	auto scan = mrpt::obs::CObservation2DRangeScan::Create();
+	mrpt::obs::stock_observations::example2DRangeScan(*scan);
+	mrpt::obs::CSensoryFrame sf;
+	sf.insert(scan);
+
+	// Make all grids copies of the same map, as after resampling, so they
+	// share their bands of cells while being written to in parallel:
+	for (auto* pdf : {&serial, &parallel})
+	{
+		const auto& parts = pdf->m_particles;
+		const auto g0 =
+			parts[0].d->mapTillNow.mapByClass<COccupancyGridMap2D>();
+		g0->insertObservation(*scan);
+		for (size_t i = 1; i < parts.size(); i++)
+			*parts[i].d->mapTillNow.mapByClass<COccupancyGridMap2D>() = *g0;
+	}
+
+	EXPECT_TRUE(serial.insertObservation(sf));
+	pfOpts.numThreads = 4;
+	EXPECT_TRUE(parallel.insertObservation(sf, pfOpts));
+
+	for (size_t i = 0; i < serial.m_particles.size(); i++)
+	{
+		const auto& m1 = serial.m_particles[i].d->mapTillNow;
+		const auto& m2 = parallel.m_particles[i].d->mapTillNow;
+
+		const auto pts1 = m1.mapByClass<CSimplePointsMap>();
+		const auto pts2 = m2.mapByClass<CSimplePointsMap>();
+		ASSERT_EQ(pts1->size(), pts2->size());
+		EXPECT_GT(pts1->size(), 0U);
+		for (size_t k = 0; k < pts1->size(); k++)
+		{
+			mrpt::math::TPoint3D p1, p2;
+			pts1->getPoint(k, p1);
+			pts2->getPoint(k, p2);
+			EXPECT_EQ(p1, p2);
+		}
+
+		const auto g1 = m1.mapByClass<COccupancyGridMap2D>();
+		const auto g2 = m2.mapByClass<COccupancyGridMap2D>();
+		ASSERT_EQ(g1->getSizeX(), g2->getSizeX());
+		ASSERT_EQ(g1->getSizeY(), g2->getSizeY());
+		for (unsigned int cy = 0; cy < g1->getSizeY(); cy++)
+			for (unsigned int cx = 0; cx < g1->getSizeX(); cx++)
+				EXPECT_EQ(g1->getCell(cx, cy), g2->getCell(cx, cy));
+	}
+}
@@ -106,7 +106,7 @@ void CRangeBearingKFSLAM::getCurrentRobotPose(
 	out_robotPose.mean.m_quat[3] = m_xkk[6];
 
 	// and cov:
-	out_robotPose.cov = m_pkk.blockCopy<7, 7>(0, 0);
+	getVehicleCov(out_robotPose.cov);
 
 	MRPT_END
 }
@@ -153,7 +153,7 @@ void CRangeBearingKFSLAM::getCurrentState(
 	out_robotPose.mean.m_quat[3] = m_xkk[6];
 
 	// and cov:
-	out_robotPose.cov = m_pkk.blockCopy<7, 7>(0, 0);
+	getVehicleCov(out_robotPose.cov);
 
 	// Landmarks:
 	ASSERT_(((m_xkk.size() - get_vehicle_size()) % get_feature_size()) == 0);
@@ -176,7 +176,7 @@ void CRangeBearingKFSLAM::getCurrentState(
 	out_fullState.resize(m_xkk.size());
 	std::copy(m_xkk.begin(), m_xkk.end(), out_fullState.begin());
 	// Full cov:
-	out_fullCovariance = m_pkk;
+	getStateCovariance(out_fullCovariance);
 
 	MRPT_END
 }
@@ -195,7 +195,7 @@ void CRangeBearingKFSLAM::processActionObservation(
 	// Sanity check:
 	ASSERT_(
 		m_IDs.size() ==
-		(m_pkk.cols() - get_vehicle_size()) / get_feature_size());
+		(m_xkk.size() - get_vehicle_size()) / get_feature_size());
 
 	// ===================================================================================================================
 	// Here's the meat!: Call the main method for the KF algorithm, which will
@@ -538,6 +538,67 @@ void CRangeBearingKFSLAM::OnObservationJacobians(
 	MRPT_END
 }
 
+void CRangeBearingKFSLAM::OnObservationJacobiansBatch(
+	const std::vector<size_t>& idx_landmarks_to_predict,
+	std::vector<KFMatrix_OxV>& out_Hx, std::vector<KFMatrix_OxF>& out_Hy) const
+{
+	MRPT_START
+
+	const size_t N = idx_landmarks_to_predict.size();
+	out_Hx.resize(N);
+	out_Hy.resize(N);
+
+	// Mean of the prior of the robot pose:
+	const CPose3DQuat robotPose = getCurrentRobotPoseMean();
+
+	// Get the sensor pose relative to the robot:
+	CObservationBearingRange::Ptr obs =
+		m_SF->getObservationByClass<CObservationBearingRange>();
+	ASSERTMSG_(
+		obs,
+		"*ERROR*: This method requires an observation of type "
+		"CObservationBearingRange");
+	const CPose3DQuat sensorPoseOnRobot =
+		CPose3DQuat(obs->sensorLocationOnRobot);
+
+	const size_t vehicle_size = get_vehicle_size();
+	const size_t feature_size = get_feature_size();
+
+	// The sensor pose and its Jacobian, only once for all the landmarks:
+	CPose3DQuat sensorPoseAbs(UNINITIALIZED_QUATERNION);
+	CMatrixFixed<kftype, 7, 7> H_senpose_vehpose(UNINITIALIZED_MATRIX);
+	CMatrixFixed<kftype, 7, 7> H_senpose_senrelpose(
+		UNINITIALIZED_MATRIX);	// Not actually used
+
+	CPose3DQuatPDF::jacobiansPoseComposition(
+		robotPose, sensorPoseOnRobot, H_senpose_vehpose, H_senpose_senrelpose,
+		&sensorPoseAbs);
+
+	KFMatrix_OxV Hx_sensor;
+	double obsData[3];
+	for (size_t i = 0; i < N; i++)
+	{
+		const size_t row_in = feature_size * idx_landmarks_to_predict[i];
+
+		// Landmark absolute 3D position in the map:
+		const TPoint3D mapEst(
+			m_xkk[vehicle_size + row_in + 0], m_xkk[vehicle_size + row_in + 1],
+			m_xkk[vehicle_size + row_in + 2]);
+
+		sensorPoseAbs.sphericalCoordinates(
+			mapEst,
+			obsData[0],	 // range
+			obsData[1],	 // yaw
+			obsData[2],	 // pitch
+			&out_Hy[i], &Hx_sensor);
+
+		// Chain rule: Hx = d sensorpose / d vehiclepose   * Hx_sensor
+		out_Hx[i] = Hx_sensor * H_senpose_vehpose;
+	}
+
+	MRPT_END
+}
+
 /** This is called between the KF prediction step and the update step, and the
  * application must return the observations and, when applicable, the data
  * association between these observations and the current map.
@@ -688,7 +749,8 @@ void CRangeBearingKFSLAM::OnGetObservationsAndDataAssociation(
 				true,  // Use KD-tree
 				m_last_data_association.predictions_IDs,
 				options.data_assoc_IC_metric,
-				options.data_assoc_IC_ml_threshold);
+				options.data_assoc_IC_ml_threshold,
+				options.data_assoc_JCBB_numThreads);
 
 			// Return pairings to the main KF algorithm:
 			for (auto it = m_last_data_association.results.associations.begin();
@@ -769,6 +831,7 @@ void CRangeBearingKFSLAM::TOptions::loadFromConfigFile(
 
 	MRPT_LOAD_CONFIG_VAR(data_assoc_IC_chi2_thres, double, source, section);
 	MRPT_LOAD_CONFIG_VAR(data_assoc_IC_ml_threshold, double, source, section);
+	MRPT_LOAD_CONFIG_VAR(data_assoc_JCBB_numThreads, int, source, section);
 
 	MRPT_LOAD_CONFIG_VAR(quantiles_3D_representation, float, source, section);
 }
@@ -820,6 +883,9 @@ void CRangeBearingKFSLAM::TOptions::dumpToTextStream(std::ostream& out) const
 	out << mrpt::format(
 		"data_assoc_IC_ml_threshold              = %.06f\n",
 		data_assoc_IC_ml_threshold);
+	out << mrpt::format(
+		"data_assoc_JCBB_numThreads              = %u\n",
+		data_assoc_JCBB_numThreads);
 
 	out << "\n";
 }
@@ -974,7 +1040,9 @@ void CRangeBearingKFSLAM::getAs3DObject(
 	pointGauss.mean.x(m_xkk[0]);
 	pointGauss.mean.y(m_xkk[1]);
 	pointGauss.mean.z(m_xkk[2]);
-	pointGauss.cov = m_pkk.blockCopy<3, 3>(0, 0);
+	KFMatrix_VxV Pxx;
+	getVehicleCov(Pxx);
+	pointGauss.cov = Pxx.blockCopy<3, 3>(0, 0);
 
 	{
 		auto ellip = opengl::CEllipsoid3D::Create();
@@ -1000,10 +1068,7 @@ void CRangeBearingKFSLAM::getAs3DObject(
 		pointGauss.mean.z(
 			m_xkk[get_vehicle_size() + get_feature_size() * i + 2]);
 
-		pointGauss.cov =
-			m_pkk.blockCopy<get_feature_size(), get_feature_size()>(
-				get_vehicle_size() + get_feature_size() * i,
-				get_vehicle_size() + get_feature_size() * i);
+		getLandmarkCov(i, pointGauss.cov);
 
 		auto ellip = opengl::CEllipsoid3D::Create();
 
@@ -1167,7 +1232,8 @@ double CRangeBearingKFSLAM::computeOffDiagonalBlocksApproximationError(
 	MRPT_START
 
 	// Compute the information matrix:
-	CMatrixDynamic<kftype> fullCov(m_pkk);
+	CMatrixDynamic<kftype> fullCov;
+	getStateCovariance(fullCov);
 	size_t i;
 	for (i = 0; i < get_vehicle_size(); i++)
 		fullCov(i, i) = max(fullCov(i, i), 1e-6);
@@ -1262,9 +1328,11 @@ void CRangeBearingKFSLAM::saveMapAndPath2DRepresentationAsMATLABFile(
 	{
 		size_t idx = get_vehicle_size() + i * get_feature_size();
 
-		cov(0, 0) = m_pkk(idx + 0, idx + 0);
-		cov(1, 1) = m_pkk(idx + 1, idx + 1);
-		cov(0, 1) = cov(1, 0) = m_pkk(idx + 0, idx + 1);
+		KFMatrix_FxF Pyy;
+		getLandmarkCov(i, Pyy);
+		cov(0, 0) = Pyy(0, 0);
+		cov(1, 1) = Pyy(1, 1);
+		cov(0, 1) = cov(1, 0) = Pyy(0, 1);
 
 		mean[0] = m_xkk[idx + 0];
 		mean[1] = m_xkk[idx + 1];
@@ -1295,9 +1363,11 @@ void CRangeBearingKFSLAM::saveMapAndPath2DRepresentationAsMATLABFile(
 	}
 
 	// The robot pose:
-	cov(0, 0) = m_pkk(0, 0);
-	cov(1, 1) = m_pkk(1, 1);
-	cov(0, 1) = cov(1, 0) = m_pkk(0, 1);
+	KFMatrix_VxV Pxx;
+	getVehicleCov(Pxx);
+	cov(0, 0) = Pxx(0, 0);
+	cov(1, 1) = Pxx(1, 1);
+	cov(0, 1) = cov(1, 0) = Pxx(0, 1);
 
 	mean[0] = m_xkk[0];
 	mean[1] = m_xkk[1];
@@ -1366,8 +1436,10 @@ void CRangeBearingKFSLAM::OnPreComputingPredictions(
 	const double fov_yaw = obs->fieldOfView_yaw;
 	const double fov_pitch = obs->fieldOfView_pitch;
 
+	KFMatrix_VxV Pxx;
+	getVehicleCov(Pxx);
 	const double max_vehicle_loc_uncertainty =
-		4 * std::sqrt(m_pkk(0, 0) + m_pkk(1, 1) + m_pkk(2, 2));
+		4 * std::sqrt(Pxx(0, 0) + Pxx(1, 1) + Pxx(2, 2));
 #endif
 
 	out_LM_indices_to_predict.clear();
@@ -61,6 +61,16 @@ void CRangeBearingKFSLAM2D::reset()
 	// Initial cov:
 	m_pkk.setSize(3, 3);
 	m_pkk.setZero();
+
+	// CEKF:
+	m_cekfActive = false;
+	m_cekfPendingUpdate = false;
+	m_cekfGlobalXkk.resize(0);
+	m_cekfGlobalPkk.setSize(0, 0);
+	m_cekfIdxA0.clear();
+	m_cekfIdxB.clear();
+	m_cekfLocalToGlobal.clear();
+	m_cekfGlobalToLocal.clear();
 }
 
 /*---------------------------------------------------------------
@@ -81,7 +91,7 @@ void CRangeBearingKFSLAM2D::getCurrentRobotPose(
 	out_robotPose.mean = CPose2D(m_xkk[0], m_xkk[1], m_xkk[2]);
 
 	// and cov:
-	out_robotPose.cov = m_pkk.blockCopy<3, 3>(0, 0);
+	getVehicleCov(out_robotPose.cov);
 
 	MRPT_END
 }
@@ -103,28 +113,30 @@ void CRangeBearingKFSLAM2D::getCurrentState(
 	out_robotPose.mean = CPose2D(m_xkk[0], m_xkk[1], m_xkk[2]);
 
 	// and cov:
-	out_robotPose.cov = m_pkk.blockCopy<3, 3>(0, 0);
+	getVehicleCov(out_robotPose.cov);
+
+	// Full state & cov:
+	if (m_cekfActive) cekfGetFullState(out_fullState, out_fullCovariance);
+	else
+	{
+		out_fullState.resize(m_xkk.size());
+		std::copy(m_xkk.begin(), m_xkk.end(), out_fullState.begin());
+		getStateCovariance(out_fullCovariance);
+	}
 
 	// Landmarks:
-	ASSERT_(((m_xkk.size() - 3) % 2) == 0);
-	size_t i, nLMs = (m_xkk.size() - 3) / 2;
+	ASSERT_(((out_fullState.size() - 3) % 2) == 0);
+	size_t i, nLMs = (out_fullState.size() - 3) / 2;
 	out_landmarksPositions.resize(nLMs);
 	for (i = 0; i < nLMs; i++)
 	{
-		out_landmarksPositions[i].x = m_xkk[3 + i * 2 + 0];
-		out_landmarksPositions[i].y = m_xkk[3 + i * 2 + 1];
+		out_landmarksPositions[i].x = out_fullState[3 + i * 2 + 0];
+		out_landmarksPositions[i].y = out_fullState[3 + i * 2 + 1];
 	}  // end for i
 
 	// IDs:
 	out_landmarkIDs = m_IDs.getInverseMap();  // m_IDs_inverse;
 
-	// Full state:
-	out_fullState.resize(m_xkk.size());
-	std::copy(m_xkk.begin(), m_xkk.end(), out_fullState.begin());
-
-	// Full cov:
-	out_fullCovariance = m_pkk;
-
 	MRPT_END
 }
 
@@ -140,7 +152,56 @@ void CRangeBearingKFSLAM2D::processActionObservation(
 	m_SF = SF;
 
 	// Sanity check:
-	ASSERT_(m_IDs.size() == this->getNumberOfLandmarksInTheMap());
+	ASSERT_(m_IDs.size() == getNumberOfLandmarksInFullMap());
+
+	// Compressed EKF: make sure the local region covers everything the
+	// robot may observe now:
+	if (options.use_compressed_ekf)
+	{
+		ASSERTMSG_(
+			KF_options.method == bayes::kfEKFNaive &&
+				KF_options.backend == bayes::kfbCovariance,
+			"use_compressed_ekf requires KF_options.method=kfEKFNaive and "
+			"KF_options.backend=kfbCovariance");
+
+		const double sensorReach = cekfSensorReach();
+		if (m_cekfActive)
+		{
+			const double distToCenter =
+				(mrpt::math::TPoint2D(m_xkk[0], m_xkk[1]) - m_cekfRegionCenter)
+					.norm();
+			bool leaveRegion =
+				distToCenter + sensorReach > m_cekfRegionLandmarksRadius;
+
+			// Also if a landmark with a known ID is out of the region:
+			CObservationBearingRange::Ptr obs =
+				m_SF->getObservationByClass<CObservationBearingRange>();
+			for (size_t i = 0; !leaveRegion && i < obs->sensedData.size(); i++)
+			{
+				if (obs->sensedData[i].landmarkID < 0) continue;
+				const auto itID = m_IDs.find_key(obs->sensedData[i].landmarkID);
+				if (itID != m_IDs.end() &&
+					landmarkIndexFullToLocal(itID->second) < 0)
+					leaveRegion = true;
+			}
+			if (leaveRegion) cekfFlush();
+		}
+		if (!m_cekfActive) cekfStartRegion(sensorReach);
+
+		// Prediction of the cross-covariances with the passive landmarks:
+		// P_AB <- F * P_AB, with F the transition Jacobian for the robot and
+		// the identity for the landmarks.
+		if (!m_IDs.empty())
+		{
+			KFMatrix_VxV F;
+			OnTransitionJacobian(F);
+			auto Phi = m_cekfPhi.asEigen();
+			Phi.topRows(get_vehicle_size()) =
+				(F.asEigen() * Phi.topRows(get_vehicle_size())).eval();
+		}
+	}
+	else if (m_cekfActive)
+		cekfFlush();
 
 	// ===================================================================================================================
 	// Here's the meat!: Call the main method for the KF algorithm, which will
@@ -205,7 +266,7 @@ void CRangeBearingKFSLAM2D::OnTransitionModel(
 	// landmakrs in the map,
 	// otherwise, we are imposing a lower bound to the best uncertainty from now
 	// on:
-	if (size_t(m_xkk.size()) == get_vehicle_size())
+	if (m_IDs.empty())
 	{
 		out_skipPrediction = true;
 		return;
@@ -381,112 +442,159 @@ void CRangeBearingKFSLAM2D::OnObservationModel(
 	MRPT_END
 }
 
-void CRangeBearingKFSLAM2D::OnObservationJacobians(
-	size_t idx_landmark_to_predict, KFMatrix_OxV& Hx, KFMatrix_OxF& Hy) const
+namespace
 {
-	MRPT_START
+/* -------------------------------------------
+   Equations, obtained using matlab, of the relative 2D position of a
+  landmark (xi,yi), relative
+	  to a robot 2D pose (x0,y0,phi)
+	Refer to technical report "6D EKF derivation...", 2008
+
+	x0 y0 phi0         % Robot's 2D pose
+	x0s y0s phis      % Sensor's 2D pose relative to robot
+	xi yi             % Absolute 2D landmark coordinates:
+
+	Hx : dh_dxv   -> Jacobian of the observation model wrt the robot pose
+	Hy : dh_dyi   -> Jacobian of the observation model wrt each landmark
+  mean position
+
+	Sizes:
+	 h:  1x2
+	 Hx: 2x3
+	 Hy: 2x2
+  ------------------------------------------- */
+// The terms which only depend on the robot and sensor poses, shared by the
+// Jacobians of all the landmarks:
+struct TObsJacobianTerms
+{
+	using kftype = CRangeBearingKFSLAM2D::kftype;
+
+	TObsJacobianTerms(const kftype* xv, const CPose2D& sensorPoseOnRobot)
+		: x0(xv[0]),
+		  y0(xv[1]),
+		  cphi0(cos(xv[2])),
+		  sphi0(sin(xv[2])),
+		  x0s(sensorPoseOnRobot.x()),
+		  y0s(sensorPoseOnRobot.y()),
+		  cphis(cos(sensorPoseOnRobot.phi())),
+		  sphis(sin(sensorPoseOnRobot.phi())),
+		  cphi0s(cos(xv[2] + sensorPoseOnRobot.phi())),
+		  sphi0s(sin(xv[2] + sensorPoseOnRobot.phi()))
+	{
+	}
 
-	// Get the sensor pose relative to the robot:
+	void eval(
+		const kftype xi, const kftype yi,
+		CRangeBearingKFSLAM2D::KFMatrix_OxV& Hx,
+		CRangeBearingKFSLAM2D::KFMatrix_OxF& Hy) const
+	{
+		// ---------------------------------------------------
+		// Generate dhi_dxv: A 2x3 block
+		// ---------------------------------------------------
+		const kftype EXP1 = -2 * yi * y0s * cphi0 - 2 * yi * y0 +
+			2 * xi * y0s * sphi0 - 2 * xi * x0 - 2 * xi * x0s * cphi0 -
+			2 * yi * x0s * sphi0 + 2 * y0s * y0 * cphi0 -
+			2 * y0s * x0 * sphi0 + 2 * y0 * x0s * sphi0 + square(x0) +
+			2 * x0s * x0 * cphi0 + square(x0s) + square(y0s) + square(xi) +
+			square(yi) + square(y0);
+		const kftype sqrtEXP1_1 = kftype(1) / sqrt(EXP1);
+
+		const kftype EXP2 = cphi0s * xi + sphi0s * yi - sphis * y0s -
+			y0 * sphi0s - x0s * cphis - x0 * cphi0s;
+		const kftype EXP2sq = square(EXP2);
+
+		const kftype EXP3 = -sphi0s * xi + cphi0s * yi - cphis * y0s -
+			y0 * cphi0s + x0s * sphis + x0 * sphi0s;
+		const kftype EXP3sq = square(EXP3);
+
+		const kftype EXP4 = kftype(1) / (1 + EXP3sq / EXP2sq);
+
+		Hx(0, 0) = (-xi - sphi0 * y0s + cphi0 * x0s + x0) * sqrtEXP1_1;
+		Hx(0, 1) = (-yi + cphi0 * y0s + y0 + sphi0 * x0s) * sqrtEXP1_1;
+		Hx(0, 2) = (y0s * xi * cphi0 + y0s * yi * sphi0 - y0 * y0s * sphi0 -
+					x0 * y0s * cphi0 + x0s * xi * sphi0 - x0s * yi * cphi0 +
+					y0 * x0s * cphi0 - x0s * x0 * sphi0) *
+			sqrtEXP1_1;
+
+		Hx(1, 0) = (sphi0s / (EXP2) + (EXP3) / EXP2sq * cphi0s) * EXP4;
+		Hx(1, 1) = (-cphi0s / (EXP2) + (EXP3) / EXP2sq * sphi0s) * EXP4;
+		Hx(1, 2) =
+			((-cphi0s * xi - sphi0s * yi + y0 * sphi0s + x0 * cphi0s) /
+				 (EXP2) -
+			 (EXP3) / EXP2sq *
+				 (-sphi0s * xi + cphi0s * yi - y0 * cphi0s + x0 * sphi0s)) *
+			EXP4;
+
+		// ---------------------------------------------------
+		// Generate dhi_dyi: A 2x2 block
+		// ---------------------------------------------------
+		Hy(0, 0) = (xi + sphi0 * y0s - cphi0 * x0s - x0) * sqrtEXP1_1;
+		Hy(0, 1) = (yi - cphi0 * y0s - y0 - sphi0 * x0s) * sqrtEXP1_1;
+
+		Hy(1, 0) = (-sphi0s / (EXP2) - (EXP3) / EXP2sq * cphi0s) * EXP4;
+		Hy(1, 1) = (cphi0s / (EXP2) - (EXP3) / EXP2sq * sphi0s) * EXP4;
+	}
+
+	// Robot 2D pose:
+	const kftype x0, y0, cphi0, sphi0;
+	// Sensor 2D pose on robot:
+	const kftype x0s, y0s, cphis, sphis;
+	const kftype cphi0s, sphi0s;
+};
+
+// Get the sensor pose relative to the robot:
+CPose2D getSensorPoseOnRobot(const CSensoryFrame& sf)
+{
 	CObservationBearingRange::Ptr obs =
-		m_SF->getObservationByClass<CObservationBearingRange>();
+		sf.getObservationByClass<CObservationBearingRange>();
 	ASSERTMSG_(
 		obs,
 		"*ERROR*: This method requires an observation of type "
 		"CObservationBearingRange");
-	const CPose2D sensorPoseOnRobot = CPose2D(obs->sensorLocationOnRobot);
-
-	/* -------------------------------------------
-	   Equations, obtained using matlab, of the relative 2D position of a
-	  landmark (xi,yi), relative
-		  to a robot 2D pose (x0,y0,phi)
-		Refer to technical report "6D EKF derivation...", 2008
-
-		x0 y0 phi0         % Robot's 2D pose
-		x0s y0s phis      % Sensor's 2D pose relative to robot
-		xi yi             % Absolute 2D landmark coordinates:
-
-		Hx : dh_dxv   -> Jacobian of the observation model wrt the robot pose
-		Hy : dh_dyi   -> Jacobian of the observation model wrt each landmark
-	  mean position
-
-		Sizes:
-		 h:  1x2
-		 Hx: 2x3
-		 Hy: 2x2
-	  ------------------------------------------- */
-	// Mean of the prior of the robot pose:
-	const CPose2D robotPose(m_xkk[0], m_xkk[1], m_xkk[2]);
-
-	const size_t vehicle_size = get_vehicle_size();
-	const size_t feature_size = get_feature_size();
-
-	// Robot 6D pose:
-	const kftype x0 = m_xkk[0];
-	const kftype y0 = m_xkk[1];
-	const kftype phi0 = m_xkk[2];
+	return CPose2D(obs->sensorLocationOnRobot);
+}
+}  // namespace
 
-	const kftype cphi0 = cos(phi0);
-	const kftype sphi0 = sin(phi0);
+void CRangeBearingKFSLAM2D::OnObservationJacobians(
+	size_t idx_landmark_to_predict, KFMatrix_OxV& Hx, KFMatrix_OxF& Hy) const
+{
+	MRPT_START
 
-	// Sensor 2D pose on robot:
-	const kftype x0s = sensorPoseOnRobot.x();
-	const kftype y0s = sensorPoseOnRobot.y();
-	const kftype phis = sensorPoseOnRobot.phi();
+	const size_t lm_idx_in_statevector = get_vehicle_size() +
+		get_feature_size() * idx_landmark_to_predict;
 
-	const kftype cphi0s = cos(phi0 + phis);
-	const kftype sphi0s = sin(phi0 + phis);
+	TObsJacobianTerms(&m_xkk[0], getSensorPoseOnRobot(*m_SF))
+		.eval(
+			m_xkk[lm_idx_in_statevector + 0], m_xkk[lm_idx_in_statevector + 1],
+			Hx, Hy);
 
-	const CPose2D sensorPoseAbs = robotPose + sensorPoseOnRobot;
+	MRPT_END
+}
 
-	// Landmark absolute position in the map:
-	const kftype xi =
-		m_xkk[vehicle_size + feature_size * idx_landmark_to_predict + 0];
-	const kftype yi =
-		m_xkk[vehicle_size + feature_size * idx_landmark_to_predict + 1];
+void CRangeBearingKFSLAM2D::OnObservationJacobiansBatch(
+	const std::vector<size_t>& idx_landmarks_to_predict,
+	std::vector<KFMatrix_OxV>& out_Hx, std::vector<KFMatrix_OxF>& out_Hy) const
+{
+	MRPT_START
 
-	// ---------------------------------------------------
-	// Generate dhi_dxv: A 2x3 block
-	// ---------------------------------------------------
-	const kftype EXP1 = -2 * yi * y0s * cphi0 - 2 * yi * y0 +
-		2 * xi * y0s * sphi0 - 2 * xi * x0 - 2 * xi * x0s * cphi0 -
-		2 * yi * x0s * sphi0 + 2 * y0s * y0 * cphi0 - 2 * y0s * x0 * sphi0 +
-		2 * y0 * x0s * sphi0 + square(x0) + 2 * x0s * x0 * cphi0 + square(x0s) +
-		square(y0s) + square(xi) + square(yi) + square(y0);
-	const kftype sqrtEXP1_1 = kftype(1) / sqrt(EXP1);
-
-	const kftype EXP2 = cphi0s * xi + sphi0s * yi - sin(phis) * y0s -
-		y0 * sphi0s - x0s * cos(phis) - x0 * cphi0s;
-	const kftype EXP2sq = square(EXP2);
-
-	const kftype EXP3 = -sphi0s * xi + cphi0s * yi - cos(phis) * y0s -
-		y0 * cphi0s + x0s * sin(phis) + x0 * sphi0s;
-	const kftype EXP3sq = square(EXP3);
-
-	const kftype EXP4 = kftype(1) / (1 + EXP3sq / EXP2sq);
-
-	Hx(0, 0) = (-xi - sphi0 * y0s + cphi0 * x0s + x0) * sqrtEXP1_1;
-	Hx(0, 1) = (-yi + cphi0 * y0s + y0 + sphi0 * x0s) * sqrtEXP1_1;
-	Hx(0, 2) = (y0s * xi * cphi0 + y0s * yi * sphi0 - y0 * y0s * sphi0 -
-				x0 * y0s * cphi0 + x0s * xi * sphi0 - x0s * yi * cphi0 +
-				y0 * x0s * cphi0 - x0s * x0 * sphi0) *
-		sqrtEXP1_1;
-
-	Hx(1, 0) = (sphi0s / (EXP2) + (EXP3) / EXP2sq * cphi0s) * EXP4;
-	Hx(1, 1) = (-cphi0s / (EXP2) + (EXP3) / EXP2sq * sphi0s) * EXP4;
-	Hx(1, 2) =
-		((-cphi0s * xi - sphi0s * yi + y0 * sphi0s + x0 * cphi0s) / (EXP2) -
-		 (EXP3) / EXP2sq *
-			 (-sphi0s * xi + cphi0s * yi - y0 * cphi0s + x0 * sphi0s)) *
-		EXP4;
+	const size_t N = idx_landmarks_to_predict.size();
+	out_Hx.resize(N);
+	out_Hy.resize(N);
 
-	// ---------------------------------------------------
-	// Generate dhi_dyi: A 2x2 block
-	// ---------------------------------------------------
-	Hy(0, 0) = (xi + sphi0 * y0s - cphi0 * x0s - x0) * sqrtEXP1_1;
-	Hy(0, 1) = (yi - cphi0 * y0s - y0 - sphi0 * x0s) * sqrtEXP1_1;
+	// The sensor pose, and its trigonometric terms, only once for all the
+	// landmarks:
+	const TObsJacobianTerms terms(&m_xkk[0], getSensorPoseOnRobot(*m_SF));
 
-	Hy(1, 0) = (-sphi0s / (EXP2) - (EXP3) / EXP2sq * cphi0s) * EXP4;
-	Hy(1, 1) = (cphi0s / (EXP2) - (EXP3) / EXP2sq * sphi0s) * EXP4;
+	const size_t vehicle_size = get_vehicle_size();
+	const size_t feature_size = get_feature_size();
+	for (size_t i = 0; i < N; i++)
+	{
+		const size_t lm_idx_in_statevector =
+			vehicle_size + feature_size * idx_landmarks_to_predict[i];
+		terms.eval(
+			m_xkk[lm_idx_in_statevector + 0], m_xkk[lm_idx_in_statevector + 1],
+			out_Hx[i], out_Hy[i]);
+	}
 
 	MRPT_END
 }
@@ -569,9 +677,12 @@ void CRangeBearingKFSLAM2D::OnGetObservationsAndDataAssociation(
 				mrpt::containers::bimap<
 					CLandmark::TLandmarkID, unsigned int>::iterator itID;
 				if ((itID = m_IDs.find_key(itObs->landmarkID)) != m_IDs.end())
-					*itDA = itID->second;  // This row in Z corresponds to the
-				// i'th map element in the state
-				// vector:
+				{
+					// This row in Z corresponds to the i'th map element in
+					// the state vector:
+					*itDA = landmarkIndexFullToLocal(itID->second);
+					ASSERTDEB_(*itDA >= 0);
+				}
 			}
 		}
 	}
@@ -589,7 +700,7 @@ void CRangeBearingKFSLAM2D::OnGetObservationsAndDataAssociation(
 			int da = data_association[idxObs];
 			if (da >= 0)
 				m_last_data_association.results.associations[idxObs] =
-					data_association[idxObs];
+					landmarkIndexLocalToFull(da);
 		}
 
 #if STATS_EXPERIMENT  // DEBUG: Generate statistic info
@@ -671,8 +782,9 @@ void CRangeBearingKFSLAM2D::OnGetObservationsAndDataAssociation(
 			for (size_t w = 0; w < obs_size; w++)
 				m_last_data_association.Y_pred_means(q, w) =
 					all_predictions[i][w];
+			// for the conversion of indices...
 			m_last_data_association.predictions_IDs.push_back(
-				i);	 // for the conversion of indices...
+				landmarkIndexLocalToFull(i));
 		}
 
 		// Do Dat. Assoc :
@@ -690,16 +802,21 @@ void CRangeBearingKFSLAM2D::OnGetObservationsAndDataAssociation(
 				true,  // Use KD-tree
 				m_last_data_association.predictions_IDs,
 				options.data_assoc_IC_metric,
-				options.data_assoc_IC_ml_threshold);
+				options.data_assoc_IC_ml_threshold,
+				options.data_assoc_JCBB_numThreads);
 
 			// Return pairings to the main KF algorithm:
 			for (auto it = m_last_data_association.results.associations.begin();
 				 it != m_last_data_association.results.associations.end(); ++it)
-				data_association[it->first] = it->second;
+				data_association[it->first] =
+					landmarkIndexFullToLocal(it->second);
 		}
 	}
 	// ---- End of data association ----
 
+	if (m_cekfActive)
+		cekfPrepareUpdate(Z, data_association, all_predictions, R);
+
 	MRPT_END
 }
 
@@ -752,6 +869,10 @@ void CRangeBearingKFSLAM2D::TOptions::loadFromConfigFile(
 
 	MRPT_LOAD_CONFIG_VAR(data_assoc_IC_chi2_thres, double, source, section);
 	MRPT_LOAD_CONFIG_VAR(data_assoc_IC_ml_threshold, double, source, section);
+	MRPT_LOAD_CONFIG_VAR(data_assoc_JCBB_numThreads, int, source, section);
+
+	MRPT_LOAD_CONFIG_VAR(use_compressed_ekf, bool, source, section);
+	MRPT_LOAD_CONFIG_VAR(compressed_ekf_region_radius, double, source, section);
 }
 
 /*---------------------------------------------------------------
@@ -795,6 +916,15 @@ void CRangeBearingKFSLAM2D::TOptions::dumpToTextStream(std::ostream& out) const
 	out << mrpt::format(
 		"data_assoc_IC_ml_threshold              = %.06f\n",
 		data_assoc_IC_ml_threshold);
+	out << mrpt::format(
+		"data_assoc_JCBB_numThreads              = %u\n",
+		data_assoc_JCBB_numThreads);
+	out << mrpt::format(
+		"use_compressed_ekf                      = %c\n",
+		use_compressed_ekf ? 'Y' : 'N');
+	out << mrpt::format(
+		"compressed_ekf_region_radius            = %.03f\n",
+		compressed_ekf_region_radius);
 
 	out << "\n";
 }
@@ -900,23 +1030,55 @@ void CRangeBearingKFSLAM2D::OnNewLandmarkAddedToMap(
 		"*ERROR*: This method requires an observation of type "
 		"CObservationBearingRange");
 
+	ASSERT_(in_obsIdx < obs->sensedData.size());
+
+	// Index of the new landmark in the full map:
+	size_t idxInFullMap = in_idxNewFeat;
+
+	if (m_cekfActive)
+	{
+		// New landmarks join the local region. Their cross-covariance with
+		// the passive landmarks is dyn_dxv * P_xB, so extend Phi with
+		// dyn_dxv * Phi_x. This uses the state after the update:
+		cekfCommitUpdate();
+
+		KFArray_OBS z;
+		z[0] = obs->sensedData[in_obsIdx].range;
+		z[1] = obs->sensedData[in_obsIdx].yaw;
+		KFArray_FEAT yn;
+		KFMatrix_FxV dyn_dxv;
+		KFMatrix_FxO dyn_dhn;
+		OnInverseObservationModel(z, yn, dyn_dxv, dyn_dhn);
+
+		const size_t nRows = m_cekfPhi.rows();
+		ASSERT_EQUAL_(nRows, m_xkk.size());
+		m_cekfPhi.setSize(nRows + get_feature_size(), m_cekfPhi.cols());
+		m_cekfPhi.asEigen().bottomRows(get_feature_size()) =
+			dyn_dxv.asEigen() *
+			m_cekfPhi.asEigen().topRows(get_vehicle_size());
+
+		idxInFullMap = m_cekfGlobalToLocal.size();
+		ASSERT_EQUAL_(in_idxNewFeat, m_cekfLocalToGlobal.size());
+		m_cekfGlobalToLocal.push_back(static_cast<int>(in_idxNewFeat));
+		m_cekfLocalToGlobal.push_back(idxInFullMap);
+	}
+
 	// ----------------------------------------------
 	// introduce in the lists of ID<->index in map:
 	// ----------------------------------------------
-	ASSERT_(in_obsIdx < obs->sensedData.size());
 	if (obs->sensedData[in_obsIdx].landmarkID >= 0)
 	{
 		// The sensor provides us a LM ID... use it:
-		m_IDs.insert(obs->sensedData[in_obsIdx].landmarkID, in_idxNewFeat);
+		m_IDs.insert(obs->sensedData[in_obsIdx].landmarkID, idxInFullMap);
 	}
 	else
 	{
 		// Features do not have IDs... use indices:
-		m_IDs.insert(in_idxNewFeat, in_idxNewFeat);
+		m_IDs.insert(idxInFullMap, idxInFullMap);
 	}
 
 	m_last_data_association.newly_inserted_landmarks[in_obsIdx] =
-		in_idxNewFeat;	// Just for stats, etc...
+		idxInFullMap;  // Just for stats, etc...
 
 	MRPT_END
 }
@@ -938,7 +1100,9 @@ void CRangeBearingKFSLAM2D::getAs3DObject(
 	CPoint2DPDFGaussian pointGauss;
 	pointGauss.mean.x(m_xkk[0]);
 	pointGauss.mean.y(m_xkk[1]);
-	pointGauss.cov = m_pkk.blockCopy<2, 2>(0, 0);
+	KFMatrix_VxV Pxx;
+	getVehicleCov(Pxx);
+	pointGauss.cov = Pxx.blockCopy<2, 2>(0, 0);
 
 	{
 		auto ellip = opengl::CEllipsoid2D::Create();
@@ -953,12 +1117,14 @@ void CRangeBearingKFSLAM2D::getAs3DObject(
 	}
 
 	// 2D ellipsoids for landmarks:
-	const size_t nLMs = (m_xkk.size() - 3) / 2;
+	const size_t nLMs = getNumberOfLandmarksInFullMap();
 	for (size_t i = 0; i < nLMs; i++)
 	{
-		pointGauss.mean.x(m_xkk[3 + 2 * i + 0]);
-		pointGauss.mean.y(m_xkk[3 + 2 * i + 1]);
-		pointGauss.cov = m_pkk.blockCopy<2, 2>(3 + 2 * i, 3 + 2 * i);
+		KFArray_FEAT lm;
+		getLandmarkMean(i, lm);
+		pointGauss.mean.x(lm[0]);
+		pointGauss.mean.y(lm[1]);
+		getLandmarkCov(i, pointGauss.cov);
 
 		auto ellip = opengl::CEllipsoid2D::Create();
 
@@ -1012,18 +1178,20 @@ void CRangeBearingKFSLAM2D::saveMapAndPath2DRepresentationAsMATLABFile(
 	// Main code:
 	os::fprintf(f, "hold on;\n\n");
 
-	size_t i, nLMs = (m_xkk.size() - get_vehicle_size()) / get_feature_size();
+	size_t i, nLMs = getNumberOfLandmarksInFullMap();
 
 	for (i = 0; i < nLMs; i++)
 	{
-		size_t idx = get_vehicle_size() + i * get_feature_size();
-
-		cov(0, 0) = m_pkk(idx + 0, idx + 0);
-		cov(1, 1) = m_pkk(idx + 1, idx + 1);
-		cov(0, 1) = cov(1, 0) = m_pkk(idx + 0, idx + 1);
+		KFArray_FEAT lm;
+		KFMatrix_FxF Pyy;
+		getLandmarkMean(i, lm);
+		getLandmarkCov(i, Pyy);
+		cov(0, 0) = Pyy(0, 0);
+		cov(1, 1) = Pyy(1, 1);
+		cov(0, 1) = cov(1, 0) = Pyy(0, 1);
 
-		mean[0] = m_xkk[idx + 0];
-		mean[1] = m_xkk[idx + 1];
+		mean[0] = lm[0];
+		mean[1] = lm[1];
 
 		// Command to draw the 2D ellipse:
 		os::fprintf(
@@ -1052,9 +1220,11 @@ void CRangeBearingKFSLAM2D::saveMapAndPath2DRepresentationAsMATLABFile(
 	}
 
 	// The robot pose:
-	cov(0, 0) = m_pkk(0, 0);
-	cov(1, 1) = m_pkk(1, 1);
-	cov(0, 1) = cov(1, 0) = m_pkk(0, 1);
+	KFMatrix_VxV Pxx;
+	getVehicleCov(Pxx);
+	cov(0, 0) = Pxx(0, 0);
+	cov(1, 1) = Pxx(1, 1);
+	cov(0, 1) = cov(1, 0) = Pxx(0, 1);
 
 	mean[0] = m_xkk[0];
 	mean[1] = m_xkk[1];
@@ -1118,9 +1288,11 @@ void CRangeBearingKFSLAM2D::OnPreComputingPredictions(
 	const double sensor_max_range = obs->maxSensorDistance;
 	const double fov_yaw = obs->fieldOfView_yaw;
 
+	KFMatrix_VxV Pxx;
+	getVehicleCov(Pxx);
 	const double max_vehicle_loc_uncertainty =
-		4 * std::sqrt(m_pkk(0, 0) + m_pkk(1, 1));
-	const double max_vehicle_ang_uncertainty = 4 * std::sqrt(m_pkk(2, 2));
+		4 * std::sqrt(Pxx(0, 0) + Pxx(1, 1));
+	const double max_vehicle_ang_uncertainty = 4 * std::sqrt(Pxx(2, 2));
 
 	out_LM_indices_to_predict.clear();
 	for (size_t i = 0; i < prediction_means.size(); i++)
@@ -1162,3 +1334,325 @@ void CRangeBearingKFSLAM2D::OnObservationJacobiansNumericGetIncrements(
 	for (size_t i = 0; i < get_feature_size(); i++)
 		out_feat_increments[i] = 1e-6;
 }
+
+void CRangeBearingKFSLAM2D::OnPostIteration() { cekfCommitUpdate(); }
+
+void CRangeBearingKFSLAM2D::getLandmarkMean(
+	size_t idx, KFArray_FEAT& feat) const
+{
+	ASSERT_LT_(idx, getNumberOfLandmarksInFullMap());
+	const int localIdx = landmarkIndexFullToLocal(idx);
+	if (localIdx >= 0)
+	{
+		KFCLASS::getLandmarkMean(localIdx, feat);
+		return;
+	}
+	// Passive landmark: x_B = x_B0 + P_BA0 * beta
+	const size_t nA0 = m_cekfIdxA0.size();
+	for (size_t k = 0; k < get_feature_size(); k++)
+	{
+		const size_t r = get_vehicle_size() + idx * get_feature_size() + k;
+		kftype v = m_cekfGlobalXkk[r];
+		for (size_t c = 0; c < nA0; c++)
+			v += m_cekfGlobalPkk(r, m_cekfIdxA0[c]) * m_cekfBeta[c];
+		feat[k] = v;
+	}
+}
+
+void CRangeBearingKFSLAM2D::getLandmarkCov(
+	size_t idx, KFMatrix_FxF& feat_cov) const
+{
+	ASSERT_LT_(idx, getNumberOfLandmarksInFullMap());
+	const int localIdx = landmarkIndexFullToLocal(idx);
+	if (localIdx >= 0)
+	{
+		KFCLASS::getLandmarkCov(localIdx, feat_cov);
+		return;
+	}
+	// Passive landmark: P_BB = P_BB0 - P_BA0 * Psi * P_A0B
+	const size_t off = get_vehicle_size() + idx * get_feature_size();
+	const size_t nA0 = m_cekfIdxA0.size();
+	Eigen::MatrixXd P_BA0(get_feature_size(), nA0);
+	for (size_t r = 0; r < get_feature_size(); r++)
+		for (size_t c = 0; c < nA0; c++)
+			P_BA0(r, c) = m_cekfGlobalPkk(off + r, m_cekfIdxA0[c]);
+
+	constexpr size_t F = get_feature_size();
+	feat_cov = m_cekfGlobalPkk.blockCopy<F, F>(off, off);
+	feat_cov.asEigen() -=
+		P_BA0 * m_cekfPsi.asEigen() * P_BA0.transpose();
+}
+
+size_t CRangeBearingKFSLAM2D::getNumberOfLandmarksInFullMap() const
+{
+	return m_cekfActive ? m_cekfGlobalToLocal.size()
+						: getNumberOfLandmarksInTheMap();
+}
+
+int CRangeBearingKFSLAM2D::landmarkIndexFullToLocal(size_t idx) const
+{
+	if (!m_cekfActive) return static_cast<int>(idx);
+	ASSERT_LT_(idx, m_cekfGlobalToLocal.size());
+	return m_cekfGlobalToLocal[idx];
+}
+
+size_t CRangeBearingKFSLAM2D::landmarkIndexLocalToFull(size_t idx) const
+{
+	if (!m_cekfActive) return idx;
+	ASSERT_LT_(idx, m_cekfLocalToGlobal.size());
+	return m_cekfLocalToGlobal[idx];
+}
+
+double CRangeBearingKFSLAM2D::cekfSensorReach() const
+{
+	CObservationBearingRange::Ptr obs =
+		m_SF->getObservationByClass<CObservationBearingRange>();
+	ASSERTMSG_(
+		obs,
+		"*ERROR*: This method requires an observation of type "
+		"CObservationBearingRange");
+
+	double maxRange = obs->maxSensorDistance;
+	for (const auto& m : obs->sensedData)
+		maxRange = std::max<double>(maxRange, m.range);
+
+	return maxRange + obs->sensorLocationOnRobot.norm() +
+		4 * std::sqrt(m_pkk(0, 0) + m_pkk(1, 1)) +
+		4 * options.std_sensor_range;
+}
+
+void CRangeBearingKFSLAM2D::cekfStartRegion(double sensorReach)
+{
+	MRPT_START
+	ASSERT_(!m_cekfActive);
+
+	constexpr size_t V = get_vehicle_size(), F = get_feature_size();
+
+	// The full map becomes the fixed reference for the region:
+	std::swap(m_cekfGlobalXkk, m_xkk);
+	std::swap(m_cekfGlobalPkk, m_pkk);
+	const auto& gx = m_cekfGlobalXkk;
+	const auto& gP = m_cekfGlobalPkk;
+
+	const size_t nLMs = (gx.size() - V) / F;
+
+	m_cekfRegionCenter = mrpt::math::TPoint2D(gx[0], gx[1]);
+	m_cekfRegionLandmarksRadius =
+		options.compressed_ekf_region_radius + sensorReach;
+
+	// Select the active landmarks:
+	m_cekfLocalToGlobal.clear();
+	m_cekfGlobalToLocal.assign(nLMs, -1);
+	m_cekfIdxA0.clear();
+	m_cekfIdxB.clear();
+	for (size_t k = 0; k < V; k++)
+		m_cekfIdxA0.push_back(k);
+
+	for (size_t i = 0; i < nLMs; i++)
+	{
+		const size_t off = V + F * i;
+		const double d =
+			(mrpt::math::TPoint2D(gx[off], gx[off + 1]) - m_cekfRegionCenter)
+				.norm();
+		auto& idxs = d <= m_cekfRegionLandmarksRadius ? m_cekfIdxA0
+													  : m_cekfIdxB;
+		if (d <= m_cekfRegionLandmarksRadius)
+		{
+			m_cekfGlobalToLocal[i] =
+				static_cast<int>(m_cekfLocalToGlobal.size());
+			m_cekfLocalToGlobal.push_back(i);
+		}
+		for (size_t k = 0; k < F; k++)
+			idxs.push_back(off + k);
+	}
+
+	// Local state:
+	const size_t nA = m_cekfIdxA0.size();
+	m_xkk.resize(nA);
+	m_pkk.setSize(nA, nA);
+	for (size_t r = 0; r < nA; r++)
+	{
+		m_xkk[r] = gx[m_cekfIdxA0[r]];
+		for (size_t c = 0; c < nA; c++)
+			m_pkk(r, c) = gP(m_cekfIdxA0[r], m_cekfIdxA0[c]);
+	}
+
+	m_cekfPhi.setSize(nA, nA);
+	m_cekfPhi.setIdentity();
+	m_cekfPsi.setSize(nA, nA);
+	m_cekfPsi.setZero();
+	m_cekfBeta.resize(nA);
+	m_cekfBeta.setZero();
+	m_cekfPendingUpdate = false;
+	m_cekfActive = true;
+
+	MRPT_LOG_DEBUG_FMT(
+		"[CEKF] New local region with %u/%u landmarks",
+		static_cast<unsigned int>(m_cekfLocalToGlobal.size()),
+		static_cast<unsigned int>(nLMs));
+
+	MRPT_END
+}
+
+void CRangeBearingKFSLAM2D::cekfFlush()
+{
+	MRPT_START
+	ASSERT_(m_cekfActive);
+	ASSERT_(!m_cekfPendingUpdate);
+
+	KFVector x;
+	KFMatrix P;
+	cekfGetFullState(x, P);
+	std::swap(m_xkk, x);
+	std::swap(m_pkk, P);
+
+	m_cekfActive = false;
+	m_cekfGlobalXkk.resize(0);
+	m_cekfGlobalPkk.setSize(0, 0);
+
+	MRPT_END
+}
+
+void CRangeBearingKFSLAM2D::cekfGetFullState(KFVector& x, KFMatrix& P) const
+{
+	MRPT_START
+	ASSERT_(m_cekfActive);
+
+	constexpr size_t V = get_vehicle_size(), F = get_feature_size();
+
+	const size_t D = V + F * m_cekfGlobalToLocal.size();
+	const size_t nA = m_xkk.size(), nA0 = m_cekfIdxA0.size(),
+				 nB = m_cekfIdxB.size();
+	const auto& gx = m_cekfGlobalXkk;
+	const auto& gP = m_cekfGlobalPkk;
+
+	// Indices in the full state of the local state entries:
+	std::vector<size_t> idxA(nA);
+	for (size_t k = 0; k < V; k++)
+		idxA[k] = k;
+	for (size_t i = 0; i < m_cekfLocalToGlobal.size(); i++)
+		for (size_t k = 0; k < F; k++)
+			idxA[V + F * i + k] = V + F * m_cekfLocalToGlobal[i] + k;
+
+	Eigen::MatrixXd P_BA0(nB, nA0);
+	for (size_t r = 0; r < nB; r++)
+		for (size_t c = 0; c < nA0; c++)
+			P_BA0(r, c) = gP(m_cekfIdxB[r], m_cekfIdxA0[c]);
+
+	// Mean:
+	x.resize(D);
+	for (size_t r = 0; r < nA; r++)
+		x[idxA[r]] = m_xkk[r];
+	const Eigen::VectorXd dxB = P_BA0 * m_cekfBeta.asEigen();
+	for (size_t r = 0; r < nB; r++)
+		x[m_cekfIdxB[r]] = gx[m_cekfIdxB[r]] + dxB[r];
+
+	// Covariance:
+	P.setSize(D, D);
+	for (size_t r = 0; r < nA; r++)
+		for (size_t c = 0; c < nA; c++)
+			P(idxA[r], idxA[c]) = m_pkk(r, c);
+
+	const Eigen::MatrixXd P_AB = m_cekfPhi.asEigen() * P_BA0.transpose();
+	for (size_t r = 0; r < nA; r++)
+		for (size_t c = 0; c < nB; c++)
+			P(idxA[r], m_cekfIdxB[c]) = P(m_cekfIdxB[c], idxA[r]) = P_AB(r, c);
+
+	const Eigen::MatrixXd dP_BB =
+		(P_BA0 * m_cekfPsi.asEigen()) * P_BA0.transpose();
+	for (size_t r = 0; r < nB; r++)
+		for (size_t c = 0; c < nB; c++)
+			P(m_cekfIdxB[r], m_cekfIdxB[c]) =
+				gP(m_cekfIdxB[r], m_cekfIdxB[c]) - dP_BB(r, c);
+
+	MRPT_END
+}
+
+void CRangeBearingKFSLAM2D::cekfPrepareUpdate(
+	const vector_KFArray_OBS& Z, const std::vector<int>& data_association,
+	const vector_KFArray_OBS& all_predictions, const KFMatrix_OxO& R)
+{
+	MRPT_START
+
+	// This may be called more than once per KF iteration: the last call
+	// prevails.
+	m_cekfPendingUpdate = false;
+
+	constexpr size_t V = get_vehicle_size(), F = get_feature_size(),
+					 O = get_observation_size();
+
+	std::vector<size_t> obsIdxs;
+	for (size_t i = 0; i < data_association.size(); i++)
+		if (data_association[i] >= 0) obsIdxs.push_back(i);
+	const size_t M = obsIdxs.size();
+	if (!M) return;
+
+	const size_t nA = m_xkk.size(), nA0 = m_cekfPhi.cols();
+	const auto P = m_pkk.asEigen();
+	const auto Phi = m_cekfPhi.asEigen();
+
+	// Same linearization than the EKF update in CKalmanFilterCapable: with
+	// H the observation Jacobian, S = H*P*H^t + R and nu the innovation:
+	//  Psi  <- Psi  + (H*Phi)^t * S^-1 * (H*Phi)
+	//  beta <- beta + (H*Phi)^t * S^-1 * nu
+	//  Phi  <- Phi  - K * (H*Phi),  K = P*H^t*S^-1
+	std::vector<size_t> lms(M), offs(M);
+	for (size_t k = 0; k < M; k++)
+	{
+		lms[k] = static_cast<size_t>(data_association[obsIdxs[k]]);
+		offs[k] = V + F * lms[k];
+	}
+	std::vector<KFMatrix_OxV> Hxs;
+	std::vector<KFMatrix_OxF> Hys;
+	OnObservationJacobiansBatch(lms, Hxs, Hys);
+
+	Eigen::MatrixXd PHt(nA, O * M), HPhi(O * M, nA0);
+	Eigen::VectorXd nu(O * M);
+	for (size_t k = 0; k < M; k++)
+	{
+		const auto Hx = Hxs[k].asEigen();
+		const auto Hy = Hys[k].asEigen();
+
+		PHt.middleCols(O * k, O) = P.leftCols(V) * Hx.transpose() +
+			P.middleCols(offs[k], F) * Hy.transpose();
+		HPhi.middleRows(O * k, O) =
+			Hx * Phi.topRows(V) + Hy * Phi.middleRows(offs[k], F);
+
+		KFArray_OBS ytilde = Z[obsIdxs[k]];
+		OnSubstractObservationVectors(ytilde, all_predictions[lms[k]]);
+		nu.segment(O * k, O) = ytilde.asEigen();
+	}
+
+	Eigen::MatrixXd S(O * M, O * M);
+	for (size_t k = 0; k < M; k++)
+	{
+		S.middleRows(O * k, O) = Hxs[k].asEigen() * PHt.topRows(V) +
+			Hys[k].asEigen() * PHt.middleRows(offs[k], F);
+		S.block(O * k, O * k, O, O) += R.asEigen();
+	}
+
+	const Eigen::LLT<Eigen::MatrixXd> S_llt(S);
+	if (S_llt.info() != Eigen::Success)
+		THROW_EXCEPTION("Innovation covariance matrix S is not positive "
+						"definite");
+	const Eigen::MatrixXd S_1_HPhi = S_llt.solve(HPhi);
+
+	m_cekfPsiUpd = m_cekfPsi;
+	m_cekfPsiUpd.asEigen() += HPhi.transpose() * S_1_HPhi;
+	m_cekfBetaUpd = m_cekfBeta;
+	m_cekfBetaUpd.asEigen() += S_1_HPhi.transpose() * nu;
+	m_cekfPhiUpd = m_cekfPhi;
+	m_cekfPhiUpd.asEigen() -= PHt * S_1_HPhi;
+	m_cekfPendingUpdate = true;
+
+	MRPT_END
+}
+
+void CRangeBearingKFSLAM2D::cekfCommitUpdate()
+{
+	if (!m_cekfPendingUpdate) return;
+	std::swap(m_cekfPhi, m_cekfPhiUpd);
+	std::swap(m_cekfPsi, m_cekfPsiUpd);
+	std::swap(m_cekfBeta, m_cekfBetaUpd);
+	m_cekfPendingUpdate = false;
+}
@@ -0,0 +1,141 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+#include <mrpt/obs/CActionRobotMovement2D.h>
+#include <mrpt/poses/CPoint2D.h>
+#include <mrpt/random/RandomGenerators.h>
+#include <mrpt/slam/CRangeBearingKFSLAM2D.h>
+
+using namespace mrpt;
+using namespace mrpt::slam;
+using namespace mrpt::math;
+using namespace mrpt::obs;
+using namespace mrpt::poses;
+using namespace std;
+
+namespace
+{
+// A robot moving along two rows of landmarks, which are observed (with their
+// IDs) up to 4 meters away.
+void simulateDataset(
+	std::vector<CActionCollection::Ptr>& acts,
+	std::vector<CSensoryFrame::Ptr>& sfs)
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(1234);
+
+	std::vector<TPoint2D> lms;
+	for (int i = 0; i < 60; i++)
+		lms.emplace_back(0.5 * i, (i % 2) ? 1.5 : -1.5);
+
+	CPose2D gtPose;
+	for (int step = 0; step < 80; step++)
+	{
+		const CPose2D incr(
+			0.25, 0, DEG2RAD((step % 8) < 4 ? 2.0 : -2.0));
+		gtPose = gtPose + incr;
+
+		CActionRobotMovement2D actmov;
+		CActionRobotMovement2D::TMotionModelOptions odo_opts;
+		odo_opts.modelSelection = CActionRobotMovement2D::mmGaussian;
+		odo_opts.gaussianModel.minStdXY = 0.02;
+		odo_opts.gaussianModel.minStdPHI = DEG2RAD(1.0);
+		const CPose2D noisyIncr(
+			incr.x() + rng.drawGaussian1D(0, 0.02),
+			incr.y() + rng.drawGaussian1D(0, 0.02),
+			incr.phi() + rng.drawGaussian1D(0, DEG2RAD(1.0)));
+		actmov.computeFromOdometry(noisyIncr, odo_opts);
+		auto act = CActionCollection::Create();
+		act->insert(actmov);
+
+		auto obs = CObservationBearingRange::Create();
+		obs->maxSensorDistance = 4;
+		for (size_t i = 0; i < lms.size(); i++)
+		{
+			const CPoint2D rel = CPoint2D(lms[i]) - gtPose;
+			const double range = rel.norm();
+			const double yaw = std::atan2(rel.y(), rel.x());
+			if (range > 4 || std::abs(yaw) > DEG2RAD(90.0)) continue;
+
+			CObservationBearingRange::TMeasurement m;
+			m.range = d2f(range + rng.drawGaussian1D(0, 0.01));
+			m.yaw = d2f(yaw + rng.drawGaussian1D(0, DEG2RAD(0.5)));
+			m.pitch = 0;
+			m.landmarkID = static_cast<int32_t>(i);
+			obs->sensedData.push_back(m);
+		}
+		auto sf = CSensoryFrame::Create();
+		sf->insert(obs);
+
+		acts.push_back(act);
+		sfs.push_back(sf);
+	}
+}
+}  // namespace
+
+TEST(CRangeBearingKFSLAM2D, compressedEKFMatchesFullEKF)
+{
+	std::vector<CActionCollection::Ptr> acts;
+	std::vector<CSensoryFrame::Ptr> sfs;
+	simulateDataset(acts, sfs);
+
+	CRangeBearingKFSLAM2D full, cekf;
+	for (auto* slam : {&full, &cekf})
+	{
+		slam->options.std_sensor_range = 0.01f;
+		slam->options.std_sensor_yaw = DEG2RAD(0.5f);
+	}
+	cekf.options.use_compressed_ekf = true;
+	// Small regions, to close many of them along the path:
+	cekf.options.compressed_ekf_region_radius = 1.0;
+
+	for (size_t step = 0; step < acts.size(); step++)
+	{
+		full.processActionObservation(acts[step], sfs[step]);
+		cekf.processActionObservation(acts[step], sfs[step]);
+
+		CPosePDFGaussian pose1, pose2;
+		std::vector<TPoint2D> lms1, lms2;
+		std::map<unsigned int, mrpt::maps::CLandmark::TLandmarkID> ids1, ids2;
+		CVectorDouble x1, x2;
+		CMatrixDouble P1, P2;
+		full.getCurrentState(pose1, lms1, ids1, x1, P1);
+		cekf.getCurrentState(pose2, lms2, ids2, x2, P2);
+
+		ASSERT_EQ(x1.size(), x2.size()) << "step=" << step;
+		EXPECT_EQ(ids1, ids2) << "step=" << step;
+		EXPECT_LT((x1.asEigen() - x2.asEigen()).cwiseAbs().maxCoeff(), 1e-6)
+			<< "step=" << step;
+		EXPECT_LT((P1.asEigen() - P2.asEigen()).cwiseAbs().maxCoeff(), 1e-8)
+			<< "step=" << step;
+
+		for (size_t i = 0; i < lms1.size(); i++)
+		{
+			CRangeBearingKFSLAM2D::KFArray_FEAT m;
+			cekf.getLandmarkMean(i, m);
+			EXPECT_NEAR(m[0], lms1[i].x, 1e-6);
+			EXPECT_NEAR(m[1], lms1[i].y, 1e-6);
+
+			CRangeBearingKFSLAM2D::KFMatrix_FxF c;
+			cekf.getLandmarkCov(i, c);
+			EXPECT_NEAR(c(0, 0), P1(3 + 2 * i, 3 + 2 * i), 1e-8);
+			EXPECT_NEAR(c(0, 1), P1(3 + 2 * i, 4 + 2 * i), 1e-8);
+			EXPECT_NEAR(c(1, 1), P1(4 + 2 * i, 4 + 2 * i), 1e-8);
+		}
+	}
+	// All the landmarks must have been mapped:
+	CPosePDFGaussian pose;
+	std::vector<TPoint2D> lms;
+	std::map<unsigned int, mrpt::maps::CLandmark::TLandmarkID> ids;
+	CVectorDouble x;
+	CMatrixDouble P;
+	cekf.getCurrentState(pose, lms, ids, x, P);
+	EXPECT_GT(lms.size(), 40U);
+}
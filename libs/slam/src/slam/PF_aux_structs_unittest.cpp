@@ -0,0 +1,124 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+#include <mrpt/random.h>
+#include <mrpt/slam/PF_aux_structs.h>
+
+#include <set>
+
+using namespace mrpt::slam::detail;
+
+namespace
+{
+TPoseBin2D randomBin2D(int range)
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	TPoseBin2D b;
+	b.x = rng.drawUniform32bit() % (2 * range + 1) - range;
+	b.y = rng.drawUniform32bit() % (2 * range + 1) - range;
+	b.phi = rng.drawUniform32bit() % 7 - 3;
+	return b;
+}
+}  // namespace
+
+TEST(TKLDBinsHashSet, sameAsStdSet)
+{
+	mrpt::random::getRandomGenerator().randomize(123);
+
+	TKLDBinsHashSet<TPoseBin2D> bins;
+	std::set<TPoseBin2D, TPoseBin2D::lt_operator> ref;
+	std::vector<TPoseBin2D> inserted;
+
+	for (int iter = 0; iter < 2; iter++)
+	{
+		bins.clear();
+		ref.clear();
+		inserted.clear();
+		for (int i = 0; i < 5000; i++)
+		{
+			const TPoseBin2D b = randomBin2D(20);
+			const bool isNew = ref.insert(b).second;
+			const auto [idx, inserted_now] = bins.insert(b);
+			EXPECT_EQ(inserted_now, isNew);
+			if (isNew) inserted.push_back(b);
+
+			// Indices are stable and in insertion order:
+			ASSERT_LT(idx, inserted.size());
+			EXPECT_TRUE(inserted[idx] == b);
+			EXPECT_EQ(bins.find(b), idx);
+		}
+		EXPECT_EQ(bins.size(), ref.size());
+		for (size_t i = 0; i < inserted.size(); i++)
+			EXPECT_EQ(bins.find(inserted[i]), i);
+
+		TPoseBin2D missing;
+		missing.x = 1000;
+		EXPECT_EQ(bins.find(missing), bins.INVALID_INDEX);
+	}
+}
+
+TEST(TKLDBinsHashSet, poseBin3D)
+{
+	TKLDBinsHashSet<TPoseBin3D> bins;
+	bins.reserve(10);
+	TPoseBin3D a, b;
+	b.roll = 1;
+	EXPECT_TRUE(bins.insert(a).second);
+	EXPECT_TRUE(bins.insert(b).second);
+	EXPECT_FALSE(bins.insert(a).second);
+	b.roll = 0;
+	EXPECT_EQ(bins.find(b), 0U);
+	EXPECT_EQ(bins.size(), 2U);
+}
+
+TEST(TKLDBinsHashSet, pathBins)
+{
+	mrpt::random::getRandomGenerator().randomize(456);
+
+	// Paths sharing their first poses:
+	std::vector<TPathBin2D> paths(50);
+	for (auto& p : paths)
+		for (int k = 0; k < 3; k++)
+			p.bins.push_back(TPoseBin2D());
+
+	TKLDBinsHashSet<TPathBin2D> bins;
+	for (auto& p : paths)
+	{
+		p.hash();  // Then, extend incrementally:
+		p.bins.push_back(randomBin2D(3));
+		bins.insert(p);
+	}
+
+	std::set<TPathBin2D, TPathBin2D::lt_operator> ref(
+		paths.begin(), paths.end());
+	EXPECT_EQ(bins.size(), ref.size());
+
+	// The same paths, hashed in one go:
+	for (const auto& p : paths)
+	{
+		TPathBin2D q;
+		q.bins = p.bins;
+		EXPECT_EQ(q.hash(), p.hash());
+		EXPECT_NE(bins.find(q), bins.INVALID_INDEX);
+		EXPECT_FALSE(bins.insert(q).second);
+	}
+
+	// clear() resets the hash:
+	TPathBin2D q = paths[0];
+	q.clear();
+	for (int k = 0; k < 5; k++)
+		q.bins.push_back(TPoseBin2D());
+	EXPECT_TRUE(bins.insert(q).second);
+	q.clear();
+	q.bins.push_back(TPoseBin2D());
+	TPathBin2D r;
+	r.bins.push_back(TPoseBin2D());
+	EXPECT_EQ(q.hash(), r.hash());
+}
@@ -9,6 +9,7 @@
 
 #include "slam-precomp.h"  // Precompiled headers
 //
+#include <mrpt/core/parallel_for.h>
 #include <mrpt/math/KDTreeCapable.h>  // For kd-tree's
 #include <mrpt/math/data_utils.h>
 #include <mrpt/math/distributions.h>  // for chi2inv
@@ -18,10 +19,11 @@
 #include <mrpt/slam/data_association.h>
 
 #include <Eigen/Dense>
+#include <algorithm>
+#include <atomic>
 #include <memory>
 #include <memory>  // unique_ptr
 #include <nanoflann.hpp>  // For kd-tree's
-#include <numeric>	// accumulate
 #include <set>
 
 /*
@@ -44,93 +46,8 @@ using namespace mrpt::math;
 using namespace mrpt::poses;
 using namespace mrpt::slam;
 
-namespace mrpt::slam
+namespace
 {
-struct TAuxDataRecursiveJCBB
-{
-	/** Just to avoid recomputing them all the time. */
-	size_t nPredictions, nObservations, length_O;
-	std::map<size_t, size_t> currentAssociation;
-};
-
-/**  Computes the joint distance metric (mahalanobis or matching likelihood)
- * between two  a set of associations
- *
- * On "currentAssociation":  maps "ID_obs" -> "ID_pred"
- *  For each landmark ID in the observations (ID_obs), its association
- *  in the predictions, that is: ID_pred = associations[ID_obs]
- *
- */
-template <typename T, TDataAssociationMetric METRIC>
-double joint_pdf_metric(
-	const CMatrixDynamic<T>& Z_observations_mean,
-	const CMatrixDynamic<T>& Y_predictions_mean,
-	const CMatrixDynamic<T>& Y_predictions_cov,
-	const TAuxDataRecursiveJCBB& info,
-	[[maybe_unused]] const TDataAssociationResults& aux_data)
-{
-	// Make a list of the indices of the predictions that appear in
-	// "currentAssociation":
-	const size_t N = info.currentAssociation.size();
-	ASSERT_(N > 0);
-	std::vector<size_t> indices_pred(
-		N);	 // Appearance order indices in the std::maps
-	std::vector<size_t> indices_obs(N);
-
-	{
-		size_t i = 0;
-		for (auto it : info.currentAssociation)
-		{
-			indices_obs[i] = it.first;
-			indices_pred[i] = it.second;
-			i++;
-		}
-	}
-
-	// ----------------------------------------------------------------------
-	// Extract submatrix of the covariances involved here:
-	//  COV = PREDICTIONS_COV(INDX,INDX) + OBSERVATIONS_COV(INDX2,INDX2)
-	// ----------------------------------------------------------------------
-	CMatrixDynamic<T> COV;
-	mrpt::math::extractSubmatrixSymmetricalBlocksDyn(
-		Y_predictions_cov,
-		info.length_O,	// dims of cov. submatrices
-		indices_pred, COV);
-
-	// ----------------------------------------------------------------------
-	// Mean:
-	// The same for the vector of "errors" or "innovation" between predictions
-	// and observations:
-	// ----------------------------------------------------------------------
-	Eigen::Matrix<T, Eigen::Dynamic, 1> innovations(N * info.length_O);
-	T* dst_ptr = &innovations[0];
-	for (auto it = info.currentAssociation.begin();
-		 it != info.currentAssociation.end(); ++it)
-	{
-		const T* pred_i_mean = &Y_predictions_mean(it->second, 0);
-		const T* obs_i_mean = &Z_observations_mean(it->first, 0);
-
-		for (unsigned int k = 0; k < info.length_O; k++)
-			*dst_ptr++ = pred_i_mean[k] - obs_i_mean[k];
-	}
-
-	// Compute mahalanobis distance squared:
-	const CMatrixDynamic<T> COV_inv = COV.inverse_LLt();
-
-	const double d2 = mrpt::math::multiply_HtCH_scalar(innovations, COV_inv);
-
-	if (METRIC == metricMaha) return d2;
-
-	ASSERT_(METRIC == metricML);
-
-	// Matching likelihood: The evaluation at 0 of the PDF of the difference
-	// between the two Gaussians:
-	const T cov_det = COV.det();
-	const double ml = exp(-0.5 * d2) /
-		(std::pow(M_2PI, info.length_O * 0.5) * std::sqrt(cov_det));
-	return ml;
-}
-
 template <TDataAssociationMetric METRIC>
 bool isCloser(const double v1, const double v2);
 
@@ -146,116 +63,347 @@ bool isCloser<metricML>(const double v1, const double v2)
 	return v1 > v2;
 }
 
+void atomicMax(std::atomic<size_t>& a, size_t v)
+{
+	size_t cur = a.load();
+	while (v > cur && !a.compare_exchange_weak(cur, v))
+	{
+	}
+}
+
+void atomicMin(std::atomic<double>& a, double v)
+{
+	double cur = a.load();
+	while (v < cur && !a.compare_exchange_weak(cur, v))
+	{
+	}
+}
+
+/** Input data and shared state of one JCBB search. Observations without any
+ * individually compatible prediction can only be left unpaired, so the
+ * search only visits the "active" ones (one tree level per active
+ * observation). */
+struct TJCBBProblem
+{
+	TJCBBProblem(
+		const CMatrixDouble& Z, const CMatrixDouble& Y,
+		const CMatrixDouble& YCov)
+		: Z_observations_mean(Z),
+		  Y_predictions_mean(Y),
+		  Y_predictions_cov(YCov)
+	{
+	}
+
+	const CMatrixDouble& Z_observations_mean;
+	const CMatrixDouble& Y_predictions_mean;
+	const CMatrixDouble& Y_predictions_cov;
+	size_t length_O = 0, nPredictions = 0;
+
+	/** Observation index of each tree level */
+	std::vector<observation_index_t> activeObs;
+	/** Individually compatible predictions of each tree level */
+	std::vector<std::vector<prediction_index_t>> candidates;
+	/** Chi2 threshold of the joint Mahalanobis distance for k pairings, or
+	 * empty if joint compatibility is not tested. */
+	std::vector<double> jointThres;
+
+	/** Best number of pairings found so far, by any thread. */
+	std::atomic<size_t> bestSize{0};
+	/** Best joint Mahalanobis distance found so far for each number of
+	 * pairings (only for metricMaha) */
+	std::unique_ptr<std::atomic<double>[]> bestD2;
+};
+
+/** A hypothesis in the JCBB tree, as the choice made in each of its first
+ * levels (a prediction index, or -1 for an unpaired observation). */
+using TJCBBPrefix = std::vector<int>;
+
+struct TJCBBResult
+{
+	std::vector<std::pair<observation_index_t, prediction_index_t>> pairs;
+	double distance = 0;
+};
+
 /* Based on MATLAB code by:
   University of Zaragoza
   Centro Politecnico Superior
   Robotics and Real Time Group
   Authors of the original MATLAB code:  J. Neira, J. Tardos
   C++ version: J.L. Blanco Claraco
+
+  Each hypothesis keeps the Cholesky factor L of the joint innovation
+  covariance of its pairings, and the whitened innovation y = L^-1 * nu.
+  Since the tree is explored depth-first, the factor of a node is the
+  top-left block of the factor of all its children, so adding a pairing
+  only appends O rows to L (a block Cholesky update, O(k^2) instead of
+  refactorizing the O(k^3) joint covariance).
 */
-template <typename T, TDataAssociationMetric METRIC>
-void JCBB_recursive(
-	const mrpt::math::CMatrixDynamic<T>& Z_observations_mean,
-	const mrpt::math::CMatrixDynamic<T>& Y_predictions_mean,
-	const mrpt::math::CMatrixDynamic<T>& Y_predictions_cov,
-	TDataAssociationResults& results, const TAuxDataRecursiveJCBB& info,
-	const observation_index_t curObsIdx)
+template <TDataAssociationMetric METRIC>
+class JCBBSearch
 {
-	// End of iteration?
-	if (curObsIdx >= info.nObservations)
+   public:
+	explicit JCBBSearch(TJCBBProblem& p) : m_p(p)
+	{
+		const size_t O = m_p.length_O;
+		const size_t maxPairs =
+			std::min(m_p.activeObs.size(), m_p.nPredictions);
+		m_L.resize(maxPairs * O, maxPairs * O);
+		m_y.resize(maxPairs * O);
+		m_X.resize(maxPairs * O, O);
+		m_nu.resize(O);
+		m_S.resize(O, O);
+		m_d2.assign(maxPairs + 1, 0);
+		m_logDet.assign(maxPairs + 1, 0);
+		m_predTaken.assign(m_p.nPredictions, false);
+		m_pairs.reserve(maxPairs);
+	}
+
+	/** Explores all the hypotheses starting with the given prefix, and
+	 * returns the best one. */
+	TJCBBResult run(const TJCBBPrefix& prefix)
+	{
+		m_best = TJCBBResult();
+		m_best.distance = (METRIC == metricML)
+			? 0
+			: std::numeric_limits<double>::max();
+
+		bool valid = true;
+		for (size_t level = 0; level < prefix.size() && valid; level++)
+		{
+			if (!canBeatBest(m_pairs.size() + (m_p.activeObs.size() - level)))
+				valid = false;
+			else if (prefix[level] >= 0)
+				valid = push(m_p.activeObs[level], prefix[level]);
+		}
+		if (valid) explore(prefix.size());
+
+		while (!m_pairs.empty())
+			pop();
+		return m_best;
+	}
+
+	size_t nNodes = 0;
+
+   private:
+	TJCBBProblem& m_p;
+
+	Eigen::MatrixXd m_L, m_X, m_S;
+	Eigen::VectorXd m_y, m_nu;
+	Eigen::LLT<Eigen::MatrixXd> m_llt;
+	/** Joint Mahalanobis distance and log(det(cov)) for the first k pairs */
+	std::vector<double> m_d2, m_logDet;
+	std::vector<std::pair<observation_index_t, prediction_index_t>> m_pairs;
+	std::vector<bool> m_predTaken;
+	TJCBBResult m_best;
+
+	/** Whether a leaf below the current node, with up to `reachable`
+	 * pairings, could be better than the best hypothesis of any thread.
+	 * Inequalities are strict, so the result does not depend on which thread
+	 * finds a hypothesis first. */
+	bool canBeatBest(const size_t reachable) const
+	{
+		if (!reachable) return false;
+		const size_t bestSize = m_p.bestSize.load();
+		if (reachable < bestSize) return false;
+		// The joint distance never decreases when adding more pairings:
+		if constexpr (METRIC == metricMaha)
+			if (reachable == bestSize &&
+				m_d2[m_pairs.size()] > m_p.bestD2[bestSize].load())
+				return false;
+		return true;
+	}
+
+	void explore(const size_t level)
 	{
-		if (info.currentAssociation.size() > results.associations.size())
+		const size_t nLevels = m_p.activeObs.size();
+		if (!canBeatBest(m_pairs.size() + (nLevels - level))) return;
+
+		if (level == nLevels)
 		{
-			// It's a better choice since more features are matched.
-			results.associations = info.currentAssociation;
-			results.distance = joint_pdf_metric<T, METRIC>(
-				Z_observations_mean, Y_predictions_mean, Y_predictions_cov,
-				info, results);
+			onLeaf();
+			return;
 		}
-		else if (
-			!info.currentAssociation.empty() &&
-			info.currentAssociation.size() == results.associations.size())
+
+		const observation_index_t obsIdx = m_p.activeObs[level];
+		for (const prediction_index_t predIdx : m_p.candidates[level])
 		{
-			// The same # of features matched than the previous best one...
-			// decide by better distance:
-			const double d2 = joint_pdf_metric<T, METRIC>(
-				Z_observations_mean, Y_predictions_mean, Y_predictions_cov,
-				info, results);
+			// Only if predIdx is NOT already assigned:
+			if (m_predTaken[predIdx]) continue;
 
-			if (isCloser<METRIC>(d2, results.distance))
-			{
-				results.associations = info.currentAssociation;
-				results.distance = d2;
-			}
+			nNodes++;
+			if (!push(obsIdx, predIdx)) continue;
+			explore(level + 1);
+			pop();
 		}
+
+		// star node: Ei not paired
+		nNodes++;
+		explore(level + 1);
 	}
-	else  // A normal iteration:
+
+	/** Adds a pairing to the current hypothesis, if it is jointly compatible
+	 * with the existing ones. */
+	bool push(
+		const observation_index_t obsIdx, const prediction_index_t predIdx)
 	{
-		// Iterate for all compatible landmarsk of "curObsIdx"
-		const observation_index_t obsIdx = curObsIdx;
-
-		const size_t nPreds = results.indiv_compatibility.rows();
-
-		// Can we do it better than the current "results.associations"?
-		// This can be checked by counting the potential new pairings+the so-far
-		// established ones.
-		//    Matlab: potentials  = pairings(compatibility.AL(i+1:end))
-		// Moved up by Kasra Khosoussi
-		const size_t potentials = std::accumulate(
-			results.indiv_compatibility_counts.begin() + (obsIdx + 1),
-			results.indiv_compatibility_counts.end(), 0);
-		for (prediction_index_t predIdx = 0; predIdx < nPreds; predIdx++)
+		const size_t O = m_p.length_O;
+		const size_t k = m_pairs.size(), kO = k * O, i0 = predIdx * O;
+		const auto C = m_p.Y_predictions_cov.asEigen();
+
+		for (size_t q = 0; q < O; q++)
+			m_nu[q] = m_p.Y_predictions_mean(predIdx, q) -
+				m_p.Z_observations_mean(obsIdx, q);
+
+		// New rows of L: [X^t L22], with X = L^-1 * COV(previous, new) and
+		// L22 the Cholesky factor of the Schur complement COV(new,new)-X^t*X
+		m_S = C.block(i0, i0, O, O);
+		if (k)
 		{
-			if ((info.currentAssociation.size() + potentials) >=
-				results.associations.size())
-			{
-				// Only if predIdx is NOT already assigned:
-				if (results.indiv_compatibility(predIdx, obsIdx))
-				{
-					// Only if predIdx is NOT already assigned:
-					bool already_asigned = false;
-					for (auto itS : info.currentAssociation)
-					{
-						if (itS.second == predIdx)
-						{
-							already_asigned = true;
-							break;
-						}
-					}
+			for (size_t r = 0; r < k; r++)
+				m_X.block(r * O, 0, O, O) =
+					C.block(m_pairs[r].second * O, i0, O, O);
+			auto X = m_X.topRows(kO);
+			m_L.topLeftCorner(kO, kO)
+				.triangularView<Eigen::Lower>()
+				.solveInPlace(X);
+			m_S.noalias() -= X.transpose() * X;
+			m_nu.noalias() -= X.transpose() * m_y.head(kO);
+		}
+		m_llt.compute(m_S);
+		if (m_llt.info() != Eigen::Success) return false;
+		m_llt.matrixL().solveInPlace(m_nu);
+
+		const double d2 = m_d2[k] + m_nu.squaredNorm();
+		if (!m_p.jointThres.empty() && !(d2 < m_p.jointThres[k + 1]))
+			return false;
+
+		if (k) m_L.block(kO, 0, O, kO) = m_X.topRows(kO).transpose();
+		m_L.block(kO, kO, O, O) = m_llt.matrixL();
+		m_y.segment(kO, O) = m_nu;
+		m_d2[k + 1] = d2;
+		m_logDet[k + 1] = m_logDet[k] +
+			2 * m_llt.matrixLLT().diagonal().array().log().sum();
+
+		m_pairs.emplace_back(obsIdx, predIdx);
+		m_predTaken[predIdx] = true;
+		return true;
+	}
 
-					if (!already_asigned)
-					{
-						// Launch a new recursive line for this hipothesis:
-						TAuxDataRecursiveJCBB new_info = info;
-						new_info.currentAssociation[curObsIdx] = predIdx;
+	void pop()
+	{
+		m_predTaken[m_pairs.back().second] = false;
+		m_pairs.pop_back();
+	}
 
-						results.nNodesExploredInJCBB++;
+	void onLeaf()
+	{
+		const size_t k = m_pairs.size();
+		double dist = m_d2[k];
+		if constexpr (METRIC == metricML)
+		{
+			// Matching likelihood: The evaluation at 0 of the PDF of the
+			// difference between the two Gaussians:
+			dist = exp(-0.5 * m_d2[k]) /
+				(std::pow(M_2PI, m_p.length_O * 0.5) *
+				 std::exp(0.5 * m_logDet[k]));
+		}
 
-						JCBB_recursive<T, METRIC>(
-							Z_observations_mean, Y_predictions_mean,
-							Y_predictions_cov, results, new_info,
-							curObsIdx + 1);
-					}
-				}
-			}
+		if (k > m_best.pairs.size() ||
+			(k == m_best.pairs.size() &&
+			 isCloser<METRIC>(dist, m_best.distance)))
+		{
+			m_best.pairs = m_pairs;
+			m_best.distance = dist;
+
+			if constexpr (METRIC == metricMaha)
+				atomicMin(m_p.bestD2[k], m_d2[k]);
+			atomicMax(m_p.bestSize, k);
 		}
+	}
+};
 
-		// Can we do it better than the current "results.associations"?
-		if ((info.currentAssociation.size() + potentials) >=
-			results.associations.size())
+/** Splits the JCBB tree in hypotheses prefixes, in depth-first order, until
+ * there are at least `minTasks` of them. */
+std::vector<TJCBBPrefix> JCBB_split_tree(
+	const TJCBBProblem& p, const size_t minTasks, size_t& nNodes)
+{
+	std::vector<TJCBBPrefix> tasks(1);
+	for (size_t level = 0;
+		 level < p.activeObs.size() && tasks.size() < minTasks; level++)
+	{
+		std::vector<TJCBBPrefix> next;
+		for (const auto& t : tasks)
 		{
-			// Yes we can </obama>
+			for (const prediction_index_t predIdx : p.candidates[level])
+			{
+				if (std::find(t.begin(), t.end(), static_cast<int>(predIdx)) !=
+					t.end())
+					continue;
+				next.push_back(t);
+				next.back().push_back(static_cast<int>(predIdx));
+			}
+			next.push_back(t);
+			next.back().push_back(-1);
+		}
+		nNodes += next.size();
+		tasks = std::move(next);
+	}
+	return tasks;
+}
+
+template <TDataAssociationMetric METRIC>
+void JCBB(TJCBBProblem& p, TDataAssociationResults& results, size_t nThreads)
+{
+	nThreads = mrpt::resolveNumThreads(nThreads);
+
+	std::vector<TJCBBPrefix> tasks(1);
+	if (nThreads > 1)
+		tasks = JCBB_split_tree(p, 4 * nThreads, results.nNodesExploredInJCBB);
+	nThreads = std::min(nThreads, tasks.size());
+
+	std::vector<TJCBBResult> taskResults(tasks.size());
+
+	if (nThreads == 1)
+	{
+		JCBBSearch<METRIC> search(p);
+		for (size_t t = 0; t < tasks.size(); t++)
+			taskResults[t] = search.run(tasks[t]);
+		results.nNodesExploredInJCBB += search.nNodes;
+	}
+	else
+	{
+		// Each worker takes the next pending subtree, for load balancing:
+		std::atomic<size_t> nextTask{0};
+		std::vector<size_t> nodesPerThread(nThreads, 0);
+		mrpt::parallelFor(nThreads, 1, nThreads, [&](size_t th, size_t) {
+			JCBBSearch<METRIC> search(p);
+			for (size_t t = nextTask++; t < tasks.size(); t = nextTask++)
+				taskResults[t] = search.run(tasks[t]);
+			nodesPerThread[th] = search.nNodes;
+		});
+		for (const auto n : nodesPerThread)
+			results.nNodesExploredInJCBB += n;
+	}
 
-			// star node: Ei not paired
-			results.nNodesExploredInJCBB++;
-			JCBB_recursive<T, METRIC>(
-				Z_observations_mean, Y_predictions_mean, Y_predictions_cov,
-				results, info, curObsIdx + 1);
+	// Merge in depth-first order, keeping the first of equally good
+	// hypotheses, as a sequential search would do:
+	size_t bestSize = 0;
+	for (const auto& r : taskResults)
+	{
+		if (r.pairs.size() > bestSize ||
+			(!r.pairs.empty() && r.pairs.size() == bestSize &&
+			 isCloser<METRIC>(r.distance, results.distance)))
+		{
+			bestSize = r.pairs.size();
+			results.associations.clear();
+			for (const auto& pr : r.pairs)
+				results.associations[pr.first] = pr.second;
+			results.distance = r.distance;
 		}
 	}
 }
 
-}  // namespace mrpt::slam
+}  // namespace
 
 /* ==================================================================================================
 Computes the data-association between the prediction of a set of landmarks and
@@ -292,6 +440,8 @@ a small number of features. (default=true).
 * \param predictions_IDs [IN, optional] (default:none) An N-vector. If provided,
 the resulting associations in "results.associations" will not contain prediction
 indices "i", but "predictions_IDs[i]".
+* \param JCBB_numThreads [IN, optional] Number of threads for JCBB (0: all
+cores).
 *
  ==================================================================================================
 */
@@ -304,7 +454,7 @@ void mrpt::slam::data_association_full_covariance(
 	const bool DAT_ASOC_USE_KDTREE,
 	const std::vector<prediction_index_t>& predictions_IDs,
 	const TDataAssociationMetric compatibilityTestMetric,
-	const double log_ML_compat_test_threshold)
+	const double log_ML_compat_test_threshold, const size_t JCBB_numThreads)
 {
 	// For details on the theory, see the papers cited at the beginning of this
 	// file.
@@ -536,20 +686,38 @@ void mrpt::slam::data_association_full_covariance(
 		// ------------------------------------
 		case assocJCBB:
 		{
-			// Call to the recursive method:
-			TAuxDataRecursiveJCBB info;
-			info.nPredictions = nPredictions;
-			info.nObservations = nObservations;
-			info.length_O = length_O;
+			TJCBBProblem p(
+				Z_observations_mean, Y_predictions_mean, Y_predictions_cov);
+			p.length_O = length_O;
+			p.nPredictions = nPredictions;
+			for (observation_index_t j = 0; j < nObservations; ++j)
+			{
+				if (!results.indiv_compatibility_counts[j]) continue;
+				p.activeObs.push_back(j);
+				auto& cands = p.candidates.emplace_back();
+				for (prediction_index_t i = 0; i < nPredictions; ++i)
+					if (results.indiv_compatibility(i, j)) cands.push_back(i);
+			}
+			if (p.activeObs.empty()) break;
+
+			const size_t maxPairs = std::min(p.activeObs.size(), nPredictions);
+			// Joint compatibility: chi2 test of the joint Mahalanobis
+			// distance, with k*O degrees of freedom for k pairings:
+			if (compatibilityTestMetric == metricMaha)
+			{
+				p.jointThres.resize(maxPairs + 1);
+				for (size_t k = 1; k <= maxPairs; k++)
+					p.jointThres[k] = mrpt::math::chi2inv(
+						chi2quantile, static_cast<unsigned int>(k * length_O));
+			}
+			p.bestD2 = std::make_unique<std::atomic<double>[]>(maxPairs + 1);
+			for (size_t k = 0; k <= maxPairs; k++)
+				p.bestD2[k] = std::numeric_limits<double>::max();
 
 			if (metric == metricMaha)
-				JCBB_recursive<CMatrixDouble::Scalar, metricMaha>(
-					Z_observations_mean, Y_predictions_mean, Y_predictions_cov,
-					results, info, 0);
+				JCBB<metricMaha>(p, results, JCBB_numThreads);
 			else
-				JCBB_recursive<CMatrixDouble::Scalar, metricML>(
-					Z_observations_mean, Y_predictions_mean, Y_predictions_cov,
-					results, info, 0);
+				JCBB<metricML>(p, results, JCBB_numThreads);
 		}
 		break;
 
@@ -581,7 +749,7 @@ void mrpt::slam::data_association_independent_predictions(
 	const bool DAT_ASOC_USE_KDTREE,
 	const std::vector<prediction_index_t>& predictions_IDs,
 	const TDataAssociationMetric compatibilityTestMetric,
-	const double log_ML_compat_test_threshold)
+	const double log_ML_compat_test_threshold, const size_t JCBB_numThreads)
 {
 	MRPT_START
 
@@ -616,7 +784,8 @@ void mrpt::slam::data_association_independent_predictions(
 	data_association_full_covariance(
 		Z_observations_mean, Y_predictions_mean, Y_predictions_cov_full,
 		results, method, metric, chi2quantile, DAT_ASOC_USE_KDTREE,
-		predictions_IDs, compatibilityTestMetric, log_ML_compat_test_threshold);
+		predictions_IDs, compatibilityTestMetric, log_ML_compat_test_threshold,
+		JCBB_numThreads);
 
 	MRPT_END
 }
@@ -8,8 +8,13 @@
    +------------------------------------------------------------------------+ */
 
 #include <gtest/gtest.h>
+#include <mrpt/core/bits_math.h>
+#include <mrpt/random/RandomGenerators.h>
 #include <mrpt/slam/data_association.h>
 
+#include <Eigen/Dense>
+#include <numeric>
+
 using namespace mrpt;
 using namespace mrpt::slam;
 using namespace mrpt::math;
@@ -55,3 +60,97 @@ TEST(DataAssociation, TestNoICs)
 		}
 	}
 }
+
+namespace
+{
+// A grid of landmarks with correlated predictions (a common, vehicle-like
+// error of 0.2 m), a few of them observed, plus random clutter observations.
+void simulateScene(
+	size_t nClutter, CMatrixDouble& Z, CMatrixDouble& Y, CMatrixDouble& YCov,
+	std::vector<size_t>& truth)
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(1234);
+
+	const size_t side = 6, nLMs = side * side, nSeen = 10;
+	const double sigmaCommon = 0.2, sigmaInd = 0.05;
+
+	Y.setSize(nLMs, 2);
+	YCov.setSize(2 * nLMs, 2 * nLMs);
+	for (size_t i = 0; i < nLMs; i++)
+	{
+		Y(i, 0) = 1.0 * (i % side);
+		Y(i, 1) = 1.0 * (i / side);
+		for (size_t j = 0; j < nLMs; j++)
+			for (size_t k = 0; k < 2; k++)
+				YCov(2 * i + k, 2 * j + k) = mrpt::square(sigmaCommon) +
+					(i == j ? mrpt::square(sigmaInd) : 0.0);
+	}
+
+	std::vector<size_t> idxs(nLMs);
+	std::iota(idxs.begin(), idxs.end(), 0);
+	for (size_t i = nLMs - 1; i > 0; i--)
+		std::swap(idxs[i], idxs[rng.drawUniform32bit() % (i + 1)]);
+	truth.assign(idxs.begin(), idxs.begin() + nSeen);
+
+	const double offset[2] = {0.1, -0.08};
+	Z.setSize(nSeen + nClutter, 2);
+	for (size_t j = 0; j < nSeen; j++)
+		for (size_t k = 0; k < 2; k++)
+			Z(j, k) = Y(truth[j], k) + offset[k] + rng.drawGaussian1D(0, 0.04);
+	for (size_t j = nSeen; j < nSeen + nClutter; j++)
+		for (size_t k = 0; k < 2; k++)
+			Z(j, k) = rng.drawUniform(-0.5, side - 0.5);
+}
+}  // namespace
+
+TEST(DataAssociation, JCBBClutterAndThreads)
+{
+	for (const size_t nClutter : {0, 3, 6})
+	{
+		CMatrixDouble Z, Y, YCov;
+		std::vector<size_t> truth;
+		simulateScene(nClutter, Z, Y, YCov, truth);
+
+		TDataAssociationResults res1, resN;
+		data_association_full_covariance(
+			Z, Y, YCov, res1, assocJCBB, metricMaha, 0.99, false, {},
+			metricMaha, 0.0, 1 /*threads*/);
+		data_association_full_covariance(
+			Z, Y, YCov, resN, assocJCBB, metricMaha, 0.99, false, {},
+			metricMaha, 0.0, 4 /*threads*/);
+
+		// Results must not depend on the number of threads:
+		EXPECT_EQ(res1.associations, resN.associations) << nClutter;
+		EXPECT_EQ(res1.distance, resN.distance) << nClutter;
+
+		EXPECT_GE(res1.associations.size(), truth.size()) << nClutter;
+		if (!nClutter)
+		{
+			for (size_t j = 0; j < truth.size(); j++)
+				EXPECT_EQ(res1.associations[j], truth[j]);
+		}
+
+		// The incremental joint Mahalanobis distance must match the one
+		// computed from the whole joint covariance:
+		const size_t N = res1.associations.size();
+		Eigen::MatrixXd C(2 * N, 2 * N);
+		Eigen::VectorXd nu(2 * N);
+		size_t a = 0;
+		for (const auto& pa : res1.associations)
+		{
+			size_t b = 0;
+			for (const auto& pb : res1.associations)
+			{
+				C.block<2, 2>(2 * a, 2 * b) = YCov.asEigen().block<2, 2>(
+					2 * pa.second, 2 * pb.second);
+				b++;
+			}
+			for (size_t k = 0; k < 2; k++)
+				nu[2 * a + k] = Y(pa.second, k) - Z(pa.first, k);
+			a++;
+		}
+		const double d2 = nu.dot(C.llt().solve(nu));
+		EXPECT_NEAR(res1.distance, d2, 1e-6 * d2) << nClutter;
+	}
+}
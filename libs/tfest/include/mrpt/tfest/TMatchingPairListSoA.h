@@ -0,0 +1,177 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/core/aligned_std_vector.h>
+#include <mrpt/tfest/TMatchingPair.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace mrpt::tfest
+{
+/** \addtogroup mrpt_tfest_grp
+ * @{ */
+
+/** A list of correspondences between two sets of points, stored as a
+ * structure of arrays (SoA): one contiguous, aligned array per coordinate.
+ *
+ * This holds the same data than TMatchingPairListTempl<T> (except
+ * `errorSquareAfterTransformation`), but with a memory layout which lets
+ * the centroid and cross-covariance loops of se2_l2() and se3_l2() run as
+ * SIMD code for whatever instruction set the compiler targets (SSE, AVX2,
+ * NEON...), without architecture-specific intrinsics.
+ *
+ * Reuse an instance to avoid memory allocations: clear() and assign() keep
+ * the capacity of the arrays.
+ *
+ * \sa TMatchingPairListTempl, se2_l2(), se3_l2()
+ * \note [New in MRPT 2.5.5]
+ */
+template <typename T>
+class TMatchingPairListSoATempl
+{
+   public:
+	using pair_t = TMatchingPairTempl<T>;
+	using list_t = TMatchingPairListTempl<T>;
+
+	TMatchingPairListSoATempl() = default;
+	explicit TMatchingPairListSoATempl(const list_t& list) { assign(list); }
+
+	std::vector<uint32_t> globalIdx, localIdx;
+	mrpt::aligned_std_vector<T> global_x, global_y, global_z;
+	mrpt::aligned_std_vector<T> local_x, local_y, local_z;
+
+	size_t size() const { return globalIdx.size(); }
+	bool empty() const { return globalIdx.empty(); }
+
+	void clear()
+	{
+		globalIdx.clear();
+		localIdx.clear();
+		global_x.clear();
+		global_y.clear();
+		global_z.clear();
+		local_x.clear();
+		local_y.clear();
+		local_z.clear();
+	}
+
+	void reserve(size_t n)
+	{
+		globalIdx.reserve(n);
+		localIdx.reserve(n);
+		global_x.reserve(n);
+		global_y.reserve(n);
+		global_z.reserve(n);
+		local_x.reserve(n);
+		local_y.reserve(n);
+		local_z.reserve(n);
+	}
+
+	void resize(size_t n)
+	{
+		globalIdx.resize(n);
+		localIdx.resize(n);
+		global_x.resize(n);
+		global_y.resize(n);
+		global_z.resize(n);
+		local_x.resize(n);
+		local_y.resize(n);
+		local_z.resize(n);
+	}
+
+	void push_back(const pair_t& p)
+	{
+		globalIdx.push_back(p.globalIdx);
+		localIdx.push_back(p.localIdx);
+		global_x.push_back(p.global.x);
+		global_y.push_back(p.global.y);
+		global_z.push_back(p.global.z);
+		local_x.push_back(p.local.x);
+		local_y.push_back(p.local.y);
+		local_z.push_back(p.local.z);
+	}
+
+	void pop_back()
+	{
+		globalIdx.pop_back();
+		localIdx.pop_back();
+		global_x.pop_back();
+		global_y.pop_back();
+		global_z.pop_back();
+		local_x.pop_back();
+		local_y.pop_back();
+		local_z.pop_back();
+	}
+
+	/** Returns the i-th correspondence (by value) */
+	pair_t getPair(size_t i) const
+	{
+		return pair_t(
+			globalIdx[i], localIdx[i], global_x[i], global_y[i], global_z[i],
+			local_x[i], local_y[i], local_z[i]);
+	}
+
+	/** Replaces the contents with those of an AoS list */
+	void assign(const list_t& list)
+	{
+		resize(list.size());
+		for (size_t i = 0; i < list.size(); i++)
+		{
+			const auto& p = list[i];
+			globalIdx[i] = p.globalIdx;
+			localIdx[i] = p.localIdx;
+			global_x[i] = p.global.x;
+			global_y[i] = p.global.y;
+			global_z[i] = p.global.z;
+			local_x[i] = p.local.x;
+			local_y[i] = p.local.y;
+			local_z[i] = p.local.z;
+		}
+	}
+
+	/** Replaces the contents with the correspondences `other[idxs[i]]` */
+	void assignSubset(
+		const TMatchingPairListSoATempl<T>& other,
+		const std::vector<uint32_t>& idxs)
+	{
+		resize(idxs.size());
+		for (size_t i = 0; i < idxs.size(); i++)
+		{
+			const size_t j = idxs[i];
+			globalIdx[i] = other.globalIdx[j];
+			localIdx[i] = other.localIdx[j];
+			global_x[i] = other.global_x[j];
+			global_y[i] = other.global_y[j];
+			global_z[i] = other.global_z[j];
+			local_x[i] = other.local_x[j];
+			local_y[i] = other.local_y[j];
+			local_z[i] = other.local_z[j];
+		}
+	}
+
+	/** Converts the contents into an AoS list */
+	void asList(list_t& out) const
+	{
+		out.resize(size());
+		for (size_t i = 0; i < size(); i++)
+			out[i] = getPair(i);
+	}
+};
+
+/** A SoA list of correspondences (T=float) \sa TMatchingPairList */
+using TMatchingPairListSoA = TMatchingPairListSoATempl<float>;
+
+/** A SoA list of correspondences (T=double) \sa TMatchingPairList_d */
+using TMatchingPairListSoA_d = TMatchingPairListSoATempl<double>;
+
+/** @} */
+
+}  // namespace mrpt::tfest
@@ -13,6 +13,7 @@
 #include <mrpt/poses/CPosePDFSOG.h>
 #include <mrpt/poses/poses_frwds.h>
 #include <mrpt/tfest/TMatchingPair.h>
+#include <mrpt/tfest/TMatchingPairListSoA.h>
 #include <mrpt/tfest/indiv-compat-decls.h>
 
 namespace mrpt
@@ -69,6 +70,23 @@ bool se2_l2(
 	const mrpt::tfest::TMatchingPairList& in_correspondences,
 	mrpt::poses::CPosePDFGaussian& out_transformation);
 
+/** \overload
+ *
+ * This version takes the correspondences in SoA layout, and computes the
+ * centroids and the cross-covariance terms with vectorized loops, for any
+ * SIMD instruction set targeted by the compiler.
+ * \note [New in MRPT 2.5.5]
+ */
+bool se2_l2(
+	const mrpt::tfest::TMatchingPairListSoA& in_correspondences,
+	mrpt::math::TPose2D& out_transformation,
+	mrpt::math::CMatrixDouble33* out_estimateCovariance = nullptr);
+
+/** \overload */
+bool se2_l2(
+	const mrpt::tfest::TMatchingPairListSoA& in_correspondences,
+	mrpt::poses::CPosePDFGaussian& out_transformation);
+
 /** Parameters for se2_l2_robust(). See function for more details */
 struct TSE2RobustParams
 {
@@ -110,6 +128,22 @@ struct TSE2RobustParams
 	/** (Default=false) */
 	bool verbose{false};
 
+	/** Number of threads to evaluate RANSAC hypotheses (0=all cores).
+	 * Hypotheses are generated in batches of `ransac_batchSize`, each one
+	 * with its own random generator seeded from `ransac_seed` and the batch
+	 * index, so results do not depend on the number of threads.
+	 * user_individual_compat_callback must be thread-safe if this is not 1.
+	 * Only used if ransac_algorithmForLandmarks=true: otherwise, all
+	 * hypotheses share the marks of already selected points.
+	 * (Default=1) */
+	unsigned int numThreads{1};
+	/** Number of hypotheses per batch (see numThreads). (Default=16) */
+	unsigned int ransac_batchSize{16};
+	/** Base seed of the random generators of all batches. The special value
+	 * 0 (default) takes it from mrpt::random::getRandomGenerator(), so
+	 * results can be reproduced by seeding the global generator. */
+	uint32_t ransac_seed{0};
+
 	/** If provided, this user callback will be invoked to determine the
 	 * individual compatibility between each potential pair
 	 * of elements. Can check image descriptors, geometrical properties, etc.
@@ -187,6 +221,18 @@ bool se2_l2_robust(
 	const double in_normalizationStd, const TSE2RobustParams& in_ransac_params,
 	TSE2RobustResult& out_results);
 
+/** \overload
+ *
+ * This version takes the correspondences in SoA layout. The AoS version
+ * converts its input once and calls this one: the transformations of all
+ * RANSAC subsets are estimated from indices into the SoA list.
+ * \note [New in MRPT 2.5.5]
+ */
+bool se2_l2_robust(
+	const mrpt::tfest::TMatchingPairListSoA& in_correspondences,
+	const double in_normalizationStd, const TSE2RobustParams& in_ransac_params,
+	TSE2RobustResult& out_results);
+
 /** @} */  // end of grouping
 }  // namespace tfest
 }  // namespace mrpt
@@ -13,6 +13,7 @@
 #include <mrpt/poses/CPose3DQuat.h>
 #include <mrpt/poses/poses_frwds.h>
 #include <mrpt/tfest/TMatchingPair.h>
+#include <mrpt/tfest/TMatchingPairListSoA.h>
 #include <mrpt/tfest/indiv-compat-decls.h>
 
 namespace mrpt::tfest
@@ -54,6 +55,24 @@ bool se3_l2(
 	mrpt::poses::CPose3DQuat& out_transform, double& out_scale,
 	bool forceScaleToUnity = false);
 
+/** \overload
+ *
+ * This version takes the correspondences in SoA layout, and computes the
+ * centroids and the cross-covariance matrix with vectorized loops. Prefer it
+ * for large sets of correspondences, e.g. in ICP, reusing the SoA container.
+ * \note [New in MRPT 2.5.5]
+ */
+bool se3_l2(
+	const mrpt::tfest::TMatchingPairListSoA& in_correspondences,
+	mrpt::poses::CPose3DQuat& out_transform, double& out_scale,
+	bool forceScaleToUnity = false);
+
+/// \overload (for double precision points)
+bool se3_l2(
+	const mrpt::tfest::TMatchingPairListSoA_d& in_correspondences,
+	mrpt::poses::CPose3DQuat& out_transform, double& out_scale,
+	bool forceScaleToUnity = false);
+
 /** \overload
  *
  * This version accepts corresponding points as two vectors of TPoint3D (must
@@ -92,6 +111,20 @@ struct TSE3RobustParams
 	/** (Default=false) */
 	bool verbose{false};
 
+	/** Number of threads to evaluate RANSAC hypotheses (0=all cores).
+	 * Hypotheses are generated in batches of `ransac_batchSize`, each one
+	 * with its own random generator seeded from `ransac_seed` and the batch
+	 * index, so results do not depend on the number of threads.
+	 * user_individual_compat_callback must be thread-safe if this is not 1.
+	 * (Default=1) */
+	unsigned int numThreads{1};
+	/** Number of hypotheses per batch (see numThreads). (Default=16) */
+	unsigned int ransac_batchSize{16};
+	/** Base seed of the random generators of all batches. The special value
+	 * 0 (default) takes it from mrpt::random::getRandomGenerator(), so
+	 * results can be reproduced by seeding the global generator. */
+	uint32_t ransac_seed{0};
+
 	/** If provided, this user callback will be invoked to determine the
 	 * individual compatibility between each potential pair
 	 * of elements. Can check image descriptors, geometrical properties, etc.
@@ -130,6 +163,11 @@ struct TSE3RobustResult
  * \param[in] in_params Method parameters (see docs for TSE3RobustParams)
  * \param[out] out_results Results: transformation, scale, etc.
  *
+ * Hypotheses may be evaluated in parallel (see TSE3RobustParams::numThreads).
+ * Each consensus set is built incrementally from the moments of the minimal
+ * set, and abandoned as soon as it cannot become larger than the best one so
+ * far, which does not change the result.
+ *
  * \return True if the minimum number of correspondences was found, false
  * otherwise.
  * \note Implemented by FAMD, 2008. Re-factored by JLBC, 2015.
@@ -141,5 +179,16 @@ bool se3_l2_robust(
 	const mrpt::tfest::TMatchingPairList& in_correspondences,
 	const TSE3RobustParams& in_params, TSE3RobustResult& out_results);
 
+/** \overload
+ *
+ * This version takes the correspondences in SoA layout. The AoS version
+ * converts its input once and calls this one: all RANSAC iterations work
+ * on subsets of indices into the SoA list, without copying correspondences.
+ * \note [New in MRPT 2.5.5]
+ */
+bool se3_l2_robust(
+	const mrpt::tfest::TMatchingPairListSoA& in_correspondences,
+	const TSE3RobustParams& in_params, TSE3RobustResult& out_results);
+
 /** @} */  // end of grouping
 }  // namespace mrpt::tfest
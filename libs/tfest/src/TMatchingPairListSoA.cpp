@@ -0,0 +1,143 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "tfest-precomp.h"	// Precompiled headers
+//
+#include <mrpt/core/exceptions.h>
+
+#include "TMatchingPairListSoA_internal.h"
+
+using namespace mrpt::tfest;
+
+// The kernels below accumulate into LANES independent partial sums, with
+// fixed-size inner loops the compiler turns into SIMD code for the target
+// instruction set (SSE, AVX2, NEON,...), without any intrinsics. Partial sums
+// are reduced in double precision at the end.
+namespace
+{
+constexpr size_t LANES = 8;
+
+// Accessors to the i-th element: contiguous or through a list of indices.
+struct AllIdxs
+{
+	size_t operator()(size_t i) const { return i; }
+};
+struct SubsetIdxs
+{
+	const uint32_t* idxs;
+	size_t operator()(size_t i) const { return idxs[i]; }
+};
+
+template <typename T>
+double reduceLanes(const T (&acc)[LANES])
+{
+	double s = 0;
+	for (size_t j = 0; j < LANES; j++)
+		s += acc[j];
+	return s;
+}
+
+template <int DIM, typename T, class IDX>
+internal::corrs_moments_t corrs_moments_impl(
+	const TMatchingPairListSoATempl<T>& c, const IDX& at, const size_t N)
+{
+	internal::corrs_moments_t ret;
+	ret.N = N;
+	if (!N) return ret;
+
+	const T* g[3] = {c.global_x.data(), c.global_y.data(), c.global_z.data()};
+	const T* l[3] = {c.local_x.data(), c.local_y.data(), c.local_z.data()};
+
+	// 1st pass: centroids.
+	T sumG[DIM][LANES] = {}, sumL[DIM][LANES] = {};
+	size_t i = 0;
+	for (; i + LANES <= N; i += LANES)
+	{
+		for (int k = 0; k < DIM; k++)
+			for (size_t j = 0; j < LANES; j++)
+			{
+				sumG[k][j] += g[k][at(i + j)];
+				sumL[k][j] += l[k][at(i + j)];
+			}
+	}
+	for (; i < N; i++)
+	{
+		for (int k = 0; k < DIM; k++)
+		{
+			sumG[k][0] += g[k][at(i)];
+			sumL[k][0] += l[k][at(i)];
+		}
+	}
+
+	const double N_inv = 1.0 / N;
+	T mG[DIM], mL[DIM];
+	for (int k = 0; k < DIM; k++)
+	{
+		ret.mean_global[k] = reduceLanes(sumG[k]) * N_inv;
+		ret.mean_local[k] = reduceLanes(sumL[k]) * N_inv;
+		mG[k] = static_cast<T>(ret.mean_global[k]);
+		mL[k] = static_cast<T>(ret.mean_local[k]);
+	}
+
+	// 2nd pass: cross-covariance and squared norms, on centered coordinates
+	// to keep the precision of float accumulators for far-away points:
+	T S[DIM][DIM][LANES] = {}, sqrG[DIM][LANES] = {}, sqrL[DIM][LANES] = {};
+	const auto accumulate = [&](size_t idx, size_t j) {
+		T dG[DIM], dL[DIM];
+		for (int k = 0; k < DIM; k++)
+		{
+			dG[k] = g[k][idx] - mG[k];
+			dL[k] = l[k][idx] - mL[k];
+			sqrG[k][j] += dG[k] * dG[k];
+			sqrL[k][j] += dL[k] * dL[k];
+		}
+		for (int r = 0; r < DIM; r++)
+			for (int q = 0; q < DIM; q++)
+				S[r][q][j] += dL[r] * dG[q];
+	};
+	for (i = 0; i + LANES <= N; i += LANES)
+		for (size_t j = 0; j < LANES; j++)
+			accumulate(at(i + j), j);
+	for (; i < N; i++)
+		accumulate(at(i), 0);
+
+	for (int r = 0; r < DIM; r++)
+	{
+		ret.sqr_global[r] = reduceLanes(sqrG[r]);
+		ret.sqr_local[r] = reduceLanes(sqrL[r]);
+		for (int q = 0; q < DIM; q++)
+			ret.S[r][q] = reduceLanes(S[r][q]);
+	}
+	return ret;
+}
+}  // namespace
+
+template <int DIM, typename T>
+internal::corrs_moments_t internal::corrs_moments(
+	const TMatchingPairListSoATempl<T>& c, const uint32_t* idxs, size_t n)
+{
+	static_assert(DIM == 2 || DIM == 3);
+	if (idxs) return corrs_moments_impl<DIM>(c, SubsetIdxs{idxs}, n);
+
+	ASSERT_LE_(n, c.size());
+	return corrs_moments_impl<DIM>(c, AllIdxs(), n);
+}
+
+// Explicit instantiations:
+namespace mrpt::tfest::internal
+{
+template corrs_moments_t corrs_moments<2, float>(
+	const TMatchingPairListSoATempl<float>&, const uint32_t*, size_t);
+template corrs_moments_t corrs_moments<3, float>(
+	const TMatchingPairListSoATempl<float>&, const uint32_t*, size_t);
+template corrs_moments_t corrs_moments<2, double>(
+	const TMatchingPairListSoATempl<double>&, const uint32_t*, size_t);
+template corrs_moments_t corrs_moments<3, double>(
+	const TMatchingPairListSoATempl<double>&, const uint32_t*, size_t);
+}  // namespace mrpt::tfest::internal
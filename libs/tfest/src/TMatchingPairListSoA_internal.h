@@ -0,0 +1,86 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/math/CMatrixFixed.h>
+#include <mrpt/math/TPose2D.h>
+#include <mrpt/poses/CPose3DQuat.h>
+#include <mrpt/tfest/TMatchingPairListSoA.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace mrpt::tfest::internal
+{
+/** Centroids and centered second-order moments of a set of correspondences,
+ * as needed by the closed-form SE(2) and SE(3) estimators. */
+struct corrs_moments_t
+{
+	size_t N = 0;
+	double mean_global[3] = {0, 0, 0};
+	double mean_local[3] = {0, 0, 0};
+	/** Cross-covariance: S[r][c] = sum_i (local_r - mean) * (global_c - mean)
+	 */
+	double S[3][3] = {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}};
+	/** Sums of squared centered coordinates, for each axis */
+	double sqr_global[3] = {0, 0, 0};
+	double sqr_local[3] = {0, 0, 0};
+};
+
+/** Computes the moments of the correspondences `c[idxs[i]]`,
+ * `i=0,...,n-1`, or of the first `n` correspondences if `idxs` is nullptr.
+ * Only the x,y coordinates are used for DIM=2.
+ * Implemented for T=float and T=double, and DIM=2 and DIM=3.
+ */
+template <int DIM, typename T>
+corrs_moments_t corrs_moments(
+	const TMatchingPairListSoATempl<T>& c, const uint32_t* idxs, size_t n);
+
+/** Adds one correspondence to the moments, updating the centered sums
+ * incrementally (Welford's method) */
+inline void corrs_moments_add(
+	corrs_moments_t& m, const double g[3], const double l[3])
+{
+	const double N1 = static_cast<double>(m.N + 1);
+	const double f = m.N / N1;
+	double dG[3], dL[3];
+	for (int k = 0; k < 3; k++)
+	{
+		dG[k] = g[k] - m.mean_global[k];
+		dL[k] = l[k] - m.mean_local[k];
+		m.mean_global[k] += dG[k] / N1;
+		m.mean_local[k] += dL[k] / N1;
+		m.sqr_global[k] += f * dG[k] * dG[k];
+		m.sqr_local[k] += f * dL[k] * dL[k];
+	}
+	for (int r = 0; r < 3; r++)
+		for (int c = 0; c < 3; c++)
+			m.S[r][c] += f * dL[r] * dG[c];
+	m.N++;
+}
+
+/** Horn's method from the moments of the correspondences (3D only) */
+bool se3_l2_from_moments(
+	const corrs_moments_t& m, mrpt::poses::CPose3DQuat& out_transform,
+	double& out_scale, bool forceScaleToUnity);
+
+/** se2_l2() over a subset of a SoA list (see corrs_moments()) */
+bool se2_l2_soa(
+	const TMatchingPairListSoA& c, const uint32_t* idxs, size_t n,
+	mrpt::math::TPose2D& out_transformation,
+	mrpt::math::CMatrixDouble33* out_estimateCovariance);
+
+/** se3_l2() over a subset of a SoA list (see corrs_moments()) */
+template <typename T>
+bool se3_l2_soa(
+	const TMatchingPairListSoATempl<T>& c, const uint32_t* idxs, size_t n,
+	mrpt::poses::CPose3DQuat& out_transform, double& out_scale,
+	bool forceScaleToUnity);
+
+}  // namespace mrpt::tfest::internal
@@ -0,0 +1,83 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/core/parallel_for.h>
+#include <mrpt/random/RandomGenerators.h>
+
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+namespace mrpt::tfest::internal
+{
+/** Draws random samples without replacement from [0,N) with a lazy
+ * Fisher-Yates shuffle: drawing k samples costs O(k) instead of permuting
+ * the whole range. rewind() undoes the swaps, in O(k) too, so the same
+ * object can be reused among RANSAC hypotheses. */
+class LazyPermutation
+{
+   public:
+	explicit LazyPermutation(size_t N) : m_perm(N)
+	{
+		std::iota(m_perm.begin(), m_perm.end(), 0);
+	}
+
+	/** \return false if all elements were already drawn */
+	bool draw(mrpt::random::CRandomGenerator& rng, uint32_t& out)
+	{
+		const size_t j = m_swaps.size();
+		if (j >= m_perm.size()) return false;
+		const size_t r = j + rng.drawUniform32bit() % (m_perm.size() - j);
+		std::swap(m_perm[j], m_perm[r]);
+		m_swaps.push_back(static_cast<uint32_t>(r));
+		out = m_perm[j];
+		return true;
+	}
+
+	size_t numDrawn() const { return m_swaps.size(); }
+
+	void rewind()
+	{
+		for (size_t j = m_swaps.size(); j-- > 0;)
+			std::swap(m_perm[j], m_perm[m_swaps[j]]);
+		m_swaps.clear();
+	}
+
+   private:
+	std::vector<uint32_t> m_perm, m_swaps;
+};
+
+/** The base seed of all batches: `userSeed`, or a number drawn from the
+ * global random generator if it is 0. */
+inline uint32_t ransacBaseSeed(uint32_t userSeed)
+{
+	return userSeed != 0
+		? userSeed
+		: mrpt::random::getRandomGenerator().drawUniform32bit();
+}
+
+/** Evaluates `evalBatch(batchIdx)` for batches
+ * `[firstBatch, firstBatch+nBatches)` in up to `numThreads` threads, and
+ * returns their outputs in order. Each batch should draw its hypotheses from
+ * a generator seeded with mrpt::parallelTaskSeed(), so results do not depend
+ * on the number of threads. */
+template <class RESULT, class EVAL_BATCH>
+std::vector<RESULT> ransacEvalBatches(
+	size_t numThreads, size_t firstBatch, size_t nBatches,
+	const EVAL_BATCH& evalBatch)
+{
+	std::vector<RESULT> out(nBatches);
+	mrpt::parallelFor(nBatches, 1, numThreads, [&](size_t i, size_t) {
+		out[i] = evalBatch(firstBatch + i);
+	});
+	return out;
+}
+
+}  // namespace mrpt::tfest::internal
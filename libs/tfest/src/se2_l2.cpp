@@ -15,6 +15,7 @@
 #include <mrpt/random.h>
 #include <mrpt/tfest/se2.h>
 
+#include "TMatchingPairListSoA_internal.h"
 #include "se2_l2_internal.h"
 
 using namespace mrpt;
@@ -82,48 +83,16 @@ static mrpt::tfest::internal::se2_l2_impl_return_t<float> se2_l2_impl(
 	return ret;
 }
 
-/*---------------------------------------------------------------
-			leastSquareErrorRigidTransformation
-
-   Compute the best transformation (x,y,phi) given a set of
-	correspondences between 2D points in two different maps.
-   This method is intensively used within ICP.
-  ---------------------------------------------------------------*/
-bool tfest::se2_l2(
-	const TMatchingPairList& in_correspondences, TPose2D& out_transformation,
+// Pose and covariance from the means and Ax,Ay values. "sqrSums" computes the
+// sums of squared centered coordinates, only if the covariance is requested.
+template <typename T, class SQR_SUMS>
+static void se2_l2_pose_and_cov(
+	const size_t N,
+	const mrpt::tfest::internal::se2_l2_impl_return_t<T>& implRet,
+	const SQR_SUMS& sqrSums, TPose2D& out_transformation,
 	CMatrixDouble33* out_estimateCovariance)
 {
-	MRPT_START
-
-	const size_t N = in_correspondences.size();
-
-	if (N < 2) return false;
-
-	const float N_inv = 1.0f / N;  // For efficiency, keep this value.
-
-	// ----------------------------------------------------------------------
-	// Compute the estimated pose. Notation from the paper:
-	// "Mobile robot motion estimation by 2d scan matching with genetic and
-	// iterative
-	// closest point algorithms", J.L. Martinez Rodriguez, A.J. Gonzalez, J.
-	// Morales Rodriguez, A. Mandow Andaluz, A. J. Garcia Cerezo, Journal of
-	// Field Robotics, 2006.
-	// ----------------------------------------------------------------------
-
-	// ----------------------------------------------------------------------
-	//  For the formulas of the covariance, see:
-	//   https://www.mrpt.org/Paper:Occupancy_Grid_Matching
-	//   and Jose Luis Blanco's PhD thesis.
-	// ----------------------------------------------------------------------
-	internal::se2_l2_impl_return_t<float> implRet;
-#if MRPT_ARCH_INTEL_COMPATIBLE
-	if (mrpt::cpu::supports(mrpt::cpu::feature::SSE2))
-	{ implRet = mrpt::tfest::internal::se2_l2_impl_SSE2(in_correspondences); }
-	else
-#endif
-	{
-		implRet = se2_l2_impl(in_correspondences);
-	}
+	const double N_inv = 1.0 / N;
 
 	out_transformation.phi = (implRet.Ax != 0 || implRet.Ay != 0)
 		? atan2(
@@ -144,18 +113,12 @@ bool tfest::se2_l2(
 
 		// Compute the normalized covariance matrix:
 		// -------------------------------------------
-		double var_x_a = 0, var_y_a = 0, var_x_b = 0, var_y_b = 0;
+		double var_x_a, var_y_a, var_x_b, var_y_b;
 		const double N_1_inv = 1.0 / (N - 1);
 
 		// 0) Precompute the unbiased variances estimations:
 		// ----------------------------------------------------
-		for (const auto& in_correspondence : in_correspondences)
-		{
-			var_x_a += square(in_correspondence.global.x - implRet.mean_x_a);
-			var_y_a += square(in_correspondence.global.y - implRet.mean_y_a);
-			var_x_b += square(in_correspondence.local.x - implRet.mean_x_b);
-			var_y_b += square(in_correspondence.local.y - implRet.mean_y_b);
-		}
+		sqrSums(var_x_a, var_y_a, var_x_b, var_y_b);
 		var_x_a *= N_1_inv;	 //  /= (N-1)
 		var_y_a *= N_1_inv;
 		var_x_b *= N_1_inv;
@@ -199,8 +162,115 @@ bool tfest::se2_l2(
 			(implRet.mean_y_b * implRet.Ay - implRet.mean_x_b * implRet.Ax) /
 			pow(D, 1.5);
 	}
+}
+
+/*---------------------------------------------------------------
+			leastSquareErrorRigidTransformation
+
+   Compute the best transformation (x,y,phi) given a set of
+	correspondences between 2D points in two different maps.
+   This method is intensively used within ICP.
+  ---------------------------------------------------------------*/
+bool tfest::se2_l2(
+	const TMatchingPairList& in_correspondences, TPose2D& out_transformation,
+	CMatrixDouble33* out_estimateCovariance)
+{
+	MRPT_START
+
+	const size_t N = in_correspondences.size();
+
+	if (N < 2) return false;
+
+	// ----------------------------------------------------------------------
+	// Compute the estimated pose. Notation from the paper:
+	// "Mobile robot motion estimation by 2d scan matching with genetic and
+	// iterative
+	// closest point algorithms", J.L. Martinez Rodriguez, A.J. Gonzalez, J.
+	// Morales Rodriguez, A. Mandow Andaluz, A. J. Garcia Cerezo, Journal of
+	// Field Robotics, 2006.
+	// ----------------------------------------------------------------------
+
+	// ----------------------------------------------------------------------
+	//  For the formulas of the covariance, see:
+	//   https://www.mrpt.org/Paper:Occupancy_Grid_Matching
+	//   and Jose Luis Blanco's PhD thesis.
+	// ----------------------------------------------------------------------
+	mrpt::tfest::internal::se2_l2_impl_return_t<float> implRet;
+#if MRPT_ARCH_INTEL_COMPATIBLE
+	if (mrpt::cpu::supports(mrpt::cpu::feature::SSE2))
+	{ implRet = mrpt::tfest::internal::se2_l2_impl_SSE2(in_correspondences); }
+	else
+#endif
+	{
+		implRet = se2_l2_impl(in_correspondences);
+	}
+
+	se2_l2_pose_and_cov(
+		N, implRet,
+		[&](double& var_x_a, double& var_y_a, double& var_x_b,
+			double& var_y_b) {
+			var_x_a = var_y_a = var_x_b = var_y_b = 0;
+			for (const auto& c : in_correspondences)
+			{
+				var_x_a += square(c.global.x - implRet.mean_x_a);
+				var_y_a += square(c.global.y - implRet.mean_y_a);
+				var_x_b += square(c.local.x - implRet.mean_x_b);
+				var_y_b += square(c.local.y - implRet.mean_y_b);
+			}
+		},
+		out_transformation, out_estimateCovariance);
 
 	return true;
 
 	MRPT_END
 }
+
+bool mrpt::tfest::internal::se2_l2_soa(
+	const TMatchingPairListSoA& c, const uint32_t* idxs, size_t n,
+	TPose2D& out_transformation, CMatrixDouble33* out_estimateCovariance)
+{
+	if (n < 2) return false;
+
+	const auto m = mrpt::tfest::internal::corrs_moments<2>(c, idxs, n);
+
+	// Same Ax,Ay than se2_l2_impl(), from centered sums:
+	mrpt::tfest::internal::se2_l2_impl_return_t<double> implRet;
+	implRet.mean_x_a = m.mean_global[0];
+	implRet.mean_y_a = m.mean_global[1];
+	implRet.mean_x_b = m.mean_local[0];
+	implRet.mean_y_b = m.mean_local[1];
+	implRet.Ax = n * (m.S[0][0] + m.S[1][1]);
+	implRet.Ay = n * (m.S[0][1] - m.S[1][0]);
+
+	se2_l2_pose_and_cov(
+		n, implRet,
+		[&](double& var_x_a, double& var_y_a, double& var_x_b,
+			double& var_y_b) {
+			var_x_a = m.sqr_global[0];
+			var_y_a = m.sqr_global[1];
+			var_x_b = m.sqr_local[0];
+			var_y_b = m.sqr_local[1];
+		},
+		out_transformation, out_estimateCovariance);
+	return true;
+}
+
+bool tfest::se2_l2(
+	const TMatchingPairListSoA& in_correspondences,
+	TPose2D& out_transformation, CMatrixDouble33* out_estimateCovariance)
+{
+	return mrpt::tfest::internal::se2_l2_soa(
+		in_correspondences, nullptr, in_correspondences.size(),
+		out_transformation, out_estimateCovariance);
+}
+
+bool tfest::se2_l2(
+	const TMatchingPairListSoA& in_correspondences,
+	CPosePDFGaussian& out_transformation)
+{
+	mrpt::math::TPose2D p;
+	const bool ret =
+		tfest::se2_l2(in_correspondences, p, &out_transformation.cov);
+	out_transformation.mean = CPose2D(p);
+	return ret;
+}
@@ -20,6 +20,9 @@
 
 #include <iostream>
 
+#include "TMatchingPairListSoA_internal.h"
+#include "ransac_internal.h"
+
 using namespace mrpt;
 using namespace mrpt::tfest;
 using namespace mrpt::random;
@@ -81,6 +84,41 @@ bool tfest::se2_l2_robust(
 	const mrpt::tfest::TMatchingPairList& in_correspondences,
 	const double normalizationStd, const TSE2RobustParams& params,
 	TSE2RobustResult& results)
+{
+	// Convert once, then work on indices into the SoA list:
+	return se2_l2_robust(
+		TMatchingPairListSoA(in_correspondences), normalizationStd, params,
+		results);
+}
+
+namespace
+{
+// The outcome of one RANSAC hypothesis:
+struct TSE2Hypothesis
+{
+	/** The subset, as indices into the input correspondences */
+	std::vector<uint32_t> subSetIdxs;
+	/** Only valid if the subset has ransac_minSetSize elements at least */
+	CPosePDFGaussian estimation;
+	double RMSE = std::numeric_limits<double>::max();
+};
+}  // namespace
+
+// se2_l2() of a subset of correspondences, as a Gaussian:
+static void se2_l2_subset(
+	const TMatchingPairListSoA& corrs, const std::vector<uint32_t>& idxs,
+	CPosePDFGaussian& out_transformation)
+{
+	mrpt::math::TPose2D p;
+	mrpt::tfest::internal::se2_l2_soa(
+		corrs, idxs.data(), idxs.size(), p, &out_transformation.cov);
+	out_transformation.mean = CPose2D(p);
+}
+
+bool tfest::se2_l2_robust(
+	const mrpt::tfest::TMatchingPairListSoA& in_correspondences,
+	const double normalizationStd, const TSE2RobustParams& params,
+	TSE2RobustResult& results)
 {
 	//#define DO_PROFILING
 
@@ -111,10 +149,10 @@ bool tfest::se2_l2_robust(
 #endif
 	// Find the max. index of "this" and "other:
 	unsigned int maxThis = 0, maxOther = 0;
-	for (const auto& in_correspondence : in_correspondences)
+	for (size_t i = 0; i < nCorrs; i++)
 	{
-		maxThis = max(maxThis, in_correspondence.globalIdx);
-		maxOther = max(maxOther, in_correspondence.localIdx);
+		maxThis = max(maxThis, in_correspondences.globalIdx[i]);
+		maxOther = max(maxOther, in_correspondences.localIdx[i]);
 	}
 #ifdef DO_PROFILING
 	timlog.leave("ransac.find_max*");
@@ -128,13 +166,14 @@ bool tfest::se2_l2_robust(
 	std::vector<bool> hasCorrThis(maxThis + 1, false);
 	std::vector<bool> hasCorrOther(maxOther + 1, false);
 	unsigned int howManyDifCorrs = 0;
-	for (const auto& in_correspondence : in_correspondences)
+	for (size_t i = 0; i < nCorrs; i++)
 	{
-		if (!hasCorrThis[in_correspondence.globalIdx] &&
-			!hasCorrOther[in_correspondence.localIdx])
+		const auto globalIdx = in_correspondences.globalIdx[i];
+		const auto localIdx = in_correspondences.localIdx[i];
+		if (!hasCorrThis[globalIdx] && !hasCorrOther[localIdx])
 		{
-			hasCorrThis[in_correspondence.globalIdx] = true;
-			hasCorrOther[in_correspondence.localIdx] = true;
+			hasCorrThis[globalIdx] = true;
+			hasCorrOther[localIdx] = true;
 			howManyDifCorrs++;
 		}
 	}
@@ -169,15 +208,15 @@ bool tfest::se2_l2_robust(
 		std::vector<int> duplis;
 		for (unsigned j = k; j < nCorrs - 1; j++)
 		{
-			if (in_correspondences[k].global.x ==
-					in_correspondences[j].global.x &&
-				in_correspondences[k].global.y ==
-					in_correspondences[j].global.y &&
-				in_correspondences[k].global.z ==
-					in_correspondences[j].global.z)
-				duplis.push_back(in_correspondences[j].globalIdx);
+			if (in_correspondences.global_x[k] ==
+					in_correspondences.global_x[j] &&
+				in_correspondences.global_y[k] ==
+					in_correspondences.global_y[j] &&
+				in_correspondences.global_z[k] ==
+					in_correspondences.global_z[j])
+				duplis.push_back(in_correspondences.globalIdx[j]);
 		}
-		listDuplicatedLandmarksThis[in_correspondences[k].globalIdx] = duplis;
+		listDuplicatedLandmarksThis[in_correspondences.globalIdx[k]] = duplis;
 	}
 
 	std::vector<std::vector<int>> listDuplicatedLandmarksOther(maxOther + 1);
@@ -186,89 +225,40 @@ bool tfest::se2_l2_robust(
 		std::vector<int> duplis;
 		for (unsigned j = k; j < nCorrs - 1; j++)
 		{
-			if (in_correspondences[k].local.x ==
-					in_correspondences[j].local.x &&
-				in_correspondences[k].local.y ==
-					in_correspondences[j].local.y &&
-				in_correspondences[k].local.z == in_correspondences[j].local.z)
-				duplis.push_back(in_correspondences[j].localIdx);
+			if (in_correspondences.local_x[k] ==
+					in_correspondences.local_x[j] &&
+				in_correspondences.local_y[k] ==
+					in_correspondences.local_y[j] &&
+				in_correspondences.local_z[k] == in_correspondences.local_z[j])
+				duplis.push_back(in_correspondences.localIdx[j]);
 		}
-		listDuplicatedLandmarksOther[in_correspondences[k].localIdx] = duplis;
+		listDuplicatedLandmarksOther[in_correspondences.localIdx[k]] = duplis;
 	}
 #endif
 
 	std::deque<TMatchingPairList> alreadyAddedSubSets;
 
-	CPosePDFGaussian referenceEstimation;
-	CPoint2DPDFGaussian pt_this;
-
 	const double ransac_consistency_test_chi2_quantile = 0.99;
 	const double chi2_thres_dim1 =
 		mrpt::math::chi2inv(ransac_consistency_test_chi2_quantile, 1);
 
-	// -------------------------
-	//		The RANSAC loop
-	// -------------------------
-	size_t largest_consensus_yet = 0;  // Used for dynamic # of steps
-	double largestSubSet_RMSE = std::numeric_limits<double>::max();
-
-	results.ransac_iters = params.ransac_nSimulations;
-	const bool use_dynamic_iter_number = results.ransac_iters == 0;
-	if (use_dynamic_iter_number)
-	{
-		ASSERT_(
-			params.probability_find_good_model > 0 &&
-			params.probability_find_good_model < 1);
-		// Set an initial # of iterations:
-		results.ransac_iters = 10;	// It doesn't matter actually, since will be
-		// changed in the first loop
-	}
+	// Builds one hypothesis: a subset of up to "ransac_maxSetSize" elements
+	// that achieve consensus. Only reads shared data, except the selection
+	// marks, so hypotheses with their own marks can be built in parallel.
+	const auto evalHypothesis = [&](CRandomGenerator& rng,
+									mrpt::tfest::internal::LazyPermutation&
+										perm,
+									std::vector<bool>& alreadySelectedThis,
+									std::vector<bool>& alreadySelectedOther,
+									TSE2Hypothesis& h) {
+		auto& subSetIdxs = h.subSetIdxs;
+		auto& referenceEstimation = h.estimation;
+		subSetIdxs.clear();
 
-	std::vector<bool> alreadySelectedThis, alreadySelectedOther;
-
-	if (!params.ransac_algorithmForLandmarks)
-	{
-		alreadySelectedThis.assign(maxThis + 1, false);
-		alreadySelectedOther.assign(maxOther + 1, false);
-	}
-	// else -> It will be done anyway inside the for() below
-
-	// First: Build a permutation of the correspondences to pick from it
-	// sequentially:
-	std::vector<size_t> corrsIdxs(nCorrs), corrsIdxsPermutation;
-	for (size_t i = 0; i < nCorrs; i++)
-		corrsIdxs[i] = i;
-
-	size_t iter_idx;
-	for (iter_idx = 0; iter_idx < results.ransac_iters;
-		 iter_idx++)  // results.ransac_iters can be dynamic
-	{
-#ifdef DO_PROFILING
-		CTimeLoggerEntry tle(timlog, "ransac.iter");
-#endif
-
-#ifdef DO_PROFILING
-		timlog.enter("ransac.permute");
-#endif
-		getRandomGenerator().permuteVector(corrsIdxs, corrsIdxsPermutation);
-
-#ifdef DO_PROFILING
-		timlog.leave("ransac.permute");
-#endif
-
-		TMatchingPairList subSet;
-
-		// Select a subset of correspondences at random:
 		if (params.ransac_algorithmForLandmarks)
 		{
-#ifdef DO_PROFILING
-			timlog.enter("ransac.reset_selection_marks");
-#endif
 			alreadySelectedThis.assign(maxThis + 1, false);
 			alreadySelectedOther.assign(maxOther + 1, false);
-#ifdef DO_PROFILING
-			timlog.leave("ransac.reset_selection_marks");
-#endif
 		}
 		else
 		{
@@ -276,17 +266,15 @@ bool tfest::se2_l2_robust(
 			// as weights
 		}
 
-// Try to build a subsetof "ransac_maxSetSize" (maximum) elements that achieve
-// consensus:
-// ------------------------------------------------------------------------------------------
-#ifdef DO_PROFILING
-		timlog.enter("ransac.inner_loops");
-#endif
-		for (unsigned int j = 0;
-			 j < nCorrs && subSet.size() < params.ransac_maxSetSize; j++)
+		// Inverse covariance of "referenceEstimation (+) point_other". It
+		// does not depend on the point, so it is computed once per subset:
+		CMatrixDouble22 ptCovInv;
+
+		uint32_t idx;
+		while (subSetIdxs.size() < params.ransac_maxSetSize &&
+			   perm.draw(rng, idx))
 		{
-			const size_t idx = corrsIdxsPermutation[j];
-			const auto& corr_j = in_correspondences[idx];
+			const auto corr_j = in_correspondences.getPair(idx);
 
 			// Don't pick the same features twice!
 			if (alreadySelectedThis[corr_j.globalIdx] ||
@@ -303,32 +291,29 @@ bool tfest::se2_l2_robust(
 					continue;  // Skip this one!
 			}
 
-			if (subSet.size() < 2)
+			if (subSetIdxs.size() < 2)
 			{
-				// ------------------------------------------------------------------------------------------------------
-				// If we are within the first two correspondences, just add them
-				// to the subset:
-				// ------------------------------------------------------------------------------------------------------
-				subSet.push_back(corr_j);
+				// If we are within the first two correspondences, just add
+				// them to the subset:
+				subSetIdxs.push_back(idx);
 				markAsPicked(corr_j, alreadySelectedThis, alreadySelectedOther);
 
-				if (subSet.size() == 2)
+				if (subSetIdxs.size() == 2)
 				{
-					// Consistency Test: From
-
 					// Check the feasibility of this pair "idx1"-"idx2":
 					//  The distance between the pair of points in MAP1 must be
 					//  very close
 					//   to that of their correspondences in MAP2:
+					const auto c0 = in_correspondences.getPair(subSetIdxs[0]);
 					const double corrs_dist1 =
 						mrpt::math::distanceBetweenPoints(
-							subSet[0].global.x, subSet[0].global.y,
-							subSet[1].global.x, subSet[1].global.y);
+							c0.global.x, c0.global.y, corr_j.global.x,
+							corr_j.global.y);
 
 					const double corrs_dist2 =
 						mrpt::math::distanceBetweenPoints(
-							subSet[0].local.x, subSet[0].local.y,
-							subSet[1].local.x, subSet[1].local.y);
+							c0.local.x, c0.local.y, corr_j.local.x,
+							corr_j.local.y);
 
 					// Is is a consistent possibility?
 					//  We use a chi2 test (see paper for the derivation)
@@ -342,7 +327,9 @@ bool tfest::se2_l2_robust(
 					if (is_acceptable)
 					{
 						// Perform estimation:
-						tfest::se2_l2(subSet, referenceEstimation);
+						se2_l2_subset(
+							in_correspondences, subSetIdxs,
+							referenceEstimation);
 						// Normalized covariance: scale!
 						referenceEstimation.cov *= square(normalizationStd);
 
@@ -358,94 +345,150 @@ bool tfest::se2_l2_robust(
 					{
 						// Remove this correspondence & try again with a
 						// different pair:
-						subSet.erase(subSet.begin() + (subSet.size() - 1));
+						subSetIdxs.pop_back();
 					}
 					else
 					{
 						// Only mark as picked if we're really keeping it:
 						markAsPicked(
 							corr_j, alreadySelectedThis, alreadySelectedOther);
+
+						CPoint2DPDFGaussian pt;
+						referenceEstimation.composePoint(
+							mrpt::math::TPoint2D(0, 0), pt);
+						ptCovInv = pt.cov.inverse();
 					}
 				}
 			}
 			else
 			{
-#ifdef DO_PROFILING
-				timlog.enter("ransac.test_consistency");
-#endif
-
-				// ------------------------------------------------------------------------------------------------------
 				// The normal case:
 				//  - test for "consensus" with the current group:
 				//		- If it is compatible (ransac_maxErrorXY,
 				// ransac_maxErrorPHI), grow the "consensus set"
 				//		- If not, do not add it.
-				// ------------------------------------------------------------------------------------------------------
 
 				// Test for the mahalanobis distance between:
 				//  "referenceEstimation (+) point_other" AND "point_this"
-				referenceEstimation.composePoint(
-					mrpt::math::TPoint2D(corr_j.local.x, corr_j.local.y),
-					pt_this);
-
-				const double maha_dist = pt_this.mahalanobisDistanceToPoint(
-					corr_j.global.x, corr_j.global.y);
-
-				const bool passTest =
-					maha_dist < params.ransac_mahalanobisDistanceThreshold;
-
-				if (passTest)
+				double gx, gy;
+				referenceEstimation.mean.composePoint(
+					corr_j.local.x, corr_j.local.y, gx, gy);
+				const double dx = corr_j.global.x - gx;
+				const double dy = corr_j.global.y - gy;
+				const double maha_dist = std::sqrt(
+					dx * dx * ptCovInv(0, 0) +
+					dx * dy * (ptCovInv(0, 1) + ptCovInv(1, 0)) +
+					dy * dy * ptCovInv(1, 1));
+
+				if (maha_dist < params.ransac_mahalanobisDistanceThreshold)
 				{
 					// OK, consensus passed:
-					subSet.push_back(corr_j);
+					subSetIdxs.push_back(idx);
 					markAsPicked(
 						corr_j, alreadySelectedThis, alreadySelectedOther);
 				}
 				// else -> Test failed
-
-#ifdef DO_PROFILING
-				timlog.leave("ransac.test_consistency");
-#endif
 			}  // end else "normal case"
-
-		}  // end for j
-#ifdef DO_PROFILING
-		timlog.leave("ransac.inner_loops");
-#endif
-
-		const bool has_to_eval_RMSE =
-			(subSet.size() >= params.ransac_minSetSize);
+		}
+		perm.rewind();
 
 		// Compute the RMSE of this matching and the corresponding
 		// transformation (only if we'll use this value below)
-		double this_subset_RMSE = 0;
-		if (has_to_eval_RMSE)
-		{
-#ifdef DO_PROFILING
-			CTimeLoggerEntry tle(timlog, "ransac.comp_rmse");
-#endif
+		h.RMSE = std::numeric_limits<double>::max();
+		if (subSetIdxs.size() < params.ransac_minSetSize) return;
 
-			// Recompute referenceEstimation from all the corrs:
-			tfest::se2_l2(subSet, referenceEstimation);
-			// Normalized covariance: scale!
-			referenceEstimation.cov *= square(normalizationStd);
+		// Recompute referenceEstimation from all the corrs:
+		se2_l2_subset(in_correspondences, subSetIdxs, referenceEstimation);
+		// Normalized covariance: scale!
+		referenceEstimation.cov *= square(normalizationStd);
 
-			for (size_t k = 0; k < subSet.size(); k++)
-			{
-				double gx, gy;
-				referenceEstimation.mean.composePoint(
-					subSet[k].local.x, subSet[k].local.y, gx, gy);
-
-				this_subset_RMSE +=
-					mrpt::math::distanceSqrBetweenPoints<double>(
-						subSet[k].global.x, subSet[k].global.y, gx, gy);
-			}
-			this_subset_RMSE /= std::max(static_cast<size_t>(1), subSet.size());
-		}
-		else
+		double rmse = 0;
+		for (const auto k : subSetIdxs)
 		{
-			this_subset_RMSE = std::numeric_limits<double>::max();
+			double gx, gy;
+			referenceEstimation.mean.composePoint(
+				in_correspondences.local_x[k], in_correspondences.local_y[k],
+				gx, gy);
+
+			rmse += mrpt::math::distanceSqrBetweenPoints<double>(
+				in_correspondences.global_x[k], in_correspondences.global_y[k],
+				gx, gy);
 		}
+		h.RMSE = rmse / subSetIdxs.size();
+	};
+
+	// -------------------------
+	//		The RANSAC loop
+	// -------------------------
+	size_t largest_consensus_yet = 0;  // Used for dynamic # of steps
+	double largestSubSet_RMSE = std::numeric_limits<double>::max();
+
+	results.ransac_iters = params.ransac_nSimulations;
+	const bool use_dynamic_iter_number = results.ransac_iters == 0;
+	if (use_dynamic_iter_number)
+	{
+		ASSERT_(
+			params.probability_find_good_model > 0 &&
+			params.probability_find_good_model < 1);
+		// Set an initial # of iterations:
+		results.ransac_iters = 10;	// It doesn't matter actually, since will be
+		// changed in the first loop
+	}
+
+	// Hypotheses are built in batches, each one with its own random generator,
+	// and merged in order below, so the results do not depend on the number
+	// of threads. For points, the selection marks are shared among all
+	// hypotheses, so batches are built sequentially.
+	const size_t nThreads = params.ransac_algorithmForLandmarks
+		? mrpt::resolveNumThreads(params.numThreads)
+		: 1;
+
+	const size_t batchSize = std::max(1U, params.ransac_batchSize);
+	const uint32_t baseSeed =
+		mrpt::tfest::internal::ransacBaseSeed(params.ransac_seed);
+
+	std::vector<bool> sharedSelectedThis, sharedSelectedOther;
+	if (!params.ransac_algorithmForLandmarks)
+	{
+		sharedSelectedThis.assign(maxThis + 1, false);
+		sharedSelectedOther.assign(maxOther + 1, false);
+	}
+
+	const auto evalBatch = [&](size_t batchIdx) {
+		CRandomGenerator rng(mrpt::parallelTaskSeed(baseSeed, batchIdx));
+		mrpt::tfest::internal::LazyPermutation perm(nCorrs);
+
+		// The # of iterations can only grow if it is dynamic:
+		const size_t first = batchIdx * batchSize;
+		const size_t last = use_dynamic_iter_number
+			? first + batchSize
+			: std::min<size_t>(first + batchSize, results.ransac_iters);
+
+		std::vector<bool> ownSelectedThis, ownSelectedOther;
+		auto& selThis = params.ransac_algorithmForLandmarks
+			? ownSelectedThis
+			: sharedSelectedThis;
+		auto& selOther = params.ransac_algorithmForLandmarks
+			? ownSelectedOther
+			: sharedSelectedOther;
+
+		std::vector<TSE2Hypothesis> hs(last - first);
+		for (auto& h : hs)
+			evalHypothesis(rng, perm, selThis, selOther, h);
+		return hs;
+	};
+
+	// Merges one hypothesis into the results, in the order of iterations.
+	// Returns true if it is good enough to end RANSAC.
+	const auto mergeHypothesis = [&](const TSE2Hypothesis& h,
+									 size_t iter_idx) {
+		TMatchingPairList subSet;
+		subSet.reserve(h.subSetIdxs.size());
+		for (const auto idx : h.subSetIdxs)
+			subSet.push_back(in_correspondences.getPair(idx));
+
+		const auto& referenceEstimation = h.estimation;
+		const double this_subset_RMSE = h.RMSE;
 
 		// Save the estimation result as a "particle", only if the subSet
 		// contains
@@ -583,15 +626,41 @@ bool tfest::se2_l2_robust(
 		}
 
 		// Is the found subset good enough?
-		if (subSet.size() >= params.ransac_minSetSize &&
-			this_subset_RMSE < MAX_RMSE_TO_END)
-		{
-			break;	// end RANSAC iterations.
-		}
+		return subSet.size() >= params.ransac_minSetSize &&
+			this_subset_RMSE < MAX_RMSE_TO_END;
+	};
+
+	size_t iter_idx = 0;
+	bool done = false;
+	for (size_t firstBatch = 0; !done && iter_idx < results.ransac_iters;)
+	{
+		// results.ransac_iters can be dynamic
+		const size_t nBatches = std::min(
+			nThreads,
+			(results.ransac_iters - iter_idx + batchSize - 1) / batchSize);
 
 #ifdef DO_PROFILING
-		timlog.leave("ransac.iter");
+		timlog.enter("ransac.eval_batches");
 #endif
+		const auto batches = mrpt::tfest::internal::ransacEvalBatches<
+			std::vector<TSE2Hypothesis>>(
+			nThreads, firstBatch, nBatches, evalBatch);
+		firstBatch += nBatches;
+#ifdef DO_PROFILING
+		timlog.leave("ransac.eval_batches");
+		CTimeLoggerEntry tle(timlog, "ransac.merge");
+#endif
+
+		for (const auto& batch : batches)
+		{
+			for (const auto& h : batch)
+			{
+				if (iter_idx >= results.ransac_iters || done) break;
+
+				done = mergeHypothesis(h, iter_idx);
+				if (!done) iter_idx++;
+			}
+		}
 	}  // end for each iteration
 
 	if (params.verbose)
@@ -606,7 +675,9 @@ bool tfest::se2_l2_robust(
 	MRPT_END_WITH_CLEAN_UP(
 		printf("nCorrs=%u\n", static_cast<unsigned int>(nCorrs));
 		printf("Saving '_debug_in_correspondences.txt'...");
-		in_correspondences.dumpToFile("_debug_in_correspondences.txt");
+		TMatchingPairList corrs;
+		in_correspondences.asList(corrs);
+		corrs.dumpToFile("_debug_in_correspondences.txt");
 		printf("Ok\n"); printf("Saving '_debug_results.transformation.txt'...");
 		results.transformation.saveToTextFile(
 			"_debug_results.transformation.txt");
@@ -15,6 +15,8 @@
 
 #include <Eigen/Dense>
 
+#include "TMatchingPairListSoA_internal.h"
+
 using namespace mrpt;
 using namespace mrpt::tfest;
 using namespace mrpt::poses;
@@ -67,77 +69,40 @@ using namespace std;
 /*---------------------------------------------------------------
 					se3_l2  (old "HornMethod()")
   ---------------------------------------------------------------*/
-static bool se3_l2_internal(
-	std::vector<mrpt::math::TPoint3D>&
-		points_this,  // IN/OUT: It gets modified!
-	std::vector<mrpt::math::TPoint3D>&
-		points_other,  // IN/OUT: It gets modified!
+// Steps 5-8 above, from the centroids and the S matrix:
+bool mrpt::tfest::internal::se3_l2_from_moments(
+	const mrpt::tfest::internal::corrs_moments_t& m,
 	mrpt::poses::CPose3DQuat& out_transform, double& out_scale,
 	bool forceScaleToUnity)
 {
 	MRPT_START
 
-	ASSERT_EQUAL_(points_this.size(), points_other.size());
-	// Compute the centroids
-	TPoint3D ct_others(0, 0, 0), ct_this(0, 0, 0);
-	const size_t nMatches = points_this.size();
+	if (m.N < 3) return false;	// Nothing we can estimate without 3 points!!
 
-	if (nMatches < 3)
-		return false;  // Nothing we can estimate without 3 points!!
-
-	for (size_t i = 0; i < nMatches; i++)
-	{
-		ct_others += points_other[i];
-		ct_this += points_this[i];
-	}
-
-	const double F = 1.0 / nMatches;
-	ct_others *= F;
-	ct_this *= F;
-
-	CMatrixDouble33 S;	// Zeroed by default
-
-	// Substract the centroid and compute the S matrix of cross products
-	for (size_t i = 0; i < nMatches; i++)
-	{
-		points_this[i] -= ct_this;
-		points_other[i] -= ct_others;
-
-		S(0, 0) += points_other[i].x * points_this[i].x;
-		S(0, 1) += points_other[i].x * points_this[i].y;
-		S(0, 2) += points_other[i].x * points_this[i].z;
-
-		S(1, 0) += points_other[i].y * points_this[i].x;
-		S(1, 1) += points_other[i].y * points_this[i].y;
-		S(1, 2) += points_other[i].y * points_this[i].z;
-
-		S(2, 0) += points_other[i].z * points_this[i].x;
-		S(2, 1) += points_other[i].z * points_this[i].y;
-		S(2, 2) += points_other[i].z * points_this[i].z;
-	}
+	const auto& S = m.S;
 
 	// Construct the N matrix
 	CMatrixDouble44 N;	// Zeroed by default
 
-	N(0, 0) = S(0, 0) + S(1, 1) + S(2, 2);
-	N(0, 1) = S(1, 2) - S(2, 1);
-	N(0, 2) = S(2, 0) - S(0, 2);
-	N(0, 3) = S(0, 1) - S(1, 0);
+	N(0, 0) = S[0][0] + S[1][1] + S[2][2];
+	N(0, 1) = S[1][2] - S[2][1];
+	N(0, 2) = S[2][0] - S[0][2];
+	N(0, 3) = S[0][1] - S[1][0];
 
 	N(1, 0) = N(0, 1);
-	N(1, 1) = S(0, 0) - S(1, 1) - S(2, 2);
-	N(1, 2) = S(0, 1) + S(1, 0);
-	N(1, 3) = S(2, 0) + S(0, 2);
+	N(1, 1) = S[0][0] - S[1][1] - S[2][2];
+	N(1, 2) = S[0][1] + S[1][0];
+	N(1, 3) = S[2][0] + S[0][2];
 
 	N(2, 0) = N(0, 2);
 	N(2, 1) = N(1, 2);
-	N(2, 2) = -S(0, 0) + S(1, 1) - S(2, 2);
-	N(2, 3) = S(1, 2) + S(2, 1);
+	N(2, 2) = -S[0][0] + S[1][1] - S[2][2];
+	N(2, 3) = S[1][2] + S[2][1];
 
 	N(3, 0) = N(0, 3);
 	N(3, 1) = N(1, 3);
 	N(3, 2) = N(2, 3);
-	N(3, 3) = -S(0, 0) - S(1, 1) + S(2, 2);
+	N(3, 3) = -S[0][0] - S[1][1] + S[2][2];
 
 	// q is the quaternion correspondent to the greatest eigenvector of the N
 	// matrix (last column in Z)
@@ -173,15 +138,8 @@ static bool se3_l2_internal(
 	}
 	else
 	{
-		double num = 0.0;
-		double den = 0.0;
-		for (size_t i = 0; i < nMatches; i++)
-		{
-			num += square(points_other[i].x) + square(points_other[i].y) +
-				square(points_other[i].z);
-			den += square(points_this[i].x) + square(points_this[i].y) +
-				square(points_this[i].z);
-		}  // end-for
+		const double num = m.sqr_local[0] + m.sqr_local[1] + m.sqr_local[2];
+		const double den = m.sqr_global[0] + m.sqr_global[1] + m.sqr_global[2];
 
 		// The scale:
 		s = std::sqrt(num / den);
@@ -189,19 +147,100 @@ static bool se3_l2_internal(
 
 	TPoint3D pp;
 	out_transform.composePoint(
-		ct_others.x, ct_others.y, ct_others.z, pp.x, pp.y, pp.z);
+		m.mean_local[0], m.mean_local[1], m.mean_local[2], pp.x, pp.y, pp.z);
 	pp *= s;
 
-	out_transform[0] = ct_this.x - pp.x;  // X
-	out_transform[1] = ct_this.y - pp.y;  // Y
-	out_transform[2] = ct_this.z - pp.z;  // Z
+	out_transform[0] = m.mean_global[0] - pp.x;	 // X
+	out_transform[1] = m.mean_global[1] - pp.y;	 // Y
+	out_transform[2] = m.mean_global[2] - pp.z;	 // Z
 
 	out_scale = s;	// return scale
 	return true;
 
+	MRPT_END
+}
+
+static bool se3_l2_internal(
+	std::vector<mrpt::math::TPoint3D>&
+		points_this,  // IN/OUT: It gets modified!
+	std::vector<mrpt::math::TPoint3D>&
+		points_other,  // IN/OUT: It gets modified!
+	mrpt::poses::CPose3DQuat& out_transform, double& out_scale,
+	bool forceScaleToUnity)
+{
+	MRPT_START
+
+	ASSERT_EQUAL_(points_this.size(), points_other.size());
+	// Compute the centroids
+	TPoint3D ct_others(0, 0, 0), ct_this(0, 0, 0);
+	const size_t nMatches = points_this.size();
+
+	if (nMatches < 3)
+		return false;  // Nothing we can estimate without 3 points!!
+
+	for (size_t i = 0; i < nMatches; i++)
+	{
+		ct_others += points_other[i];
+		ct_this += points_this[i];
+	}
+
+	const double F = 1.0 / nMatches;
+	ct_others *= F;
+	ct_this *= F;
+
+	mrpt::tfest::internal::corrs_moments_t m;
+	m.N = nMatches;
+	for (int k = 0; k < 3; k++)
+	{
+		m.mean_global[k] = ct_this[k];
+		m.mean_local[k] = ct_others[k];
+	}
+
+	// Substract the centroid and compute the S matrix of cross products
+	for (size_t i = 0; i < nMatches; i++)
+	{
+		points_this[i] -= ct_this;
+		points_other[i] -= ct_others;
+
+		for (int r = 0; r < 3; r++)
+		{
+			for (int c = 0; c < 3; c++)
+				m.S[r][c] += points_other[i][r] * points_this[i][c];
+
+			m.sqr_global[r] += square(points_this[i][r]);
+			m.sqr_local[r] += square(points_other[i][r]);
+		}
+	}
+
+	return mrpt::tfest::internal::se3_l2_from_moments(
+		m, out_transform, out_scale, forceScaleToUnity);
+
 	MRPT_END
 }  // end se3_l2_internal()
 
+template <typename T>
+bool mrpt::tfest::internal::se3_l2_soa(
+	const TMatchingPairListSoATempl<T>& c, const uint32_t* idxs, size_t n,
+	mrpt::poses::CPose3DQuat& out_transform, double& out_scale,
+	bool forceScaleToUnity)
+{
+	if (n < 3) return false;
+	return mrpt::tfest::internal::se3_l2_from_moments(
+		mrpt::tfest::internal::corrs_moments<3>(c, idxs, n), out_transform,
+		out_scale, forceScaleToUnity);
+}
+
+// Explicit instantiations:
+namespace mrpt::tfest::internal
+{
+template bool se3_l2_soa<float>(
+	const TMatchingPairListSoATempl<float>&, const uint32_t*, size_t,
+	mrpt::poses::CPose3DQuat&, double&, bool);
+template bool se3_l2_soa<double>(
+	const TMatchingPairListSoATempl<double>&, const uint32_t*, size_t,
+	mrpt::poses::CPose3DQuat&, double&, bool);
+}  // namespace mrpt::tfest::internal
+
 bool tfest::se3_l2(
 	const std::vector<mrpt::math::TPoint3D>& in_points_this,
 	const std::vector<mrpt::math::TPoint3D>& in_points_other,
@@ -258,3 +297,23 @@ bool tfest::se3_l2(
 	return se3_l2_internal(
 		points_this, points_other, out_transform, out_scale, forceScaleToUnity);
 }
+
+bool tfest::se3_l2(
+	const mrpt::tfest::TMatchingPairListSoA& corrs,
+	mrpt::poses::CPose3DQuat& out_transform, double& out_scale,
+	bool forceScaleToUnity)
+{
+	return mrpt::tfest::internal::se3_l2_soa(
+		corrs, nullptr, corrs.size(), out_transform, out_scale,
+		forceScaleToUnity);
+}
+
+bool tfest::se3_l2(
+	const mrpt::tfest::TMatchingPairListSoA_d& corrs,
+	mrpt::poses::CPose3DQuat& out_transform, double& out_scale,
+	bool forceScaleToUnity)
+{
+	return mrpt::tfest::internal::se3_l2_soa(
+		corrs, nullptr, corrs.size(), out_transform, out_scale,
+		forceScaleToUnity);
+}
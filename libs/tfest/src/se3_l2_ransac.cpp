@@ -10,7 +10,6 @@
 #include "tfest-precomp.h"	// Precompiled headers
 //
 #include <mrpt/core/round.h>
-#include <mrpt/math/utils.h>  // linspace()
 #include <mrpt/poses/CPose3D.h>
 #include <mrpt/poses/CPose3DQuat.h>
 #include <mrpt/poses/Lie/SO.h>
@@ -20,6 +19,9 @@
 #include <iostream>
 #include <numeric>
 
+#include "TMatchingPairListSoA_internal.h"
+#include "ransac_internal.h"
+
 using namespace mrpt;
 using namespace mrpt::tfest;
 using namespace mrpt::random;
@@ -27,87 +29,108 @@ using namespace mrpt::poses;
 using namespace mrpt::math;
 using namespace std;
 
-/*---------------------------------------------------------------
-						 se3_l2_robust
-  ---------------------------------------------------------------*/
-bool tfest::se3_l2_robust(
-	const mrpt::tfest::TMatchingPairList& in_correspondences,
-	const TSE3RobustParams& params, TSE3RobustResult& results)
+namespace
 {
-	MRPT_START
-
-	const size_t nCorrs = in_correspondences.size();
+// The outcome of one RANSAC hypothesis:
+struct THypothesis
+{
+	/** Consensus set (empty if the hypothesis was discarded) */
+	std::vector<uint32_t> cSet;
+	CPose3DQuat transformation;
+	double scale = 0;
+	double err = std::numeric_limits<double>::max();
+};
+
+bool isCompatible(
+	const TSE3RobustParams& params, const TMatchingPairListSoA& corrs,
+	size_t idx)
+{
+	// User-provided filter:
+	if (!params.user_individual_compat_callback) return true;
 
-	// -------------------------------------------
-	// RANSAC parameters
-	// -------------------------------------------
-	// Minimum error achieved so far
-	double min_err = std::numeric_limits<double>::max();
-	size_t max_size = 0;  // Maximum size of the consensus set so far
-	double scale;  // Output scale
+	mrpt::tfest::TPotentialMatch pm;
+	pm.idx_this = corrs.globalIdx[idx];
+	pm.idx_other = corrs.localIdx[idx];
+	return params.user_individual_compat_callback(pm);
+}
 
+// Evaluates one hypothesis. Its consensus set is abandoned as soon as it
+// cannot reach `minConsensus` correspondences (preemptive scoring): it would
+// be discarded anyway.
+void evalHypothesis(
+	const TMatchingPairListSoA& corrs, const TSE3RobustParams& params,
+	const size_t minConsensus, CRandomGenerator& rng,
+	mrpt::tfest::internal::LazyPermutation& perm, THypothesis& h)
+{
+	const size_t nCorrs = corrs.size();
 	// Minimum number of points to fit the model
 	const size_t n = params.ransac_minSetSize;
-	// Minimum number of points to be considered a good set
-	const size_t d = mrpt::round(nCorrs * params.ransac_maxSetSizePct);
-	// Maximum number of iterations
-	const size_t maxIters = params.ransac_nmaxSimulations;
 
-	ASSERTMSG_(
-		d >= n,
-		"Minimum number of points to be considered a good set is < Minimum "
-		"number of points to fit the model");
+	// Generate maybe inliers
+	auto& cSet = h.cSet;  // consensus set
+	cSet.clear();
+	uint32_t idx;
+	while (cSet.size() < n && perm.draw(rng, idx))
+		if (isCompatible(params, corrs, idx)) cSet.push_back(idx);
+	perm.rewind();
 
-	// -------------------------------------------
-	// MAIN loop
-	// -------------------------------------------
-	for (size_t iterations = 0; iterations < maxIters; iterations++)
+	// Check minimum number:
+	if (cSet.size() < n)
 	{
 		if (params.verbose)
-			std::cout << "[tfest::se3_l2_robust] Iteration " << (iterations + 1)
-					  << "/" << maxIters << "\n";
+			std::cerr << "[tfest::se3_l2_robust] It was not possible to find "
+						 "the min no of (compatible) matching pairs.\n";
+		cSet.clear();
+		return;
+	}
 
-		// Generate maybe inliers
-		const auto rub = mrpt::math::linspace<uint32_t>(0, nCorrs - 1, nCorrs);
-		const auto mbSet = getRandomGenerator().permuteVector(rub);
+	const auto mbMoments =
+		mrpt::tfest::internal::corrs_moments<3>(corrs, cSet.data(), n);
 
-		std::vector<uint32_t> cSet;	 // consensus set
+	CPose3DQuat mbOutQuat;
+	double scale;
+	if (!mrpt::tfest::internal::se3_l2_from_moments(
+			mbMoments, mbOutQuat, scale, params.forceScaleToUnity))
+	{
+		std::cerr << "[tfest::se3_l2_robust] tfest::se3_l2() returned "
+					 "false for tentative subset during RANSAC "
+					 "iteration!\n";
+		cSet.clear();
+		return;
+	}
 
-		// Compute first inliers output
-		TMatchingPairList mbInliers;
-		mbInliers.reserve(n);
-		for (size_t i = 0; mbInliers.size() < n && i < nCorrs; i++)
-		{
-			const size_t idx = mbSet[i];
+	// Maybe inliers Output
+	const CPose3D mbOut = CPose3D(mbOutQuat);
+	const double mbScale = scale;
 
-			// User-provided filter:
-			if (params.user_individual_compat_callback)
-			{
-				mrpt::tfest::TPotentialMatch pm;
-				pm.idx_this = in_correspondences[idx].globalIdx;
-				pm.idx_other = in_correspondences[idx].localIdx;
-				if (!params.user_individual_compat_callback(pm))
-					continue;  // Skip this one!
-			}
-
-			mbInliers.push_back(in_correspondences[idx]);
-			cSet.push_back(idx);
-		}
+	std::vector<uint32_t> maybeInliers(cSet.begin(), cSet.end());
+	std::sort(maybeInliers.begin(), maybeInliers.end());
 
-		// Check minimum number:
-		if (cSet.size() < n)
+	// Inner loop: for each point NOT in the maybe inliers
+	for (size_t k = 0; k < nCorrs; k++)
+	{
+		// Can the consensus set still reach the minimum size?
+		if (cSet.size() + (nCorrs - k) < minConsensus)
 		{
-			if (params.verbose)
-				std::cerr << "[tfest::se3_l2_robust] Iter " << iterations
-						  << ": It was not possible to find the min no of "
-							 "(compatible) matching pairs.\n";
-			continue;  // Try again
+			cSet.clear();
+			return;
 		}
 
-		CPose3DQuat mbOutQuat;
-		bool res = mrpt::tfest::se3_l2(
-			mbInliers, mbOutQuat, scale, params.forceScaleToUnity);
-		if (!res)
+		if (std::binary_search(maybeInliers.begin(), maybeInliers.end(), k))
+			continue;
+		if (!isCompatible(params, corrs, k)) continue;
+
+		// Consensus set: Maybe inliers + new point
+		auto csMoments = mbMoments;
+		const double g[3] = {
+			corrs.global_x[k], corrs.global_y[k], corrs.global_z[k]};
+		const double l[3] = {
+			corrs.local_x[k], corrs.local_y[k], corrs.local_z[k]};
+		mrpt::tfest::internal::corrs_moments_add(csMoments, g, l);
+
+		CPose3DQuat csOutQuat;
+		if (!mrpt::tfest::internal::se3_l2_from_moments(
+				csMoments, csOutQuat, scale, params.forceScaleToUnity))
 		{
 			std::cerr << "[tfest::se3_l2_robust] tfest::se3_l2() returned "
 						 "false for tentative subset during RANSAC "
@@ -115,118 +138,146 @@ bool tfest::se3_l2_robust(
 			continue;
 		}
 
-		// Maybe inliers Output
-		const CPose3D mbOut = CPose3D(mbOutQuat);
-		CVectorDouble mbOut_vec(7);
-		mbOut_vec[0] = mbOut.x();
-		mbOut_vec[1] = mbOut.y();
-		mbOut_vec[2] = mbOut.z();
-
-		mbOut_vec[3] = mbOut.yaw();
-		mbOut_vec[4] = mbOut.pitch();
-		mbOut_vec[5] = mbOut.roll();
+		// Is this point a supporter of the initial inlier group?
+		const CPose3D csOut = CPose3D(csOutQuat);
 
-		mbOut_vec[6] = scale;
+		const double linDist = mbOut.distanceTo(csOut);
+		const double angDist =
+			mrpt::poses::Lie::SO<3>::log((csOut - mbOut).getRotationMatrix())
+				.norm();
+		const double scaleDist = std::abs(mbScale - scale);
 
-		// Inner loop: for each point NOT in the maybe inliers
-		for (size_t k = n; k < nCorrs; k++)
+		if (linDist < params.ransac_threshold_lin &&
+			angDist < params.ransac_threshold_ang &&
+			scaleDist < params.ransac_threshold_scale)
 		{
-			const size_t idx = mbSet[k];
+			// Inlier detected -> add to the inlier list
+			cSet.push_back(k);
+		}
+	}  // end 'inner' for
 
-			// User-provided filter:
-			if (params.user_individual_compat_callback)
-			{
-				mrpt::tfest::TPotentialMatch pm;
-				pm.idx_this = in_correspondences[idx].globalIdx;
-				pm.idx_other = in_correspondences[idx].localIdx;
-				if (!params.user_individual_compat_callback(pm))
-					continue;  // Skip this one!
-			}
+	if (cSet.size() < minConsensus)
+	{
+		cSet.clear();
+		return;
+	}
 
-			// Consensus set: Maybe inliers + new point
-			CPose3DQuat csOutQuat;
-			mbInliers.push_back(in_correspondences[idx]);  // Insert
-			res = mrpt::tfest::se3_l2(
-				mbInliers, csOutQuat, scale, params.forceScaleToUnity);
-			mbInliers.erase(mbInliers.end() - 1);  // Erase
+	// Good set of points found
+	// Compute output: Consensus Set + Initial Inliers Guess
+	const bool res = mrpt::tfest::internal::se3_l2_soa(
+		corrs, cSet.data(), cSet.size(), h.transformation, h.scale,
+		params.forceScaleToUnity);
+	ASSERTMSG_(
+		res,
+		"tfest::se3_l2() returned false for tentative subset during "
+		"RANSAC iteration!");
+
+	// Compute error for consensus_set
+	const CPose3D cIOut = CPose3D(h.transformation);
+	h.err = std::sqrt(
+		square(mbOut.x() - cIOut.x()) + square(mbOut.y() - cIOut.y()) +
+		square(mbOut.z() - cIOut.z()) + square(mbOut.yaw() - cIOut.yaw()) +
+		square(mbOut.pitch() - cIOut.pitch()) +
+		square(mbOut.roll() - cIOut.roll()) + square(mbScale - h.scale));
+}
+}  // namespace
 
-			if (!res)
-			{
-				std::cerr << "[tfest::se3_l2_robust] tfest::se3_l2() returned "
-							 "false for tentative subset during RANSAC "
-							 "iteration!\n";
-				continue;
-			}
+/*---------------------------------------------------------------
+						 se3_l2_robust
+  ---------------------------------------------------------------*/
+bool tfest::se3_l2_robust(
+	const mrpt::tfest::TMatchingPairList& in_correspondences,
+	const TSE3RobustParams& params, TSE3RobustResult& results)
+{
+	// Convert once, then work on indices into the SoA list:
+	return se3_l2_robust(
+		TMatchingPairListSoA(in_correspondences), params, results);
+}
 
-			// Is this point a supporter of the initial inlier group?
-			const CPose3D csOut = CPose3D(csOutQuat);
+bool tfest::se3_l2_robust(
+	const mrpt::tfest::TMatchingPairListSoA& in_correspondences,
+	const TSE3RobustParams& params, TSE3RobustResult& results)
+{
+	MRPT_START
 
-			const double linDist = mbOut.distanceTo(csOut);
-			const double angDist = mrpt::poses::Lie::SO<3>::log(
-									   (csOut - mbOut).getRotationMatrix())
-									   .norm();
-			const double scaleDist = std::abs(mbOut_vec[6] - scale);
+	const size_t nCorrs = in_correspondences.size();
 
-			if (linDist < params.ransac_threshold_lin &&
-				angDist < params.ransac_threshold_ang &&
-				scaleDist < params.ransac_threshold_scale)
-			{
-				// Inlier detected -> add to the inlier list
-				cSet.push_back(idx);
-			}
-			else
-			{
-				// cout << " It " << iterations << " - RANSAC Outlier Detected:
-				// " << k << endl;
-			}
-		}  // end 'inner' for
+	// -------------------------------------------
+	// RANSAC parameters
+	// -------------------------------------------
+	// Minimum error achieved so far
+	double min_err = std::numeric_limits<double>::max();
+	size_t max_size = 0;  // Maximum size of the consensus set so far
+
+	// Minimum number of points to fit the model
+	const size_t n = params.ransac_minSetSize;
+	// Minimum number of points to be considered a good set
+	const size_t d = mrpt::round(nCorrs * params.ransac_maxSetSizePct);
+	// Maximum number of iterations
+	const size_t maxIters = params.ransac_nmaxSimulations;
 
-		// Test cSet size
-		if (cSet.size() >= d)
+	ASSERTMSG_(
+		d >= n,
+		"Minimum number of points to be considered a good set is < Minimum "
+		"number of points to fit the model");
+
+	// Hypotheses are evaluated in batches, each one with its own random
+	// generator, and merged in order:
+	const size_t nThreads = mrpt::resolveNumThreads(params.numThreads);
+
+	const size_t batchSize = std::max(1U, params.ransac_batchSize);
+	const size_t nBatches = (maxIters + batchSize - 1) / batchSize;
+	const uint32_t baseSeed =
+		mrpt::tfest::internal::ransacBaseSeed(params.ransac_seed);
+
+	// -------------------------------------------
+	// MAIN loop
+	// -------------------------------------------
+	for (size_t firstBatch = 0; firstBatch < nBatches; firstBatch += nThreads)
+	{
+		// Consensus sets smaller than this cannot be accepted:
+		const size_t minConsensus = std::max(d, max_size);
+
+		const auto batches =
+			mrpt::tfest::internal::ransacEvalBatches<std::vector<THypothesis>>(
+				nThreads, firstBatch,
+				std::min(nThreads, nBatches - firstBatch),
+				[&](size_t batchIdx) {
+					CRandomGenerator rng(
+						mrpt::parallelTaskSeed(baseSeed, batchIdx));
+					mrpt::tfest::internal::LazyPermutation perm(nCorrs);
+
+					const size_t first = batchIdx * batchSize;
+					std::vector<THypothesis> hs(
+						std::min(maxIters, first + batchSize) - first);
+					for (auto& h : hs)
+						evalHypothesis(
+							in_correspondences, params, minConsensus, rng,
+							perm, h);
+					return hs;
+				});
+
+		size_t iterations = firstBatch * batchSize;
+		for (const auto& batch : batches)
 		{
-			// Good set of points found
-			TMatchingPairList cSetInliers;
-			cSetInliers.resize(cSet.size());
-			for (size_t m = 0; m < cSet.size(); m++)
-				cSetInliers[m] = in_correspondences[cSet[m]];
-
-			// Compute output: Consensus Set + Initial Inliers Guess
-			CPose3DQuat cIOutQuat;
-			res = mrpt::tfest::se3_l2(
-				cSetInliers, cIOutQuat, scale,
-				params.forceScaleToUnity);	// Compute output
-			ASSERTMSG_(
-				res,
-				"tfest::se3_l2() returned false for tentative subset during "
-				"RANSAC iteration!");
-
-			// Compute error for consensus_set
-			const CPose3D cIOut = CPose3D(cIOutQuat);
-			const double err = std::sqrt(
-				square(mbOut_vec[0] - cIOut.x()) +
-				square(mbOut_vec[1] - cIOut.y()) +
-				square(mbOut_vec[2] - cIOut.z()) +
-				square(mbOut_vec[3] - cIOut.yaw()) +
-				square(mbOut_vec[4] - cIOut.pitch()) +
-				square(mbOut_vec[5] - cIOut.roll()) +
-				square(mbOut_vec[6] - scale));
-
-			// Is the best set of points so far?
-			if (err < min_err && cSet.size() >= max_size)
+			for (const auto& h : batch)
 			{
-				min_err = err;
-				max_size = cSet.size();
-				results.transformation = cIOutQuat;
-				results.scale = scale;
-				results.inliers_idx = cSet;
+				if (params.verbose)
+					std::cout << "[tfest::se3_l2_robust] Iteration "
+							  << (++iterations) << "/" << maxIters << ": "
+							  << h.cSet.size() << " inliers\n";
+
+				// Is the best set of points so far?
+				if (!h.cSet.empty() && h.err < min_err &&
+					h.cSet.size() >= max_size)
+				{
+					min_err = h.err;
+					max_size = h.cSet.size();
+					results.transformation = h.transformation;
+					results.scale = h.scale;
+					results.inliers_idx = h.cSet;
+				}
 			}
-			// printf(" - Consensus set size: %u - Error: %.6f\n", (unsigned
-			// int)cSet.size(), err );
-		}  // end if cSet.size() > d
-		else
-		{
-			// printf(" - Consensus set size: %u - Not big enough!\n", (unsigned
-			// int)cSet.size() );
 		}
 	}  // end 'iterations' for
 
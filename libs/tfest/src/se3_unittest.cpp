@@ -8,6 +8,7 @@
    +------------------------------------------------------------------------+ */
 
 #include <gtest/gtest.h>
+#include <mrpt/math/TPose2D.h>
 #include <mrpt/math/ops_vectors.h>
 #include <mrpt/poses/CPose3D.h>
 #include <mrpt/poses/CPose3DQuat.h>
@@ -228,3 +229,196 @@ TEST(tfest, se3_l2_robust)
 					 << outQuat << endl;
 	}
 }
+
+template <typename T>
+static TMatchingPairListTempl<T> random_corrs(
+	const CPose3D& gtPose, size_t N, bool planar)
+{
+	auto& rng = getRandomGenerator();
+	TMatchingPairListTempl<T> list;
+	for (size_t i = 0; i < N; i++)
+	{
+		const TPoint3D local(
+			rng.drawUniform(-10.0, 10.0), rng.drawUniform(-10.0, 10.0),
+			planar ? 0.0 : rng.drawUniform(-10.0, 10.0));
+		const TPoint3D noise(
+			rng.drawGaussian1D(0, 0.01), rng.drawGaussian1D(0, 0.01),
+			planar ? 0.0 : rng.drawGaussian1D(0, 0.01));
+		const TPoint3D global = gtPose.composePoint(local) + noise;
+		list.emplace_back(
+			i, i, mrpt::math::TPoint3D_<T>(global),
+			mrpt::math::TPoint3D_<T>(local));
+	}
+	return list;
+}
+
+template <typename T>
+void se3_l2_SoA_test()
+{
+	getRandomGenerator().randomize(123);
+
+	// Far from the origin, to check the accuracy of float accumulators:
+	const CPose3D gtPose(100.0, -50.0, 2.0, 30.0_deg, -10.0_deg, 5.0_deg);
+
+	for (const size_t N : {3, 8, 17, 1000})
+	{
+		const auto list = random_corrs<T>(gtPose, N, false);
+		const TMatchingPairListSoATempl<T> soa(list);
+		ASSERT_EQ(soa.size(), list.size());
+
+		CPose3DQuat aosQuat, soaQuat;
+		double aosScale, soaScale;
+		ASSERT_TRUE(se3_l2(list, aosQuat, aosScale));
+		ASSERT_TRUE(se3_l2(soa, soaQuat, soaScale));
+
+		const CPose3D aosPose(aosQuat), soaPose(soaQuat);
+		EXPECT_NEAR(aosScale, soaScale, 1e-4);
+		EXPECT_NEAR(aosPose.distanceTo(soaPose), 0.0, 1e-3)
+			<< "N=" << N << " AoS: " << aosPose << " SoA: " << soaPose;
+		for (unsigned int i = 3; i < 7; ++i)
+			EXPECT_NEAR(aosQuat[i], soaQuat[i], 1e-4) << "N=" << N;
+		if (N > 100)
+		{
+			EXPECT_NEAR(soaPose.distanceTo(gtPose), 0.0, 1e-2);
+		}
+	}
+	// Not enough points:
+	TMatchingPairListSoATempl<T> soa(random_corrs<T>(gtPose, 2, false));
+	CPose3DQuat q;
+	double scale;
+	EXPECT_FALSE(se3_l2(soa, q, scale));
+}
+
+TEST(tfest, se3_l2_SoA_float) { se3_l2_SoA_test<float>(); }
+TEST(tfest, se3_l2_SoA_double) { se3_l2_SoA_test<double>(); }
+
+TEST(tfest, se2_l2_SoA)
+{
+	getRandomGenerator().randomize(456);
+	const CPose3D gtPose(20.0, 3.0, 0.0, 25.0_deg, 0.0, 0.0);
+
+	for (const size_t N : {2, 9, 1000})
+	{
+		const auto list = random_corrs<float>(gtPose, N, true);
+		const TMatchingPairListSoA soa(list);
+
+		TPose2D aosPose, soaPose;
+		CMatrixDouble33 aosCov, soaCov;
+		ASSERT_TRUE(se2_l2(list, aosPose, &aosCov));
+		ASSERT_TRUE(se2_l2(soa, soaPose, &soaCov));
+
+		EXPECT_NEAR(aosPose.x, soaPose.x, 1e-3) << "N=" << N;
+		EXPECT_NEAR(aosPose.y, soaPose.y, 1e-3) << "N=" << N;
+		EXPECT_NEAR(aosPose.phi, soaPose.phi, 1e-4) << "N=" << N;
+		for (int r = 0; r < 3; r++)
+			for (int c = 0; c < 3; c++)
+				EXPECT_NEAR(
+					aosCov(r, c), soaCov(r, c),
+					1e-3 * std::sqrt(aosCov(r, r) * aosCov(c, c)))
+					<< "N=" << N << " (r,c)=" << r << "," << c;
+	}
+}
+
+TEST(tfest, se3_l2_robust_SoA)
+{
+	TPoints pA, pB;	 // The input points
+	generate_points(pA, pB);
+
+	TMatchingPairList list;
+	generate_list_of_points(pA, pB, list);
+
+	mrpt::tfest::TSE3RobustParams params;
+	params.ransac_minSetSize = 3;
+	params.ransac_maxSetSizePct = 3.0 / list.size();
+
+	// Same random samples -> same results with both layouts:
+	mrpt::tfest::TSE3RobustResult aosResult, soaResult;
+	getRandomGenerator().randomize(789);
+	ASSERT_TRUE(mrpt::tfest::se3_l2_robust(list, params, aosResult));
+	getRandomGenerator().randomize(789);
+	ASSERT_TRUE(mrpt::tfest::se3_l2_robust(
+		TMatchingPairListSoA(list), params, soaResult));
+
+	EXPECT_EQ(aosResult.inliers_idx, soaResult.inliers_idx);
+	for (unsigned int i = 0; i < 7; ++i)
+		EXPECT_DOUBLE_EQ(
+			aosResult.transformation[i], soaResult.transformation[i]);
+}
+
+// Correspondences with 25% of outliers:
+template <typename T>
+static TMatchingPairListTempl<T> corrs_with_outliers(
+	const CPose3D& gtPose, size_t N, bool planar)
+{
+	auto list = random_corrs<T>(gtPose, N, planar);
+	for (size_t i = 0; i < list.size(); i += 4)
+		list[i].global.x += 5;
+	return list;
+}
+
+TEST(tfest, se3_l2_robust_threads)
+{
+	getRandomGenerator().randomize(321);
+	const CPose3D gtPose(1.0, -2.0, 0.5, 20.0_deg, 5.0_deg, -10.0_deg);
+	const auto list = corrs_with_outliers<float>(gtPose, 40, false);
+
+	mrpt::tfest::TSE3RobustParams params;
+	params.ransac_batchSize = 3;
+	params.ransac_seed = 1234;
+
+	// Same seed -> same results, regardless of the number of threads:
+	mrpt::tfest::TSE3RobustResult res1, res4;
+	params.numThreads = 1;
+	ASSERT_TRUE(mrpt::tfest::se3_l2_robust(list, params, res1));
+	params.numThreads = 4;
+	ASSERT_TRUE(mrpt::tfest::se3_l2_robust(list, params, res4));
+
+	EXPECT_EQ(res1.inliers_idx, res4.inliers_idx);
+	for (unsigned int i = 0; i < 7; ++i)
+		EXPECT_DOUBLE_EQ(res1.transformation[i], res4.transformation[i]);
+
+	EXPECT_GE(res1.inliers_idx.size(), 20u);
+	for (const auto idx : res1.inliers_idx)
+		EXPECT_NE(idx % 4, 0u) << "Outlier taken as inlier: " << idx;
+	EXPECT_NEAR(CPose3D(res1.transformation).distanceTo(gtPose), 0.0, 0.05);
+}
+
+TEST(tfest, se2_l2_robust_threads)
+{
+	getRandomGenerator().randomize(654);
+	const CPose3D gtPose(2.0, 1.0, 0.0, -40.0_deg, 0.0, 0.0);
+	const auto list = corrs_with_outliers<float>(gtPose, 40, true);
+
+	for (const bool landmarks : {true, false})
+	{
+		mrpt::tfest::TSE2RobustParams params;
+		params.ransac_algorithmForLandmarks = landmarks;
+		params.ransac_batchSize = 2;
+		params.ransac_seed = 99;
+
+		mrpt::tfest::TSE2RobustResult res1, res3;
+		params.numThreads = 1;
+		ASSERT_TRUE(mrpt::tfest::se2_l2_robust(list, 0.02, params, res1));
+		params.numThreads = 3;
+		ASSERT_TRUE(mrpt::tfest::se2_l2_robust(list, 0.02, params, res3));
+
+		EXPECT_EQ(res1.ransac_iters, res3.ransac_iters);
+		EXPECT_TRUE(res1.largestSubSet == res3.largestSubSet);
+		ASSERT_EQ(res1.transformation.size(), res3.transformation.size());
+		for (size_t i = 0; i < res1.transformation.size(); i++)
+		{
+			const auto& m1 = res1.transformation.get(i);
+			const auto& m3 = res3.transformation.get(i);
+			EXPECT_EQ(m1.mean, m3.mean);
+			EXPECT_DOUBLE_EQ(m1.log_w, m3.log_w);
+		}
+
+		ASSERT_FALSE(res1.largestSubSet.empty());
+		for (const auto& c : res1.largestSubSet)
+			EXPECT_NE(c.globalIdx % 4, 0u) << "Outlier taken as inlier";
+		CPose2D mean;
+		res1.transformation.getMean(mean);
+		EXPECT_NEAR(mean.distanceTo(CPose2D(gtPose)), 0.0, 0.05)
+			<< "landmarks=" << landmarks;
+	}
+}